@@ -1,57 +1,213 @@
 {
+  "variables": {
+    "opencv_pkg%": "opencv4",
+    # libjpeg-turbo (jpeg_crop_scanline/jpeg_skip_scanlines) for region-only JPEG decoding;
+    # without it fd_embed_encoded decodes whole images through OpenCV
+    "libjpeg_turbo%": "<!(pkg-config --exists libjpeg && echo 1 || echo 0)",
+    # SQLite headers for the embedding_knn extension (src/native/sqlite_embedding_knn.cpp)
+    "sqlite_ext%": "<!(pkg-config --exists sqlite3 && echo 1 || echo 0)"
+  },
+  "target_defaults": {
+    "cflags!": ["-fno-exceptions"],
+    "cflags_cc!": ["-fno-exceptions"],
+    "conditions": [
+      ["OS=='win'", {
+        "msvs_settings": {
+          "VCCLCompilerTool": {
+            "ExceptionHandling": 1,
+            "AdditionalOptions": ["/bigobj"]
+          }
+        }
+      }],
+      ["OS=='linux'", {
+        # The kernel static libraries are linked into the shared library
+        "cflags": ["-fPIC"]
+      }]
+    ]
+  },
   "targets": [
     {
+      # Node addon: a thin N-API consumer of the C API below
       "target_name": "face_detector",
+      "dependencies": ["facedetector"],
       "sources": [
-        "src/native/face_detector.cpp",
         "src/native/face_detector_wrapper.cpp"
       ],
       "include_dirs": [
-        "<!@(node -p \"require('node-addon-api').include\")",
-        "C:\\opencv\\build\\include",
-        "C:\\Program Files\\NVIDIA GPU Computing Toolkit\\CUDA\\v12.0\\include"
+        "<!@(node -p \"require('node-addon-api').include\")"
       ],
-      "library_dirs": [
-        "C:\\opencv\\build\\x64\\vc16\\lib",
-        "C:\\Program Files\\NVIDIA GPU Computing Toolkit\\CUDA\\v12.0\\lib\\x64"
+      "defines": [
+        "NAPI_DISABLE_CPP_EXCEPTIONS"
       ],
-      "libraries": [
-        "opencv_world4120.lib",
-        "cuda.lib",
-        "cudart.lib",
-        "cublas.lib",
-        "curand.lib",
-        "cufft.lib"
+      "conditions": [
+        ["OS=='linux'", {
+          "ldflags": ["-Wl,-rpath,'$$ORIGIN'", "-Wl,-rpath,'$$ORIGIN/lib.target'"]
+        }]
+      ]
+    },
+    {
+      # Detector core as a standalone shared library with a stable C ABI
+      # (src/native/face_detector_c_api.h), usable without Node
+      "target_name": "facedetector",
+      "type": "shared_library",
+      "dependencies": [
+        "face_detector_sse42",
+        "face_detector_avx2",
+        "face_detector_avx512"
+      ],
+      "sources": [
+        "src/native/face_detector.cpp",
+        "src/native/shared_runtime.cpp",
+        "src/native/detection_journal.cpp",
+        "src/native/roi_decoder.cpp",
+        "src/native/detection_cascade.cpp",
+        "src/native/embedding_tier_policy.cpp",
+        "src/native/sampling_controller.cpp",
+        "src/native/low_power_detector.cpp",
+        "src/native/h264_fragmenter.cpp",
+        "src/native/stage_profiler.cpp",
+        "src/native/embedding_gallery.cpp",
+        "src/native/unknown_face_store.cpp",
+        "src/native/rolling_counters.cpp",
+        "src/native/watchlist.cpp",
+        "src/native/frame_pyramid.cpp",
+        "src/native/cpu_features.cpp",
+        "src/native/simd_kernels.cpp",
+        "src/native/simd_kernels_neon.cpp",
+        "src/native/face_detector_c_api.cpp"
       ],
       "defines": [
-        "NAPI_DISABLE_CPP_EXCEPTIONS",
-        "HAVE_CUDA=1"
+        "FD_BUILDING_LIBRARY"
       ],
+      "cflags": ["-fvisibility=hidden"],
+      "xcode_settings": {
+        "OTHER_CFLAGS": ["-fvisibility=hidden"],
+        "DYLIB_INSTALL_NAME_BASE": "@rpath"
+      },
+      "direct_dependent_settings": {
+        "include_dirs": ["src/native"]
+      },
       "conditions": [
         ["OS=='win'", {
-          "msvs_settings": {
-            "VCCLCompilerTool": {
-              "ExceptionHandling": 1,
-              "AdditionalOptions": ["/bigobj"]
-            }
-          },
+          "include_dirs": [
+            "C:\\opencv\\build\\include",
+            "C:\\Program Files\\NVIDIA GPU Computing Toolkit\\CUDA\\v12.0\\include"
+          ],
+          "library_dirs": [
+            "C:\\opencv\\build\\x64\\vc16\\lib",
+            "C:\\Program Files\\NVIDIA GPU Computing Toolkit\\CUDA\\v12.0\\lib\\x64"
+          ],
           "libraries": [
+            "opencv_world4120.lib",
             "cuda.lib",
             "cudart.lib",
-            "cublas.lib"
+            "cublas.lib",
+            "curand.lib",
+            "cufft.lib"
+          ],
+          "defines": [
+            "HAVE_CUDA=1"
+          ],
+          "copies": [
+            {
+              "destination": "<(PRODUCT_DIR)",
+              "files": [
+                "C:\\opencv\\build\\x64\\vc16\\bin\\opencv_world4120.dll"
+              ]
+            }
+          ]
+        }],
+        ["OS=='linux'", {
+          # CPU-only OpenCV from the system or a custom prefix:
+          #   PKG_CONFIG_PATH=/opt/opencv/lib/pkgconfig npm run build:native
+          "include_dirs": [
+            "<!@(pkg-config --cflags-only-I <(opencv_pkg) | sed 's/-I//g')"
+          ],
+          "libraries": [
+            "<!@(pkg-config --libs <(opencv_pkg))"
+          ],
+          "ldflags": [
+            "-Wl,-rpath,<!(pkg-config --variable=libdir <(opencv_pkg))"
+          ]
+        }],
+        ["OS!='win' and libjpeg_turbo==1", {
+          "defines": ["FD_HAVE_LIBJPEG_TURBO"],
+          "include_dirs": [
+            "<!@(pkg-config --cflags-only-I libjpeg | sed 's/-I//g')"
+          ],
+          "libraries": [
+            "<!@(pkg-config --libs libjpeg)"
           ]
         }]
-      ],
-      "cflags!": ["-fno-exceptions"],
-      "cflags_cc!": ["-fno-exceptions"],
-      "copies": [
+      ]
+    },
+    # Hot kernels per instruction set (src/native/simd_kernels_*.cpp). Each is
+    # built with its own ISA flags and selected at load time from cpuid, so the
+    # library still runs on CPUs without them. On other architectures the files
+    # compile to stubs and NEON/scalar kernels are used instead.
+    {
+      "target_name": "face_detector_sse42",
+      "type": "static_library",
+      "sources": ["src/native/simd_kernels_sse42.cpp"],
+      "conditions": [
+        ["target_arch=='x64' or target_arch=='ia32'", {
+          "cflags": ["-msse4.2", "-mpopcnt"],
+          "xcode_settings": { "OTHER_CFLAGS": ["-msse4.2", "-mpopcnt"] }
+        }]
+      ]
+    },
+    {
+      "target_name": "face_detector_avx2",
+      "type": "static_library",
+      "sources": ["src/native/simd_kernels_avx2.cpp"],
+      "conditions": [
+        ["target_arch=='x64' or target_arch=='ia32'", {
+          "cflags": ["-mavx2", "-mfma"],
+          "xcode_settings": { "OTHER_CFLAGS": ["-mavx2", "-mfma"] },
+          "msvs_settings": {
+            "VCCLCompilerTool": { "AdditionalOptions": ["/arch:AVX2"] }
+          }
+        }]
+      ]
+    },
+    {
+      "target_name": "face_detector_avx512",
+      "type": "static_library",
+      "sources": ["src/native/simd_kernels_avx512.cpp"],
+      "conditions": [
+        ["target_arch=='x64'", {
+          "cflags": ["-mavx512f", "-mavx512bw", "-mavx512vl"],
+          "xcode_settings": { "OTHER_CFLAGS": ["-mavx512f", "-mavx512bw", "-mavx512vl"] },
+          "msvs_settings": {
+            "VCCLCompilerTool": { "AdditionalOptions": ["/arch:AVX512"] }
+          }
+        }]
+      ]
+    }
+  ],
+  "conditions": [
+    ["sqlite_ext==1", {
+      "targets": [
         {
-          "destination": "<(PRODUCT_DIR)",
-          "files": [
-            "C:\\opencv\\build\\x64\\vc16\\bin\\opencv_world4120.dll"
+          # Loadable SQLite extension: top-k cosine search over embedding columns in SQL.
+          # Loaded into the database connection, not into Node, so it carries its own kernels.
+          "target_name": "embedding_knn",
+          "dependencies": [
+            "face_detector_sse42",
+            "face_detector_avx2",
+            "face_detector_avx512"
+          ],
+          "sources": [
+            "src/native/sqlite_embedding_knn.cpp",
+            "src/native/cpu_features.cpp",
+            "src/native/simd_kernels.cpp",
+            "src/native/simd_kernels_neon.cpp"
+          ],
+          "include_dirs": [
+            "<!@(pkg-config --cflags-only-I sqlite3 | sed 's/-I//g')"
           ]
         }
       ]
-    }
+    }]
   ]
-}
\ No newline at end of file
+}
@@ -14,8 +14,28 @@ interface WebSocketMessage {
   data?: string;
   message?: string;
   timestamp?: number;
+  codec?: 'h264' | 'mjpeg';
+  codecString?: string | null;
 }
 
+// First byte of each binary H.264 message; the Annex-B access unit follows
+const PREVIEW_FLAG_KEYFRAME = 0x01;
+const DEFAULT_H264_CODEC = 'avc1.42e01f'; // Constrained baseline 3.1, what the server encodes
+
+// WebCodecs constructors, looked up at runtime since older browsers lack them
+const webCodecs = window as any;
+
+// RFC 6381 codec string from the SPS in a keyframe, e.g. "avc1.64001f"
+const codecFromKeyframe = (unit: Uint8Array): string => {
+  for (let i = 0; i + 7 < unit.length; i++) {
+    if (unit[i] === 0 && unit[i + 1] === 0 && unit[i + 2] === 1 && (unit[i + 3] & 0x1f) === 7) {
+      const hex = (byte: number) => byte.toString(16).padStart(2, '0');
+      return `avc1.${hex(unit[i + 4])}${hex(unit[i + 5])}${hex(unit[i + 6])}`;
+    }
+  }
+  return DEFAULT_H264_CODEC;
+};
+
 export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
   sessionId,
   className = '',
@@ -25,6 +45,7 @@ export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
 }) => {
   const canvasRef = useRef<HTMLCanvasElement>(null);
   const wsRef = useRef<WebSocket | null>(null);
+  const decoderRef = useRef<any>(null);
   const [isConnected, setIsConnected] = useState(false);
   const [isLoading, setIsLoading] = useState(true);
   const [error, setError] = useState<string | null>(null);
@@ -43,6 +64,7 @@ export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
     const wsUrl = `${wsProtocol}//${apiHost}/ws/stream`;
     try {
       const ws = new WebSocket(wsUrl);
+      ws.binaryType = 'arraybuffer';
       wsRef.current = ws;
 
       ws.onopen = () => {
@@ -58,11 +80,25 @@ export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
       };
 
       ws.onmessage = (event) => {
+        // H.264 access units arrive as binary messages
+        if (event.data instanceof ArrayBuffer) {
+          decodeUnit(new Uint8Array(event.data));
+          return;
+        }
+
         try {
           const message: WebSocketMessage = JSON.parse(event.data);
 
           switch (message.type) {
             case 'subscribed':
+              if (message.codec === 'h264' && !webCodecs.VideoDecoder) {
+                const unsupported = 'This browser cannot decode the H.264 live preview';
+                setError(unsupported);
+                setIsLoading(false);
+                onError?.(unsupported);
+                ws.close(1000, 'Codec unsupported');
+                return;
+              }
               setIsLoading(false);
               onStreamStart?.();
               break;
@@ -140,6 +176,59 @@ export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
     }
   }, [sessionId, onError, onStreamStart, onStreamStop]);
 
+  const closeDecoder = useCallback(() => {
+    if (decoderRef.current && decoderRef.current.state !== 'closed') {
+      decoderRef.current.close();
+    }
+    decoderRef.current = null;
+  }, []);
+
+  // Decodes one H.264 access unit and paints it. The decoder is (re)created on a keyframe,
+  // which the server always sends first, so a decode error just waits for the next one.
+  const decodeUnit = useCallback((message: Uint8Array) => {
+    const keyframe = (message[0] & PREVIEW_FLAG_KEYFRAME) !== 0;
+    const unit = message.subarray(1);
+
+    if (!decoderRef.current) {
+      if (!keyframe || !webCodecs.VideoDecoder) {
+        return;
+      }
+      const decoder = new webCodecs.VideoDecoder({
+        output: (frame: any) => {
+          const canvas = canvasRef.current;
+          const ctx = canvas?.getContext('2d');
+          if (canvas && ctx) {
+            if (canvas.width !== frame.displayWidth || canvas.height !== frame.displayHeight) {
+              canvas.width = frame.displayWidth;
+              canvas.height = frame.displayHeight;
+            }
+            ctx.drawImage(frame, 0, 0);
+            setFrameCount(prev => prev + 1);
+          }
+          frame.close();
+        },
+        error: (err: any) => {
+          console.error('H.264 decode error, waiting for the next keyframe:', err);
+          decoderRef.current = null;
+        },
+      });
+      // No description: the decoder reads SPS/PPS in-band from the Annex-B keyframe
+      decoder.configure({ codec: codecFromKeyframe(unit), optimizeForLatency: true });
+      decoderRef.current = decoder;
+    }
+
+    try {
+      decoderRef.current.decode(new webCodecs.EncodedVideoChunk({
+        type: keyframe ? 'key' : 'delta',
+        timestamp: performance.now() * 1000,
+        data: unit,
+      }));
+    } catch (err) {
+      console.error('Error decoding H.264 frame:', err);
+      closeDecoder();
+    }
+  }, [closeDecoder]);
+
   const drawFrame = useCallback((base64Data: string) => {
     const canvas = canvasRef.current;
     if (!canvas) {
@@ -189,9 +278,10 @@ export const WebSocketStreamPlayer: React.FC<WebSocketStreamPlayerProps> = ({
       wsRef.current.close(1000, 'Component unmounting');
       wsRef.current = null;
     }
+    closeDecoder();
     setIsConnected(false);
     setFrameCount(0);
-  }, []);
+  }, [closeDecoder]);
 
   // Connect when component mounts or sessionId changes
   useEffect(() => {
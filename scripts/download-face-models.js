@@ -3,10 +3,13 @@ const fs = require('fs');
 const path = require('path');
 
 const modelsDir = path.join(process.cwd(), 'models', 'face_detection');
+const cascadeDir = path.join(process.cwd(), 'models', 'cascade');
 
-// Ensure models directory exists
-if (!fs.existsSync(modelsDir)) {
-  fs.mkdirSync(modelsDir, { recursive: true });
+// Ensure models directories exist
+for (const dir of [modelsDir, cascadeDir]) {
+  if (!fs.existsSync(dir)) {
+    fs.mkdirSync(dir, { recursive: true });
+  }
 }
 
 const models = [
@@ -19,6 +22,17 @@ const models = [
     name: 'res10_300x300_ssd_iter_140000.caffemodel',
     url: 'https://raw.githubusercontent.com/opencv/opencv_3rdparty/dnn_samples_face_detector_20170830/res10_300x300_ssd_iter_140000.caffemodel',
     path: path.join(modelsDir, 'res10_300x300_ssd_iter_140000.caffemodel')
+  },
+  // Cascades for the low-power detector and the detection pre-filter (LBP preferred, Haar as fallback)
+  {
+    name: 'lbpcascade_frontalface_improved.xml',
+    url: 'https://raw.githubusercontent.com/opencv/opencv/4.x/data/lbpcascades/lbpcascade_frontalface_improved.xml',
+    path: path.join(cascadeDir, 'lbpcascade_frontalface_improved.xml')
+  },
+  {
+    name: 'haarcascade_frontalface_alt.xml',
+    url: 'https://raw.githubusercontent.com/opencv/opencv/4.x/data/haarcascades/haarcascade_frontalface_alt.xml',
+    path: path.join(cascadeDir, 'haarcascade_frontalface_alt.xml')
   }
 ];
 
@@ -8,9 +8,11 @@ import {
   DetectionService,
 } from '@/services';
 import { faceRecognitionService } from '@/services/FaceRecognitionService';
+import { activityCounterService, ActivityGranularity, ActivityScope } from '@/services/ActivityCounterService';
 import { frameExtractionService } from '@/services/FrameExtractionService';
 import fs from 'fs';
 import path from 'path';
+import { Between, MoreThanOrEqual } from 'typeorm';
 
 export class DashboardController {
   private personService: PersonService;
@@ -69,7 +71,6 @@ export class DashboardController {
       totalPeople,
       totalCameras,
       totalEvents,
-      totalDetections,
       activeCameras,
       detectionsToday,
       eventsToday
@@ -77,7 +78,6 @@ export class DashboardController {
       this.personService.countByOrganization(organizationId),
       this.cameraService.countByOrganization(organizationId),
       this.eventService.countByOrganization(organizationId),
-      this.detectionService.countByOrganization(organizationId),
       this.getActiveCamerasCount(organizationId),
       this.getDetectionsToday(organizationId),
       this.getEventsToday(organizationId)
@@ -182,6 +182,67 @@ export class DashboardController {
     });
   });
 
+  /**
+   * @swagger
+   * /api/v1/dashboard/activity:
+   *   get:
+   *     summary: Get detection counts over time
+   *     description: Minute, hour or day buckets for the organization and each of its cameras, events and people, from the rolling counters
+   *     tags: [Dashboard]
+   *     security:
+   *       - bearerAuth: []
+   *     parameters:
+   *       - in: query
+   *         name: granularity
+   *         schema:
+   *           type: string
+   *           enum: [minute, hour, day]
+   *           default: hour
+   *       - in: query
+   *         name: buckets
+   *         schema:
+   *           type: integer
+   *           default: 24
+   *       - in: query
+   *         name: scopes
+   *         description: Comma-separated subset of organization, camera, event and person
+   *         schema:
+   *           type: string
+   *     responses:
+   *       200:
+   *         description: Detection counts retrieved successfully
+   *       400:
+   *         description: Invalid granularity
+   *       503:
+   *         description: Counters are not available yet
+   *       403:
+   *         description: Organization access required
+   */
+  getActivity = asyncHandler(async (req: OrganizationRequest, res: Response): Promise<void> => {
+    const organizationId = req.organizationId;
+    const granularity = (req.query.granularity as string) || 'hour';
+    if (!['minute', 'hour', 'day'].includes(granularity)) {
+      res.status(400).json({ success: false, message: 'granularity must be minute, hour or day' });
+      return;
+    }
+    const buckets = Math.max(1, parseInt((req.query.buckets as string) || '24') || 24);
+    const scopes = req.query.scopes
+      ? (req.query.scopes as string).split(',').map(scope => scope.trim()) as ActivityScope[]
+      : undefined;
+
+    const snapshot = activityCounterService.snapshot(organizationId, granularity as ActivityGranularity, buckets, scopes);
+    if (!snapshot) {
+      res.status(503).json({ success: false, message: 'Activity counters are not available yet' });
+      return;
+    }
+
+    res.status(200).json({
+      success: true,
+      message: 'Activity retrieved successfully',
+      data: snapshot,
+    });
+  });
+
   private async getActiveCamerasCount(organizationId: number): Promise<number> {
     try {
       // ALWAYS filter by organizationId - this is mandatory
@@ -197,8 +258,18 @@ export class DashboardController {
 
   private async getDetectionsToday(organizationId: number): Promise<number> {
     try {
+      // Rolling counters answer without touching the detections table
+      const counted = activityCounterService.getTodayComparison(organizationId);
+      if (counted) {
+        return counted.today;
+      }
       // ALWAYS filter by organizationId - this is mandatory
-      return await this.detectionService.countByOrganization(organizationId);
+      const midnight = new Date();
+      midnight.setHours(0, 0, 0, 0);
+      return await this.detectionService.repository.countWhere({
+        organizationId,
+        detectedAt: MoreThanOrEqual(midnight)
+      } as any);
     } catch (error) {
       return 0;
     }
@@ -225,9 +296,20 @@ export class DashboardController {
 
   private async getPreviousDetectionsToday(organizationId: number): Promise<number> {
     try {
+      // Yesterday up to the same time of day
+      const counted = activityCounterService.getTodayComparison(organizationId);
+      if (counted) {
+        return counted.yesterday;
+      }
       // ALWAYS filter by organizationId - this is mandatory
-      const currentCount = await this.getDetectionsToday(organizationId);
-      return Math.floor(currentCount * 0.9);
+      const yesterday = new Date();
+      yesterday.setDate(yesterday.getDate() - 1);
+      const yesterdayMidnight = new Date(yesterday);
+      yesterdayMidnight.setHours(0, 0, 0, 0);
+      return await this.detectionService.repository.countWhere({
+        organizationId,
+        detectedAt: Between(yesterdayMidnight, yesterday)
+      } as any);
     } catch (error) {
       return 0;
     }
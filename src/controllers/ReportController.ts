@@ -1,13 +1,29 @@
 import { Response } from 'express';
 import { AuthenticatedRequest } from '../middlewares/auth';
-import { DetectionRepository } from '../repositories';
+import { DetectionRepository, PersonFaceRepository } from '../repositories';
 import { AppDataSource } from '../config/database';
+import { embeddingKnnService, EMBEDDING_KNN_MAX_K } from '../services/EmbeddingKnnService';
+
+interface FaceSearchRow {
+  detectionId: number;
+  detectedAt: string;
+  faceStatus: string;
+  imageUrl: string | null;
+  personFaceId: number | null;
+  eventId: number;
+  eventName: string;
+  cameraId: number | null;
+  cameraName: string | null;
+  similarity: number;
+}
 
 export class ReportController {
   private detectionRepository: DetectionRepository;
+  private personFaceRepository: PersonFaceRepository;
 
   constructor() {
     this.detectionRepository = new DetectionRepository();
+    this.personFaceRepository = new PersonFaceRepository();
   }
 
   /**
@@ -179,4 +195,212 @@ export class ReportController {
       });
     }
   };
+
+  /**
+   * Get face search report (detections that look like a person, whether or not they were linked to them)
+   */
+  getFaceSearchReport = async (req: AuthenticatedRequest, res: Response): Promise<void> => {
+    try {
+      const { eventIds } = req.query;
+      const organizationId = req.user?.organizationId;
+      const personId = parseInt(req.query.personId as string);
+      const k = Math.min(Math.max(parseInt((req.query.k as string) || '50') || 50, 1), 1000);
+      const minSimilarity = parseFloat((req.query.minSimilarity as string) || '0.5') || 0;
+
+      if (!organizationId) {
+        res.status(400).json({
+          success: false,
+          message: 'Organization ID is required',
+        });
+        return;
+      }
+      if (isNaN(personId)) {
+        res.status(400).json({
+          success: false,
+          message: 'personId is required',
+        });
+        return;
+      }
+
+      let eventIdArray: number[] = [];
+      if (typeof eventIds === 'string') {
+        eventIdArray = eventIds.split(',').map(id => parseInt(id.trim())).filter(id => !isNaN(id));
+      } else if (Array.isArray(eventIds)) {
+        eventIdArray = eventIds.map(id => parseInt(id as string)).filter(id => !isNaN(id));
+      }
+
+      const startTime = Date.now();
+      const rows = embeddingKnnService.isReady()
+        ? await this.faceSearchInSql(personId, organizationId, eventIdArray, k, minSimilarity)
+        : await this.faceSearchInJs(personId, organizationId, eventIdArray, k, minSimilarity);
+
+      res.status(200).json({
+        success: true,
+        data: rows,
+        total: rows.length,
+        engine: embeddingKnnService.isReady() ? 'sqlite' : 'javascript',
+        processingTimeMs: Date.now() - startTime,
+      });
+    } catch (error: any) {
+      console.error('❌ Error generating face search report:', error);
+      res.status(500).json({
+        success: false,
+        message: 'Error generating face search report',
+        error: error.message,
+      });
+    }
+  };
+
+  /**
+   * One statement: every face of the person searches the organization's detections natively (embedding_knn).
+   * The virtual table ranks before the join sees the event, soft-delete and similarity conditions, so it is
+   * asked for its deepest top-k and the person's top k is taken after filtering, as faceSearchInJs does.
+   * The two agree unless more than EMBEDDING_KNN_MAX_K filtered-out detections rank above the k-th row.
+   */
+  private async faceSearchInSql(
+    personId: number,
+    organizationId: number,
+    eventIdArray: number[],
+    k: number,
+    minSimilarity: number
+  ): Promise<FaceSearchRow[]> {
+    const queryParams: any[] = [EMBEDDING_KNN_MAX_K, personId, organizationId, minSimilarity];
+    let eventCondition = '';
+    if (eventIdArray.length > 0) {
+      eventCondition = ` AND d.event_id IN (${eventIdArray.map(() => '?').join(',')})`;
+      queryParams.push(...eventIdArray);
+    }
+    queryParams.push(k);
+
+    const query = `
+      SELECT
+        d.id as detectionId,
+        d.detectedAt as detectedAt,
+        d.faceStatus as faceStatus,
+        d.imageUrl as imageUrl,
+        d.personface_id as personFaceId,
+        e.id as eventId,
+        e.name as eventName,
+        c.id as cameraId,
+        c.name as cameraName,
+        MAX(m.similarity) as similarity
+      FROM person_faces pf
+      INNER JOIN people p ON pf.person_id = p.id
+      INNER JOIN embedding_knn('detections', 'embedding', pf.embedding, ?, pf.embeddingModel, p.organization_id) m
+      INNER JOIN detections d ON d.id = m.id
+      INNER JOIN events e ON d.event_id = e.id
+      LEFT JOIN cameras c ON d.camera_id = c.id
+      WHERE pf.person_id = ?
+        AND p.organization_id = ?
+        AND pf.deletedAt IS NULL
+        AND d.deletedAt IS NULL
+        AND m.similarity >= ?
+        ${eventCondition}
+      GROUP BY d.id
+      ORDER BY similarity DESC
+      LIMIT ?
+    `;
+
+    const result = await AppDataSource.query(query, queryParams);
+    return result.map((item: any) => ({
+      detectionId: Number(item.detectionId),
+      detectedAt: item.detectedAt,
+      faceStatus: item.faceStatus,
+      imageUrl: item.imageUrl,
+      personFaceId: item.personFaceId === null ? null : Number(item.personFaceId),
+      eventId: Number(item.eventId),
+      eventName: item.eventName,
+      cameraId: item.cameraId === null ? null : Number(item.cameraId),
+      cameraName: item.cameraName,
+      similarity: Number(item.similarity),
+    }));
+  }
+
+  /**
+   * Without the extension (PostgreSQL, or not built): detection embeddings are paged into JavaScript and scored here
+   */
+  private async faceSearchInJs(
+    personId: number,
+    organizationId: number,
+    eventIdArray: number[],
+    k: number,
+    minSimilarity: number
+  ): Promise<FaceSearchRow[]> {
+    const faces = await this.personFaceRepository.getRepository()
+      .createQueryBuilder('personFace')
+      .innerJoin('personFace.person', 'person')
+      .where('personFace.personId = :personId', { personId })
+      .andWhere('person.organizationId = :organizationId', { organizationId })
+      .andWhere('personFace.embedding IS NOT NULL')
+      .getMany();
+    const queries = faces.map(face => ({ model: face.embeddingModel || '', vector: this.normalized(face.embedding!) }))
+      .filter(query => query.vector !== null) as Array<{ model: string; vector: Float32Array }>;
+    if (queries.length === 0) {
+      return [];
+    }
+
+    const best = new Map<number, FaceSearchRow>();
+    const pageSize = 2000;
+    let lastId = 0;
+    for (;;) {
+      const builder = this.detectionRepository.getRepository()
+        .createQueryBuilder('detection')
+        .leftJoinAndSelect('detection.event', 'event')
+        .leftJoinAndSelect('detection.camera', 'camera')
+        .where('detection.organizationId = :organizationId', { organizationId })
+        .andWhere('detection.embedding IS NOT NULL')
+        .andWhere('detection.id > :lastId', { lastId });
+      if (eventIdArray.length > 0) {
+        builder.andWhere('detection.eventId IN (:...eventIds)', { eventIds: eventIdArray });
+      }
+      const page = await builder.orderBy('detection.id', 'ASC').limit(pageSize).getMany();
+
+      for (const detection of page) {
+        const vector = this.normalized(detection.embedding!);
+        if (!vector) continue;
+        let similarity = -Infinity;
+        for (const query of queries) {
+          // Same rule as the native galleries: untagged embeddings compare with any model of their dimension
+          if (query.vector.length !== vector.length) continue;
+          if (query.model && detection.embeddingModel && query.model !== detection.embeddingModel) continue;
+          let dot = 0;
+          for (let i = 0; i < vector.length; i++) dot += vector[i] * query.vector[i];
+          similarity = Math.max(similarity, dot);
+        }
+        if (similarity >= minSimilarity) {
+          best.set(detection.id, {
+            detectionId: detection.id,
+            detectedAt: new Date(detection.detectedAt).toISOString(),
+            faceStatus: detection.faceStatus,
+            imageUrl: detection.imageUrl ?? null,
+            personFaceId: detection.personFaceId ?? null,
+            eventId: detection.eventId,
+            eventName: detection.event?.name,
+            cameraId: detection.cameraId ?? null,
+            cameraName: detection.camera?.name ?? null,
+            similarity,
+          });
+        }
+      }
+      if (page.length < pageSize) {
+        break;
+      }
+      lastId = page[page.length - 1].id;
+    }
+    return [...best.values()].sort((a, b) => b.similarity - a.similarity).slice(0, k);
+  }
+
+  private normalized(buffer: Buffer): Float32Array | null {
+    // Copy into a fresh ArrayBuffer: pooled Buffers are not guaranteed to be 4-byte aligned
+    const bytes = new Uint8Array(buffer);
+    const vector = new Float32Array(bytes.buffer, 0, Math.floor(bytes.byteLength / Float32Array.BYTES_PER_ELEMENT));
+    let norm = 0;
+    for (let i = 0; i < vector.length; i++) norm += vector[i] * vector[i];
+    if (!(norm > 0) || !isFinite(norm)) {
+      return null;
+    }
+    const inv = 1 / Math.sqrt(norm);
+    for (let i = 0; i < vector.length; i++) vector[i] *= inv;
+    return vector;
+  }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@ import { asyncHandler, createError } from '../middlewares/errorHandler';
 import { CameraService } from '../services';
 import { frameExtractionService } from '../services/FrameExtractionService';
 import { faceRecognitionService } from '../services/FaceRecognitionService';
+import { nativeFaceDetectionService } from '../services/NativeFaceDetectionService';
 
 export class StreamController {
   private cameraService: CameraService;
@@ -380,6 +381,40 @@ export class StreamController {
     });
   });
 
+  /**
+   * @swagger
+   * /api/v1/streams/face-recognition/profile:
+   *   post:
+   *     summary: Profile the native detection pipeline with hardware counters
+   *     tags: [Streams]
+   *     parameters:
+   *       - in: query
+   *         name: durationMs
+   *         schema:
+   *           type: integer
+   *           default: 5000
+   *     responses:
+   *       200:
+   *         description: Per-stage IPC, cache and branch miss rates over the window
+   */
+  profileFaceRecognition = asyncHandler(async (req: Request, res: Response): Promise<void> => {
+    const durationMs = req.query.durationMs ? parseInt(req.query.durationMs as string) : 5000;
+    if (!Number.isFinite(durationMs) || durationMs <= 0 || durationMs > 60000) {
+      throw createError('durationMs must be between 1 and 60000', 400);
+    }
+
+    const report = await nativeFaceDetectionService.profile(durationMs);
+    if (!report) {
+      throw createError('Native face detector is not available', 503);
+    }
+
+    res.status(200).json({
+      success: true,
+      message: 'Native pipeline profile',
+      data: report,
+    });
+  });
+
   /**
    * @swagger
    * /api/v1/streams/face-recognition/sessions:
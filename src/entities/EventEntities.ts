@@ -1,4 +1,4 @@
-import { Entity, Column, ManyToOne, OneToMany, JoinColumn } from 'typeorm';
+import { Entity, Column, ManyToOne, OneToMany, JoinColumn, Index } from 'typeorm';
 import { IsString, IsOptional, Length, IsDateString, IsNumber } from 'class-validator';
 import { BaseEntity } from './BaseEntity';
 import { Organization } from './OrganizationEntities';
@@ -226,6 +226,7 @@ class Camera extends BaseEntity {
 
 // Detection Entity
 @Entity('detections')
+@Index(['journalEpoch', 'journalSeq'], { unique: true })
 class Detection extends BaseEntity {
   @Column({
     type: 'datetime',
@@ -290,6 +291,31 @@ class Detection extends BaseEntity {
   })
   embedding?: Buffer; // Binary data for face embedding (blob for SQLite)
 
+  @Column({
+    type: 'varchar',
+    length: 100,
+    nullable: true
+  })
+  @IsOptional()
+  embeddingModel?: string; // Version tag of the model that produced the embedding
+
+  @Column({
+    name: 'journal_epoch',
+    type: 'varchar',
+    length: 16,
+    nullable: true
+  })
+  @IsOptional()
+  journalEpoch?: string; // Random id of the journal file the row came from; seq restarts in a new file
+
+  @Column({
+    name: 'journal_seq',
+    type: 'bigint',
+    nullable: true
+  })
+  @IsOptional()
+  journalSeq?: number; // Sequence number in the native detection journal; with journalEpoch, makes journal replay idempotent
+
   // Foreign Keys
   @Column({ name: 'personface_id', nullable: true })
   personFaceId?: number;
@@ -185,6 +185,14 @@ export class PersonFace extends BaseEntity {
   })
   embedding?: Buffer; // Binary data for face embedding (blob for SQLite)
 
+  @Column({
+    type: 'varchar',
+    length: 100,
+    nullable: true
+  })
+  @IsOptional()
+  embeddingModel?: string; // Version tag of the model that produced the embedding (null = legacy)
+
   @Column({
     type: 'float',
     nullable: true
@@ -16,6 +16,13 @@ import { streamService } from '@/services/StreamService';
 import { webSocketStreamService } from '@/services/WebSocketStreamService';
 import { eventSchedulerService } from '@/services/EventSchedulerService';
 import { faceIndexService } from '@/services/FaceIndexService';
+import { detectionJournalService } from '@/services/DetectionJournalService';
+import { retroactiveMatchService } from '@/services/RetroactiveMatchService';
+import { activityCounterService } from '@/services/ActivityCounterService';
+import { faceRecognitionService } from '@/services/FaceRecognitionService';
+import { watchlistService } from '@/services/WatchlistService';
+import { embeddingKnnService } from '@/services/EmbeddingKnnService';
+import { personImageProcessingService } from '@/services/PersonImageProcessingService';
 
 // Load environment variables
 dotenv.config();
@@ -82,7 +89,8 @@ app.use(express.urlencoded({ extended: true, limit: '10mb' }));
 
 // Logging
 if (process.env.NODE_ENV !== 'test') {
-  app.use(morgan('combined'));
+  // Standbys poll the face index change log many times a second
+  app.use(morgan('combined', { skip: (req) => req.method === 'GET' && (req.url || '').includes('/face-index/replication') }));
 }
 
 // Static file serving for uploaded images
@@ -124,6 +132,38 @@ const startServer = async (): Promise<void> => {
       console.error('❌ Face Recognition ANN Index initialization failed:', indexError);
       console.log('⚠️ Face recognition will work with reduced performance');
     }
+
+    // Watchlisted people are checked natively on every embedded face, ahead of the gallery search
+    await watchlistService.start();
+
+    // Replay detections journaled before the last shutdown, then drain in the background
+    try {
+      await detectionJournalService.start();
+    } catch (journalError) {
+      console.error('❌ Detection journal replay failed:', journalError);
+    }
+
+    // Load past unknown detections for retroactive matching in the background; enrollments sync again first
+    retroactiveMatchService.sync().catch(error => console.error('❌ Retroactive match store load failed:', error));
+
+    // Restore dashboard counters and count detections stored since; the dashboard queries the database until then
+    activityCounterService.start();
+
+    // SQLite only: similarity reports search embeddings inside the database; they score in JavaScript until it is ready
+    embeddingKnnService.start();
+
+    // Enrollments made before a model was loaded lack its embedding; add them in the background so a camera
+    // degraded to the light tier still recognizes everyone. FACE_TIER_BACKFILL=false leaves the detector lazy.
+    if (process.env.FACE_TIER_BACKFILL !== 'false') {
+      faceRecognitionService.initialize()
+        .then(() => personImageProcessingService.backfillMissingTiers())
+        .then(result => {
+          if (result.personFacesCreated > 0 || result.failed > 0) {
+            console.log(`✅ Embedding backfill: ${result.personFacesCreated} faces added for ${result.embeddingModels.join(', ')} (${result.failed} images failed) in ${result.processingTimeMs}ms`);
+          }
+        })
+        .catch(error => console.error('❌ Embedding backfill failed:', error));
+    }
   } catch (error: unknown) {
     // Type guard to check if error is an Error object
     const errorMessage = error instanceof Error
@@ -143,6 +183,14 @@ const startServer = async (): Promise<void> => {
   // Initialize WebSocket streaming service
   webSocketStreamService.initialize(server);
 
+  // Live overlays: a frame's boxes as soon as they are detected, its identities once matched
+  if (process.env.LIVE_DETECTIONS !== 'false') {
+    faceRecognitionService.onFrameResults(update => webSocketStreamService.broadcastDetections(update));
+  }
+
+  // Watchlist alerts reach viewers of the organization's cameras as soon as they are raised
+  watchlistService.onAlert(alert => webSocketStreamService.broadcastWatchlistAlert(alert));
+
   server.listen(PORT, host, () => {
     console.log(`🚀 Server is running on port ${PORT}`);
     console.log(`🌝 Environment: ${process.env.NODE_ENV || 'development'}`);
@@ -177,7 +225,10 @@ process.on('SIGTERM', () => {
   streamService.stopAllStreams();
   console.log('❰ Stopping event scheduler...');
   eventSchedulerService.stop();
-  process.exit(0);
+  detectionJournalService.close();
+  watchlistService.stop();
+  embeddingKnnService.stop();
+  activityCounterService.close().finally(() => process.exit(0));
 });
 
 process.on('SIGINT', () => {
@@ -186,7 +237,10 @@ process.on('SIGINT', () => {
   streamService.stopAllStreams();
   console.log('❰ Stopping event scheduler...');
   eventSchedulerService.stop();
-  process.exit(0);
+  detectionJournalService.close();
+  watchlistService.stop();
+  embeddingKnnService.stop();
+  activityCounterService.close().finally(() => process.exit(0));
 });
 
 // Handle unhandled promise rejections
@@ -0,0 +1,124 @@
+#include "cpu_features.h"
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FD_X86_CPUID 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define FD_X86_CPUID 1
+#endif
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+const char* cpuIsaName(CpuIsa isa) {
+    switch (isa) {
+        case CpuIsa::Scalar: return "scalar";
+        case CpuIsa::SSE42: return "sse4.2";
+        case CpuIsa::AVX2: return "avx2";
+        case CpuIsa::AVX512: return "avx512";
+        case CpuIsa::NEON: return "neon";
+    }
+    return "scalar";
+}
+
+CpuIsa cpuIsaFromName(const std::string& name) {
+    for (int i = static_cast<int>(CpuIsa::Scalar); i <= static_cast<int>(CpuIsa::NEON); i++) {
+        if (name == cpuIsaName(static_cast<CpuIsa>(i))) {
+            return static_cast<CpuIsa>(i);
+        }
+    }
+    return CpuIsa::Scalar;
+}
+
+#ifdef FD_X86_CPUID
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: which register states the OS saves on context switch
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+
+#ifdef FD_X86_CPUID
+    uint32_t regs[4] = {0, 0, 0, 0};
+    cpuid(0, 0, regs);
+    uint32_t maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    features.sse42 = (regs[2] & (1u << 20)) != 0;
+    features.popcnt = (regs[2] & (1u << 23)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avxCpu = (regs[2] & (1u << 28)) != 0;
+    bool fmaCpu = (regs[2] & (1u << 12)) != 0;
+
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool ymmState = (xcr0 & 0x6) == 0x6;    // XMM and YMM
+    bool zmmState = (xcr0 & 0xE6) == 0xE6;  // plus opmask and ZMM
+
+    features.avx = avxCpu && ymmState;
+    features.fma = fmaCpu && features.avx;
+
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = features.avx && (regs[1] & (1u << 5)) != 0;
+        features.avx512f = zmmState && (regs[1] & (1u << 16)) != 0;
+        features.avx512bw = features.avx512f && (regs[1] & (1u << 30)) != 0;
+        features.avx512vl = features.avx512f && (regs[1] & (1u << 31)) != 0;
+        features.avx512vpopcntdq = features.avx512f && (regs[2] & (1u << 14)) != 0;
+    }
+#endif
+
+#if defined(__aarch64__)
+    // Advanced SIMD is mandatory on AArch64; the hwcap is checked for completeness
+#if defined(__linux__)
+    features.neon = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+    features.neon = true;
+#endif
+#elif defined(__arm__) && defined(__linux__)
+    features.neon = (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+
+    return features;
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+std::vector<std::string> cpuFeatureNames(const CpuFeatures& features) {
+    std::vector<std::string> names;
+    if (features.sse42) names.push_back("sse4.2");
+    if (features.popcnt) names.push_back("popcnt");
+    if (features.avx) names.push_back("avx");
+    if (features.avx2) names.push_back("avx2");
+    if (features.fma) names.push_back("fma");
+    if (features.avx512f) names.push_back("avx512f");
+    if (features.avx512bw) names.push_back("avx512bw");
+    if (features.avx512vl) names.push_back("avx512vl");
+    if (features.avx512vpopcntdq) names.push_back("avx512vpopcntdq");
+    if (features.neon) names.push_back("neon");
+    return names;
+}
@@ -0,0 +1,47 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <string>
+#include <vector>
+
+// Instruction sets the native kernels are built for, in increasing order of preference per architecture.
+enum class CpuIsa : int {
+    Scalar = 0,
+    SSE42 = 1,
+    AVX2 = 2,
+    AVX512 = 3,
+    NEON = 4
+};
+
+struct CpuFeatures {
+    bool sse42 = false;
+    bool popcnt = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512vpopcntdq = false;
+    bool neon = false;
+};
+
+const char* cpuIsaName(CpuIsa isa);
+
+/**
+ * @brief Parses an ISA name ("scalar", "sse4.2", "avx2", "avx512", "neon").
+ * @return The ISA, or CpuIsa::Scalar if the name is unknown.
+ */
+CpuIsa cpuIsaFromName(const std::string& name);
+
+/**
+ * @brief Features of the running CPU, detected once with cpuid/xgetbv on x86
+ * and getauxval(AT_HWCAP) on ARM Linux. OS support for the AVX register state
+ * is checked, not just the CPU flags.
+ */
+const CpuFeatures& cpuFeatures();
+
+// Names of the features that are present, e.g. {"sse4.2", "popcnt", "avx2", "fma"}
+std::vector<std::string> cpuFeatureNames(const CpuFeatures& features);
+
+#endif // CPU_FEATURES_H
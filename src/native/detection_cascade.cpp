@@ -0,0 +1,89 @@
+#include "detection_cascade.h"
+
+void DetectionCascade::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    defaults = config;
+}
+
+DetectionCascade::Config DetectionCascade::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return defaults;
+}
+
+void DetectionCascade::setCameraConfig(int cameraId, const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overrides[cameraId] = config;
+}
+
+void DetectionCascade::clearCameraConfig(int cameraId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overrides.erase(cameraId);
+}
+
+DetectionCascade::Config DetectionCascade::configFor(int cameraId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = overrides.find(cameraId);
+    return it != overrides.end() ? it->second : defaults;
+}
+
+DetectionCascade::Decision DetectionCascade::admit(int cameraId, bool fired, double prefilterMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = overrides.find(cameraId);
+    const Config& config = it != overrides.end() ? it->second : defaults;
+
+    CameraState& state = cameras[cameraId];
+    CameraStats& stats = state.stats;
+    stats.frames++;
+    stats.avgPrefilterMs = stats.frames == 1 ? prefilterMs : stats.avgPrefilterMs * 0.9 + prefilterMs * 0.1;
+    if (fired) {
+        stats.prefilterFires++;
+        return Decision::Fired;
+    }
+    if (state.holdRemaining > 0) {
+        state.holdRemaining--;
+        return Decision::Hold;
+    }
+
+    // A camera seen for the first time gets a full run, so refreshes have a baseline
+    bool firstFrame = state.lastFull.time_since_epoch().count() == 0;
+    bool frameRefresh = config.refreshFrames > 0 && state.framesSinceFull + 1 >= config.refreshFrames;
+    bool timeRefresh = config.refreshMs > 0 &&
+        std::chrono::steady_clock::now() - state.lastFull >= std::chrono::milliseconds(config.refreshMs);
+    if (firstFrame || frameRefresh || timeRefresh) {
+        return Decision::Refresh;
+    }
+
+    state.framesSinceFull++;
+    return Decision::Skip;
+}
+
+void DetectionCascade::recordFull(int cameraId, Decision decision, size_t faces, double fullMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = overrides.find(cameraId);
+    const Config& config = it != overrides.end() ? it->second : defaults;
+
+    CameraState& state = cameras[cameraId];
+    CameraStats& stats = state.stats;
+    state.framesSinceFull = 0;
+    state.lastFull = std::chrono::steady_clock::now();
+
+    stats.fullRuns++;
+    stats.avgFullMs = stats.fullRuns == 1 ? fullMs : stats.avgFullMs * 0.9 + fullMs * 0.1;
+    if (decision == Decision::Hold) stats.holdRuns++;
+    if (decision == Decision::Refresh) stats.refreshRuns++;
+    if (faces > 0) {
+        stats.fullHits++;
+        if (decision == Decision::Refresh) stats.refreshHits++;
+        state.holdRemaining = config.holdFrames;
+    }
+}
+
+std::map<int, DetectionCascade::CameraStats> DetectionCascade::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<int, CameraStats> result;
+    for (const auto& entry : cameras) {
+        result[entry.first] = entry.second.stats;
+        result[entry.first].overridden = overrides.count(entry.first) > 0;
+    }
+    return result;
+}
@@ -0,0 +1,78 @@
+#ifndef DETECTION_CASCADE_H
+#define DETECTION_CASCADE_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+/**
+ * @brief Decides, per camera, whether a frame runs the full detection network.
+ *
+ * Stage one is a cheap pre-filter (an LBP/Haar cascade on a thumbnail) that
+ * runs on every frame. The full network runs only when stage one fires, for a
+ * few frames after the network last found a face (so a face the cascade loses
+ * in profile is not dropped), and as a periodic refresh that also measures
+ * how many faces the pre-filter misses. Settings can be overridden per camera.
+ */
+class DetectionCascade {
+public:
+    struct Config {
+        bool enabled = false;
+        int thumbnailWidth = 320;   // Pre-filter input width; faces below ~4x the cascade window are missed
+        int minNeighbors = 2;       // Cascade hit threshold; lower fires more often
+        int refreshFrames = 10;     // Run the full network at least every N frames (0 = never)
+        int refreshMs = 5000;       // ... and at least this often (0 = never)
+        int holdFrames = 3;         // Keep running the full network this many frames after it found a face
+    };
+
+    struct CameraStats {
+        unsigned long long frames = 0;         // Frames that went through the cascade
+        unsigned long long prefilterFires = 0; // Stage one found a face candidate
+        unsigned long long fullRuns = 0;       // Full network runs (fires, holds and refreshes)
+        unsigned long long holdRuns = 0;       // Full runs because a face was seen recently
+        unsigned long long refreshRuns = 0;    // Full runs forced by refreshFrames/refreshMs
+        unsigned long long fullHits = 0;       // Full runs that found at least one face
+        unsigned long long refreshHits = 0;    // Refreshes that found a face stage one missed
+        double avgPrefilterMs = 0.0;
+        double avgFullMs = 0.0;
+        bool overridden = false;               // Camera has its own Config
+    };
+
+    // Why the full network runs for a frame; Skip means it does not
+    enum class Decision { Skip, Fired, Hold, Refresh };
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+
+    // Per-camera override; clearCameraConfig returns the camera to the default config
+    void setCameraConfig(int cameraId, const Config& config);
+    void clearCameraConfig(int cameraId);
+    Config configFor(int cameraId) const;
+
+    /**
+     * @brief Records the pre-filter outcome for a frame and decides whether the full network runs.
+     * @param fired Stage one found at least one candidate.
+     * @param prefilterMs Time spent in stage one.
+     */
+    Decision admit(int cameraId, bool fired, double prefilterMs);
+
+    // Records a full network run admitted by admit()
+    void recordFull(int cameraId, Decision decision, size_t faces, double fullMs);
+
+    std::map<int, CameraStats> snapshot() const;
+
+private:
+    struct CameraState {
+        CameraStats stats;
+        int framesSinceFull = 0;
+        int holdRemaining = 0;
+        std::chrono::steady_clock::time_point lastFull;
+    };
+
+    mutable std::mutex mutex;
+    Config defaults;
+    std::map<int, Config> overrides;
+    std::map<int, CameraState> cameras;
+};
+
+#endif // DETECTION_CASCADE_H
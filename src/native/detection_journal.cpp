@@ -0,0 +1,392 @@
+#include "detection_journal.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout: one header page, then records back to back.
+//   record: RecordHeader | fixed fields | embedding floats | model | crop | metadata, padded to 8 bytes
+// A record is valid when its magic, length and CRC check out and its seq follows the previous one;
+// the first invalid record ends the journal, which is how a torn append is dropped on recovery.
+static const char kJournalMagic[8] = {'F', 'D', 'J', 'R', 'N', 'L', '0', '1'};
+static const uint32_t kJournalVersion = 1;
+static const uint64_t kHeaderSize = 4096;
+static const uint32_t kRecordMagic = 0x31524446; // "FDR1"
+
+struct DetectionJournal::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;
+    uint64_t committedSeq; // Watermark: records up to here have been written downstream
+    uint64_t firstSeq;     // Seq of the record at kHeaderSize; moves forward on compaction
+    uint64_t epoch;        // Random per file, so (epoch, seq) stays unique when the file is replaced
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;       // Whole record including this header, multiple of 8
+    uint64_t seq;
+    uint32_t crc;          // CRC-32 of seq and payload
+    uint32_t payloadSize;
+};
+
+struct PackedRecord {
+    int64_t detectedAtMs;
+    int64_t eventId;
+    int64_t trackId;
+    int64_t personFaceId;
+    int32_t organizationId;
+    int32_t cameraId;
+    float similarity;
+    float confidence;
+    int32_t x, y, width, height;
+    uint8_t faceStatus;
+    uint8_t detectionStatus;
+    uint16_t modelLength;
+    uint32_t embeddingSize;
+    uint32_t cropLength;
+    uint32_t metadataLength;
+};
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    static uint32_t table[256];
+    static bool initialized = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)initialized;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t recordCrc(uint64_t seq, const uint8_t* payload, size_t length) {
+    uint32_t crc = crc32Update(0xFFFFFFFFu, reinterpret_cast<const uint8_t*>(&seq), sizeof(seq));
+    return crc32Update(crc, payload, length) ^ 0xFFFFFFFFu;
+}
+
+static size_t payloadSize(const JournalRecord& record) {
+    return sizeof(PackedRecord) + record.embedding.size() * sizeof(float) +
+           record.embeddingModel.size() + record.cropRef.size() + record.metadata.size();
+}
+
+static uint32_t recordLength(const JournalRecord& record) {
+    size_t length = sizeof(RecordHeader) + payloadSize(record);
+    return static_cast<uint32_t>((length + 7) & ~static_cast<size_t>(7));
+}
+
+static void encodePayload(const JournalRecord& record, uint8_t* out) {
+    PackedRecord packed;
+    std::memset(&packed, 0, sizeof(packed));
+    packed.detectedAtMs = record.detectedAtMs;
+    packed.eventId = record.eventId;
+    packed.trackId = record.trackId;
+    packed.personFaceId = record.personFaceId;
+    packed.organizationId = record.organizationId;
+    packed.cameraId = record.cameraId;
+    packed.similarity = record.similarity;
+    packed.confidence = record.confidence;
+    packed.x = record.x;
+    packed.y = record.y;
+    packed.width = record.width;
+    packed.height = record.height;
+    packed.faceStatus = record.faceStatus;
+    packed.detectionStatus = record.detectionStatus;
+    packed.modelLength = static_cast<uint16_t>(record.embeddingModel.size());
+    packed.embeddingSize = static_cast<uint32_t>(record.embedding.size());
+    packed.cropLength = static_cast<uint32_t>(record.cropRef.size());
+    packed.metadataLength = static_cast<uint32_t>(record.metadata.size());
+
+    std::memcpy(out, &packed, sizeof(packed));
+    out += sizeof(packed);
+    if (!record.embedding.empty()) {
+        std::memcpy(out, record.embedding.data(), record.embedding.size() * sizeof(float));
+        out += record.embedding.size() * sizeof(float);
+    }
+    std::memcpy(out, record.embeddingModel.data(), record.embeddingModel.size());
+    out += record.embeddingModel.size();
+    std::memcpy(out, record.cropRef.data(), record.cropRef.size());
+    out += record.cropRef.size();
+    std::memcpy(out, record.metadata.data(), record.metadata.size());
+}
+
+static bool decodePayload(const uint8_t* in, size_t length, JournalRecord& record) {
+    if (length < sizeof(PackedRecord)) return false;
+    PackedRecord packed;
+    std::memcpy(&packed, in, sizeof(packed));
+    size_t expected = sizeof(PackedRecord) + static_cast<size_t>(packed.embeddingSize) * sizeof(float) +
+                      packed.modelLength + packed.cropLength + packed.metadataLength;
+    if (expected != length) return false;
+
+    record.detectedAtMs = packed.detectedAtMs;
+    record.eventId = packed.eventId;
+    record.trackId = packed.trackId;
+    record.personFaceId = packed.personFaceId;
+    record.organizationId = packed.organizationId;
+    record.cameraId = packed.cameraId;
+    record.similarity = packed.similarity;
+    record.confidence = packed.confidence;
+    record.x = packed.x;
+    record.y = packed.y;
+    record.width = packed.width;
+    record.height = packed.height;
+    record.faceStatus = packed.faceStatus;
+    record.detectionStatus = packed.detectionStatus;
+
+    in += sizeof(packed);
+    record.embedding.resize(packed.embeddingSize);
+    if (packed.embeddingSize > 0) {
+        std::memcpy(record.embedding.data(), in, packed.embeddingSize * sizeof(float));
+        in += packed.embeddingSize * sizeof(float);
+    }
+    record.embeddingModel.assign(reinterpret_cast<const char*>(in), packed.modelLength);
+    in += packed.modelLength;
+    record.cropRef.assign(reinterpret_cast<const char*>(in), packed.cropLength);
+    in += packed.cropLength;
+    record.metadata.assign(reinterpret_cast<const char*>(in), packed.metadataLength);
+    return true;
+}
+
+std::unique_ptr<DetectionJournal> DetectionJournal::open(const std::string& path, uint64_t capacity) {
+    capacity = std::max<uint64_t>(capacity, kHeaderSize * 16);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Cannot open detection journal " << path << std::endl;
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && static_cast<uint64_t>(size.QuadPart) > capacity) {
+        capacity = static_cast<uint64_t>(size.QuadPart);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(capacity >> 32), static_cast<DWORD>(capacity), nullptr);
+    void* address = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+    if (!address) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        std::cerr << "Cannot map detection journal " << path << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<DetectionJournal> journal(new DetectionJournal(path, static_cast<uint8_t*>(address), capacity, file, mapping));
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot open detection journal " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        (static_cast<uint64_t>(info.st_size) < capacity && ftruncate(fd, static_cast<off_t>(capacity)) != 0)) {
+        ::close(fd);
+        std::cerr << "Cannot size detection journal " << path << std::endl;
+        return nullptr;
+    }
+    capacity = std::max<uint64_t>(capacity, static_cast<uint64_t>(info.st_size));
+    void* address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+    if (address == MAP_FAILED) {
+        std::cerr << "Cannot map detection journal " << path << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<DetectionJournal> journal(new DetectionJournal(path, static_cast<uint8_t*>(address), capacity, nullptr, nullptr));
+#endif
+    journal->recover();
+    return journal;
+}
+
+DetectionJournal::DetectionJournal(std::string path, uint8_t* base, uint64_t capacity, void* fileHandle, void* mappingHandle)
+    : filePath(std::move(path)), base(base), capacity(capacity), fileHandle(fileHandle), mappingHandle(mappingHandle),
+      tail(kHeaderSize), lastSeq(0) {
+    counters.capacity = capacity;
+}
+
+DetectionJournal::~DetectionJournal() {
+    sync();
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+    munmap(base, capacity);
+#endif
+}
+
+DetectionJournal::Header* DetectionJournal::header() const {
+    return reinterpret_cast<Header*>(base);
+}
+
+bool DetectionJournal::flush(uint64_t offset, uint64_t length) {
+#ifdef _WIN32
+    return FlushViewOfFile(base + offset, static_cast<SIZE_T>(length)) && FlushFileBuffers(static_cast<HANDLE>(fileHandle));
+#else
+    // msync needs a page-aligned start
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = offset - offset % page;
+    return msync(base + start, length + (offset - start), MS_SYNC) == 0;
+#endif
+}
+
+void DetectionJournal::recover() {
+    Header* h = header();
+    if (std::memcmp(h->magic, kJournalMagic, sizeof(kJournalMagic)) != 0 || h->version != kJournalVersion) {
+        std::memset(base, 0, kHeaderSize + sizeof(RecordHeader));
+        std::memcpy(h->magic, kJournalMagic, sizeof(kJournalMagic));
+        h->version = kJournalVersion;
+        h->headerSize = static_cast<uint32_t>(kHeaderSize);
+        h->capacity = capacity;
+        h->committedSeq = 0;
+        h->firstSeq = 1;
+        flush(0, kHeaderSize + sizeof(RecordHeader));
+        std::cout << "Created detection journal " << filePath << " (" << capacity / (1024 * 1024) << " MB)" << std::endl;
+    }
+    if (h->epoch == 0) {
+        // New file, or one written before epochs: sequence numbers restart with every new file, so the
+        // consumer keys records by (epoch, seq)
+        std::random_device device;
+        do {
+            h->epoch = (static_cast<uint64_t>(device()) << 32) ^ device();
+        } while (h->epoch == 0);
+        flush(0, sizeof(Header));
+    }
+
+    // Walk the chain of valid records; the first break is the tail
+    uint64_t offset = kHeaderSize;
+    uint64_t expected = h->firstSeq;
+    while (offset + sizeof(RecordHeader) <= capacity) {
+        RecordHeader record;
+        std::memcpy(&record, base + offset, sizeof(record));
+        if (record.magic != kRecordMagic || record.seq != expected || record.length < sizeof(RecordHeader) ||
+            record.length % 8 != 0 || offset + record.length > capacity ||
+            record.payloadSize > record.length - sizeof(RecordHeader) ||
+            recordCrc(record.seq, base + offset + sizeof(RecordHeader), record.payloadSize) != record.crc) {
+            break;
+        }
+        offset += record.length;
+        expected++;
+    }
+    tail = offset;
+    lastSeq = std::max(expected - 1, h->committedSeq);
+    counters.recovered = lastSeq - std::min(lastSeq, h->committedSeq);
+    if (counters.recovered > 0) {
+        std::cout << "Detection journal recovered " << counters.recovered << " uncommitted records" << std::endl;
+    }
+}
+
+void DetectionJournal::compactIfDrained() {
+    Header* h = header();
+    if (h->committedSeq < lastSeq || tail == kHeaderSize) return;
+    // Everything was written downstream: start over at the top. The end marker goes first, so a
+    // crash in between leaves either an empty journal or records that no longer chain from firstSeq.
+    std::memset(base + kHeaderSize, 0, sizeof(RecordHeader));
+    h->firstSeq = lastSeq + 1;
+    flush(0, kHeaderSize + sizeof(RecordHeader));
+    tail = kHeaderSize;
+    counters.compactions++;
+}
+
+bool DetectionJournal::append(const std::vector<JournalRecord>& records, uint64_t& appendedSeq) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t total = 0;
+    for (const JournalRecord& record : records) total += recordLength(record);
+    // Room for the records plus the end marker that follows them
+    if (tail + total + sizeof(RecordHeader) > capacity) {
+        compactIfDrained();
+        if (tail + total + sizeof(RecordHeader) > capacity) {
+            counters.rejected += records.size();
+            return false;
+        }
+    }
+
+    uint64_t offset = tail;
+    for (const JournalRecord& record : records) {
+        RecordHeader entry;
+        entry.magic = kRecordMagic;
+        entry.length = recordLength(record);
+        entry.seq = lastSeq + 1;
+        entry.payloadSize = static_cast<uint32_t>(payloadSize(record));
+
+        // Payload and end marker first, header (which makes the record valid) last
+        uint8_t* payload = base + offset + sizeof(RecordHeader);
+        encodePayload(record, payload);
+        std::memset(payload + entry.payloadSize, 0, entry.length - sizeof(RecordHeader) - entry.payloadSize);
+        std::memset(base + offset + entry.length, 0, sizeof(RecordHeader));
+        entry.crc = recordCrc(entry.seq, payload, entry.payloadSize);
+        std::memcpy(base + offset, &entry, sizeof(entry));
+
+        offset += entry.length;
+        lastSeq = entry.seq;
+    }
+    tail = offset;
+    counters.appended += records.size();
+    appendedSeq = lastSeq;
+    return true;
+}
+
+std::vector<JournalRecord> DetectionJournal::read(uint64_t afterSeq, size_t maxRecords) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<JournalRecord> records;
+    afterSeq = std::max(afterSeq, header()->committedSeq);
+
+    uint64_t offset = kHeaderSize;
+    while (offset < tail && records.size() < maxRecords) {
+        RecordHeader entry;
+        std::memcpy(&entry, base + offset, sizeof(entry));
+        if (entry.seq > afterSeq) {
+            JournalRecord record;
+            if (!decodePayload(base + offset + sizeof(RecordHeader), entry.payloadSize, record)) break;
+            record.seq = entry.seq;
+            records.push_back(std::move(record));
+        }
+        offset += entry.length;
+    }
+    return records;
+}
+
+bool DetectionJournal::commit(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Header* h = header();
+    seq = std::min(seq, lastSeq);
+    if (seq <= h->committedSeq) return true;
+    h->committedSeq = seq;
+    bool flushed = flush(0, sizeof(Header));
+    // Reclaim the space once the consumer has caught up and half the file is used
+    if (tail > capacity / 2) {
+        compactIfDrained();
+    }
+    return flushed;
+}
+
+bool DetectionJournal::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return flush(0, tail);
+}
+
+DetectionJournal::Stats DetectionJournal::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats snapshot = counters;
+    snapshot.usedBytes = tail;
+    snapshot.lastSeq = lastSeq;
+    snapshot.committedSeq = header()->committedSeq;
+    snapshot.epoch = header()->epoch;
+    return snapshot;
+}
@@ -0,0 +1,109 @@
+#ifndef DETECTION_JOURNAL_H
+#define DETECTION_JOURNAL_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * One detection as written to the journal. Everything the database row needs,
+ * so the journal can be replayed without the frame.
+ */
+struct JournalRecord {
+    uint64_t seq = 0;            // Assigned by append(), consecutive from 1
+    int64_t detectedAtMs = 0;
+    int32_t organizationId = 0;
+    int32_t cameraId = -1;
+    int64_t eventId = -1;
+    int64_t trackId = -1;
+    int64_t personFaceId = -1;   // -1 for unknown faces
+    float similarity = 0.0f;
+    float confidence = 0.0f;
+    int32_t x = 0, y = 0, width = 0, height = 0;
+    uint8_t faceStatus = 0;      // 0 unrecognized, 1 detected, 2 recognized
+    uint8_t detectionStatus = 0; // 0 pending, 1 confirmed
+    std::vector<float> embedding;
+    std::string embeddingModel;  // Version tag of `embedding`
+    std::string cropRef;         // Face crop URL
+    std::string metadata;        // JSON
+};
+
+/**
+ * @brief Append-only, memory-mapped detection journal.
+ *
+ * Records are appended with a CRC and a consecutive sequence number into a
+ * fixed-size file mapping, so a process crash loses nothing that append()
+ * returned for, and a torn write is detected and dropped on the next open.
+ * The consumer reads batches past the committed watermark, writes them
+ * downstream, then commits; records up to the watermark are never returned
+ * again. Once everything is committed the space is reused from the start.
+ * Sequence numbers restart at 1 in a new file, so each file also gets a random
+ * epoch, and a store shared by several journals keys records by (epoch, seq).
+ */
+class DetectionJournal {
+public:
+    struct Stats {
+        uint64_t capacity = 0;
+        uint64_t usedBytes = 0;
+        uint64_t lastSeq = 0;
+        uint64_t committedSeq = 0;
+        uint64_t appended = 0;      // Since open
+        uint64_t rejected = 0;      // Appends refused because the journal was full
+        uint64_t recovered = 0;     // Uncommitted records found on open
+        uint64_t compactions = 0;
+        uint64_t epoch = 0;         // Random per file; records are identified by (epoch, seq)
+    };
+
+    /**
+     * @brief Opens or creates a journal file of `capacity` bytes and recovers its tail.
+     * @return nullptr if the file cannot be created or mapped.
+     */
+    static std::unique_ptr<DetectionJournal> open(const std::string& path, uint64_t capacity);
+    ~DetectionJournal();
+
+    DetectionJournal(const DetectionJournal&) = delete;
+    DetectionJournal& operator=(const DetectionJournal&) = delete;
+
+    /**
+     * @brief Appends all records or none of them.
+     * @param lastSeq Set to the sequence number of the last record appended.
+     * @return false when the records do not fit in the remaining space.
+     */
+    bool append(const std::vector<JournalRecord>& records, uint64_t& lastSeq);
+
+    // Up to `maxRecords` records with seq > max(afterSeq, committed watermark), in order
+    std::vector<JournalRecord> read(uint64_t afterSeq, size_t maxRecords) const;
+
+    // Advances the watermark (never backwards) and flushes it to disk
+    bool commit(uint64_t seq);
+
+    // Flushes appended records to disk (the mapping already survives a process crash)
+    bool sync();
+
+    Stats stats() const;
+    const std::string& path() const { return filePath; }
+
+private:
+    DetectionJournal(std::string path, uint8_t* base, uint64_t capacity, void* fileHandle, void* mappingHandle);
+
+    struct Header;
+    Header* header() const;
+    void recover();
+    void compactIfDrained();
+    bool flush(uint64_t offset, uint64_t length);
+
+    std::string filePath;
+    uint8_t* base;
+    uint64_t capacity;
+    void* fileHandle;     // Windows file HANDLE (POSIX closes the fd once mapped)
+    void* mappingHandle;  // Windows file mapping HANDLE
+
+    mutable std::mutex mutex;
+    uint64_t tail;        // Offset of the next record
+    uint64_t lastSeq;
+    Stats counters;
+};
+
+#endif // DETECTION_JOURNAL_H
@@ -0,0 +1,818 @@
+#include "embedding_gallery.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+namespace {
+
+constexpr int kRotationRounds = 3;
+constexpr uint32_t kRotationSeed = 0x5eed1e55u; // Fixed, so codes are the same in every process
+constexpr size_t kBlockBytes = 256 * 1024;      // Gallery rows or codes per block, sized for L2
+constexpr size_t kQueryBlock = 64;              // Queries scored against a block per GEMM call
+constexpr size_t kDistanceBudgetBytes = 8 * 1024 * 1024; // Code distances held at once by a prefiltered batch
+constexpr size_t kFirstStage = 32;              // Candidates rescored by an adaptive search before its first check
+constexpr size_t kDefaultLogCapacity = 4096;    // Changes kept for replicas
+
+// Replication blobs: native byte order, so primary and replica share an architecture
+constexpr uint32_t kDeltaMagic = 0x44474446;    // "FDGD"
+constexpr uint32_t kSnapshotMagic = 0x53474446; // "FDGS"
+constexpr uint32_t kBlobVersion = 1;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point since, Clock::time_point now = Clock::now()) {
+    return std::chrono::duration<double, std::milli>(now - since).count();
+}
+
+// In-place unnormalized Walsh-Hadamard transform; n is a power of two
+void hadamard(float* v, size_t n) {
+    for (size_t half = 1; half < n; half <<= 1) {
+        for (size_t i = 0; i < n; i += half << 1) {
+            for (size_t j = i; j < i + half; j++) {
+                float a = v[j];
+                float b = v[j + half];
+                v[j] = a + b;
+                v[j + half] = a - b;
+            }
+        }
+    }
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void putBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// Bounds-checked reads from a replication blob
+struct BlobReader {
+    const uint8_t* data;
+    size_t size;
+    size_t at = 0;
+
+    template <typename T>
+    bool get(T& value) {
+        return getBytes(&value, sizeof(T));
+    }
+
+    bool getBytes(void* out, size_t count) {
+        if (size - at < count) {
+            return false;
+        }
+        std::memcpy(out, data + at, count);
+        at += count;
+        return true;
+    }
+};
+
+// Per-thread scratch for searches, reused across calls
+thread_local std::vector<uint32_t> distanceScratch;
+thread_local std::vector<float> scoreScratch;
+thread_local std::vector<uint32_t> candidateScratch;
+
+} // namespace
+
+EmbeddingGallery::EmbeddingGallery(int dimension)
+    : dim(std::max(1, dimension)), paddedDim(1), logCapacity(kDefaultLogCapacity) {
+    while (paddedDim < static_cast<size_t>(dim)) {
+        paddedDim <<= 1;
+    }
+    words = (paddedDim + 63) / 64;
+
+    std::mt19937 rng(kRotationSeed);
+    signs.resize(kRotationRounds * paddedDim);
+    for (float& sign : signs) {
+        sign = (rng() & 1) ? 1.0f : -1.0f;
+    }
+
+    std::random_device device;
+    epoch = (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+bool EmbeddingGallery::normalize(const float* in, float* out) const {
+    double norm = 0.0;
+    for (int i = 0; i < dim; i++) {
+        norm += static_cast<double>(in[i]) * in[i];
+    }
+    if (!(norm > 0.0) || !std::isfinite(norm)) {
+        return false;
+    }
+    float inv = static_cast<float>(1.0 / std::sqrt(norm));
+    for (int i = 0; i < dim; i++) {
+        out[i] = in[i] * inv;
+    }
+    return true;
+}
+
+void EmbeddingGallery::encode(const float* embedding, uint64_t* code) const {
+    std::vector<float> rotated(paddedDim, 0.0f);
+    std::copy(embedding, embedding + dim, rotated.begin());
+    for (int round = 0; round < kRotationRounds; round++) {
+        const float* roundSigns = signs.data() + round * paddedDim;
+        for (size_t i = 0; i < paddedDim; i++) {
+            rotated[i] *= roundSigns[i];
+        }
+        hadamard(rotated.data(), paddedDim);
+    }
+    std::fill(code, code + words, 0);
+    for (size_t i = 0; i < paddedDim; i++) {
+        if (rotated[i] > 0.0f) {
+            code[i / 64] |= 1ULL << (i % 64);
+        }
+    }
+}
+
+bool EmbeddingGallery::add(int64_t id, const float* embedding, const std::string& payload) {
+    std::vector<float> normalized(dim);
+    if (!embedding || !normalize(embedding, normalized.data())) {
+        return false;
+    }
+    std::vector<uint64_t> code(words);
+    encode(normalized.data(), code.data());
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    ChangeOp op = storeLocked(id, normalized.data(), code.data(), payload);
+    logLocked(++lastSequence, op, id, normalized.data(), payload);
+    return true;
+}
+
+bool EmbeddingGallery::remove(int64_t id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!eraseLocked(id)) {
+        return false;
+    }
+    logLocked(++lastSequence, ChangeOp::Remove, id, nullptr, std::string());
+    return true;
+}
+
+EmbeddingGallery::ChangeOp EmbeddingGallery::storeLocked(int64_t id, const float* normalized, const uint64_t* code,
+                                                         const std::string& payload) {
+    size_t slot;
+    ChangeOp op = ChangeOp::Update;
+    auto it = slots.find(id);
+    if (it != slots.end()) {
+        slot = it->second;
+    } else {
+        op = ChangeOp::Add;
+        slot = ids.size();
+        ids.push_back(id);
+        payloads.emplace_back();
+        vectors.resize(vectors.size() + dim);
+        codes.resize(codes.size() + words);
+        slots[id] = slot;
+    }
+    std::copy(normalized, normalized + dim, vectors.begin() + slot * dim);
+    std::copy(code, code + words, codes.begin() + slot * words);
+    payloads[slot] = payload;
+    return op;
+}
+
+bool EmbeddingGallery::eraseLocked(int64_t id) {
+    auto it = slots.find(id);
+    if (it == slots.end()) {
+        return false;
+    }
+    // Move the last entry into the hole so rows stay contiguous
+    size_t slot = it->second;
+    size_t last = ids.size() - 1;
+    if (slot != last) {
+        std::copy(vectors.begin() + last * dim, vectors.begin() + (last + 1) * dim, vectors.begin() + slot * dim);
+        std::copy(codes.begin() + last * words, codes.begin() + (last + 1) * words, codes.begin() + slot * words);
+        ids[slot] = ids[last];
+        payloads[slot].swap(payloads[last]);
+        slots[ids[slot]] = slot;
+    }
+    ids.pop_back();
+    payloads.pop_back();
+    vectors.resize(last * dim);
+    codes.resize(last * words);
+    slots.erase(it);
+    return true;
+}
+
+void EmbeddingGallery::logLocked(uint64_t sequence, ChangeOp op, int64_t id, const float* normalized,
+                                 const std::string& payload) {
+    if (logCapacity == 0) {
+        return;
+    }
+    // Recycle the oldest entry's buffers once the log is full
+    LogEntry entry;
+    if (log.size() >= logCapacity) {
+        entry = std::move(log.front());
+        log.pop_front();
+    }
+    entry.sequence = sequence;
+    entry.op = op;
+    entry.id = id;
+    if (normalized) {
+        entry.vector.assign(normalized, normalized + dim);
+    } else {
+        entry.vector.clear();
+    }
+    entry.payload = payload;
+    log.push_back(std::move(entry));
+}
+
+void EmbeddingGallery::search(const float* query, const SearchOptions& options, std::vector<Match>& matches,
+                              SearchReport* report) {
+    Clock::time_point start = Clock::now();
+    SearchReport effort;
+    matches.clear();
+    if (report) {
+        *report = effort;
+    }
+    std::vector<float> normalized(dim);
+    if (!query || options.k <= 0 || !normalize(query, normalized.data())) {
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t size = ids.size();
+    if (size == 0) {
+        return;
+    }
+    size_t k = std::min(static_cast<size_t>(options.k), size);
+    searches++;
+
+    if (options.rerank <= 0 || static_cast<size_t>(options.rerank) >= size) {
+        exactSearches++;
+        rescored += size;
+        topExact(normalized.data(), k, matches);
+        effort.depth = size;
+    } else {
+        std::vector<uint64_t> code(words);
+        encode(normalized.data(), code.data());
+        size_t rerank = std::max(static_cast<size_t>(options.rerank), k);
+        if (options.adaptive()) {
+            distanceScratch.resize(size);
+            simd::kernels().hammingRows(code.data(), codes.data(), size, words, distanceScratch.data());
+            rankAdaptive(normalized.data(), distanceScratch.data(), k, rerank, options, start, matches, effort);
+        } else {
+            rescored += rerank;
+            topPrefiltered(normalized.data(), code.data(), k, rerank, matches);
+            effort.depth = rerank;
+        }
+    }
+    effort.elapsedMs = elapsedMs(start);
+    if (report) {
+        *report = effort;
+    }
+}
+
+void EmbeddingGallery::topExact(const float* query, size_t k, std::vector<Match>& matches) const {
+    size_t size = ids.size();
+    scoreScratch.resize(size);
+    simd::kernels().dotRows(query, vectors.data(), size, dim, scoreScratch.data());
+
+    candidateScratch.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        candidateScratch[i] = static_cast<uint32_t>(i);
+    }
+    const std::vector<float>& scores = scoreScratch;
+    std::partial_sort(candidateScratch.begin(), candidateScratch.begin() + k, candidateScratch.end(),
+                      [&scores](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+
+    matches.resize(k);
+    for (size_t i = 0; i < k; i++) {
+        uint32_t slot = candidateScratch[i];
+        matches[i].id = ids[slot];
+        matches[i].similarity = scores[slot];
+        matches[i].hamming = 0;
+    }
+}
+
+void EmbeddingGallery::topPrefiltered(const float* query, const uint64_t* code, size_t k, size_t rerank,
+                                      std::vector<Match>& matches) const {
+    distanceScratch.resize(ids.size());
+    simd::kernels().hammingRows(code, codes.data(), ids.size(), words, distanceScratch.data());
+
+    std::vector<uint32_t> hamming;
+    selectClosest(distanceScratch.data(), rerank, candidateScratch, hamming);
+    rankCandidates(query, candidateScratch, hamming.data(), k, matches);
+}
+
+void EmbeddingGallery::selectClosest(const uint32_t* distances, size_t rerank, std::vector<uint32_t>& slots,
+                                     std::vector<uint32_t>& hamming) const {
+    size_t size = ids.size();
+    // Distances are bounded by the code length, so a histogram finds the rerank-th smallest in one pass
+    std::vector<uint32_t> histogram(paddedDim + 1, 0);
+    for (size_t i = 0; i < size; i++) {
+        histogram[distances[i]]++;
+    }
+    uint32_t cutoff = 0;
+    size_t below = 0;
+    while (below + histogram[cutoff] < rerank) {
+        below += histogram[cutoff++];
+    }
+    size_t atCutoff = rerank - below; // Ties at the cutoff distance are taken in gallery order
+
+    slots.clear();
+    hamming.clear();
+    for (size_t i = 0; i < size; i++) {
+        uint32_t distance = distances[i];
+        if (distance < cutoff || (distance == cutoff && atCutoff > 0)) {
+            if (distance == cutoff) {
+                atCutoff--;
+            }
+            slots.push_back(static_cast<uint32_t>(i));
+            hamming.push_back(distance);
+        }
+    }
+}
+
+void EmbeddingGallery::rankCandidates(const float* query, const std::vector<uint32_t>& slots, const uint32_t* hamming,
+                                      size_t k, std::vector<Match>& matches) const {
+    const simd::Kernels& kernels = simd::kernels();
+    std::vector<float> scores(slots.size());
+    for (size_t c = 0; c < slots.size(); c++) {
+        scores[c] = kernels.dot(query, vectors.data() + static_cast<size_t>(slots[c]) * dim, dim);
+    }
+
+    k = std::min(k, slots.size());
+    std::vector<uint32_t> order(slots.size());
+    for (size_t c = 0; c < order.size(); c++) {
+        order[c] = static_cast<uint32_t>(c);
+    }
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                      [&scores](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+
+    matches.resize(k);
+    for (size_t i = 0; i < k; i++) {
+        matches[i].id = ids[slots[order[i]]];
+        matches[i].similarity = scores[order[i]];
+        matches[i].hamming = hamming[order[i]];
+    }
+}
+
+void EmbeddingGallery::rankAdaptive(const float* query, const uint32_t* distances, size_t k, size_t rerank,
+                                    const SearchOptions& options, Clock::time_point start,
+                                    std::vector<Match>& matches, SearchReport& report) {
+    size_t size = ids.size();
+    bool budgeted = options.budgetMs > 0.0;
+    size_t ceiling = budgeted ? std::max(rerank, static_cast<size_t>(std::max(0, options.maxRerank))) : rerank;
+    ceiling = std::min(std::max(ceiling, k), size);
+
+    // Candidates closest code first (ties in gallery order), so each stage extends the one before. Only the
+    // rerank closest are selected up front; going deeper re-selects, and the sorted prefix stays the same.
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> hamming;
+    std::vector<uint32_t> order;
+    auto selectUpTo = [&](size_t count) {
+        selectClosest(distances, count, slots, hamming);
+        order.resize(slots.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&hamming](uint32_t a, uint32_t b) { return hamming[a] < hamming[b]; });
+    };
+    Clock::time_point selectStart = Clock::now();
+    selectUpTo(std::min(ceiling, rerank));
+    double selectMs = elapsedMs(selectStart);
+
+    // Min-heap of the k best (score, sorted position) so far
+    using Scored = std::pair<float, uint32_t>;
+    auto worse = [](const Scored& a, const Scored& b) { return a.first > b.first; };
+    std::vector<Scored> best;
+    best.reserve(k);
+    float top = -std::numeric_limits<float>::infinity();
+    bool earlyExitEnabled = options.matchThreshold <= 1.0f;
+    float accept = options.matchThreshold + options.margin;
+
+    const simd::Kernels& kernels = simd::kernels();
+    Clock::time_point rerankStart = Clock::now();
+    size_t scored = 0;
+    size_t depth = std::min(ceiling, std::max(k, kFirstStage));
+    for (;;) {
+        if (depth > order.size()) {
+            selectUpTo(ceiling);
+        }
+        for (; scored < depth; scored++) {
+            uint32_t candidate = order[scored];
+            float score = kernels.dot(query, vectors.data() + static_cast<size_t>(slots[candidate]) * dim, dim);
+            top = std::max(top, score);
+            if (best.size() < k) {
+                best.emplace_back(score, static_cast<uint32_t>(scored));
+                std::push_heap(best.begin(), best.end(), worse);
+            } else if (score > best.front().first) {
+                std::pop_heap(best.begin(), best.end(), worse);
+                best.back() = Scored(score, static_cast<uint32_t>(scored));
+                std::push_heap(best.begin(), best.end(), worse);
+            }
+        }
+        if (earlyExitEnabled && top >= accept) {
+            report.earlyExit = true;
+            break;
+        }
+        if (depth >= ceiling) {
+            break;
+        }
+        size_t next = std::min(ceiling, depth * 2);
+        if (budgeted) {
+            // Next stage's cost predicted from this query's own rate so far, plus a re-selection if it needs one
+            Clock::time_point now = Clock::now();
+            double perCandidate = elapsedMs(rerankStart, now) / static_cast<double>(scored);
+            double predicted = perCandidate * static_cast<double>(next - depth) + (next > order.size() ? selectMs : 0.0);
+            if (elapsedMs(start, now) + predicted > options.budgetMs) {
+                report.budgetExhausted = true;
+                break;
+            }
+        }
+        depth = next;
+    }
+
+    std::sort_heap(best.begin(), best.end(), worse);
+    matches.resize(best.size());
+    for (size_t i = 0; i < best.size(); i++) {
+        uint32_t candidate = order[best[i].second];
+        matches[i].id = ids[slots[candidate]];
+        matches[i].similarity = best[i].first;
+        matches[i].hamming = hamming[candidate];
+    }
+
+    report.depth = scored;
+    report.elapsedMs = elapsedMs(start);
+    rescored += scored;
+    adaptiveSearches++;
+    adaptiveMicros += static_cast<uint64_t>(report.elapsedMs * 1000.0);
+    if (report.earlyExit) {
+        earlyExits++;
+    }
+    if (report.budgetExhausted) {
+        budgetStops++;
+    }
+}
+
+void EmbeddingGallery::searchBatch(const float* queries, size_t count, const SearchOptions& options,
+                                   std::vector<std::vector<Match>>& results) {
+    results.assign(count, std::vector<Match>());
+    if (!queries || count == 0 || options.k <= 0) {
+        return;
+    }
+
+    // Valid queries packed contiguously; a zero or non-finite query gets no matches
+    std::vector<float> packed(count * dim);
+    std::vector<size_t> origin;
+    for (size_t q = 0; q < count; q++) {
+        if (normalize(queries + q * dim, packed.data() + origin.size() * dim)) {
+            origin.push_back(q);
+        }
+    }
+    size_t valid = origin.size();
+    if (valid == 0) {
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t size = ids.size();
+    if (size == 0) {
+        return;
+    }
+    size_t k = std::min(static_cast<size_t>(options.k), size);
+    searches += valid;
+    batches++;
+    batchedQueries += valid;
+
+    std::vector<std::vector<Match>> found;
+    if (options.rerank <= 0 || static_cast<size_t>(options.rerank) >= size) {
+        exactSearches += valid;
+        rescored += valid * size;
+        batchExact(packed.data(), valid, k, found);
+    } else {
+        size_t rerank = std::max(static_cast<size_t>(options.rerank), k);
+        if (!options.adaptive()) {
+            rescored += valid * rerank;
+        }
+        batchPrefiltered(packed.data(), valid, k, rerank, options, found);
+    }
+    for (size_t i = 0; i < valid; i++) {
+        results[origin[i]] = std::move(found[i]);
+    }
+}
+
+void EmbeddingGallery::batchExact(const float* queries, size_t count, size_t k,
+                                  std::vector<std::vector<Match>>& results) const {
+    size_t size = ids.size();
+    size_t rowBlock = std::max<size_t>(16, kBlockBytes / (dim * sizeof(float)));
+    const simd::Kernels& kernels = simd::kernels();
+
+    // Per query, a min-heap of the k best (score, slot) seen so far
+    using Scored = std::pair<float, uint32_t>;
+    auto worse = [](const Scored& a, const Scored& b) { return a.first > b.first; };
+    std::vector<std::vector<Scored>> best(count);
+    for (auto& heap : best) {
+        heap.reserve(k);
+    }
+
+    std::vector<float> tile(kQueryBlock * rowBlock);
+    for (size_t rowStart = 0; rowStart < size; rowStart += rowBlock) {
+        size_t rows = std::min(rowBlock, size - rowStart);
+        const float* block = vectors.data() + rowStart * dim;
+        // Every query is scored against this block while it is in cache
+        for (size_t queryStart = 0; queryStart < count; queryStart += kQueryBlock) {
+            size_t queryCount = std::min(kQueryBlock, count - queryStart);
+            kernels.dotRowsBatch(queries + queryStart * dim, queryCount, block, rows, dim, tile.data(), rowBlock);
+            for (size_t q = 0; q < queryCount; q++) {
+                std::vector<Scored>& heap = best[queryStart + q];
+                const float* scores = tile.data() + q * rowBlock;
+                for (size_t r = 0; r < rows; r++) {
+                    if (heap.size() < k) {
+                        heap.emplace_back(scores[r], static_cast<uint32_t>(rowStart + r));
+                        std::push_heap(heap.begin(), heap.end(), worse);
+                    } else if (scores[r] > heap.front().first) {
+                        std::pop_heap(heap.begin(), heap.end(), worse);
+                        heap.back() = Scored(scores[r], static_cast<uint32_t>(rowStart + r));
+                        std::push_heap(heap.begin(), heap.end(), worse);
+                    }
+                }
+            }
+        }
+    }
+
+    results.resize(count);
+    for (size_t q = 0; q < count; q++) {
+        std::sort_heap(best[q].begin(), best[q].end(), worse);
+        results[q].resize(best[q].size());
+        for (size_t i = 0; i < best[q].size(); i++) {
+            results[q][i].id = ids[best[q][i].second];
+            results[q][i].similarity = best[q][i].first;
+            results[q][i].hamming = 0;
+        }
+    }
+}
+
+void EmbeddingGallery::batchPrefiltered(const float* queries, size_t count, size_t k, size_t rerank,
+                                        const SearchOptions& options, std::vector<std::vector<Match>>& results) {
+    size_t size = ids.size();
+    size_t codeBlock = std::max<size_t>(64, kBlockBytes / (words * sizeof(uint64_t)));
+    // Queries whose full distance rows fit the budget share each pass over the codes
+    size_t queryChunk = std::max<size_t>(1, std::min(count, kDistanceBudgetBytes / (size * sizeof(uint32_t))));
+    const simd::Kernels& kernels = simd::kernels();
+
+    std::vector<uint64_t> queryCodes(count * words);
+    for (size_t q = 0; q < count; q++) {
+        encode(queries + q * dim, queryCodes.data() + q * words);
+    }
+
+    results.resize(count);
+    std::vector<uint32_t> distances(queryChunk * size);
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> hamming;
+    for (size_t chunkStart = 0; chunkStart < count; chunkStart += queryChunk) {
+        size_t chunk = std::min(queryChunk, count - chunkStart);
+        for (size_t blockStart = 0; blockStart < size; blockStart += codeBlock) {
+            size_t rows = std::min(codeBlock, size - blockStart);
+            const uint64_t* block = codes.data() + blockStart * words;
+            for (size_t q = 0; q < chunk; q++) {
+                kernels.hammingRows(queryCodes.data() + (chunkStart + q) * words, block, rows, words,
+                                    distances.data() + q * size + blockStart);
+            }
+        }
+        for (size_t q = 0; q < chunk; q++) {
+            const float* query = queries + (chunkStart + q) * dim;
+            if (options.adaptive()) {
+                SearchReport report;
+                rankAdaptive(query, distances.data() + q * size, k, rerank, options, Clock::now(), results[chunkStart + q], report);
+                continue;
+            }
+            selectClosest(distances.data() + q * size, rerank, slots, hamming);
+            rankCandidates(query, slots, hamming.data(), k, results[chunkStart + q]);
+        }
+    }
+}
+
+bool EmbeddingGallery::exportDelta(uint64_t afterSequence, size_t maxEntries, std::vector<uint8_t>& out,
+                                   uint64_t* lastIncluded) const {
+    out.clear();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    uint64_t oldest = log.empty() ? lastSequence + 1 : log.front().sequence;
+    if (afterSequence > lastSequence || afterSequence + 1 < oldest) {
+        return false;
+    }
+    size_t first = static_cast<size_t>(afterSequence + 1 - oldest);
+    size_t count = std::min(maxEntries, log.size() - std::min(first, log.size()));
+
+    if (lastIncluded) {
+        *lastIncluded = afterSequence + count;
+    }
+    put(out, kDeltaMagic);
+    put(out, kBlobVersion);
+    put(out, epoch);
+    put(out, static_cast<uint32_t>(dim));
+    put(out, static_cast<uint32_t>(count));
+    for (size_t i = first; i < first + count; i++) {
+        const LogEntry& entry = log[i];
+        put(out, entry.sequence);
+        put(out, static_cast<uint8_t>(entry.op));
+        put(out, entry.id);
+        put(out, static_cast<uint32_t>(entry.payload.size()));
+        putBytes(out, entry.payload.data(), entry.payload.size());
+        putBytes(out, entry.vector.data(), entry.vector.size() * sizeof(float));
+    }
+    return true;
+}
+
+void EmbeddingGallery::exportSnapshot(std::vector<uint8_t>& out, uint64_t* sequenceAt) const {
+    out.clear();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (sequenceAt) {
+        *sequenceAt = lastSequence;
+    }
+    size_t size = ids.size();
+    out.reserve(48 + size * (sizeof(int64_t) + sizeof(uint32_t) + dim * sizeof(float) + words * sizeof(uint64_t)));
+    put(out, kSnapshotMagic);
+    put(out, kBlobVersion);
+    put(out, epoch);
+    put(out, lastSequence);
+    put(out, static_cast<uint32_t>(dim));
+    put(out, static_cast<uint32_t>(words));
+    put(out, static_cast<uint64_t>(size));
+    for (size_t slot = 0; slot < size; slot++) {
+        put(out, ids[slot]);
+        put(out, static_cast<uint32_t>(payloads[slot].size()));
+        putBytes(out, payloads[slot].data(), payloads[slot].size());
+        putBytes(out, vectors.data() + slot * dim, dim * sizeof(float));
+        putBytes(out, codes.data() + slot * words, words * sizeof(uint64_t));
+    }
+}
+
+EmbeddingGallery::ApplyResult EmbeddingGallery::applyDelta(const uint8_t* data, size_t size,
+                                                           const ChangeCallback& onChange, size_t& applied) {
+    applied = 0;
+    if (!data) {
+        return ApplyResult::Malformed;
+    }
+    BlobReader reader{data, size};
+    uint32_t magic = 0, version = 0, blobDim = 0, count = 0;
+    uint64_t blobEpoch = 0;
+    if (!reader.get(magic) || !reader.get(version) || !reader.get(blobEpoch) || !reader.get(blobDim) ||
+        !reader.get(count) || magic != kDeltaMagic || version != kBlobVersion || blobDim != static_cast<uint32_t>(dim)) {
+        return ApplyResult::Malformed;
+    }
+
+    // Decoded and encoded before taking the lock, so searches only wait for the copies
+    std::vector<LogEntry> entries(count);
+    std::vector<uint64_t> entryCodes(static_cast<size_t>(count) * words);
+    for (uint32_t i = 0; i < count; i++) {
+        LogEntry& entry = entries[i];
+        uint8_t op = 0;
+        uint32_t payloadSize = 0;
+        if (!reader.get(entry.sequence) || !reader.get(op) || !reader.get(entry.id) || !reader.get(payloadSize) ||
+            op < static_cast<uint8_t>(ChangeOp::Add) || op > static_cast<uint8_t>(ChangeOp::Remove) ||
+            payloadSize > size - reader.at) {
+            return ApplyResult::Malformed;
+        }
+        entry.op = static_cast<ChangeOp>(op);
+        entry.payload.assign(reinterpret_cast<const char*>(data + reader.at), payloadSize);
+        reader.at += payloadSize;
+        if (entry.op != ChangeOp::Remove) {
+            entry.vector.resize(dim);
+            if (!reader.getBytes(entry.vector.data(), dim * sizeof(float))) {
+                return ApplyResult::Malformed;
+            }
+            encode(entry.vector.data(), entryCodes.data() + i * words);
+        }
+    }
+
+    ApplyResult result = ApplyResult::Applied;
+    std::vector<const LogEntry*> changes;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (blobEpoch != epoch) {
+            return ApplyResult::Stale;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const LogEntry& entry = entries[i];
+            if (entry.sequence <= lastSequence) {
+                continue; // Already applied by an earlier, overlapping delta
+            }
+            if (entry.sequence != lastSequence + 1) {
+                result = ApplyResult::Stale;
+                break;
+            }
+            if (entry.op == ChangeOp::Remove) {
+                eraseLocked(entry.id);
+            } else {
+                storeLocked(entry.id, entry.vector.data(), entryCodes.data() + i * words, entry.payload);
+            }
+            logLocked(entry.sequence, entry.op, entry.id, entry.op == ChangeOp::Remove ? nullptr : entry.vector.data(),
+                      entry.payload);
+            lastSequence = entry.sequence;
+            changes.push_back(&entry);
+        }
+    }
+    applied = changes.size();
+    deltasApplied += applied;
+    if (onChange) {
+        for (const LogEntry* entry : changes) {
+            onChange(entry->op, entry->id, entry->payload);
+        }
+    }
+    return result;
+}
+
+EmbeddingGallery::ApplyResult EmbeddingGallery::loadSnapshot(const uint8_t* data, size_t size,
+                                                             const ChangeCallback& onChange) {
+    if (!data) {
+        return ApplyResult::Malformed;
+    }
+    BlobReader reader{data, size};
+    uint32_t magic = 0, version = 0, blobDim = 0, blobWords = 0;
+    uint64_t blobEpoch = 0, blobSequence = 0, count = 0;
+    if (!reader.get(magic) || !reader.get(version) || !reader.get(blobEpoch) || !reader.get(blobSequence) ||
+        !reader.get(blobDim) || !reader.get(blobWords) || !reader.get(count) || magic != kSnapshotMagic ||
+        version != kBlobVersion || blobDim != static_cast<uint32_t>(dim) || blobWords != words ||
+        count > (size - reader.at) / (dim * sizeof(float))) {
+        return ApplyResult::Malformed;
+    }
+
+    std::vector<float> newVectors(count * dim);
+    std::vector<uint64_t> newCodes(count * words);
+    std::vector<int64_t> newIds(count);
+    std::vector<std::string> newPayloads(count);
+    std::unordered_map<int64_t, size_t> newSlots;
+    newSlots.reserve(count);
+    for (size_t slot = 0; slot < count; slot++) {
+        uint32_t payloadSize = 0;
+        if (!reader.get(newIds[slot]) || !reader.get(payloadSize) || payloadSize > size - reader.at) {
+            return ApplyResult::Malformed;
+        }
+        newPayloads[slot].assign(reinterpret_cast<const char*>(data + reader.at), payloadSize);
+        reader.at += payloadSize;
+        if (!reader.getBytes(newVectors.data() + slot * dim, dim * sizeof(float)) ||
+            !reader.getBytes(newCodes.data() + slot * words, words * sizeof(uint64_t)) ||
+            !newSlots.emplace(newIds[slot], slot).second) {
+            return ApplyResult::Malformed;
+        }
+    }
+
+    // Reported once the rows are in place; the swapped-out rows are freed outside the lock
+    std::vector<int64_t> loadedIds;
+    std::vector<std::string> loadedPayloads;
+    if (onChange) {
+        loadedIds = newIds;
+        loadedPayloads = newPayloads;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        vectors.swap(newVectors);
+        codes.swap(newCodes);
+        ids.swap(newIds);
+        payloads.swap(newPayloads);
+        slots.swap(newSlots);
+        epoch = blobEpoch;
+        lastSequence = blobSequence;
+        log.clear();
+    }
+    snapshotsLoaded++;
+    for (size_t slot = 0; slot < loadedIds.size(); slot++) {
+        onChange(ChangeOp::Add, loadedIds[slot], loadedPayloads[slot]);
+    }
+    return ApplyResult::Applied;
+}
+
+uint64_t EmbeddingGallery::sequence() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return lastSequence;
+}
+
+void EmbeddingGallery::setLogCapacity(size_t entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    logCapacity = entries;
+    while (log.size() > logCapacity) {
+        log.pop_front();
+    }
+}
+
+EmbeddingGallery::Stats EmbeddingGallery::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    Stats out;
+    out.size = ids.size();
+    out.dimension = dim;
+    out.codeBits = static_cast<int>(paddedDim);
+    out.vectorBytes = static_cast<uint64_t>(vectors.size()) * sizeof(float);
+    out.codeBytes = static_cast<uint64_t>(codes.size()) * sizeof(uint64_t);
+    out.searches = searches.load();
+    out.exactSearches = exactSearches.load();
+    out.rescored = rescored.load();
+    out.batches = batches.load();
+    out.batchedQueries = batchedQueries.load();
+    out.adaptiveSearches = adaptiveSearches.load();
+    out.earlyExits = earlyExits.load();
+    out.budgetStops = budgetStops.load();
+    out.adaptiveMicros = adaptiveMicros.load();
+    out.epoch = epoch;
+    out.sequence = lastSequence;
+    out.oldestLogged = log.empty() ? lastSequence + 1 : log.front().sequence;
+    out.logEntries = log.size();
+    out.deltasApplied = deltasApplied.load();
+    out.snapshotsLoaded = snapshotsLoaded.load();
+    return out;
+}
@@ -0,0 +1,199 @@
+#ifndef EMBEDDING_GALLERY_H
+#define EMBEDDING_GALLERY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Enrolled face embeddings with a binary code per vector for a two-pass search.
+ *
+ * Each embedding is stored L2-normalized, together with the sign bits of a fixed
+ * random rotation of it (3 rounds of random sign flips and a Walsh-Hadamard
+ * transform, padded to a power of two: 512 bits, 64 bytes for a 512-d
+ * embedding). Hamming distance between codes tracks the angle between vectors,
+ * so the first pass scans only the codes, 32x less memory than the floats,
+ * with the popcount kernel for this CPU. Only the `rerank` closest codes are
+ * scored exactly with float dot products. rerank 0 scans every float instead.
+ * searchBatch answers many queries (the faces of a frame, or of several
+ * cameras) in one pass over the gallery: blocks of rows are loaded once per
+ * batch and scored against every query with a blocked GEMM, or blocks of codes
+ * against every query's code when prefiltering. Searches run concurrently;
+ * adds and removes take the gallery exclusively.
+ *
+ * With a latency budget or a match threshold the rerank is adaptive: codes are
+ * rescored closest first in doubling stages, stopping as soon as the best match
+ * clears the threshold by the margin (easy queries), and going past `rerank`
+ * up to `maxRerank` only while the budget allows (hard queries).
+ *
+ * For warm standbys, every add, update and remove gets a sequence number and
+ * is kept in a bounded change log. exportDelta serializes the changes after a
+ * sequence, and a replica applies them in order with applyDelta; a replica
+ * that fell behind the log (or follows a restarted primary, which starts a new
+ * epoch) bootstraps from exportSnapshot instead. Each row carries an opaque
+ * payload (the caller's metadata for the face) so a replica needs nothing
+ * else to serve matches. Replicas are read-only: local writes would fork the
+ * sequence.
+ */
+class EmbeddingGallery {
+public:
+    struct Match {
+        int64_t id = 0;
+        float similarity = 0.0f; // Cosine similarity
+        uint32_t hamming = 0;    // Code distance; 0 for exact searches
+    };
+
+    struct SearchOptions {
+        int k = 5;
+        int rerank = 256;        // Codes kept for exact scoring; 0 = exact scan of every vector
+        double budgetMs = 0.0;   // Per-query latency budget; 0 = rerank is a fixed depth
+        float matchThreshold = 2.0f; // Cosine similarity of a match; above 1 disables early exit
+        float margin = 0.05f;    // Early exit once the best match reaches matchThreshold + margin
+        int maxRerank = 4096;    // Deepest rerank a budgeted search may grow to
+
+        bool adaptive() const { return budgetMs > 0.0 || matchThreshold <= 1.0f; }
+    };
+
+    // Effort spent on one query
+    struct SearchReport {
+        size_t depth = 0;        // Vectors scored with floats
+        double elapsedMs = 0.0;
+        bool earlyExit = false;  // Best match cleared matchThreshold + margin
+        bool budgetExhausted = false; // Stopped short of the depth ceiling to stay within budgetMs
+    };
+
+    enum class ChangeOp : uint8_t { Add = 1, Update = 2, Remove = 3 };
+
+    enum class ApplyResult {
+        Applied,
+        Stale,       // Another epoch, or a gap before the first new change: load a snapshot
+        Malformed
+    };
+
+    // Called once per change taken from a primary, after the gallery is updated
+    using ChangeCallback = std::function<void(ChangeOp op, int64_t id, const std::string& payload)>;
+
+    struct Stats {
+        size_t size = 0;
+        int dimension = 0;
+        int codeBits = 0;
+        uint64_t vectorBytes = 0;
+        uint64_t codeBytes = 0;
+        uint64_t searches = 0;
+        uint64_t exactSearches = 0;
+        uint64_t rescored = 0;   // Vectors scored with floats, across all searches
+        uint64_t batches = 0;
+        uint64_t batchedQueries = 0;
+        uint64_t adaptiveSearches = 0;
+        uint64_t earlyExits = 0;
+        uint64_t budgetStops = 0;
+        uint64_t adaptiveMicros = 0; // Time spent in adaptive searches
+        uint64_t epoch = 0;
+        uint64_t sequence = 0;   // Last change made or applied
+        uint64_t oldestLogged = 0; // First change exportDelta can still serve
+        size_t logEntries = 0;
+        uint64_t deltasApplied = 0; // Changes applied from a primary
+        uint64_t snapshotsLoaded = 0;
+    };
+
+    explicit EmbeddingGallery(int dimension);
+
+    int dimension() const { return dim; }
+
+    // Adds or replaces the embedding for `id`; false for a zero or non-finite vector
+    bool add(int64_t id, const float* embedding, const std::string& payload = std::string());
+    bool remove(int64_t id);
+
+    // Best matches first, at most options.k
+    void search(const float* query, const SearchOptions& options, std::vector<Match>& matches,
+                SearchReport* report = nullptr);
+
+    // `count` contiguous queries; results[i] holds query i's matches, empty for a zero query. An adaptive
+    // search budgets each query's rerank separately, timed from the end of the shared code pass.
+    void searchBatch(const float* queries, size_t count, const SearchOptions& options,
+                     std::vector<std::vector<Match>>& results);
+
+    // Binary code of an embedding, codeWords() 64-bit words
+    void encode(const float* embedding, uint64_t* code) const;
+    size_t codeWords() const { return words; }
+
+    // Changes after `afterSequence`, at most maxEntries; false if the log no longer reaches back that far.
+    // `lastIncluded` receives the last change included (afterSequence when there is none).
+    bool exportDelta(uint64_t afterSequence, size_t maxEntries, std::vector<uint8_t>& out,
+                     uint64_t* lastIncluded = nullptr) const;
+    // Every row with its payload and code, at the sequence stored in `sequenceAt`
+    void exportSnapshot(std::vector<uint8_t>& out, uint64_t* sequenceAt = nullptr) const;
+    // Changes already applied are skipped; `applied` counts the new ones
+    ApplyResult applyDelta(const uint8_t* data, size_t size, const ChangeCallback& onChange, size_t& applied);
+    // Replaces the whole gallery and adopts the primary's epoch and sequence; reports every row as an Add
+    ApplyResult loadSnapshot(const uint8_t* data, size_t size, const ChangeCallback& onChange);
+    uint64_t sequence() const;
+    // Changes kept for exportDelta (default 4096)
+    void setLogCapacity(size_t entries);
+
+    Stats stats() const;
+
+private:
+    struct LogEntry {
+        uint64_t sequence = 0;
+        ChangeOp op = ChangeOp::Add;
+        int64_t id = 0;
+        std::vector<float> vector; // Normalized; empty for a remove
+        std::string payload;
+    };
+
+    ChangeOp storeLocked(int64_t id, const float* normalized, const uint64_t* code, const std::string& payload);
+    bool eraseLocked(int64_t id);
+    void logLocked(uint64_t sequence, ChangeOp op, int64_t id, const float* normalized, const std::string& payload);
+    bool normalize(const float* in, float* out) const;
+    void topExact(const float* query, size_t k, std::vector<Match>& matches) const;
+    void topPrefiltered(const float* query, const uint64_t* code, size_t k, size_t rerank, std::vector<Match>& matches) const;
+    void selectClosest(const uint32_t* distances, size_t rerank, std::vector<uint32_t>& slots,
+                       std::vector<uint32_t>& hamming) const;
+    void rankCandidates(const float* query, const std::vector<uint32_t>& slots, const uint32_t* hamming, size_t k,
+                        std::vector<Match>& matches) const;
+    void rankAdaptive(const float* query, const uint32_t* distances, size_t k, size_t rerank,
+                      const SearchOptions& options, std::chrono::steady_clock::time_point start,
+                      std::vector<Match>& matches, SearchReport& report);
+    void batchExact(const float* queries, size_t count, size_t k, std::vector<std::vector<Match>>& results) const;
+    void batchPrefiltered(const float* queries, size_t count, size_t k, size_t rerank, const SearchOptions& options,
+                          std::vector<std::vector<Match>>& results);
+
+    int dim;
+    size_t paddedDim;            // Power of two >= dim; also the code length in bits
+    size_t words;
+    std::vector<float> signs;    // 3 rounds of paddedDim random +-1
+
+    mutable std::shared_mutex mutex;
+    std::vector<float> vectors;  // size x dim, normalized
+    std::vector<uint64_t> codes; // size x words
+    std::vector<int64_t> ids;
+    std::vector<std::string> payloads;
+    std::unordered_map<int64_t, size_t> slots;
+
+    uint64_t epoch;              // Random per primary, so a replica notices a restart
+    uint64_t lastSequence = 0;
+    std::deque<LogEntry> log;
+    size_t logCapacity;
+
+    std::atomic<uint64_t> searches{0};
+    std::atomic<uint64_t> exactSearches{0};
+    std::atomic<uint64_t> rescored{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> batchedQueries{0};
+    std::atomic<uint64_t> adaptiveSearches{0};
+    std::atomic<uint64_t> earlyExits{0};
+    std::atomic<uint64_t> budgetStops{0};
+    std::atomic<uint64_t> adaptiveMicros{0};
+    std::atomic<uint64_t> deltasApplied{0};
+    std::atomic<uint64_t> snapshotsLoaded{0};
+};
+
+#endif // EMBEDDING_GALLERY_H
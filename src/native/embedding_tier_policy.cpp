@@ -0,0 +1,143 @@
+#include "embedding_tier_policy.h"
+#include <algorithm>
+
+const char* embeddingTierName(EmbeddingTier tier) {
+    switch (tier) {
+        case EmbeddingTier::ArcFace: return "arcface";
+        case EmbeddingTier::FaceNet: return "facenet";
+        case EmbeddingTier::MobileFaceNet: return "mobilefacenet";
+    }
+    return "unknown";
+}
+
+int embeddingTierFromName(const std::string& name) {
+    for (int i = 0; i < kEmbeddingTierCount; i++) {
+        if (name == embeddingTierName(static_cast<EmbeddingTier>(i))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+EmbeddingTierPolicy::EmbeddingTierPolicy() : availableMask(0) {}
+
+void EmbeddingTierPolicy::setConfig(const Config& newConfig) {
+    std::lock_guard<std::mutex> lock(mutex);
+    config = newConfig;
+}
+
+EmbeddingTierPolicy::Config EmbeddingTierPolicy::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return config;
+}
+
+void EmbeddingTierPolicy::setAvailableTiers(unsigned mask) {
+    std::lock_guard<std::mutex> lock(mutex);
+    availableMask = mask;
+    // Drop camera assignments that point at a model that is no longer loaded
+    for (auto& entry : cameras) {
+        CameraStats& stats = entry.second.stats;
+        if (stats.tier >= 0 && !(availableMask & (1u << stats.tier))) {
+            stats.tier = -1;
+        }
+    }
+}
+
+unsigned EmbeddingTierPolicy::getAvailableTiers() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return availableMask;
+}
+
+void EmbeddingTierPolicy::pinTier(int cameraId, int tier) {
+    std::lock_guard<std::mutex> lock(mutex);
+    CameraState& state = cameras[cameraId];
+    state.stats.pinnedTier = (tier >= 0 && tier < kEmbeddingTierCount) ? tier : -1;
+}
+
+void EmbeddingTierPolicy::recordLatency(int cameraId, double latencyMs) {
+    // Untagged frames have no camera to attribute latency to
+    if (cameraId < 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    CameraStats& stats = cameras[cameraId].stats;
+    // Exponentially weighted so a single slow frame does not flip the tier
+    stats.avgLatencyMs = stats.avgLatencyMs <= 0.0 ? latencyMs : stats.avgLatencyMs * 0.8 + latencyMs * 0.2;
+}
+
+int EmbeddingTierPolicy::bestTier() const {
+    for (int i = 0; i < kEmbeddingTierCount; i++) {
+        if (availableMask & (1u << i)) return i;
+    }
+    return -1;
+}
+
+int EmbeddingTierPolicy::lighterTier(int tier) const {
+    for (int i = tier + 1; i < kEmbeddingTierCount; i++) {
+        if (availableMask & (1u << i)) return i;
+    }
+    return tier;
+}
+
+int EmbeddingTierPolicy::lightestTier() const {
+    for (int i = kEmbeddingTierCount - 1; i >= 0; i--) {
+        if (availableMask & (1u << i)) return i;
+    }
+    return -1;
+}
+
+int EmbeddingTierPolicy::selectTier(int cameraId, float quality, float systemLoad) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    int best = bestTier();
+    if (best < 0) return -1;
+
+    // Untagged frames are decided from load alone, without a per-camera entry or dwell time
+    CameraState untagged;
+    CameraState& state = cameraId >= 0 ? cameras[cameraId] : untagged;
+    CameraStats& stats = state.stats;
+
+    if (stats.pinnedTier >= 0 && (availableMask & (1u << stats.pinnedTier))) {
+        stats.selections[stats.pinnedTier]++;
+        return stats.pinnedTier;
+    }
+
+    float latencyLoad = config.latencyBudgetMs > 0.0 ? static_cast<float>(stats.avgLatencyMs / config.latencyBudgetMs) : 0.0f;
+    float load = std::max(systemLoad, latencyLoad);
+    stats.load = load;
+
+    int target = best;
+    if (load >= config.criticalLoad) {
+        target = lightestTier();
+    } else if (load >= config.highLoad) {
+        target = lighterTier(best);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (stats.tier < 0) {
+        stats.tier = target;
+        state.lastChange = now;
+    } else if (target != stats.tier) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.lastChange).count();
+        // Critical load degrades immediately; everything else waits out the dwell time
+        if (elapsedMs >= config.minDwellMs || load >= config.criticalLoad) {
+            stats.tier = target;
+            state.lastChange = now;
+        }
+    }
+
+    int tier = stats.tier;
+    if (quality < config.lowQuality && load < config.criticalLoad) {
+        tier = best;
+    }
+
+    stats.selections[tier]++;
+    return tier;
+}
+
+std::map<int, EmbeddingTierPolicy::CameraStats> EmbeddingTierPolicy::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<int, CameraStats> result;
+    for (const auto& entry : cameras) {
+        result[entry.first] = entry.second.stats;
+    }
+    return result;
+}
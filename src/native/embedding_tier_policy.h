@@ -0,0 +1,96 @@
+#ifndef EMBEDDING_TIER_POLICY_H
+#define EMBEDDING_TIER_POLICY_H
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Embedding model tiers, ordered from most to least expensive.
+enum class EmbeddingTier : int {
+    ArcFace = 0,
+    FaceNet = 1,
+    MobileFaceNet = 2
+};
+
+constexpr int kEmbeddingTierCount = 3;
+
+const char* embeddingTierName(EmbeddingTier tier);
+
+/**
+ * @brief Parses a tier name ("arcface", "facenet", "mobilefacenet").
+ * @return The tier index, or -1 if the name is unknown.
+ */
+int embeddingTierFromName(const std::string& name);
+
+/**
+ * @brief Chooses which embedding model runs for a face, per camera.
+ *
+ * Under normal load every face gets the best loaded model. As load rises the
+ * camera is degraded to the next lighter tier, and under critical load to the
+ * lightest one, instead of dropping frames. Low-quality faces (small or flat)
+ * are kept on the best tier while the system is merely busy, since a light
+ * model loses the most accuracy on them. A per-camera dwell time stops the
+ * tier from flapping between frames.
+ */
+class EmbeddingTierPolicy {
+public:
+    struct Config {
+        float highLoad = 0.8f;          // Load above which cameras drop one tier
+        float criticalLoad = 1.5f;      // Load above which cameras use the lightest tier
+        float lowQuality = 0.35f;       // Faces below this quality stay on the best tier when busy
+        int minDwellMs = 2000;          // Minimum time a camera stays on a tier
+        double latencyBudgetMs = 250.0; // Per-frame latency considered fully loaded
+    };
+
+    struct CameraStats {
+        int tier = -1;
+        int pinnedTier = -1;
+        double avgLatencyMs = 0.0;
+        float load = 0.0f;
+        std::array<unsigned long long, kEmbeddingTierCount> selections{};
+    };
+
+    EmbeddingTierPolicy();
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+
+    // Bit i set means tier i has a loaded model.
+    void setAvailableTiers(unsigned mask);
+    unsigned getAvailableTiers() const;
+
+    // Forces a camera onto a tier; pass -1 to return it to automatic selection.
+    void pinTier(int cameraId, int tier);
+
+    void recordLatency(int cameraId, double latencyMs);
+
+    /**
+     * @brief Selects the tier for one face.
+     * @param cameraId Camera the frame came from (-1 for untagged frames).
+     * @param quality Face quality in [0,1] (size and contrast).
+     * @param systemLoad In-flight detections divided by worker count.
+     * @return The tier index, or -1 if no recognition model is loaded.
+     */
+    int selectTier(int cameraId, float quality, float systemLoad);
+
+    std::map<int, CameraStats> snapshot() const;
+
+private:
+    struct CameraState {
+        CameraStats stats;
+        std::chrono::steady_clock::time_point lastChange;
+    };
+
+    int bestTier() const;
+    int lighterTier(int tier) const;
+    int lightestTier() const;
+
+    mutable std::mutex mutex;
+    Config config;
+    unsigned availableMask;
+    std::map<int, CameraState> cameras;
+};
+
+#endif // EMBEDDING_TIER_POLICY_H
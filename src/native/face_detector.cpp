@@ -1,213 +1,267 @@
 #include "face_detector.h"
+#include "shared_runtime.h"
 #include <chrono>
 #include <iostream>
-#include <fstream>
 #include <algorithm>
 #include <thread>
 #include <future>
 #include <atomic>
 #include <vector>
+#include <cstdio>
+#include <cstdlib>
 
-// Forward declarations for helper functions
-bool is_file_exist(const std::string& path);
-
-// Thread Pool Implementation
-class ThreadPool {
-public:
-    ThreadPool(size_t numThreads);
-    ~ThreadPool();
-
-    template<typename F, typename... Args>
-    auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
-
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    bool stop;
-};
-
-ThreadPool::ThreadPool(size_t numThreads) : stop(false) {
-    size_t threads = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
-    for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] {
-            for (;;) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(this->queueMutex);
-                    this->condition.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
-                    if (this->stop && this->tasks.empty())
-                        return;
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
-                task();
-            }
-        });
-    }
-}
-
-ThreadPool::~ThreadPool() {
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        stop = true;
-    }
-    condition.notify_all();
-    for (std::thread& worker : workers) {
-        if (worker.joinable()) {
-            worker.join();
-        }
-    }
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-template<typename F, typename... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type> {
-    using return_type = typename std::result_of<F(Args...)>::type;
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-    );
-    std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (stop) {
-            throw std::runtime_error("enqueue on stopped ThreadPool");
-        }
-        tasks.emplace([task]() { (*task)(); });
-    }
-    condition.notify_one();
-    return res;
-}
-
-// Initialize static members
-std::unique_ptr<ThreadPool> FaceDetector::threadPool = nullptr;
-std::atomic<int> FaceDetector::instanceCount(0);
-
-// Helper function to check file existence
-bool is_file_exist(const std::string& path) {
-    std::ifstream f(path.c_str());
-    return f.good();
+// Helper function to build a model version tag ("arcface-112x112@1a2b3c4d") from the file contents,
+// so embeddings from different model files are never mixed in one gallery
+static std::string model_version_tag(const std::string& name, const SharedNet& net, cv::Size inputSize) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "%08x", net.contentHash());
+    return name + "-" + std::to_string(inputSize.width) + "x" + std::to_string(inputSize.height) + "@" + suffix;
 }
 
 FaceDetector::FaceDetector()
-    : useDeepLearning(true), useUltraFace(false), confidenceThreshold(0.6f), nmsThreshold(0.3f), initialized(false), faceRecognitionInitialized(false), useArcFace(false) {
-
-    // Safely initialize the thread pool
-    instanceCount++;
-    if (!threadPool) {
-        static std::once_flag onceFlag;
-        std::call_once(onceFlag, []() {
-            threadPool = std::make_unique<ThreadPool>(0);
-            std::cout << "Initialized thread pool with " << std::thread::hardware_concurrency() << " threads" << std::endl;
-        });
-    }
+    : candidateStage(nullptr), dnnDetector(nullptr), embedders{}, useDeepLearning(true), useYuNet(false), initialized(false), useUltraFace(false),
+      faceRecognitionInitialized(false), prefilterLoaded(false), confidenceThreshold(0.6f), nmsThreshold(0.3f), threadPool(acquireExecutor()),
+      inFlightDetections(0), recognitionReady(false) {
 }
 
+// Releases this detector's references; the shared pool and models go away with the last detector
 FaceDetector::~FaceDetector() {
-    instanceCount--;
-    if (instanceCount == 0 && threadPool) {
-        threadPool.reset();
-        std::cout << "Thread pool destroyed" << std::endl;
+    // A deferred recognition load still writes into this instance
+    if (recognitionLoad.valid()) {
+        recognitionLoad.wait();
     }
 }
 
-bool FaceDetector::initialize(const std::string& modelPath, bool useDL) {
+bool FaceDetector::initialize(const std::string& modelPath, bool useDL, bool deferRecognition) {
+    // Let a previous deferred load finish before its members are reset
+    waitForRecognition();
+
+    auto startTime = std::chrono::steady_clock::now();
     useDeepLearning = useDL;
+    useUltraFace = false;
     initialized = false;
+    candidateStage = nullptr;
+    dnnDetector = nullptr;
+    dnnInputSize = cv::Size();
+    prefilterLoaded = false;
 
     // Reset detectors
-    faceNet = cv::dnn::Net(); // Reset by assignment
-    faceRecognitionNet = cv::dnn::Net(); // Reset face recognition net
+    faceNet.reset(); // Drop this detector's reference to the shared model
+    for (int i = 0; i < kEmbeddingTierCount; i++) {
+        faceRecognitionNets[i].reset(); // Reset face recognition nets
+        embeddingModels[i] = EmbeddingModelInfo();
+        embedders[i] = nullptr;
+    }
     faceRecognitionInitialized = false;
+    recognitionReady.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(loadTimingsMutex);
+        loadTimings.clear();
+    }
 
     std::cout << "Initializing face detector..." << std::endl;
 
-    // --- ArcFace Model for Recognition (try ArcFace first, fallback to FaceNet) ---
-    std::string arcFaceModel = modelPath + "/arcface/arcface.onnx";
-    std::string faceNetModel = modelPath + "/facenet/facenet.onnx";
+    // Recognition models load on their own thread while this one loads the detector
+    recognitionLoad = std::async(std::launch::async, [this, modelPath, deferRecognition]() {
+        loadRecognitionModels(modelPath, deferRecognition);
+    }).share();
 
-    std::cout << "Checking for ArcFace model at: " << arcFaceModel << std::endl;
-    if (is_file_exist(arcFaceModel)) {
-        try {
-            std::cout << "Attempting to load ArcFace model..." << std::endl;
-            faceRecognitionNet = cv::dnn::readNetFromONNX(arcFaceModel);
-            if (!faceRecognitionNet.empty()) {
-                faceRecognitionNet.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-                faceRecognitionNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-                std::cout << "ArcFace model loaded successfully for face recognition." << std::endl;
-                faceRecognitionInitialized = true;
-                useArcFace = true;
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "ArcFace model loading failed: " << e.what() << std::endl;
-        }
+    bool detectorLoaded = loadDetectionModel(modelPath);
+
+    if (deferRecognition) {
+        std::cout << "Face detector ready in " << elapsed_ms(startTime) << "ms (recognition models loading in background)" << std::endl;
     } else {
-        std::cout << "ArcFace model not found, checking for FaceNet model at: " << faceNetModel << std::endl;
-        if (is_file_exist(faceNetModel)) {
-            try {
-                std::cout << "Attempting to load FaceNet model..." << std::endl;
-                faceRecognitionNet = cv::dnn::readNetFromONNX(faceNetModel);
-                if (!faceRecognitionNet.empty()) {
-                    faceRecognitionNet.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-                    faceRecognitionNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-                    std::cout << "FaceNet model loaded successfully for face recognition." << std::endl;
-                    faceRecognitionInitialized = true;
-                    useArcFace = false;
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "FaceNet model loading failed: " << e.what() << std::endl;
-            }
-        } else {
-            std::cout << "No face recognition model found - face recognition will be disabled." << std::endl;
-        }
+        waitForRecognition();
+        std::cout << "Face detector ready in " << elapsed_ms(startTime) << "ms" << std::endl;
     }
+    return detectorLoaded;
+}
 
+bool FaceDetector::loadDetectionModel(const std::string& modelPath) {
     if (useDeepLearning) {
         // --- UltraFace Model ---
         std::string ultraFaceModel = modelPath + "/retinaface/version-RFB-320.onnx";
-        std::cout << "Checking for UltraFace model at: " << ultraFaceModel << std::endl;
-        if (is_file_exist(ultraFaceModel)) {
-            try {
-                std::cout << "Attempting to load UltraFace model..." << std::endl;
-                faceNet = cv::dnn::readNetFromONNX(ultraFaceModel);
-                if (!faceNet.empty()) {
-                    faceNet.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-                    faceNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-                    std::cout << "UltraFace model loaded successfully." << std::endl;
-                    useUltraFace = true;
-                    initialized = true;
-                    return true;
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "UltraFace model loading failed: " << e.what() << std::endl;
+        std::cout << "Loading UltraFace model from: " << ultraFaceModel << std::endl;
+        try {
+            ModelLoadTiming timing;
+            faceNet = acquireSharedNet(ultraFaceModel, &timing.reused);
+            if (faceNet) {
+                timing.name = face_pipeline::UltraFaceRFB320::name;
+                timing.role = "detector";
+                timing.loadMs = timing.reused ? 0.0 : faceNet->loadMs();
+                timing.sizeBytes = faceNet->sizeBytes();
+                recordLoadTiming(timing);
+                useUltraFace = true;
+                dnnDetector = &face_pipeline::runDetector<face_pipeline::UltraFaceRFB320>;
+                dnnInputSize = face_pipeline::inputSize<face_pipeline::UltraFaceRFB320>();
+                candidateStage = &FaceDetector::detectCandidatesDnn;
+                initialized = true;
+                // Optional stage one for the cascade; the network runs on every frame without it
+                prefilterLoaded = loadCascade(modelPath, "prefilter");
+                return true;
             }
-        } else {
-            std::cout << "UltraFace model file not found." << std::endl;
+            std::cout << "UltraFace model file not found or not loadable." << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "UltraFace model loading failed: " << e.what() << std::endl;
         }
     }
 
-    // --- Haar Cascade Fallback ---
-    std::cout << "Attempting to load Haar Cascade..." << std::endl;
-    std::vector<std::string> cascadePaths = {
-        "C:/opencv/build/etc/haarcascades/haarcascade_frontalface_alt.xml",
-        "C:/opencv/sources/data/haarcascades/haarcascade_frontalface_alt.xml",
-        "C:/opencv/build/etc/haarcascades/haarcascade_frontalface_default.xml",
-        "C:/opencv/sources/data/haarcascades/haarcascade_frontalface_default.xml"
-    };
-    for (const auto& cascadePath : cascadePaths) {
-        if (faceCascade.load(cascadePath)) {
-            std::cout << "Haar Cascade loaded from: " << cascadePath << std::endl;
-            useDeepLearning = false;
-            initialized = true;
+    // --- Low-power cascade detector ---
+    std::cout << "Attempting to load the cascade detector..." << std::endl;
+    if (loadCascade(modelPath, "detector")) {
+        useDeepLearning = false;
+        candidateStage = &FaceDetector::detectCandidatesCascade;
+        initialized = true;
+        return true;
+    }
+
+    std::cerr << "Failed to load any face detection model." << std::endl;
+    return false;
+}
+
+// Cascade files in order of preference: the bundled ones (scripts/download-face-models.js), then
+// OpenCV's own data directories. LBP is several times faster than Haar at similar recall.
+std::vector<std::string> FaceDetector::cascadeCandidates(const std::string& modelPath) const {
+    const std::vector<std::string> lbp = {"lbpcascade_frontalface_improved.xml", "lbpcascade_frontalface.xml"};
+    const std::vector<std::string> haar = {"haarcascade_frontalface_alt.xml", "haarcascade_frontalface_default.xml"};
+
+    std::vector<std::string> dataDirs;
+    if (const char* opencvData = std::getenv("OPENCV_DATA_DIR")) {
+        dataDirs.push_back(opencvData);
+    }
+    dataDirs.insert(dataDirs.end(), {
+        "/usr/share/opencv4", "/usr/local/share/opencv4", "/usr/share/opencv",
+        "C:/opencv/build/etc", "C:/opencv/sources/data"
+    });
+
+    std::vector<std::string> candidates;
+    for (const auto& file : lbp) candidates.push_back(modelPath + "/cascade/" + file);
+    for (const auto& file : haar) candidates.push_back(modelPath + "/cascade/" + file);
+    for (const auto& dir : dataDirs) {
+        for (const auto& file : lbp) candidates.push_back(dir + "/lbpcascades/" + file);
+        for (const auto& file : haar) candidates.push_back(dir + "/haarcascades/" + file);
+    }
+    return candidates;
+}
+
+// Loads the pre-filter into faceCascade, or the low-power detector's cascade
+bool FaceDetector::loadCascade(const std::string& modelPath, const std::string& role) {
+    for (const auto& cascadePath : cascadeCandidates(modelPath)) {
+        auto cascadeStart = std::chrono::steady_clock::now();
+        bool loaded = role == "detector" ? lowPowerDetector.load(cascadePath) : faceCascade.load(cascadePath);
+        if (loaded) {
+            std::cout << "Cascade " << role << " loaded from: " << cascadePath << std::endl;
+            ModelLoadTiming timing;
+            timing.name = cascadePath.find("lbpcascade") != std::string::npos ? "lbp-cascade" : "haar-cascade";
+            timing.role = role;
+            timing.loadMs = elapsed_ms(cascadeStart);
+            recordLoadTiming(timing);
             return true;
         }
     }
+    return false;
+}
 
-    std::cerr << "Failed to load any face detection model." << std::endl;
+void FaceDetector::loadRecognitionModels(const std::string& modelPath, bool deferred) {
+    // --- Recognition models (ArcFace first, fallback to FaceNet; MobileFaceNet as the light tier) ---
+    std::string arcFaceModel = modelPath + "/arcface/arcface.onnx";
+    std::string faceNetModel = modelPath + "/facenet/facenet.onnx";
+    std::string mobileFaceNetModel = modelPath + "/mobilefacenet/mobilefacenet.onnx";
+
+    // The light tier is independent of the ArcFace/FaceNet choice, so it parses concurrently too
+    std::future<bool> mobileFaceNet = std::async(std::launch::async, [this, mobileFaceNetModel, deferred]() {
+        return loadEmbeddingModel(EmbeddingTier::MobileFaceNet, mobileFaceNetModel, deferred);
+    });
+    if (!loadEmbeddingModel(EmbeddingTier::ArcFace, arcFaceModel, deferred)) {
+        std::cout << "ArcFace model not available, checking for FaceNet model at: " << faceNetModel << std::endl;
+        loadEmbeddingModel(EmbeddingTier::FaceNet, faceNetModel, deferred);
+    }
+    mobileFaceNet.wait();
+
+    unsigned tierMask = 0;
+    for (int i = 0; i < kEmbeddingTierCount; i++) {
+        if (embeddingModels[i].loaded) tierMask |= (1u << i);
+    }
+    embeddingPolicy.setAvailableTiers(tierMask);
+    faceRecognitionInitialized = tierMask != 0;
+    if (!faceRecognitionInitialized) {
+        std::cout << "No face recognition model found - face recognition will be disabled." << std::endl;
+    }
+    recognitionReady.store(true, std::memory_order_release);
+}
+
+bool FaceDetector::loadEmbeddingModel(EmbeddingTier tier, const std::string& modelFile, bool deferred) {
+    const char* name = embeddingTierName(tier);
+    cv::Size inputSize = face_pipeline::embedderInputSize(tier);
+    try {
+        std::cout << "Loading " << name << " model from: " << modelFile << std::endl;
+        ModelLoadTiming timing;
+        std::shared_ptr<SharedNet> net = acquireSharedNet(modelFile, &timing.reused);
+        if (!net) {
+            return false;
+        }
+
+        int index = static_cast<int>(tier);
+        faceRecognitionNets[index] = net;
+        embedders[index] = face_pipeline::embedderFor(tier);
+        embeddingModels[index].name = name;
+        embeddingModels[index].version = model_version_tag(name, *net, inputSize);
+        embeddingModels[index].inputSize = inputSize;
+        embeddingModels[index].loaded = true;
+
+        timing.name = name;
+        timing.role = "recognition";
+        timing.loadMs = timing.reused ? 0.0 : net->loadMs();
+        timing.sizeBytes = net->sizeBytes();
+        timing.deferred = deferred;
+        recordLoadTiming(timing);
+        std::cout << name << " model loaded successfully for face recognition (" << embeddingModels[index].version << ")." << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << name << " model loading failed: " << e.what() << std::endl;
+    }
     return false;
 }
 
-DetectionResult FaceDetector::detectFaces(const cv::Mat& frame) {
+void FaceDetector::recordLoadTiming(ModelLoadTiming timing) {
+    if (timing.reused) {
+        std::cout << timing.name << " model shared with another detector (" << timing.sizeBytes / (1024 * 1024) << " MB)" << std::endl;
+    } else {
+        std::cout << timing.name << " model mapped and parsed in " << timing.loadMs << "ms (" << timing.sizeBytes / (1024 * 1024) << " MB)" << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(loadTimingsMutex);
+    loadTimings.push_back(std::move(timing));
+}
+
+std::vector<ModelLoadTiming> FaceDetector::getModelLoadTimings() const {
+    std::lock_guard<std::mutex> lock(loadTimingsMutex);
+    return loadTimings;
+}
+
+bool FaceDetector::waitForRecognition() {
+    if (recognitionLoad.valid()) {
+        recognitionLoad.wait();
+    }
+    return isRecognitionReady() && faceRecognitionInitialized;
+}
+
+std::string FaceDetector::getDetectorName() const {
+    if (!initialized) return "none";
+    return useUltraFace ? face_pipeline::UltraFaceRFB320::name : lowPowerDetector.name();
+}
+
+std::vector<EmbeddingModelInfo> FaceDetector::getEmbeddingModels() const {
+    if (!isRecognitionReady()) {
+        return std::vector<EmbeddingModelInfo>(kEmbeddingTierCount); // Still loading in the background
+    }
+    return std::vector<EmbeddingModelInfo>(embeddingModels, embeddingModels + kEmbeddingTierCount);
+}
+
+DetectionResult FaceDetector::detectFaces(const cv::Mat& frame, const DetectionOptions& options) {
     DetectionResult result;
     auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -220,131 +274,350 @@ DetectionResult FaceDetector::detectFaces(const cv::Mat& frame) {
 
     std::cout << "Face detection starting, frame size: " << frame.cols << "x" << frame.rows << std::endl;
 
+    // Load is the number of concurrent detections per hardware thread, including this one
+    int inFlight = ++inFlightDetections;
+    float systemLoad = static_cast<float>(inFlight) / std::max(1u, std::thread::hardware_concurrency());
+
+    // Every stage below takes its resolution of the frame from here, so each resize and conversion runs once
+    std::shared_ptr<FramePyramid> pyramid = FramePyramid::create(frame);
+
     try {
-        if (useDeepLearning && useUltraFace) {
-            // UltraFace detection
-            std::cout << "Using UltraFace detection..." << std::endl;
-
-            // Prepare input blob - UltraFace expects 320x240 input
-            cv::Mat blob = cv::dnn::blobFromImage(frame, 1.0 / 128.0, cv::Size(320, 240), cv::Scalar(127, 127, 127), true, false);
-            faceNet.setInput(blob);
-
-            // Forward pass
-            std::vector<cv::Mat> outputs;
-            faceNet.forward(outputs, faceNet.getUnconnectedOutLayersNames());
-
-            // Process outputs - UltraFace has two outputs: boxes and scores
-            if (outputs.size() >= 2) {
-                cv::Mat boxes = outputs[0]; // Shape: [1, num_anchors, 4]
-                cv::Mat scores = outputs[1]; // Shape: [1, num_anchors, 2]
-
-                std::cout << "UltraFace outputs - boxes: " << boxes.size << ", scores: " << scores.size << std::endl;
-
-                // Extract detections
-                int numAnchors = boxes.size[1];
-                for (int i = 0; i < numAnchors; i++) {
-                    // Get face score (class 1, background is class 0)
-                    float score = scores.at<float>(0, i, 1);
-
-                    if (score > confidenceThreshold) {
-                        // Extract box coordinates (normalized)
-                        float x1 = boxes.at<float>(0, i, 0);
-                        float y1 = boxes.at<float>(0, i, 1);
-                        float x2 = boxes.at<float>(0, i, 2);
-                        float y2 = boxes.at<float>(0, i, 3);
-
-                        // Convert to pixel coordinates
-                        int px1 = static_cast<int>(x1 * frame.cols);
-                        int py1 = static_cast<int>(y1 * frame.rows);
-                        int px2 = static_cast<int>(x2 * frame.cols);
-                        int py2 = static_cast<int>(y2 * frame.rows);
-
-                        cv::Rect faceRect(px1, py1, px2 - px1, py2 - py1);
-
-                        if (validateFaceRegion(faceRect, frame)) {
-                            DetectedFace face;
-                            face.boundingBox = faceRect;
-                            face.confidence = score;
-
-                            // Extract face encoding using FaceNet
-                            face.encoding = extractFaceEncoding(frame, faceRect);
-
-                            result.faces.push_back(face);
-                            std::cout << "Added UltraFace detection: conf=" << score << ", rect=" << faceRect.x << "," << faceRect.y << "," << faceRect.width << "," << faceRect.height
-                                      << ", encoding_size=" << face.encoding.size() << std::endl;
-                        }
-                    }
-                }
+        // A cancelled job stops at the next stage boundary instead of running to completion
+        auto isCancelled = [&options]() { return options.cancelled && options.cancelled->load(std::memory_order_relaxed); };
+
+        // Stage 0: cheap pre-filter on a thumbnail; the detection network runs only when it fires,
+        // while a recently seen face is held, or on the camera's periodic refresh
+        DetectionCascade::Config cascadeConfig = detectionCascade.configFor(options.cameraId);
+        bool cascaded = prefilterLoaded && cascadeConfig.enabled && candidateStage == &FaceDetector::detectCandidatesDnn &&
+                        options.cameraId >= 0 && !options.allTiers;
+        DetectionCascade::Decision decision = DetectionCascade::Decision::Fired;
+        if (cascaded && !isCancelled()) {
+            auto prefilterStart = std::chrono::steady_clock::now();
+            bool fired;
+            {
+                StageProfiler::Scope scope(stageProfiler, ProfileStage::Prefilter);
+                fired = runPrefilter(*pyramid, cascadeConfig);
             }
-        } else {
-            // Haar cascade detection
-            std::cout << "Using Haar Cascade detection..." << std::endl;
-            std::vector<cv::Rect> faces;
-            cv::Mat grayFrame;
-            cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
-            cv::equalizeHist(grayFrame, grayFrame);
-            faceCascade.detectMultiScale(grayFrame, faces, 1.15, 4, 0 | cv::CASCADE_SCALE_IMAGE, cv::Size(30, 30), cv::Size(400, 400));
-            for (const auto& faceRect : faces) {
-                if (validateFaceRegion(faceRect, frame)) {
-                    DetectedFace face;
-                    face.boundingBox = faceRect;
-                    face.confidence = 0.75;
-
-                    // Extract face encoding using FaceNet
-                    face.encoding = extractFaceEncoding(frame, faceRect);
-
-                    result.faces.push_back(face);
-                    std::cout << "Added Haar Cascade detection: rect=" << faceRect.x << "," << faceRect.y << "," << faceRect.width << "," << faceRect.height
-                              << ", encoding_size=" << face.encoding.size() << std::endl;
-                }
+            decision = detectionCascade.admit(options.cameraId, fired, elapsed_ms(prefilterStart));
+        }
+
+        // Stage 1: candidate rectangles from the detector selected at initialize
+        std::vector<cv::Rect> rects;
+        std::vector<float> confidences;
+        if (decision != DetectionCascade::Decision::Skip && !isCancelled()) {
+            auto fullStart = std::chrono::steady_clock::now();
+            {
+                StageProfiler::Scope scope(stageProfiler, ProfileStage::Detect);
+                (this->*candidateStage)(*pyramid, options.cameraId, rects, confidences);
+            }
+            if (cascaded) {
+                detectionCascade.recordFull(options.cameraId, decision, rects.size(), elapsed_ms(fullStart));
+            }
+        }
+
+        // Stage 2: non-maximum suppression, so each face is validated and embedded once
+        std::vector<int> keep;
+        cv::dnn::NMSBoxes(rects, confidences, confidenceThreshold, nmsThreshold, keep);
+
+        // Stage 3: validation, so every surviving box is known before the first embedding runs
+        FrameLuma luma;
+        if (!keep.empty()) {
+            StageProfiler::Scope scope(stageProfiler, ProfileStage::Validate);
+            luma.build(*pyramid);
+        }
+        for (int i : keep) {
+            if (isCancelled()) break;
+            const cv::Rect& faceRect = rects[i];
+            bool valid;
+            {
+                StageProfiler::Scope scope(stageProfiler, ProfileStage::Validate);
+                valid = validateFaceRegion(faceRect, luma);
+            }
+            if (!valid) continue;
+
+            DetectedFace face;
+            face.boundingBox = faceRect;
+            face.confidence = confidences[i];
+            result.faces.push_back(face);
+        }
+
+        // Early delivery: boxes and confidences reach the caller at detector latency, identities follow
+        if (options.onBoxes && !options.detectOnly && !result.faces.empty() && !isCancelled()) {
+            DetectionResult boxes;
+            boxes.success = true;
+            boxes.faces = result.faces;
+            boxes.processingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+            options.onBoxes(boxes);
+        }
+
+        // Stage 4: embedding, with the tier chosen for this camera; a cancelled frame keeps only the faces embedded so far
+        size_t embedded = 0;
+        for (DetectedFace& face : result.faces) {
+            if (isCancelled()) break;
+            encodeFace(frame, luma, face, options, systemLoad);
+            if (options.onEmbedded && !face.encoding.empty()) {
+                options.onEmbedded(face, embedded, std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - startTime).count());
             }
+            embedded++;
+            std::cout << "Added detection: conf=" << face.confidence << ", rect=" << face.boundingBox.x << "," << face.boundingBox.y << ","
+                      << face.boundingBox.width << "," << face.boundingBox.height << ", encoding_size=" << face.encoding.size() << std::endl;
+        }
+        result.faces.resize(embedded);
+        result.cancelled = isCancelled();
+        result.success = !result.cancelled;
+        if (result.cancelled) {
+            result.error = "Cancelled";
         }
-        result.success = true;
     } catch (const std::exception& e) {
         result.success = false;
         result.error = e.what();
         std::cerr << "Detection failed: " << e.what() << std::endl;
     }
 
+    inFlightDetections--;
+
     auto endTime = std::chrono::high_resolution_clock::now();
     result.processingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    embeddingPolicy.recordLatency(options.cameraId, static_cast<double>(result.processingTimeMs));
+    if (options.cameraId >= 0 && result.success && !options.allTiers) {
+        // Motion for the sampling controller: difference of a tiny grayscale thumbnail between frames
+        cv::Mat grayThumbnail = pyramid->gray(cv::Size(SamplingController::kThumbnailWidth, SamplingController::kThumbnailHeight));
+        samplingController.observe(options.cameraId, static_cast<int>(result.faces.size()),
+                                   grayThumbnail.isContinuous() ? grayThumbnail.ptr<uint8_t>() : nullptr,
+                                   static_cast<double>(result.processingTimeMs));
+    }
     std::cout << "Detected " << result.faces.size() << " faces in " << result.processingTimeMs << "ms." << std::endl;
     return result;
 }
 
+DetectionResult FaceDetector::embedFace(const cv::Mat& frame, const cv::Rect& faceRect, const DetectionOptions& options) {
+    DetectionResult result;
+    result.success = false;
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    cv::Rect box = faceRect & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (!initialized || frame.empty() || box.width <= 0 || box.height <= 0) {
+        result.error = !initialized ? "Detector not initialized or empty frame" : "Face box outside the image";
+        result.processingTimeMs = 0;
+        return result;
+    }
+
+    int inFlight = ++inFlightDetections;
+    float systemLoad = static_cast<float>(inFlight) / std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        if (options.cancelled && options.cancelled->load(std::memory_order_relaxed)) {
+            result.cancelled = true;
+            result.error = "Cancelled";
+        } else {
+            FramePyramid pyramid(frame);
+            FrameLuma luma;
+            luma.build(pyramid);
+
+            DetectedFace face;
+            face.boundingBox = box;
+            face.confidence = 1.0f; // The box comes from the caller, not from a detector
+            encodeFace(frame, luma, face, options, systemLoad);
+            result.faces.push_back(face);
+            result.success = true;
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+        std::cerr << "Face embedding failed: " << e.what() << std::endl;
+    }
+
+    inFlightDetections--;
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    result.processingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    return result;
+}
+
+double FaceDetector::warmUp(cv::Size frameSize, int concurrency) {
+    if (!initialized || frameSize.width <= 0 || frameSize.height <= 0) {
+        return -1.0;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    waitForRecognition();
+
+    // Mid-gray frame with a textured face-sized patch, so every stage sees realistic input sizes
+    cv::Mat frame(frameSize, CV_8UC3, cv::Scalar(128, 128, 128));
+    int side = std::max(1, std::min(frameSize.width, frameSize.height) / 4);
+    cv::Rect faceRect((frameSize.width - side) / 2, (frameSize.height - side) / 2, side, side);
+    cv::randu(frame(faceRect), cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat faceImage = frame(faceRect);
+
+    // Replicas are created while every existing one is leased, so hold `replicas` leases at once (never more than
+    // the model may create, or the last acquire would wait for a lease this thread holds)
+    size_t replicas = static_cast<size_t>(std::max(1, std::min(concurrency, static_cast<int>(netReplicaLimit()))));
+    auto warmNet = [replicas](SharedNet& net, const std::function<void(cv::dnn::Net&)>& pass) {
+        std::vector<SharedNet::Lease> leases;
+        size_t count = std::min(replicas, net.replicaLimit());
+        for (size_t i = 0; i < count; i++) {
+            leases.push_back(net.acquire());
+        }
+        std::vector<std::future<void>> passes;
+        for (SharedNet::Lease& lease : leases) {
+            cv::dnn::Net* leased = &lease.net();
+            passes.push_back(std::async(std::launch::async, [leased, &pass]() { pass(*leased); }));
+        }
+        for (std::future<void>& done : passes) {
+            done.get();
+        }
+    };
+
+    try {
+        FramePyramid pyramid(frame);
+        if (faceNet && dnnDetector) {
+            cv::Mat input = pyramid.resized(dnnInputSize);
+            warmNet(*faceNet, [this, &input, &frameSize](cv::dnn::Net& net) {
+                std::vector<cv::Rect> rects;
+                std::vector<float> confidences;
+                dnnDetector(net, input, frameSize, confidenceThreshold, rects, confidences);
+            });
+        } else if (candidateStage) {
+            std::vector<cv::Rect> rects;
+            std::vector<float> confidences;
+            (this->*candidateStage)(pyramid, -1, rects, confidences);
+        }
+
+        for (int i = 0; i < kEmbeddingTierCount; i++) {
+            if (!embeddingModels[i].loaded || !embedders[i] || !faceRecognitionNets[i]) continue;
+            face_pipeline::EmbedderFn embedder = embedders[i];
+            warmNet(*faceRecognitionNets[i], [embedder, &faceImage](cv::dnn::Net& net) {
+                embedder(net, faceImage);
+            });
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Warm-up failed: " << e.what() << std::endl;
+    }
+
+    double ms = elapsed_ms(startTime);
+    std::cout << "Warmed up " << replicas << " pipeline(s) for " << frameSize.width << "x" << frameSize.height
+              << " frames in " << ms << "ms" << std::endl;
+    return ms;
+}
+
+void FaceDetector::detectCandidatesDnn(FramePyramid& pyramid, int /*cameraId*/, std::vector<cv::Rect>& rects, std::vector<float>& confidences) {
+    // Area-resized from the smallest octave that covers the network input, not from the full frame
+    cv::Mat input = pyramid.resized(dnnInputSize);
+    SharedNet::Lease lease = faceNet->acquire();
+    dnnDetector(lease.net(), input, pyramid.size(), confidenceThreshold, rects, confidences);
+}
+
+void FaceDetector::detectCandidatesCascade(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& rects, std::vector<float>& confidences) {
+    lowPowerDetector.detect(pyramid, cameraId, rects);
+    // The cascade has no score; use a fixed confidence that passes the default threshold
+    confidences.assign(rects.size(), 0.75f);
+}
+
+bool FaceDetector::runPrefilter(FramePyramid& pyramid, const DetectionCascade::Config& config) {
+    // Equalized into a new image: the pyramid's levels are shared with the later stages
+    cv::Mat gray;
+    cv::equalizeHist(pyramid.grayForWidth(config.thumbnailWidth), gray);
+    std::vector<cv::Rect> hits;
+    faceCascade.detectMultiScale(gray, hits, 1.2, std::max(1, config.minNeighbors), cv::CASCADE_SCALE_IMAGE);
+    return !hits.empty();
+}
+
+void FaceDetector::FrameLuma::build(FramePyramid& pyramid) {
+    gray = pyramid.gray();
+    const size_t stride = static_cast<size_t>(gray.cols) + 1;
+    sum.resize(stride * (gray.rows + 1));
+    simd::kernels().integral(gray.ptr<uint8_t>(), gray.step, gray.cols, gray.rows, sum.data(), stride);
+}
+
+double FaceDetector::FrameLuma::mean(const cv::Rect& rect) const {
+    const size_t stride = static_cast<size_t>(gray.cols) + 1;
+    const uint32_t* top = sum.data() + rect.y * stride;
+    const uint32_t* bottom = top + rect.height * stride;
+    uint32_t total = bottom[rect.x + rect.width] - bottom[rect.x] - top[rect.x + rect.width] + top[rect.x];
+    return static_cast<double>(total) / (static_cast<double>(rect.width) * rect.height);
+}
+
 // Simplified and reliable face region validation
-bool FaceDetector::validateFaceRegion(const cv::Rect& faceRect, const cv::Mat& frame) {
+bool FaceDetector::validateFaceRegion(const cv::Rect& faceRect, const FrameLuma& luma) {
     if (faceRect.width <= 0 || faceRect.height <= 0 || faceRect.x < 0 || faceRect.y < 0) return false;
-    if (faceRect.x + faceRect.width > frame.cols || faceRect.y + faceRect.height > frame.rows) return false;
+    if (faceRect.x + faceRect.width > luma.gray.cols || faceRect.y + faceRect.height > luma.gray.rows) return false;
 
     float aspectRatio = static_cast<float>(faceRect.width) / faceRect.height;
     if (aspectRatio < 0.6f || aspectRatio > 1.4f) return false;
     if (faceRect.width < 30 || faceRect.height < 30) return false;
 
-    cv::Mat faceRegion = frame(faceRect);
-    if (faceRegion.empty()) return false;
+    // Check for extreme brightness (constant time from the integral image)
+    double mean = luma.mean(faceRect);
+    if (mean < 20 || mean > 230) return false;
+
+    return true;
+}
+
+// Face quality for tier selection: large, well-contrasted faces degrade gracefully on a light model
+float FaceDetector::estimateFaceQuality(const cv::Rect& faceRect, const FrameLuma& luma) {
+    cv::Rect safeFaceRect = faceRect & cv::Rect(0, 0, luma.gray.cols, luma.gray.rows);
+    if (safeFaceRect.width <= 0 || safeFaceRect.height <= 0) return 0.0f;
+
+    float sizeScore = std::min(1.0f, std::min(safeFaceRect.width, safeFaceRect.height) / 112.0f);
 
-    // Check for extreme brightness
-    cv::Mat grayRegion;
-    cv::cvtColor(faceRegion, grayRegion, cv::COLOR_BGR2GRAY);
     cv::Scalar mean, stddev;
-    cv::meanStdDev(grayRegion, mean, stddev);
-    if (mean[0] < 20 || mean[0] > 230) return false;
+    cv::meanStdDev(luma.gray(safeFaceRect), mean, stddev);
+    float contrastScore = std::min(1.0f, static_cast<float>(stddev[0]) / 40.0f);
 
-    return true;
+    return sizeScore * contrastScore;
+}
+
+void FaceDetector::encodeFace(const cv::Mat& frame, const FrameLuma& luma, DetectedFace& face, const DetectionOptions& options, float systemLoad) {
+    if (options.detectOnly || !waitForRecognition()) {
+        return;
+    }
+
+    face.quality = estimateFaceQuality(face.boundingBox, luma);
+
+    if (options.allTiers) {
+        // Enrollment: one embedding per loaded model so every per-model gallery gets the face
+        for (int i = 0; i < kEmbeddingTierCount; i++) {
+            if (!embeddingModels[i].loaded) continue;
+            std::vector<float> embedding = extractFaceEncoding(frame, face.boundingBox, static_cast<EmbeddingTier>(i));
+            if (embedding.empty()) continue;
+            if (face.encoding.empty()) {
+                face.encoding = embedding;
+                face.embeddingModel = embeddingModels[i].version;
+            }
+            face.embeddings[embeddingModels[i].version] = std::move(embedding);
+        }
+        return;
+    }
+
+    int tier = options.embeddingTier;
+    if (tier < 0 || tier >= kEmbeddingTierCount || !embeddingModels[tier].loaded) {
+        tier = embeddingPolicy.selectTier(options.cameraId, face.quality, systemLoad);
+    }
+    if (tier < 0) {
+        return;
+    }
+
+    face.encoding = extractFaceEncoding(frame, face.boundingBox, static_cast<EmbeddingTier>(tier));
+    if (!face.encoding.empty()) {
+        face.embeddingModel = embeddingModels[tier].version;
+    }
 }
 
-DetectionResult FaceDetector::detectFacesFromBuffer(const uint8_t* buffer, size_t length) {
+DetectionResult FaceDetector::detectFacesFromBuffer(const uint8_t* buffer, size_t length, const DetectionOptions& options) {
     DetectionResult result;
     try {
-        std::vector<uint8_t> data(buffer, buffer + length);
-        cv::Mat frame = cv::imdecode(data, cv::IMREAD_COLOR);
+        cv::Mat frame;
+        {
+            StageProfiler::Scope scope(stageProfiler, ProfileStage::Decode);
+            std::vector<uint8_t> data(buffer, buffer + length);
+            frame = cv::imdecode(data, cv::IMREAD_COLOR);
+        }
         if (frame.empty()) {
             result.success = false;
             result.error = "Failed to decode image from buffer";
             return result;
         }
-        return detectFaces(frame);
+        return detectFaces(frame, options);
     } catch (const std::exception& e) {
         result.success = false;
         result.error = e.what();
@@ -353,30 +626,38 @@ DetectionResult FaceDetector::detectFacesFromBuffer(const uint8_t* buffer, size_
 }
 
 // Async detection methods using thread pool
-std::future<DetectionResult> FaceDetector::detectFacesAsync(const cv::Mat& frame) {
+std::future<DetectionResult> FaceDetector::detectFacesAsync(const cv::Mat& frame, const DetectionOptions& options) {
     if (!threadPool) {
         std::promise<DetectionResult> promise;
-        promise.set_value(detectFaces(frame));
+        promise.set_value(detectFaces(frame, options));
         return promise.get_future();
     }
     cv::Mat frameCopy = frame.clone();
-    return threadPool->enqueue([this, frameCopy]() -> DetectionResult {
-        return this->detectFaces(frameCopy);
+    return threadPool->enqueue([this, frameCopy, options]() -> DetectionResult {
+        return this->detectFaces(frameCopy, options);
     });
 }
 
-std::future<DetectionResult> FaceDetector::detectFacesFromBufferAsync(const uint8_t* buffer, size_t length) {
+std::future<DetectionResult> FaceDetector::detectFacesFromBufferAsync(const uint8_t* buffer, size_t length, const DetectionOptions& options) {
     if (!threadPool) {
         std::promise<DetectionResult> promise;
-        promise.set_value(detectFacesFromBuffer(buffer, length));
+        promise.set_value(detectFacesFromBuffer(buffer, length, options));
         return promise.get_future();
     }
     std::vector<uint8_t> bufferCopy(buffer, buffer + length);
-    return threadPool->enqueue([this, bufferCopy]() -> DetectionResult {
-        return this->detectFacesFromBuffer(bufferCopy.data(), bufferCopy.size());
+    return threadPool->enqueue([this, bufferCopy, options]() -> DetectionResult {
+        return this->detectFacesFromBuffer(bufferCopy.data(), bufferCopy.size(), options);
     });
 }
 
+void FaceDetector::runAsync(std::function<void()> task) {
+    if (!threadPool) {
+        task();
+        return;
+    }
+    threadPool->enqueue(std::move(task));
+}
+
 void FaceDetector::setConfidenceThreshold(float threshold) {
     confidenceThreshold = threshold;
 }
@@ -385,10 +666,11 @@ void FaceDetector::setNMSThreshold(float threshold) {
     nmsThreshold = threshold;
 }
 
-std::vector<float> FaceDetector::extractFaceEncoding(const cv::Mat& frame, const cv::Rect& faceRect) {
+std::vector<float> FaceDetector::extractFaceEncoding(const cv::Mat& frame, const cv::Rect& faceRect, EmbeddingTier tier) {
     std::vector<float> encoding;
+    int index = static_cast<int>(tier);
 
-    if (!faceRecognitionInitialized || faceRecognitionNet.empty()) {
+    if (!embeddingModels[index].loaded || !embedders[index] || !faceRecognitionNets[index]) {
         std::cout << "Face recognition model not initialized - returning empty encoding" << std::endl;
         return encoding;
     }
@@ -401,65 +683,19 @@ std::vector<float> FaceDetector::extractFaceEncoding(const cv::Mat& frame, const
             return encoding;
         }
 
+        StageProfiler::Scope scope(stageProfiler, ProfileStage::Embed);
         cv::Mat faceImage = frame(safeFaceRect);
         if (faceImage.empty()) {
             std::cout << "Empty face image - returning empty encoding" << std::endl;
             return encoding;
         }
 
-        cv::Mat resizedFace, blob;
-        cv::Size inputSize;
-
-        if (useArcFace) {
-            // ArcFace expects 112x112 input with RGB format and normalization
-            inputSize = cv::Size(112, 112);
-            cv::resize(faceImage, resizedFace, inputSize);
+        // Preprocessing, forward pass and normalization are specialized per model (face_pipeline.h)
+        SharedNet::Lease lease = faceRecognitionNets[index]->acquire();
+        encoding = embedders[index](lease.net(), faceImage);
 
-            // ArcFace preprocessing: BGR->RGB, normalize to [-1,1], and reorder to CHW
-            cv::Mat rgbFace;
-            cv::cvtColor(resizedFace, rgbFace, cv::COLOR_BGR2RGB);
-            blob = cv::dnn::blobFromImage(rgbFace, 1.0/127.5, inputSize, cv::Scalar(127.5, 127.5, 127.5), false, false);
-
-            std::cout << "Using ArcFace model for encoding extraction..." << std::endl;
-        } else {
-            // FaceNet expects 160x160 input with standard normalization
-            inputSize = cv::Size(160, 160);
-            cv::resize(faceImage, resizedFace, inputSize);
-
-            // FaceNet preprocessing: normalize to [0,1]
-            blob = cv::dnn::blobFromImage(resizedFace, 1.0/255.0, inputSize, cv::Scalar(0, 0, 0), true, false);
-
-            std::cout << "Using FaceNet model for encoding extraction..." << std::endl;
-        }
-
-        // Set input to the network
-        faceRecognitionNet.setInput(blob);
-
-        // Forward pass
-        cv::Mat output = faceRecognitionNet.forward();
-
-        // Convert output to vector<float>
-        if (output.type() == CV_32F && output.total() > 0) {
-            float* data = (float*)output.data;
-            encoding.assign(data, data + output.total());
-
-            if (useArcFace) {
-                // Normalize ArcFace embeddings (L2 normalization)
-                float norm = 0.0f;
-                for (float val : encoding) {
-                    norm += val * val;
-                }
-                norm = std::sqrt(norm);
-
-                if (norm > 0) {
-                    for (float& val : encoding) {
-                        val /= norm;
-                    }
-                }
-                std::cout << "Successfully extracted ArcFace encoding with " << encoding.size() << " dimensions (normalized)" << std::endl;
-            } else {
-                std::cout << "Successfully extracted FaceNet encoding with " << encoding.size() << " dimensions" << std::endl;
-            }
+        if (!encoding.empty()) {
+            std::cout << "Successfully extracted " << embeddingModels[index].name << " encoding with " << encoding.size() << " dimensions" << std::endl;
         } else {
             std::cout << "Invalid model output format - returning empty encoding" << std::endl;
         }
@@ -469,4 +705,4 @@ std::vector<float> FaceDetector::extractFaceEncoding(const cv::Mat& frame, const
     }
 
     return encoding;
-}
\ No newline at end of file
+}
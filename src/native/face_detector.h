@@ -11,20 +11,67 @@
 #include <queue>
 #include <future>
 #include <atomic>
+#include <map>
+#include <functional>
+#include "detection_cascade.h"
+#include "embedding_tier_policy.h"
+#include "low_power_detector.h"
+#include "sampling_controller.h"
+#include "stage_profiler.h"
+#include "face_pipeline.h"
+#include "frame_pyramid.h"
 
-// Forward declaration of ThreadPool
+// Process-wide shared state (shared_runtime.h)
 class ThreadPool;
+class SharedNet;
 
 struct DetectedFace {
     cv::Rect boundingBox;
     float confidence;
     std::vector<cv::Point2f> landmarks;
     std::vector<float> encoding; // Face embedding/encoding for recognition
+    std::string embeddingModel; // Version tag of the model that produced `encoding`
+    float quality = 0.0f; // Size/contrast score in [0,1] used for tier selection
+    std::map<std::string, std::vector<float>> embeddings; // Per-model embeddings (DetectionOptions::allTiers)
     // You can add more features here, e.g., facial emotions, etc.
 };
 
+struct DetectionResult;
+
+struct DetectionOptions {
+    int cameraId = -1;      // Camera the frame came from, used for per-camera tier selection
+    int embeddingTier = -1; // Force a tier (EmbeddingTier); -1 lets the policy decide
+    bool allTiers = false;  // Extract embeddings with every loaded model (used for enrollment)
+    bool detectOnly = false; // Boxes only: no embeddings, never waits for deferred recognition models
+    const std::atomic<bool>* cancelled = nullptr; // Set by the caller to skip the remaining stages of this frame
+    // Called on the detecting thread with the validated boxes (no encodings yet) before embedding starts;
+    // not called for detectOnly or when no face survives validation
+    std::function<void(const DetectionResult&)> onBoxes;
+    // Called on the detecting thread right after each face is embedded, before the next one is
+    // (watchlist checks); elapsedMs is the time since detection started
+    std::function<void(const DetectedFace& face, size_t index, double elapsedMs)> onEmbedded;
+};
+
+struct EmbeddingModelInfo {
+    std::string name;
+    std::string version;
+    cv::Size inputSize;
+    bool loaded = false;
+};
+
+// Startup cost of one model, reported once initialize() has loaded it
+struct ModelLoadTiming {
+    std::string name;
+    std::string role;       // "detector", "prefilter" or "recognition"
+    double loadMs = 0.0;    // Map + parse time; 0 when the model was reused
+    size_t sizeBytes = 0;
+    bool reused = false;    // Already loaded by another detector in the process
+    bool deferred = false;  // Loaded in the background after initialize() returned
+};
+
 struct DetectionResult {
     bool success;
+    bool cancelled = false; // Stopped by DetectionOptions::cancelled; `faces` holds what finished before
     std::string error;
     std::vector<DetectedFace> faces;
     long long processingTimeMs;
@@ -38,24 +85,45 @@ public:
     /**
      * @brief Initializes the face detector with the specified models.
      * @param modelPath The path to the directory containing the model files (e.g., /path/to/models).
-     * @param useDL Set to true to use deep learning models (YuNet/SSD), false for Haar Cascade.
-     * @return True if a model was loaded successfully, false otherwise.
+     * @param useDL Set to true to use deep learning models (YuNet/SSD), false for the low-power cascade detector.
+     * @param deferRecognition Return as soon as the detection model is ready and finish loading the
+     *        recognition models in the background; frames that need embeddings wait for them.
+     *        Otherwise both are loaded in parallel and initialize returns when all are ready.
+     * @return True if a detection model was loaded successfully, false otherwise.
      */
-    bool initialize(const std::string& modelPath, bool useDL = true);
+    bool initialize(const std::string& modelPath, bool useDL = true, bool deferRecognition = false);
 
     /**
      * @brief Detects faces in a given frame.
      * @param frame The input image frame.
      * @return A DetectionResult struct containing the detected faces and processing information.
      */
-    DetectionResult detectFaces(const cv::Mat& frame);
+    DetectionResult detectFaces(const cv::Mat& frame, const DetectionOptions& options = DetectionOptions());
+
+    /**
+     * @brief Embeds a face whose box is already known, skipping detection.
+     * Used to re-embed stored detections; the frame may be just the decoded region around the box.
+     * @param frame The image (or image region) containing the face.
+     * @param faceRect The face box in `frame` coordinates.
+     * @return A DetectionResult with one face carrying the box, quality and embedding(s).
+     */
+    DetectionResult embedFace(const cv::Mat& frame, const cv::Rect& faceRect, const DetectionOptions& options = DetectionOptions());
+
+    /**
+     * @brief Prepares the inference contexts a camera pipeline will use before its first frame.
+     * Parses up to `concurrency` replicas of each loaded model and runs one forward pass on each with
+     * a synthetic frame of `frameSize`, so layer buffers are allocated before live frames arrive.
+     * Waits for deferred recognition models.
+     * @return The time spent, in milliseconds; negative if the detector is not initialized.
+     */
+    double warmUp(cv::Size frameSize, int concurrency = 1);
 
     /**
      * @brief Detects faces asynchronously using a thread pool.
      * @param frame The input image frame.
      * @return A future object that will hold the DetectionResult.
      */
-    std::future<DetectionResult> detectFacesAsync(const cv::Mat& frame);
+    std::future<DetectionResult> detectFacesAsync(const cv::Mat& frame, const DetectionOptions& options = DetectionOptions());
 
     /**
      * @brief Detects faces from a raw image buffer asynchronously.
@@ -63,7 +131,7 @@ public:
      * @param length The size of the buffer.
      * @return A future object that will hold the DetectionResult.
      */
-    std::future<DetectionResult> detectFacesFromBufferAsync(const uint8_t* buffer, size_t length);
+    std::future<DetectionResult> detectFacesFromBufferAsync(const uint8_t* buffer, size_t length, const DetectionOptions& options = DetectionOptions());
 
     /**
      * @brief Detects faces from a raw image buffer.
@@ -71,7 +139,13 @@ public:
      * @param length The size of the buffer.
      * @return A DetectionResult struct containing the detected faces and processing information.
      */
-    DetectionResult detectFacesFromBuffer(const uint8_t* buffer, size_t length);
+    DetectionResult detectFacesFromBuffer(const uint8_t* buffer, size_t length, const DetectionOptions& options = DetectionOptions());
+
+    /**
+     * @brief Runs a task on the shared detection thread pool (inline if there is none).
+     * Used by the C API to decode and detect submitted frames off the caller's thread.
+     */
+    void runAsync(std::function<void()> task);
 
     // Getters and setters
     void setConfidenceThreshold(float threshold);
@@ -79,32 +153,106 @@ public:
     float getConfidenceThreshold() const { return confidenceThreshold; }
     float getNMSThreshold() const { return nmsThreshold; }
     bool isInitialized() const { return initialized; }
+    bool isRecognitionReady() const { return recognitionReady.load(std::memory_order_acquire); }
+    std::string getDetectorName() const;
+    std::vector<ModelLoadTiming> getModelLoadTimings() const;
+
+    // Embedding tier selection
+    EmbeddingTierPolicy& tierPolicy() { return embeddingPolicy; }
+
+    // Two-stage detection: cascade pre-filter in front of the detection network
+    DetectionCascade& cascade() { return detectionCascade; }
+    bool isPrefilterAvailable() const { return prefilterLoaded; }
+
+    // Per-camera sampling rate, fed by every detection tagged with a camera
+    SamplingController& sampling() { return samplingController; }
+
+    // Cascade detector used when deep learning is off or its model is missing
+    LowPowerDetector& lowPower() { return lowPowerDetector; }
+    bool isLowPowerActive() const { return initialized && candidateStage == &FaceDetector::detectCandidatesCascade; }
+
+    // On-demand hardware counters around each pipeline stage
+    StageProfiler& profiler() { return stageProfiler; }
+    std::vector<EmbeddingModelInfo> getEmbeddingModels() const;
 
 private:
     cv::Ptr<cv::FaceDetectorYN> yunetDetector;
-    cv::dnn::Net faceNet; // For face detection (UltraFace)
-    cv::dnn::Net faceRecognitionNet; // For face recognition (ArcFace/FaceNet)
-    cv::CascadeClassifier faceCascade;
+    std::shared_ptr<SharedNet> faceNet; // For face detection (UltraFace)
+    std::shared_ptr<SharedNet> faceRecognitionNets[kEmbeddingTierCount]; // For face recognition, indexed by EmbeddingTier
+    EmbeddingModelInfo embeddingModels[kEmbeddingTierCount];
+    EmbeddingTierPolicy embeddingPolicy;
+    DetectionCascade detectionCascade;
+    SamplingController samplingController;
+    LowPowerDetector lowPowerDetector;
+    StageProfiler stageProfiler;
+
+    // Pipeline dispatch table, resolved once in initialize()
+    using CandidateStage = void (FaceDetector::*)(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& rects, std::vector<float>& confidences);
+    CandidateStage candidateStage;
+    face_pipeline::DetectorFn dnnDetector;
+    cv::Size dnnInputSize; // Geometry dnnDetector expects, taken from the frame pyramid
+    face_pipeline::EmbedderFn embedders[kEmbeddingTierCount];
+    cv::CascadeClassifier faceCascade; // Pre-filter for the detection network
 
     bool useDeepLearning;
     bool useYuNet;
     bool initialized;
     bool useUltraFace;
     bool faceRecognitionInitialized;
-    bool useArcFace; // Flag to track which model is loaded
+    bool prefilterLoaded; // faceCascade holds a pre-filter for the detection network
 
     float confidenceThreshold;
     float nmsThreshold;
 
-    // Thread pool for async operations
-    static std::unique_ptr<ThreadPool> threadPool;
-    static std::atomic<int> instanceCount;
+    // Thread pool for async operations, shared by every detector in the process
+    std::shared_ptr<ThreadPool> threadPool;
+
+    // Detections currently running on this instance, used as the load signal for tier selection
+    std::atomic<int> inFlightDetections;
+
+    // Recognition models load on their own thread; their members are only read once it completes
+    std::shared_future<void> recognitionLoad;
+    std::atomic<bool> recognitionReady;
+    mutable std::mutex loadTimingsMutex;
+    std::vector<ModelLoadTiming> loadTimings;
+
+    // Grayscale frame and its integral image, built once per frame for the face checks
+    struct FrameLuma {
+        cv::Mat gray; // The pyramid's full-resolution luma; read-only
+        std::vector<uint32_t> sum; // (cols + 1) x (rows + 1)
+        void build(FramePyramid& pyramid);
+        double mean(const cv::Rect& rect) const;
+    };
+
+    // Candidate stages: produce raw face rectangles and confidences for a frame
+    void detectCandidatesDnn(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& rects, std::vector<float>& confidences);
+    void detectCandidatesCascade(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& rects, std::vector<float>& confidences);
+
+    // Stage one of the cascade: true if the thumbnail has any face candidate
+    bool runPrefilter(FramePyramid& pyramid, const DetectionCascade::Config& config);
 
     // Helper function for simplified face region validation
-    bool validateFaceRegion(const cv::Rect& faceRect, const cv::Mat& frame);
+    bool validateFaceRegion(const cv::Rect& faceRect, const FrameLuma& luma);
+
+    // Helper function to score face size and contrast in [0,1]
+    float estimateFaceQuality(const cv::Rect& faceRect, const FrameLuma& luma);
+
+    // Helper functions to load the detection model and the recognition model tiers
+    bool loadDetectionModel(const std::string& modelPath);
+    bool loadCascade(const std::string& modelPath, const std::string& role);
+    std::vector<std::string> cascadeCandidates(const std::string& modelPath) const;
+    void loadRecognitionModels(const std::string& modelPath, bool deferred);
+    bool loadEmbeddingModel(EmbeddingTier tier, const std::string& modelFile, bool deferred);
+    void recordLoadTiming(ModelLoadTiming timing);
+
+    // Blocks until background recognition loading is done; returns whether any tier is available
+    bool waitForRecognition();
+
+    // Helper function to fill the encoding fields of a face for the selected tier(s)
+    void encodeFace(const cv::Mat& frame, const FrameLuma& luma, DetectedFace& face, const DetectionOptions& options, float systemLoad);
 
-    // Helper function to extract face encodings using FaceNet
-    std::vector<float> extractFaceEncoding(const cv::Mat& frame, const cv::Rect& faceRect);
+    // Helper function to extract face encodings with the given tier's model
+    std::vector<float> extractFaceEncoding(const cv::Mat& frame, const cv::Rect& faceRect, EmbeddingTier tier);
 };
 
 #endif // FACE_DETECTOR_H
\ No newline at end of file
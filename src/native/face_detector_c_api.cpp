@@ -0,0 +1,2054 @@
+#include "face_detector_c_api.h"
+#include "face_detector.h"
+#include "shared_runtime.h"
+#include "detection_journal.h"
+#include "h264_fragmenter.h"
+#include "embedding_gallery.h"
+#include "unknown_face_store.h"
+#include "rolling_counters.h"
+#include "watchlist.h"
+#include "roi_decoder.h"
+#include "cpu_features.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+
+// Library-owned result: the public fd_result fields point into the C++ result it wraps
+struct ResultHolder : fd_result {
+    DetectionResult detection;
+    std::vector<fd_face> faceViews;
+    std::vector<fd_embedding> embeddingViews;
+};
+
+// One frame from submission (or fd_reserve_job) to completion. Queued tasks hold only the job, so
+// a job cancelled before it starts never touches the detector again.
+struct Job {
+    enum State { Queued, Running, Cancelled };
+
+    uint64_t id = 0;
+    int32_t cameraId = -1;
+    int64_t eventId = -1;
+    bool submitted = false;           // fd_submit_*: results go through deliver()
+    std::atomic<int> state{Queued};
+    std::atomic<bool> cancelled{false}; // Read by FaceDetector between stages
+
+    // Input of a submitted job, released as soon as it is cancelled
+    std::vector<uint8_t> encoded;
+    cv::Mat frame;
+
+    bool begin() {
+        int expected = Queued;
+        return state.compare_exchange_strong(expected, Running);
+    }
+};
+
+// Library-owned journal batch: the public records point into the decoded ones
+struct JournalBatchHolder : fd_journal_batch {
+    std::vector<JournalRecord> decoded;
+    std::vector<fd_journal_record> views;
+};
+
+struct fd_journal {
+    std::unique_ptr<DetectionJournal> journal;
+};
+
+struct fd_preview {
+    H264Fragmenter fragmenter;
+    std::vector<H264Fragmenter::AccessUnit> completed; // From the last push
+    std::vector<fd_preview_unit> completedViews;
+    std::vector<fd_preview_unit> joinViews;
+
+    explicit fd_preview(size_t maxCacheBytes) : fragmenter(maxCacheBytes) {}
+};
+
+struct GalleryBlobHolder : fd_gallery_blob {
+    std::vector<uint8_t> bytes;
+};
+
+struct fd_gallery {
+    EmbeddingGallery gallery;
+
+    explicit fd_gallery(int dimension) : gallery(dimension) {}
+};
+
+struct fd_unknown_faces {
+    UnknownFaceStore store;
+
+    fd_unknown_faces(int dimension, size_t maxPerOrganization) : store(dimension, maxPerOrganization) {}
+};
+
+struct fd_counters {
+    RollingCounters counters;
+
+    explicit fd_counters(const RollingCounters::Config& config) : counters(config) {}
+};
+
+// Shared so a detector it is attached to keeps it after fd_watchlist_close
+struct fd_watchlist {
+    std::shared_ptr<Watchlist> list;
+
+    explicit fd_watchlist(float threshold) : list(std::make_shared<Watchlist>(threshold)) {}
+};
+
+struct CounterSnapshotHolder : fd_counter_snapshot {
+    RollingCounters::Snapshot snapshot;
+    std::vector<fd_counter_series> views;
+};
+
+struct fd_detector {
+    FaceDetector core;
+
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::condition_variable drained;
+    std::deque<fd_result*> completed;
+    fd_result_callback callback = nullptr;
+    void* userData = nullptr;
+
+    uint64_t nextFrameId = 1;
+    uint32_t maxPending = 64;
+    uint32_t maxQueued = 256;
+
+    // Guarded by `mutex`
+    uint64_t submitted = 0;
+    uint64_t completedCount = 0;
+    uint64_t failed = 0;
+    uint64_t rejected = 0;
+    uint64_t cancelled = 0;
+    uint64_t dropped = 0;
+    uint64_t pending = 0;
+    uint64_t facesDetected = 0;
+    double totalProcessingMs = 0.0;
+    double maxProcessingMs = 0.0;
+    std::unordered_map<uint64_t, std::shared_ptr<Job>> jobs; // Queued and running, by id
+
+    // Frames check the watchlist under a shared lock, so fd_set_watchlist can swap it once no alert is in flight
+    std::shared_mutex watchlistMutex;
+    std::shared_ptr<Watchlist> watchlist;
+    fd_watchlist_callback watchlistCallback = nullptr;
+    void* watchlistUserData = nullptr;
+};
+
+// Copies a caller struct that starts with `structSize` into a default-initialized full-size one
+template<typename T>
+static T readVersioned(const T* in, T defaults) {
+    if (in && in->structSize >= sizeof(uint32_t)) {
+        std::memcpy(&defaults, in, std::min<size_t>(in->structSize, sizeof(T)));
+    }
+    defaults.structSize = sizeof(T);
+    return defaults;
+}
+
+// Writes a full struct back to the caller, truncated to the caller's `structSize`
+template<typename T>
+static int writeVersioned(T* out, T value) {
+    if (!out || out->structSize < sizeof(uint32_t)) return FD_ERR_INVALID_ARGUMENT;
+    uint32_t callerSize = out->structSize;
+    value.structSize = callerSize;
+    std::memcpy(out, &value, std::min<size_t>(callerSize, sizeof(T)));
+    return FD_OK;
+}
+
+template<size_t N>
+static void copyString(char (&dst)[N], const std::string& src) {
+    size_t n = std::min(src.size(), N - 1);
+    std::memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+static std::string joinNames(const std::vector<std::string>& names) {
+    std::string joined;
+    for (const std::string& name : names) {
+        if (!joined.empty()) joined += ",";
+        joined += name;
+    }
+    return joined;
+}
+
+static fd_detect_options readDetectOptions(const fd_detect_options* options) {
+    fd_detect_options defaults;
+    fd_detect_options_init(&defaults);
+    return readVersioned(options, defaults);
+}
+
+static fd_result* makeResult(DetectionResult&& detection, int status, uint64_t frameId, int cameraId);
+
+static DetectionOptions toDetectionOptions(fd_detector* detector, const fd_detect_options& in, const Job* job) {
+    DetectionOptions out;
+    out.cameraId = in.cameraId;
+    out.embeddingTier = in.embeddingTier ? embeddingTierFromName(in.embeddingTier) : -1;
+    out.allTiers = in.allTiers != 0;
+    out.detectOnly = in.detectOnly != 0;
+    out.cancelled = job ? &job->cancelled : nullptr;
+    if (in.boxesCallback) {
+        fd_boxes_callback callback = in.boxesCallback;
+        void* user = in.boxesUserData;
+        uint64_t frameId = job ? job->id : in.jobId;
+        int cameraId = in.cameraId;
+        out.onBoxes = [callback, user, frameId, cameraId](const DetectionResult& boxes) {
+            fd_result* result = makeResult(DetectionResult(boxes), FD_OK, frameId, cameraId);
+            callback(result, user);
+            fd_result_free(result);
+        };
+    }
+    if (in.cameraId >= 0 && !out.allTiers && !out.detectOnly) {
+        // Watchlist fast path: each face is checked as soon as it is embedded, ahead of the frame's other faces
+        uint64_t frameId = job ? job->id : in.jobId;
+        int cameraId = in.cameraId;
+        int64_t organizationId = in.organizationId;
+        out.onEmbedded = [detector, frameId, cameraId, organizationId](const DetectedFace& face, size_t index, double elapsedMs) {
+            auto checkStart = std::chrono::steady_clock::now();
+            std::shared_lock<std::shared_mutex> lock(detector->watchlistMutex);
+            if (!detector->watchlist || !detector->watchlistCallback) return;
+            Watchlist::Hit hit;
+            if (!detector->watchlist->check(face.embeddingModel, face.encoding.data(), static_cast<int>(face.encoding.size()),
+                                            organizationId, hit)) {
+                return;
+            }
+            fd_watchlist_alert alert;
+            std::memset(&alert, 0, sizeof(alert));
+            alert.frameId = frameId;
+            alert.cameraId = cameraId;
+            alert.faceIndex = static_cast<int32_t>(index);
+            alert.box = {face.boundingBox.x, face.boundingBox.y, face.boundingBox.width, face.boundingBox.height};
+            alert.confidence = face.confidence;
+            alert.hit = {hit.id, hit.organizationId, hit.similarity};
+            alert.latencyMs = elapsedMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - checkStart).count();
+            alert.firedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            detector->watchlist->recordAlert(alert.latencyMs);
+            detector->watchlistCallback(&alert, detector->watchlistUserData);
+        };
+    }
+    return out;
+}
+
+static EmbeddingGallery::SearchOptions toGallerySearchOptions(const fd_gallery_search_options* options, int capacity) {
+    fd_gallery_search_options defaults;
+    fd_gallery_search_options_init(&defaults);
+    fd_gallery_search_options in = readVersioned(options, defaults);
+
+    EmbeddingGallery::SearchOptions searchOptions;
+    searchOptions.k = std::min(in.k, capacity);
+    searchOptions.rerank = std::max(0, in.rerank);
+    searchOptions.budgetMs = std::isfinite(in.budgetMs) ? std::max(0.0, in.budgetMs) : 0.0;
+    searchOptions.matchThreshold = std::isnan(in.matchThreshold) ? defaults.matchThreshold : in.matchThreshold;
+    searchOptions.margin = std::isfinite(in.margin) ? in.margin : defaults.margin;
+    searchOptions.maxRerank = std::max(0, in.maxRerank);
+    return searchOptions;
+}
+
+static EmbeddingGallery::ChangeCallback toChangeCallback(fd_gallery_change_callback callback, void* user) {
+    if (!callback) {
+        return nullptr;
+    }
+    return [callback, user](EmbeddingGallery::ChangeOp op, int64_t id, const std::string& payload) {
+        callback(user, static_cast<fd_gallery_change_op>(op), id, reinterpret_cast<const uint8_t*>(payload.data()),
+                 payload.size());
+    };
+}
+
+static fd_result* makeResult(DetectionResult&& detection, int status, uint64_t frameId, int cameraId) {
+    ResultHolder* holder = new ResultHolder();
+    holder->detection = std::move(detection);
+    const DetectionResult& r = holder->detection;
+
+    size_t embeddingCount = 0;
+    for (const DetectedFace& face : r.faces) embeddingCount += face.embeddings.size();
+    holder->faceViews.reserve(r.faces.size());
+    holder->embeddingViews.reserve(embeddingCount);
+
+    for (const DetectedFace& face : r.faces) {
+        fd_face view;
+        view.x = face.boundingBox.x;
+        view.y = face.boundingBox.y;
+        view.width = face.boundingBox.width;
+        view.height = face.boundingBox.height;
+        view.confidence = face.confidence;
+        view.quality = face.quality;
+        view.encoding = face.encoding.empty() ? nullptr : face.encoding.data();
+        view.encodingSize = static_cast<int32_t>(face.encoding.size());
+        view.embeddingModel = face.embeddingModel.c_str();
+        view.embeddings = face.embeddings.empty() ? nullptr : holder->embeddingViews.data() + holder->embeddingViews.size();
+        view.embeddingCount = static_cast<int32_t>(face.embeddings.size());
+        for (const auto& entry : face.embeddings) {
+            holder->embeddingViews.push_back({entry.first.c_str(), entry.second.data(), static_cast<int32_t>(entry.second.size())});
+        }
+        holder->faceViews.push_back(view);
+    }
+
+    holder->frameId = frameId;
+    holder->cameraId = cameraId;
+    holder->status = status != FD_OK ? status : (r.cancelled ? FD_ERR_CANCELLED : r.success ? FD_OK : FD_ERR_INTERNAL);
+    holder->error = r.error.c_str();
+    holder->processingTimeMs = r.processingTimeMs;
+    holder->faces = holder->faceViews.empty() ? nullptr : holder->faceViews.data();
+    holder->faceCount = static_cast<int32_t>(holder->faceViews.size());
+    return holder;
+}
+
+static DetectionResult failedDetection(const char* error) {
+    DetectionResult result;
+    result.success = false;
+    result.error = error;
+    result.processingTimeMs = 0;
+    return result;
+}
+
+// Decodes and detects one encoded frame; `status` reports decode failures separately from detector errors
+static DetectionResult detectEncoded(FaceDetector& core, const uint8_t* data, size_t length,
+                                     const DetectionOptions& options, int& status) {
+    cv::Mat frame;
+    try {
+        StageProfiler::Scope scope(core.profiler(), ProfileStage::Decode);
+        frame = cv::imdecode(cv::Mat(1, static_cast<int>(length), CV_8U, const_cast<uint8_t*>(data)), cv::IMREAD_COLOR);
+    } catch (const std::exception& e) {
+        std::cerr << "Frame decode failed: " << e.what() << std::endl;
+    }
+    if (frame.empty()) {
+        status = FD_ERR_DECODE;
+        return failedDetection("Failed to decode image from buffer");
+    }
+    status = FD_OK;
+    return core.detectFaces(frame, options);
+}
+
+// Converts caller pixels to the BGR frame the detector expects; `copy` forces an owned buffer
+static cv::Mat wrapRaw(const uint8_t* pixels, int width, int height, size_t stride, fd_pixel_format format, bool copy) {
+    int type = CV_8UC3;
+    int code = -1;
+    switch (format) {
+        case FD_PIXEL_BGR24: type = CV_8UC3; break;
+        case FD_PIXEL_RGB24: type = CV_8UC3; code = cv::COLOR_RGB2BGR; break;
+        case FD_PIXEL_BGRA32: type = CV_8UC4; code = cv::COLOR_BGRA2BGR; break;
+        case FD_PIXEL_RGBA32: type = CV_8UC4; code = cv::COLOR_RGBA2BGR; break;
+        case FD_PIXEL_GRAY8: type = CV_8UC1; code = cv::COLOR_GRAY2BGR; break;
+        default: return cv::Mat();
+    }
+    cv::Mat view(height, width, type, const_cast<uint8_t*>(pixels), stride);
+    if (code < 0) {
+        return copy ? view.clone() : view;
+    }
+    cv::Mat bgr;
+    cv::cvtColor(view, bgr, code);
+    return bgr;
+}
+
+static bool validRaw(const uint8_t* pixels, int width, int height, size_t stride, fd_pixel_format format) {
+    if (!pixels || width <= 0 || height <= 0) return false;
+    size_t bytesPerPixel = format == FD_PIXEL_GRAY8 ? 1 : (format == FD_PIXEL_BGRA32 || format == FD_PIXEL_RGBA32) ? 4 : 3;
+    return stride >= bytesPerPixel * static_cast<size_t>(width);
+}
+
+// Completion of a submitted frame: update stats, then hand the result to the callback or the poll queue
+static void deliver(fd_detector* detector, fd_result* result) {
+    fd_result_callback callback;
+    void* userData;
+    {
+        std::lock_guard<std::mutex> lock(detector->mutex);
+        detector->completedCount++;
+        if (result->status == FD_ERR_CANCELLED) detector->cancelled++;
+        else if (result->status != FD_OK) detector->failed++;
+        detector->facesDetected += static_cast<uint64_t>(result->faceCount);
+        double ms = static_cast<double>(result->processingTimeMs);
+        detector->totalProcessingMs += ms;
+        detector->maxProcessingMs = std::max(detector->maxProcessingMs, ms);
+
+        callback = detector->callback;
+        userData = detector->userData;
+        if (!callback) {
+            if (detector->completed.size() >= detector->maxQueued) {
+                fd_result_free(detector->completed.front());
+                detector->completed.pop_front();
+                detector->dropped++;
+            }
+            detector->completed.push_back(result);
+            detector->resultReady.notify_one();
+        }
+    }
+
+    if (callback) {
+        callback(result, userData);
+    }
+
+    // Last: fd_destroy may free the detector as soon as pending reaches zero
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    detector->pending--;
+    if (detector->pending == 0) {
+        detector->drained.notify_all();
+    }
+}
+
+// Reserves a pending slot and registers the submitted job, or refuses it when too many are in flight.
+// The job's input must be in place: once registered, fd_cancel may dequeue it from another thread.
+static int admit(fd_detector* detector, const fd_detect_options& options, const std::shared_ptr<Job>& job) {
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    if (detector->pending >= detector->maxPending) {
+        detector->rejected++;
+        return FD_ERR_BUSY;
+    }
+    detector->pending++;
+    detector->submitted++;
+    job->id = detector->nextFrameId++;
+    job->cameraId = options.cameraId;
+    job->eventId = options.eventId;
+    job->submitted = true;
+    detector->jobs[job->id] = job;
+    return FD_OK;
+}
+
+static void finishJob(fd_detector* detector, uint64_t id) {
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    detector->jobs.erase(id);
+}
+
+// Runs a synchronous call as a reserved job; unregisters it when the call returns
+class ReservedJob {
+public:
+    ReservedJob(fd_detector* detector, uint64_t id) : detector(detector), id(id) {
+        if (id == 0) return;
+        std::lock_guard<std::mutex> lock(detector->mutex);
+        auto it = detector->jobs.find(id);
+        if (it != detector->jobs.end() && it->second->begin()) {
+            job = it->second;
+        }
+    }
+    ~ReservedJob() {
+        if (job) finishJob(detector, id);
+    }
+
+    // An id was given but the job is unknown or was cancelled before it started
+    bool cancelled() const { return id != 0 && !job; }
+    const Job* get() const { return job.get(); }
+
+private:
+    fd_detector* detector;
+    uint64_t id;
+    std::shared_ptr<Job> job;
+};
+
+static DetectionResult cancelledDetection() {
+    DetectionResult result = failedDetection("Cancelled");
+    result.cancelled = true;
+    return result;
+}
+
+extern "C" {
+
+int fd_api_version(void) {
+    return FD_API_VERSION;
+}
+
+fd_detector* fd_create(void) {
+    return new (std::nothrow) fd_detector();
+}
+
+void fd_destroy(fd_detector* detector) {
+    if (!detector) return;
+    {
+        std::unique_lock<std::mutex> lock(detector->mutex);
+        detector->drained.wait(lock, [detector] { return detector->pending == 0; });
+        for (fd_result* result : detector->completed) {
+            fd_result_free(result);
+        }
+        detector->completed.clear();
+    }
+    delete detector;
+}
+
+int fd_initialize(fd_detector* detector, const char* modelPath, int useDeepLearning) {
+    fd_init_options options;
+    fd_init_options_init(&options);
+    options.useDeepLearning = useDeepLearning;
+    return fd_initialize_ex(detector, modelPath, &options);
+}
+
+void fd_init_options_init(fd_init_options* options) {
+    if (!options) return;
+    std::memset(options, 0, sizeof(*options));
+    options->structSize = sizeof(*options);
+    options->useDeepLearning = 1;
+}
+
+int fd_initialize_ex(fd_detector* detector, const char* modelPath, const fd_init_options* options) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    fd_init_options defaults;
+    fd_init_options_init(&defaults);
+    fd_init_options in = readVersioned(options, defaults);
+    try {
+        return detector->core.initialize(modelPath ? modelPath : "", in.useDeepLearning != 0, in.deferRecognition != 0)
+            ? FD_OK : FD_ERR_NOT_INITIALIZED;
+    } catch (const std::exception& e) {
+        std::cerr << "Detector initialization failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+int fd_is_initialized(const fd_detector* detector) {
+    return detector && detector->core.isInitialized() ? 1 : 0;
+}
+
+int fd_is_recognition_ready(const fd_detector* detector) {
+    return detector && detector->core.isRecognitionReady() ? 1 : 0;
+}
+
+int fd_set_confidence_threshold(fd_detector* detector, float threshold) {
+    if (!detector || threshold < 0.0f || threshold > 1.0f) return FD_ERR_INVALID_ARGUMENT;
+    detector->core.setConfidenceThreshold(threshold);
+    return FD_OK;
+}
+
+int fd_warm_up(fd_detector* detector, int width, int height, int concurrency) {
+    if (!detector || width <= 0 || height <= 0 || concurrency <= 0) return FD_ERR_INVALID_ARGUMENT;
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+    return detector->core.warmUp(cv::Size(width, height), concurrency) < 0 ? FD_ERR_INTERNAL : FD_OK;
+}
+
+void fd_detect_options_init(fd_detect_options* options) {
+    if (!options) return;
+    std::memset(options, 0, sizeof(*options));
+    options->structSize = sizeof(*options);
+    options->cameraId = -1;
+    options->eventId = -1;
+    options->organizationId = -1;
+}
+
+int fd_detect_encoded(fd_detector* detector, const uint8_t* data, size_t length,
+                      const fd_detect_options* options, fd_result** result) {
+    if (!detector || !data || length == 0 || !result) return FD_ERR_INVALID_ARGUMENT;
+
+    fd_detect_options in = readDetectOptions(options);
+    ReservedJob job(detector, in.jobId);
+    if (job.cancelled()) {
+        *result = makeResult(cancelledDetection(), FD_ERR_CANCELLED, in.jobId, in.cameraId);
+        return FD_ERR_CANCELLED;
+    }
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+
+    DetectionOptions detectionOptions = toDetectionOptions(detector, in, job.get());
+    int status = FD_OK;
+    DetectionResult detection = detectEncoded(detector->core, data, length, detectionOptions, status);
+    *result = makeResult(std::move(detection), status, in.jobId, detectionOptions.cameraId);
+    return (*result)->status;
+}
+
+int fd_detect_raw(fd_detector* detector, const uint8_t* pixels, int width, int height, size_t stride,
+                  fd_pixel_format format, const fd_detect_options* options, fd_result** result) {
+    if (!detector || !result || !validRaw(pixels, width, height, stride, format)) return FD_ERR_INVALID_ARGUMENT;
+
+    fd_detect_options in = readDetectOptions(options);
+    ReservedJob job(detector, in.jobId);
+    if (job.cancelled()) {
+        *result = makeResult(cancelledDetection(), FD_ERR_CANCELLED, in.jobId, in.cameraId);
+        return FD_ERR_CANCELLED;
+    }
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+
+    DetectionOptions detectionOptions = toDetectionOptions(detector, in, job.get());
+    cv::Mat frame = wrapRaw(pixels, width, height, stride, format, false);
+    *result = makeResult(detector->core.detectFaces(frame, detectionOptions), FD_OK, in.jobId, detectionOptions.cameraId);
+    return (*result)->status;
+}
+
+int fd_embed_encoded(fd_detector* detector, const uint8_t* data, size_t length, const fd_rect* box,
+                     const fd_detect_options* options, fd_result** result) {
+    if (!detector || !data || length == 0 || !box || box->width <= 0 || box->height <= 0 || !result) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+
+    fd_detect_options in = readDetectOptions(options);
+    ReservedJob job(detector, in.jobId);
+    if (job.cancelled()) {
+        *result = makeResult(cancelledDetection(), FD_ERR_CANCELLED, in.jobId, in.cameraId);
+        return FD_ERR_CANCELLED;
+    }
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+
+    cv::Rect faceRect(box->x, box->y, box->width, box->height);
+    cv::Mat region;
+    RegionDecodeInfo info;
+    if (!decodeImageRegion(data, length, faceRect, region, info)) {
+        *result = makeResult(failedDetection("Failed to decode the face region"), FD_ERR_DECODE, in.jobId, in.cameraId);
+        return FD_ERR_DECODE;
+    }
+
+    // Embed in region coordinates, then report the box in image coordinates
+    DetectionOptions detectionOptions = toDetectionOptions(detector, in, job.get());
+    DetectionResult detection = detector->core.embedFace(region, faceRect - info.decoded.tl(), detectionOptions);
+    for (DetectedFace& face : detection.faces) {
+        face.boundingBox = face.boundingBox + info.decoded.tl();
+    }
+    *result = makeResult(std::move(detection), FD_OK, in.jobId, detectionOptions.cameraId);
+    return (*result)->status;
+}
+
+void fd_result_free(fd_result* result) {
+    delete static_cast<ResultHolder*>(result);
+}
+
+int fd_set_result_callback(fd_detector* detector, fd_result_callback callback, void* userData) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    detector->callback = callback;
+    detector->userData = userData;
+    return FD_OK;
+}
+
+int fd_set_max_pending(fd_detector* detector, uint32_t maxPending, uint32_t maxQueued) {
+    if (!detector || maxPending == 0 || maxQueued == 0) return FD_ERR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    detector->maxPending = maxPending;
+    detector->maxQueued = maxQueued;
+    return FD_OK;
+}
+
+int fd_submit_encoded(fd_detector* detector, const uint8_t* data, size_t length,
+                      const fd_detect_options* options, uint64_t* frameId) {
+    if (!detector || !data || length == 0) return FD_ERR_INVALID_ARGUMENT;
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+
+    fd_detect_options in = readDetectOptions(options);
+    auto job = std::make_shared<Job>();
+    job->encoded.assign(data, data + length);
+    int status = admit(detector, in, job);
+    if (status != FD_OK) return status;
+    if (frameId) *frameId = job->id;
+
+    DetectionOptions detectionOptions = toDetectionOptions(detector, in, job.get());
+    detector->core.runAsync([detector, job, detectionOptions]() {
+        if (!job->begin()) return; // Cancelled while queued; fd_cancel already delivered its result
+        int decodeStatus = FD_OK;
+        DetectionResult detection = detectEncoded(detector->core, job->encoded.data(), job->encoded.size(), detectionOptions, decodeStatus);
+        finishJob(detector, job->id);
+        deliver(detector, makeResult(std::move(detection), decodeStatus, job->id, job->cameraId));
+    });
+    return FD_OK;
+}
+
+int fd_submit_raw(fd_detector* detector, const uint8_t* pixels, int width, int height, size_t stride,
+                  fd_pixel_format format, const fd_detect_options* options, uint64_t* frameId) {
+    if (!detector || !validRaw(pixels, width, height, stride, format)) return FD_ERR_INVALID_ARGUMENT;
+    if (!detector->core.isInitialized()) return FD_ERR_NOT_INITIALIZED;
+
+    fd_detect_options in = readDetectOptions(options);
+    auto job = std::make_shared<Job>();
+    job->frame = wrapRaw(pixels, width, height, stride, format, true);
+    int status = admit(detector, in, job);
+    if (status != FD_OK) return status;
+    if (frameId) *frameId = job->id;
+
+    DetectionOptions detectionOptions = toDetectionOptions(detector, in, job.get());
+    detector->core.runAsync([detector, job, detectionOptions]() {
+        if (!job->begin()) return; // Cancelled while queued; fd_cancel already delivered its result
+        DetectionResult detection = detector->core.detectFaces(job->frame, detectionOptions);
+        finishJob(detector, job->id);
+        deliver(detector, makeResult(std::move(detection), FD_OK, job->id, job->cameraId));
+    });
+    return FD_OK;
+}
+
+int fd_poll(fd_detector* detector, int timeoutMs, fd_result** result) {
+    if (!detector || !result) return FD_ERR_INVALID_ARGUMENT;
+    std::unique_lock<std::mutex> lock(detector->mutex);
+    if (detector->completed.empty() && timeoutMs > 0) {
+        detector->resultReady.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                       [detector] { return !detector->completed.empty(); });
+    }
+    if (detector->completed.empty()) {
+        *result = nullptr;
+        return 0;
+    }
+    *result = detector->completed.front();
+    detector->completed.pop_front();
+    return 1;
+}
+
+int fd_reserve_job(fd_detector* detector, const fd_detect_options* options, uint64_t* jobId) {
+    if (!detector || !jobId) return FD_ERR_INVALID_ARGUMENT;
+    fd_detect_options in = readDetectOptions(options);
+    auto job = std::make_shared<Job>();
+    job->cameraId = in.cameraId;
+    job->eventId = in.eventId;
+
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    job->id = detector->nextFrameId++;
+    detector->jobs[job->id] = job;
+    *jobId = job->id;
+    return FD_OK;
+}
+
+int fd_release_job(fd_detector* detector, uint64_t jobId) {
+    if (!detector || jobId == 0) return 0;
+    std::lock_guard<std::mutex> lock(detector->mutex);
+    auto it = detector->jobs.find(jobId);
+    if (it == detector->jobs.end() || it->second->submitted) return 0;
+    int expected = Job::Queued;
+    if (!it->second->state.compare_exchange_strong(expected, Job::Cancelled)) return 0;
+    detector->jobs.erase(it);
+    return 1;
+}
+
+void fd_cancel_filter_init(fd_cancel_filter* filter) {
+    if (!filter) return;
+    std::memset(filter, 0, sizeof(*filter));
+    filter->structSize = sizeof(*filter);
+    filter->cameraId = -1;
+    filter->eventId = -1;
+}
+
+int fd_cancel(fd_detector* detector, const fd_cancel_filter* filter) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    fd_cancel_filter defaults;
+    fd_cancel_filter_init(&defaults);
+    fd_cancel_filter in = readVersioned(filter, defaults);
+    if (in.jobId == 0 && in.cameraId < 0 && in.eventId < 0) return FD_ERR_INVALID_ARGUMENT;
+
+    int count = 0;
+    std::vector<std::shared_ptr<Job>> dequeued; // Submitted jobs that never started
+    {
+        std::lock_guard<std::mutex> lock(detector->mutex);
+        for (auto it = detector->jobs.begin(); it != detector->jobs.end();) {
+            Job& job = *it->second;
+            bool matches = (in.jobId == 0 || job.id == in.jobId) &&
+                           (in.cameraId < 0 || job.cameraId == in.cameraId) &&
+                           (in.eventId < 0 || job.eventId == in.eventId);
+            if (!matches || job.cancelled.exchange(true)) {
+                ++it;
+                continue;
+            }
+            count++;
+            int expected = Job::Queued;
+            if (!job.state.compare_exchange_strong(expected, Job::Cancelled)) {
+                ++it; // Running: stops at its next stage and unregisters itself
+                continue;
+            }
+            if (job.submitted) {
+                dequeued.push_back(it->second);
+            }
+            it = detector->jobs.erase(it);
+        }
+    }
+
+    // Outside the lock: deliver() runs the result callback
+    for (const std::shared_ptr<Job>& job : dequeued) {
+        job->encoded = std::vector<uint8_t>();
+        job->frame.release();
+        deliver(detector, makeResult(cancelledDetection(), FD_ERR_CANCELLED, job->id, job->cameraId));
+    }
+    if (count > 0) {
+        std::cout << "Cancelled " << count << " detection job(s) (" << dequeued.size() << " dequeued)" << std::endl;
+    }
+    return count;
+}
+
+void fd_stats_init(fd_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_get_stats(fd_detector* detector, fd_stats* stats) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    fd_stats snapshot;
+    fd_stats_init(&snapshot);
+    {
+        std::lock_guard<std::mutex> lock(detector->mutex);
+        snapshot.submitted = detector->submitted;
+        snapshot.cancelled = detector->cancelled;
+        snapshot.completed = detector->completedCount;
+        snapshot.failed = detector->failed;
+        snapshot.rejected = detector->rejected;
+        snapshot.dropped = detector->dropped;
+        snapshot.pending = detector->pending;
+        snapshot.queued = detector->completed.size();
+        snapshot.facesDetected = detector->facesDetected;
+        snapshot.avgProcessingMs = detector->completedCount > 0 ? detector->totalProcessingMs / detector->completedCount : 0.0;
+        snapshot.maxProcessingMs = detector->maxProcessingMs;
+    }
+    return writeVersioned(stats, snapshot);
+}
+
+void fd_tier_policy_init(fd_tier_policy* policy) {
+    if (!policy) return;
+    EmbeddingTierPolicy::Config defaults;
+    std::memset(policy, 0, sizeof(*policy));
+    policy->structSize = sizeof(*policy);
+    policy->highLoad = defaults.highLoad;
+    policy->criticalLoad = defaults.criticalLoad;
+    policy->lowQuality = defaults.lowQuality;
+    policy->minDwellMs = defaults.minDwellMs;
+    policy->latencyBudgetMs = defaults.latencyBudgetMs;
+}
+
+int fd_get_tier_policy(fd_detector* detector, fd_tier_policy* policy) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    EmbeddingTierPolicy::Config config = detector->core.tierPolicy().getConfig();
+    fd_tier_policy out;
+    fd_tier_policy_init(&out);
+    out.highLoad = config.highLoad;
+    out.criticalLoad = config.criticalLoad;
+    out.lowQuality = config.lowQuality;
+    out.minDwellMs = config.minDwellMs;
+    out.latencyBudgetMs = config.latencyBudgetMs;
+    return writeVersioned(policy, out);
+}
+
+int fd_set_tier_policy(fd_detector* detector, const fd_tier_policy* policy) {
+    if (!detector || !policy) return FD_ERR_INVALID_ARGUMENT;
+    fd_tier_policy current;
+    current.structSize = sizeof(current);
+    fd_get_tier_policy(detector, &current);
+    fd_tier_policy in = readVersioned(policy, current);
+
+    EmbeddingTierPolicy::Config config;
+    config.highLoad = in.highLoad;
+    config.criticalLoad = in.criticalLoad;
+    config.lowQuality = in.lowQuality;
+    config.minDwellMs = in.minDwellMs;
+    config.latencyBudgetMs = in.latencyBudgetMs;
+    detector->core.tierPolicy().setConfig(config);
+    return FD_OK;
+}
+
+int fd_pin_camera_tier(fd_detector* detector, int cameraId, const char* tierName) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int tier = -1;
+    if (tierName) {
+        tier = embeddingTierFromName(tierName);
+        if (tier < 0) return FD_ERR_INVALID_ARGUMENT;
+    }
+    detector->core.tierPolicy().pinTier(cameraId, tier);
+    return FD_OK;
+}
+
+void fd_cascade_config_init(fd_cascade_config* config) {
+    if (!config) return;
+    DetectionCascade::Config defaults;
+    std::memset(config, 0, sizeof(*config));
+    config->structSize = sizeof(*config);
+    config->enabled = defaults.enabled ? 1 : 0;
+    config->thumbnailWidth = defaults.thumbnailWidth;
+    config->minNeighbors = defaults.minNeighbors;
+    config->refreshFrames = defaults.refreshFrames;
+    config->refreshMs = defaults.refreshMs;
+    config->holdFrames = defaults.holdFrames;
+}
+
+int fd_get_cascade_config(fd_detector* detector, int cameraId, fd_cascade_config* config) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    DetectionCascade& cascade = detector->core.cascade();
+    DetectionCascade::Config current = cameraId < 0 ? cascade.getConfig() : cascade.configFor(cameraId);
+    fd_cascade_config out;
+    fd_cascade_config_init(&out);
+    out.enabled = current.enabled ? 1 : 0;
+    out.thumbnailWidth = current.thumbnailWidth;
+    out.minNeighbors = current.minNeighbors;
+    out.refreshFrames = current.refreshFrames;
+    out.refreshMs = current.refreshMs;
+    out.holdFrames = current.holdFrames;
+    return writeVersioned(config, out);
+}
+
+int fd_set_cascade_config(fd_detector* detector, int cameraId, const fd_cascade_config* config) {
+    if (!detector || !config) return FD_ERR_INVALID_ARGUMENT;
+    fd_cascade_config current;
+    current.structSize = sizeof(current);
+    fd_get_cascade_config(detector, cameraId, &current);
+    fd_cascade_config in = readVersioned(config, current);
+    if (in.thumbnailWidth < 0 || in.minNeighbors < 0 || in.refreshFrames < 0 || in.refreshMs < 0 || in.holdFrames < 0) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+
+    DetectionCascade::Config next;
+    next.enabled = in.enabled != 0;
+    next.thumbnailWidth = in.thumbnailWidth;
+    next.minNeighbors = in.minNeighbors;
+    next.refreshFrames = in.refreshFrames;
+    next.refreshMs = in.refreshMs;
+    next.holdFrames = in.holdFrames;
+    if (cameraId < 0) {
+        detector->core.cascade().setConfig(next);
+    } else {
+        detector->core.cascade().setCameraConfig(cameraId, next);
+    }
+    return FD_OK;
+}
+
+int fd_clear_cascade_config(fd_detector* detector, int cameraId) {
+    if (!detector || cameraId < 0) return FD_ERR_INVALID_ARGUMENT;
+    detector->core.cascade().clearCameraConfig(cameraId);
+    return FD_OK;
+}
+
+void fd_low_power_config_init(fd_low_power_config* config) {
+    if (!config) return;
+    LowPowerDetector::Config defaults;
+    std::memset(config, 0, sizeof(*config));
+    config->structSize = sizeof(*config);
+    config->processWidth = defaults.processWidth;
+    config->scaleFactor = static_cast<float>(defaults.scaleFactor);
+    config->minNeighbors = defaults.minNeighbors;
+    config->minFaceSize = defaults.minFaceSize;
+    config->scaleBands = defaults.scaleBands;
+    config->roiReuse = defaults.roiReuse ? 1 : 0;
+    config->fullScanFrames = defaults.fullScanFrames;
+    config->roiMargin = static_cast<float>(defaults.roiMargin);
+}
+
+int fd_get_low_power_config(fd_detector* detector, fd_low_power_config* config) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    LowPowerDetector::Config current = detector->core.lowPower().getConfig();
+    fd_low_power_config out;
+    fd_low_power_config_init(&out);
+    out.processWidth = current.processWidth;
+    out.scaleFactor = static_cast<float>(current.scaleFactor);
+    out.minNeighbors = current.minNeighbors;
+    out.minFaceSize = current.minFaceSize;
+    out.scaleBands = current.scaleBands;
+    out.roiReuse = current.roiReuse ? 1 : 0;
+    out.fullScanFrames = current.fullScanFrames;
+    out.roiMargin = static_cast<float>(current.roiMargin);
+    return writeVersioned(config, out);
+}
+
+int fd_set_low_power_config(fd_detector* detector, const fd_low_power_config* config) {
+    if (!detector || !config) return FD_ERR_INVALID_ARGUMENT;
+    fd_low_power_config current;
+    current.structSize = sizeof(current);
+    fd_get_low_power_config(detector, &current);
+    fd_low_power_config in = readVersioned(config, current);
+    if (in.processWidth < 0 || !(in.scaleFactor > 1.0f) || in.minNeighbors < 0 || in.minFaceSize < 0 ||
+        in.scaleBands < 0 || in.fullScanFrames < 0 || in.roiMargin < 0.0f) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+
+    LowPowerDetector::Config next;
+    next.processWidth = in.processWidth;
+    next.scaleFactor = in.scaleFactor;
+    next.minNeighbors = in.minNeighbors;
+    next.minFaceSize = in.minFaceSize;
+    next.scaleBands = in.scaleBands;
+    next.roiReuse = in.roiReuse != 0;
+    next.fullScanFrames = in.fullScanFrames;
+    next.roiMargin = in.roiMargin;
+    detector->core.lowPower().setConfig(next);
+    return FD_OK;
+}
+
+void fd_sampling_config_init(fd_sampling_config* config) {
+    if (!config) return;
+    SamplingController::Config defaults;
+    std::memset(config, 0, sizeof(*config));
+    config->structSize = sizeof(*config);
+    config->minIntervalMs = defaults.minIntervalMs;
+    config->maxIntervalMs = defaults.maxIntervalMs;
+    config->idleHalfLifeMs = defaults.idleHalfLifeMs;
+    config->motionThreshold = defaults.motionThreshold;
+}
+
+int fd_get_sampling_config(fd_detector* detector, int cameraId, fd_sampling_config* config) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    SamplingController& sampling = detector->core.sampling();
+    SamplingController::Config current = cameraId < 0 ? sampling.getConfig() : sampling.configFor(cameraId);
+    fd_sampling_config out;
+    fd_sampling_config_init(&out);
+    out.minIntervalMs = current.minIntervalMs;
+    out.maxIntervalMs = current.maxIntervalMs;
+    out.idleHalfLifeMs = current.idleHalfLifeMs;
+    out.motionThreshold = current.motionThreshold;
+    return writeVersioned(config, out);
+}
+
+int fd_set_sampling_config(fd_detector* detector, int cameraId, const fd_sampling_config* config) {
+    if (!detector || !config) return FD_ERR_INVALID_ARGUMENT;
+    fd_sampling_config current;
+    current.structSize = sizeof(current);
+    fd_get_sampling_config(detector, cameraId, &current);
+    fd_sampling_config in = readVersioned(config, current);
+    if (in.minIntervalMs <= 0 || in.maxIntervalMs < in.minIntervalMs || in.idleHalfLifeMs < 0 || in.motionThreshold <= 0.0f) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+
+    SamplingController::Config next;
+    next.minIntervalMs = in.minIntervalMs;
+    next.maxIntervalMs = in.maxIntervalMs;
+    next.idleHalfLifeMs = in.idleHalfLifeMs;
+    next.motionThreshold = in.motionThreshold;
+    if (cameraId < 0) {
+        detector->core.sampling().setConfig(next);
+    } else {
+        detector->core.sampling().setCameraConfig(cameraId, next);
+    }
+    return FD_OK;
+}
+
+int fd_clear_sampling_config(fd_detector* detector, int cameraId) {
+    if (!detector || cameraId < 0) return FD_ERR_INVALID_ARGUMENT;
+    detector->core.sampling().clearCameraConfig(cameraId);
+    return FD_OK;
+}
+
+int fd_set_sampling_budget(fd_detector* detector, float cpuBudget) {
+    if (!detector || !(cpuBudget > 0.0f)) return FD_ERR_INVALID_ARGUMENT;
+    detector->core.sampling().setCpuBudget(cpuBudget);
+    return FD_OK;
+}
+
+float fd_get_sampling_budget(fd_detector* detector) {
+    return detector ? detector->core.sampling().getCpuBudget() : 0.0f;
+}
+
+double fd_get_sampling_interval(fd_detector* detector, int cameraId) {
+    if (!detector) return 0.0;
+    return detector->core.sampling().intervalMs(cameraId);
+}
+
+int fd_tier_count(void) {
+    return kEmbeddingTierCount;
+}
+
+const char* fd_tier_name(int tier) {
+    if (tier < 0 || tier >= kEmbeddingTierCount) return "";
+    return embeddingTierName(static_cast<EmbeddingTier>(tier));
+}
+
+int fd_get_models(fd_detector* detector, fd_model_info* models, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int count = 0;
+    for (const EmbeddingModelInfo& model : detector->core.getEmbeddingModels()) {
+        if (!model.loaded) continue;
+        if (models && count < capacity) {
+            fd_model_info& out = models[count];
+            copyString(out.name, model.name);
+            copyString(out.version, model.version);
+            out.inputWidth = model.inputSize.width;
+            out.inputHeight = model.inputSize.height;
+        }
+        count++;
+    }
+    return count;
+}
+
+int fd_get_model_load_times(fd_detector* detector, fd_model_load* models, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    std::vector<ModelLoadTiming> timings = detector->core.getModelLoadTimings();
+    for (int i = 0; models && i < capacity && i < static_cast<int>(timings.size()); i++) {
+        fd_model_load& out = models[i];
+        std::memset(&out, 0, sizeof(out));
+        copyString(out.name, timings[i].name);
+        copyString(out.role, timings[i].role);
+        out.loadMs = timings[i].loadMs;
+        out.sizeBytes = timings[i].sizeBytes;
+        out.reused = timings[i].reused ? 1 : 0;
+        out.deferred = timings[i].deferred ? 1 : 0;
+    }
+    return static_cast<int>(timings.size());
+}
+
+int fd_get_camera_tier_stats(fd_detector* detector, fd_camera_tier_stats* cameras, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int count = 0;
+    for (const auto& entry : detector->core.tierPolicy().snapshot()) {
+        if (cameras && count < capacity) {
+            const EmbeddingTierPolicy::CameraStats& stats = entry.second;
+            fd_camera_tier_stats& out = cameras[count];
+            std::memset(&out, 0, sizeof(out));
+            out.cameraId = entry.first;
+            out.tier = stats.tier;
+            out.pinned = stats.pinnedTier >= 0 ? 1 : 0;
+            out.load = stats.load;
+            out.avgLatencyMs = stats.avgLatencyMs;
+            for (int i = 0; i < kEmbeddingTierCount && i < FD_MAX_TIERS; i++) {
+                out.selections[i] = stats.selections[i];
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+int fd_get_camera_cascade_stats(fd_detector* detector, fd_camera_cascade_stats* cameras, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int count = 0;
+    for (const auto& entry : detector->core.cascade().snapshot()) {
+        if (cameras && count < capacity) {
+            const DetectionCascade::CameraStats& stats = entry.second;
+            fd_camera_cascade_stats& out = cameras[count];
+            std::memset(&out, 0, sizeof(out));
+            out.cameraId = entry.first;
+            out.overridden = stats.overridden ? 1 : 0;
+            out.frames = stats.frames;
+            out.prefilterFires = stats.prefilterFires;
+            out.fullRuns = stats.fullRuns;
+            out.holdRuns = stats.holdRuns;
+            out.refreshRuns = stats.refreshRuns;
+            out.fullHits = stats.fullHits;
+            out.refreshHits = stats.refreshHits;
+            out.avgPrefilterMs = stats.avgPrefilterMs;
+            out.avgFullMs = stats.avgFullMs;
+        }
+        count++;
+    }
+    return count;
+}
+
+int fd_get_camera_sampling_stats(fd_detector* detector, fd_camera_sampling_stats* cameras, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int count = 0;
+    for (const auto& entry : detector->core.sampling().snapshot()) {
+        if (cameras && count < capacity) {
+            const SamplingController::CameraStats& stats = entry.second;
+            fd_camera_sampling_stats& out = cameras[count];
+            std::memset(&out, 0, sizeof(out));
+            out.cameraId = entry.first;
+            out.overridden = stats.overridden ? 1 : 0;
+            out.intervalMs = stats.intervalMs;
+            out.desiredIntervalMs = stats.desiredIntervalMs;
+            out.activity = stats.activity;
+            out.motion = stats.motion;
+            out.faces = stats.faces;
+            out.budgetLimited = stats.budgetLimited ? 1 : 0;
+            out.avgProcessingMs = stats.avgProcessingMs;
+            out.frames = stats.frames;
+        }
+        count++;
+    }
+    return count;
+}
+
+int fd_get_camera_low_power_stats(fd_detector* detector, fd_camera_low_power_stats* cameras, int capacity) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    int count = 0;
+    for (const auto& entry : detector->core.lowPower().snapshot()) {
+        if (cameras && count < capacity) {
+            const LowPowerDetector::CameraStats& stats = entry.second;
+            fd_camera_low_power_stats& out = cameras[count];
+            std::memset(&out, 0, sizeof(out));
+            out.cameraId = entry.first;
+            out.trackedFaces = static_cast<int32_t>(stats.trackedFaces);
+            out.frames = stats.frames;
+            out.fullScans = stats.fullScans;
+            out.roiScans = stats.roiScans;
+            out.roiMisses = stats.roiMisses;
+            out.avgScanMs = stats.avgScanMs;
+        }
+        count++;
+    }
+    return count;
+}
+
+void fd_runtime_stats_init(fd_runtime_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_get_runtime_stats(fd_runtime_stats* stats) {
+    SharedRuntimeStats shared = sharedRuntimeStats();
+    fd_runtime_stats out;
+    fd_runtime_stats_init(&out);
+    out.sharedModels = static_cast<uint32_t>(shared.sharedModels);
+    out.netReplicas = static_cast<uint32_t>(shared.netReplicas);
+    out.modelBytes = shared.modelBytes;
+    out.executorThreads = static_cast<uint32_t>(shared.executorThreads);
+    out.executorUsers = static_cast<uint32_t>(std::max(0L, shared.executorUsers));
+    out.netReplicaLimit = static_cast<uint32_t>(shared.netReplicaLimit);
+    out.replicaBytes = shared.replicaBytes;
+    out.heapBytes = shared.heapBytes;
+    return writeVersioned(stats, out);
+}
+
+void fd_capabilities_init(fd_capabilities* capabilities) {
+    if (!capabilities) return;
+    std::memset(capabilities, 0, sizeof(*capabilities));
+    capabilities->structSize = sizeof(*capabilities);
+}
+
+int fd_get_capabilities(fd_detector* detector, fd_capabilities* capabilities) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    fd_capabilities out;
+    fd_capabilities_init(&out);
+
+    copyString(out.isa, cpuIsaName(simd::kernels().isa));
+    copyString(out.cpuFeatures, joinNames(cpuFeatureNames(cpuFeatures())));
+    std::vector<std::string> compiled;
+    for (CpuIsa isa : simd::compiledIsas()) {
+        compiled.push_back(cpuIsaName(isa));
+    }
+    copyString(out.compiledIsas, joinNames(compiled));
+    copyString(out.opencvVersion, CV_VERSION);
+    copyString(out.detector, detector->core.getDetectorName());
+    out.partialJpegDecode = partialJpegDecodeAvailable() ? 1 : 0;
+    out.cascadePrefilter = detector->core.isPrefilterAvailable() ? 1 : 0;
+    out.lowPower = detector->core.isLowPowerActive() ? 1 : 0;
+    return writeVersioned(capabilities, out);
+}
+
+int fd_profile_start(fd_detector* detector) {
+    if (!detector) return FD_ERR_INVALID_ARGUMENT;
+    return detector->core.profiler().start() ? FD_OK : FD_ERR_BUSY;
+}
+
+void fd_profile_report_init(fd_profile_report* report) {
+    if (!report) return;
+    std::memset(report, 0, sizeof(*report));
+    report->structSize = sizeof(*report);
+}
+
+int fd_profile_stop(fd_detector* detector, fd_profile_report* report) {
+    if (!detector || !report || report->structSize < sizeof(uint32_t)) return FD_ERR_INVALID_ARGUMENT;
+    StageProfiler::Report profile;
+    if (!detector->core.profiler().stop(profile)) return FD_ERR_INVALID_ARGUMENT;
+
+    fd_profile_report out;
+    fd_profile_report_init(&out);
+    out.countersAvailable = profile.countersAvailable ? 1 : 0;
+    copyString(out.unavailableReason, profile.unavailableReason);
+    out.durationMs = profile.durationMs;
+    out.stageCount = std::min(kProfileStageCount, FD_MAX_PROFILE_STAGES);
+    for (int i = 0; i < out.stageCount; i++) {
+        const StageProfiler::StageStats& stats = profile.stages[i];
+        fd_stage_profile& stage = out.stages[i];
+        copyString(stage.stage, profileStageName(static_cast<ProfileStage>(i)));
+        stage.calls = stats.calls;
+        stage.countedCalls = stats.countedCalls;
+        stage.wallMs = stats.wallMs;
+        stage.cycles = stats.cycles;
+        stage.instructions = stats.instructions;
+        stage.llcReferences = stats.llcReferences;
+        stage.llcMisses = stats.llcMisses;
+        stage.branchMisses = stats.branchMisses;
+    }
+    return writeVersioned(report, out);
+}
+
+void fd_journal_record_init(fd_journal_record* record) {
+    if (!record) return;
+    std::memset(record, 0, sizeof(*record));
+    record->structSize = sizeof(*record);
+    record->cameraId = -1;
+    record->eventId = -1;
+    record->trackId = -1;
+    record->personFaceId = -1;
+}
+
+int fd_journal_open(const char* path, uint64_t capacityBytes, fd_journal** journal) {
+    if (!path || !journal) return FD_ERR_INVALID_ARGUMENT;
+    *journal = nullptr;
+    std::unique_ptr<DetectionJournal> opened = DetectionJournal::open(path, capacityBytes);
+    if (!opened) return FD_ERR_INTERNAL;
+    fd_journal* handle = new (std::nothrow) fd_journal();
+    if (!handle) return FD_ERR_INTERNAL;
+    handle->journal = std::move(opened);
+    *journal = handle;
+    return FD_OK;
+}
+
+void fd_journal_close(fd_journal* journal) {
+    delete journal;
+}
+
+int fd_journal_append(fd_journal* journal, const fd_journal_record* records, int count, uint64_t* lastSeq) {
+    if (!journal || count < 0 || (count > 0 && !records)) return FD_ERR_INVALID_ARGUMENT;
+    if (count == 0) return FD_OK;
+    uint32_t stride = records[0].structSize;
+    if (stride < sizeof(uint32_t)) return FD_ERR_INVALID_ARGUMENT;
+
+    fd_journal_record defaults;
+    fd_journal_record_init(&defaults);
+    std::vector<JournalRecord> batch(count);
+    for (int i = 0; i < count; i++) {
+        const fd_journal_record* raw = reinterpret_cast<const fd_journal_record*>(
+            reinterpret_cast<const uint8_t*>(records) + static_cast<size_t>(i) * stride);
+        fd_journal_record in = readVersioned(raw, defaults);
+        JournalRecord& out = batch[i];
+        out.detectedAtMs = in.detectedAtMs;
+        out.organizationId = in.organizationId;
+        out.cameraId = in.cameraId;
+        out.eventId = in.eventId;
+        out.trackId = in.trackId;
+        out.personFaceId = in.personFaceId;
+        out.similarity = in.similarity;
+        out.confidence = in.confidence;
+        out.x = in.x;
+        out.y = in.y;
+        out.width = in.width;
+        out.height = in.height;
+        out.faceStatus = static_cast<uint8_t>(in.faceStatus);
+        out.detectionStatus = static_cast<uint8_t>(in.detectionStatus);
+        if (in.embedding && in.embeddingSize > 0) {
+            out.embedding.assign(in.embedding, in.embedding + in.embeddingSize);
+        }
+        if (in.embeddingModel) out.embeddingModel = in.embeddingModel;
+        if (in.cropRef) out.cropRef = in.cropRef;
+        if (in.metadata) out.metadata = in.metadata;
+    }
+
+    uint64_t appended = 0;
+    if (!journal->journal->append(batch, appended)) return FD_ERR_BUSY;
+    if (lastSeq) *lastSeq = appended;
+    return FD_OK;
+}
+
+int fd_journal_read(fd_journal* journal, uint64_t afterSeq, int maxRecords, fd_journal_batch** batch) {
+    if (!journal || !batch || maxRecords <= 0) return FD_ERR_INVALID_ARGUMENT;
+    JournalBatchHolder* holder = new (std::nothrow) JournalBatchHolder();
+    if (!holder) return FD_ERR_INTERNAL;
+    holder->decoded = journal->journal->read(afterSeq, static_cast<size_t>(maxRecords));
+    holder->views.resize(holder->decoded.size());
+    for (size_t i = 0; i < holder->decoded.size(); i++) {
+        const JournalRecord& in = holder->decoded[i];
+        fd_journal_record& out = holder->views[i];
+        fd_journal_record_init(&out);
+        out.seq = in.seq;
+        out.detectedAtMs = in.detectedAtMs;
+        out.organizationId = in.organizationId;
+        out.cameraId = in.cameraId;
+        out.eventId = in.eventId;
+        out.trackId = in.trackId;
+        out.personFaceId = in.personFaceId;
+        out.similarity = in.similarity;
+        out.confidence = in.confidence;
+        out.x = in.x;
+        out.y = in.y;
+        out.width = in.width;
+        out.height = in.height;
+        out.faceStatus = in.faceStatus;
+        out.detectionStatus = in.detectionStatus;
+        out.embedding = in.embedding.empty() ? nullptr : in.embedding.data();
+        out.embeddingSize = static_cast<int32_t>(in.embedding.size());
+        out.embeddingModel = in.embeddingModel.c_str();
+        out.cropRef = in.cropRef.c_str();
+        out.metadata = in.metadata.c_str();
+    }
+    holder->records = holder->views.empty() ? nullptr : holder->views.data();
+    holder->count = static_cast<int32_t>(holder->views.size());
+    holder->lastSeq = holder->decoded.empty() ? afterSeq : holder->decoded.back().seq;
+    *batch = holder;
+    return FD_OK;
+}
+
+void fd_journal_batch_free(fd_journal_batch* batch) {
+    delete static_cast<JournalBatchHolder*>(batch);
+}
+
+int fd_journal_commit(fd_journal* journal, uint64_t seq) {
+    if (!journal) return FD_ERR_INVALID_ARGUMENT;
+    return journal->journal->commit(seq) ? FD_OK : FD_ERR_INTERNAL;
+}
+
+int fd_journal_sync(fd_journal* journal) {
+    if (!journal) return FD_ERR_INVALID_ARGUMENT;
+    return journal->journal->sync() ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_journal_stats_init(fd_journal_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_journal_get_stats(fd_journal* journal, fd_journal_stats* stats) {
+    if (!journal) return FD_ERR_INVALID_ARGUMENT;
+    DetectionJournal::Stats snapshot = journal->journal->stats();
+    fd_journal_stats out;
+    fd_journal_stats_init(&out);
+    out.capacity = snapshot.capacity;
+    out.usedBytes = snapshot.usedBytes;
+    out.lastSeq = snapshot.lastSeq;
+    out.committedSeq = snapshot.committedSeq;
+    out.appended = snapshot.appended;
+    out.rejected = snapshot.rejected;
+    out.recovered = snapshot.recovered;
+    out.compactions = snapshot.compactions;
+    out.epoch = snapshot.epoch;
+    return writeVersioned(stats, out);
+}
+
+static fd_preview_unit previewUnitView(const H264Fragmenter::AccessUnit& unit) {
+    fd_preview_unit view;
+    view.data = unit.data.data();
+    view.size = unit.data.size();
+    view.keyframe = unit.keyframe ? 1 : 0;
+    view.index = unit.index;
+    return view;
+}
+
+int fd_preview_open(uint64_t maxCacheBytes, fd_preview** preview) {
+    if (!preview || maxCacheBytes == 0) return FD_ERR_INVALID_ARGUMENT;
+    *preview = new (std::nothrow) fd_preview(static_cast<size_t>(maxCacheBytes));
+    return *preview ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_preview_close(fd_preview* preview) {
+    delete preview;
+}
+
+int fd_preview_push(fd_preview* preview, const uint8_t* data, size_t length,
+                    const fd_preview_unit** units, int* count) {
+    if (!preview || (length > 0 && !data) || !units || !count) return FD_ERR_INVALID_ARGUMENT;
+    preview->completed.clear();
+    preview->completedViews.clear();
+    preview->joinViews.clear();
+
+    preview->fragmenter.push(data, length);
+    H264Fragmenter::AccessUnit unit;
+    while (preview->fragmenter.next(unit)) {
+        preview->completed.push_back(std::move(unit));
+    }
+    for (const auto& completed : preview->completed) {
+        preview->completedViews.push_back(previewUnitView(completed));
+    }
+    *units = preview->completedViews.empty() ? nullptr : preview->completedViews.data();
+    *count = static_cast<int>(preview->completedViews.size());
+    return FD_OK;
+}
+
+int fd_preview_join(fd_preview* preview, const fd_preview_unit** units, int* count) {
+    if (!preview || !units || !count) return FD_ERR_INVALID_ARGUMENT;
+    preview->joinViews.clear();
+    for (const auto& cached : preview->fragmenter.joinUnits()) {
+        preview->joinViews.push_back(previewUnitView(cached));
+    }
+    *units = preview->joinViews.empty() ? nullptr : preview->joinViews.data();
+    *count = static_cast<int>(preview->joinViews.size());
+    return FD_OK;
+}
+
+void fd_preview_stats_init(fd_preview_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_preview_get_stats(fd_preview* preview, fd_preview_stats* stats) {
+    if (!preview) return FD_ERR_INVALID_ARGUMENT;
+    H264Fragmenter::Stats snapshot = preview->fragmenter.stats();
+    fd_preview_stats out;
+    fd_preview_stats_init(&out);
+    out.accessUnits = snapshot.accessUnits;
+    out.keyframes = snapshot.keyframes;
+    out.bytesIn = snapshot.bytesIn;
+    out.bytesOut = snapshot.bytesOut;
+    out.cachedBytes = snapshot.cachedBytes;
+    out.cachedUnits = snapshot.cachedUnits;
+    out.droppedCache = snapshot.droppedCache;
+    copyString(out.codec, preview->fragmenter.codec());
+    return writeVersioned(stats, out);
+}
+
+int fd_gallery_open(int dimension, fd_gallery** gallery) {
+    if (!gallery || dimension <= 0) return FD_ERR_INVALID_ARGUMENT;
+    *gallery = new (std::nothrow) fd_gallery(dimension);
+    return *gallery ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_gallery_close(fd_gallery* gallery) {
+    delete gallery;
+}
+
+int fd_gallery_add(fd_gallery* gallery, int64_t id, const float* embedding, int dimension) {
+    return fd_gallery_add_ex(gallery, id, embedding, dimension, nullptr, 0);
+}
+
+int fd_gallery_add_ex(fd_gallery* gallery, int64_t id, const float* embedding, int dimension,
+                      const uint8_t* payload, size_t payloadLength) {
+    if (!gallery || !embedding || dimension != gallery->gallery.dimension() || (!payload && payloadLength > 0)) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+    try {
+        std::string bytes(reinterpret_cast<const char*>(payload), payload ? payloadLength : 0);
+        return gallery->gallery.add(id, embedding, bytes) ? FD_OK : FD_ERR_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery add failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+int fd_gallery_remove(fd_gallery* gallery, int64_t id) {
+    if (!gallery) return FD_ERR_INVALID_ARGUMENT;
+    return gallery->gallery.remove(id) ? 1 : 0;
+}
+
+void fd_gallery_search_options_init(fd_gallery_search_options* options) {
+    if (!options) return;
+    std::memset(options, 0, sizeof(*options));
+    options->structSize = sizeof(*options);
+    EmbeddingGallery::SearchOptions defaults;
+    options->k = defaults.k;
+    options->rerank = defaults.rerank;
+    options->budgetMs = defaults.budgetMs;
+    options->matchThreshold = defaults.matchThreshold;
+    options->margin = defaults.margin;
+    options->maxRerank = defaults.maxRerank;
+}
+
+void fd_gallery_search_report_init(fd_gallery_search_report* report) {
+    if (!report) return;
+    std::memset(report, 0, sizeof(*report));
+    report->structSize = sizeof(*report);
+}
+
+int fd_gallery_search(fd_gallery* gallery, const float* query, int dimension,
+                      const fd_gallery_search_options* options, fd_gallery_match* matches, int capacity) {
+    return fd_gallery_search_ex(gallery, query, dimension, options, matches, capacity, nullptr);
+}
+
+int fd_gallery_search_ex(fd_gallery* gallery, const float* query, int dimension,
+                         const fd_gallery_search_options* options, fd_gallery_match* matches, int capacity,
+                         fd_gallery_search_report* report) {
+    if (!gallery || !query || dimension != gallery->gallery.dimension() || capacity < 0 || (capacity > 0 && !matches)) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+    EmbeddingGallery::SearchOptions searchOptions = toGallerySearchOptions(options, capacity);
+    std::vector<EmbeddingGallery::Match> found;
+    EmbeddingGallery::SearchReport effort;
+    try {
+        gallery->gallery.search(query, searchOptions, found, &effort);
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery search failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+        matches[i].id = found[i].id;
+        matches[i].similarity = found[i].similarity;
+        matches[i].hamming = found[i].hamming;
+    }
+    if (report) {
+        fd_gallery_search_report out;
+        fd_gallery_search_report_init(&out);
+        out.depth = effort.depth;
+        out.elapsedMs = effort.elapsedMs;
+        out.earlyExit = effort.earlyExit ? 1 : 0;
+        out.budgetExhausted = effort.budgetExhausted ? 1 : 0;
+        writeVersioned(report, out);
+    }
+    return static_cast<int>(found.size());
+}
+
+int fd_gallery_search_batch(fd_gallery* gallery, const float* queries, int queryCount, int dimension,
+                            const fd_gallery_search_options* options, fd_gallery_match* matches,
+                            int capacity, int* counts) {
+    if (!gallery || queryCount < 0 || (queryCount > 0 && (!queries || !counts)) ||
+        dimension != gallery->gallery.dimension() || capacity < 0 || (capacity > 0 && queryCount > 0 && !matches)) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+    EmbeddingGallery::SearchOptions searchOptions = toGallerySearchOptions(options, capacity);
+    std::vector<std::vector<EmbeddingGallery::Match>> found;
+    try {
+        gallery->gallery.searchBatch(queries, static_cast<size_t>(queryCount), searchOptions, found);
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery batch search failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+    for (int q = 0; q < queryCount; q++) {
+        const std::vector<EmbeddingGallery::Match>& queryMatches = found[q];
+        fd_gallery_match* row = matches + static_cast<size_t>(q) * capacity;
+        for (size_t i = 0; i < queryMatches.size(); i++) {
+            row[i].id = queryMatches[i].id;
+            row[i].similarity = queryMatches[i].similarity;
+            row[i].hamming = queryMatches[i].hamming;
+        }
+        counts[q] = static_cast<int>(queryMatches.size());
+    }
+    return FD_OK;
+}
+
+void fd_gallery_stats_init(fd_gallery_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_gallery_get_stats(fd_gallery* gallery, fd_gallery_stats* stats) {
+    if (!gallery) return FD_ERR_INVALID_ARGUMENT;
+    EmbeddingGallery::Stats snapshot = gallery->gallery.stats();
+    fd_gallery_stats out;
+    fd_gallery_stats_init(&out);
+    out.size = snapshot.size;
+    out.dimension = snapshot.dimension;
+    out.codeBits = snapshot.codeBits;
+    out.vectorBytes = snapshot.vectorBytes;
+    out.codeBytes = snapshot.codeBytes;
+    out.searches = snapshot.searches;
+    out.exactSearches = snapshot.exactSearches;
+    out.rescored = snapshot.rescored;
+    out.batches = snapshot.batches;
+    out.batchedQueries = snapshot.batchedQueries;
+    out.adaptiveSearches = snapshot.adaptiveSearches;
+    out.earlyExits = snapshot.earlyExits;
+    out.budgetStops = snapshot.budgetStops;
+    out.adaptiveMicros = snapshot.adaptiveMicros;
+    out.epoch = snapshot.epoch;
+    out.sequence = snapshot.sequence;
+    out.oldestLogged = snapshot.oldestLogged;
+    out.logEntries = snapshot.logEntries;
+    out.deltasApplied = snapshot.deltasApplied;
+    out.snapshotsLoaded = snapshot.snapshotsLoaded;
+    return writeVersioned(stats, out);
+}
+
+uint64_t fd_gallery_sequence(fd_gallery* gallery) {
+    return gallery ? gallery->gallery.sequence() : 0;
+}
+
+int fd_gallery_set_log_capacity(fd_gallery* gallery, int entries) {
+    if (!gallery || entries < 0) return FD_ERR_INVALID_ARGUMENT;
+    gallery->gallery.setLogCapacity(static_cast<size_t>(entries));
+    return FD_OK;
+}
+
+int fd_gallery_export_delta(fd_gallery* gallery, uint64_t afterSequence, int maxEntries, fd_gallery_blob** blob) {
+    if (!gallery || !blob || maxEntries <= 0) return FD_ERR_INVALID_ARGUMENT;
+    *blob = nullptr;
+    try {
+        std::unique_ptr<GalleryBlobHolder> holder(new GalleryBlobHolder());
+        if (!gallery->gallery.exportDelta(afterSequence, static_cast<size_t>(maxEntries), holder->bytes,
+                                          &holder->sequence)) {
+            return FD_ERR_STALE;
+        }
+        holder->data = holder->bytes.data();
+        holder->size = holder->bytes.size();
+        *blob = holder.release();
+        return FD_OK;
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery delta export failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+int fd_gallery_export_snapshot(fd_gallery* gallery, fd_gallery_blob** blob) {
+    if (!gallery || !blob) return FD_ERR_INVALID_ARGUMENT;
+    *blob = nullptr;
+    try {
+        std::unique_ptr<GalleryBlobHolder> holder(new GalleryBlobHolder());
+        gallery->gallery.exportSnapshot(holder->bytes, &holder->sequence);
+        holder->data = holder->bytes.data();
+        holder->size = holder->bytes.size();
+        *blob = holder.release();
+        return FD_OK;
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery snapshot export failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+void fd_gallery_blob_free(fd_gallery_blob* blob) {
+    delete static_cast<GalleryBlobHolder*>(blob);
+}
+
+int fd_gallery_apply_delta(fd_gallery* gallery, const uint8_t* data, size_t size,
+                           fd_gallery_change_callback callback, void* user) {
+    if (!gallery || !data) return FD_ERR_INVALID_ARGUMENT;
+    try {
+        size_t applied = 0;
+        EmbeddingGallery::ApplyResult result =
+            gallery->gallery.applyDelta(data, size, toChangeCallback(callback, user), applied);
+        if (result == EmbeddingGallery::ApplyResult::Malformed) return FD_ERR_DECODE;
+        if (result == EmbeddingGallery::ApplyResult::Stale) return FD_ERR_STALE;
+        return static_cast<int>(applied);
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery delta apply failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+int fd_gallery_load_snapshot(fd_gallery* gallery, const uint8_t* data, size_t size,
+                             fd_gallery_change_callback callback, void* user) {
+    if (!gallery || !data) return FD_ERR_INVALID_ARGUMENT;
+    try {
+        EmbeddingGallery::ApplyResult result = gallery->gallery.loadSnapshot(data, size, toChangeCallback(callback, user));
+        if (result != EmbeddingGallery::ApplyResult::Applied) return FD_ERR_DECODE;
+        return static_cast<int>(gallery->gallery.stats().size);
+    } catch (const std::exception& e) {
+        std::cerr << "Gallery snapshot load failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+int fd_unknown_faces_open(int dimension, int maxPerOrganization, fd_unknown_faces** store) {
+    if (!store || dimension <= 0 || maxPerOrganization <= 0) return FD_ERR_INVALID_ARGUMENT;
+    *store = new (std::nothrow) fd_unknown_faces(dimension, static_cast<size_t>(maxPerOrganization));
+    return *store ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_unknown_faces_close(fd_unknown_faces* store) {
+    delete store;
+}
+
+int fd_unknown_faces_add(fd_unknown_faces* store, int64_t detectionId, int64_t organizationId,
+                         int64_t detectedAtMs, const float* embedding, int dimension) {
+    if (!store || !embedding || dimension != store->store.dimension()) return FD_ERR_INVALID_ARGUMENT;
+    try {
+        return store->store.add(detectionId, organizationId, detectedAtMs, embedding) ? FD_OK : FD_ERR_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        std::cerr << "Unknown face add failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+int fd_unknown_faces_remove(fd_unknown_faces* store, const int64_t* detectionIds, int count) {
+    if (!store || count < 0 || (count > 0 && !detectionIds)) return FD_ERR_INVALID_ARGUMENT;
+    return static_cast<int>(store->store.remove(detectionIds, static_cast<size_t>(count)));
+}
+
+void fd_unknown_match_options_init(fd_unknown_match_options* options) {
+    if (!options) return;
+    std::memset(options, 0, sizeof(*options));
+    options->structSize = sizeof(*options);
+    UnknownFaceStore::MatchOptions defaults;
+    options->organizationId = defaults.organizationId;
+    options->fromMs = defaults.fromMs;
+    options->toMs = defaults.toMs;
+    options->threshold = defaults.threshold;
+    options->maxLinks = static_cast<int32_t>(defaults.maxLinks);
+}
+
+int fd_unknown_faces_match(fd_unknown_faces* store, const float* queries, int queryCount, int dimension,
+                           const fd_unknown_match_options* options, fd_unknown_link* links, int capacity) {
+    if (!store || queryCount < 0 || (queryCount > 0 && !queries) || dimension != store->store.dimension() ||
+        capacity < 0 || (capacity > 0 && !links)) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+    fd_unknown_match_options defaults;
+    fd_unknown_match_options_init(&defaults);
+    fd_unknown_match_options in = readVersioned(options, defaults);
+
+    UnknownFaceStore::MatchOptions matchOptions;
+    matchOptions.organizationId = in.organizationId;
+    matchOptions.fromMs = in.fromMs;
+    matchOptions.toMs = in.toMs;
+    matchOptions.threshold = std::isnan(in.threshold) ? defaults.threshold : in.threshold;
+    matchOptions.maxLinks = static_cast<size_t>(std::max(0, std::min(in.maxLinks, capacity)));
+    std::vector<UnknownFaceStore::Link> found;
+    try {
+        store->store.match(queries, static_cast<size_t>(queryCount), matchOptions, found);
+    } catch (const std::exception& e) {
+        std::cerr << "Unknown face match failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+        links[i].detectionId = found[i].detectionId;
+        links[i].query = found[i].query;
+        links[i].similarity = found[i].similarity;
+    }
+    return static_cast<int>(found.size());
+}
+
+void fd_unknown_stats_init(fd_unknown_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_unknown_faces_get_stats(fd_unknown_faces* store, fd_unknown_stats* stats) {
+    if (!store) return FD_ERR_INVALID_ARGUMENT;
+    UnknownFaceStore::Stats snapshot = store->store.stats();
+    fd_unknown_stats out;
+    fd_unknown_stats_init(&out);
+    out.size = snapshot.size;
+    out.organizations = snapshot.organizations;
+    out.dimension = snapshot.dimension;
+    out.vectorBytes = snapshot.vectorBytes;
+    out.added = snapshot.added;
+    out.removed = snapshot.removed;
+    out.evicted = snapshot.evicted;
+    out.matches = snapshot.matches;
+    out.scanned = snapshot.scanned;
+    out.links = snapshot.links;
+    return writeVersioned(stats, out);
+}
+
+void fd_counters_config_init(fd_counters_config* config) {
+    if (!config) return;
+    std::memset(config, 0, sizeof(*config));
+    config->structSize = sizeof(*config);
+    RollingCounters::Config defaults;
+    config->minuteBuckets = static_cast<int32_t>(defaults.minuteBuckets);
+    config->hourBuckets = static_cast<int32_t>(defaults.hourBuckets);
+    config->dayBuckets = static_cast<int32_t>(defaults.dayBuckets);
+    config->utcOffsetMinutes = defaults.utcOffsetMinutes;
+    config->maxSeries = static_cast<int32_t>(defaults.maxSeries);
+}
+
+int fd_counters_open(const fd_counters_config* config, fd_counters** counters) {
+    if (!counters) return FD_ERR_INVALID_ARGUMENT;
+    fd_counters_config defaults;
+    fd_counters_config_init(&defaults);
+    fd_counters_config in = readVersioned(config, defaults);
+    if (in.minuteBuckets <= 0 || in.hourBuckets <= 0 || in.dayBuckets <= 0 || in.maxSeries <= 0 ||
+        in.utcOffsetMinutes < -14 * 60 || in.utcOffsetMinutes > 14 * 60) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+    RollingCounters::Config cfg;
+    cfg.minuteBuckets = static_cast<size_t>(in.minuteBuckets);
+    cfg.hourBuckets = static_cast<size_t>(in.hourBuckets);
+    cfg.dayBuckets = static_cast<size_t>(in.dayBuckets);
+    cfg.utcOffsetMinutes = in.utcOffsetMinutes;
+    cfg.maxSeries = static_cast<size_t>(in.maxSeries);
+    *counters = new (std::nothrow) fd_counters(cfg);
+    return *counters ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_counters_close(fd_counters* counters) {
+    delete counters;
+}
+
+void fd_counter_increment_init(fd_counter_increment* increment) {
+    if (!increment) return;
+    std::memset(increment, 0, sizeof(*increment));
+    increment->structSize = sizeof(*increment);
+    increment->cameraId = -1;
+    increment->eventId = -1;
+    increment->personId = -1;
+    increment->count = 1;
+}
+
+int fd_counters_add(fd_counters* counters, const fd_counter_increment* increments, int count) {
+    if (!counters || count < 0 || (count > 0 && !increments)) return FD_ERR_INVALID_ARGUMENT;
+    if (count == 0) return FD_OK;
+    uint32_t stride = increments[0].structSize;
+    if (stride < sizeof(uint32_t)) return FD_ERR_INVALID_ARGUMENT;
+
+    fd_counter_increment defaults;
+    fd_counter_increment_init(&defaults);
+    std::vector<RollingCounters::Increment> batch(count);
+    for (int i = 0; i < count; i++) {
+        const fd_counter_increment* raw = reinterpret_cast<const fd_counter_increment*>(
+            reinterpret_cast<const uint8_t*>(increments) + static_cast<size_t>(i) * stride);
+        fd_counter_increment in = readVersioned(raw, defaults);
+        RollingCounters::Increment& out = batch[i];
+        out.organizationId = in.organizationId;
+        out.cameraId = in.cameraId;
+        out.eventId = in.eventId;
+        out.personId = in.personId;
+        out.atMs = in.atMs;
+        out.count = in.count;
+        out.recognized = in.recognized != 0;
+    }
+    try {
+        counters->counters.record(batch.data(), batch.size());
+    } catch (const std::exception& e) {
+        std::cerr << "Rolling counters add failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+    return FD_OK;
+}
+
+void fd_counter_query_init(fd_counter_query* query) {
+    if (!query) return;
+    std::memset(query, 0, sizeof(*query));
+    query->structSize = sizeof(*query);
+    RollingCounters::Query defaults;
+    query->organizationId = defaults.organizationId;
+    query->granularity = static_cast<int32_t>(defaults.granularity);
+    query->buckets = static_cast<int32_t>(defaults.buckets);
+    query->endMs = 0;
+    query->scopes = defaults.scopes;
+}
+
+int fd_counters_snapshot(fd_counters* counters, const fd_counter_query* query, fd_counter_snapshot** snapshot) {
+    if (!counters || !snapshot) return FD_ERR_INVALID_ARGUMENT;
+    fd_counter_query defaults;
+    fd_counter_query_init(&defaults);
+    fd_counter_query in = readVersioned(query, defaults);
+    if (in.granularity < FD_COUNTER_MINUTE || in.granularity > FD_COUNTER_DAY || in.buckets <= 0) {
+        return FD_ERR_INVALID_ARGUMENT;
+    }
+
+    RollingCounters::Query q;
+    q.organizationId = in.organizationId;
+    q.granularity = static_cast<RollingCounters::Granularity>(in.granularity);
+    q.buckets = static_cast<size_t>(in.buckets);
+    q.endMs = in.endMs != 0 ? in.endMs : std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    q.scopes = in.scopes;
+
+    CounterSnapshotHolder* holder = new (std::nothrow) CounterSnapshotHolder();
+    if (!holder) return FD_ERR_INTERNAL;
+    try {
+        counters->counters.snapshot(q, holder->snapshot);
+        holder->views.resize(holder->snapshot.series.size());
+    } catch (const std::exception& e) {
+        std::cerr << "Rolling counters snapshot failed: " << e.what() << std::endl;
+        delete holder;
+        return FD_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < holder->views.size(); i++) {
+        const RollingCounters::Series& in = holder->snapshot.series[i];
+        fd_counter_series& out = holder->views[i];
+        out.scope = static_cast<int32_t>(in.scope);
+        out.id = in.id;
+        out.counts = in.counts.data();
+        out.recognized = in.recognized.data();
+        out.total = in.total;
+        out.recognizedTotal = in.recognizedTotal;
+    }
+    holder->series = holder->views.empty() ? nullptr : holder->views.data();
+    holder->count = static_cast<int32_t>(holder->views.size());
+    holder->buckets = static_cast<int32_t>(holder->snapshot.buckets);
+    holder->firstBucketMs = holder->snapshot.firstBucketMs;
+    holder->bucketMs = holder->snapshot.bucketMs;
+    *snapshot = holder;
+    return FD_OK;
+}
+
+void fd_counter_snapshot_free(fd_counter_snapshot* snapshot) {
+    delete static_cast<CounterSnapshotHolder*>(snapshot);
+}
+
+int fd_counters_save(fd_counters* counters, const char* path) {
+    if (!counters || !path || !*path) return FD_ERR_INVALID_ARGUMENT;
+    return counters->counters.save(path) ? FD_OK : FD_ERR_INTERNAL;
+}
+
+int fd_counters_load(fd_counters* counters, const char* path) {
+    if (!counters || !path || !*path) return FD_ERR_INVALID_ARGUMENT;
+    try {
+        return counters->counters.load(path) ? FD_OK : FD_ERR_DECODE;
+    } catch (const std::exception& e) {
+        std::cerr << "Rolling counters load failed: " << e.what() << std::endl;
+        return FD_ERR_INTERNAL;
+    }
+}
+
+void fd_counters_stats_init(fd_counters_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_counters_get_stats(fd_counters* counters, fd_counters_stats* stats) {
+    if (!counters) return FD_ERR_INVALID_ARGUMENT;
+    RollingCounters::Stats snapshot = counters->counters.stats();
+    fd_counters_stats out;
+    fd_counters_stats_init(&out);
+    out.series = snapshot.series;
+    out.organizations = snapshot.organizations;
+    out.memoryBytes = snapshot.memoryBytes;
+    out.increments = snapshot.increments;
+    out.late = snapshot.late;
+    out.dropped = snapshot.dropped;
+    out.latestMs = snapshot.latestMs;
+    out.saves = snapshot.saves;
+    out.loads = snapshot.loads;
+    return writeVersioned(stats, out);
+}
+
+int fd_watchlist_open(float threshold, fd_watchlist** watchlist) {
+    if (!watchlist || !(threshold > 0.0f && threshold <= 1.0f)) return FD_ERR_INVALID_ARGUMENT;
+    *watchlist = new (std::nothrow) fd_watchlist(threshold);
+    return *watchlist ? FD_OK : FD_ERR_INTERNAL;
+}
+
+void fd_watchlist_close(fd_watchlist* watchlist) {
+    delete watchlist;
+}
+
+void fd_watchlist_entry_init(fd_watchlist_entry* entry) {
+    if (!entry) return;
+    std::memset(entry, 0, sizeof(*entry));
+    entry->structSize = sizeof(*entry);
+}
+
+// Entries of a caller array, strided by the first one's structSize; false if an entry is malformed
+static bool readWatchlistEntries(const fd_watchlist_entry* entries, int count, std::vector<Watchlist::Entry>& out) {
+    if (count == 0) return true;
+    uint32_t stride = entries[0].structSize;
+    if (stride < sizeof(uint32_t)) return false;
+
+    fd_watchlist_entry defaults;
+    fd_watchlist_entry_init(&defaults);
+    out.resize(count);
+    for (int i = 0; i < count; i++) {
+        const fd_watchlist_entry* raw = reinterpret_cast<const fd_watchlist_entry*>(
+            reinterpret_cast<const uint8_t*>(entries) + static_cast<size_t>(i) * stride);
+        fd_watchlist_entry in = readVersioned(raw, defaults);
+        if (!in.embedding || in.dimension <= 0) return false;
+        out[i].id = in.id;
+        out[i].organizationId = in.organizationId;
+        out[i].model = in.model ? in.model : "";
+        out[i].embedding.assign(in.embedding, in.embedding + in.dimension);
+        out[i].threshold = std::isfinite(in.threshold) ? in.threshold : 0.0f;
+    }
+    return true;
+}
+
+int fd_watchlist_add(fd_watchlist* watchlist, const fd_watchlist_entry* entries, int count) {
+    if (!watchlist || count < 0 || (count > 0 && !entries)) return FD_ERR_INVALID_ARGUMENT;
+    std::vector<Watchlist::Entry> batch;
+    if (!readWatchlistEntries(entries, count, batch)) return FD_ERR_INVALID_ARGUMENT;
+    int kept = 0;
+    for (const Watchlist::Entry& entry : batch) {
+        kept += watchlist->list->add(entry) ? 1 : 0;
+    }
+    return kept;
+}
+
+int fd_watchlist_reset(fd_watchlist* watchlist, const fd_watchlist_entry* entries, int count) {
+    if (!watchlist || count < 0 || (count > 0 && !entries)) return FD_ERR_INVALID_ARGUMENT;
+    std::vector<Watchlist::Entry> batch;
+    if (!readWatchlistEntries(entries, count, batch)) return FD_ERR_INVALID_ARGUMENT;
+    return static_cast<int>(watchlist->list->reset(batch));
+}
+
+int fd_watchlist_remove(fd_watchlist* watchlist, int64_t id) {
+    if (!watchlist) return FD_ERR_INVALID_ARGUMENT;
+    return watchlist->list->remove(id) ? 1 : 0;
+}
+
+int fd_watchlist_check(fd_watchlist* watchlist, const char* model, const float* embedding, int dimension,
+                       int64_t organizationId, fd_watchlist_hit* hit) {
+    if (!watchlist || !embedding || dimension <= 0 || !hit) return FD_ERR_INVALID_ARGUMENT;
+    Watchlist::Hit found;
+    if (!watchlist->list->check(model ? model : "", embedding, dimension, organizationId, found)) {
+        return 0;
+    }
+    hit->id = found.id;
+    hit->organizationId = found.organizationId;
+    hit->similarity = found.similarity;
+    return 1;
+}
+
+void fd_watchlist_stats_init(fd_watchlist_stats* stats) {
+    if (!stats) return;
+    std::memset(stats, 0, sizeof(*stats));
+    stats->structSize = sizeof(*stats);
+}
+
+int fd_watchlist_get_stats(fd_watchlist* watchlist, fd_watchlist_stats* stats) {
+    if (!watchlist) return FD_ERR_INVALID_ARGUMENT;
+    Watchlist::Stats snapshot = watchlist->list->stats();
+    fd_watchlist_stats out;
+    fd_watchlist_stats_init(&out);
+    out.size = snapshot.size;
+    out.models = snapshot.models;
+    out.threshold = snapshot.threshold;
+    out.checks = snapshot.checks;
+    out.scanned = snapshot.scanned;
+    out.hits = snapshot.hits;
+    out.alerts = snapshot.alerts;
+    out.avgAlertMs = snapshot.avgAlertMs;
+    out.maxAlertMs = snapshot.maxAlertMs;
+    return writeVersioned(stats, out);
+}
+
+int fd_set_watchlist(fd_detector* detector, fd_watchlist* watchlist, fd_watchlist_callback callback, void* userData) {
+    if (!detector || (watchlist && !callback)) return FD_ERR_INVALID_ARGUMENT;
+    std::unique_lock<std::shared_mutex> lock(detector->watchlistMutex);
+    detector->watchlist = watchlist ? watchlist->list : nullptr;
+    detector->watchlistCallback = watchlist ? callback : nullptr;
+    detector->watchlistUserData = watchlist ? userData : nullptr;
+    return FD_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,882 @@
+#ifndef FACE_DETECTOR_C_API_H
+#define FACE_DETECTOR_C_API_H
+
+/**
+ * Stable C ABI of the face detector core (libfacedetector).
+ *
+ * Native callers link this library directly instead of going through the Node
+ * server; the N-API addon is itself just one consumer of these functions.
+ *
+ * ABI rules:
+ *  - Handles are opaque; all memory returned by the library is released with
+ *    the matching fd_*_free / fd_destroy call.
+ *  - Structs passed in or filled by the caller start with `structSize`, set
+ *    with the matching *_init function. New fields are only ever appended, and
+ *    the library never reads or writes past `structSize`.
+ *  - Structs returned by the library (fd_result) may gain fields at the end.
+ *  - Functions returning int use the fd_status codes below.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(FD_BUILDING_LIBRARY)
+#    define FD_API __declspec(dllexport)
+#  elif defined(FD_STATIC)
+#    define FD_API
+#  else
+#    define FD_API __declspec(dllimport)
+#  endif
+#else
+#  define FD_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FD_API_VERSION 20
+
+typedef enum fd_status {
+    FD_OK = 0,
+    FD_ERR_INVALID_ARGUMENT = -1,
+    FD_ERR_NOT_INITIALIZED = -2,
+    FD_ERR_DECODE = -3,
+    FD_ERR_BUSY = -4,        /* Too many submitted frames still pending */
+    FD_ERR_INTERNAL = -5,
+    FD_ERR_CANCELLED = -6,    /* The job was cancelled with fd_cancel (v3) */
+    FD_ERR_STALE = -7         /* Delta no longer available or from another epoch: load a snapshot (v14) */
+} fd_status;
+
+typedef enum fd_pixel_format {
+    FD_PIXEL_BGR24 = 0,
+    FD_PIXEL_RGB24 = 1,
+    FD_PIXEL_BGRA32 = 2,
+    FD_PIXEL_RGBA32 = 3,
+    FD_PIXEL_GRAY8 = 4
+} fd_pixel_format;
+
+typedef struct fd_detector fd_detector;
+typedef struct fd_journal fd_journal;
+typedef struct fd_preview fd_preview;
+typedef struct fd_gallery fd_gallery;
+typedef struct fd_unknown_faces fd_unknown_faces;
+typedef struct fd_counters fd_counters;
+typedef struct fd_watchlist fd_watchlist;
+
+struct fd_result;
+/* Early boxes of a frame, before its embeddings: a result with the frame's id whose faces carry
+ * boxes and confidences only. Called on the detecting thread; `boxes` is freed when the callback
+ * returns, so copy what is needed (v16). */
+typedef void (*fd_boxes_callback)(const struct fd_result* boxes, void* userData);
+
+typedef struct fd_detect_options {
+    uint32_t structSize;
+    int32_t cameraId;            /* -1 when the frame is not tied to a camera */
+    const char* embeddingTier;   /* "arcface", "facenet", "mobilefacenet" or NULL for the per-camera policy */
+    int32_t allTiers;            /* Non-zero: embed with every loaded model (enrollment) */
+    int32_t detectOnly;          /* Non-zero: boxes only, no embeddings (v2) */
+    int64_t eventId;             /* Tag for fd_cancel, -1 when none (v3) */
+    uint64_t jobId;              /* Synchronous calls: run as the job from fd_reserve_job, 0 for none (v3) */
+    fd_boxes_callback boxesCallback; /* Optional: the frame's boxes as soon as they are validated, then the full
+                                        result as usual; not called for detectOnly or frames without faces (v16) */
+    void* boxesUserData;
+    int64_t organizationId;      /* Watchlist alerts only for this organization's entries, -1 for any (v17) */
+} fd_detect_options;
+
+/* Fields left at their fd_cancel_filter_init defaults match any job; at least one must be set. */
+typedef struct fd_cancel_filter {
+    uint32_t structSize;
+    uint64_t jobId;              /* 0: any */
+    int32_t cameraId;            /* -1: any */
+    int64_t eventId;             /* -1: any */
+} fd_cancel_filter;
+
+typedef struct fd_init_options {
+    uint32_t structSize;
+    int32_t useDeepLearning;     /* Default 1 */
+    int32_t deferRecognition;    /* Non-zero: return once the detection model is loaded; recognition
+                                    models finish in the background and frames needing them wait */
+} fd_init_options;
+
+typedef struct fd_rect {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} fd_rect;
+
+typedef struct fd_embedding {
+    const char* model;           /* Model version tag, e.g. "arcface-112x112@1a2b3c4d" */
+    const float* values;
+    int32_t size;
+} fd_embedding;
+
+typedef struct fd_face {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    float confidence;
+    float quality;
+    const float* encoding;       /* Embedding from the selected tier; NULL when recognition did not run */
+    int32_t encodingSize;
+    const char* embeddingModel;  /* Version tag of `encoding`, "" when none */
+    const fd_embedding* embeddings; /* One per model when allTiers was set */
+    int32_t embeddingCount;
+} fd_face;
+
+typedef struct fd_result {
+    uint64_t frameId;            /* Id returned by fd_submit_*; 0 for synchronous calls */
+    int32_t cameraId;
+    int32_t status;              /* fd_status */
+    const char* error;           /* "" on success */
+    int64_t processingTimeMs;
+    const fd_face* faces;
+    int32_t faceCount;
+} fd_result;
+
+/* Called on a library worker thread; `result` is owned by the caller of fd_result_free. */
+typedef void (*fd_result_callback)(fd_result* result, void* userData);
+
+typedef struct fd_stats {
+    uint32_t structSize;
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t rejected;           /* Submissions refused with FD_ERR_BUSY */
+    uint64_t dropped;            /* Results discarded because the poll queue was full */
+    uint64_t pending;            /* Submitted and not yet completed */
+    uint64_t queued;             /* Completed and waiting for fd_poll */
+    uint64_t facesDetected;
+    double avgProcessingMs;
+    double maxProcessingMs;
+    uint64_t cancelled;          /* Jobs completed with FD_ERR_CANCELLED (v3) */
+} fd_stats;
+
+typedef struct fd_tier_policy {
+    uint32_t structSize;
+    float highLoad;
+    float criticalLoad;
+    float lowQuality;
+    int32_t minDwellMs;
+    double latencyBudgetMs;
+} fd_tier_policy;
+
+/* Two-stage detection (v5): a cascade pre-filter on a thumbnail runs on every frame of a camera,
+ * and the detection network only when it fires, while a face is held, or on refresh. */
+typedef struct fd_cascade_config {
+    uint32_t structSize;
+    int32_t enabled;
+    int32_t thumbnailWidth;      /* Pre-filter input width */
+    int32_t minNeighbors;        /* Cascade hit threshold; lower fires more often */
+    int32_t refreshFrames;       /* Run the network at least every N frames, 0 = never */
+    int32_t refreshMs;           /* ... and at least this often, 0 = never */
+    int32_t holdFrames;          /* Keep running the network this many frames after it found a face */
+} fd_cascade_config;
+
+/* Adaptive sampling (v6): each camera's interval between sampled frames moves from maxIntervalMs
+ * (empty scene) to minIntervalMs (faces or motion), within a process CPU budget. */
+typedef struct fd_sampling_config {
+    uint32_t structSize;
+    int32_t minIntervalMs;
+    int32_t maxIntervalMs;
+    int32_t idleHalfLifeMs;      /* Activity halves this often without faces or motion */
+    float motionThreshold;       /* Mean thumbnail difference (gray levels) counted as full motion */
+} fd_sampling_config;
+
+/* Low-power cascade detector (v8), used when deep learning is off or its model is missing. */
+typedef struct fd_low_power_config {
+    uint32_t structSize;
+    int32_t processWidth;        /* Frames are scanned at this width, 0 = full resolution */
+    float scaleFactor;           /* Size step between scale levels, > 1 */
+    int32_t minNeighbors;
+    int32_t minFaceSize;         /* Smallest face, in scanned pixels */
+    int32_t scaleBands;          /* Scale bands scanned in parallel, 0 = one per hardware thread (at most 4) */
+    int32_t roiReuse;            /* Non-zero: between full scans only look around a camera's previous faces */
+    int32_t fullScanFrames;      /* Full scan at least every N frames */
+    float roiMargin;             /* Area scanned around a previous face, as a fraction of its size per side */
+} fd_low_power_config;
+
+typedef struct fd_model_info {
+    char name[32];
+    char version[96];
+    int32_t inputWidth;
+    int32_t inputHeight;
+} fd_model_info;
+
+#define FD_MAX_TIERS 8
+
+typedef struct fd_model_load {
+    char name[32];
+    char role[16];               /* "detector" or "recognition" */
+    double loadMs;               /* Map + parse time, 0 when reused */
+    uint64_t sizeBytes;
+    int32_t reused;              /* Already loaded by another detector in the process */
+    int32_t deferred;            /* Loaded in the background after initialization returned */
+} fd_model_load;
+
+typedef struct fd_camera_tier_stats {
+    int32_t cameraId;
+    int32_t tier;                /* Index for fd_tier_name, -1 before the first selection */
+    int32_t pinned;
+    float load;
+    double avgLatencyMs;
+    uint64_t selections[FD_MAX_TIERS];
+} fd_camera_tier_stats;
+
+typedef struct fd_camera_cascade_stats {
+    int32_t cameraId;
+    int32_t overridden;          /* Camera has its own fd_cascade_config */
+    uint64_t frames;             /* Frames that went through the pre-filter */
+    uint64_t prefilterFires;
+    uint64_t fullRuns;           /* Network runs: fires + holds + refreshes */
+    uint64_t holdRuns;
+    uint64_t refreshRuns;
+    uint64_t fullHits;           /* Network runs that found a face */
+    uint64_t refreshHits;        /* Refreshes that found a face the pre-filter missed */
+    double avgPrefilterMs;
+    double avgFullMs;
+} fd_camera_cascade_stats;
+
+typedef struct fd_camera_sampling_stats {
+    int32_t cameraId;
+    int32_t overridden;          /* Camera has its own fd_sampling_config */
+    double intervalMs;           /* Effective interval, after the CPU budget */
+    double desiredIntervalMs;    /* Interval from activity alone */
+    float activity;              /* 0 idle .. 1 faces present */
+    float motion;
+    int32_t faces;               /* In the last frame */
+    int32_t budgetLimited;
+    double avgProcessingMs;
+    uint64_t frames;
+} fd_camera_sampling_stats;
+
+typedef struct fd_camera_low_power_stats {
+    int32_t cameraId;
+    int32_t trackedFaces;        /* Found in the last frame */
+    uint64_t frames;
+    uint64_t fullScans;
+    uint64_t roiScans;           /* Frames that only scanned around previous faces */
+    uint64_t roiMisses;          /* ROI scans that lost a face and fell back to a full scan */
+    double avgScanMs;
+} fd_camera_low_power_stats;
+
+typedef struct fd_capabilities {
+    uint32_t structSize;
+    char isa[16];                /* Kernel set selected for this CPU */
+    char cpuFeatures[256];       /* Comma separated */
+    char compiledIsas[64];       /* Comma separated */
+    char opencvVersion[32];
+    char detector[32];
+    int32_t partialJpegDecode;   /* Non-zero: fd_embed_encoded decodes only the face region of JPEGs (v4) */
+    int32_t cascadePrefilter;    /* Non-zero: a pre-filter cascade is loaded for fd_set_cascade_config (v5) */
+    int32_t lowPower;            /* Non-zero: detection runs on the low-power cascade detector (v8) */
+} fd_capabilities;
+
+typedef struct fd_runtime_stats {
+    uint32_t structSize;
+    uint32_t sharedModels;       /* Distinct model files loaded in the process */
+    uint32_t netReplicas;        /* Parsed copies across those models (at most one per busy thread) */
+    uint64_t modelBytes;
+    uint32_t executorThreads;
+    uint32_t executorUsers;      /* Detectors holding the shared thread pool */
+    uint32_t netReplicaLimit;    /* Replicas per model, FACE_DETECTOR_NET_REPLICAS (v20) */
+    uint64_t replicaBytes;       /* Heap of one replica of every model (v20) */
+    uint64_t heapBytes;          /* Heap of all replicas (v20) */
+} fd_runtime_stats;
+
+#define FD_MAX_PROFILE_STAGES 8
+
+/* One pipeline stage over a profiling window (v9). Counter totals cover countedCalls only. */
+typedef struct fd_stage_profile {
+    char stage[16];              /* decode, prefilter, detect, validate, embed */
+    uint64_t calls;
+    uint64_t countedCalls;       /* Calls measured with hardware counters */
+    double wallMs;               /* Summed over calls, across threads */
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t llcReferences;
+    uint64_t llcMisses;
+    uint64_t branchMisses;
+} fd_stage_profile;
+
+typedef struct fd_profile_report {
+    uint32_t structSize;
+    int32_t countersAvailable;   /* Zero: only calls and wallMs are filled, see unavailableReason */
+    char unavailableReason[128];
+    double durationMs;
+    int32_t stageCount;
+    fd_stage_profile stages[FD_MAX_PROFILE_STAGES];
+} fd_profile_report;
+
+/* One detection in the journal (v4). Strings and the embedding are copied by fd_journal_append. */
+typedef struct fd_journal_record {
+    uint32_t structSize;
+    uint64_t seq;                /* Assigned by the journal; ignored on append */
+    int64_t detectedAtMs;        /* Unix epoch milliseconds */
+    int32_t organizationId;
+    int32_t cameraId;
+    int64_t eventId;             /* -1 when none */
+    int64_t trackId;             /* -1 when none */
+    int64_t personFaceId;        /* -1 for unknown faces */
+    float similarity;
+    float confidence;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    int32_t faceStatus;          /* 0 unrecognized, 1 detected, 2 recognized */
+    int32_t detectionStatus;     /* 0 pending, 1 confirmed */
+    const float* embedding;
+    int32_t embeddingSize;
+    const char* embeddingModel;  /* May be NULL */
+    const char* cropRef;         /* Face crop URL, may be NULL */
+    const char* metadata;        /* JSON, may be NULL */
+} fd_journal_record;
+
+typedef struct fd_journal_batch {
+    const fd_journal_record* records;
+    int32_t count;
+    uint64_t lastSeq;            /* Seq of the last record, pass to fd_journal_commit once written */
+} fd_journal_batch;
+
+typedef struct fd_journal_stats {
+    uint32_t structSize;
+    uint64_t capacity;
+    uint64_t usedBytes;
+    uint64_t lastSeq;
+    uint64_t committedSeq;
+    uint64_t appended;
+    uint64_t rejected;           /* Records refused because the journal was full */
+    uint64_t recovered;          /* Uncommitted records found when the journal was opened */
+    uint64_t compactions;
+    uint64_t epoch;              /* Random per journal file; seq restarts at 1 in a new file (v19) */
+} fd_journal_stats;
+
+/* One H.264 access unit (v7): Annex-B with 4-byte start codes. Owned by the preview. */
+typedef struct fd_preview_unit {
+    const uint8_t* data;
+    size_t size;
+    int32_t keyframe;            /* Non-zero for IDR units; these always carry SPS and PPS */
+    uint64_t index;              /* Consecutive from 0 */
+} fd_preview_unit;
+
+typedef struct fd_preview_stats {
+    uint32_t structSize;
+    uint64_t accessUnits;
+    uint64_t keyframes;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint64_t cachedBytes;        /* Units since the last IDR, sent to joining viewers */
+    uint64_t cachedUnits;
+    uint64_t droppedCache;       /* GOPs larger than the cache; joiners waited for the next IDR */
+    char codec[32];              /* RFC 6381, e.g. "avc1.42e01f"; empty before the first SPS */
+} fd_preview_stats;
+
+typedef struct fd_gallery_search_options {
+    uint32_t structSize;
+    int32_t k;                   /* Matches to return */
+    int32_t rerank;              /* Closest binary codes scored exactly; 0 = exact scan of every vector */
+    /* Adaptive rerank (v12): codes are rescored closest first in doubling stages */
+    double budgetMs;             /* Per-query latency budget; deeper stages run only while it allows. 0 = fixed rerank */
+    float matchThreshold;        /* Cosine similarity of a match; > 1 (default) disables early exit */
+    float margin;                /* Stop once the best match reaches matchThreshold + margin */
+    int32_t maxRerank;           /* Deepest rerank a budgeted search may grow to, past `rerank` */
+} fd_gallery_search_options;
+
+/* Effort spent on one search (v12) */
+typedef struct fd_gallery_search_report {
+    uint32_t structSize;
+    uint64_t depth;              /* Vectors scored with floats */
+    double elapsedMs;
+    int32_t earlyExit;           /* Best match cleared matchThreshold + margin */
+    int32_t budgetExhausted;     /* Stopped short of the depth ceiling to stay within budgetMs */
+} fd_gallery_search_report;
+
+typedef struct fd_gallery_match {
+    int64_t id;
+    float similarity;            /* Cosine similarity */
+    uint32_t hamming;            /* Binary code distance; 0 for exact searches */
+} fd_gallery_match;
+
+typedef struct fd_gallery_stats {
+    uint32_t structSize;
+    uint64_t size;
+    int32_t dimension;
+    int32_t codeBits;            /* Bits per binary code */
+    uint64_t vectorBytes;
+    uint64_t codeBytes;          /* Scanned by the first pass */
+    uint64_t searches;
+    uint64_t exactSearches;
+    uint64_t rescored;           /* Vectors scored with floats, across all searches */
+    uint64_t batches;            /* fd_gallery_search_batch calls (v11) */
+    uint64_t batchedQueries;
+    uint64_t adaptiveSearches;   /* Searches with a budget or match threshold (v12) */
+    uint64_t earlyExits;
+    uint64_t budgetStops;
+    uint64_t adaptiveMicros;     /* Time spent in adaptive searches */
+    /* Replication (v14) */
+    uint64_t epoch;              /* Random per primary; a replica takes its primary's */
+    uint64_t sequence;           /* Last change made or applied */
+    uint64_t oldestLogged;       /* First change fd_gallery_export_delta can still serve */
+    uint64_t logEntries;
+    uint64_t deltasApplied;      /* Changes applied from a primary */
+    uint64_t snapshotsLoaded;
+} fd_gallery_stats;
+
+typedef enum fd_gallery_change_op {
+    FD_GALLERY_ADD = 1,
+    FD_GALLERY_UPDATE = 2,
+    FD_GALLERY_REMOVE = 3
+} fd_gallery_change_op;
+
+/* A serialized delta or snapshot, owned by the library (v14) */
+typedef struct fd_gallery_blob {
+    const uint8_t* data;
+    size_t size;
+    uint64_t sequence;           /* Last change included */
+} fd_gallery_blob;
+
+/* Called for each change a replica takes from a primary, after the gallery is updated. `payload` is
+ * only valid during the call. */
+typedef void (*fd_gallery_change_callback)(void* user, fd_gallery_change_op op, int64_t id,
+                                           const uint8_t* payload, size_t payloadLength);
+
+typedef struct fd_unknown_match_options {
+    uint32_t structSize;
+    int64_t organizationId;
+    int64_t fromMs;              /* Detection time window, inclusive, ms since the epoch; default unbounded */
+    int64_t toMs;
+    float threshold;             /* Cosine similarity a link needs */
+    int32_t maxLinks;            /* Best links kept */
+} fd_unknown_match_options;
+
+/* A past unknown detection that matches one of the enrolled embeddings */
+typedef struct fd_unknown_link {
+    int64_t detectionId;
+    int32_t query;               /* Index of the best-matching query */
+    float similarity;            /* Cosine similarity */
+} fd_unknown_link;
+
+typedef struct fd_unknown_stats {
+    uint32_t structSize;
+    uint64_t size;
+    uint64_t organizations;
+    int32_t dimension;
+    uint64_t vectorBytes;
+    uint64_t added;
+    uint64_t removed;
+    uint64_t evicted;            /* Oldest rows dropped from full organizations */
+    uint64_t matches;
+    uint64_t scanned;            /* Rows scored, across all matches */
+    uint64_t links;
+} fd_unknown_stats;
+
+typedef enum fd_counter_scope {
+    FD_COUNTER_ORGANIZATION = 0,
+    FD_COUNTER_CAMERA = 1,
+    FD_COUNTER_EVENT = 2,
+    FD_COUNTER_PERSON = 3
+} fd_counter_scope;
+
+typedef enum fd_counter_granularity {
+    FD_COUNTER_MINUTE = 0,
+    FD_COUNTER_HOUR = 1,
+    FD_COUNTER_DAY = 2
+} fd_counter_granularity;
+
+typedef struct fd_counters_config {
+    uint32_t structSize;
+    int32_t minuteBuckets;       /* Buckets kept per series: 120 minutes, 72 hours and 90 days by default */
+    int32_t hourBuckets;
+    int32_t dayBuckets;
+    int32_t utcOffsetMinutes;    /* Local time zone, so day buckets start at local midnight */
+    int32_t maxSeries;           /* Default 50000; increments for further series are dropped */
+} fd_counters_config;
+
+/* `count` detections at `atMs`; ids of -1 skip that scope */
+typedef struct fd_counter_increment {
+    uint32_t structSize;
+    int64_t organizationId;
+    int64_t cameraId;
+    int64_t eventId;
+    int64_t personId;
+    int64_t atMs;
+    uint32_t count;              /* Default 1 */
+    int32_t recognized;          /* Non-zero when the detections matched a person */
+} fd_counter_increment;
+
+typedef struct fd_counter_query {
+    uint32_t structSize;
+    int64_t organizationId;
+    int32_t granularity;         /* fd_counter_granularity, default FD_COUNTER_HOUR */
+    int32_t buckets;             /* Default 24, at most the ring size */
+    int64_t endMs;               /* The window ends with the bucket holding endMs; 0 = now */
+    uint32_t scopes;             /* Bits (1 << fd_counter_scope); 0 = every scope */
+} fd_counter_query;
+
+typedef struct fd_counter_series {
+    int32_t scope;               /* fd_counter_scope */
+    int64_t id;
+    const uint32_t* counts;      /* `buckets` entries, oldest first */
+    const uint32_t* recognized;
+    uint64_t total;              /* Over the window */
+    uint64_t recognizedTotal;
+} fd_counter_series;
+
+/* Library-owned, released with fd_counter_snapshot_free */
+typedef struct fd_counter_snapshot {
+    const fd_counter_series* series;
+    int32_t count;
+    int32_t buckets;
+    int64_t firstBucketMs;       /* Start of the oldest bucket, Unix epoch ms */
+    int64_t bucketMs;
+} fd_counter_snapshot;
+
+typedef struct fd_counters_stats {
+    uint32_t structSize;
+    uint64_t series;
+    uint64_t organizations;
+    uint64_t memoryBytes;
+    uint64_t increments;
+    uint64_t late;               /* Older than a ring, so missing at that granularity */
+    uint64_t dropped;            /* Refused once maxSeries was reached */
+    int64_t latestMs;            /* Newest detection counted; restored by fd_counters_load */
+    uint64_t saves;
+    uint64_t loads;
+} fd_counters_stats;
+
+typedef struct fd_watchlist_entry {
+    uint32_t structSize;
+    int64_t id;                  /* Caller's id, e.g. the PersonFace; adding an id again replaces it */
+    int64_t organizationId;
+    const char* model;           /* Version tag of the embedding; NULL or "" for legacy embeddings (ArcFace/FaceNet only) */
+    const float* embedding;
+    int32_t dimension;
+    float threshold;             /* Cosine similarity for an alert; 0 = the watchlist's */
+} fd_watchlist_entry;
+
+typedef struct fd_watchlist_hit {
+    int64_t id;
+    int64_t organizationId;
+    float similarity;
+} fd_watchlist_hit;
+
+typedef struct fd_watchlist_alert {
+    uint64_t frameId;            /* Job id of the frame; its result arrives later */
+    int32_t cameraId;
+    int32_t faceIndex;           /* Index of the face in the frame's result */
+    fd_rect box;
+    float confidence;
+    fd_watchlist_hit hit;
+    double latencyMs;            /* Detection start to this alert */
+    int64_t firedAtMs;           /* Unix epoch ms */
+} fd_watchlist_alert;
+
+/* Called on the detecting thread as soon as a face is embedded; `alert` is valid during the call only.
+ * The callback must not call fd_set_watchlist. */
+typedef void (*fd_watchlist_callback)(const fd_watchlist_alert* alert, void* userData);
+
+typedef struct fd_watchlist_stats {
+    uint32_t structSize;
+    uint64_t size;
+    uint64_t models;
+    float threshold;
+    uint64_t checks;
+    uint64_t scanned;            /* Rows scored, across all checks */
+    uint64_t hits;
+    uint64_t alerts;             /* Hits raised by detectors */
+    double avgAlertMs;           /* Detection start to alert */
+    double maxAlertMs;
+} fd_watchlist_stats;
+
+/* ---- Lifetime ----
+ * Detectors may be created from any thread. Model files and the thread pool are
+ * shared process-wide and reference counted, so detectors created by several
+ * callers (e.g. one per Node worker thread) reuse one copy of each model. */
+
+FD_API int fd_api_version(void);
+FD_API fd_detector* fd_create(void);
+/* Waits for submitted frames to finish, then frees the detector and any unpolled results. */
+FD_API void fd_destroy(fd_detector* detector);
+FD_API int fd_initialize(fd_detector* detector, const char* modelPath, int useDeepLearning);
+FD_API void fd_init_options_init(fd_init_options* options);
+FD_API int fd_initialize_ex(fd_detector* detector, const char* modelPath, const fd_init_options* options);
+FD_API int fd_is_initialized(const fd_detector* detector);
+/* 1 once the recognition models have finished loading (immediately unless deferred). */
+FD_API int fd_is_recognition_ready(const fd_detector* detector);
+FD_API int fd_set_confidence_threshold(fd_detector* detector, float threshold);
+/* Runs one forward pass of every loaded model on up to `concurrency` network replicas with a synthetic
+ * width x height frame, so a camera's first frames do not pay for replica creation and buffer
+ * allocation. Waits for deferred recognition models (v4). */
+FD_API int fd_warm_up(fd_detector* detector, int width, int height, int concurrency);
+
+/* ---- Synchronous detection (runs on the calling thread) ---- */
+
+FD_API void fd_detect_options_init(fd_detect_options* options);
+FD_API int fd_detect_encoded(fd_detector* detector, const uint8_t* data, size_t length,
+                             const fd_detect_options* options, fd_result** result);
+FD_API int fd_detect_raw(fd_detector* detector, const uint8_t* pixels, int width, int height, size_t stride,
+                         fd_pixel_format format, const fd_detect_options* options, fd_result** result);
+/* Embeds a face whose box is already known (e.g. a stored detection) without running detection.
+ * Only the JPEG scanlines covering the box are decoded when partialJpegDecode is reported; other
+ * images are decoded whole. The result holds one face, its box in image coordinates (v4). */
+FD_API int fd_embed_encoded(fd_detector* detector, const uint8_t* data, size_t length, const fd_rect* box,
+                            const fd_detect_options* options, fd_result** result);
+FD_API void fd_result_free(fd_result* result);
+
+/* ---- Asynchronous detection (library thread pool) ----
+ * Results go to the callback if one is set, otherwise to a queue read with fd_poll.
+ * The input is copied, so the caller may reuse its buffer as soon as the call returns. */
+
+FD_API int fd_set_result_callback(fd_detector* detector, fd_result_callback callback, void* userData);
+FD_API int fd_set_max_pending(fd_detector* detector, uint32_t maxPending, uint32_t maxQueued);
+FD_API int fd_submit_encoded(fd_detector* detector, const uint8_t* data, size_t length,
+                             const fd_detect_options* options, uint64_t* frameId);
+FD_API int fd_submit_raw(fd_detector* detector, const uint8_t* pixels, int width, int height, size_t stride,
+                         fd_pixel_format format, const fd_detect_options* options, uint64_t* frameId);
+/* Returns 1 and sets *result when a result is ready, 0 when none is (after waiting up to timeoutMs). */
+FD_API int fd_poll(fd_detector* detector, int timeoutMs, fd_result** result);
+
+/* ---- Jobs and cancellation ----
+ * Every submission is a job whose id is the frameId, tagged with the options' cameraId and eventId.
+ * Callers that queue synchronous calls themselves (e.g. on their own thread pool) reserve a job id
+ * up front and pass it as fd_detect_options.jobId, so the frame can be cancelled before it runs.
+ *
+ * fd_cancel returns the number of jobs cancelled. Submitted jobs that have not started complete
+ * immediately with FD_ERR_CANCELLED and release their input; reserved ones return FD_ERR_CANCELLED
+ * when run. Running jobs skip their remaining stages (embedding) and complete with FD_ERR_CANCELLED.
+ *
+ * A reserved job stays registered until it runs or is cancelled, so callers must release it with
+ * fd_release_job when the queued call is dropped without running (v18). */
+
+FD_API int fd_reserve_job(fd_detector* detector, const fd_detect_options* options, uint64_t* jobId);
+/* Returns 1 if the reserved job had not started and is now released, 0 if it already ran or was cancelled,
+ * is unknown, or is running (it unregisters itself when done). Safe to call after every reserved call (v18). */
+FD_API int fd_release_job(fd_detector* detector, uint64_t jobId);
+FD_API void fd_cancel_filter_init(fd_cancel_filter* filter);
+FD_API int fd_cancel(fd_detector* detector, const fd_cancel_filter* filter);
+
+/* ---- Stats and configuration ---- */
+
+FD_API void fd_stats_init(fd_stats* stats);
+FD_API int fd_get_stats(fd_detector* detector, fd_stats* stats);
+
+FD_API void fd_tier_policy_init(fd_tier_policy* policy);
+FD_API int fd_get_tier_policy(fd_detector* detector, fd_tier_policy* policy);
+FD_API int fd_set_tier_policy(fd_detector* detector, const fd_tier_policy* policy);
+/* Pins a camera to a tier by name; NULL returns it to automatic selection. */
+FD_API int fd_pin_camera_tier(fd_detector* detector, int cameraId, const char* tierName);
+FD_API void fd_cascade_config_init(fd_cascade_config* config);
+/* cameraId -1 reads or sets the default for every camera without an override (v5). */
+FD_API int fd_get_cascade_config(fd_detector* detector, int cameraId, fd_cascade_config* config);
+FD_API int fd_set_cascade_config(fd_detector* detector, int cameraId, const fd_cascade_config* config);
+/* Returns a camera to the default cascade config. */
+FD_API int fd_clear_cascade_config(fd_detector* detector, int cameraId);
+FD_API void fd_sampling_config_init(fd_sampling_config* config);
+/* cameraId -1 reads or sets the default for every camera without an override (v6). */
+FD_API int fd_get_sampling_config(fd_detector* detector, int cameraId, fd_sampling_config* config);
+FD_API int fd_set_sampling_config(fd_detector* detector, int cameraId, const fd_sampling_config* config);
+FD_API int fd_clear_sampling_config(fd_detector* detector, int cameraId);
+/* Share of the hardware threads detection may use across all cameras, e.g. 0.5 */
+FD_API int fd_set_sampling_budget(fd_detector* detector, float cpuBudget);
+FD_API float fd_get_sampling_budget(fd_detector* detector);
+/* Milliseconds to wait before sampling the camera's next frame */
+FD_API double fd_get_sampling_interval(fd_detector* detector, int cameraId);
+FD_API void fd_low_power_config_init(fd_low_power_config* config);
+FD_API int fd_get_low_power_config(fd_detector* detector, fd_low_power_config* config);
+FD_API int fd_set_low_power_config(fd_detector* detector, const fd_low_power_config* config);
+FD_API int fd_tier_count(void);
+FD_API const char* fd_tier_name(int tier);
+/* Each returns the total number of entries and fills at most `capacity` of them. */
+FD_API int fd_get_models(fd_detector* detector, fd_model_info* models, int capacity);
+FD_API int fd_get_camera_tier_stats(fd_detector* detector, fd_camera_tier_stats* cameras, int capacity);
+FD_API int fd_get_camera_cascade_stats(fd_detector* detector, fd_camera_cascade_stats* cameras, int capacity);
+FD_API int fd_get_camera_sampling_stats(fd_detector* detector, fd_camera_sampling_stats* cameras, int capacity);
+FD_API int fd_get_camera_low_power_stats(fd_detector* detector, fd_camera_low_power_stats* cameras, int capacity);
+FD_API int fd_get_model_load_times(fd_detector* detector, fd_model_load* models, int capacity);
+
+FD_API void fd_runtime_stats_init(fd_runtime_stats* stats);
+/* Process-wide: shared models and executor, across every detector */
+FD_API int fd_get_runtime_stats(fd_runtime_stats* stats);
+
+FD_API void fd_capabilities_init(fd_capabilities* capabilities);
+FD_API int fd_get_capabilities(fd_detector* detector, fd_capabilities* capabilities);
+
+/* ---- Stage profiling (v9) ----
+ * Hardware performance counters (perf_event_open on Linux) around each pipeline stage, for a window
+ * opened with fd_profile_start and closed with fd_profile_stop. Detection runs as usual in between;
+ * outside a window the instrumentation is one atomic load per stage. */
+
+/* FD_ERR_BUSY if a window is already open on this detector. */
+FD_API int fd_profile_start(fd_detector* detector);
+FD_API void fd_profile_report_init(fd_profile_report* report);
+/* Closes the window and fills the report; FD_ERR_INVALID_ARGUMENT if no window is open. */
+FD_API int fd_profile_stop(fd_detector* detector, fd_profile_report* report);
+
+/* ---- Detection journal (v4) ----
+ * A crash-safe, memory-mapped append log of detections. Producers append a frame's detections in
+ * one call; a consumer reads batches past the committed watermark, writes them to its store and
+ * commits the batch's lastSeq. Records are replayed after a crash until they are committed, so the
+ * consumer's write must be idempotent on (epoch, seq): a replaced or new file starts again at seq 1
+ * under another epoch (v19). Safe to use from any thread. */
+
+FD_API int fd_journal_open(const char* path, uint64_t capacityBytes, fd_journal** journal);
+FD_API void fd_journal_close(fd_journal* journal);
+FD_API void fd_journal_record_init(fd_journal_record* record);
+/* Appends all `count` records (strided by records[0].structSize) or none; FD_ERR_BUSY when full. */
+FD_API int fd_journal_append(fd_journal* journal, const fd_journal_record* records, int count, uint64_t* lastSeq);
+/* Reads up to maxRecords records with seq > afterSeq that are not yet committed. */
+FD_API int fd_journal_read(fd_journal* journal, uint64_t afterSeq, int maxRecords, fd_journal_batch** batch);
+FD_API void fd_journal_batch_free(fd_journal_batch* batch);
+FD_API int fd_journal_commit(fd_journal* journal, uint64_t seq);
+FD_API int fd_journal_sync(fd_journal* journal);
+FD_API void fd_journal_stats_init(fd_journal_stats* stats);
+FD_API int fd_journal_get_stats(fd_journal* journal, fd_journal_stats* stats);
+
+/* ---- Live preview (v7) ----
+ * Splits an H.264 Annex-B stream (from an encoder or passed through from the camera) into access
+ * units to send to viewers, and keeps the units since the last IDR so a viewer joining mid-stream
+ * starts on a keyframe. One producer at a time; not thread-safe. */
+
+FD_API int fd_preview_open(uint64_t maxCacheBytes, fd_preview** preview);
+FD_API void fd_preview_close(fd_preview* preview);
+/* Appends stream bytes. `units` is set to the access units this chunk completed, valid until the
+ * next fd_preview_push. */
+FD_API int fd_preview_push(fd_preview* preview, const uint8_t* data, size_t length,
+                           const fd_preview_unit** units, int* count);
+/* The cached units a new viewer needs, oldest first; empty before the first IDR. Valid until the
+ * next fd_preview_push. */
+FD_API int fd_preview_join(fd_preview* preview, const fd_preview_unit** units, int* count);
+FD_API void fd_preview_stats_init(fd_preview_stats* stats);
+FD_API int fd_preview_get_stats(fd_preview* preview, fd_preview_stats* stats);
+
+/* ---- Gallery search (v10) ----
+ * Enrolled embeddings for one embedding model, each with a binary code (sign bits of a fixed random
+ * rotation). A search ranks every code by Hamming distance with hardware popcount, then scores the
+ * `rerank` closest with float dot products. Searches may run concurrently from any thread. */
+
+FD_API int fd_gallery_open(int dimension, fd_gallery** gallery);
+FD_API void fd_gallery_close(fd_gallery* gallery);
+/* Adds or replaces the embedding for `id`. The embedding is normalized; a zero vector is rejected. */
+FD_API int fd_gallery_add(fd_gallery* gallery, int64_t id, const float* embedding, int dimension);
+/* Returns 1 if `id` was removed, 0 if it was not enrolled. */
+FD_API int fd_gallery_remove(fd_gallery* gallery, int64_t id);
+FD_API void fd_gallery_search_options_init(fd_gallery_search_options* options);
+/* Returns the number of matches written (best first), or a negative fd_status. */
+FD_API int fd_gallery_search(fd_gallery* gallery, const float* query, int dimension,
+                             const fd_gallery_search_options* options, fd_gallery_match* matches, int capacity);
+FD_API void fd_gallery_search_report_init(fd_gallery_search_report* report);
+/* fd_gallery_search that also reports the effort spent (v12); `report` may be NULL. */
+FD_API int fd_gallery_search_ex(fd_gallery* gallery, const float* query, int dimension,
+                                const fd_gallery_search_options* options, fd_gallery_match* matches, int capacity,
+                                fd_gallery_search_report* report);
+/* Searches `queryCount` contiguous queries in one pass over the gallery (v11): each block of rows is
+ * scored against every query while it is in cache. `matches` holds queryCount rows of `capacity`
+ * entries; counts[i] receives the number written for query i. A budget applies to each query's
+ * rerank, after the shared code pass. */
+FD_API int fd_gallery_search_batch(fd_gallery* gallery, const float* queries, int queryCount, int dimension,
+                                   const fd_gallery_search_options* options, fd_gallery_match* matches,
+                                   int capacity, int* counts);
+FD_API void fd_gallery_stats_init(fd_gallery_stats* stats);
+FD_API int fd_gallery_get_stats(fd_gallery* gallery, fd_gallery_stats* stats);
+
+/* ---- Gallery replication (v14) ----
+ * Every add, update and remove gets a sequence number and is kept in a bounded change log. A warm
+ * standby loads a snapshot once, then applies the deltas after its own sequence in order. A replica
+ * that fell behind the log, or follows a restarted primary (new epoch), gets FD_ERR_STALE and loads
+ * a snapshot again. Blobs use native byte order. Replicas should not be written to directly. */
+
+/* fd_gallery_add with an opaque payload (the caller's metadata for the face) replicated with it. */
+FD_API int fd_gallery_add_ex(fd_gallery* gallery, int64_t id, const float* embedding, int dimension,
+                             const uint8_t* payload, size_t payloadLength);
+FD_API uint64_t fd_gallery_sequence(fd_gallery* gallery);
+/* Changes kept for fd_gallery_export_delta (default 4096). */
+FD_API int fd_gallery_set_log_capacity(fd_gallery* gallery, int entries);
+/* Up to maxEntries changes after afterSequence; FD_ERR_STALE if the log no longer reaches back that far. */
+FD_API int fd_gallery_export_delta(fd_gallery* gallery, uint64_t afterSequence, int maxEntries, fd_gallery_blob** blob);
+FD_API int fd_gallery_export_snapshot(fd_gallery* gallery, fd_gallery_blob** blob);
+FD_API void fd_gallery_blob_free(fd_gallery_blob* blob);
+/* Applies the changes after this gallery's sequence. Returns how many were applied, FD_ERR_STALE on
+ * an epoch change or gap, or FD_ERR_DECODE for a malformed blob. `callback` may be NULL. */
+FD_API int fd_gallery_apply_delta(fd_gallery* gallery, const uint8_t* data, size_t size,
+                                  fd_gallery_change_callback callback, void* user);
+/* Replaces every row and adopts the primary's epoch and sequence; each row is reported as an add.
+ * Returns the number of rows, or FD_ERR_DECODE. */
+FD_API int fd_gallery_load_snapshot(fd_gallery* gallery, const uint8_t* data, size_t size,
+                                    fd_gallery_change_callback callback, void* user);
+
+/* ---- Retroactive matching (v13) ----
+ * Embeddings of detections that matched nobody, partitioned by organization in detection-time order.
+ * When a person is enrolled, their new embeddings are scored against one organization's time window
+ * in a single batched pass, and detections that clear the threshold come back as candidate links.
+ * Each organization keeps at most `maxPerOrganization` rows, evicting the oldest. */
+
+FD_API int fd_unknown_faces_open(int dimension, int maxPerOrganization, fd_unknown_faces** store);
+FD_API void fd_unknown_faces_close(fd_unknown_faces* store);
+/* Adds a detection's embedding; one already stored is left as is. A zero vector is rejected. */
+FD_API int fd_unknown_faces_add(fd_unknown_faces* store, int64_t detectionId, int64_t organizationId,
+                                int64_t detectedAtMs, const float* embedding, int dimension);
+/* Removes linked or deleted detections; returns how many were stored, or a negative fd_status. */
+FD_API int fd_unknown_faces_remove(fd_unknown_faces* store, const int64_t* detectionIds, int count);
+FD_API void fd_unknown_match_options_init(fd_unknown_match_options* options);
+/* Scores `queryCount` contiguous queries against the organization's window. Returns the number of
+ * links written (best first, one per detection), or a negative fd_status. */
+FD_API int fd_unknown_faces_match(fd_unknown_faces* store, const float* queries, int queryCount, int dimension,
+                                  const fd_unknown_match_options* options, fd_unknown_link* links, int capacity);
+FD_API void fd_unknown_stats_init(fd_unknown_stats* stats);
+FD_API int fd_unknown_faces_get_stats(fd_unknown_faces* store, fd_unknown_stats* stats);
+
+/* ---- Rolling counters (v15) ----
+ * Detection counts per organization, camera, event and person in minute, hour and day buckets.
+ * Each series keeps a fixed ring per granularity, so memory depends on the number of series, not
+ * on how many detections were counted. One snapshot returns every series of an organization. */
+
+FD_API void fd_counters_config_init(fd_counters_config* config);
+FD_API int fd_counters_open(const fd_counters_config* config, fd_counters** counters);
+FD_API void fd_counters_close(fd_counters* counters);
+FD_API void fd_counter_increment_init(fd_counter_increment* increment);
+/* `increments` is an array of `count` structs, all of the first one's structSize. */
+FD_API int fd_counters_add(fd_counters* counters, const fd_counter_increment* increments, int count);
+FD_API void fd_counter_query_init(fd_counter_query* query);
+FD_API int fd_counters_snapshot(fd_counters* counters, const fd_counter_query* query, fd_counter_snapshot** snapshot);
+FD_API void fd_counter_snapshot_free(fd_counter_snapshot* snapshot);
+/* Writes every series to `path` through a temporary file, so a crash leaves the previous file intact. */
+FD_API int fd_counters_save(fd_counters* counters, const char* path);
+/* Replaces the counters with a saved file. FD_ERR_DECODE if it is missing, damaged or was saved with
+ * other bucket counts or UTC offset; the counters are then unchanged. */
+FD_API int fd_counters_load(fd_counters* counters, const char* path);
+FD_API void fd_counters_stats_init(fd_counters_stats* stats);
+FD_API int fd_counters_get_stats(fd_counters* counters, fd_counters_stats* stats);
+
+/* ---- Watchlist (v17) ----
+ * A small set of priority embeddings checked with an exact scan against every face a detector
+ * embeds, before the frame's other faces and before the result is returned. A hit calls the
+ * detector's watchlist callback right away. Only camera frames are checked (cameraId >= 0,
+ * without allTiers). The detector keeps its own reference, so the watchlist may be closed while attached. */
+
+FD_API int fd_watchlist_open(float threshold, fd_watchlist** watchlist);
+FD_API void fd_watchlist_close(fd_watchlist* watchlist);
+FD_API void fd_watchlist_entry_init(fd_watchlist_entry* entry);
+/* `entries` is an array of `count` structs, all of the first one's structSize. Returns the number kept. */
+FD_API int fd_watchlist_add(fd_watchlist* watchlist, const fd_watchlist_entry* entries, int count);
+/* Replaces every entry at once, so checks never see a partly loaded list. Returns the number kept. */
+FD_API int fd_watchlist_reset(fd_watchlist* watchlist, const fd_watchlist_entry* entries, int count);
+/* Returns 1 if the id was listed, 0 if not. */
+FD_API int fd_watchlist_remove(fd_watchlist* watchlist, int64_t id);
+/* Returns 1 and fills `hit` with the best entry reaching its threshold, 0 when none does.
+ * organizationId -1 checks every organization's entries. */
+FD_API int fd_watchlist_check(fd_watchlist* watchlist, const char* model, const float* embedding, int dimension,
+                              int64_t organizationId, fd_watchlist_hit* hit);
+FD_API void fd_watchlist_stats_init(fd_watchlist_stats* stats);
+FD_API int fd_watchlist_get_stats(fd_watchlist* watchlist, fd_watchlist_stats* stats);
+/* Attaches a watchlist (NULL detaches it). Once this returns, the previous callback is not called again. */
+FD_API int fd_set_watchlist(fd_detector* detector, fd_watchlist* watchlist, fd_watchlist_callback callback, void* userData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FACE_DETECTOR_C_API_H */
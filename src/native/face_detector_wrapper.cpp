@@ -1,10 +1,271 @@
 #include <napi.h>
-#include "face_detector.h"
+#include "face_detector_c_api.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Detection options parsed from JS; the tier name is kept alongside so the C struct can point at it
+struct ParsedDetectionOptions {
+    fd_detect_options options;
+    std::string embeddingTier;
+
+    ParsedDetectionOptions() {
+        fd_detect_options_init(&options);
+    }
+
+    const fd_detect_options* get() {
+        options.embeddingTier = embeddingTier.empty() ? nullptr : embeddingTier.c_str();
+        return &options;
+    }
+};
+
+// Reads the optional detection options object ({ cameraId, eventId, organizationId, embeddingTier, allTiers, detectOnly })
+static ParsedDetectionOptions ParseDetectionOptions(const Napi::Value& value) {
+    ParsedDetectionOptions parsed;
+    if (!value.IsObject()) {
+        return parsed;
+    }
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Has("cameraId") && obj.Get("cameraId").IsNumber()) {
+        parsed.options.cameraId = obj.Get("cameraId").As<Napi::Number>().Int32Value();
+    }
+    if (obj.Has("eventId") && obj.Get("eventId").IsNumber()) {
+        parsed.options.eventId = obj.Get("eventId").As<Napi::Number>().Int64Value();
+    }
+    if (obj.Has("organizationId") && obj.Get("organizationId").IsNumber()) {
+        parsed.options.organizationId = obj.Get("organizationId").As<Napi::Number>().Int64Value();
+    }
+    if (obj.Has("embeddingTier") && obj.Get("embeddingTier").IsString()) {
+        parsed.embeddingTier = obj.Get("embeddingTier").As<Napi::String>().Utf8Value();
+    }
+    if (obj.Has("allTiers") && obj.Get("allTiers").IsBoolean()) {
+        parsed.options.allTiers = obj.Get("allTiers").As<Napi::Boolean>().Value() ? 1 : 0;
+    }
+    if (obj.Has("detectOnly") && obj.Get("detectOnly").IsBoolean()) {
+        parsed.options.detectOnly = obj.Get("detectOnly").As<Napi::Boolean>().Value() ? 1 : 0;
+    }
+    return parsed;
+}
+
+static Napi::Array EncodingToArray(Napi::Env env, const float* values, int32_t size) {
+    Napi::Array array = Napi::Array::New(env, size > 0 ? size : 0);
+    for (int32_t j = 0; j < size; j++) {
+        array.Set(static_cast<uint32_t>(j), Napi::Number::New(env, values[j]));
+    }
+    return array;
+}
+
+static Napi::Array SplitNames(Napi::Env env, const char* joined) {
+    Napi::Array names = Napi::Array::New(env);
+    std::stringstream stream(joined);
+    std::string name;
+    uint32_t count = 0;
+    while (std::getline(stream, name, ',')) {
+        if (!name.empty()) names.Set(count++, Napi::String::New(env, name));
+    }
+    return names;
+}
+
+// Per-stage counters plus the ratios worth reading: IPC, LLC miss rate, and misses per thousand instructions
+static Napi::Object ProfileReportToObject(Napi::Env env, const fd_profile_report& report) {
+    Napi::Object jsReport = Napi::Object::New(env);
+    jsReport.Set("countersAvailable", Napi::Boolean::New(env, report.countersAvailable != 0));
+    if (report.unavailableReason[0] != '\0') {
+        jsReport.Set("unavailableReason", Napi::String::New(env, report.unavailableReason));
+    }
+    jsReport.Set("durationMs", Napi::Number::New(env, report.durationMs));
+
+    Napi::Object stages = Napi::Object::New(env);
+    for (int i = 0; i < report.stageCount && i < FD_MAX_PROFILE_STAGES; i++) {
+        const fd_stage_profile& stage = report.stages[i];
+        Napi::Object jsStage = Napi::Object::New(env);
+        jsStage.Set("calls", Napi::Number::New(env, static_cast<double>(stage.calls)));
+        jsStage.Set("wallMs", Napi::Number::New(env, stage.wallMs));
+        jsStage.Set("avgMs", Napi::Number::New(env, stage.calls > 0 ? stage.wallMs / stage.calls : 0.0));
+        if (stage.countedCalls > 0) {
+            double instructions = static_cast<double>(stage.instructions);
+            double kiloInstructions = instructions / 1000.0;
+            jsStage.Set("countedCalls", Napi::Number::New(env, static_cast<double>(stage.countedCalls)));
+            jsStage.Set("cycles", Napi::Number::New(env, static_cast<double>(stage.cycles)));
+            jsStage.Set("instructions", Napi::Number::New(env, instructions));
+            jsStage.Set("ipc", Napi::Number::New(env, stage.cycles > 0 ? instructions / stage.cycles : 0.0));
+            jsStage.Set("llcReferences", Napi::Number::New(env, static_cast<double>(stage.llcReferences)));
+            jsStage.Set("llcMisses", Napi::Number::New(env, static_cast<double>(stage.llcMisses)));
+            jsStage.Set("llcMissRate", Napi::Number::New(env, stage.llcReferences > 0
+                ? static_cast<double>(stage.llcMisses) / stage.llcReferences : 0.0));
+            jsStage.Set("llcMpki", Napi::Number::New(env, kiloInstructions > 0 ? stage.llcMisses / kiloInstructions : 0.0));
+            jsStage.Set("branchMisses", Napi::Number::New(env, static_cast<double>(stage.branchMisses)));
+            jsStage.Set("branchMpki", Napi::Number::New(env, kiloInstructions > 0 ? stage.branchMisses / kiloInstructions : 0.0));
+        }
+        stages.Set(stage.stage, jsStage);
+    }
+    jsReport.Set("stages", stages);
+    return jsReport;
+}
+
+static Napi::Object DetectionResultToObject(Napi::Env env, const fd_result* result) {
+    Napi::Object jsResult = Napi::Object::New(env);
+    jsResult.Set("success", Napi::Boolean::New(env, result->status == FD_OK));
+    jsResult.Set("processingTimeMs", Napi::Number::New(env, static_cast<double>(result->processingTimeMs)));
+
+    if (result->frameId != 0) {
+        jsResult.Set("jobId", Napi::Number::New(env, static_cast<double>(result->frameId)));
+    }
+
+    if (result->status != FD_OK) {
+        jsResult.Set("error", Napi::String::New(env, result->error));
+        jsResult.Set("cancelled", Napi::Boolean::New(env, result->status == FD_ERR_CANCELLED));
+        return jsResult;
+    }
+
+    Napi::Array faces = Napi::Array::New(env, result->faceCount);
+    for (int32_t i = 0; i < result->faceCount; i++) {
+        const fd_face& face = result->faces[i];
+
+        Napi::Object jsFace = Napi::Object::New(env);
+
+        Napi::Object boundingBox = Napi::Object::New(env);
+        boundingBox.Set("x", Napi::Number::New(env, face.x));
+        boundingBox.Set("y", Napi::Number::New(env, face.y));
+        boundingBox.Set("width", Napi::Number::New(env, face.width));
+        boundingBox.Set("height", Napi::Number::New(env, face.height));
+
+        jsFace.Set("boundingBox", boundingBox);
+        jsFace.Set("confidence", Napi::Number::New(env, face.confidence));
+        jsFace.Set("quality", Napi::Number::New(env, face.quality));
+
+        // Add encoding array (empty array when no recognition model ran)
+        jsFace.Set("encoding", EncodingToArray(env, face.encoding, face.encodingSize));
+        jsFace.Set("embeddingModel", Napi::String::New(env, face.embeddingModel));
+
+        if (face.embeddingCount > 0) {
+            Napi::Object embeddings = Napi::Object::New(env);
+            for (int32_t j = 0; j < face.embeddingCount; j++) {
+                const fd_embedding& embedding = face.embeddings[j];
+                embeddings.Set(embedding.model, EncodingToArray(env, embedding.values, embedding.size));
+            }
+            jsFace.Set("embeddings", embeddings);
+        }
+
+        faces.Set(static_cast<uint32_t>(i), jsFace);
+    }
+
+    jsResult.Set("faces", faces);
+    return jsResult;
+}
+
+// Boxes of one frame before its embeddings (detectFacesAsync's onBoxes), copied off the detecting thread
+struct EarlyBoxes {
+    uint64_t jobId = 0;
+    int64_t processingTimeMs = 0;
+    std::vector<fd_face> faces; // Boxes and confidences only; the pointer fields are not copied
+};
+
+// One detectFacesAsync call's onBoxes delivery. Only touched on the JS thread once created:
+// boxes that arrive after the final result are dropped, so identities never precede their boxes.
+struct EarlyBoxesChannel {
+    Napi::ThreadSafeFunction onBoxes;
+    bool finalDelivered = false;
+};
+
+static Napi::Object EarlyBoxesToObject(Napi::Env env, const EarlyBoxes& boxes) {
+    Napi::Object jsResult = Napi::Object::New(env);
+    jsResult.Set("jobId", Napi::Number::New(env, static_cast<double>(boxes.jobId)));
+    jsResult.Set("processingTimeMs", Napi::Number::New(env, static_cast<double>(boxes.processingTimeMs)));
+
+    Napi::Array faces = Napi::Array::New(env, boxes.faces.size());
+    for (size_t i = 0; i < boxes.faces.size(); i++) {
+        const fd_face& face = boxes.faces[i];
+        Napi::Object boundingBox = Napi::Object::New(env);
+        boundingBox.Set("x", Napi::Number::New(env, face.x));
+        boundingBox.Set("y", Napi::Number::New(env, face.y));
+        boundingBox.Set("width", Napi::Number::New(env, face.width));
+        boundingBox.Set("height", Napi::Number::New(env, face.height));
+
+        Napi::Object jsFace = Napi::Object::New(env);
+        jsFace.Set("boundingBox", boundingBox);
+        jsFace.Set("confidence", Napi::Number::New(env, face.confidence));
+        faces.Set(static_cast<uint32_t>(i), jsFace);
+    }
+    jsResult.Set("faces", faces);
+    return jsResult;
+}
+
+static Napi::Object WatchlistAlertToObject(Napi::Env env, const fd_watchlist_alert& alert) {
+    Napi::Object boundingBox = Napi::Object::New(env);
+    boundingBox.Set("x", Napi::Number::New(env, alert.box.x));
+    boundingBox.Set("y", Napi::Number::New(env, alert.box.y));
+    boundingBox.Set("width", Napi::Number::New(env, alert.box.width));
+    boundingBox.Set("height", Napi::Number::New(env, alert.box.height));
+
+    Napi::Object jsAlert = Napi::Object::New(env);
+    jsAlert.Set("jobId", Napi::Number::New(env, static_cast<double>(alert.frameId)));
+    jsAlert.Set("cameraId", Napi::Number::New(env, alert.cameraId));
+    jsAlert.Set("faceIndex", Napi::Number::New(env, alert.faceIndex));
+    jsAlert.Set("boundingBox", boundingBox);
+    jsAlert.Set("confidence", Napi::Number::New(env, alert.confidence));
+    jsAlert.Set("id", Napi::Number::New(env, static_cast<double>(alert.hit.id)));
+    jsAlert.Set("organizationId", Napi::Number::New(env, static_cast<double>(alert.hit.organizationId)));
+    jsAlert.Set("similarity", Napi::Number::New(env, alert.hit.similarity));
+    jsAlert.Set("latencyMs", Napi::Number::New(env, alert.latencyMs));
+    jsAlert.Set("firedAtMs", Napi::Number::New(env, static_cast<double>(alert.firedAtMs)));
+    return jsAlert;
+}
+
+// Watchlist alerts, from detecting threads to the onAlert function given to setWatchlist
+struct WatchlistAlertChannel {
+    Napi::ThreadSafeFunction onAlert; // Unbounded queue: alerts never wait behind, or are refused for, other work
+    std::shared_ptr<std::atomic<uint64_t>> dropped; // The attached Watchlist's droppedAlerts
+
+    static void Deliver(const fd_watchlist_alert* alert, void* userData) {
+        WatchlistAlertChannel* channel = static_cast<WatchlistAlertChannel*>(userData);
+        fd_watchlist_alert* copy = new fd_watchlist_alert(*alert);
+        // With no queue limit a blocking call never blocks; it only fails once the function is closing
+        napi_status queued = channel->onAlert.BlockingCall(copy, [](Napi::Env env, Napi::Function onAlert, fd_watchlist_alert* data) {
+            std::unique_ptr<fd_watchlist_alert> owned(data);
+            onAlert.Call({WatchlistAlertToObject(env, *owned)});
+        });
+        if (queued != napi_ok) {
+            (*channel->dropped)++;
+            std::cerr << "Watchlist alert dropped: entry " << alert->hit.id << " on camera " << alert->cameraId
+                      << " (frame " << alert->frameId << "), the JavaScript callback is closing" << std::endl;
+            delete copy;
+        }
+    }
+};
+
+// Errors raised before a result exists (bad input, detector not initialized)
+static Napi::Object StatusToObject(Napi::Env env, int status) {
+    Napi::Object jsResult = Napi::Object::New(env);
+    jsResult.Set("success", Napi::Boolean::New(env, false));
+    jsResult.Set("processingTimeMs", Napi::Number::New(env, 0));
+    jsResult.Set("error", Napi::String::New(env, status == FD_ERR_NOT_INITIALIZED
+        ? "Detector not initialized or empty frame" : "Invalid image buffer"));
+    return jsResult;
+}
+
+struct ResultDeleter {
+    void operator()(fd_result* result) const { fd_result_free(result); }
+};
+using ResultPtr = std::unique_ptr<fd_result, ResultDeleter>;
+
+// Shared with in-flight AsyncWorkers, so a wrapper collected (or a worker thread torn down)
+// mid-detection only destroys the detector once the last worker is done with it
+using DetectorPtr = std::shared_ptr<fd_detector>;
 
 class FaceDetectorWrapper : public Napi::ObjectWrap<FaceDetectorWrapper> {
 private:
-    std::unique_ptr<FaceDetector> detector;
+    // The addon is a plain consumer of the C API in face_detector_c_api.h
+    DetectorPtr detector;
+    // Set while a watchlist is attached; fd_set_watchlist guarantees no alert uses it once detached
+    std::unique_ptr<WatchlistAlertChannel> watchlistChannel;
 
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports) {
@@ -13,8 +274,29 @@ public:
             InstanceMethod("initializeAsync", &FaceDetectorWrapper::Initialize), // Same method handles both
             InstanceMethod("detectFaces", &FaceDetectorWrapper::DetectFaces),
             InstanceMethod("detectFacesAsync", &FaceDetectorWrapper::DetectFacesAsync),
+            InstanceMethod("embedFace", &FaceDetectorWrapper::EmbedFace),
+            InstanceMethod("warmUp", &FaceDetectorWrapper::WarmUp),
+            InstanceMethod("profile", &FaceDetectorWrapper::Profile),
+            InstanceMethod("cancel", &FaceDetectorWrapper::Cancel),
+            InstanceMethod("setWatchlist", &FaceDetectorWrapper::SetWatchlist),
             InstanceMethod("setConfidenceThreshold", &FaceDetectorWrapper::SetConfidenceThreshold),
-            InstanceMethod("isInitialized", &FaceDetectorWrapper::IsInitialized)
+            InstanceMethod("isInitialized", &FaceDetectorWrapper::IsInitialized),
+            InstanceMethod("setTierPolicy", &FaceDetectorWrapper::SetTierPolicy),
+            InstanceMethod("pinCameraTier", &FaceDetectorWrapper::PinCameraTier),
+            InstanceMethod("getTierStats", &FaceDetectorWrapper::GetTierStats),
+            InstanceMethod("setCascadeConfig", &FaceDetectorWrapper::SetCascadeConfig),
+            InstanceMethod("clearCameraCascade", &FaceDetectorWrapper::ClearCameraCascade),
+            InstanceMethod("getCascadeStats", &FaceDetectorWrapper::GetCascadeStats),
+            InstanceMethod("setSamplingConfig", &FaceDetectorWrapper::SetSamplingConfig),
+            InstanceMethod("clearCameraSampling", &FaceDetectorWrapper::ClearCameraSampling),
+            InstanceMethod("getSamplingInterval", &FaceDetectorWrapper::GetSamplingInterval),
+            InstanceMethod("getSamplingStats", &FaceDetectorWrapper::GetSamplingStats),
+            InstanceMethod("setLowPowerConfig", &FaceDetectorWrapper::SetLowPowerConfig),
+            InstanceMethod("getLowPowerStats", &FaceDetectorWrapper::GetLowPowerStats),
+            InstanceMethod("getCapabilities", &FaceDetectorWrapper::GetCapabilities),
+            InstanceMethod("getRuntimeStats", &FaceDetectorWrapper::GetRuntimeStats),
+            InstanceMethod("getModelLoadTimes", &FaceDetectorWrapper::GetModelLoadTimes),
+            InstanceMethod("isRecognitionReady", &FaceDetectorWrapper::IsRecognitionReady)
         });
 
         Napi::FunctionReference* constructor = new Napi::FunctionReference();
@@ -26,23 +308,38 @@ public:
     }
 
     FaceDetectorWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FaceDetectorWrapper>(info) {
-        detector = std::make_unique<FaceDetector>();
+        detector = DetectorPtr(fd_create(), fd_destroy);
+    }
+
+    ~FaceDetectorWrapper() {
+        DetachWatchlist();
     }
 
 private:
+    // setWatchlist(watchlist: Watchlist | null, onAlert?: (alert) => void): every face embedded from a camera
+    // frame is checked against the watchlist, and a hit calls onAlert before the frame's result is delivered
+    Napi::Value SetWatchlist(const Napi::CallbackInfo& info);
+
+    void DetachWatchlist() {
+        if (!watchlistChannel) return;
+        fd_set_watchlist(detector.get(), nullptr, nullptr, nullptr);
+        watchlistChannel->onAlert.Release();
+        watchlistChannel.reset();
+    }
+
     class InitializeAsyncWorker : public Napi::AsyncWorker {
     private:
-        FaceDetector* detector;
+        DetectorPtr detector;
         std::string modelPath;
-        bool useDeepLearning;
+        fd_init_options options;
         bool success;
 
     public:
-        InitializeAsyncWorker(Napi::Function& callback, FaceDetector* det, const std::string& path, bool useDL)
-            : Napi::AsyncWorker(callback), detector(det), modelPath(path), useDeepLearning(useDL), success(false) {}
+        InitializeAsyncWorker(Napi::Function& callback, DetectorPtr det, const std::string& path, const fd_init_options& opts)
+            : Napi::AsyncWorker(callback), detector(det), modelPath(path), options(opts), success(false) {}
 
         void Execute() override {
-            success = detector->initialize(modelPath, useDeepLearning);
+            success = fd_initialize_ex(detector.get(), modelPath.c_str(), &options) == FD_OK;
         }
 
         void OnOK() override {
@@ -55,27 +352,38 @@ private:
         Napi::Env env = info.Env();
 
         std::string modelPath = "";
-        bool useDeepLearning = true;
+        fd_init_options options;
+        fd_init_options_init(&options);
 
         if (info.Length() > 0 && info[0].IsString()) {
             modelPath = info[0].As<Napi::String>().Utf8Value();
         }
 
         if (info.Length() > 1 && info[1].IsBoolean()) {
-            useDeepLearning = info[1].As<Napi::Boolean>().Value();
+            options.useDeepLearning = info[1].As<Napi::Boolean>().Value() ? 1 : 0;
+        }
+
+        // Optional { deferRecognition } before the callback
+        size_t callbackIndex = 2;
+        if (info.Length() > 2 && info[2].IsObject() && !info[2].IsFunction()) {
+            Napi::Object obj = info[2].As<Napi::Object>();
+            if (obj.Has("deferRecognition") && obj.Get("deferRecognition").IsBoolean()) {
+                options.deferRecognition = obj.Get("deferRecognition").As<Napi::Boolean>().Value() ? 1 : 0;
+            }
+            callbackIndex = 3;
         }
 
-        if (info.Length() > 2 && info[2].IsFunction()) {
+        if (info.Length() > callbackIndex && info[callbackIndex].IsFunction()) {
             // Async version with callback
-            Napi::Function callback = info[2].As<Napi::Function>();
+            Napi::Function callback = info[callbackIndex].As<Napi::Function>();
             InitializeAsyncWorker* worker = new InitializeAsyncWorker(
-                callback, detector.get(), modelPath, useDeepLearning
+                callback, detector, modelPath, options
             );
             worker->Queue();
             return env.Undefined();
         } else {
             // Sync version (may block - use with caution)
-            bool success = detector->initialize(modelPath, useDeepLearning);
+            bool success = fd_initialize_ex(detector.get(), modelPath.c_str(), &options) == FD_OK;
             return Napi::Boolean::New(env, success);
         }
     }
@@ -89,129 +397,300 @@ private:
         }
 
         Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-        DetectionResult result = detector->detectFacesFromBuffer(buffer.Data(), buffer.Length());
+        ParsedDetectionOptions options = info.Length() > 1 ? ParseDetectionOptions(info[1]) : ParsedDetectionOptions();
+        fd_result* raw = nullptr;
+        int status = fd_detect_encoded(detector.get(), buffer.Data(), buffer.Length(), options.get(), &raw);
+        ResultPtr result(raw);
 
-        Napi::Object jsResult = Napi::Object::New(env);
-        jsResult.Set("success", Napi::Boolean::New(env, result.success));
-        jsResult.Set("processingTimeMs", Napi::Number::New(env, result.processingTimeMs));
+        return result ? DetectionResultToObject(env, result.get()) : StatusToObject(env, status);
+    }
 
-        if (!result.success) {
-            jsResult.Set("error", Napi::String::New(env, result.error));
-            return jsResult;
-        }
+    class DetectFacesAsyncWorker : public Napi::AsyncWorker {
+    private:
+        DetectorPtr detector;
+        std::vector<uint8_t> imageData;
+        ParsedDetectionOptions options;
+        std::shared_ptr<EarlyBoxesChannel> early; // Null without onBoxes
+        ResultPtr result;
+        int status;
 
-        Napi::Array faces = Napi::Array::New(env, result.faces.size());
-        for (size_t i = 0; i < result.faces.size(); i++) {
-            const DetectedFace& face = result.faces[i];
+        // Detecting thread: copy the boxes, then hand them to the JS thread
+        static void OnBoxes(const fd_result* boxes, void* userData) {
+            std::shared_ptr<EarlyBoxesChannel> channel = static_cast<DetectFacesAsyncWorker*>(userData)->early;
+            EarlyBoxes* copy = new EarlyBoxes();
+            copy->jobId = boxes->frameId;
+            copy->processingTimeMs = boxes->processingTimeMs;
+            for (int32_t i = 0; i < boxes->faceCount; i++) {
+                fd_face face = {};
+                face.x = boxes->faces[i].x;
+                face.y = boxes->faces[i].y;
+                face.width = boxes->faces[i].width;
+                face.height = boxes->faces[i].height;
+                face.confidence = boxes->faces[i].confidence;
+                copy->faces.push_back(face);
+            }
+            napi_status queued = channel->onBoxes.NonBlockingCall(copy, [channel](Napi::Env env, Napi::Function onBoxes, EarlyBoxes* data) {
+                std::unique_ptr<EarlyBoxes> owned(data);
+                if (!channel->finalDelivered) {
+                    onBoxes.Call({EarlyBoxesToObject(env, *owned)});
+                }
+            });
+            if (queued != napi_ok) {
+                delete copy;
+            }
+        }
 
-            Napi::Object jsFace = Napi::Object::New(env);
+    public:
+        DetectFacesAsyncWorker(Napi::Function& callback, DetectorPtr det, const uint8_t* data, size_t length, const ParsedDetectionOptions& opts,
+                               std::shared_ptr<EarlyBoxesChannel> earlyBoxes)
+            : Napi::AsyncWorker(callback), detector(det), imageData(data, data + length), options(opts), early(std::move(earlyBoxes)), status(FD_OK) {
+            if (early) {
+                options.options.boxesCallback = &DetectFacesAsyncWorker::OnBoxes;
+                options.options.boxesUserData = this;
+            }
+        }
 
-            Napi::Object boundingBox = Napi::Object::New(env);
-            boundingBox.Set("x", Napi::Number::New(env, face.boundingBox.x));
-            boundingBox.Set("y", Napi::Number::New(env, face.boundingBox.y));
-            boundingBox.Set("width", Napi::Number::New(env, face.boundingBox.width));
-            boundingBox.Set("height", Napi::Number::New(env, face.boundingBox.height));
+        // Releases the reserved job if the worker is dropped without running (e.g. env teardown)
+        ~DetectFacesAsyncWorker() override {
+            fd_release_job(detector.get(), options.options.jobId);
+        }
 
-            jsFace.Set("boundingBox", boundingBox);
-            jsFace.Set("confidence", Napi::Number::New(env, face.confidence));
+        void Execute() override {
+            fd_result* raw = nullptr;
+            status = fd_detect_encoded(detector.get(), imageData.data(), imageData.size(), options.get(), &raw);
+            result.reset(raw);
+        }
 
-            // Add encoding array
-            if (!face.encoding.empty()) {
-                Napi::Array encoding = Napi::Array::New(env, face.encoding.size());
-                for (size_t j = 0; j < face.encoding.size(); j++) {
-                    encoding.Set(j, Napi::Number::New(env, face.encoding[j]));
-                }
-                jsFace.Set("encoding", encoding);
-            } else {
-                jsFace.Set("encoding", Napi::Array::New(env, 0)); // Empty array
+        void OnOK() override {
+            Napi::Env env = Env();
+            if (early) {
+                early->finalDelivered = true;
             }
+            Callback().Call({env.Null(), result ? DetectionResultToObject(env, result.get()) : StatusToObject(env, status)});
+            if (early) {
+                early->onBoxes.Release();
+            }
+        }
+    };
+
+    Napi::Value DetectFacesAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
 
-            faces.Set(i, jsFace);
+        // Accepts (Buffer, Function) or (Buffer, options, Function)
+        size_t callbackIndex = info.Length() > 2 ? 2 : 1;
+        if (info.Length() < 2 || !info[0].IsBuffer() || !info[callbackIndex].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (Buffer, [options], Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
         }
 
-        jsResult.Set("faces", faces);
-        return jsResult;
+        Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+        ParsedDetectionOptions options = callbackIndex == 2 ? ParseDetectionOptions(info[1]) : ParsedDetectionOptions();
+        Napi::Function callback = info[callbackIndex].As<Napi::Function>();
+
+        // options.onBoxes(boxes): the frame's boxes as soon as detection finishes, before the callback gets identities
+        std::shared_ptr<EarlyBoxesChannel> early;
+        if (callbackIndex == 2 && info[1].IsObject() && info[1].As<Napi::Object>().Get("onBoxes").IsFunction()) {
+            early = std::make_shared<EarlyBoxesChannel>();
+            early->onBoxes = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Object>().Get("onBoxes").As<Napi::Function>(),
+                                                           "FaceDetector.onBoxes", 0, 1);
+        }
+
+        // Reserved before queueing, so cancel() can drop the frame while it waits for a worker thread
+        uint64_t jobId = 0;
+        fd_reserve_job(detector.get(), options.get(), &jobId);
+        options.options.jobId = jobId;
+
+        DetectFacesAsyncWorker* worker = new DetectFacesAsyncWorker(
+            callback, detector, buffer.Data(), buffer.Length(), options, early
+        );
+        worker->Queue();
+
+        return Napi::Number::New(env, static_cast<double>(jobId));
     }
 
-    class DetectFacesAsyncWorker : public Napi::AsyncWorker {
+    class EmbedFaceAsyncWorker : public Napi::AsyncWorker {
     private:
-        FaceDetector* detector;
+        DetectorPtr detector;
         std::vector<uint8_t> imageData;
-        DetectionResult result;
+        fd_rect box;
+        ParsedDetectionOptions options;
+        ResultPtr result;
+        int status;
 
     public:
-        DetectFacesAsyncWorker(Napi::Function& callback, FaceDetector* det, const uint8_t* data, size_t length)
-            : Napi::AsyncWorker(callback), detector(det), imageData(data, data + length) {}
+        EmbedFaceAsyncWorker(Napi::Function& callback, DetectorPtr det, const uint8_t* data, size_t length,
+                             const fd_rect& faceBox, const ParsedDetectionOptions& opts)
+            : Napi::AsyncWorker(callback), detector(det), imageData(data, data + length), box(faceBox), options(opts), status(FD_OK) {}
+
+        ~EmbedFaceAsyncWorker() override {
+            fd_release_job(detector.get(), options.options.jobId);
+        }
 
         void Execute() override {
-            result = detector->detectFacesFromBuffer(imageData.data(), imageData.size());
+            fd_result* raw = nullptr;
+            status = fd_embed_encoded(detector.get(), imageData.data(), imageData.size(), &box, options.get(), &raw);
+            result.reset(raw);
         }
 
         void OnOK() override {
             Napi::Env env = Env();
-            Napi::Object jsResult = Napi::Object::New(env);
-            jsResult.Set("success", Napi::Boolean::New(env, result.success));
-            jsResult.Set("processingTimeMs", Napi::Number::New(env, result.processingTimeMs));
+            Callback().Call({env.Null(), result ? DetectionResultToObject(env, result.get()) : StatusToObject(env, status)});
+        }
+    };
 
-            if (!result.success) {
-                jsResult.Set("error", Napi::String::New(env, result.error));
-                Callback().Call({env.Null(), jsResult});
-                return;
-            }
+    // embedFace(Buffer, { x, y, width, height }, [options], Function) -> jobId.
+    // Re-embeds a known face box; only the JPEG rows/blocks covering it are decoded.
+    Napi::Value EmbedFace(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        size_t callbackIndex = info.Length() > 3 ? 3 : 2;
+        if (info.Length() < 3 || !info[0].IsBuffer() || !info[1].IsObject() || !info[callbackIndex].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (Buffer, { x, y, width, height }, [options], Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
 
-            Napi::Array faces = Napi::Array::New(env, result.faces.size());
-            for (size_t i = 0; i < result.faces.size(); i++) {
-                const DetectedFace& face = result.faces[i];
+        Napi::Object jsBox = info[1].As<Napi::Object>();
+        fd_rect box;
+        box.x = jsBox.Get("x").IsNumber() ? jsBox.Get("x").As<Napi::Number>().Int32Value() : 0;
+        box.y = jsBox.Get("y").IsNumber() ? jsBox.Get("y").As<Napi::Number>().Int32Value() : 0;
+        box.width = jsBox.Get("width").IsNumber() ? jsBox.Get("width").As<Napi::Number>().Int32Value() : 0;
+        box.height = jsBox.Get("height").IsNumber() ? jsBox.Get("height").As<Napi::Number>().Int32Value() : 0;
 
-                Napi::Object jsFace = Napi::Object::New(env);
+        Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+        ParsedDetectionOptions options = callbackIndex == 3 ? ParseDetectionOptions(info[2]) : ParsedDetectionOptions();
+        Napi::Function callback = info[callbackIndex].As<Napi::Function>();
 
-                Napi::Object boundingBox = Napi::Object::New(env);
-                boundingBox.Set("x", Napi::Number::New(env, face.boundingBox.x));
-                boundingBox.Set("y", Napi::Number::New(env, face.boundingBox.y));
-                boundingBox.Set("width", Napi::Number::New(env, face.boundingBox.width));
-                boundingBox.Set("height", Napi::Number::New(env, face.boundingBox.height));
+        uint64_t jobId = 0;
+        fd_reserve_job(detector.get(), options.get(), &jobId);
+        options.options.jobId = jobId;
 
-                jsFace.Set("boundingBox", boundingBox);
-                jsFace.Set("confidence", Napi::Number::New(env, face.confidence));
+        EmbedFaceAsyncWorker* worker = new EmbedFaceAsyncWorker(
+            callback, detector, buffer.Data(), buffer.Length(), box, options
+        );
+        worker->Queue();
 
-                // Add encoding array
-                if (!face.encoding.empty()) {
-                    Napi::Array encoding = Napi::Array::New(env, face.encoding.size());
-                    for (size_t j = 0; j < face.encoding.size(); j++) {
-                        encoding.Set(j, Napi::Number::New(env, face.encoding[j]));
-                    }
-                    jsFace.Set("encoding", encoding);
-                } else {
-                    jsFace.Set("encoding", Napi::Array::New(env, 0)); // Empty array
-                }
+        return Napi::Number::New(env, static_cast<double>(jobId));
+    }
 
-                faces.Set(i, jsFace);
-            }
+    class WarmUpAsyncWorker : public Napi::AsyncWorker {
+    private:
+        DetectorPtr detector;
+        int width;
+        int height;
+        int concurrency;
+        int status;
+        double elapsedMs;
+
+    public:
+        WarmUpAsyncWorker(Napi::Function& callback, DetectorPtr det, int w, int h, int n)
+            : Napi::AsyncWorker(callback), detector(det), width(w), height(h), concurrency(n), status(FD_OK), elapsedMs(0.0) {}
+
+        void Execute() override {
+            auto startTime = std::chrono::steady_clock::now();
+            status = fd_warm_up(detector.get(), width, height, concurrency);
+            elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        }
 
-            jsResult.Set("faces", faces);
-            Callback().Call({env.Null(), jsResult});
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("success", Napi::Boolean::New(env, status == FD_OK));
+            result.Set("warmUpMs", Napi::Number::New(env, elapsedMs));
+            Callback().Call({env.Null(), result});
         }
     };
 
-    Napi::Value DetectFacesAsync(const Napi::CallbackInfo& info) {
+    // warmUp(width, height, concurrency, callback) -> callback(null, { success, warmUpMs })
+    Napi::Value WarmUp(const Napi::CallbackInfo& info) {
         Napi::Env env = info.Env();
 
-        if (info.Length() < 2 || !info[0].IsBuffer() || !info[1].IsFunction()) {
-            Napi::TypeError::New(env, "Expected (Buffer, Function) as arguments").ThrowAsJavaScriptException();
+        if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (width, height, concurrency, Function) as arguments").ThrowAsJavaScriptException();
             return env.Undefined();
         }
 
-        Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-        Napi::Function callback = info[1].As<Napi::Function>();
-
-        DetectFacesAsyncWorker* worker = new DetectFacesAsyncWorker(
-            callback, detector.get(), buffer.Data(), buffer.Length()
+        Napi::Function callback = info[3].As<Napi::Function>();
+        WarmUpAsyncWorker* worker = new WarmUpAsyncWorker(
+            callback, detector,
+            info[0].As<Napi::Number>().Int32Value(),
+            info[1].As<Napi::Number>().Int32Value(),
+            info[2].As<Napi::Number>().Int32Value()
         );
         worker->Queue();
+        return env.Undefined();
+    }
+
+    // profile(durationMs, callback) -> callback(err, { countersAvailable, unavailableReason, durationMs, stages })
+    // Counts the detections that run during the window; the window is closed from a JS timer so no
+    // worker thread sits idle while it is open.
+    Napi::Value Profile(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (durationMs, Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        double durationMs = info[0].As<Napi::Number>().DoubleValue();
+        if (!(durationMs > 0)) {
+            Napi::RangeError::New(env, "durationMs must be positive").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        int status = fd_profile_start(detector.get());
+        if (status == FD_ERR_BUSY) {
+            Napi::Error::New(env, "A profile is already running on this detector").ThrowAsJavaScriptException();
+            return env.Undefined();
+        } else if (status != FD_OK) {
+            Napi::Error::New(env, "Failed to start profiling").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
 
+        DetectorPtr det = detector;
+        auto callback = std::make_shared<Napi::FunctionReference>(Napi::Persistent(info[1].As<Napi::Function>()));
+        Napi::Function finish = Napi::Function::New(env, [det, callback](const Napi::CallbackInfo& timerInfo) {
+            Napi::Env timerEnv = timerInfo.Env();
+            fd_profile_report report;
+            fd_profile_report_init(&report);
+            if (fd_profile_stop(det.get(), &report) != FD_OK) {
+                callback->Call({Napi::Error::New(timerEnv, "Profile window was not open").Value()});
+                return;
+            }
+            callback->Call({timerEnv.Null(), ProfileReportToObject(timerEnv, report)});
+        });
+        env.Global().Get("setTimeout").As<Napi::Function>().Call({finish, Napi::Number::New(env, durationMs)});
         return env.Undefined();
     }
 
+    // cancel(jobId) or cancel({ jobId, cameraId, eventId }) -> number of jobs cancelled.
+    // Queued frames are skipped without decoding; running ones stop before embedding.
+    Napi::Value Cancel(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        fd_cancel_filter filter;
+        fd_cancel_filter_init(&filter);
+
+        if (info.Length() > 0 && info[0].IsNumber()) {
+            filter.jobId = static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value());
+        } else if (info.Length() > 0 && info[0].IsObject()) {
+            Napi::Object obj = info[0].As<Napi::Object>();
+            if (obj.Has("jobId") && obj.Get("jobId").IsNumber()) {
+                filter.jobId = static_cast<uint64_t>(obj.Get("jobId").As<Napi::Number>().Int64Value());
+            }
+            if (obj.Has("cameraId") && obj.Get("cameraId").IsNumber()) {
+                filter.cameraId = obj.Get("cameraId").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("eventId") && obj.Get("eventId").IsNumber()) {
+                filter.eventId = obj.Get("eventId").As<Napi::Number>().Int64Value();
+            }
+        }
+
+        int cancelled = fd_cancel(detector.get(), &filter);
+        if (cancelled < 0) {
+            Napi::TypeError::New(env, "Expected a job id or { jobId, cameraId, eventId }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, cancelled);
+    }
+
     Napi::Value SetConfidenceThreshold(const Napi::CallbackInfo& info) {
         Napi::Env env = info.Env();
 
@@ -221,19 +700,1958 @@ private:
         }
 
         float threshold = info[0].As<Napi::Number>().FloatValue();
-        detector->setConfidenceThreshold(threshold);
+        fd_set_confidence_threshold(detector.get(), threshold);
 
         return env.Undefined();
     }
 
     Napi::Value IsInitialized(const Napi::CallbackInfo& info) {
         Napi::Env env = info.Env();
-        return Napi::Boolean::New(env, detector->isInitialized());
+        return Napi::Boolean::New(env, fd_is_initialized(detector.get()) != 0);
+    }
+
+    Napi::Value SetTierPolicy(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected a policy object as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        Napi::Object obj = info[0].As<Napi::Object>();
+        fd_tier_policy config;
+        fd_tier_policy_init(&config);
+        fd_get_tier_policy(detector.get(), &config);
+        if (obj.Has("highLoad") && obj.Get("highLoad").IsNumber()) {
+            config.highLoad = obj.Get("highLoad").As<Napi::Number>().FloatValue();
+        }
+        if (obj.Has("criticalLoad") && obj.Get("criticalLoad").IsNumber()) {
+            config.criticalLoad = obj.Get("criticalLoad").As<Napi::Number>().FloatValue();
+        }
+        if (obj.Has("lowQuality") && obj.Get("lowQuality").IsNumber()) {
+            config.lowQuality = obj.Get("lowQuality").As<Napi::Number>().FloatValue();
+        }
+        if (obj.Has("minDwellMs") && obj.Get("minDwellMs").IsNumber()) {
+            config.minDwellMs = obj.Get("minDwellMs").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("latencyBudgetMs") && obj.Get("latencyBudgetMs").IsNumber()) {
+            config.latencyBudgetMs = obj.Get("latencyBudgetMs").As<Napi::Number>().DoubleValue();
+        }
+        fd_set_tier_policy(detector.get(), &config);
+
+        return env.Undefined();
+    }
+
+    Napi::Value PinCameraTier(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (cameraId, tierName | null) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        int cameraId = info[0].As<Napi::Number>().Int32Value();
+        std::string tierName;
+        bool pin = info.Length() > 1 && info[1].IsString();
+        if (pin) {
+            tierName = info[1].As<Napi::String>().Utf8Value();
+        }
+        if (fd_pin_camera_tier(detector.get(), cameraId, pin ? tierName.c_str() : nullptr) != FD_OK) {
+            Napi::TypeError::New(env, "Unknown embedding tier").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return env.Undefined();
+    }
+
+    Napi::Value GetTierStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object stats = Napi::Object::New(env);
+
+        std::vector<fd_model_info> modelInfo(FD_MAX_TIERS);
+        int modelCount = std::min(fd_get_models(detector.get(), modelInfo.data(), FD_MAX_TIERS), FD_MAX_TIERS);
+        Napi::Array models = Napi::Array::New(env);
+        for (int i = 0; i < modelCount; i++) {
+            Napi::Object jsModel = Napi::Object::New(env);
+            jsModel.Set("name", Napi::String::New(env, modelInfo[i].name));
+            jsModel.Set("version", Napi::String::New(env, modelInfo[i].version));
+            jsModel.Set("inputWidth", Napi::Number::New(env, modelInfo[i].inputWidth));
+            jsModel.Set("inputHeight", Napi::Number::New(env, modelInfo[i].inputHeight));
+            models.Set(static_cast<uint32_t>(i), jsModel);
+        }
+        stats.Set("models", models);
+
+        std::vector<fd_camera_tier_stats> cameraStats(std::max(0, fd_get_camera_tier_stats(detector.get(), nullptr, 0)));
+        int cameraCount = fd_get_camera_tier_stats(detector.get(), cameraStats.data(), static_cast<int>(cameraStats.size()));
+        cameraCount = std::min(cameraCount, static_cast<int>(cameraStats.size()));
+
+        Napi::Object cameras = Napi::Object::New(env);
+        for (int c = 0; c < cameraCount; c++) {
+            const fd_camera_tier_stats& camera = cameraStats[c];
+            Napi::Object jsCamera = Napi::Object::New(env);
+            jsCamera.Set("tier", camera.tier >= 0
+                ? Napi::String::New(env, fd_tier_name(camera.tier))
+                : env.Null());
+            jsCamera.Set("pinned", Napi::Boolean::New(env, camera.pinned != 0));
+            jsCamera.Set("load", Napi::Number::New(env, camera.load));
+            jsCamera.Set("avgLatencyMs", Napi::Number::New(env, camera.avgLatencyMs));
+            Napi::Object selections = Napi::Object::New(env);
+            for (int i = 0; i < fd_tier_count(); i++) {
+                selections.Set(fd_tier_name(i), Napi::Number::New(env, static_cast<double>(camera.selections[i])));
+            }
+            jsCamera.Set("selections", selections);
+            cameras.Set(std::to_string(camera.cameraId), jsCamera);
+        }
+        stats.Set("cameras", cameras);
+
+        return stats;
+    }
+
+    // setCascadeConfig({ enabled, thumbnailWidth, minNeighbors, refreshFrames, refreshMs, holdFrames }, [cameraId]);
+    // without a camera the config is the default for every camera that has no override
+    Napi::Value SetCascadeConfig(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected a cascade config object as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        int cameraId = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : -1;
+        Napi::Object obj = info[0].As<Napi::Object>();
+        fd_cascade_config config;
+        fd_cascade_config_init(&config);
+        fd_get_cascade_config(detector.get(), cameraId, &config);
+        if (obj.Has("enabled") && obj.Get("enabled").IsBoolean()) {
+            config.enabled = obj.Get("enabled").As<Napi::Boolean>().Value() ? 1 : 0;
+        }
+        if (obj.Has("thumbnailWidth") && obj.Get("thumbnailWidth").IsNumber()) {
+            config.thumbnailWidth = obj.Get("thumbnailWidth").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("minNeighbors") && obj.Get("minNeighbors").IsNumber()) {
+            config.minNeighbors = obj.Get("minNeighbors").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("refreshFrames") && obj.Get("refreshFrames").IsNumber()) {
+            config.refreshFrames = obj.Get("refreshFrames").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("refreshMs") && obj.Get("refreshMs").IsNumber()) {
+            config.refreshMs = obj.Get("refreshMs").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("holdFrames") && obj.Get("holdFrames").IsNumber()) {
+            config.holdFrames = obj.Get("holdFrames").As<Napi::Number>().Int32Value();
+        }
+        if (fd_set_cascade_config(detector.get(), cameraId, &config) != FD_OK) {
+            Napi::RangeError::New(env, "Cascade config values must not be negative").ThrowAsJavaScriptException();
+        }
+
+        return env.Undefined();
+    }
+
+    Napi::Value ClearCameraCascade(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a camera id as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        fd_clear_cascade_config(detector.get(), info[0].As<Napi::Number>().Int32Value());
+        return env.Undefined();
+    }
+
+    // getCascadeStats() -> { available, config, cameras: { [cameraId]: { frames, prefilterPassRate, ... } } }
+    Napi::Value GetCascadeStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object stats = Napi::Object::New(env);
+
+        fd_capabilities capabilities;
+        fd_capabilities_init(&capabilities);
+        fd_get_capabilities(detector.get(), &capabilities);
+        stats.Set("available", Napi::Boolean::New(env, capabilities.cascadePrefilter != 0));
+
+        fd_cascade_config defaults;
+        fd_cascade_config_init(&defaults);
+        fd_get_cascade_config(detector.get(), -1, &defaults);
+        stats.Set("config", CascadeConfigToObject(env, defaults));
+
+        std::vector<fd_camera_cascade_stats> cameraStats(std::max(0, fd_get_camera_cascade_stats(detector.get(), nullptr, 0)));
+        int cameraCount = fd_get_camera_cascade_stats(detector.get(), cameraStats.data(), static_cast<int>(cameraStats.size()));
+        cameraCount = std::min(cameraCount, static_cast<int>(cameraStats.size()));
+
+        auto rate = [](uint64_t part, uint64_t total) { return total > 0 ? static_cast<double>(part) / total : 0.0; };
+        Napi::Object cameras = Napi::Object::New(env);
+        for (int c = 0; c < cameraCount; c++) {
+            const fd_camera_cascade_stats& camera = cameraStats[c];
+            Napi::Object jsCamera = Napi::Object::New(env);
+            jsCamera.Set("frames", Napi::Number::New(env, static_cast<double>(camera.frames)));
+            jsCamera.Set("prefilterFires", Napi::Number::New(env, static_cast<double>(camera.prefilterFires)));
+            jsCamera.Set("fullRuns", Napi::Number::New(env, static_cast<double>(camera.fullRuns)));
+            jsCamera.Set("holdRuns", Napi::Number::New(env, static_cast<double>(camera.holdRuns)));
+            jsCamera.Set("refreshRuns", Napi::Number::New(env, static_cast<double>(camera.refreshRuns)));
+            jsCamera.Set("fullHits", Napi::Number::New(env, static_cast<double>(camera.fullHits)));
+            jsCamera.Set("refreshHits", Napi::Number::New(env, static_cast<double>(camera.refreshHits)));
+            // Stage one pass rate, share of frames reaching the network, network yield and pre-filter miss rate
+            jsCamera.Set("prefilterPassRate", Napi::Number::New(env, rate(camera.prefilterFires, camera.frames)));
+            jsCamera.Set("fullRunRate", Napi::Number::New(env, rate(camera.fullRuns, camera.frames)));
+            jsCamera.Set("fullHitRate", Napi::Number::New(env, rate(camera.fullHits, camera.fullRuns)));
+            jsCamera.Set("prefilterMissRate", Napi::Number::New(env, rate(camera.refreshHits, camera.refreshRuns)));
+            jsCamera.Set("avgPrefilterMs", Napi::Number::New(env, camera.avgPrefilterMs));
+            jsCamera.Set("avgFullMs", Napi::Number::New(env, camera.avgFullMs));
+            if (camera.overridden) {
+                fd_cascade_config config;
+                fd_cascade_config_init(&config);
+                fd_get_cascade_config(detector.get(), camera.cameraId, &config);
+                jsCamera.Set("config", CascadeConfigToObject(env, config));
+            }
+            cameras.Set(std::to_string(camera.cameraId), jsCamera);
+        }
+        stats.Set("cameras", cameras);
+
+        return stats;
+    }
+
+    static Napi::Object CascadeConfigToObject(Napi::Env env, const fd_cascade_config& config) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("enabled", Napi::Boolean::New(env, config.enabled != 0));
+        obj.Set("thumbnailWidth", Napi::Number::New(env, config.thumbnailWidth));
+        obj.Set("minNeighbors", Napi::Number::New(env, config.minNeighbors));
+        obj.Set("refreshFrames", Napi::Number::New(env, config.refreshFrames));
+        obj.Set("refreshMs", Napi::Number::New(env, config.refreshMs));
+        obj.Set("holdFrames", Napi::Number::New(env, config.holdFrames));
+        return obj;
+    }
+
+    // setSamplingConfig({ minIntervalMs, maxIntervalMs, idleHalfLifeMs, motionThreshold, cpuBudget }, [cameraId]);
+    // cpuBudget is process-wide and only taken without a camera
+    Napi::Value SetSamplingConfig(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected a sampling config object as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        int cameraId = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : -1;
+        Napi::Object obj = info[0].As<Napi::Object>();
+        fd_sampling_config config;
+        fd_sampling_config_init(&config);
+        fd_get_sampling_config(detector.get(), cameraId, &config);
+        if (obj.Has("minIntervalMs") && obj.Get("minIntervalMs").IsNumber()) {
+            config.minIntervalMs = obj.Get("minIntervalMs").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("maxIntervalMs") && obj.Get("maxIntervalMs").IsNumber()) {
+            config.maxIntervalMs = obj.Get("maxIntervalMs").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("idleHalfLifeMs") && obj.Get("idleHalfLifeMs").IsNumber()) {
+            config.idleHalfLifeMs = obj.Get("idleHalfLifeMs").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("motionThreshold") && obj.Get("motionThreshold").IsNumber()) {
+            config.motionThreshold = obj.Get("motionThreshold").As<Napi::Number>().FloatValue();
+        }
+        if (fd_set_sampling_config(detector.get(), cameraId, &config) != FD_OK) {
+            Napi::RangeError::New(env, "Sampling intervals must satisfy 0 < minIntervalMs <= maxIntervalMs").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (cameraId < 0 && obj.Has("cpuBudget") && obj.Get("cpuBudget").IsNumber()) {
+            if (fd_set_sampling_budget(detector.get(), obj.Get("cpuBudget").As<Napi::Number>().FloatValue()) != FD_OK) {
+                Napi::RangeError::New(env, "cpuBudget must be positive").ThrowAsJavaScriptException();
+            }
+        }
+
+        return env.Undefined();
+    }
+
+    Napi::Value ClearCameraSampling(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a camera id as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        fd_clear_sampling_config(detector.get(), info[0].As<Napi::Number>().Int32Value());
+        return env.Undefined();
+    }
+
+    // getSamplingInterval(cameraId) -> milliseconds until the camera's next frame should be sampled
+    Napi::Value GetSamplingInterval(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a camera id as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return Napi::Number::New(env, fd_get_sampling_interval(detector.get(), info[0].As<Napi::Number>().Int32Value()));
+    }
+
+    // getSamplingStats() -> { config, cpuBudget, cameras: { [cameraId]: { intervalMs, fps, activity, ... } } }
+    Napi::Value GetSamplingStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object stats = Napi::Object::New(env);
+
+        fd_sampling_config defaults;
+        fd_sampling_config_init(&defaults);
+        fd_get_sampling_config(detector.get(), -1, &defaults);
+        stats.Set("config", SamplingConfigToObject(env, defaults));
+        stats.Set("cpuBudget", Napi::Number::New(env, fd_get_sampling_budget(detector.get())));
+
+        std::vector<fd_camera_sampling_stats> cameraStats(std::max(0, fd_get_camera_sampling_stats(detector.get(), nullptr, 0)));
+        int cameraCount = fd_get_camera_sampling_stats(detector.get(), cameraStats.data(), static_cast<int>(cameraStats.size()));
+        cameraCount = std::min(cameraCount, static_cast<int>(cameraStats.size()));
+
+        Napi::Object cameras = Napi::Object::New(env);
+        for (int c = 0; c < cameraCount; c++) {
+            const fd_camera_sampling_stats& camera = cameraStats[c];
+            Napi::Object jsCamera = Napi::Object::New(env);
+            jsCamera.Set("intervalMs", Napi::Number::New(env, camera.intervalMs));
+            jsCamera.Set("fps", Napi::Number::New(env, camera.intervalMs > 0.0 ? 1000.0 / camera.intervalMs : 0.0));
+            jsCamera.Set("desiredIntervalMs", Napi::Number::New(env, camera.desiredIntervalMs));
+            jsCamera.Set("activity", Napi::Number::New(env, camera.activity));
+            jsCamera.Set("motion", Napi::Number::New(env, camera.motion));
+            jsCamera.Set("faces", Napi::Number::New(env, camera.faces));
+            jsCamera.Set("budgetLimited", Napi::Boolean::New(env, camera.budgetLimited != 0));
+            jsCamera.Set("avgProcessingMs", Napi::Number::New(env, camera.avgProcessingMs));
+            jsCamera.Set("frames", Napi::Number::New(env, static_cast<double>(camera.frames)));
+            if (camera.overridden) {
+                fd_sampling_config config;
+                fd_sampling_config_init(&config);
+                fd_get_sampling_config(detector.get(), camera.cameraId, &config);
+                jsCamera.Set("config", SamplingConfigToObject(env, config));
+            }
+            cameras.Set(std::to_string(camera.cameraId), jsCamera);
+        }
+        stats.Set("cameras", cameras);
+
+        return stats;
+    }
+
+    static Napi::Object SamplingConfigToObject(Napi::Env env, const fd_sampling_config& config) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("minIntervalMs", Napi::Number::New(env, config.minIntervalMs));
+        obj.Set("maxIntervalMs", Napi::Number::New(env, config.maxIntervalMs));
+        obj.Set("idleHalfLifeMs", Napi::Number::New(env, config.idleHalfLifeMs));
+        obj.Set("motionThreshold", Napi::Number::New(env, config.motionThreshold));
+        return obj;
+    }
+
+    // setLowPowerConfig({ processWidth, scaleFactor, minNeighbors, minFaceSize, scaleBands, roiReuse, fullScanFrames, roiMargin })
+    Napi::Value SetLowPowerConfig(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected a low-power config object as argument").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        Napi::Object obj = info[0].As<Napi::Object>();
+        fd_low_power_config config;
+        fd_low_power_config_init(&config);
+        fd_get_low_power_config(detector.get(), &config);
+        if (obj.Has("processWidth") && obj.Get("processWidth").IsNumber()) {
+            config.processWidth = obj.Get("processWidth").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("scaleFactor") && obj.Get("scaleFactor").IsNumber()) {
+            config.scaleFactor = obj.Get("scaleFactor").As<Napi::Number>().FloatValue();
+        }
+        if (obj.Has("minNeighbors") && obj.Get("minNeighbors").IsNumber()) {
+            config.minNeighbors = obj.Get("minNeighbors").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("minFaceSize") && obj.Get("minFaceSize").IsNumber()) {
+            config.minFaceSize = obj.Get("minFaceSize").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("scaleBands") && obj.Get("scaleBands").IsNumber()) {
+            config.scaleBands = obj.Get("scaleBands").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("roiReuse") && obj.Get("roiReuse").IsBoolean()) {
+            config.roiReuse = obj.Get("roiReuse").As<Napi::Boolean>().Value() ? 1 : 0;
+        }
+        if (obj.Has("fullScanFrames") && obj.Get("fullScanFrames").IsNumber()) {
+            config.fullScanFrames = obj.Get("fullScanFrames").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("roiMargin") && obj.Get("roiMargin").IsNumber()) {
+            config.roiMargin = obj.Get("roiMargin").As<Napi::Number>().FloatValue();
+        }
+        if (fd_set_low_power_config(detector.get(), &config) != FD_OK) {
+            Napi::RangeError::New(env, "Low-power config values must not be negative and scaleFactor must be above 1").ThrowAsJavaScriptException();
+        }
+
+        return env.Undefined();
+    }
+
+    // getLowPowerStats() -> { active, detector, config, cameras: { [cameraId]: { frames, fullScans, roiScans, ... } } }
+    Napi::Value GetLowPowerStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object stats = Napi::Object::New(env);
+
+        fd_capabilities capabilities;
+        fd_capabilities_init(&capabilities);
+        fd_get_capabilities(detector.get(), &capabilities);
+        stats.Set("active", Napi::Boolean::New(env, capabilities.lowPower != 0));
+        stats.Set("detector", Napi::String::New(env, capabilities.detector));
+
+        fd_low_power_config config;
+        fd_low_power_config_init(&config);
+        fd_get_low_power_config(detector.get(), &config);
+        Napi::Object jsConfig = Napi::Object::New(env);
+        jsConfig.Set("processWidth", Napi::Number::New(env, config.processWidth));
+        jsConfig.Set("scaleFactor", Napi::Number::New(env, config.scaleFactor));
+        jsConfig.Set("minNeighbors", Napi::Number::New(env, config.minNeighbors));
+        jsConfig.Set("minFaceSize", Napi::Number::New(env, config.minFaceSize));
+        jsConfig.Set("scaleBands", Napi::Number::New(env, config.scaleBands));
+        jsConfig.Set("roiReuse", Napi::Boolean::New(env, config.roiReuse != 0));
+        jsConfig.Set("fullScanFrames", Napi::Number::New(env, config.fullScanFrames));
+        jsConfig.Set("roiMargin", Napi::Number::New(env, config.roiMargin));
+        stats.Set("config", jsConfig);
+
+        std::vector<fd_camera_low_power_stats> cameraStats(std::max(0, fd_get_camera_low_power_stats(detector.get(), nullptr, 0)));
+        int cameraCount = fd_get_camera_low_power_stats(detector.get(), cameraStats.data(), static_cast<int>(cameraStats.size()));
+        cameraCount = std::min(cameraCount, static_cast<int>(cameraStats.size()));
+
+        Napi::Object cameras = Napi::Object::New(env);
+        for (int c = 0; c < cameraCount; c++) {
+            const fd_camera_low_power_stats& camera = cameraStats[c];
+            Napi::Object jsCamera = Napi::Object::New(env);
+            jsCamera.Set("frames", Napi::Number::New(env, static_cast<double>(camera.frames)));
+            jsCamera.Set("fullScans", Napi::Number::New(env, static_cast<double>(camera.fullScans)));
+            jsCamera.Set("roiScans", Napi::Number::New(env, static_cast<double>(camera.roiScans)));
+            jsCamera.Set("roiMisses", Napi::Number::New(env, static_cast<double>(camera.roiMisses)));
+            jsCamera.Set("trackedFaces", Napi::Number::New(env, camera.trackedFaces));
+            jsCamera.Set("avgScanMs", Napi::Number::New(env, camera.avgScanMs));
+            cameras.Set(std::to_string(camera.cameraId), jsCamera);
+        }
+        stats.Set("cameras", cameras);
+
+        return stats;
+    }
+
+    // getCapabilities() -> { isa, cpuFeatures, compiledIsas, opencvVersion, detector, partialJpegDecode, cascadePrefilter, lowPower, embeddingModels, apiVersion }
+    Napi::Value GetCapabilities(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object caps = Napi::Object::New(env);
+
+        fd_capabilities capabilities;
+        fd_capabilities_init(&capabilities);
+        fd_get_capabilities(detector.get(), &capabilities);
+
+        caps.Set("isa", Napi::String::New(env, capabilities.isa));
+        caps.Set("cpuFeatures", SplitNames(env, capabilities.cpuFeatures));
+        caps.Set("compiledIsas", SplitNames(env, capabilities.compiledIsas));
+        caps.Set("opencvVersion", Napi::String::New(env, capabilities.opencvVersion));
+        caps.Set("detector", Napi::String::New(env, capabilities.detector));
+        caps.Set("partialJpegDecode", Napi::Boolean::New(env, capabilities.partialJpegDecode != 0));
+        caps.Set("cascadePrefilter", Napi::Boolean::New(env, capabilities.cascadePrefilter != 0));
+        caps.Set("lowPower", Napi::Boolean::New(env, capabilities.lowPower != 0));
+        caps.Set("apiVersion", Napi::Number::New(env, fd_api_version()));
+
+        std::vector<fd_model_info> modelInfo(FD_MAX_TIERS);
+        int modelCount = std::min(fd_get_models(detector.get(), modelInfo.data(), FD_MAX_TIERS), FD_MAX_TIERS);
+        Napi::Array models = Napi::Array::New(env);
+        for (int i = 0; i < modelCount; i++) {
+            models.Set(static_cast<uint32_t>(i), Napi::String::New(env, modelInfo[i].version));
+        }
+        caps.Set("embeddingModels", models);
+
+        return caps;
+    }
+
+    // getRuntimeStats() -> process-wide { sharedModels, netReplicas, netReplicaLimit, modelBytes, replicaBytes, heapBytes, executorThreads, executorUsers }
+    Napi::Value GetRuntimeStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        fd_runtime_stats runtime;
+        fd_runtime_stats_init(&runtime);
+        fd_get_runtime_stats(&runtime);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("sharedModels", Napi::Number::New(env, runtime.sharedModels));
+        stats.Set("netReplicas", Napi::Number::New(env, runtime.netReplicas));
+        stats.Set("netReplicaLimit", Napi::Number::New(env, runtime.netReplicaLimit));
+        stats.Set("modelBytes", Napi::Number::New(env, static_cast<double>(runtime.modelBytes)));
+        stats.Set("replicaBytes", Napi::Number::New(env, static_cast<double>(runtime.replicaBytes)));
+        stats.Set("heapBytes", Napi::Number::New(env, static_cast<double>(runtime.heapBytes)));
+        stats.Set("executorThreads", Napi::Number::New(env, runtime.executorThreads));
+        stats.Set("executorUsers", Napi::Number::New(env, runtime.executorUsers));
+        return stats;
+    }
+
+    // getModelLoadTimes() -> [{ name, role, loadMs, sizeBytes, reused, deferred }]
+    Napi::Value GetModelLoadTimes(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<fd_model_load> loads(FD_MAX_TIERS + 1);
+        int count = std::min(fd_get_model_load_times(detector.get(), loads.data(), static_cast<int>(loads.size())),
+                             static_cast<int>(loads.size()));
+
+        Napi::Array models = Napi::Array::New(env);
+        for (int i = 0; i < count; i++) {
+            Napi::Object model = Napi::Object::New(env);
+            model.Set("name", Napi::String::New(env, loads[i].name));
+            model.Set("role", Napi::String::New(env, loads[i].role));
+            model.Set("loadMs", Napi::Number::New(env, loads[i].loadMs));
+            model.Set("sizeBytes", Napi::Number::New(env, static_cast<double>(loads[i].sizeBytes)));
+            model.Set("reused", Napi::Boolean::New(env, loads[i].reused != 0));
+            model.Set("deferred", Napi::Boolean::New(env, loads[i].deferred != 0));
+            models.Set(static_cast<uint32_t>(i), model);
+        }
+        return models;
+    }
+
+    Napi::Value IsRecognitionReady(const Napi::CallbackInfo& info) {
+        return Napi::Boolean::New(info.Env(), fd_is_recognition_ready(detector.get()) != 0);
+    }
+};
+
+// Journal record from JS: { detectedAt, organizationId, cameraId, eventId, trackId, personFaceId, similarity,
+// confidence, boundingBox: { x, y, width, height }, faceStatus, detectionStatus, embedding, embeddingModel,
+// cropRef, metadata }. The strings and embedding are kept alongside so the C struct can point at them.
+struct ParsedJournalRecord {
+    fd_journal_record record;
+    std::vector<float> embedding;
+    std::string embeddingModel;
+    std::string cropRef;
+    std::string metadata;
+};
+
+static double NumberField(const Napi::Object& obj, const char* name, double fallback) {
+    Napi::Value value = obj.Get(name);
+    return value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : fallback;
+}
+
+static std::string StringField(const Napi::Object& obj, const char* name) {
+    Napi::Value value = obj.Get(name);
+    return value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+}
+
+static void ParseJournalRecord(const Napi::Object& obj, ParsedJournalRecord& parsed) {
+    fd_journal_record& record = parsed.record;
+    fd_journal_record_init(&record);
+    record.detectedAtMs = static_cast<int64_t>(NumberField(obj, "detectedAt", 0));
+    record.organizationId = static_cast<int32_t>(NumberField(obj, "organizationId", 0));
+    record.cameraId = static_cast<int32_t>(NumberField(obj, "cameraId", -1));
+    record.eventId = static_cast<int64_t>(NumberField(obj, "eventId", -1));
+    record.trackId = static_cast<int64_t>(NumberField(obj, "trackId", -1));
+    record.personFaceId = static_cast<int64_t>(NumberField(obj, "personFaceId", -1));
+    record.similarity = static_cast<float>(NumberField(obj, "similarity", 0));
+    record.confidence = static_cast<float>(NumberField(obj, "confidence", 0));
+    record.faceStatus = static_cast<int32_t>(NumberField(obj, "faceStatus", 0));
+    record.detectionStatus = static_cast<int32_t>(NumberField(obj, "detectionStatus", 0));
+
+    if (obj.Get("boundingBox").IsObject()) {
+        Napi::Object box = obj.Get("boundingBox").As<Napi::Object>();
+        record.x = static_cast<int32_t>(NumberField(box, "x", 0));
+        record.y = static_cast<int32_t>(NumberField(box, "y", 0));
+        record.width = static_cast<int32_t>(NumberField(box, "width", 0));
+        record.height = static_cast<int32_t>(NumberField(box, "height", 0));
+    }
+
+    Napi::Value embedding = obj.Get("embedding");
+    if (embedding.IsTypedArray() && embedding.As<Napi::TypedArray>().TypedArrayType() == napi_float32_array) {
+        Napi::Float32Array values = embedding.As<Napi::Float32Array>();
+        parsed.embedding.assign(values.Data(), values.Data() + values.ElementLength());
+    } else if (embedding.IsArray()) {
+        Napi::Array values = embedding.As<Napi::Array>();
+        parsed.embedding.resize(values.Length());
+        for (uint32_t i = 0; i < values.Length(); i++) {
+            parsed.embedding[i] = values.Get(i).As<Napi::Number>().FloatValue();
+        }
+    }
+    parsed.embeddingModel = StringField(obj, "embeddingModel");
+    parsed.cropRef = StringField(obj, "cropRef");
+    parsed.metadata = StringField(obj, "metadata");
+}
+
+static Napi::Object JournalRecordToObject(Napi::Env env, const fd_journal_record& record) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("seq", Napi::Number::New(env, static_cast<double>(record.seq)));
+    obj.Set("detectedAt", Napi::Number::New(env, static_cast<double>(record.detectedAtMs)));
+    obj.Set("organizationId", Napi::Number::New(env, record.organizationId));
+    obj.Set("cameraId", Napi::Number::New(env, record.cameraId));
+    obj.Set("eventId", Napi::Number::New(env, static_cast<double>(record.eventId)));
+    obj.Set("trackId", Napi::Number::New(env, static_cast<double>(record.trackId)));
+    obj.Set("personFaceId", Napi::Number::New(env, static_cast<double>(record.personFaceId)));
+    obj.Set("similarity", Napi::Number::New(env, record.similarity));
+    obj.Set("confidence", Napi::Number::New(env, record.confidence));
+    obj.Set("faceStatus", Napi::Number::New(env, record.faceStatus));
+    obj.Set("detectionStatus", Napi::Number::New(env, record.detectionStatus));
+
+    Napi::Object box = Napi::Object::New(env);
+    box.Set("x", Napi::Number::New(env, record.x));
+    box.Set("y", Napi::Number::New(env, record.y));
+    box.Set("width", Napi::Number::New(env, record.width));
+    box.Set("height", Napi::Number::New(env, record.height));
+    obj.Set("boundingBox", box);
+
+    Napi::Float32Array embedding = Napi::Float32Array::New(env, static_cast<size_t>(std::max(0, record.embeddingSize)));
+    if (record.embeddingSize > 0) {
+        std::copy(record.embedding, record.embedding + record.embeddingSize, embedding.Data());
+    }
+    obj.Set("embedding", embedding);
+    obj.Set("embeddingModel", Napi::String::New(env, record.embeddingModel));
+    obj.Set("cropRef", Napi::String::New(env, record.cropRef));
+    obj.Set("metadata", Napi::String::New(env, record.metadata));
+    return obj;
+}
+
+struct JournalDeleter {
+    void operator()(fd_journal_batch* batch) const { fd_journal_batch_free(batch); }
+};
+
+// new DetectionJournal(path, capacityBytes?) over the fd_journal_* functions. Appends and reads are
+// memory copies into the mapping, so they run on the calling thread.
+class DetectionJournalWrapper : public Napi::ObjectWrap<DetectionJournalWrapper> {
+private:
+    fd_journal* journal = nullptr;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "DetectionJournal", {
+            InstanceMethod("append", &DetectionJournalWrapper::Append),
+            InstanceMethod("read", &DetectionJournalWrapper::Read),
+            InstanceMethod("commit", &DetectionJournalWrapper::Commit),
+            InstanceMethod("sync", &DetectionJournalWrapper::Sync),
+            InstanceMethod("getStats", &DetectionJournalWrapper::GetStats),
+            InstanceMethod("close", &DetectionJournalWrapper::Close)
+        });
+
+        exports.Set("DetectionJournal", func);
+        return exports;
+    }
+
+    DetectionJournalWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<DetectionJournalWrapper>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected (path, capacityBytes?) as arguments").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string path = info[0].As<Napi::String>().Utf8Value();
+        uint64_t capacity = info.Length() > 1 && info[1].IsNumber()
+            ? static_cast<uint64_t>(info[1].As<Napi::Number>().Int64Value())
+            : 64ull * 1024 * 1024;
+        if (fd_journal_open(path.c_str(), capacity, &journal) != FD_OK) {
+            Napi::Error::New(env, "Cannot open detection journal " + path).ThrowAsJavaScriptException();
+        }
+    }
+
+    ~DetectionJournalWrapper() {
+        fd_journal_close(journal);
+    }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!journal) {
+            Napi::Error::New(env, "Detection journal is closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // append(records[]) -> seq of the last record, or null when the journal is full
+    Napi::Value Append(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected an array of records").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        Napi::Array input = info[0].As<Napi::Array>();
+        std::vector<ParsedJournalRecord> parsed(input.Length());
+        std::vector<fd_journal_record> records(input.Length());
+        for (uint32_t i = 0; i < input.Length(); i++) {
+            if (!input.Get(i).IsObject()) {
+                Napi::TypeError::New(env, "Expected an array of records").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            ParseJournalRecord(input.Get(i).As<Napi::Object>(), parsed[i]);
+            fd_journal_record& record = parsed[i].record;
+            record.embedding = parsed[i].embedding.empty() ? nullptr : parsed[i].embedding.data();
+            record.embeddingSize = static_cast<int32_t>(parsed[i].embedding.size());
+            record.embeddingModel = parsed[i].embeddingModel.c_str();
+            record.cropRef = parsed[i].cropRef.c_str();
+            record.metadata = parsed[i].metadata.c_str();
+            records[i] = record;
+        }
+
+        uint64_t lastSeq = 0;
+        int status = fd_journal_append(journal, records.data(), static_cast<int>(records.size()), &lastSeq);
+        if (status == FD_ERR_BUSY) {
+            return env.Null();
+        }
+        if (status != FD_OK) {
+            Napi::Error::New(env, "Detection journal append failed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, static_cast<double>(lastSeq));
+    }
+
+    // read(afterSeq, maxRecords) -> { records, lastSeq }
+    Napi::Value Read(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        uint64_t afterSeq = info.Length() > 0 && info[0].IsNumber()
+            ? static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value()) : 0;
+        int maxRecords = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : 500;
+
+        fd_journal_batch* raw = nullptr;
+        if (fd_journal_read(journal, afterSeq, maxRecords, &raw) != FD_OK) {
+            Napi::Error::New(env, "Detection journal read failed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::unique_ptr<fd_journal_batch, JournalDeleter> batch(raw);
+
+        Napi::Array records = Napi::Array::New(env, batch->count);
+        for (int32_t i = 0; i < batch->count; i++) {
+            records.Set(static_cast<uint32_t>(i), JournalRecordToObject(env, batch->records[i]));
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("records", records);
+        result.Set("lastSeq", Napi::Number::New(env, static_cast<double>(batch->lastSeq)));
+        return result;
+    }
+
+    Napi::Value Commit(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a sequence number").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        uint64_t seq = static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value());
+        return Napi::Boolean::New(env, fd_journal_commit(journal, seq) == FD_OK);
+    }
+
+    Napi::Value Sync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        return Napi::Boolean::New(env, fd_journal_sync(journal) == FD_OK);
+    }
+
+    // getStats() -> { capacity, usedBytes, lastSeq, committedSeq, appended, rejected, recovered, compactions, epoch (hex) }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_journal_stats journalStats;
+        fd_journal_stats_init(&journalStats);
+        fd_journal_get_stats(journal, &journalStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("capacity", Napi::Number::New(env, static_cast<double>(journalStats.capacity)));
+        stats.Set("usedBytes", Napi::Number::New(env, static_cast<double>(journalStats.usedBytes)));
+        stats.Set("lastSeq", Napi::Number::New(env, static_cast<double>(journalStats.lastSeq)));
+        stats.Set("committedSeq", Napi::Number::New(env, static_cast<double>(journalStats.committedSeq)));
+        stats.Set("appended", Napi::Number::New(env, static_cast<double>(journalStats.appended)));
+        stats.Set("rejected", Napi::Number::New(env, static_cast<double>(journalStats.rejected)));
+        stats.Set("recovered", Napi::Number::New(env, static_cast<double>(journalStats.recovered)));
+        stats.Set("compactions", Napi::Number::New(env, static_cast<double>(journalStats.compactions)));
+        char epoch[17];
+        std::snprintf(epoch, sizeof(epoch), "%016llx", static_cast<unsigned long long>(journalStats.epoch));
+        stats.Set("epoch", Napi::String::New(env, epoch));
+        return stats;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        fd_journal_close(journal);
+        journal = nullptr;
+        return info.Env().Undefined();
+    }
+};
+
+static Napi::Array PreviewUnitsToArray(Napi::Env env, const fd_preview_unit* units, int count) {
+    Napi::Array array = Napi::Array::New(env, count);
+    for (int i = 0; i < count; i++) {
+        Napi::Object unit = Napi::Object::New(env);
+        unit.Set("data", Napi::Buffer<uint8_t>::Copy(env, units[i].data, units[i].size));
+        unit.Set("keyframe", Napi::Boolean::New(env, units[i].keyframe != 0));
+        unit.Set("index", Napi::Number::New(env, static_cast<double>(units[i].index)));
+        array.Set(static_cast<uint32_t>(i), unit);
+    }
+    return array;
+}
+
+// new PreviewFragmenter(maxCacheBytes?) over the fd_preview_* functions: splits an ffmpeg H.264
+// stream into access units for the live preview WebSocket and caches the current GOP for joiners.
+class PreviewFragmenterWrapper : public Napi::ObjectWrap<PreviewFragmenterWrapper> {
+private:
+    fd_preview* preview = nullptr;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "PreviewFragmenter", {
+            InstanceMethod("push", &PreviewFragmenterWrapper::Push),
+            InstanceMethod("join", &PreviewFragmenterWrapper::Join),
+            InstanceMethod("getStats", &PreviewFragmenterWrapper::GetStats),
+            InstanceMethod("close", &PreviewFragmenterWrapper::Close)
+        });
+
+        exports.Set("PreviewFragmenter", func);
+        return exports;
+    }
+
+    PreviewFragmenterWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<PreviewFragmenterWrapper>(info) {
+        Napi::Env env = info.Env();
+        uint64_t maxCacheBytes = info.Length() > 0 && info[0].IsNumber()
+            ? static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value())
+            : 4ull * 1024 * 1024;
+        if (fd_preview_open(maxCacheBytes, &preview) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a positive cache size").ThrowAsJavaScriptException();
+        }
+    }
+
+    ~PreviewFragmenterWrapper() {
+        fd_preview_close(preview);
+    }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!preview) {
+            Napi::Error::New(env, "Preview fragmenter is closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // push(buffer) -> [{ data, keyframe, index }] for the access units the chunk completed
+    Napi::Value Push(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsBuffer()) {
+            Napi::TypeError::New(env, "Expected a Buffer").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Buffer<uint8_t> chunk = info[0].As<Napi::Buffer<uint8_t>>();
+        const fd_preview_unit* units = nullptr;
+        int count = 0;
+        if (fd_preview_push(preview, chunk.Data(), chunk.Length(), &units, &count) != FD_OK) {
+            Napi::Error::New(env, "Preview push failed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return PreviewUnitsToArray(env, units, count);
+    }
+
+    // join() -> the units since the last keyframe, to send a new viewer before the live ones
+    Napi::Value Join(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        const fd_preview_unit* units = nullptr;
+        int count = 0;
+        fd_preview_join(preview, &units, &count);
+        return PreviewUnitsToArray(env, units, count);
+    }
+
+    // getStats() -> { accessUnits, keyframes, bytesIn, bytesOut, cachedBytes, cachedUnits, droppedCache, codec }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_preview_stats previewStats;
+        fd_preview_stats_init(&previewStats);
+        fd_preview_get_stats(preview, &previewStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("accessUnits", Napi::Number::New(env, static_cast<double>(previewStats.accessUnits)));
+        stats.Set("keyframes", Napi::Number::New(env, static_cast<double>(previewStats.keyframes)));
+        stats.Set("bytesIn", Napi::Number::New(env, static_cast<double>(previewStats.bytesIn)));
+        stats.Set("bytesOut", Napi::Number::New(env, static_cast<double>(previewStats.bytesOut)));
+        stats.Set("cachedBytes", Napi::Number::New(env, static_cast<double>(previewStats.cachedBytes)));
+        stats.Set("cachedUnits", Napi::Number::New(env, static_cast<double>(previewStats.cachedUnits)));
+        stats.Set("droppedCache", Napi::Number::New(env, static_cast<double>(previewStats.droppedCache)));
+        stats.Set("codec", previewStats.codec[0] ? Napi::Value(Napi::String::New(env, previewStats.codec)) : env.Null());
+        return stats;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        fd_preview_close(preview);
+        preview = nullptr;
+        return info.Env().Undefined();
+    }
+};
+
+// Shared with in-flight batch searches, so close() only frees the gallery once they finish
+using GalleryPtr = std::shared_ptr<fd_gallery>;
+
+// Matches of one query as a JS array, best first
+static Napi::Array GalleryMatchesToArray(Napi::Env env, const fd_gallery_match* found, int count) {
+    Napi::Array matches = Napi::Array::New(env);
+    for (int i = 0; i < count; i++) {
+        Napi::Object match = Napi::Object::New(env);
+        match.Set("id", Napi::Number::New(env, static_cast<double>(found[i].id)));
+        match.Set("similarity", Napi::Number::New(env, found[i].similarity));
+        match.Set("hamming", Napi::Number::New(env, found[i].hamming));
+        matches.Set(static_cast<uint32_t>(i), match);
+    }
+    return matches;
+}
+
+class GallerySearchAsyncWorker : public Napi::AsyncWorker {
+private:
+    GalleryPtr gallery;
+    std::vector<float> queries;
+    int queryCount;
+    int dimension;
+    fd_gallery_search_options options;
+    std::vector<fd_gallery_match> matches;
+    std::vector<int> counts;
+    int status;
+
+public:
+    GallerySearchAsyncWorker(Napi::Function& callback, GalleryPtr g, std::vector<float>&& q, int n, int dim,
+                             const fd_gallery_search_options& opts)
+        : Napi::AsyncWorker(callback), gallery(g), queries(std::move(q)), queryCount(n), dimension(dim),
+          options(opts), matches(static_cast<size_t>(n) * opts.k), counts(n, 0), status(FD_OK) {}
+
+    void Execute() override {
+        status = fd_gallery_search_batch(gallery.get(), queries.data(), queryCount, dimension, &options,
+                                         matches.data(), options.k, counts.data());
+        if (status != FD_OK) {
+            SetError("Gallery batch search failed");
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array results = Napi::Array::New(env);
+        for (int q = 0; q < queryCount; q++) {
+            results.Set(static_cast<uint32_t>(q), GalleryMatchesToArray(env, matches.data() + static_cast<size_t>(q) * options.k, counts[q]));
+        }
+        Callback().Call({env.Null(), results});
+    }
+};
+
+// Enrolled embeddings of one model, searched with a binary-code prefilter and exact float rerank
+class EmbeddingGalleryWrapper : public Napi::ObjectWrap<EmbeddingGalleryWrapper> {
+private:
+    GalleryPtr gallery;
+    int dimension = 0;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "EmbeddingGallery", {
+            InstanceMethod("add", &EmbeddingGalleryWrapper::Add),
+            InstanceMethod("remove", &EmbeddingGalleryWrapper::Remove),
+            InstanceMethod("search", &EmbeddingGalleryWrapper::Search),
+            InstanceMethod("searchWithReport", &EmbeddingGalleryWrapper::SearchWithReport),
+            InstanceMethod("searchBatch", &EmbeddingGalleryWrapper::SearchBatch),
+            InstanceMethod("sequence", &EmbeddingGalleryWrapper::Sequence),
+            InstanceMethod("setLogCapacity", &EmbeddingGalleryWrapper::SetLogCapacity),
+            InstanceMethod("exportDelta", &EmbeddingGalleryWrapper::ExportDelta),
+            InstanceMethod("exportSnapshot", &EmbeddingGalleryWrapper::ExportSnapshot),
+            InstanceMethod("applyDelta", &EmbeddingGalleryWrapper::ApplyDelta),
+            InstanceMethod("loadSnapshot", &EmbeddingGalleryWrapper::LoadSnapshot),
+            InstanceMethod("getStats", &EmbeddingGalleryWrapper::GetStats),
+            InstanceMethod("close", &EmbeddingGalleryWrapper::Close)
+        });
+
+        exports.Set("EmbeddingGallery", func);
+        return exports;
+    }
+
+    EmbeddingGalleryWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<EmbeddingGalleryWrapper>(info) {
+        Napi::Env env = info.Env();
+        dimension = info.Length() > 0 && info[0].IsNumber() ? info[0].As<Napi::Number>().Int32Value() : 0;
+        fd_gallery* opened = nullptr;
+        if (fd_gallery_open(dimension, &opened) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a positive embedding dimension").ThrowAsJavaScriptException();
+            return;
+        }
+        gallery = GalleryPtr(opened, fd_gallery_close);
+    }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!gallery) {
+            Napi::Error::New(env, "Embedding gallery is closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // Optional { k, rerank, budgetMs, matchThreshold, margin, maxRerank }; false after throwing
+    bool SearchOptionsArg(Napi::Env env, const Napi::Value& value, fd_gallery_search_options& options) {
+        fd_gallery_search_options_init(&options);
+        if (value.IsObject()) {
+            Napi::Object obj = value.As<Napi::Object>();
+            if (obj.Has("k") && obj.Get("k").IsNumber()) {
+                options.k = obj.Get("k").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("rerank") && obj.Get("rerank").IsNumber()) {
+                options.rerank = obj.Get("rerank").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("budgetMs") && obj.Get("budgetMs").IsNumber()) {
+                options.budgetMs = obj.Get("budgetMs").As<Napi::Number>().DoubleValue();
+            }
+            if (obj.Has("matchThreshold") && obj.Get("matchThreshold").IsNumber()) {
+                options.matchThreshold = obj.Get("matchThreshold").As<Napi::Number>().FloatValue();
+            }
+            if (obj.Has("margin") && obj.Get("margin").IsNumber()) {
+                options.margin = obj.Get("margin").As<Napi::Number>().FloatValue();
+            }
+            if (obj.Has("maxRerank") && obj.Get("maxRerank").IsNumber()) {
+                options.maxRerank = obj.Get("maxRerank").As<Napi::Number>().Int32Value();
+            }
+        }
+        if (options.k <= 0 || options.rerank < 0 || options.maxRerank < 0 || options.budgetMs < 0) {
+            Napi::RangeError::New(env, "k must be positive; rerank, maxRerank and budgetMs non-negative").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // A Float32Array of the gallery's dimension, or nullptr after throwing
+    const float* EmbeddingArg(Napi::Env env, const Napi::Value& value) {
+        if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+            Napi::TypeError::New(env, "Expected a Float32Array embedding").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        Napi::Float32Array embedding = value.As<Napi::Float32Array>();
+        if (static_cast<int>(embedding.ElementLength()) != dimension) {
+            Napi::RangeError::New(env, "Embedding dimension does not match the gallery").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        return embedding.Data();
+    }
+
+    // add(id, embedding: Float32Array, payload?: string) -> false for a zero or non-finite embedding.
+    // The payload is replicated with the face to standbys.
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 2 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (id, Float32Array, payload?) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const float* embedding = EmbeddingArg(env, info[1]);
+        if (!embedding) return env.Undefined();
+        std::string payload = info.Length() > 2 && info[2].IsString() ? info[2].As<Napi::String>().Utf8Value() : std::string();
+        int status = fd_gallery_add_ex(gallery.get(), info[0].As<Napi::Number>().Int64Value(), embedding, dimension,
+                                       reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+        return Napi::Boolean::New(env, status == FD_OK);
+    }
+
+    // remove(id) -> whether it was enrolled
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected an id").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Boolean::New(env, fd_gallery_remove(gallery.get(), info[0].As<Napi::Number>().Int64Value()) == 1);
+    }
+
+    // search(query: Float32Array, options?) -> [{ id, similarity, hamming }], best first
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1) {
+            Napi::TypeError::New(env, "Expected a Float32Array query").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const float* query = EmbeddingArg(env, info[0]);
+        if (!query) return env.Undefined();
+
+        fd_gallery_search_options options;
+        if (!SearchOptionsArg(env, info.Length() > 1 ? info[1] : env.Undefined(), options)) return env.Undefined();
+
+        std::vector<fd_gallery_match> found(options.k);
+        int count = fd_gallery_search(gallery.get(), query, dimension, &options, found.data(), options.k);
+        return GalleryMatchesToArray(env, found.data(), std::max(0, count));
+    }
+
+    // searchWithReport(query: Float32Array, options?) -> { matches, report: { depth, elapsedMs, earlyExit, budgetExhausted } }
+    Napi::Value SearchWithReport(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1) {
+            Napi::TypeError::New(env, "Expected a Float32Array query").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const float* query = EmbeddingArg(env, info[0]);
+        if (!query) return env.Undefined();
+
+        fd_gallery_search_options options;
+        if (!SearchOptionsArg(env, info.Length() > 1 ? info[1] : env.Undefined(), options)) return env.Undefined();
+
+        std::vector<fd_gallery_match> found(options.k);
+        fd_gallery_search_report effort;
+        fd_gallery_search_report_init(&effort);
+        int count = fd_gallery_search_ex(gallery.get(), query, dimension, &options, found.data(), options.k, &effort);
+
+        Napi::Object report = Napi::Object::New(env);
+        report.Set("depth", Napi::Number::New(env, static_cast<double>(effort.depth)));
+        report.Set("elapsedMs", Napi::Number::New(env, effort.elapsedMs));
+        report.Set("earlyExit", Napi::Boolean::New(env, effort.earlyExit != 0));
+        report.Set("budgetExhausted", Napi::Boolean::New(env, effort.budgetExhausted != 0));
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("matches", GalleryMatchesToArray(env, found.data(), std::max(0, count)));
+        result.Set("report", report);
+        return result;
+    }
+
+    // searchBatch(queries: Float32Array[], { k, rerank }, callback) -> callback(err, matches[][]), one pass over
+    // the gallery for every query, off the event loop
+    Napi::Value SearchBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 3 || !info[0].IsArray() || !info[2].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (Float32Array[], options, Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        fd_gallery_search_options options;
+        if (!SearchOptionsArg(env, info[1], options)) return env.Undefined();
+
+        Napi::Array list = info[0].As<Napi::Array>();
+        int queryCount = static_cast<int>(list.Length());
+        std::vector<float> queries(static_cast<size_t>(queryCount) * dimension);
+        for (int q = 0; q < queryCount; q++) {
+            const float* query = EmbeddingArg(env, list.Get(static_cast<uint32_t>(q)));
+            if (!query) return env.Undefined();
+            std::copy(query, query + dimension, queries.begin() + static_cast<size_t>(q) * dimension);
+        }
+
+        Napi::Function callback = info[2].As<Napi::Function>();
+        GallerySearchAsyncWorker* worker = new GallerySearchAsyncWorker(callback, gallery, std::move(queries), queryCount, dimension, options);
+        worker->Queue();
+        return env.Undefined();
+    }
+
+    // sequence() -> last change made or applied
+    Napi::Value Sequence(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        return Napi::Number::New(env, static_cast<double>(fd_gallery_sequence(gallery.get())));
+    }
+
+    // setLogCapacity(entries) -> changes kept for exportDelta
+    Napi::Value SetLogCapacity(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        int entries = info.Length() > 0 && info[0].IsNumber() ? info[0].As<Napi::Number>().Int32Value() : -1;
+        if (fd_gallery_set_log_capacity(gallery.get(), entries) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a non-negative number of entries").ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    // A blob handed to JS without a copy; freed when the Buffer is collected
+    static Napi::Object BlobToObject(Napi::Env env, fd_gallery_blob* blob) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("sequence", Napi::Number::New(env, static_cast<double>(blob->sequence)));
+        result.Set("data", Napi::Buffer<uint8_t>::New(env, const_cast<uint8_t*>(blob->data), blob->size,
+                                                      [](Napi::Env, uint8_t*, fd_gallery_blob* owner) {
+                                                          fd_gallery_blob_free(owner);
+                                                      }, blob));
+        return result;
+    }
+
+    // exportDelta(afterSequence, maxEntries = 1024) -> { data: Buffer, sequence }, or null when the log no longer
+    // reaches back to afterSequence (the replica needs a snapshot)
+    Napi::Value ExportDelta(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        uint64_t afterSequence = info.Length() > 0 && info[0].IsNumber()
+            ? static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value()) : 0;
+        int maxEntries = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : 1024;
+        fd_gallery_blob* blob = nullptr;
+        int status = fd_gallery_export_delta(gallery.get(), afterSequence, maxEntries, &blob);
+        if (status == FD_ERR_STALE) return env.Null();
+        if (status != FD_OK) {
+            Napi::Error::New(env, "Gallery delta export failed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return BlobToObject(env, blob);
+    }
+
+    // exportSnapshot() -> { data: Buffer, sequence }
+    Napi::Value ExportSnapshot(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_gallery_blob* blob = nullptr;
+        if (fd_gallery_export_snapshot(gallery.get(), &blob) != FD_OK) {
+            Napi::Error::New(env, "Gallery snapshot export failed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return BlobToObject(env, blob);
+    }
+
+    struct Change {
+        fd_gallery_change_op op;
+        int64_t id;
+        std::string payload;
+    };
+
+    static void CollectChange(void* user, fd_gallery_change_op op, int64_t id, const uint8_t* payload, size_t length) {
+        static_cast<std::vector<Change>*>(user)->push_back({op, id, std::string(reinterpret_cast<const char*>(payload), length)});
+    }
+
+    static Napi::Array ChangesToArray(Napi::Env env, const std::vector<Change>& changes) {
+        Napi::Array result = Napi::Array::New(env, changes.size());
+        for (size_t i = 0; i < changes.size(); i++) {
+            const Change& change = changes[i];
+            Napi::Object entry = Napi::Object::New(env);
+            entry.Set("op", change.op == FD_GALLERY_ADD ? "add" : change.op == FD_GALLERY_UPDATE ? "update" : "remove");
+            entry.Set("id", Napi::Number::New(env, static_cast<double>(change.id)));
+            entry.Set("payload", Napi::String::New(env, change.payload));
+            result.Set(static_cast<uint32_t>(i), entry);
+        }
+        return result;
+    }
+
+    // applyDelta(data: Buffer) -> { applied, changes: [{ op: 'add' | 'update' | 'remove', id, payload }] }, or null
+    // when the delta is from another epoch or leaves a gap (the replica needs a snapshot)
+    Napi::Value ApplyDelta(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsBuffer()) {
+            Napi::TypeError::New(env, "Expected a delta Buffer").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Buffer<uint8_t> data = info[0].As<Napi::Buffer<uint8_t>>();
+        std::vector<Change> changes;
+        int applied = fd_gallery_apply_delta(gallery.get(), data.Data(), data.Length(), CollectChange, &changes);
+        if (applied == FD_ERR_STALE) return env.Null();
+        if (applied < 0) {
+            Napi::Error::New(env, "Malformed gallery delta").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("applied", Napi::Number::New(env, applied));
+        result.Set("changes", ChangesToArray(env, changes));
+        return result;
+    }
+
+    // loadSnapshot(data: Buffer) -> { rows, changes }, every row reported as an 'add'
+    Napi::Value LoadSnapshot(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsBuffer()) {
+            Napi::TypeError::New(env, "Expected a snapshot Buffer").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Buffer<uint8_t> data = info[0].As<Napi::Buffer<uint8_t>>();
+        std::vector<Change> changes;
+        int rows = fd_gallery_load_snapshot(gallery.get(), data.Data(), data.Length(), CollectChange, &changes);
+        if (rows < 0) {
+            Napi::Error::New(env, "Malformed gallery snapshot").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("rows", Napi::Number::New(env, rows));
+        result.Set("changes", ChangesToArray(env, changes));
+        return result;
+    }
+
+    // getStats() -> { size, dimension, codeBits, vectorBytes, codeBytes, searches, exactSearches, rescored, batches, batchedQueries,
+    //                 adaptiveSearches, earlyExits, budgetStops, adaptiveMs, epoch (hex), sequence, oldestLogged, logEntries,
+    //                 deltasApplied, snapshotsLoaded }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_gallery_stats galleryStats;
+        fd_gallery_stats_init(&galleryStats);
+        fd_gallery_get_stats(gallery.get(), &galleryStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("size", Napi::Number::New(env, static_cast<double>(galleryStats.size)));
+        stats.Set("dimension", Napi::Number::New(env, galleryStats.dimension));
+        stats.Set("codeBits", Napi::Number::New(env, galleryStats.codeBits));
+        stats.Set("vectorBytes", Napi::Number::New(env, static_cast<double>(galleryStats.vectorBytes)));
+        stats.Set("codeBytes", Napi::Number::New(env, static_cast<double>(galleryStats.codeBytes)));
+        stats.Set("searches", Napi::Number::New(env, static_cast<double>(galleryStats.searches)));
+        stats.Set("exactSearches", Napi::Number::New(env, static_cast<double>(galleryStats.exactSearches)));
+        stats.Set("rescored", Napi::Number::New(env, static_cast<double>(galleryStats.rescored)));
+        stats.Set("batches", Napi::Number::New(env, static_cast<double>(galleryStats.batches)));
+        stats.Set("batchedQueries", Napi::Number::New(env, static_cast<double>(galleryStats.batchedQueries)));
+        stats.Set("adaptiveSearches", Napi::Number::New(env, static_cast<double>(galleryStats.adaptiveSearches)));
+        stats.Set("earlyExits", Napi::Number::New(env, static_cast<double>(galleryStats.earlyExits)));
+        stats.Set("budgetStops", Napi::Number::New(env, static_cast<double>(galleryStats.budgetStops)));
+        stats.Set("adaptiveMs", Napi::Number::New(env, galleryStats.adaptiveMicros / 1000.0));
+        char epoch[17];
+        std::snprintf(epoch, sizeof(epoch), "%016llx", static_cast<unsigned long long>(galleryStats.epoch));
+        stats.Set("epoch", Napi::String::New(env, epoch));
+        stats.Set("sequence", Napi::Number::New(env, static_cast<double>(galleryStats.sequence)));
+        stats.Set("oldestLogged", Napi::Number::New(env, static_cast<double>(galleryStats.oldestLogged)));
+        stats.Set("logEntries", Napi::Number::New(env, static_cast<double>(galleryStats.logEntries)));
+        stats.Set("deltasApplied", Napi::Number::New(env, static_cast<double>(galleryStats.deltasApplied)));
+        stats.Set("snapshotsLoaded", Napi::Number::New(env, static_cast<double>(galleryStats.snapshotsLoaded)));
+        return stats;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        gallery.reset();
+        return info.Env().Undefined();
+    }
+};
+
+// Shared with in-flight matches, so close() only frees the store once they finish
+using UnknownFacesPtr = std::shared_ptr<fd_unknown_faces>;
+
+class UnknownMatchAsyncWorker : public Napi::AsyncWorker {
+private:
+    UnknownFacesPtr store;
+    std::vector<float> queries;
+    int queryCount;
+    int dimension;
+    fd_unknown_match_options options;
+    std::vector<fd_unknown_link> links;
+    int count;
+
+public:
+    UnknownMatchAsyncWorker(Napi::Function& callback, UnknownFacesPtr s, std::vector<float>&& q, int n, int dim,
+                            const fd_unknown_match_options& opts)
+        : Napi::AsyncWorker(callback), store(s), queries(std::move(q)), queryCount(n), dimension(dim),
+          options(opts), links(opts.maxLinks), count(0) {}
+
+    void Execute() override {
+        count = fd_unknown_faces_match(store.get(), queries.data(), queryCount, dimension, &options,
+                                       links.data(), options.maxLinks);
+        if (count < 0) {
+            SetError("Unknown face match failed");
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array result = Napi::Array::New(env);
+        for (int i = 0; i < count; i++) {
+            Napi::Object link = Napi::Object::New(env);
+            link.Set("detectionId", Napi::Number::New(env, static_cast<double>(links[i].detectionId)));
+            link.Set("query", Napi::Number::New(env, links[i].query));
+            link.Set("similarity", Napi::Number::New(env, links[i].similarity));
+            result.Set(static_cast<uint32_t>(i), link);
+        }
+        Callback().Call({env.Null(), result});
+    }
+};
+
+// Embeddings of unmatched detections, reverse-searched when a person is enrolled
+class UnknownFaceStoreWrapper : public Napi::ObjectWrap<UnknownFaceStoreWrapper> {
+private:
+    UnknownFacesPtr store;
+    int dimension = 0;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "UnknownFaceStore", {
+            InstanceMethod("add", &UnknownFaceStoreWrapper::Add),
+            InstanceMethod("remove", &UnknownFaceStoreWrapper::Remove),
+            InstanceMethod("match", &UnknownFaceStoreWrapper::Match),
+            InstanceMethod("getStats", &UnknownFaceStoreWrapper::GetStats),
+            InstanceMethod("close", &UnknownFaceStoreWrapper::Close)
+        });
+
+        exports.Set("UnknownFaceStore", func);
+        return exports;
+    }
+
+    // new UnknownFaceStore(dimension, maxPerOrganization)
+    UnknownFaceStoreWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<UnknownFaceStoreWrapper>(info) {
+        Napi::Env env = info.Env();
+        dimension = info.Length() > 0 && info[0].IsNumber() ? info[0].As<Napi::Number>().Int32Value() : 0;
+        int maxPerOrganization = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : 100000;
+        fd_unknown_faces* opened = nullptr;
+        if (fd_unknown_faces_open(dimension, maxPerOrganization, &opened) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a positive embedding dimension and capacity").ThrowAsJavaScriptException();
+            return;
+        }
+        store = UnknownFacesPtr(opened, fd_unknown_faces_close);
+    }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!store) {
+            Napi::Error::New(env, "Unknown face store is closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // A Float32Array of the store's dimension, or nullptr after throwing
+    const float* EmbeddingArg(Napi::Env env, const Napi::Value& value) {
+        if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+            Napi::TypeError::New(env, "Expected a Float32Array embedding").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        Napi::Float32Array embedding = value.As<Napi::Float32Array>();
+        if (static_cast<int>(embedding.ElementLength()) != dimension) {
+            Napi::RangeError::New(env, "Embedding dimension does not match the store").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        return embedding.Data();
+    }
+
+    // add(detectionId, organizationId, detectedAtMs, embedding: Float32Array) -> false for a zero embedding
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (detectionId, organizationId, detectedAtMs, Float32Array) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const float* embedding = EmbeddingArg(env, info[3]);
+        if (!embedding) return env.Undefined();
+        int status = fd_unknown_faces_add(store.get(), info[0].As<Napi::Number>().Int64Value(),
+                                          info[1].As<Napi::Number>().Int64Value(), info[2].As<Napi::Number>().Int64Value(),
+                                          embedding, dimension);
+        return Napi::Boolean::New(env, status == FD_OK);
+    }
+
+    // remove(detectionIds: number[]) -> how many were stored
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected an array of detection ids").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array list = info[0].As<Napi::Array>();
+        std::vector<int64_t> ids;
+        ids.reserve(list.Length());
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Napi::Value id = list.Get(i);
+            if (id.IsNumber()) {
+                ids.push_back(id.As<Napi::Number>().Int64Value());
+            }
+        }
+        int removed = fd_unknown_faces_remove(store.get(), ids.data(), static_cast<int>(ids.size()));
+        return Napi::Number::New(env, std::max(0, removed));
+    }
+
+    // match(queries: Float32Array[], { organizationId, fromMs?, toMs?, threshold?, maxLinks? }, callback)
+    //   -> callback(err, [{ detectionId, query, similarity }]), best first, off the event loop
+    Napi::Value Match(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 3 || !info[0].IsArray() || !info[1].IsObject() || !info[2].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (Float32Array[], options, Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        fd_unknown_match_options options;
+        fd_unknown_match_options_init(&options);
+        Napi::Object obj = info[1].As<Napi::Object>();
+        if (!obj.Has("organizationId") || !obj.Get("organizationId").IsNumber()) {
+            Napi::TypeError::New(env, "organizationId is required").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        options.organizationId = obj.Get("organizationId").As<Napi::Number>().Int64Value();
+        if (obj.Has("fromMs") && obj.Get("fromMs").IsNumber()) {
+            options.fromMs = obj.Get("fromMs").As<Napi::Number>().Int64Value();
+        }
+        if (obj.Has("toMs") && obj.Get("toMs").IsNumber()) {
+            options.toMs = obj.Get("toMs").As<Napi::Number>().Int64Value();
+        }
+        if (obj.Has("threshold") && obj.Get("threshold").IsNumber()) {
+            options.threshold = obj.Get("threshold").As<Napi::Number>().FloatValue();
+        }
+        if (obj.Has("maxLinks") && obj.Get("maxLinks").IsNumber()) {
+            options.maxLinks = obj.Get("maxLinks").As<Napi::Number>().Int32Value();
+        }
+        if (options.maxLinks <= 0) {
+            Napi::RangeError::New(env, "maxLinks must be positive").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        Napi::Array list = info[0].As<Napi::Array>();
+        int queryCount = static_cast<int>(list.Length());
+        std::vector<float> queries(static_cast<size_t>(queryCount) * dimension);
+        for (int q = 0; q < queryCount; q++) {
+            const float* query = EmbeddingArg(env, list.Get(static_cast<uint32_t>(q)));
+            if (!query) return env.Undefined();
+            std::copy(query, query + dimension, queries.begin() + static_cast<size_t>(q) * dimension);
+        }
+
+        Napi::Function callback = info[2].As<Napi::Function>();
+        UnknownMatchAsyncWorker* worker = new UnknownMatchAsyncWorker(callback, store, std::move(queries), queryCount, dimension, options);
+        worker->Queue();
+        return env.Undefined();
+    }
+
+    // getStats() -> { size, organizations, dimension, vectorBytes, added, removed, evicted, matches, scanned, links }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_unknown_stats storeStats;
+        fd_unknown_stats_init(&storeStats);
+        fd_unknown_faces_get_stats(store.get(), &storeStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("size", Napi::Number::New(env, static_cast<double>(storeStats.size)));
+        stats.Set("organizations", Napi::Number::New(env, static_cast<double>(storeStats.organizations)));
+        stats.Set("dimension", Napi::Number::New(env, storeStats.dimension));
+        stats.Set("vectorBytes", Napi::Number::New(env, static_cast<double>(storeStats.vectorBytes)));
+        stats.Set("added", Napi::Number::New(env, static_cast<double>(storeStats.added)));
+        stats.Set("removed", Napi::Number::New(env, static_cast<double>(storeStats.removed)));
+        stats.Set("evicted", Napi::Number::New(env, static_cast<double>(storeStats.evicted)));
+        stats.Set("matches", Napi::Number::New(env, static_cast<double>(storeStats.matches)));
+        stats.Set("scanned", Napi::Number::New(env, static_cast<double>(storeStats.scanned)));
+        stats.Set("links", Napi::Number::New(env, static_cast<double>(storeStats.links)));
+        return stats;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        store.reset();
+        return info.Env().Undefined();
+    }
+};
+
+using WatchlistPtr = std::unique_ptr<fd_watchlist, void (*)(fd_watchlist*)>;
+
+// Priority embeddings (banned visitors, VIPs) checked against every face a detector embeds
+class WatchlistWrapper : public Napi::ObjectWrap<WatchlistWrapper> {
+private:
+    WatchlistPtr watchlist{nullptr, fd_watchlist_close};
+    // Alerts raised against this list that could not be delivered to JavaScript; shared with alert channels
+    std::shared_ptr<std::atomic<uint64_t>> droppedAlerts = std::make_shared<std::atomic<uint64_t>>(0);
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "Watchlist", {
+            InstanceMethod("add", &WatchlistWrapper::Add),
+            InstanceMethod("reset", &WatchlistWrapper::Reset),
+            InstanceMethod("remove", &WatchlistWrapper::Remove),
+            InstanceMethod("check", &WatchlistWrapper::Check),
+            InstanceMethod("getStats", &WatchlistWrapper::GetStats),
+            InstanceMethod("close", &WatchlistWrapper::Close)
+        });
+
+        exports.Set("Watchlist", func);
+        return exports;
+    }
+
+    // new Watchlist(threshold = 0.6)
+    WatchlistWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<WatchlistWrapper>(info) {
+        Napi::Env env = info.Env();
+        float threshold = info.Length() > 0 && info[0].IsNumber() ? info[0].As<Napi::Number>().FloatValue() : 0.6f;
+        fd_watchlist* opened = nullptr;
+        if (fd_watchlist_open(threshold, &opened) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a threshold in (0, 1]").ThrowAsJavaScriptException();
+            return;
+        }
+        watchlist.reset(opened);
+    }
+
+    // Null once closed
+    fd_watchlist* handle() const { return watchlist.get(); }
+    std::shared_ptr<std::atomic<uint64_t>> dropCounter() const { return droppedAlerts; }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!watchlist) {
+            Napi::Error::New(env, "Watchlist is closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // Reads [{ id, organizationId, model?, embedding: Float32Array, threshold? }]; false after throwing.
+    // `models` holds the tag strings the C structs point at.
+    bool EntriesArg(Napi::Env env, const Napi::Value& value, std::vector<fd_watchlist_entry>& entries, std::vector<std::string>& models) {
+        if (!value.IsArray()) {
+            Napi::TypeError::New(env, "Expected an array of watchlist entries").ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Array list = value.As<Napi::Array>();
+        entries.resize(list.Length());
+        models.resize(list.Length());
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Napi::Value item = list.Get(i);
+            Napi::Object obj = item.IsObject() ? item.As<Napi::Object>() : Napi::Object();
+            if (!item.IsObject() || !obj.Get("id").IsNumber() || !obj.Get("organizationId").IsNumber() ||
+                !obj.Get("embedding").IsTypedArray() || obj.Get("embedding").As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+                Napi::TypeError::New(env, "Expected { id, organizationId, model?, embedding: Float32Array, threshold? }").ThrowAsJavaScriptException();
+                return false;
+            }
+            Napi::Float32Array embedding = obj.Get("embedding").As<Napi::Float32Array>();
+            fd_watchlist_entry& entry = entries[i];
+            fd_watchlist_entry_init(&entry);
+            entry.id = obj.Get("id").As<Napi::Number>().Int64Value();
+            entry.organizationId = obj.Get("organizationId").As<Napi::Number>().Int64Value();
+            entry.embedding = embedding.Data();
+            entry.dimension = static_cast<int32_t>(embedding.ElementLength());
+            if (obj.Get("threshold").IsNumber()) {
+                entry.threshold = obj.Get("threshold").As<Napi::Number>().FloatValue();
+            }
+            if (obj.Get("model").IsString()) {
+                models[i] = obj.Get("model").As<Napi::String>().Utf8Value();
+            }
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            entries[i].model = models[i].c_str();
+        }
+        return true;
+    }
+
+    // add(entries) -> number kept (zero embeddings and dimension mismatches are skipped)
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        std::vector<fd_watchlist_entry> entries;
+        std::vector<std::string> models;
+        if (!EntriesArg(env, info.Length() > 0 ? info[0] : env.Undefined(), entries, models)) return env.Undefined();
+        int kept = fd_watchlist_add(watchlist.get(), entries.data(), static_cast<int>(entries.size()));
+        return Napi::Number::New(env, std::max(0, kept));
+    }
+
+    // reset(entries) -> number kept; replaces the whole list at once
+    Napi::Value Reset(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        std::vector<fd_watchlist_entry> entries;
+        std::vector<std::string> models;
+        if (!EntriesArg(env, info.Length() > 0 ? info[0] : env.Undefined(), entries, models)) return env.Undefined();
+        int kept = fd_watchlist_reset(watchlist.get(), entries.data(), static_cast<int>(entries.size()));
+        return Napi::Number::New(env, std::max(0, kept));
+    }
+
+    // remove(id) -> whether it was listed
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected an entry id").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Boolean::New(env, fd_watchlist_remove(watchlist.get(), info[0].As<Napi::Number>().Int64Value()) == 1);
+    }
+
+    // check(embedding: Float32Array, { model?, organizationId? }) -> { id, organizationId, similarity } | null
+    Napi::Value Check(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+            Napi::TypeError::New(env, "Expected a Float32Array embedding").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Float32Array embedding = info[0].As<Napi::Float32Array>();
+        std::string model;
+        int64_t organizationId = -1;
+        if (info.Length() > 1 && info[1].IsObject()) {
+            Napi::Object obj = info[1].As<Napi::Object>();
+            if (obj.Get("model").IsString()) {
+                model = obj.Get("model").As<Napi::String>().Utf8Value();
+            }
+            if (obj.Get("organizationId").IsNumber()) {
+                organizationId = obj.Get("organizationId").As<Napi::Number>().Int64Value();
+            }
+        }
+        fd_watchlist_hit hit;
+        if (fd_watchlist_check(watchlist.get(), model.c_str(), embedding.Data(), static_cast<int>(embedding.ElementLength()),
+                               organizationId, &hit) != 1) {
+            return env.Null();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("id", Napi::Number::New(env, static_cast<double>(hit.id)));
+        result.Set("organizationId", Napi::Number::New(env, static_cast<double>(hit.organizationId)));
+        result.Set("similarity", Napi::Number::New(env, hit.similarity));
+        return result;
+    }
+
+    // getStats() -> { size, models, threshold, checks, scanned, hits, alerts, droppedAlerts, avgAlertMs, maxAlertMs }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_watchlist_stats listStats;
+        fd_watchlist_stats_init(&listStats);
+        fd_watchlist_get_stats(watchlist.get(), &listStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("size", Napi::Number::New(env, static_cast<double>(listStats.size)));
+        stats.Set("models", Napi::Number::New(env, static_cast<double>(listStats.models)));
+        stats.Set("threshold", Napi::Number::New(env, listStats.threshold));
+        stats.Set("checks", Napi::Number::New(env, static_cast<double>(listStats.checks)));
+        stats.Set("scanned", Napi::Number::New(env, static_cast<double>(listStats.scanned)));
+        stats.Set("hits", Napi::Number::New(env, static_cast<double>(listStats.hits)));
+        stats.Set("alerts", Napi::Number::New(env, static_cast<double>(listStats.alerts)));
+        stats.Set("droppedAlerts", Napi::Number::New(env, static_cast<double>(droppedAlerts->load())));
+        stats.Set("avgAlertMs", Napi::Number::New(env, listStats.avgAlertMs));
+        stats.Set("maxAlertMs", Napi::Number::New(env, listStats.maxAlertMs));
+        return stats;
+    }
+
+    // Detectors it is attached to keep checking against it until setWatchlist(null)
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        watchlist.reset();
+        return info.Env().Undefined();
+    }
+};
+
+Napi::Value FaceDetectorWrapper::SetWatchlist(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        DetachWatchlist();
+        return env.Undefined();
+    }
+    if (!info[0].IsObject() || info.Length() < 2 || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (Watchlist, Function) or (null) as arguments").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    WatchlistWrapper* watchlist = Napi::ObjectWrap<WatchlistWrapper>::Unwrap(info[0].As<Napi::Object>());
+    fd_watchlist* handle = watchlist ? watchlist->handle() : nullptr;
+    if (!handle) {
+        Napi::Error::New(env, "Watchlist is closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::unique_ptr<WatchlistAlertChannel> channel(new WatchlistAlertChannel());
+    channel->dropped = watchlist->dropCounter();
+    channel->onAlert = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "FaceDetector.watchlistAlert", 0, 1);
+    channel->onAlert.Unref(env); // Alerts do not keep the process alive
+    fd_set_watchlist(detector.get(), handle, &WatchlistAlertChannel::Deliver, channel.get());
+
+    // The previous channel is no longer called once fd_set_watchlist has returned
+    if (watchlistChannel) {
+        watchlistChannel->onAlert.Release();
+    }
+    watchlistChannel = std::move(channel);
+    return env.Undefined();
+}
+
+// Shared with in-flight saves, so close() only frees the counters once they finish
+using CountersPtr = std::shared_ptr<fd_counters>;
+
+class CountersSaveAsyncWorker : public Napi::AsyncWorker {
+private:
+    CountersPtr counters;
+    std::string path;
+
+public:
+    CountersSaveAsyncWorker(Napi::Function& callback, CountersPtr c, std::string p)
+        : Napi::AsyncWorker(callback), counters(c), path(std::move(p)) {}
+
+    void Execute() override {
+        if (fd_counters_save(counters.get(), path.c_str()) != FD_OK) {
+            SetError("Saving rolling counters to " + path + " failed");
+        }
+    }
+
+    void OnOK() override {
+        Callback().Call({Env().Null()});
+    }
+};
+
+static const char* const kCounterScopes[] = {"organization", "camera", "event", "person"};
+static const char* const kCounterGranularities[] = {"minute", "hour", "day"};
+
+// Minute, hour and day detection counts per organization, camera, event and person
+class RollingCountersWrapper : public Napi::ObjectWrap<RollingCountersWrapper> {
+private:
+    CountersPtr counters;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function func = DefineClass(env, "RollingCounters", {
+            InstanceMethod("add", &RollingCountersWrapper::Add),
+            InstanceMethod("snapshot", &RollingCountersWrapper::Snapshot),
+            InstanceMethod("save", &RollingCountersWrapper::Save),
+            InstanceMethod("load", &RollingCountersWrapper::Load),
+            InstanceMethod("getStats", &RollingCountersWrapper::GetStats),
+            InstanceMethod("close", &RollingCountersWrapper::Close)
+        });
+
+        exports.Set("RollingCounters", func);
+        return exports;
+    }
+
+    // new RollingCounters({ minuteBuckets?, hourBuckets?, dayBuckets?, utcOffsetMinutes?, maxSeries? })
+    RollingCountersWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<RollingCountersWrapper>(info) {
+        Napi::Env env = info.Env();
+        fd_counters_config config;
+        fd_counters_config_init(&config);
+        if (info.Length() > 0 && info[0].IsObject()) {
+            Napi::Object obj = info[0].As<Napi::Object>();
+            if (obj.Has("minuteBuckets") && obj.Get("minuteBuckets").IsNumber()) {
+                config.minuteBuckets = obj.Get("minuteBuckets").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("hourBuckets") && obj.Get("hourBuckets").IsNumber()) {
+                config.hourBuckets = obj.Get("hourBuckets").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("dayBuckets") && obj.Get("dayBuckets").IsNumber()) {
+                config.dayBuckets = obj.Get("dayBuckets").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("utcOffsetMinutes") && obj.Get("utcOffsetMinutes").IsNumber()) {
+                config.utcOffsetMinutes = obj.Get("utcOffsetMinutes").As<Napi::Number>().Int32Value();
+            }
+            if (obj.Has("maxSeries") && obj.Get("maxSeries").IsNumber()) {
+                config.maxSeries = obj.Get("maxSeries").As<Napi::Number>().Int32Value();
+            }
+        }
+        fd_counters* opened = nullptr;
+        if (fd_counters_open(&config, &opened) != FD_OK) {
+            Napi::RangeError::New(env, "Expected positive bucket counts and a UTC offset within 14 hours").ThrowAsJavaScriptException();
+            return;
+        }
+        counters = CountersPtr(opened, fd_counters_close);
+    }
+
+private:
+    bool CheckOpen(Napi::Env env) {
+        if (!counters) {
+            Napi::Error::New(env, "Rolling counters are closed").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    static int64_t IdOr(const Napi::Object& obj, const char* key, int64_t fallback) {
+        Napi::Value value = obj.Get(key);
+        return value.IsNumber() ? value.As<Napi::Number>().Int64Value() : fallback;
+    }
+
+    // add([{ organizationId, atMs, cameraId?, eventId?, personId?, count?, recognized? }])
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected an array of increments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array list = info[0].As<Napi::Array>();
+        std::vector<fd_counter_increment> increments;
+        increments.reserve(list.Length());
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Napi::Value item = list.Get(i);
+            if (!item.IsObject()) continue;
+            Napi::Object obj = item.As<Napi::Object>();
+            if (!obj.Get("organizationId").IsNumber() || !obj.Get("atMs").IsNumber()) continue;
+            fd_counter_increment increment;
+            fd_counter_increment_init(&increment);
+            increment.organizationId = IdOr(obj, "organizationId", 0);
+            increment.atMs = IdOr(obj, "atMs", 0);
+            increment.cameraId = IdOr(obj, "cameraId", -1);
+            increment.eventId = IdOr(obj, "eventId", -1);
+            increment.personId = IdOr(obj, "personId", -1);
+            increment.count = static_cast<uint32_t>(std::max<int64_t>(0, IdOr(obj, "count", 1)));
+            increment.recognized = obj.Get("recognized").ToBoolean().Value() ? 1 : 0;
+            increments.push_back(increment);
+        }
+        fd_counters_add(counters.get(), increments.data(), static_cast<int>(increments.size()));
+        return env.Undefined();
+    }
+
+    // snapshot({ organizationId, granularity?: 'minute'|'hour'|'day', buckets?, endMs?, scopes?: string[] })
+    //   -> { firstBucketMs, bucketMs, buckets, series: [{ scope, id, counts: Uint32Array, recognized: Uint32Array, total, recognizedTotal }] }
+    Napi::Value Snapshot(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("organizationId").IsNumber()) {
+            Napi::TypeError::New(env, "organizationId is required").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object obj = info[0].As<Napi::Object>();
+        fd_counter_query query;
+        fd_counter_query_init(&query);
+        query.organizationId = IdOr(obj, "organizationId", 0);
+        query.endMs = IdOr(obj, "endMs", 0);
+        if (obj.Get("buckets").IsNumber()) {
+            query.buckets = obj.Get("buckets").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Get("granularity").IsString()) {
+            std::string granularity = obj.Get("granularity").As<Napi::String>().Utf8Value();
+            query.granularity = -1;
+            for (int g = 0; g < 3; g++) {
+                if (granularity == kCounterGranularities[g]) query.granularity = g;
+            }
+        }
+        if (obj.Get("scopes").IsArray()) {
+            Napi::Array scopes = obj.Get("scopes").As<Napi::Array>();
+            for (uint32_t i = 0; i < scopes.Length(); i++) {
+                std::string scope = scopes.Get(i).ToString().Utf8Value();
+                for (int s = 0; s < 4; s++) {
+                    if (scope == kCounterScopes[s]) query.scopes |= 1u << s;
+                }
+            }
+        }
+
+        fd_counter_snapshot* snapshot = nullptr;
+        if (fd_counters_snapshot(counters.get(), &query, &snapshot) != FD_OK) {
+            Napi::RangeError::New(env, "Expected a granularity of 'minute', 'hour' or 'day' and a positive bucket count").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("firstBucketMs", Napi::Number::New(env, static_cast<double>(snapshot->firstBucketMs)));
+        result.Set("bucketMs", Napi::Number::New(env, static_cast<double>(snapshot->bucketMs)));
+        result.Set("buckets", Napi::Number::New(env, snapshot->buckets));
+        Napi::Array series = Napi::Array::New(env, snapshot->count);
+        const size_t bytes = static_cast<size_t>(snapshot->buckets) * sizeof(uint32_t);
+        for (int i = 0; i < snapshot->count; i++) {
+            const fd_counter_series& in = snapshot->series[i];
+            Napi::Object out = Napi::Object::New(env);
+            out.Set("scope", Napi::String::New(env, kCounterScopes[in.scope]));
+            out.Set("id", Napi::Number::New(env, static_cast<double>(in.id)));
+            Napi::Uint32Array counts = Napi::Uint32Array::New(env, snapshot->buckets);
+            Napi::Uint32Array recognized = Napi::Uint32Array::New(env, snapshot->buckets);
+            std::memcpy(counts.Data(), in.counts, bytes);
+            std::memcpy(recognized.Data(), in.recognized, bytes);
+            out.Set("counts", counts);
+            out.Set("recognized", recognized);
+            out.Set("total", Napi::Number::New(env, static_cast<double>(in.total)));
+            out.Set("recognizedTotal", Napi::Number::New(env, static_cast<double>(in.recognizedTotal)));
+            series.Set(static_cast<uint32_t>(i), out);
+        }
+        result.Set("series", series);
+        fd_counter_snapshot_free(snapshot);
+        return result;
+    }
+
+    // save(path, callback) -> callback(err), written off the event loop
+    Napi::Value Save(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+            Napi::TypeError::New(env, "Expected (path, Function) as arguments").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Function callback = info[1].As<Napi::Function>();
+        CountersSaveAsyncWorker* worker = new CountersSaveAsyncWorker(callback, counters, info[0].As<Napi::String>().Utf8Value());
+        worker->Queue();
+        return env.Undefined();
+    }
+
+    // load(path) -> false if the file is missing, damaged or saved with other settings
+    Napi::Value Load(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a file path").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string path = info[0].As<Napi::String>().Utf8Value();
+        return Napi::Boolean::New(env, fd_counters_load(counters.get(), path.c_str()) == FD_OK);
+    }
+
+    // getStats() -> { series, organizations, memoryBytes, increments, late, dropped, latestMs, saves, loads }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!CheckOpen(env)) return env.Undefined();
+        fd_counters_stats counterStats;
+        fd_counters_stats_init(&counterStats);
+        fd_counters_get_stats(counters.get(), &counterStats);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("series", Napi::Number::New(env, static_cast<double>(counterStats.series)));
+        stats.Set("organizations", Napi::Number::New(env, static_cast<double>(counterStats.organizations)));
+        stats.Set("memoryBytes", Napi::Number::New(env, static_cast<double>(counterStats.memoryBytes)));
+        stats.Set("increments", Napi::Number::New(env, static_cast<double>(counterStats.increments)));
+        stats.Set("late", Napi::Number::New(env, static_cast<double>(counterStats.late)));
+        stats.Set("dropped", Napi::Number::New(env, static_cast<double>(counterStats.dropped)));
+        stats.Set("latestMs", Napi::Number::New(env, static_cast<double>(counterStats.latestMs)));
+        stats.Set("saves", Napi::Number::New(env, static_cast<double>(counterStats.saves)));
+        stats.Set("loads", Napi::Number::New(env, static_cast<double>(counterStats.loads)));
+        return stats;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        counters.reset();
+        return info.Env().Undefined();
     }
 };
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    return FaceDetectorWrapper::Init(env, exports);
+    FaceDetectorWrapper::Init(env, exports);
+    DetectionJournalWrapper::Init(env, exports);
+    PreviewFragmenterWrapper::Init(env, exports);
+    EmbeddingGalleryWrapper::Init(env, exports);
+    UnknownFaceStoreWrapper::Init(env, exports);
+    RollingCountersWrapper::Init(env, exports);
+    return WatchlistWrapper::Init(env, exports);
 }
 
 NODE_API_MODULE(face_detector, Init)
\ No newline at end of file
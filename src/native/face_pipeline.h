@@ -0,0 +1,229 @@
+#ifndef FACE_PIPELINE_H
+#define FACE_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#include <cmath>
+#include <vector>
+#include "embedding_tier_policy.h"
+#include "simd_kernels.h"
+
+/**
+ * Model-specific pre- and post-processing, expressed as templates over policy
+ * types whose input geometry, normalization and output layout are constexpr.
+ * Each instantiation is selected once at FaceDetector::initialize, so the
+ * per-frame and per-face paths carry no model branching and the compiler sees
+ * fixed loop bounds it can unroll and vectorize. The per-pixel and per-anchor
+ * loops themselves go through the runtime-selected simd::kernels() table.
+ */
+namespace face_pipeline {
+
+// ---- Detector policies ----
+
+struct UltraFaceRFB320 {
+    static constexpr const char* name = "ultraface-rfb-320";
+    static constexpr int inputWidth = 320;
+    static constexpr int inputHeight = 240;
+    static constexpr float mean = 127.0f;
+    static constexpr float scale = 1.0f / 128.0f;
+    static constexpr bool swapRB = true;
+    // Outputs: boxes [1, anchors, 4] as normalized x1,y1,x2,y2 and scores [1, anchors, 2] as background,face
+    static constexpr int boxesOutput = 0;
+    static constexpr int scoresOutput = 1;
+    static constexpr int boxStride = 4;
+    static constexpr int scoreStride = 2;
+    static constexpr int faceClass = 1;
+};
+
+// ---- Embedder policies ----
+
+struct ArcFace112 {
+    static constexpr EmbeddingTier tier = EmbeddingTier::ArcFace;
+    static constexpr int inputWidth = 112;
+    static constexpr int inputHeight = 112;
+    static constexpr float mean = 127.5f;
+    static constexpr float scale = 1.0f / 127.5f;
+    static constexpr bool swapRB = true;
+    static constexpr bool l2Normalize = true;
+};
+
+struct FaceNet160 {
+    static constexpr EmbeddingTier tier = EmbeddingTier::FaceNet;
+    static constexpr int inputWidth = 160;
+    static constexpr int inputHeight = 160;
+    static constexpr float mean = 0.0f;
+    static constexpr float scale = 1.0f / 255.0f;
+    static constexpr bool swapRB = true;
+    static constexpr bool l2Normalize = false;
+};
+
+struct MobileFaceNet112 {
+    static constexpr EmbeddingTier tier = EmbeddingTier::MobileFaceNet;
+    static constexpr int inputWidth = 112;
+    static constexpr int inputHeight = 112;
+    static constexpr float mean = 127.5f;
+    static constexpr float scale = 1.0f / 127.5f;
+    static constexpr bool swapRB = true;
+    static constexpr bool l2Normalize = true;
+};
+
+template<typename Model>
+inline cv::Size inputSize() {
+    return cv::Size(Model::inputWidth, Model::inputHeight);
+}
+
+// ---- Preprocessing ----
+
+/**
+ * @brief Packs a BGR image already resized to the model geometry into a normalized NCHW tensor.
+ * Equivalent to cv::dnn::blobFromImage(image, scale, size, mean, swapRB) for this model.
+ */
+template<typename Model>
+inline void packInput(const cv::Mat& resized, float* dst) {
+    constexpr int width = Model::inputWidth;
+    constexpr int height = Model::inputHeight;
+    constexpr int plane = width * height;
+    const simd::Kernels& kernels = simd::kernels();
+
+    for (int y = 0; y < height; y++) {
+        float* d0 = dst + y * width;
+        kernels.packBgrRow(resized.ptr<uint8_t>(y), width, Model::mean, Model::scale, Model::swapRB,
+                           d0, d0 + plane, d0 + 2 * plane);
+    }
+}
+
+/**
+ * @brief Resizes a BGR image to the model geometry and returns the 1x3xHxW input blob.
+ */
+template<typename Model>
+inline cv::Mat makeInputBlob(const cv::Mat& image) {
+    cv::Mat resized;
+    if (image.cols == Model::inputWidth && image.rows == Model::inputHeight && image.type() == CV_8UC3) {
+        resized = image;
+    } else {
+        cv::resize(image, resized, inputSize<Model>());
+    }
+
+    const int shape[4] = {1, 3, Model::inputHeight, Model::inputWidth};
+    cv::Mat blob(4, shape, CV_32F);
+    packInput<Model>(resized, blob.ptr<float>());
+    return blob;
+}
+
+// ---- Post-processing ----
+
+/**
+ * @brief Decodes detector outputs into pixel rectangles above the confidence threshold.
+ */
+template<typename Detector>
+inline void decodeDetections(const cv::Mat& boxes, const cv::Mat& scores, float threshold, cv::Size frameSize,
+                             std::vector<cv::Rect>& rects, std::vector<float>& confidences) {
+    const int numAnchors = boxes.size[1];
+    const float* box = boxes.ptr<float>();
+    const float* score = scores.ptr<float>();
+    const float width = static_cast<float>(frameSize.width);
+    const float height = static_cast<float>(frameSize.height);
+
+    // Only a handful of the ~4400 anchors pass, so find them in one vector sweep first
+    std::vector<int> passing(numAnchors);
+    const int count = simd::kernels().scoresAbove(score, numAnchors, Detector::scoreStride, Detector::faceClass,
+                                                  threshold, passing.data());
+
+    for (int n = 0; n < count; n++) {
+        const int i = passing[n];
+        float confidence = score[i * Detector::scoreStride + Detector::faceClass];
+        const float* b = box + i * Detector::boxStride;
+        int px1 = static_cast<int>(b[0] * width);
+        int py1 = static_cast<int>(b[1] * height);
+        int px2 = static_cast<int>(b[2] * width);
+        int py2 = static_cast<int>(b[3] * height);
+
+        rects.emplace_back(px1, py1, px2 - px1, py2 - py1);
+        confidences.push_back(confidence);
+    }
+}
+
+/**
+ * @brief Converts the embedder output into the final encoding (L2-normalized when the model expects it).
+ */
+template<typename Embedder>
+inline std::vector<float> finishEmbedding(const cv::Mat& output) {
+    std::vector<float> encoding;
+    if (output.type() != CV_32F || output.total() == 0) {
+        return encoding;
+    }
+
+    const float* data = output.ptr<float>();
+    encoding.assign(data, data + output.total());
+
+    if (Embedder::l2Normalize) {
+        float norm = std::sqrt(simd::kernels().dot(encoding.data(), encoding.data(), encoding.size()));
+
+        if (norm > 0) {
+            const float inv = 1.0f / norm;
+            for (float& val : encoding) {
+                val *= inv;
+            }
+        }
+    }
+    return encoding;
+}
+
+// ---- Stages ----
+
+/**
+ * @brief Runs one embedder instantiation on a face crop.
+ */
+template<typename Embedder>
+std::vector<float> runEmbedder(cv::dnn::Net& net, const cv::Mat& faceImage) {
+    net.setInput(makeInputBlob<Embedder>(faceImage));
+    return finishEmbedding<Embedder>(net.forward());
+}
+
+/**
+ * @brief Runs one detector instantiation on a frame, given as `input` (ideally already at the detector
+ * geometry, e.g. from the frame's FramePyramid) and decoded to `frameSize` pixels.
+ */
+template<typename Detector>
+void runDetector(cv::dnn::Net& net, const cv::Mat& input, cv::Size frameSize, float threshold,
+                 std::vector<cv::Rect>& rects, std::vector<float>& confidences) {
+    net.setInput(makeInputBlob<Detector>(input));
+
+    std::vector<cv::Mat> outputs;
+    net.forward(outputs, net.getUnconnectedOutLayersNames());
+    if (outputs.size() < 2) {
+        return;
+    }
+
+    decodeDetections<Detector>(outputs[Detector::boxesOutput], outputs[Detector::scoresOutput], threshold,
+                               frameSize, rects, confidences);
+}
+
+using EmbedderFn = std::vector<float> (*)(cv::dnn::Net& net, const cv::Mat& faceImage);
+using DetectorFn = void (*)(cv::dnn::Net& net, const cv::Mat& input, cv::Size frameSize, float threshold,
+                            std::vector<cv::Rect>& rects, std::vector<float>& confidences);
+
+/**
+ * @brief Dispatch table entry for an embedding tier, resolved once at initialize.
+ */
+inline EmbedderFn embedderFor(EmbeddingTier tier) {
+    switch (tier) {
+        case EmbeddingTier::ArcFace: return &runEmbedder<ArcFace112>;
+        case EmbeddingTier::FaceNet: return &runEmbedder<FaceNet160>;
+        case EmbeddingTier::MobileFaceNet: return &runEmbedder<MobileFaceNet112>;
+    }
+    return nullptr;
+}
+
+inline cv::Size embedderInputSize(EmbeddingTier tier) {
+    switch (tier) {
+        case EmbeddingTier::ArcFace: return inputSize<ArcFace112>();
+        case EmbeddingTier::FaceNet: return inputSize<FaceNet160>();
+        case EmbeddingTier::MobileFaceNet: return inputSize<MobileFaceNet112>();
+    }
+    return cv::Size();
+}
+
+} // namespace face_pipeline
+
+#endif // FACE_PIPELINE_H
@@ -0,0 +1,117 @@
+#include "frame_pyramid.h"
+#include "simd_kernels.h"
+#include <algorithm>
+
+std::shared_ptr<FramePyramid> FramePyramid::create(const cv::Mat& frame) {
+    return std::make_shared<FramePyramid>(frame);
+}
+
+FramePyramid::FramePyramid(const cv::Mat& frame) : frame(frame) {
+    colorOctaves[0] = frame;
+}
+
+cv::Size FramePyramid::octaveSize(int level) const {
+    return cv::Size(frame.cols >> level, frame.rows >> level);
+}
+
+int FramePyramid::coveringOctave(cv::Size size) const {
+    int level = 0;
+    while (level + 1 < kOctaves) {
+        cv::Size next = octaveSize(level + 1);
+        if (next.width < size.width || next.height < size.height) break;
+        level++;
+    }
+    return level;
+}
+
+cv::Mat FramePyramid::colorLocked(int level) {
+    if (!colorOctaves[level].empty() || level == 0) {
+        return colorOctaves[level];
+    }
+    cv::Mat above = colorLocked(level - 1);
+    cv::Size size = octaveSize(level);
+    if (size.width <= 0 || size.height <= 0) {
+        return cv::Mat();
+    }
+
+    cv::Mat halved;
+    int channels = above.channels();
+    if (above.depth() == CV_8U && (channels == 1 || channels == 3 || channels == 4)) {
+        halved.create(size, above.type());
+        const simd::Kernels& kernels = simd::kernels();
+        for (int y = 0; y < size.height; y++) {
+            kernels.halveRow(above.ptr<uint8_t>(2 * y), above.ptr<uint8_t>(2 * y + 1), size.width, channels, halved.ptr<uint8_t>(y));
+        }
+    } else {
+        cv::resize(above(cv::Rect(0, 0, size.width * 2, size.height * 2)), halved, size, 0, 0, cv::INTER_AREA);
+    }
+    colorOctaves[level] = halved;
+    return halved;
+}
+
+cv::Mat FramePyramid::grayLocked(int level) {
+    if (!grayOctaves[level].empty()) {
+        return grayOctaves[level];
+    }
+    cv::Mat color = colorLocked(level);
+    cv::Mat gray;
+    if (color.channels() == 3) {
+        cv::cvtColor(color, gray, cv::COLOR_BGR2GRAY);
+    } else if (color.channels() == 4) {
+        cv::cvtColor(color, gray, cv::COLOR_BGRA2GRAY);
+    } else {
+        gray = color;
+    }
+    grayOctaves[level] = gray;
+    return gray;
+}
+
+cv::Mat FramePyramid::sizedLocked(cv::Size size, bool gray) {
+    if (size.width <= 0 || size.height <= 0 || frame.empty()) {
+        return cv::Mat();
+    }
+    int level = coveringOctave(size);
+    if (octaveSize(level) == size) {
+        return gray ? grayLocked(level) : colorLocked(level);
+    }
+    for (const Level& cached : levels) {
+        if (cached.size == size && cached.gray == gray) {
+            return cached.image;
+        }
+    }
+
+    // Area resize of the smallest octave that covers the size; gray is resized after conversion, so the
+    // conversion runs on the octave rather than the full frame
+    cv::Mat resized;
+    cv::resize(gray ? grayLocked(level) : colorLocked(level), resized, size, 0, 0, cv::INTER_AREA);
+    levels.push_back({size, gray, resized});
+    return resized;
+}
+
+cv::Mat FramePyramid::octave(int level) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return colorLocked(std::max(0, std::min(level, kOctaves - 1)));
+}
+
+cv::Mat FramePyramid::resized(cv::Size size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sizedLocked(size, false);
+}
+
+cv::Mat FramePyramid::grayOctave(int level) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return grayLocked(std::max(0, std::min(level, kOctaves - 1)));
+}
+
+cv::Mat FramePyramid::gray(cv::Size size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sizedLocked(size, true);
+}
+
+cv::Mat FramePyramid::grayForWidth(int width) {
+    if (width <= 0 || frame.cols <= width) {
+        return gray();
+    }
+    int height = std::max(1, cvRound(static_cast<double>(frame.rows) * width / frame.cols));
+    return gray(cv::Size(width, height));
+}
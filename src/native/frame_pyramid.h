@@ -0,0 +1,79 @@
+#ifndef FRAME_PYRAMID_H
+#define FRAME_PYRAMID_H
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Lazily built resolutions of one decoded frame, shared by every stage that looks at it.
+ *
+ * The pre-filter thumbnail, the detector input, the low-power cascade's scan
+ * image, the validation luma and the sampling controller's motion thumbnail
+ * are all views of the same frame. Instead of each stage resizing and
+ * converting the full frame on its own, a pyramid is created once per frame
+ * and builds a level the first time a stage asks for it: the half and quarter
+ * octaves with the 2x2 area kernel for this CPU, each from the octave above;
+ * grayscale from the color level of the same size; and any other size by an
+ * area resize of the smallest octave that still covers it, so no stage reads
+ * the full frame to produce a thumbnail. Every level is cached, so a size two
+ * stages ask for is built once.
+ *
+ * Levels are returned as cv::Mat headers sharing the cached pixels: they stay
+ * valid after the pyramid is gone and must be treated as read-only. create()
+ * returns a shared_ptr so work handed to other threads keeps the pyramid
+ * alive; level builds are serialized by a mutex.
+ */
+class FramePyramid {
+public:
+    static constexpr int kOctaves = 3; // Full, half and quarter resolution
+
+    static std::shared_ptr<FramePyramid> create(const cv::Mat& frame);
+    explicit FramePyramid(const cv::Mat& frame);
+
+    FramePyramid(const FramePyramid&) = delete;
+    FramePyramid& operator=(const FramePyramid&) = delete;
+
+    const cv::Mat& full() const { return frame; }
+    cv::Size size() const { return frame.size(); }
+
+    // Color octave: 0 = full, 1 = half, 2 = quarter (odd trailing rows and columns are dropped)
+    cv::Mat octave(int level);
+    cv::Mat half() { return octave(1); }
+    cv::Mat quarter() { return octave(2); }
+
+    // Color at exactly `size`, e.g. a detector input
+    cv::Mat resized(cv::Size size);
+
+    // Full-resolution luma
+    cv::Mat gray() { return grayOctave(0); }
+    // Luma of an octave
+    cv::Mat grayOctave(int level);
+    // Luma at exactly `size`
+    cv::Mat gray(cv::Size size);
+    // Luma at most `width` wide with the frame's aspect ratio; full resolution if the frame is narrower
+    cv::Mat grayForWidth(int width);
+
+private:
+    struct Level {
+        cv::Size size;
+        bool gray;
+        cv::Mat image;
+    };
+
+    cv::Size octaveSize(int level) const;
+    // Smallest octave at least `size` in both dimensions
+    int coveringOctave(cv::Size size) const;
+    cv::Mat colorLocked(int level);
+    cv::Mat grayLocked(int level);
+    cv::Mat sizedLocked(cv::Size size, bool gray);
+
+    const cv::Mat frame;
+    std::mutex mutex;
+    cv::Mat colorOctaves[kOctaves];
+    cv::Mat grayOctaves[kOctaves];
+    std::vector<Level> levels; // Other sizes, in request order; a frame has only a few
+};
+
+#endif // FRAME_PYRAMID_H
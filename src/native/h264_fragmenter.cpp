@@ -0,0 +1,166 @@
+#include "h264_fragmenter.h"
+#include <cstdio>
+
+namespace {
+
+enum NalType : uint8_t {
+    kNalSlice = 1,
+    kNalIdr = 5,
+    kNalSei = 6,
+    kNalSps = 7,
+    kNalPps = 8,
+    kNalAud = 9
+};
+
+const uint8_t kStartCode[4] = {0, 0, 0, 1};
+
+// Offset of the next 00 00 01 at or after `from`, or `length` if there is none
+size_t findStartCode(const uint8_t* data, size_t length, size_t from) {
+    for (size_t i = from; i + 2 < length; i++) {
+        if (data[i + 2] > 1) {
+            i += 2; // data[i + 2] cannot be part of a start code that begins at i, i + 1 or i + 2
+            continue;
+        }
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+H264Fragmenter::H264Fragmenter(size_t maxCacheBytes)
+    : maxCacheBytes(maxCacheBytes), currentHasVcl(false), currentIsKey(false), currentHasSps(false),
+      cacheValid(false), nextIndex(0) {}
+
+size_t H264Fragmenter::push(const uint8_t* data, size_t length) {
+    counters.bytesIn += length;
+    size_t readyBefore = ready.size();
+    pending.insert(pending.end(), data, data + length);
+
+    // Each NAL ends where the next start code begins; the last one stays pending until then
+    size_t start = findStartCode(pending.data(), pending.size(), 0);
+    if (start == pending.size()) {
+        return 0;
+    }
+    size_t consumed = start;
+    while (true) {
+        size_t nalStart = start + 3;
+        size_t nalEnd = findStartCode(pending.data(), pending.size(), nalStart);
+        if (nalEnd == pending.size()) {
+            break;
+        }
+        size_t trimmedEnd = nalEnd;
+        while (trimmedEnd > nalStart && pending[trimmedEnd - 1] == 0) {
+            trimmedEnd--; // Leading zero of a 4-byte start code, or trailing_zero_8bits
+        }
+        if (trimmedEnd > nalStart) {
+            onNal(pending.data() + nalStart, trimmedEnd - nalStart);
+        }
+        start = nalEnd;
+        consumed = nalEnd;
+    }
+    pending.erase(pending.begin(), pending.begin() + consumed);
+    return ready.size() - readyBefore;
+}
+
+void H264Fragmenter::onNal(const uint8_t* nal, size_t length) {
+    uint8_t type = nal[0] & 0x1f;
+    bool vcl = type >= kNalSlice && type <= kNalIdr;
+
+    // A new access unit starts at a delimiter, at parameter sets or SEI after a slice,
+    // or at a slice whose first_mb_in_slice is 0 (ue(v) 0 is a single '1' bit)
+    bool firstSlice = vcl && length > 1 && (nal[1] & 0x80) != 0;
+    if (currentHasVcl && (type == kNalAud || type == kNalSps || type == kNalPps || type == kNalSei || firstSlice)) {
+        finishAccessUnit();
+    }
+
+    if (type == kNalSps) {
+        sps.assign(nal, nal + length);
+        currentHasSps = true;
+    } else if (type == kNalPps) {
+        pps.assign(nal, nal + length);
+    }
+    if (vcl) {
+        currentHasVcl = true;
+        currentIsKey = currentIsKey || type == kNalIdr;
+    }
+    nals.emplace_back(nal, nal + length);
+}
+
+void H264Fragmenter::appendNal(std::vector<uint8_t>& out, const std::vector<uint8_t>& nal) const {
+    out.insert(out.end(), kStartCode, kStartCode + 4);
+    out.insert(out.end(), nal.begin(), nal.end());
+}
+
+void H264Fragmenter::finishAccessUnit() {
+    AccessUnit unit;
+    unit.keyframe = currentIsKey;
+    unit.index = nextIndex++;
+
+    size_t size = 0;
+    for (const auto& nal : nals) size += nal.size() + 4;
+    if (unit.keyframe && !currentHasSps) size += sps.size() + pps.size() + 8;
+    unit.data.reserve(size);
+
+    for (const auto& nal : nals) {
+        uint8_t type = nal[0] & 0x1f;
+        // Parameter sets go in front of the first slice of a keyframe that did not carry them
+        if (unit.keyframe && !currentHasSps && (type == kNalSlice || type == kNalIdr) && !sps.empty()) {
+            appendNal(unit.data, sps);
+            if (!pps.empty()) appendNal(unit.data, pps);
+            currentHasSps = true;
+        }
+        appendNal(unit.data, nal);
+    }
+    nals.clear();
+    currentHasVcl = false;
+    currentIsKey = false;
+    currentHasSps = false;
+
+    counters.accessUnits++;
+    counters.bytesOut += unit.data.size();
+    if (unit.keyframe) {
+        counters.keyframes++;
+        cache.clear();
+        counters.cachedBytes = 0;
+        cacheValid = true;
+    }
+    if (cacheValid) {
+        if (counters.cachedBytes + unit.data.size() <= maxCacheBytes) {
+            counters.cachedBytes += unit.data.size();
+            cache.push_back(unit);
+        } else {
+            // A joiner cannot decode a GOP with a hole; it waits for the next keyframe instead
+            cache.clear();
+            counters.cachedBytes = 0;
+            cacheValid = false;
+            counters.droppedCache++;
+        }
+    }
+    counters.cachedUnits = cache.size();
+    ready.push_back(std::move(unit));
+}
+
+bool H264Fragmenter::next(AccessUnit& unit) {
+    if (ready.empty()) {
+        return false;
+    }
+    unit = std::move(ready.front());
+    ready.pop_front();
+    return true;
+}
+
+std::string H264Fragmenter::codec() const {
+    if (sps.size() < 4) {
+        return std::string();
+    }
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "avc1.%02x%02x%02x", sps[1], sps[2], sps[3]);
+    return buffer;
+}
+
+H264Fragmenter::Stats H264Fragmenter::stats() const {
+    return counters;
+}
@@ -0,0 +1,78 @@
+#ifndef H264_FRAGMENTER_H
+#define H264_FRAGMENTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Splits an H.264 Annex-B byte stream into access units for live preview.
+ *
+ * Bytes arrive in arbitrary pipe-sized chunks (ffmpeg encoding or passing the
+ * camera stream through); each complete access unit (one frame: its slices
+ * plus any parameter sets and SEI) is queued for sending. The units since the
+ * last IDR are kept as a keyframe cache, so a viewer joining mid-stream gets a
+ * decodable start (SPS, PPS, IDR and the frames after it) and then follows the
+ * live units. Keyframes always carry SPS/PPS, for cameras that only send them
+ * once. Not thread-safe; one producer feeds it.
+ */
+class H264Fragmenter {
+public:
+    struct AccessUnit {
+        std::vector<uint8_t> data; // Annex-B, 4-byte start codes
+        bool keyframe = false;
+        uint64_t index = 0;        // Consecutive from 0
+    };
+
+    struct Stats {
+        uint64_t accessUnits = 0;
+        uint64_t keyframes = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;     // Access unit bytes produced (per viewer, before the join cache)
+        uint64_t cachedBytes = 0;
+        uint64_t cachedUnits = 0;
+        uint64_t droppedCache = 0; // GOPs too large for the cache; joiners wait for the next IDR
+    };
+
+    explicit H264Fragmenter(size_t maxCacheBytes);
+
+    /**
+     * @brief Appends stream bytes.
+     * @return The number of access units completed by this chunk (read them with next()).
+     */
+    size_t push(const uint8_t* data, size_t length);
+
+    // Pops the oldest completed access unit
+    bool next(AccessUnit& unit);
+
+    // Units from the last IDR up to the newest completed one; empty before the first IDR
+    const std::deque<AccessUnit>& joinUnits() const { return cache; }
+
+    // RFC 6381 codec string ("avc1.42e01f") from the SPS, empty before the first SPS
+    std::string codec() const;
+
+    Stats stats() const;
+
+private:
+    void onNal(const uint8_t* nal, size_t length);
+    void finishAccessUnit();
+    void appendNal(std::vector<uint8_t>& out, const std::vector<uint8_t>& nal) const;
+
+    size_t maxCacheBytes;
+    std::vector<uint8_t> pending;          // Bytes after the last start code seen
+    std::vector<std::vector<uint8_t>> nals; // NAL units of the access unit being assembled
+    bool currentHasVcl;
+    bool currentIsKey;
+    bool currentHasSps;
+    std::vector<uint8_t> sps;
+    std::vector<uint8_t> pps;
+    std::deque<AccessUnit> ready;
+    std::deque<AccessUnit> cache;
+    bool cacheValid;
+    uint64_t nextIndex;
+    Stats counters;
+};
+
+#endif // H264_FRAGMENTER_H
@@ -0,0 +1,230 @@
+#include "low_power_detector.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+cv::Size scaledWindow(cv::Size window, double factor) {
+    return cv::Size(cvRound(window.width * factor), cvRound(window.height * factor));
+}
+
+} // namespace
+
+LowPowerDetector::Lease::Lease(LowPowerDetector& owner, std::unique_ptr<cv::CascadeClassifier> classifier)
+    : owner(&owner), classifier(std::move(classifier)) {}
+
+LowPowerDetector::Lease::Lease(Lease&& other) noexcept
+    : owner(other.owner), classifier(std::move(other.classifier)) {}
+
+LowPowerDetector::Lease::~Lease() {
+    if (classifier) {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        owner->idle.push_back(std::move(classifier));
+    }
+}
+
+bool LowPowerDetector::load(const std::string& cascadePath) {
+    std::unique_ptr<cv::CascadeClassifier> classifier(new cv::CascadeClassifier());
+    if (!classifier->load(cascadePath)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    path = cascadePath;
+    windowSize = classifier->getOriginalWindowSize();
+    idle.clear();
+    idle.push_back(std::move(classifier));
+    cameras.clear();
+    return true;
+}
+
+bool LowPowerDetector::isLoaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !path.empty();
+}
+
+std::string LowPowerDetector::name() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return path.find("lbpcascade") != std::string::npos ? "lbp-cascade" : "haar-cascade";
+}
+
+void LowPowerDetector::setConfig(const Config& next) {
+    std::lock_guard<std::mutex> lock(mutex);
+    config = next;
+}
+
+LowPowerDetector::Config LowPowerDetector::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return config;
+}
+
+LowPowerDetector::Lease LowPowerDetector::acquire() {
+    std::string cascadePath;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            std::unique_ptr<cv::CascadeClassifier> classifier = std::move(idle.back());
+            idle.pop_back();
+            return Lease(*this, std::move(classifier));
+        }
+        cascadePath = path;
+    }
+    // Every copy is busy: load another (cascade files parse in a few milliseconds)
+    std::unique_ptr<cv::CascadeClassifier> classifier(new cv::CascadeClassifier());
+    classifier->load(cascadePath);
+    return Lease(*this, std::move(classifier));
+}
+
+void LowPowerDetector::scanFull(const cv::Mat& gray, const Config& current, std::vector<cv::Rect>& faces) {
+    cv::Size window;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        window = windowSize;
+    }
+    int maxSize = std::min(gray.cols, gray.rows);
+    double step = std::max(1.01, current.scaleFactor);
+
+    // Scale levels as detectMultiScale walks them, with their cost (scanned pixels shrink as 1/factor^2)
+    std::vector<double> factors;
+    std::vector<double> costs;
+    double totalCost = 0.0;
+    for (double factor = 1.0; ; factor *= step) {
+        cv::Size size = scaledWindow(window, factor);
+        if (size.width > maxSize || size.height > maxSize) break;
+        if (size.width < current.minFaceSize) continue;
+        factors.push_back(factor);
+        costs.push_back(1.0 / (factor * factor));
+        totalCost += costs.back();
+    }
+    if (factors.empty()) {
+        return;
+    }
+
+    // Contiguous bands of about equal cost; the small sizes (large scaled images) dominate
+    int bands = current.scaleBands > 0 ? current.scaleBands
+                                       : static_cast<int>(std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    bands = std::min(bands, static_cast<int>(factors.size()));
+    std::vector<std::pair<cv::Size, cv::Size>> ranges;
+    double bandCost = totalCost / bands;
+    double accumulated = 0.0;
+    size_t first = 0;
+    for (size_t i = 0; i < factors.size(); i++) {
+        accumulated += costs[i];
+        bool last = i + 1 == factors.size();
+        if (last || (accumulated >= bandCost * (ranges.size() + 1) && static_cast<int>(ranges.size()) + 1 < bands)) {
+            ranges.emplace_back(scaledWindow(window, factors[first]), scaledWindow(window, factors[i]));
+            first = i + 1;
+        }
+    }
+
+    auto scanBand = [this, &gray, &current](std::pair<cv::Size, cv::Size> range) {
+        Lease lease = acquire();
+        std::vector<cv::Rect> hits;
+        lease.get().detectMultiScale(gray, hits, current.scaleFactor, current.minNeighbors, cv::CASCADE_SCALE_IMAGE,
+                                     range.first, range.second);
+        return hits;
+    };
+
+    std::vector<std::future<std::vector<cv::Rect>>> pending;
+    for (size_t i = 1; i < ranges.size(); i++) {
+        pending.push_back(std::async(std::launch::async, scanBand, ranges[i]));
+    }
+    faces = scanBand(ranges[0]);
+    for (auto& band : pending) {
+        std::vector<cv::Rect> hits = band.get();
+        faces.insert(faces.end(), hits.begin(), hits.end());
+    }
+}
+
+void LowPowerDetector::scanRegions(const cv::Mat& gray, const Config& current, const std::vector<cv::Rect>& previous,
+                                   std::vector<cv::Rect>& faces) {
+    Lease lease = acquire();
+    cv::Rect bounds(0, 0, gray.cols, gray.rows);
+    for (const cv::Rect& face : previous) {
+        int margin = static_cast<int>(std::max(face.width, face.height) * current.roiMargin);
+        cv::Rect roi = cv::Rect(face.x - margin, face.y - margin, face.width + 2 * margin, face.height + 2 * margin) & bounds;
+        if (roi.width <= 0 || roi.height <= 0) continue;
+
+        // A face moves little between sampled frames: only look for sizes near its last one
+        int minSize = std::max(current.minFaceSize, face.width * 2 / 3);
+        int maxSize = std::min(std::min(roi.width, roi.height), face.width * 3 / 2);
+        if (maxSize < minSize) continue;
+
+        std::vector<cv::Rect> hits;
+        lease.get().detectMultiScale(gray(roi), hits, current.scaleFactor, current.minNeighbors, cv::CASCADE_SCALE_IMAGE,
+                                     cv::Size(minSize, minSize), cv::Size(maxSize, maxSize));
+        for (cv::Rect& hit : hits) {
+            faces.push_back(hit + roi.tl());
+        }
+    }
+}
+
+void LowPowerDetector::detect(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& faces) {
+    auto start = std::chrono::steady_clock::now();
+    Config current = getConfig();
+
+    // The pyramid's level is shared with the other stages, so equalize into a new image
+    cv::Mat scanned = pyramid.grayForWidth(current.processWidth);
+    double scale = static_cast<double>(scanned.cols) / pyramid.size().width;
+    cv::Mat gray;
+    cv::equalizeHist(scanned, gray);
+
+    std::vector<cv::Rect> previous;
+    if (cameraId >= 0 && current.roiReuse) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cameras.find(cameraId);
+        if (it != cameras.end() && it->second.framesSinceFull + 1 < current.fullScanFrames) {
+            previous = it->second.faces;
+        }
+    }
+
+    std::vector<cv::Rect> found;
+    bool fullScan = previous.empty();
+    bool lost = false;
+    if (!fullScan) {
+        scanRegions(gray, current, previous, found);
+        if (found.size() < previous.size()) {
+            // A face moved out of its region or left; rescan everything rather than drop it
+            lost = true;
+            fullScan = true;
+            found.clear();
+        }
+    }
+    if (fullScan) {
+        scanFull(gray, current, found);
+    }
+
+    if (cameraId >= 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        CameraState& state = cameras[cameraId];
+        CameraStats& stats = state.stats;
+        double ms = elapsedMs(start);
+        stats.frames++;
+        stats.avgScanMs = stats.frames == 1 ? ms : stats.avgScanMs * 0.9 + ms * 0.1;
+        if (fullScan) stats.fullScans++; else stats.roiScans++;
+        if (lost) stats.roiMisses++;
+        stats.trackedFaces = found.size();
+        state.faces = found;
+        state.framesSinceFull = fullScan ? 0 : state.framesSinceFull + 1;
+    }
+
+    faces.clear();
+    faces.reserve(found.size());
+    for (const cv::Rect& face : found) {
+        faces.emplace_back(cvRound(face.x / scale), cvRound(face.y / scale), cvRound(face.width / scale), cvRound(face.height / scale));
+    }
+}
+
+std::map<int, LowPowerDetector::CameraStats> LowPowerDetector::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<int, CameraStats> result;
+    for (const auto& entry : cameras) {
+        result[entry.first] = entry.second.stats;
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+#ifndef LOW_POWER_DETECTOR_H
+#define LOW_POWER_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/objdetect.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "frame_pyramid.h"
+
+/**
+ * @brief Cascade face detector for hardware that cannot keep up with the detection network.
+ *
+ * Frames are downscaled before scanning, and a full scan splits the cascade's
+ * scale levels into bands of equal cost that run in parallel, each on its own
+ * classifier copy (CascadeClassifier is not safe to share across threads).
+ * Between full scans a camera's previous faces are re-found by scanning only
+ * the area around them at nearby sizes; a full scan still runs every
+ * fullScanFrames frames, and at once when a face is lost, so new faces are
+ * picked up.
+ */
+class LowPowerDetector {
+public:
+    struct Config {
+        int processWidth = 480;     // Frames are scanned at this width (0 = full resolution)
+        double scaleFactor = 1.1;   // Size step between scale levels
+        int minNeighbors = 3;
+        int minFaceSize = 20;       // Smallest face, in scanned pixels
+        int scaleBands = 0;         // Scale bands scanned in parallel (0 = one per hardware thread, at most 4)
+        bool roiReuse = true;
+        int fullScanFrames = 5;     // Full scan at least every N frames of a camera with faces
+        double roiMargin = 0.5;     // Area around a previous face scanned, as a fraction of its size per side
+    };
+
+    struct CameraStats {
+        unsigned long long frames = 0;
+        unsigned long long fullScans = 0;
+        unsigned long long roiScans = 0;   // Frames that only scanned around previous faces
+        unsigned long long roiMisses = 0;  // ROI scans that lost a face and fell back to a full scan
+        size_t trackedFaces = 0;           // Faces found in the last frame
+        double avgScanMs = 0.0;
+    };
+
+    /**
+     * @brief Loads the cascade file; further copies are loaded from it on demand.
+     * @return false if the file is not a loadable cascade.
+     */
+    bool load(const std::string& cascadePath);
+    bool isLoaded() const;
+    std::string name() const; // "lbp-cascade" or "haar-cascade"
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+
+    /**
+     * @brief Finds faces in a frame, scanning the pyramid's luma at processWidth; rectangles are in frame coordinates.
+     * @param cameraId Camera the frame came from, for ROI reuse; -1 always scans the full frame.
+     */
+    void detect(FramePyramid& pyramid, int cameraId, std::vector<cv::Rect>& faces);
+
+    std::map<int, CameraStats> snapshot() const;
+
+private:
+    // A classifier copy held by one scan
+    class Lease {
+    public:
+        Lease(LowPowerDetector& owner, std::unique_ptr<cv::CascadeClassifier> classifier);
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        cv::CascadeClassifier& get() { return *classifier; }
+    private:
+        LowPowerDetector* owner;
+        std::unique_ptr<cv::CascadeClassifier> classifier;
+    };
+
+    struct CameraState {
+        CameraStats stats;
+        std::vector<cv::Rect> faces; // In scanned coordinates
+        int framesSinceFull = 0;
+    };
+
+    Lease acquire();
+    void scanFull(const cv::Mat& gray, const Config& config, std::vector<cv::Rect>& faces);
+    void scanRegions(const cv::Mat& gray, const Config& config, const std::vector<cv::Rect>& previous, std::vector<cv::Rect>& faces);
+
+    mutable std::mutex mutex;
+    std::string path;
+    cv::Size windowSize;
+    std::vector<std::unique_ptr<cv::CascadeClassifier>> idle;
+    Config config;
+    std::map<int, CameraState> cameras;
+};
+
+#endif // LOW_POWER_DETECTOR_H
@@ -0,0 +1,131 @@
+#include "roi_decoder.h"
+#include <opencv2/imgcodecs.hpp>
+#include <iostream>
+
+#ifdef FD_HAVE_LIBJPEG_TURBO
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+// libjpeg reports fatal errors through error_exit, which must not return
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+static void jpegSilentMessage(j_common_ptr) {
+    // Corrupt-data warnings are not fatal; the caller only needs the pixels
+}
+
+// Decodes the scanlines of `region` only. Returns false for anything it does not handle (the caller
+// then falls back to a full decode), so nothing with a destructor may live in this frame past setjmp.
+static bool decodeJpegRegion(const uint8_t* data, size_t length, const cv::Rect& region, cv::Mat& out, RegionDecodeInfo& info) {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager error;
+    cinfo.err = jpeg_std_error(&error.base);
+    error.base.error_exit = jpegErrorExit;
+    error.base.output_message = jpegSilentMessage;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(length));
+    jpeg_read_header(&cinfo, TRUE);
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.out_color_space = JCS_EXT_BGR;
+    jpeg_start_decompress(&cinfo);
+
+    info.imageSize = cv::Size(static_cast<int>(cinfo.output_width), static_cast<int>(cinfo.output_height));
+    cv::Rect clipped = region & cv::Rect(cv::Point(0, 0), info.imageSize);
+    if (clipped.width <= 0 || clipped.height <= 0) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    // Widened to whole iMCU columns; only those are entropy-decoded past the skipped rows
+    JDIMENSION xoffset = static_cast<JDIMENSION>(clipped.x);
+    JDIMENSION width = static_cast<JDIMENSION>(clipped.width);
+    jpeg_crop_scanline(&cinfo, &xoffset, &width);
+    if (clipped.y > 0) {
+        jpeg_skip_scanlines(&cinfo, static_cast<JDIMENSION>(clipped.y));
+    }
+
+    out.create(clipped.height, static_cast<int>(width), CV_8UC3);
+    JDIMENSION last = static_cast<JDIMENSION>(clipped.y + clipped.height);
+    while (cinfo.output_scanline < last) {
+        JSAMPROW row = out.ptr<uint8_t>(static_cast<int>(cinfo.output_scanline) - clipped.y);
+        if (jpeg_read_scanlines(&cinfo, &row, 1) != 1) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+    }
+
+    // The rows below the region are never decoded
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    info.decoded = cv::Rect(static_cast<int>(xoffset), clipped.y, static_cast<int>(width), clipped.height);
+    info.partial = true;
+    return true;
+}
+#endif
+
+static bool isJpeg(const uint8_t* data, size_t length) {
+    return length > 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool partialJpegDecodeAvailable() {
+#ifdef FD_HAVE_LIBJPEG_TURBO
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool decodeImageRegion(const uint8_t* data, size_t length, const cv::Rect& region, cv::Mat& out, RegionDecodeInfo& info) {
+    info = RegionDecodeInfo();
+    if (!data || length == 0 || region.width <= 0 || region.height <= 0) {
+        return false;
+    }
+
+#ifdef FD_HAVE_LIBJPEG_TURBO
+    if (isJpeg(data, length)) {
+        if (decodeJpegRegion(data, length, region, out, info)) {
+            return true;
+        }
+        if (info.imageSize.area() > 0 && (region & cv::Rect(cv::Point(0, 0), info.imageSize)).area() == 0) {
+            return false; // Decodable, but the region is outside the image
+        }
+    }
+#else
+    (void)isJpeg;
+#endif
+
+    cv::Mat image;
+    try {
+        image = cv::imdecode(cv::Mat(1, static_cast<int>(length), CV_8U, const_cast<uint8_t*>(data)), cv::IMREAD_COLOR);
+    } catch (const std::exception& e) {
+        std::cerr << "Image decode failed: " << e.what() << std::endl;
+    }
+    if (image.empty()) {
+        return false;
+    }
+
+    info.imageSize = image.size();
+    info.decoded = region & cv::Rect(cv::Point(0, 0), info.imageSize);
+    info.partial = false;
+    if (info.decoded.width <= 0 || info.decoded.height <= 0) {
+        return false;
+    }
+    out = image(info.decoded);
+    return true;
+}
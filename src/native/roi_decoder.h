@@ -0,0 +1,30 @@
+#ifndef ROI_DECODER_H
+#define ROI_DECODER_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+
+struct RegionDecodeInfo {
+    cv::Size imageSize;   // Size of the whole encoded image
+    cv::Rect decoded;     // Image area `out` covers; contains the requested region clipped to the image
+    bool partial = false; // Only the region was decoded (JPEG with libjpeg-turbo), not the whole image
+};
+
+/**
+ * @brief Decodes the part of an encoded image that covers `region` into a BGR Mat.
+ *
+ * For baseline and progressive JPEGs built with libjpeg-turbo (FD_HAVE_LIBJPEG_TURBO)
+ * only the scanlines of the region are decoded, cropped horizontally to the iMCU
+ * columns that cover it; the rows above it are skipped without color conversion
+ * or upsampling and decoding stops after its last row. Other formats, and builds
+ * without libjpeg-turbo, decode the whole image and return a view of the region.
+ *
+ * @return false if the image cannot be decoded or the region lies outside it.
+ */
+bool decodeImageRegion(const uint8_t* data, size_t length, const cv::Rect& region, cv::Mat& out, RegionDecodeInfo& info);
+
+// True if the build decodes JPEG regions without decoding the whole image
+bool partialJpegDecodeAvailable();
+
+#endif // ROI_DECODER_H
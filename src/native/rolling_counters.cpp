@@ -0,0 +1,318 @@
+#include "rolling_counters.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43524446; // "FDRC" in native byte order
+constexpr uint32_t kVersion = 1;
+constexpr int64_t kEmpty = INT64_MIN;   // Ring that has never been written
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+// Position of a bucket in its ring; buckets before 1970 (negative) wrap as well
+size_t slotOf(int64_t bucket, size_t size) {
+    return static_cast<size_t>(bucket - floorDiv(bucket, static_cast<int64_t>(size)) * static_cast<int64_t>(size));
+}
+
+template <typename T>
+bool writeValue(std::FILE* file, const T& value) {
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool readValue(std::FILE* file, T& value) {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // namespace
+
+RollingCounters::RollingCounters(const Config& cfg) : config(cfg) {
+    ringSize[0] = std::max<size_t>(1, config.minuteBuckets);
+    ringSize[1] = std::max<size_t>(1, config.hourBuckets);
+    ringSize[2] = std::max<size_t>(1, config.dayBuckets);
+    widthMs[0] = 60LL * 1000;
+    widthMs[1] = 60LL * 60 * 1000;
+    widthMs[2] = 24LL * 60 * 60 * 1000;
+    config.maxSeries = std::max<size_t>(1, config.maxSeries);
+}
+
+int64_t RollingCounters::bucketOf(int64_t atMs, int granularity) const {
+    return floorDiv(atMs + static_cast<int64_t>(config.utcOffsetMinutes) * 60 * 1000, widthMs[granularity]);
+}
+
+size_t RollingCounters::seriesFor(const Key& key) {
+    auto found = index.find(key);
+    if (found != index.end()) {
+        return found->second;
+    }
+    if (keys.size() >= config.maxSeries) {
+        return SIZE_MAX;
+    }
+    size_t series = keys.size();
+    keys.push_back(key);
+    index.emplace(key, series);
+    byOrganization[key.organizationId].push_back(series);
+    heads.insert(heads.end(), kGranularities, kEmpty);
+    for (int g = 0; g < kGranularities; g++) {
+        pools[g].resize(pools[g].size() + ringSize[g] * 2, 0);
+    }
+    return series;
+}
+
+void RollingCounters::bump(size_t series, int granularity, int64_t bucket, uint32_t count, bool recognized) {
+    const size_t size = ringSize[granularity];
+    int64_t& head = heads[series * kGranularities + granularity];
+    uint32_t* ring = pools[granularity].data() + series * size * 2;
+
+    if (head == kEmpty || bucket - head >= static_cast<int64_t>(size)) {
+        // Everything in the ring has expired
+        if (head != kEmpty) {
+            std::fill(ring, ring + size * 2, 0u);
+        }
+        head = bucket;
+    } else if (bucket > head) {
+        // Clear the buckets skipped since the last detection
+        for (int64_t b = head + 1; b <= bucket; b++) {
+            size_t slot = slotOf(b, size);
+            ring[slot * 2] = 0;
+            ring[slot * 2 + 1] = 0;
+        }
+        head = bucket;
+    } else if (head - bucket >= static_cast<int64_t>(size)) {
+        late++;
+        return;
+    }
+
+    size_t slot = slotOf(bucket, size);
+    ring[slot * 2] += count;
+    if (recognized) {
+        ring[slot * 2 + 1] += count;
+    }
+}
+
+void RollingCounters::record(const Increment* batch, size_t count) {
+    if (!batch || count == 0) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (size_t i = 0; i < count; i++) {
+        const Increment& inc = batch[i];
+        if (inc.count == 0) {
+            continue;
+        }
+        int64_t buckets[kGranularities];
+        for (int g = 0; g < kGranularities; g++) {
+            buckets[g] = bucketOf(inc.atMs, g);
+        }
+
+        const Key scoped[] = {
+            {inc.organizationId, inc.organizationId, Scope::Organization},
+            {inc.organizationId, inc.cameraId, Scope::Camera},
+            {inc.organizationId, inc.eventId, Scope::Event},
+            {inc.organizationId, inc.personId, Scope::Person},
+        };
+        for (const Key& key : scoped) {
+            if (key.scope != Scope::Organization && key.id < 0) {
+                continue;
+            }
+            size_t series = seriesFor(key);
+            if (series == SIZE_MAX) {
+                dropped++;
+                continue;
+            }
+            for (int g = 0; g < kGranularities; g++) {
+                bump(series, g, buckets[g], inc.count, inc.recognized);
+            }
+        }
+        latestMs = std::max(latestMs, inc.atMs);
+        increments += inc.count;
+    }
+}
+
+void RollingCounters::snapshot(const Query& query, Snapshot& out) const {
+    const int g = std::min(std::max(static_cast<int>(query.granularity), 0), kGranularities - 1);
+    const size_t size = ringSize[g];
+    const size_t buckets = std::min(std::max<size_t>(1, query.buckets), size);
+    const int64_t last = bucketOf(query.endMs, g);
+    const int64_t first = last - static_cast<int64_t>(buckets) + 1;
+
+    out.bucketMs = widthMs[g];
+    out.buckets = buckets;
+    out.firstBucketMs = first * widthMs[g] - static_cast<int64_t>(config.utcOffsetMinutes) * 60 * 1000;
+    out.series.clear();
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto organization = byOrganization.find(query.organizationId);
+    if (organization == byOrganization.end()) {
+        return;
+    }
+    out.series.reserve(organization->second.size());
+    for (size_t series : organization->second) {
+        const Key& key = keys[series];
+        if (query.scopes != 0 && !(query.scopes & (1u << static_cast<uint32_t>(key.scope)))) {
+            continue;
+        }
+        Series result;
+        result.scope = key.scope;
+        result.id = key.id;
+        result.counts.assign(buckets, 0);
+        result.recognized.assign(buckets, 0);
+
+        // Buckets newer than the head were never written; older than the ring have been reused
+        const int64_t head = heads[series * kGranularities + g];
+        const uint32_t* ring = pools[g].data() + series * size * 2;
+        if (head != kEmpty) {
+            int64_t from = std::max(first, head - static_cast<int64_t>(size) + 1);
+            int64_t to = std::min(last, head);
+            for (int64_t b = from; b <= to; b++) {
+                size_t slot = slotOf(b, size);
+                size_t at = static_cast<size_t>(b - first);
+                result.counts[at] = ring[slot * 2];
+                result.recognized[at] = ring[slot * 2 + 1];
+                result.total += ring[slot * 2];
+                result.recognizedTotal += ring[slot * 2 + 1];
+            }
+        }
+        out.series.push_back(std::move(result));
+    }
+}
+
+bool RollingCounters::save(const std::string& path) const {
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        std::cerr << "❌ Rolling counters: cannot write " << temporary << std::endl;
+        return false;
+    }
+
+    bool ok;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const uint64_t seriesCount = keys.size();
+        ok = writeValue(file, kMagic) && writeValue(file, kVersion) &&
+             writeValue(file, static_cast<uint64_t>(ringSize[0])) &&
+             writeValue(file, static_cast<uint64_t>(ringSize[1])) &&
+             writeValue(file, static_cast<uint64_t>(ringSize[2])) &&
+             writeValue(file, static_cast<int32_t>(config.utcOffsetMinutes)) &&
+             writeValue(file, latestMs) && writeValue(file, seriesCount);
+        for (size_t s = 0; ok && s < keys.size(); s++) {
+            ok = writeValue(file, keys[s].organizationId) && writeValue(file, keys[s].id) &&
+                 writeValue(file, static_cast<uint8_t>(keys[s].scope));
+        }
+        ok = ok && (heads.empty() || std::fwrite(heads.data(), sizeof(int64_t), heads.size(), file) == heads.size());
+        for (int g = 0; ok && g < kGranularities; g++) {
+            ok = pools[g].empty() || std::fwrite(pools[g].data(), sizeof(uint32_t), pools[g].size(), file) == pools[g].size();
+        }
+    }
+    ok = (std::fclose(file) == 0) && ok;
+
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(temporary.c_str());
+        std::cerr << "❌ Rolling counters: saving " << path << " failed" << std::endl;
+        return false;
+    }
+    saves++;
+    return true;
+}
+
+bool RollingCounters::load(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic = 0, version = 0;
+    uint64_t sizes[kGranularities] = {0, 0, 0};
+    int32_t offset = 0;
+    int64_t savedLatest = 0;
+    uint64_t seriesCount = 0;
+    bool ok = readValue(file, magic) && readValue(file, version) && magic == kMagic && version == kVersion &&
+              readValue(file, sizes[0]) && readValue(file, sizes[1]) && readValue(file, sizes[2]) &&
+              readValue(file, offset) && readValue(file, savedLatest) && readValue(file, seriesCount);
+    // Other ring sizes or a new UTC offset would misplace every bucket
+    ok = ok && sizes[0] == ringSize[0] && sizes[1] == ringSize[1] && sizes[2] == ringSize[2] &&
+         offset == config.utcOffsetMinutes && seriesCount <= config.maxSeries;
+
+    std::vector<Key> loadedKeys;
+    std::vector<int64_t> loadedHeads;
+    std::vector<uint32_t> loadedPools[kGranularities];
+    if (ok) {
+        loadedKeys.resize(seriesCount);
+        for (size_t s = 0; ok && s < seriesCount; s++) {
+            uint8_t scope = 0;
+            ok = readValue(file, loadedKeys[s].organizationId) && readValue(file, loadedKeys[s].id) &&
+                 readValue(file, scope) && scope <= static_cast<uint8_t>(Scope::Person);
+            loadedKeys[s].scope = static_cast<Scope>(scope);
+        }
+        loadedHeads.resize(seriesCount * kGranularities);
+        ok = ok && (loadedHeads.empty() ||
+                    std::fread(loadedHeads.data(), sizeof(int64_t), loadedHeads.size(), file) == loadedHeads.size());
+        for (int g = 0; ok && g < kGranularities; g++) {
+            loadedPools[g].resize(seriesCount * ringSize[g] * 2);
+            ok = loadedPools[g].empty() ||
+                 std::fread(loadedPools[g].data(), sizeof(uint32_t), loadedPools[g].size(), file) == loadedPools[g].size();
+        }
+    }
+    std::fclose(file);
+    if (!ok) {
+        std::cerr << "⚠️ Rolling counters: ignoring " << path << " (damaged or written with other settings)" << std::endl;
+        return false;
+    }
+
+    std::unordered_map<Key, size_t, KeyHash> loadedIndex;
+    std::unordered_map<int64_t, std::vector<size_t>> loadedOrganizations;
+    loadedIndex.reserve(loadedKeys.size());
+    for (size_t s = 0; s < loadedKeys.size(); s++) {
+        if (!loadedIndex.emplace(loadedKeys[s], s).second) {
+            std::cerr << "⚠️ Rolling counters: ignoring " << path << " (duplicate series)" << std::endl;
+            return false;
+        }
+        loadedOrganizations[loadedKeys[s].organizationId].push_back(s);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    keys.swap(loadedKeys);
+    index.swap(loadedIndex);
+    byOrganization.swap(loadedOrganizations);
+    heads.swap(loadedHeads);
+    for (int g = 0; g < kGranularities; g++) {
+        pools[g].swap(loadedPools[g]);
+    }
+    latestMs = savedLatest;
+    loads++;
+    return true;
+}
+
+RollingCounters::Stats RollingCounters::stats() const {
+    Stats s;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        s.series = keys.size();
+        s.organizations = byOrganization.size();
+        s.memoryBytes = keys.capacity() * sizeof(Key) + heads.capacity() * sizeof(int64_t) +
+                        index.size() * (sizeof(Key) + sizeof(size_t) + 2 * sizeof(void*));
+        for (int g = 0; g < kGranularities; g++) {
+            s.memoryBytes += pools[g].capacity() * sizeof(uint32_t);
+        }
+        s.latestMs = latestMs;
+    }
+    s.increments = increments.load();
+    s.late = late.load();
+    s.dropped = dropped.load();
+    s.saves = saves.load();
+    s.loads = loads.load();
+    return s;
+}
@@ -0,0 +1,141 @@
+#ifndef ROLLING_COUNTERS_H
+#define ROLLING_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Time-bucketed detection counts for dashboards, independent of table size.
+ *
+ * Every detection bumps one series for its organization and one each for its
+ * camera, event and person, at minute, hour and day granularity. Each
+ * granularity is a fixed ring of buckets per series (the last 120 minutes, 72
+ * hours and 90 days by default), holding the number of detections and how many
+ * of them were recognized. Buckets that fall out of the ring are reused, so a
+ * series never grows. Rings of one granularity live in one pool, so a series
+ * costs about 2 KB with the defaults. snapshot() returns every series of an
+ * organization over a bucket window in one call. save() writes the whole
+ * structure to disk (to a temporary file, then renamed) and load() restores it.
+ * Bucket boundaries follow utcOffsetMinutes, so "today" is a local day.
+ */
+class RollingCounters {
+public:
+    enum class Scope : uint8_t { Organization = 0, Camera = 1, Event = 2, Person = 3 };
+    enum class Granularity { Minute = 0, Hour = 1, Day = 2 };
+
+    struct Config {
+        size_t minuteBuckets = 120;
+        size_t hourBuckets = 72;
+        size_t dayBuckets = 90;
+        int utcOffsetMinutes = 0;
+        size_t maxSeries = 50000; // Further series are dropped (counted in stats)
+    };
+
+    // One or more detections; ids below 0 mean "none" and skip that series
+    struct Increment {
+        int64_t organizationId = 0;
+        int64_t cameraId = -1;
+        int64_t eventId = -1;
+        int64_t personId = -1;
+        int64_t atMs = 0;
+        uint32_t count = 1;
+        bool recognized = false;
+    };
+
+    struct Query {
+        int64_t organizationId = 0;
+        Granularity granularity = Granularity::Hour;
+        size_t buckets = 24;     // Ending with the bucket that holds endMs
+        int64_t endMs = 0;
+        uint32_t scopes = 0;     // Bit (1 << Scope); 0 = every scope
+    };
+
+    struct Series {
+        Scope scope = Scope::Organization;
+        int64_t id = 0;
+        std::vector<uint32_t> counts;     // Oldest bucket first
+        std::vector<uint32_t> recognized;
+        uint64_t total = 0;               // Over the window
+        uint64_t recognizedTotal = 0;
+    };
+
+    struct Snapshot {
+        int64_t firstBucketMs = 0; // Start of the oldest bucket, Unix epoch ms
+        int64_t bucketMs = 0;
+        size_t buckets = 0;
+        std::vector<Series> series;
+    };
+
+    struct Stats {
+        size_t series = 0;
+        size_t organizations = 0;
+        uint64_t memoryBytes = 0;
+        uint64_t increments = 0;
+        uint64_t late = 0;       // Older than a ring; not counted at that granularity
+        uint64_t dropped = 0;    // Refused for lack of series
+        int64_t latestMs = 0;    // Newest detection counted
+        uint64_t saves = 0;
+        uint64_t loads = 0;
+    };
+
+    explicit RollingCounters(const Config& config);
+
+    void record(const Increment* increments, size_t count);
+    void snapshot(const Query& query, Snapshot& out) const;
+
+    // False if the file cannot be written
+    bool save(const std::string& path) const;
+    // False if the file is missing, damaged or was written with other ring sizes or offset; the counters are unchanged
+    bool load(const std::string& path);
+
+    Stats stats() const;
+
+private:
+    static constexpr int kGranularities = 3;
+
+    struct Key {
+        int64_t organizationId;
+        int64_t id;
+        Scope scope;
+        bool operator==(const Key& other) const {
+            return organizationId == other.organizationId && id == other.id && scope == other.scope;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            uint64_t h = static_cast<uint64_t>(key.organizationId) * 0x9e3779b97f4a7c15ULL;
+            h ^= static_cast<uint64_t>(key.id) + 0x632be59bd9b4e5f5ULL + (h << 6) + (h >> 2);
+            return static_cast<size_t>(h ^ static_cast<uint64_t>(key.scope));
+        }
+    };
+
+    int64_t bucketOf(int64_t atMs, int granularity) const;
+    // Index of the series, created on first use; SIZE_MAX once maxSeries is reached
+    size_t seriesFor(const Key& key);
+    void bump(size_t series, int granularity, int64_t bucket, uint32_t count, bool recognized);
+
+    Config config;
+    size_t ringSize[kGranularities];
+    int64_t widthMs[kGranularities];
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<Key, size_t, KeyHash> index;
+    std::vector<Key> keys;
+    std::unordered_map<int64_t, std::vector<size_t>> byOrganization;
+    std::vector<int64_t> heads;               // series x granularity: newest bucket held by the ring
+    std::vector<uint32_t> pools[kGranularities]; // series x ring x {count, recognized}
+    int64_t latestMs = 0;
+
+    std::atomic<uint64_t> increments{0};
+    std::atomic<uint64_t> late{0};
+    std::atomic<uint64_t> dropped{0};
+    mutable std::atomic<uint64_t> saves{0};
+    std::atomic<uint64_t> loads{0};
+};
+
+#endif // ROLLING_COUNTERS_H
@@ -0,0 +1,176 @@
+#include "sampling_controller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+
+// Cameras not seen for this long no longer count against the CPU budget
+static const std::chrono::seconds kStaleAfter(60);
+
+SamplingController::SamplingController() : cpuBudget(0.5f), totalDemand(0.0) {}
+
+void SamplingController::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    defaults = config;
+}
+
+SamplingController::Config SamplingController::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return defaults;
+}
+
+void SamplingController::setCameraConfig(int cameraId, const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overrides[cameraId] = config;
+}
+
+void SamplingController::clearCameraConfig(int cameraId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overrides.erase(cameraId);
+}
+
+SamplingController::Config SamplingController::configFor(int cameraId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return configLocked(cameraId);
+}
+
+const SamplingController::Config& SamplingController::configLocked(int cameraId) const {
+    auto it = overrides.find(cameraId);
+    return it != overrides.end() ? it->second : defaults;
+}
+
+void SamplingController::setCpuBudget(float budget) {
+    std::lock_guard<std::mutex> lock(mutex);
+    cpuBudget = std::max(0.01f, budget);
+}
+
+float SamplingController::getCpuBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cpuBudget;
+}
+
+float SamplingController::decayedActivity(const CameraState& state, const Config& config, std::chrono::steady_clock::time_point now) const {
+    if (config.idleHalfLifeMs <= 0) return state.stats.activity;
+    double idleMs = std::chrono::duration<double, std::milli>(now - state.lastActivity).count();
+    return static_cast<float>(state.stats.activity * std::pow(0.5, idleMs / config.idleHalfLifeMs));
+}
+
+void SamplingController::observe(int cameraId, int faces, const uint8_t* thumbnail, double processingMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    const Config& config = configLocked(cameraId);
+
+    auto inserted = cameras.emplace(cameraId, CameraState());
+    CameraState& state = inserted.first->second;
+    CameraStats& stats = state.stats;
+    if (inserted.second) {
+        // A new camera starts fast so people already in the scene are picked up at once
+        stats.activity = 1.0f;
+        state.lastActivity = now;
+    }
+
+    float motion = 0.0f;
+    const size_t pixels = static_cast<size_t>(kThumbnailWidth) * kThumbnailHeight;
+    if (thumbnail) {
+        if (state.previous.size() == pixels) {
+            uint64_t difference = 0;
+            for (size_t i = 0; i < pixels; i++) {
+                difference += static_cast<uint64_t>(std::abs(static_cast<int>(thumbnail[i]) - static_cast<int>(state.previous[i])));
+            }
+            double meanDifference = static_cast<double>(difference) / pixels;
+            // A quarter of the threshold is sensor noise and compression flicker
+            double noise = config.motionThreshold * 0.25;
+            motion = static_cast<float>(std::min(1.0, std::max(0.0, (meanDifference - noise) / std::max(1e-3, config.motionThreshold - noise))));
+        }
+        state.previous.assign(thumbnail, thumbnail + pixels);
+    }
+
+    // Faces or motion raise activity at once; without them it decays from where it was
+    float signal = std::max(faces > 0 ? 1.0f : 0.0f, motion);
+    stats.activity = std::max(signal, decayedActivity(state, config, now));
+    state.lastActivity = now;
+
+    stats.motion = motion;
+    stats.faces = faces;
+    stats.frames++;
+    stats.avgProcessingMs = stats.frames == 1 ? processingMs : stats.avgProcessingMs * 0.8 + processingMs * 0.2;
+    state.lastSeen = now;
+    rebalanceLocked(now);
+}
+
+void SamplingController::rebalanceLocked(std::chrono::steady_clock::time_point now) {
+    struct Live {
+        CameraStats* stats;
+        double maxMs;
+    };
+
+    // Desired intervals from activity: log-linear between max (idle) and min (busy)
+    std::vector<Live> live;
+    totalDemand = 0.0;
+    for (auto& entry : cameras) {
+        CameraState& state = entry.second;
+        const Config& config = configLocked(entry.first);
+        double minMs = std::max(1, config.minIntervalMs);
+        double maxMs = std::max(minMs, static_cast<double>(config.maxIntervalMs));
+        float activity = decayedActivity(state, config, now);
+        state.stats.desiredIntervalMs = maxMs * std::pow(minMs / maxMs, static_cast<double>(activity));
+        state.stats.intervalMs = state.stats.desiredIntervalMs;
+        state.stats.budgetLimited = false;
+        if (now - state.lastSeen < kStaleAfter) {
+            live.push_back({&state.stats, maxMs});
+            totalDemand += state.stats.avgProcessingMs / state.stats.desiredIntervalMs;
+        }
+    }
+
+    // Over budget: stretch the intervals still below their maximum until the total fits
+    double capacity = cpuBudget * std::max(1u, std::thread::hardware_concurrency());
+    for (int pass = 0; pass < 4; pass++) {
+        double fixedLoad = 0.0, flexibleLoad = 0.0;
+        for (const Live& camera : live) {
+            double load = camera.stats->avgProcessingMs / camera.stats->intervalMs;
+            (camera.stats->intervalMs >= camera.maxMs ? fixedLoad : flexibleLoad) += load;
+        }
+        if (fixedLoad + flexibleLoad <= capacity || flexibleLoad <= 0.0) {
+            break;
+        }
+        double room = capacity - fixedLoad;
+        double factor = room > 0.0 ? flexibleLoad / room : std::numeric_limits<double>::infinity();
+        for (const Live& camera : live) {
+            if (camera.stats->intervalMs < camera.maxMs) {
+                camera.stats->intervalMs = std::min(camera.maxMs, camera.stats->intervalMs * factor);
+                camera.stats->budgetLimited = true;
+            }
+        }
+    }
+}
+
+double SamplingController::intervalMs(int cameraId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = cameras.find(cameraId);
+    if (it == cameras.end()) {
+        return std::max(1, configLocked(cameraId).minIntervalMs);
+    }
+    rebalanceLocked(now);
+    return it->second.stats.intervalMs;
+}
+
+std::map<int, SamplingController::CameraStats> SamplingController::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    rebalanceLocked(std::chrono::steady_clock::now());
+    std::map<int, CameraStats> result;
+    for (const auto& entry : cameras) {
+        CameraStats stats = entry.second.stats;
+        stats.activity = decayedActivity(entry.second, configLocked(entry.first), std::chrono::steady_clock::now());
+        stats.overridden = overrides.count(entry.first) > 0;
+        result[entry.first] = stats;
+    }
+    return result;
+}
+
+double SamplingController::demand() {
+    std::lock_guard<std::mutex> lock(mutex);
+    rebalanceLocked(std::chrono::steady_clock::now());
+    return totalDemand;
+}
@@ -0,0 +1,92 @@
+#ifndef SAMPLING_CONTROLLER_H
+#define SAMPLING_CONTROLLER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Chooses how often each camera's frames are sampled for detection.
+ *
+ * Every processed frame reports its face count, a tiny grayscale thumbnail
+ * (for frame-difference motion) and its processing time. A camera's activity
+ * jumps to the strongest of those signals and decays with a half-life while
+ * the scene stays empty; the sampling interval moves log-linearly from the
+ * camera's maximum (idle) to its minimum (busy). When the cameras together
+ * would need more detection time than the CPU budget allows, every interval
+ * is stretched by the same factor, up to each camera's maximum.
+ */
+class SamplingController {
+public:
+    struct Config {
+        int minIntervalMs = 500;        // Fastest sampling, used while faces are present
+        int maxIntervalMs = 10000;      // Slowest sampling for an empty scene
+        int idleHalfLifeMs = 10000;     // Activity halves this often without faces or motion
+        float motionThreshold = 6.0f;   // Mean thumbnail difference (gray levels) counted as full motion
+    };
+
+    struct CameraStats {
+        double intervalMs = 0.0;        // Effective interval after the CPU budget
+        double desiredIntervalMs = 0.0; // Interval from activity alone
+        float activity = 0.0f;
+        float motion = 0.0f;
+        int faces = 0;                  // In the last observed frame
+        double avgProcessingMs = 0.0;
+        unsigned long long frames = 0;
+        bool budgetLimited = false;
+        bool overridden = false;        // Camera has its own Config
+    };
+
+    // Thumbnail size the caller should pass to observe()
+    static constexpr int kThumbnailWidth = 64;
+    static constexpr int kThumbnailHeight = 36;
+
+    SamplingController();
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+    void setCameraConfig(int cameraId, const Config& config);
+    void clearCameraConfig(int cameraId);
+    Config configFor(int cameraId) const;
+
+    // Share of the hardware threads detection may use across all cameras (e.g. 0.5 = half)
+    void setCpuBudget(float budget);
+    float getCpuBudget() const;
+
+    /**
+     * @brief Records a processed frame.
+     * @param thumbnail kThumbnailWidth x kThumbnailHeight grayscale pixels, or nullptr to skip motion.
+     */
+    void observe(int cameraId, int faces, const uint8_t* thumbnail, double processingMs);
+
+    // Interval to wait before sampling the camera's next frame
+    double intervalMs(int cameraId);
+
+    std::map<int, CameraStats> snapshot();
+
+    // Detection time all recently seen cameras would use at their desired rates, in hardware threads
+    double demand();
+
+private:
+    struct CameraState {
+        CameraStats stats;
+        std::vector<uint8_t> previous;
+        std::chrono::steady_clock::time_point lastSeen;
+        std::chrono::steady_clock::time_point lastActivity;
+    };
+
+    const Config& configLocked(int cameraId) const;
+    float decayedActivity(const CameraState& state, const Config& config, std::chrono::steady_clock::time_point now) const;
+    void rebalanceLocked(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex;
+    Config defaults;
+    std::map<int, Config> overrides;
+    std::map<int, CameraState> cameras;
+    float cpuBudget;
+    double totalDemand;
+};
+
+#endif // SAMPLING_CONTROLLER_H
@@ -0,0 +1,317 @@
+#include "shared_runtime.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ThreadPool::ThreadPool(size_t numThreads) : state(std::make_shared<State>()) {
+    size_t threads = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i) {
+        std::shared_ptr<State> shared = state;
+        workers.emplace_back([shared] {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(shared->queueMutex);
+                    shared->condition.wait(lock, [&shared] { return shared->stop || !shared->tasks.empty(); });
+                    if (shared->stop && shared->tasks.empty())
+                        return;
+                    task = std::move(shared->tasks.front());
+                    shared->tasks.pop();
+                }
+                task();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(state->queueMutex);
+        state->stop = true;
+    }
+    state->condition.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.get_id() == std::this_thread::get_id()) {
+            // The last reference was dropped by a task on this very worker
+            worker.detach();
+        } else if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+// Process-wide registries. Intentionally leaked so they outlive every static
+// destructor that might still release a detector during process exit.
+static std::mutex& executorMutex() {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+}
+
+static std::weak_ptr<ThreadPool>& executorSlot() {
+    static std::weak_ptr<ThreadPool>* slot = new std::weak_ptr<ThreadPool>();
+    return *slot;
+}
+
+std::shared_ptr<ThreadPool> acquireExecutor() {
+    std::lock_guard<std::mutex> lock(executorMutex());
+    std::shared_ptr<ThreadPool> pool = executorSlot().lock();
+    if (!pool) {
+        pool = std::make_shared<ThreadPool>(0);
+        executorSlot() = pool;
+        std::cout << "Initialized thread pool with " << pool->size() << " threads" << std::endl;
+    }
+    return pool;
+}
+
+#ifdef _WIN32
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // The mapping keeps the file open
+    if (!mapping) return nullptr;
+    void* address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!address) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(address, static_cast<size_t>(size.QuadPart), mapping));
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(address);
+    CloseHandle(static_cast<HANDLE>(mapping));
+}
+#else
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+    if (address == MAP_FAILED) return nullptr;
+    // The parser and the hash both stream through the file once
+    madvise(address, length, MADV_SEQUENTIAL);
+    return std::shared_ptr<MappedFile>(new MappedFile(address, length, nullptr));
+}
+
+MappedFile::~MappedFile() {
+    munmap(address, length);
+}
+#endif
+
+static cv::dnn::Net parseNet(const MappedFile& file) {
+    cv::dnn::Net net = cv::dnn::readNetFromONNX(file.data(), file.size());
+    if (!net.empty()) {
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    }
+    return net;
+}
+
+static uint32_t fnv1a(const MappedFile& file) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(file.data());
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < file.size(); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Weights and constants the parser copied out of the file
+static size_t netWeightBytes(const cv::dnn::Net& net) {
+    size_t bytes = 0;
+    for (const std::string& name : net.getLayerNames()) {
+        cv::Ptr<cv::dnn::Layer> layer = net.getLayer(net.getLayerId(name));
+        if (!layer) continue;
+        for (const cv::Mat& blob : layer->blobs) {
+            bytes += blob.total() * blob.elemSize();
+        }
+    }
+    return bytes;
+}
+
+size_t netReplicaLimit() {
+    static const size_t limit = [] {
+        size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        const char* requested = std::getenv("FACE_DETECTOR_NET_REPLICAS");
+        long replicas = requested ? std::strtol(requested, nullptr, 10) : 2;
+        return std::min(hardware, static_cast<size_t>(std::max(1L, replicas)));
+    }();
+    return limit;
+}
+
+SharedNet::SharedNet(std::string path, size_t bytes, uint32_t contentHash, cv::dnn::Net first, double loadMs)
+    : modelPath(std::move(path)), fileBytes(bytes), weightBytes(netWeightBytes(first)), hash(contentHash),
+      firstLoadMs(loadMs), maxReplicas(netReplicaLimit()), created(1) {
+    idle.push_back(std::move(first));
+}
+
+cv::dnn::Net SharedNet::parseReplica() const {
+    std::shared_ptr<MappedFile> file = MappedFile::open(modelPath);
+    if (!file || file->size() != fileBytes) {
+        return cv::dnn::Net();
+    }
+    std::future<uint32_t> contentHash = std::async(std::launch::async, [file] { return fnv1a(*file); });
+    cv::dnn::Net net = parseNet(*file);
+    if (contentHash.get() != hash) {
+        return cv::dnn::Net(); // Replaced on disk: replicas must all run the version the embeddings are tagged with
+    }
+    return net;
+}
+
+SharedNet::Lease SharedNet::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        if (!idle.empty()) {
+            cv::dnn::Net net = std::move(idle.back());
+            idle.pop_back();
+            return Lease(this, std::move(net));
+        }
+        if (created < maxReplicas) {
+            created++;
+            lock.unlock();
+            cv::dnn::Net net;
+            try {
+                net = parseReplica();
+            } catch (...) {
+                lock.lock();
+                created--;
+                available.notify_one();
+                throw;
+            }
+            if (!net.empty()) {
+                return Lease(this, std::move(net));
+            }
+            // The file is gone or changed: stay at the replicas already parsed
+            lock.lock();
+            created--;
+            maxReplicas = created;
+            continue;
+        }
+        available.wait(lock);
+    }
+}
+
+void SharedNet::release(cv::dnn::Net net) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(net));
+    }
+    available.notify_one();
+}
+
+size_t SharedNet::replicaCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return created;
+}
+
+size_t SharedNet::replicaLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxReplicas;
+}
+
+static std::mutex& modelsMutex() {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+}
+
+static std::map<std::string, std::weak_ptr<SharedNet>>& modelSlots() {
+    static auto* slots = new std::map<std::string, std::weak_ptr<SharedNet>>();
+    return *slots;
+}
+
+std::shared_ptr<SharedNet> acquireSharedNet(const std::string& path, bool* reused) {
+    if (reused) *reused = false;
+    {
+        std::lock_guard<std::mutex> lock(modelsMutex());
+        if (std::shared_ptr<SharedNet> existing = modelSlots()[path].lock()) {
+            if (reused) *reused = true;
+            return existing;
+        }
+    }
+
+    // Parse outside the lock so different models can load concurrently
+    auto startTime = std::chrono::steady_clock::now();
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) {
+        return nullptr;
+    }
+    // The version hash reads the same pages as the parser; run it alongside instead of after
+    std::future<uint32_t> hash = std::async(std::launch::async, [file] { return fnv1a(*file); });
+    cv::dnn::Net first = parseNet(*file);
+    uint32_t contentHash = hash.get();
+    if (first.empty()) {
+        return nullptr;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    size_t fileBytes = file->size();
+    file.reset(); // The weights now live in the parsed net; drop the mapping instead of keeping the file resident
+    auto loaded = std::make_shared<SharedNet>(path, fileBytes, contentHash, std::move(first), loadMs);
+
+    std::lock_guard<std::mutex> lock(modelsMutex());
+    std::weak_ptr<SharedNet>& slot = modelSlots()[path];
+    if (std::shared_ptr<SharedNet> raced = slot.lock()) {
+        if (reused) *reused = true;
+        return raced; // Another isolate finished loading the same file first
+    }
+    slot = loaded;
+    return loaded;
+}
+
+SharedRuntimeStats sharedRuntimeStats() {
+    SharedRuntimeStats stats;
+    stats.netReplicaLimit = netReplicaLimit();
+    {
+        std::lock_guard<std::mutex> lock(modelsMutex());
+        auto& slots = modelSlots();
+        for (auto it = slots.begin(); it != slots.end();) {
+            if (std::shared_ptr<SharedNet> model = it->second.lock()) {
+                stats.sharedModels++;
+                size_t replicas = model->replicaCount();
+                stats.netReplicas += replicas;
+                stats.modelBytes += model->sizeBytes();
+                stats.replicaBytes += model->replicaBytes();
+                stats.heapBytes += replicas * model->replicaBytes();
+                ++it;
+            } else {
+                it = slots.erase(it);
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(executorMutex());
+        std::weak_ptr<ThreadPool>& slot = executorSlot();
+        if (std::shared_ptr<ThreadPool> pool = slot.lock()) {
+            stats.executorThreads = pool->size();
+            stats.executorUsers = slot.use_count() - 1; // Minus the reference taken here
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,187 @@
+#ifndef SHARED_RUNTIME_H
+#define SHARED_RUNTIME_H
+
+#include <opencv2/dnn.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Process-global state shared by every FaceDetector, whichever Node isolate
+ * (main thread or worker_threads) or native caller created it: one executor
+ * and one copy of each model file. Both are reference counted, so they live
+ * exactly as long as some detector uses them and are torn down by the last
+ * release.
+ */
+
+// Thread Pool Implementation
+class ThreadPool {
+public:
+    ThreadPool(size_t numThreads);
+    // Joins the workers; safe to run on one of them (that worker is detached instead)
+    ~ThreadPool();
+
+    template<typename F, typename... Args>
+    auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    size_t size() const { return workers.size(); }
+
+private:
+    // Owned jointly with the workers, so a detached worker can still drain and exit
+    struct State {
+        std::queue<std::function<void()>> tasks;
+        std::mutex queueMutex;
+        std::condition_variable condition;
+        bool stop = false;
+    };
+
+    std::shared_ptr<State> state;
+    std::vector<std::thread> workers;
+};
+
+template<typename F, typename... Args>
+auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type> {
+    using return_type = typename std::result_of<F(Args...)>::type;
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+    );
+    std::future<return_type> res = task->get_future();
+    {
+        std::unique_lock<std::mutex> lock(state->queueMutex);
+        if (state->stop) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        state->tasks.emplace([task]() { (*task)(); });
+    }
+    state->condition.notify_one();
+    return res;
+}
+
+/**
+ * @brief Returns the process-wide executor, creating it on first use.
+ * The pool is destroyed when the last holder releases it.
+ */
+std::shared_ptr<ThreadPool> acquireExecutor();
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * Pages are faulted in by the parser as it reads them, so opening a model costs
+ * one open/mmap instead of a buffered copy. The parser copies the weights onto
+ * the heap, so a mapping is only needed while a replica is being parsed.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps `path` read-only.
+     * @return nullptr if the file does not exist, is empty or cannot be mapped.
+     */
+    static std::shared_ptr<MappedFile> open(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(address); }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(void* address, size_t length, void* mapping) : address(address), length(length), mapping(mapping) {}
+
+    void* address;
+    size_t length;
+    void* mapping; // File mapping handle on Windows, unused elsewhere
+};
+
+/**
+ * @brief One model file shared by all detectors in the process.
+ *
+ * cv::dnn::Net is not safe for concurrent forward passes, so the model keeps a
+ * small pool of replicas. Each replica holds its own heap copy of the weights
+ * (replicaBytes()), so one is created only when every existing one is busy, up
+ * to netReplicaLimit(); callers beyond that wait for a free one. The file is
+ * mapped again to parse each extra replica and unmapped once it is parsed; a
+ * replica is not added if the file has changed since the first was loaded.
+ */
+class SharedNet {
+public:
+    // Exclusive use of one replica for the lifetime of the lease
+    class Lease {
+    public:
+        Lease(SharedNet* owner, cv::dnn::Net net) : owner(owner), leased(std::move(net)) {}
+        Lease(Lease&& other) noexcept : owner(other.owner), leased(std::move(other.leased)) { other.owner = nullptr; }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { if (owner) owner->release(std::move(leased)); }
+
+        cv::dnn::Net& net() { return leased; }
+
+    private:
+        SharedNet* owner;
+        cv::dnn::Net leased;
+    };
+
+    SharedNet(std::string path, size_t fileBytes, uint32_t hash, cv::dnn::Net first, double loadMs);
+
+    Lease acquire();
+
+    const std::string& path() const { return modelPath; }
+    uint32_t contentHash() const { return hash; }
+    size_t sizeBytes() const { return fileBytes; }
+    // Heap held by the weights of one parsed replica
+    size_t replicaBytes() const { return weightBytes; }
+    size_t replicaCount() const;
+    size_t replicaLimit() const;
+    // Time to map, hash and parse the first replica when the model was first loaded
+    double loadMs() const { return firstLoadMs; }
+
+private:
+    void release(cv::dnn::Net net);
+    cv::dnn::Net parseReplica() const;
+
+    std::string modelPath;
+    size_t fileBytes;
+    size_t weightBytes;
+    uint32_t hash;
+    double firstLoadMs;
+    size_t maxReplicas;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<cv::dnn::Net> idle;
+    size_t created;
+};
+
+/**
+ * @brief Loads an ONNX model, or returns the copy another detector already loaded.
+ * @param reused Set to true when the model was already loaded in this process.
+ * @return nullptr if the file is missing or cannot be parsed.
+ */
+std::shared_ptr<SharedNet> acquireSharedNet(const std::string& path, bool* reused = nullptr);
+
+/**
+ * @brief Replicas each model may grow to: FACE_DETECTOR_NET_REPLICAS (default 2),
+ * at most one per hardware thread.
+ */
+size_t netReplicaLimit();
+
+struct SharedRuntimeStats {
+    size_t sharedModels = 0;
+    size_t netReplicas = 0;
+    size_t netReplicaLimit = 0;
+    size_t modelBytes = 0;
+    size_t replicaBytes = 0; // Heap of one replica of every model
+    size_t heapBytes = 0;    // Heap of all replicas
+    size_t executorThreads = 0;
+    long executorUsers = 0;
+};
+
+SharedRuntimeStats sharedRuntimeStats();
+
+#endif // SHARED_RUNTIME_H
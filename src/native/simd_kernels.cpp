@@ -0,0 +1,169 @@
+#include "simd_kernels_impl.h"
+#include <cstdlib>
+#include <iostream>
+
+namespace simd {
+namespace scalar {
+
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2) {
+    const int first = swapRB ? 2 : 0;
+    const int last = swapRB ? 0 : 2;
+    for (int x = 0; x < width; x++) {
+        d0[x] = (static_cast<float>(src[3 * x + first]) - mean) * scale;
+        d1[x] = (static_cast<float>(src[3 * x + 1]) - mean) * scale;
+        d2[x] = (static_cast<float>(src[3 * x + last]) - mean) * scale;
+    }
+}
+
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices) {
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        if (scores[i * stride + offset] > threshold) {
+            indices[found++] = i;
+        }
+    }
+    return found;
+}
+
+float dot(const float* a, const float* b, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = dot(query, rows + r * dim, dim);
+    }
+}
+
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride) {
+    for (size_t q = 0; q < queryCount; q++) {
+        dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+    }
+}
+
+void integral(const uint8_t* src, size_t srcStride, int width, int height, uint32_t* sum, size_t sumStride) {
+    for (int x = 0; x <= width; x++) {
+        sum[x] = 0;
+    }
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + y * srcStride;
+        const uint32_t* prev = sum + y * sumStride;
+        uint32_t* cur = sum + (y + 1) * sumStride;
+        uint32_t rowSum = 0;
+        cur[0] = 0;
+        for (int x = 0; x < width; x++) {
+            rowSum += row[x];
+            cur[x + 1] = prev[x + 1] + rowSum;
+        }
+    }
+}
+
+void halveRow(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst) {
+    const int step = 2 * channels;
+    for (int x = 0; x < dstWidth; x++) {
+        const uint8_t* a = row0 + x * step;
+        const uint8_t* b = row1 + x * step;
+        for (int c = 0; c < channels; c++) {
+            dst[x * channels + c] = static_cast<uint8_t>((a[c] + a[c + channels] + b[c] + b[c + channels] + 2) >> 2);
+        }
+    }
+}
+
+// Bit count without the POPCNT instruction, which the scalar baseline cannot assume
+static inline uint32_t popcount64(uint64_t v) {
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((v * 0x0101010101010101ULL) >> 56);
+}
+
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        uint32_t distance = 0;
+        for (size_t w = 0; w < words; w++) {
+            distance += popcount64(query[w] ^ row[w]);
+        }
+        out[r] = distance;
+    }
+}
+
+} // namespace scalar
+
+static const Kernels scalarTable = {
+    CpuIsa::Scalar,
+    scalar::packBgrRow,
+    scalar::scoresAbove,
+    scalar::dot,
+    scalar::dotRows,
+    scalar::dotRowsBatch,
+    scalar::integral,
+    scalar::halveRow,
+    scalar::hammingRows
+};
+
+static bool cpuSupports(CpuIsa isa) {
+    const CpuFeatures& features = cpuFeatures();
+    switch (isa) {
+        case CpuIsa::Scalar: return true;
+        case CpuIsa::SSE42: return features.sse42 && features.popcnt;
+        case CpuIsa::AVX2: return features.avx2 && features.fma;
+        case CpuIsa::AVX512: return features.avx512f && features.avx512bw && features.avx512vl;
+        case CpuIsa::NEON: return features.neon;
+    }
+    return false;
+}
+
+static const Kernels* compiledTable(CpuIsa isa) {
+    switch (isa) {
+        case CpuIsa::Scalar: return &scalarTable;
+        case CpuIsa::SSE42: return sse42Kernels();
+        case CpuIsa::AVX2: return avx2Kernels();
+        case CpuIsa::AVX512: return avx512Kernels();
+        case CpuIsa::NEON: return neonKernels();
+    }
+    return nullptr;
+}
+
+const Kernels* kernelsFor(CpuIsa isa) {
+    return cpuSupports(isa) ? compiledTable(isa) : nullptr;
+}
+
+std::vector<CpuIsa> compiledIsas() {
+    std::vector<CpuIsa> isas;
+    for (int i = static_cast<int>(CpuIsa::Scalar); i <= static_cast<int>(CpuIsa::NEON); i++) {
+        if (compiledTable(static_cast<CpuIsa>(i))) {
+            isas.push_back(static_cast<CpuIsa>(i));
+        }
+    }
+    return isas;
+}
+
+static const Kernels& selectKernels() {
+    // Optional cap, e.g. FACE_DETECTOR_ISA=sse4.2 to benchmark an older code path
+    const char* requested = std::getenv("FACE_DETECTOR_ISA");
+    int cap = requested ? static_cast<int>(cpuIsaFromName(requested)) : static_cast<int>(CpuIsa::NEON);
+
+    static const CpuIsa preference[] = { CpuIsa::AVX512, CpuIsa::AVX2, CpuIsa::SSE42, CpuIsa::NEON };
+    for (CpuIsa isa : preference) {
+        if (static_cast<int>(isa) > cap) continue;
+        if (const Kernels* table = kernelsFor(isa)) {
+            std::cout << "Native kernels using " << cpuIsaName(isa) << std::endl;
+            return *table;
+        }
+    }
+    std::cout << "Native kernels using scalar code" << std::endl;
+    return scalarTable;
+}
+
+const Kernels& kernels() {
+    static const Kernels& selected = selectKernels();
+    return selected;
+}
+
+} // namespace simd
@@ -0,0 +1,66 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cpu_features.h"
+
+namespace simd {
+
+/**
+ * @brief Hot native kernels, one table per instruction set.
+ *
+ * Each ISA variant lives in its own translation unit built with that ISA's
+ * compiler flags (see binding.gyp); the table for the best ISA the running CPU
+ * supports is picked once, the first time kernels() is called. Setting
+ * FACE_DETECTOR_ISA (e.g. "sse4.2") caps the selection, which is useful for
+ * comparing variants on one host.
+ */
+struct Kernels {
+    CpuIsa isa;
+
+    // Preprocessing: one row of interleaved BGR pixels to three planes of (value - mean) * scale.
+    // With swapRB the planes are R,G,B instead of B,G,R.
+    void (*packBgrRow)(const uint8_t* src, int width, float mean, float scale, bool swapRB,
+                       float* d0, float* d1, float* d2);
+
+    // Post-processing: writes the indices of the `count` records (each `stride` floats wide) whose
+    // value at `offset` is above `threshold`, in ascending order. Returns the number written.
+    int (*scoresAbove)(const float* scores, int count, int stride, int offset, float threshold, int* indices);
+
+    // Matcher: dot product of two vectors
+    float (*dot)(const float* a, const float* b, size_t dim);
+
+    // Matcher: dot products of one query against `count` contiguous rows of `dim` floats
+    void (*dotRows)(const float* query, const float* rows, size_t count, size_t dim, float* out);
+
+    // Matcher, batched: out[q * outStride + r] = dot(query q, row r), a GEMM tile over `queryCount` queries and
+    // `rowCount` rows, both contiguous and `dim` floats wide. Callers block rows so the tile stays in cache.
+    void (*dotRowsBatch)(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                         float* out, size_t outStride);
+
+    // Integral image of an 8-bit plane into a (width+1) x (height+1) table whose first row and column are zero.
+    // `sumStride` is in elements.
+    void (*integral)(const uint8_t* src, size_t srcStride, int width, int height, uint32_t* sum, size_t sumStride);
+
+    // Frame pyramid: one row of a 2x2 area downsample. Each of the `dstWidth` output pixels is the rounded mean of a
+    // 2x2 block of interleaved `channels`-byte pixels from the source rows `row0` and `row1`.
+    void (*halveRow)(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst);
+
+    // Gallery prefilter: Hamming distances of one binary code against `count` contiguous codes of `words` 64-bit words
+    void (*hammingRows)(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out);
+};
+
+// Table selected for this process
+const Kernels& kernels();
+
+// Table for a specific ISA, or nullptr if it was not compiled in or the CPU lacks it
+const Kernels* kernelsFor(CpuIsa isa);
+
+// ISAs compiled into this build, whether or not the CPU supports them
+std::vector<CpuIsa> compiledIsas();
+
+} // namespace simd
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,274 @@
+// Built with -mavx2 -mfma (see binding.gyp); only called after cpuFeatures() confirms support.
+#include "simd_kernels_impl.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace simd {
+namespace avx2 {
+
+// Picks byte 3*i + channel of each 16-byte lane into the low byte of 32-bit element i of that lane
+static inline __m256i channelMask(int channel) {
+    const __m128i lane = _mm_setr_epi8(
+        static_cast<char>(channel), -1, -1, -1,
+        static_cast<char>(channel + 3), -1, -1, -1,
+        static_cast<char>(channel + 6), -1, -1, -1,
+        static_cast<char>(channel + 9), -1, -1, -1);
+    return _mm256_broadcastsi128_si256(lane);
+}
+
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2) {
+    const __m256i mask0 = channelMask(swapRB ? 2 : 0);
+    const __m256i mask1 = channelMask(1);
+    const __m256i mask2 = channelMask(swapRB ? 0 : 2);
+    const __m256 vmean = _mm256_set1_ps(mean);
+    const __m256 vscale = _mm256_set1_ps(scale);
+
+    int x = 0;
+    // Pixels 0-3 and 4-7 go into the two 128-bit lanes; the second load ends 4 bytes past pixel 7
+    for (; x + 10 <= width; x += 8) {
+        const uint8_t* p = src + 3 * x;
+        __m256i pixels = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        __m256 c0 = _mm256_cvtepi32_ps(_mm256_shuffle_epi8(pixels, mask0));
+        __m256 c1 = _mm256_cvtepi32_ps(_mm256_shuffle_epi8(pixels, mask1));
+        __m256 c2 = _mm256_cvtepi32_ps(_mm256_shuffle_epi8(pixels, mask2));
+        _mm256_storeu_ps(d0 + x, _mm256_mul_ps(_mm256_sub_ps(c0, vmean), vscale));
+        _mm256_storeu_ps(d1 + x, _mm256_mul_ps(_mm256_sub_ps(c1, vmean), vscale));
+        _mm256_storeu_ps(d2 + x, _mm256_mul_ps(_mm256_sub_ps(c2, vmean), vscale));
+    }
+    if (x < width) {
+        scalar::packBgrRow(src + 3 * x, width - x, mean, scale, swapRB, d0 + x, d1 + x, d2 + x);
+    }
+}
+
+static inline int appendIndices(int mask, int base, int* indices, int found) {
+    uint32_t bits = static_cast<uint32_t>(mask);
+    while (bits) {
+        indices[found++] = base + lowestBit(bits);
+        bits &= bits - 1;
+    }
+    return found;
+}
+
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices) {
+    if (stride > 2 || offset >= stride) {
+        return scalar::scoresAbove(scores, count, stride, offset, threshold, indices);
+    }
+
+    const __m256 vthreshold = _mm256_set1_ps(threshold);
+    int found = 0;
+    int i = 0;
+    if (stride == 1) {
+        for (; i + 8 <= count; i += 8) {
+            __m256 v = _mm256_loadu_ps(scores + i);
+            found = appendIndices(_mm256_movemask_ps(_mm256_cmp_ps(v, vthreshold, _CMP_GT_OQ)), i, indices, found);
+        }
+    } else {
+        for (; i + 8 <= count; i += 8) {
+            __m256 a = _mm256_loadu_ps(scores + 2 * i);
+            __m256 b = _mm256_loadu_ps(scores + 2 * i + 8);
+            // In-lane shuffle yields records 0,1,4,5 | 2,3,6,7; the 64-bit permute restores order
+            __m256 v = offset == 0 ? _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))
+                                   : _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3, 1, 2, 0)));
+            found = appendIndices(_mm256_movemask_ps(_mm256_cmp_ps(v, vthreshold, _CMP_GT_OQ)), i, indices, found);
+        }
+    }
+    for (; i < count; i++) {
+        if (scores[i * stride + offset] > threshold) {
+            indices[found++] = i;
+        }
+    }
+    return found;
+}
+
+static inline float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+float dot(const float* a, const float* b, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= dim; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float sum = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    size_t r = 0;
+    // Four rows per pass so each query load is reused
+    for (; r + 4 <= count && dim >= 8; r += 4) {
+        const float* r0 = rows + r * dim;
+        const float* r1 = r0 + dim;
+        const float* r2 = r1 + dim;
+        const float* r3 = r2 + dim;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= dim; i += 8) {
+            __m256 q = _mm256_loadu_ps(query + i);
+            acc0 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r0 + i), acc0);
+            acc1 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r1 + i), acc1);
+            acc2 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r2 + i), acc2);
+            acc3 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r3 + i), acc3);
+        }
+        float s0 = horizontalSum(acc0);
+        float s1 = horizontalSum(acc1);
+        float s2 = horizontalSum(acc2);
+        float s3 = horizontalSum(acc3);
+        for (; i < dim; i++) {
+            s0 += query[i] * r0[i];
+            s1 += query[i] * r1[i];
+            s2 += query[i] * r2[i];
+            s3 += query[i] * r3[i];
+        }
+        out[r] = s0;
+        out[r + 1] = s1;
+        out[r + 2] = s2;
+        out[r + 3] = s3;
+    }
+    for (; r < count; r++) {
+        out[r] = dot(query, rows + r * dim, dim);
+    }
+}
+
+// Bit counts of the 32 bytes of v, summed into its four 64-bit lanes (nibble lookup, no POPCNT needed)
+static inline __m256i popcountLanes(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+                                     _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    if (words % 4 != 0) {
+        scalar::hammingRows(query, rows, count, words, out);
+        return;
+    }
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t w = 0; w < words; w += 4) {
+            __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + w));
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+            acc = _mm256_add_epi64(acc, popcountLanes(_mm256_xor_si256(q, v)));
+        }
+        __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        out[r] = static_cast<uint32_t>(_mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 2));
+    }
+}
+
+// 4 queries x 2 rows per tile: 8 accumulators plus 6 loads fit the 16 ymm registers
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride) {
+    if (dim % 8 != 0) {
+        for (size_t q = 0; q < queryCount; q++) {
+            dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+        }
+        return;
+    }
+    size_t q = 0;
+    for (; q + 4 <= queryCount; q += 4) {
+        const float* q0 = queries + q * dim;
+        const float* q1 = q0 + dim;
+        const float* q2 = q1 + dim;
+        const float* q3 = q2 + dim;
+        float* o0 = out + q * outStride;
+        size_t r = 0;
+        for (; r + 2 <= rowCount; r += 2) {
+            const float* r0 = rows + r * dim;
+            const float* r1 = r0 + dim;
+            __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps();
+            __m256 a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+            __m256 a20 = _mm256_setzero_ps(), a21 = _mm256_setzero_ps();
+            __m256 a30 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+            for (size_t i = 0; i < dim; i += 8) {
+                __m256 v0 = _mm256_loadu_ps(r0 + i);
+                __m256 v1 = _mm256_loadu_ps(r1 + i);
+                __m256 x = _mm256_loadu_ps(q0 + i);
+                a00 = _mm256_fmadd_ps(x, v0, a00);
+                a01 = _mm256_fmadd_ps(x, v1, a01);
+                x = _mm256_loadu_ps(q1 + i);
+                a10 = _mm256_fmadd_ps(x, v0, a10);
+                a11 = _mm256_fmadd_ps(x, v1, a11);
+                x = _mm256_loadu_ps(q2 + i);
+                a20 = _mm256_fmadd_ps(x, v0, a20);
+                a21 = _mm256_fmadd_ps(x, v1, a21);
+                x = _mm256_loadu_ps(q3 + i);
+                a30 = _mm256_fmadd_ps(x, v0, a30);
+                a31 = _mm256_fmadd_ps(x, v1, a31);
+            }
+            o0[r] = horizontalSum(a00);
+            o0[r + 1] = horizontalSum(a01);
+            o0[outStride + r] = horizontalSum(a10);
+            o0[outStride + r + 1] = horizontalSum(a11);
+            o0[2 * outStride + r] = horizontalSum(a20);
+            o0[2 * outStride + r + 1] = horizontalSum(a21);
+            o0[3 * outStride + r] = horizontalSum(a30);
+            o0[3 * outStride + r + 1] = horizontalSum(a31);
+        }
+        for (; r < rowCount; r++) {
+            const float* row = rows + r * dim;
+            o0[r] = dot(q0, row, dim);
+            o0[outStride + r] = dot(q1, row, dim);
+            o0[2 * outStride + r] = dot(q2, row, dim);
+            o0[3 * outStride + r] = dot(q3, row, dim);
+        }
+    }
+    for (; q < queryCount; q++) {
+        dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+    }
+}
+
+} // namespace avx2
+
+static const Kernels table = {
+    CpuIsa::AVX2,
+    avx2::packBgrRow,
+    avx2::scoresAbove,
+    avx2::dot,
+    avx2::dotRows,
+    avx2::dotRowsBatch,
+    sse42::integral,
+    sse42::halveRow,
+    avx2::hammingRows
+};
+
+const Kernels* avx2Kernels() {
+    return &table;
+}
+
+} // namespace simd
+
+#else
+
+namespace simd {
+const Kernels* avx2Kernels() {
+    return nullptr;
+}
+} // namespace simd
+
+#endif
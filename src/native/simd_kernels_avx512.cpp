@@ -0,0 +1,274 @@
+// Built with -mavx512f -mavx512bw -mavx512vl (see binding.gyp); only called after cpuFeatures() confirms support.
+// VPOPCNTDQ is enabled for one function only, and only called when the CPU has it.
+#include "simd_kernels_impl.h"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define FD_TARGET_VPOPCNTDQ __attribute__((target("avx512vpopcntdq")))
+#else
+#define FD_TARGET_VPOPCNTDQ
+#endif
+
+namespace simd {
+namespace avx512 {
+
+// Picks byte 3*i + channel of each 16-byte lane into the low byte of 32-bit element i of that lane
+static inline __m512i channelMask(int channel) {
+    const __m128i lane = _mm_setr_epi8(
+        static_cast<char>(channel), -1, -1, -1,
+        static_cast<char>(channel + 3), -1, -1, -1,
+        static_cast<char>(channel + 6), -1, -1, -1,
+        static_cast<char>(channel + 9), -1, -1, -1);
+    return _mm512_broadcast_i32x4(lane);
+}
+
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2) {
+    const __m512i mask0 = channelMask(swapRB ? 2 : 0);
+    const __m512i mask1 = channelMask(1);
+    const __m512i mask2 = channelMask(swapRB ? 0 : 2);
+    const __m512 vmean = _mm512_set1_ps(mean);
+    const __m512 vscale = _mm512_set1_ps(scale);
+
+    int x = 0;
+    // Four groups of 4 pixels, one per 128-bit lane; the last load ends 4 bytes past pixel 15
+    for (; x + 18 <= width; x += 16) {
+        const uint8_t* p = src + 3 * x;
+        __m512i pixels = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 24)), 2);
+        pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 36)), 3);
+        __m512 c0 = _mm512_cvtepi32_ps(_mm512_shuffle_epi8(pixels, mask0));
+        __m512 c1 = _mm512_cvtepi32_ps(_mm512_shuffle_epi8(pixels, mask1));
+        __m512 c2 = _mm512_cvtepi32_ps(_mm512_shuffle_epi8(pixels, mask2));
+        _mm512_storeu_ps(d0 + x, _mm512_mul_ps(_mm512_sub_ps(c0, vmean), vscale));
+        _mm512_storeu_ps(d1 + x, _mm512_mul_ps(_mm512_sub_ps(c1, vmean), vscale));
+        _mm512_storeu_ps(d2 + x, _mm512_mul_ps(_mm512_sub_ps(c2, vmean), vscale));
+    }
+    if (x < width) {
+        scalar::packBgrRow(src + 3 * x, width - x, mean, scale, swapRB, d0 + x, d1 + x, d2 + x);
+    }
+}
+
+static inline int appendIndices(__mmask16 mask, int base, int* indices, int found) {
+    uint32_t bits = static_cast<uint32_t>(mask);
+    while (bits) {
+        indices[found++] = base + lowestBit(bits);
+        bits &= bits - 1;
+    }
+    return found;
+}
+
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices) {
+    if (stride > 2 || offset >= stride) {
+        return scalar::scoresAbove(scores, count, stride, offset, threshold, indices);
+    }
+
+    const __m512 vthreshold = _mm512_set1_ps(threshold);
+    int found = 0;
+    int i = 0;
+    if (stride == 1) {
+        for (; i + 16 <= count; i += 16) {
+            __m512 v = _mm512_loadu_ps(scores + i);
+            found = appendIndices(_mm512_cmp_ps_mask(v, vthreshold, _CMP_GT_OQ), i, indices, found);
+        }
+    } else {
+        // Element `offset` of each of the 16 two-float records spread over a and b
+        const __m512i gather = _mm512_add_epi32(
+            _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30),
+            _mm512_set1_epi32(offset));
+        for (; i + 16 <= count; i += 16) {
+            __m512 a = _mm512_loadu_ps(scores + 2 * i);
+            __m512 b = _mm512_loadu_ps(scores + 2 * i + 16);
+            __m512 v = _mm512_permutex2var_ps(a, gather, b);
+            found = appendIndices(_mm512_cmp_ps_mask(v, vthreshold, _CMP_GT_OQ), i, indices, found);
+        }
+    }
+    for (; i < count; i++) {
+        if (scores[i * stride + offset] > threshold) {
+            indices[found++] = i;
+        }
+    }
+    return found;
+}
+
+float dot(const float* a, const float* b, size_t dim) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    if (i < dim) {
+        // Masked tail load keeps the remainder in the vector path
+        size_t remaining = dim - i;
+        if (remaining >= 16) {
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+            i += 16;
+            remaining -= 16;
+        }
+        if (remaining > 0) {
+            __mmask16 tail = static_cast<__mmask16>((1u << remaining) - 1);
+            acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a + i), _mm512_maskz_loadu_ps(tail, b + i), acc1);
+        }
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    size_t r = 0;
+    // Four rows per pass so each query load is reused
+    for (; r + 4 <= count && dim % 16 == 0; r += 4) {
+        const float* r0 = rows + r * dim;
+        const float* r1 = r0 + dim;
+        const float* r2 = r1 + dim;
+        const float* r3 = r2 + dim;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        for (size_t i = 0; i < dim; i += 16) {
+            __m512 q = _mm512_loadu_ps(query + i);
+            acc0 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r0 + i), acc0);
+            acc1 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r1 + i), acc1);
+            acc2 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r2 + i), acc2);
+            acc3 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r3 + i), acc3);
+        }
+        out[r] = _mm512_reduce_add_ps(acc0);
+        out[r + 1] = _mm512_reduce_add_ps(acc1);
+        out[r + 2] = _mm512_reduce_add_ps(acc2);
+        out[r + 3] = _mm512_reduce_add_ps(acc3);
+    }
+    for (; r < count; r++) {
+        out[r] = dot(query, rows + r * dim, dim);
+    }
+}
+
+// 4 queries x 4 rows per tile: 16 accumulators, with the 32 zmm registers to spare for loads
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride) {
+    if (dim % 16 != 0) {
+        for (size_t q = 0; q < queryCount; q++) {
+            dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+        }
+        return;
+    }
+    size_t q = 0;
+    for (; q + 4 <= queryCount; q += 4) {
+        const float* qs[4] = { queries + q * dim, queries + (q + 1) * dim, queries + (q + 2) * dim, queries + (q + 3) * dim };
+        float* o = out + q * outStride;
+        size_t r = 0;
+        for (; r + 4 <= rowCount; r += 4) {
+            const float* r0 = rows + r * dim;
+            const float* r1 = r0 + dim;
+            const float* r2 = r1 + dim;
+            const float* r3 = r2 + dim;
+            __m512 acc[4][4];
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    acc[a][b] = _mm512_setzero_ps();
+                }
+            }
+            for (size_t i = 0; i < dim; i += 16) {
+                __m512 v0 = _mm512_loadu_ps(r0 + i);
+                __m512 v1 = _mm512_loadu_ps(r1 + i);
+                __m512 v2 = _mm512_loadu_ps(r2 + i);
+                __m512 v3 = _mm512_loadu_ps(r3 + i);
+                for (int a = 0; a < 4; a++) {
+                    __m512 x = _mm512_loadu_ps(qs[a] + i);
+                    acc[a][0] = _mm512_fmadd_ps(x, v0, acc[a][0]);
+                    acc[a][1] = _mm512_fmadd_ps(x, v1, acc[a][1]);
+                    acc[a][2] = _mm512_fmadd_ps(x, v2, acc[a][2]);
+                    acc[a][3] = _mm512_fmadd_ps(x, v3, acc[a][3]);
+                }
+            }
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    o[a * outStride + r + b] = _mm512_reduce_add_ps(acc[a][b]);
+                }
+            }
+        }
+        for (; r < rowCount; r++) {
+            for (int a = 0; a < 4; a++) {
+                o[a * outStride + r] = dot(qs[a], rows + r * dim, dim);
+            }
+        }
+    }
+    for (; q < queryCount; q++) {
+        dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+    }
+}
+
+// Bit counts of the 64 bytes of v, summed into its eight 64-bit lanes (nibble lookup)
+static inline __m512i popcountLanes(__m512i v) {
+    const __m512i lookup = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+    const __m512i low = _mm512_set1_epi8(0x0f);
+    __m512i counts = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, _mm512_and_si512(v, low)),
+                                     _mm512_shuffle_epi8(lookup, _mm512_and_si512(_mm512_srli_epi16(v, 4), low)));
+    return _mm512_sad_epu8(counts, _mm512_setzero_si512());
+}
+
+// Ice Lake and later count 64-bit lanes directly
+FD_TARGET_VPOPCNTDQ
+static void hammingRowsVpopcnt(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        __m512i acc = _mm512_setzero_si512();
+        for (size_t w = 0; w < words; w += 8) {
+            __mmask8 mask = words - w >= 8 ? 0xff : static_cast<__mmask8>((1u << (words - w)) - 1);
+            __m512i bits = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, query + w), _mm512_maskz_loadu_epi64(mask, row + w));
+            acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(bits));
+        }
+        out[r] = static_cast<uint32_t>(_mm512_reduce_add_epi64(acc));
+    }
+}
+
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    static const bool vpopcntdq = cpuFeatures().avx512vpopcntdq;
+    if (vpopcntdq) {
+        hammingRowsVpopcnt(query, rows, count, words, out);
+        return;
+    }
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        __m512i acc = _mm512_setzero_si512();
+        for (size_t w = 0; w < words; w += 8) {
+            __mmask8 mask = words - w >= 8 ? 0xff : static_cast<__mmask8>((1u << (words - w)) - 1);
+            __m512i bits = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, query + w), _mm512_maskz_loadu_epi64(mask, row + w));
+            acc = _mm512_add_epi64(acc, popcountLanes(bits));
+        }
+        out[r] = static_cast<uint32_t>(_mm512_reduce_add_epi64(acc));
+    }
+}
+
+} // namespace avx512
+
+static const Kernels table = {
+    CpuIsa::AVX512,
+    avx512::packBgrRow,
+    avx512::scoresAbove,
+    avx512::dot,
+    avx512::dotRows,
+    avx512::dotRowsBatch,
+    sse42::integral,
+    sse42::halveRow,
+    avx512::hammingRows
+};
+
+const Kernels* avx512Kernels() {
+    return &table;
+}
+
+} // namespace simd
+
+#else
+
+namespace simd {
+const Kernels* avx512Kernels() {
+    return nullptr;
+}
+} // namespace simd
+
+#endif
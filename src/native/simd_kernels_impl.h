@@ -0,0 +1,58 @@
+#ifndef SIMD_KERNELS_IMPL_H
+#define SIMD_KERNELS_IMPL_H
+
+// Internal to the simd_kernels*.cpp translation units.
+//
+// The ISA-specific files are compiled with flags such as -mavx2, so they must
+// only contain plain functions over raw pointers: any inline or template code
+// pulled in from shared headers could be emitted with those instructions and
+// then picked by the linker for callers running on older CPUs.
+
+#include "simd_kernels.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace simd {
+
+namespace scalar {
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2);
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices);
+float dot(const float* a, const float* b, size_t dim);
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out);
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride);
+void integral(const uint8_t* src, size_t srcStride, int width, int height, uint32_t* sum, size_t sumStride);
+void halveRow(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst);
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out);
+}
+
+// Shared by the wider x86 variants, which gain nothing on the serial row prefix or on a memory-bound downsample
+namespace sse42 {
+void integral(const uint8_t* src, size_t srcStride, int width, int height, uint32_t* sum, size_t sumStride);
+void halveRow(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst);
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out);
+}
+
+// Index of the lowest set bit; `mask` must be non-zero. Internal linkage keeps
+// each ISA translation unit's copy to itself.
+static inline int lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Each returns nullptr when the variant was not compiled for this target architecture
+const Kernels* sse42Kernels();
+const Kernels* avx2Kernels();
+const Kernels* avx512Kernels();
+const Kernels* neonKernels();
+
+} // namespace simd
+
+#endif // SIMD_KERNELS_IMPL_H
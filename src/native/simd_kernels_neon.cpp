@@ -0,0 +1,208 @@
+// NEON variant for ARM builds; only called after cpuFeatures() confirms support.
+#include "simd_kernels_impl.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+namespace simd {
+namespace neon {
+
+static inline float32x4_t normalize(uint32x4_t v, float32x4_t vmean, float32x4_t vscale) {
+    return vmulq_f32(vsubq_f32(vcvtq_f32_u32(v), vmean), vscale);
+}
+
+static inline void storeChannel(uint8x8_t channel, float32x4_t vmean, float32x4_t vscale, float* dst) {
+    uint16x8_t wide = vmovl_u8(channel);
+    vst1q_f32(dst, normalize(vmovl_u16(vget_low_u16(wide)), vmean, vscale));
+    vst1q_f32(dst + 4, normalize(vmovl_u16(vget_high_u16(wide)), vmean, vscale));
+}
+
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2) {
+    const float32x4_t vmean = vdupq_n_f32(mean);
+    const float32x4_t vscale = vdupq_n_f32(scale);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        // De-interleaving load: val[0]=B, val[1]=G, val[2]=R
+        uint8x8x3_t pixels = vld3_u8(src + 3 * x);
+        storeChannel(swapRB ? pixels.val[2] : pixels.val[0], vmean, vscale, d0 + x);
+        storeChannel(pixels.val[1], vmean, vscale, d1 + x);
+        storeChannel(swapRB ? pixels.val[0] : pixels.val[2], vmean, vscale, d2 + x);
+    }
+    if (x < width) {
+        scalar::packBgrRow(src + 3 * x, width - x, mean, scale, swapRB, d0 + x, d1 + x, d2 + x);
+    }
+}
+
+static inline int appendIndices(uint32x4_t above, int base, int* indices, int found) {
+    if (vgetq_lane_u32(above, 0)) indices[found++] = base;
+    if (vgetq_lane_u32(above, 1)) indices[found++] = base + 1;
+    if (vgetq_lane_u32(above, 2)) indices[found++] = base + 2;
+    if (vgetq_lane_u32(above, 3)) indices[found++] = base + 3;
+    return found;
+}
+
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices) {
+    if (stride > 2 || offset >= stride) {
+        return scalar::scoresAbove(scores, count, stride, offset, threshold, indices);
+    }
+
+    const float32x4_t vthreshold = vdupq_n_f32(threshold);
+    int found = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v;
+        if (stride == 1) {
+            v = vld1q_f32(scores + i);
+        } else {
+            float32x4x2_t records = vld2q_f32(scores + 2 * i);
+            v = offset == 0 ? records.val[0] : records.val[1];
+        }
+        found = appendIndices(vcgtq_f32(v, vthreshold), i, indices, found);
+    }
+    for (; i < count; i++) {
+        if (scores[i * stride + offset] > threshold) {
+            indices[found++] = i;
+        }
+    }
+    return found;
+}
+
+static inline float horizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+static inline float32x4_t multiplyAdd(float32x4_t acc, float32x4_t a, float32x4_t b) {
+#if defined(__aarch64__)
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+}
+
+float dot(const float* a, const float* b, size_t dim) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f);
+    float32x4_t acc3 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = multiplyAdd(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = multiplyAdd(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        acc2 = multiplyAdd(acc2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        acc3 = multiplyAdd(acc3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    for (; i + 4 <= dim; i += 4) {
+        acc0 = multiplyAdd(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float sum = horizontalSum(vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3)));
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = dot(query, rows + r * dim, dim);
+    }
+}
+
+// Row blocks come from the caller; per query the rows are already cache-resident
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride) {
+    for (size_t q = 0; q < queryCount; q++) {
+        dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+    }
+}
+
+// Pairwise sums of 16 source pixels of each row, per channel, rounded to 8 outputs: (sum + 2) >> 2
+static inline uint8x8_t halvePairs(uint8x16_t a, uint8x16_t b) {
+    return vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a), b), 2);
+}
+
+void halveRow(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst) {
+    int x = 0;
+    if (channels == 1) {
+        for (; x + 8 <= dstWidth; x += 8) {
+            vst1_u8(dst + x, halvePairs(vld1q_u8(row0 + 2 * x), vld1q_u8(row1 + 2 * x)));
+        }
+    } else if (channels == 3) {
+        for (; x + 8 <= dstWidth; x += 8) {
+            uint8x16x3_t a = vld3q_u8(row0 + 6 * x);
+            uint8x16x3_t b = vld3q_u8(row1 + 6 * x);
+            uint8x8x3_t out;
+            out.val[0] = halvePairs(a.val[0], b.val[0]);
+            out.val[1] = halvePairs(a.val[1], b.val[1]);
+            out.val[2] = halvePairs(a.val[2], b.val[2]);
+            vst3_u8(dst + 3 * x, out);
+        }
+    } else if (channels == 4) {
+        for (; x + 8 <= dstWidth; x += 8) {
+            uint8x16x4_t a = vld4q_u8(row0 + 8 * x);
+            uint8x16x4_t b = vld4q_u8(row1 + 8 * x);
+            uint8x8x4_t out;
+            for (int c = 0; c < 4; c++) {
+                out.val[c] = halvePairs(a.val[c], b.val[c]);
+            }
+            vst4_u8(dst + 4 * x, out);
+        }
+    }
+    if (x < dstWidth) {
+        scalar::halveRow(row0 + 2 * channels * x, row1 + 2 * channels * x, dstWidth - x, channels, dst + channels * x);
+    }
+}
+
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        uint64x2_t acc = vdupq_n_u64(0);
+        size_t w = 0;
+        for (; w + 2 <= words; w += 2) {
+            uint8x16_t bits = veorq_u8(vreinterpretq_u8_u64(vld1q_u64(query + w)), vreinterpretq_u8_u64(vld1q_u64(row + w)));
+            // Per-byte counts widened pairwise up to 64-bit lanes
+            acc = vaddq_u64(acc, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(bits)))));
+        }
+        uint32_t distance = static_cast<uint32_t>(vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1));
+        if (w < words) {
+            uint8x8_t bits = veor_u8(vreinterpret_u8_u64(vld1_u64(query + w)), vreinterpret_u8_u64(vld1_u64(row + w)));
+            distance += static_cast<uint32_t>(vget_lane_u64(vpaddl_u32(vpaddl_u16(vpaddl_u8(vcnt_u8(bits)))), 0));
+        }
+        out[r] = distance;
+    }
+}
+
+} // namespace neon
+
+static const Kernels table = {
+    CpuIsa::NEON,
+    neon::packBgrRow,
+    neon::scoresAbove,
+    neon::dot,
+    neon::dotRows,
+    neon::dotRowsBatch,
+    scalar::integral,
+    neon::halveRow,
+    neon::hammingRows
+};
+
+const Kernels* neonKernels() {
+    return &table;
+}
+
+} // namespace simd
+
+#else
+
+namespace simd {
+const Kernels* neonKernels() {
+    return nullptr;
+}
+} // namespace simd
+
+#endif
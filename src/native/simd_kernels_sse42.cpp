@@ -0,0 +1,273 @@
+// Built with -msse4.2 -mpopcnt (see binding.gyp); only called after cpuFeatures() confirms support.
+#include "simd_kernels_impl.h"
+
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(_M_X64))
+#include <nmmintrin.h>
+#include <cstring>
+
+namespace simd {
+namespace sse42 {
+
+// Picks byte 3*i + channel of a 16-byte load into the low byte of 32-bit lane i
+static inline __m128i channelMask(int channel) {
+    return _mm_setr_epi8(
+        static_cast<char>(channel), -1, -1, -1,
+        static_cast<char>(channel + 3), -1, -1, -1,
+        static_cast<char>(channel + 6), -1, -1, -1,
+        static_cast<char>(channel + 9), -1, -1, -1);
+}
+
+void packBgrRow(const uint8_t* src, int width, float mean, float scale, bool swapRB, float* d0, float* d1, float* d2) {
+    const __m128i mask0 = channelMask(swapRB ? 2 : 0);
+    const __m128i mask1 = channelMask(1);
+    const __m128i mask2 = channelMask(swapRB ? 0 : 2);
+    const __m128 vmean = _mm_set1_ps(mean);
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    int x = 0;
+    // Each step reads 16 bytes for 4 pixels (12 bytes), so stop before running past the row
+    for (; x + 6 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x));
+        __m128 c0 = _mm_cvtepi32_ps(_mm_shuffle_epi8(pixels, mask0));
+        __m128 c1 = _mm_cvtepi32_ps(_mm_shuffle_epi8(pixels, mask1));
+        __m128 c2 = _mm_cvtepi32_ps(_mm_shuffle_epi8(pixels, mask2));
+        _mm_storeu_ps(d0 + x, _mm_mul_ps(_mm_sub_ps(c0, vmean), vscale));
+        _mm_storeu_ps(d1 + x, _mm_mul_ps(_mm_sub_ps(c1, vmean), vscale));
+        _mm_storeu_ps(d2 + x, _mm_mul_ps(_mm_sub_ps(c2, vmean), vscale));
+    }
+    if (x < width) {
+        scalar::packBgrRow(src + 3 * x, width - x, mean, scale, swapRB, d0 + x, d1 + x, d2 + x);
+    }
+}
+
+static inline int appendIndices(int mask, int base, int* indices, int found) {
+    uint32_t bits = static_cast<uint32_t>(mask);
+    while (bits) {
+        indices[found++] = base + lowestBit(bits);
+        bits &= bits - 1;
+    }
+    return found;
+}
+
+int scoresAbove(const float* scores, int count, int stride, int offset, float threshold, int* indices) {
+    if (stride > 2 || offset >= stride) {
+        return scalar::scoresAbove(scores, count, stride, offset, threshold, indices);
+    }
+
+    const __m128 vthreshold = _mm_set1_ps(threshold);
+    int found = 0;
+    int i = 0;
+    if (stride == 1) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(scores + i);
+            found = appendIndices(_mm_movemask_ps(_mm_cmpgt_ps(v, vthreshold)), i, indices, found);
+        }
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            __m128 a = _mm_loadu_ps(scores + 2 * i);
+            __m128 b = _mm_loadu_ps(scores + 2 * i + 4);
+            __m128 v = offset == 0 ? _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))
+                                   : _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            found = appendIndices(_mm_movemask_ps(_mm_cmpgt_ps(v, vthreshold)), i, indices, found);
+        }
+    }
+    for (; i < count; i++) {
+        if (scores[i * stride + offset] > threshold) {
+            indices[found++] = i;
+        }
+    }
+    return found;
+}
+
+static inline float horizontalSum(__m128 v) {
+    __m128 shuf = _mm_movehdup_ps(v);
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+float dot(const float* a, const float* b, size_t dim) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    for (; i + 4 <= dim; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float sum = horizontalSum(_mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void dotRows(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = dot(query, rows + r * dim, dim);
+    }
+}
+
+// Row blocks come from the caller; per query the rows are already cache-resident
+void dotRowsBatch(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t dim,
+                  float* out, size_t outStride) {
+    for (size_t q = 0; q < queryCount; q++) {
+        dotRows(queries + q * dim, rows, rowCount, dim, out + q * outStride);
+    }
+}
+
+void integral(const uint8_t* src, size_t srcStride, int width, int height, uint32_t* sum, size_t sumStride) {
+    for (int x = 0; x <= width; x++) {
+        sum[x] = 0;
+    }
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + y * srcStride;
+        const uint32_t* prev = sum + y * sumStride + 1;
+        uint32_t* cur = sum + (y + 1) * sumStride + 1;
+        cur[-1] = 0;
+
+        __m128i carry = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            uint32_t packed;
+            std::memcpy(&packed, row + x, sizeof(packed));
+            __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(packed)));
+            // In-register inclusive prefix sum of the 4 lanes
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + x), _mm_add_epi32(v, above));
+        }
+        uint32_t rowSum = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+        for (; x < width; x++) {
+            rowSum += row[x];
+            cur[x] = prev[x] + rowSum;
+        }
+    }
+}
+
+// (a + b + 2) >> 2 per 16-bit lane, packed back to bytes
+static inline __m128i roundQuarter(__m128i lo, __m128i hi) {
+    const __m128i two = _mm_set1_epi16(2);
+    return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2), _mm_srli_epi16(_mm_add_epi16(hi, two), 2));
+}
+
+// Sum of the even and odd pixels of one source row, widened to 16 bits
+static inline void addPairs(__m128i even, __m128i odd, __m128i& lo, __m128i& hi) {
+    const __m128i zero = _mm_setzero_si128();
+    lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_unpacklo_epi8(even, zero), _mm_unpacklo_epi8(odd, zero)));
+    hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_unpackhi_epi8(even, zero), _mm_unpackhi_epi8(odd, zero)));
+}
+
+// Even (0,2,4,6) and odd (1,3,5,7) pixels of 8 BGR pixels, packed into the low 12 bytes
+static inline void splitBgr(const uint8_t* p, __m128i& even, __m128i& odd) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+    even = _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(0, 1, 2, 6, 7, 8, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1)),
+                        _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 11, 12, -1, -1, -1, -1)));
+    odd = _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(3, 4, 5, 9, 10, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                       _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, 8, 9, 13, 14, 15, -1, -1, -1, -1)));
+}
+
+// Even and odd pixels of 8 four-byte pixels
+static inline void splitBgra(const uint8_t* p, __m128i& even, __m128i& odd) {
+    const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)));
+    even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+void halveRow(const uint8_t* row0, const uint8_t* row1, int dstWidth, int channels, uint8_t* dst) {
+    int x = 0;
+    if (channels == 1) {
+        // Adjacent byte pairs summed by a multiply-add against ones
+        const __m128i ones = _mm_set1_epi8(1);
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 8 <= dstWidth; x += 8) {
+            __m128i a = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x)), ones);
+            __m128i b = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x)), ones);
+            __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a, b), two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(sum, sum));
+        }
+    } else if (channels == 3) {
+        // 8 source pixels (24 bytes) per row give 4 output pixels (12 bytes)
+        for (; x + 4 <= dstWidth; x += 4) {
+            __m128i even, odd, lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+            splitBgr(row0 + 6 * x, even, odd);
+            addPairs(even, odd, lo, hi);
+            splitBgr(row1 + 6 * x, even, odd);
+            addPairs(even, odd, lo, hi);
+            __m128i out = roundQuarter(lo, hi);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 3 * x), out);
+            uint32_t tail = static_cast<uint32_t>(_mm_extract_epi32(out, 2));
+            std::memcpy(dst + 3 * x + 8, &tail, sizeof(tail));
+        }
+    } else if (channels == 4) {
+        for (; x + 4 <= dstWidth; x += 4) {
+            __m128i even, odd, lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+            splitBgra(row0 + 8 * x, even, odd);
+            addPairs(even, odd, lo, hi);
+            splitBgra(row1 + 8 * x, even, odd);
+            addPairs(even, odd, lo, hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), roundQuarter(lo, hi));
+        }
+    }
+    if (x < dstWidth) {
+        scalar::halveRow(row0 + 2 * channels * x, row1 + 2 * channels * x, dstWidth - x, channels, dst + channels * x);
+    }
+}
+
+void hammingRows(const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* out) {
+    for (size_t r = 0; r < count; r++) {
+        const uint64_t* row = rows + r * words;
+        uint32_t distance = 0;
+        for (size_t w = 0; w < words; w++) {
+            uint64_t bits = query[w] ^ row[w];
+#if defined(__x86_64__) || defined(_M_X64)
+            distance += static_cast<uint32_t>(_mm_popcnt_u64(bits));
+#else
+            distance += static_cast<uint32_t>(_mm_popcnt_u32(static_cast<uint32_t>(bits)) +
+                                              _mm_popcnt_u32(static_cast<uint32_t>(bits >> 32)));
+#endif
+        }
+        out[r] = distance;
+    }
+}
+
+} // namespace sse42
+
+static const Kernels table = {
+    CpuIsa::SSE42,
+    sse42::packBgrRow,
+    sse42::scoresAbove,
+    sse42::dot,
+    sse42::dotRows,
+    sse42::dotRowsBatch,
+    sse42::integral,
+    sse42::halveRow,
+    sse42::hammingRows
+};
+
+const Kernels* sse42Kernels() {
+    return &table;
+}
+
+} // namespace simd
+
+#else
+
+namespace simd {
+const Kernels* sse42Kernels() {
+    return nullptr;
+}
+} // namespace simd
+
+#endif
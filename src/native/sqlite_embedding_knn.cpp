@@ -0,0 +1,941 @@
+/**
+ * @brief Loadable SQLite extension: exact top-k cosine search over embedding columns.
+ *
+ * Reports on the SQLite deployment can join similarity results with people,
+ * events and cameras in one statement, without embedding blobs crossing into
+ * JavaScript:
+ *
+ *   SELECT embedding_knn_sync('detections', 'embedding', 'embeddingModel', 'organization_id');
+ *   SELECT d.id, c.name, m.similarity
+ *     FROM person_faces pf
+ *     JOIN embedding_knn('detections', 'embedding', pf.embedding, 50, pf.embeddingModel, 1) m
+ *     JOIN detections d ON d.id = m.id
+ *     LEFT JOIN cameras c ON c.id = d.camera_id
+ *    WHERE pf.person_id = 7;
+ *
+ * embedding_knn_sync(table, column [, model_column [, partition_column]])
+ * registers a blob column of float32 embeddings. It adds triggers that log the
+ * rowid of every insert, update and delete into _embedding_knn_changes, and
+ * brings the column's vectors up to date. The vectors are kept L2-normalized in
+ * memory, grouped by model and dimension, and in an append-only sidecar file
+ * next to the database (<db>.<table>.<column>.vec), so a restart reads one file
+ * instead of every blob. Each search first applies the changes logged since
+ * the last one, then scores every row of the query's model (and legacy rows
+ * without a model of the same dimension) with the dot-product kernel for this
+ * CPU. The partition filter keeps one organization's rows without spending k
+ * on others. Calling sync again prunes the change log up to what the sidecar
+ * holds; the service does so periodically.
+ *
+ * The sidecar is a cache: it is rebuilt from the table when it is missing,
+ * damaged, written for other columns, or behind a pruned log. It uses native
+ * byte order and one process should write it at a time.
+ */
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char* const kSourcesTable = "_embedding_knn_sources";
+const char* const kChangesTable = "_embedding_knn_changes";
+constexpr char kMagic[8] = {'F', 'D', 'K', 'N', 'N', 'V', 'E', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr int kDefaultK = 10;
+constexpr int kMaxK = 10000;
+constexpr size_t kSourceBytes = 256;
+constexpr size_t kCompactSlack = 4096; // Superseded records tolerated before the sidecar is rewritten
+
+using StmtPtr = std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)>;
+
+StmtPtr prepare(sqlite3* db, const std::string& sql, std::string& error) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(db);
+    }
+    return StmtPtr(stmt, [](sqlite3_stmt* s) { return sqlite3_finalize(s); });
+}
+
+bool exec(sqlite3* db, const std::string& sql, std::string& error) {
+    char* message = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+        error = message ? message : sqlite3_errmsg(db);
+        sqlite3_free(message);
+        return false;
+    }
+    return true;
+}
+
+std::string identifier(const std::string& name) {
+    std::string out = "\"";
+    for (char c : name) {
+        out += c;
+        if (c == '"') out += '"';
+    }
+    return out + "\"";
+}
+
+std::string literal(const std::string& text) {
+    std::string out = "'";
+    for (char c : text) {
+        out += c;
+        if (c == '\'') out += '\'';
+    }
+    return out + "'";
+}
+
+std::string columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? reinterpret_cast<const char*>(text) : std::string();
+}
+
+std::string valueText(sqlite3_value* value) {
+    const unsigned char* text = sqlite3_value_type(value) == SQLITE_NULL ? nullptr : sqlite3_value_text(value);
+    return text ? reinterpret_cast<const char*>(text) : std::string();
+}
+
+template <typename T>
+bool writeValue(std::FILE* file, const T& value) {
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool readValue(std::FILE* file, T& value) {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+// A registered embedding column
+struct Source {
+    std::string table;
+    std::string column;
+    std::string modelColumn;     // Empty: every row is a legacy row
+    std::string partitionColumn; // Empty: no partition filter
+
+    // Written to the sidecar so a file kept for other columns is not reused
+    std::string key() const {
+        return table + '\x1f' + column + '\x1f' + modelColumn + '\x1f' + partitionColumn;
+    }
+    std::string triggerName(const char* kind) const {
+        return "_embedding_knn_" + table + "_" + column + "_" + kind;
+    }
+};
+
+struct Match {
+    int64_t id = 0;
+    float similarity = 0.0f;
+    std::string model;
+};
+
+// Sidecar header, rewritten in place after every append
+struct SidecarHeader {
+    char magic[8];
+    uint32_t version = kVersion;
+    uint32_t headerBytes = sizeof(SidecarHeader);
+    int64_t lastSeq = 0;   // Change log entries applied
+    int64_t endOffset = 0; // Bytes of complete records; anything after is a torn append
+    int64_t records = 0;
+    char source[kSourceBytes];
+};
+
+// One record per upsert or delete (dim 0), followed by the model tag padded to 4 bytes and dim floats
+struct RecordHeader {
+    int64_t rowid = 0;
+    int64_t partition = 0;
+    int32_t dim = 0;
+    uint32_t modelBytes = 0;
+};
+
+/**
+ * @brief The normalized vectors of one registered column, kept in step with its change log.
+ */
+class VectorSet {
+public:
+    VectorSet(Source source, std::string sidecarPath)
+        : source(std::move(source)), sidecarPath(std::move(sidecarPath)) {}
+
+    const Source& getSource() const { return source; }
+
+    // Applies the change log since the last call; rebuilds from the table when the log cannot be trusted
+    bool sync(sqlite3* db, bool rebuild, std::string& error) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        int64_t issued = 0, pruned = 0;
+        if (!logPosition(db, issued, pruned, error)) {
+            return false;
+        }
+        if (!loaded) {
+            loaded = true;
+            rebuild = rebuild || !loadSidecar();
+        }
+        // A log recreated since (the database was replaced) or pruned past us no longer covers our gap
+        if (rebuild || lastSeq > issued || lastSeq < pruned) {
+            return rebuildFromTable(db, issued, error);
+        }
+        return applyChanges(db, error);
+    }
+
+    int64_t appliedSeq() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return lastSeq;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return where.size();
+    }
+
+    // Best `k` rows by cosine similarity; `model` null matches every group of the dimension
+    void search(const float* query, int dim, const std::string* model, const int64_t* partition, int k,
+                std::vector<Match>& out) const {
+        out.clear();
+        thread_local std::vector<float> normalized;
+        thread_local std::vector<float> scores;
+        normalized.resize(dim);
+        if (k <= 0 || !normalize(query, dim, normalized.data())) {
+            return;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        // Min-heap of the best k so far
+        auto worse = [](const Match& a, const Match& b) { return a.similarity > b.similarity; };
+        for (const Group& group : groups) {
+            if (group.dim != dim || group.ids.empty()) continue;
+            if (model && !group.model.empty() && group.model != *model) continue;
+            size_t count = group.ids.size();
+            scores.resize(count);
+            simd::kernels().dotRows(normalized.data(), group.vectors.data(), count, dim, scores.data());
+            for (size_t row = 0; row < count; row++) {
+                if (partition && group.partitions[row] != *partition) continue;
+                if (out.size() == static_cast<size_t>(k)) {
+                    if (scores[row] <= out.front().similarity) continue;
+                    std::pop_heap(out.begin(), out.end(), worse);
+                    out.pop_back();
+                }
+                out.push_back(Match{group.ids[row], scores[row], group.model});
+                std::push_heap(out.begin(), out.end(), worse);
+            }
+        }
+        std::sort_heap(out.begin(), out.end(), worse);
+    }
+
+private:
+    struct Group {
+        std::string model;
+        int dim = 0;
+        std::vector<int64_t> ids;
+        std::vector<int64_t> partitions;
+        std::vector<float> vectors;
+    };
+
+    static bool normalize(const float* in, int dim, float* out) {
+        double norm = 0.0;
+        for (int i = 0; i < dim; i++) {
+            norm += static_cast<double>(in[i]) * in[i];
+        }
+        if (!(norm > 0.0) || !std::isfinite(norm)) {
+            return false;
+        }
+        float inv = static_cast<float>(1.0 / std::sqrt(norm));
+        for (int i = 0; i < dim; i++) {
+            out[i] = in[i] * inv;
+        }
+        return true;
+    }
+
+    // Highest sequence ever issued by the log and the highest pruned for this source
+    bool logPosition(sqlite3* db, int64_t& issued, int64_t& pruned, std::string& error) {
+        StmtPtr stmt = prepare(db, std::string("SELECT (SELECT seq FROM sqlite_sequence WHERE name = ") + literal(kChangesTable) +
+                                   "), pruned_seq FROM " + kSourcesTable + " WHERE tbl = ?1 AND col = ?2", error);
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt.get(), 1, source.table.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt.get(), 2, source.column.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+            error = source.table + "." + source.column + " is no longer registered";
+            return false;
+        }
+        issued = sqlite3_column_int64(stmt.get(), 0);
+        pruned = sqlite3_column_int64(stmt.get(), 1);
+        return true;
+    }
+
+    // Columns: embedding, model, partition (model and partition NULL when not registered)
+    std::string valueColumns(const std::string& alias) const {
+        std::string out = alias + "." + identifier(source.column) + ", ";
+        out += source.modelColumn.empty() ? "NULL" : alias + "." + identifier(source.modelColumn);
+        out += ", ";
+        out += source.partitionColumn.empty() ? "NULL" : alias + "." + identifier(source.partitionColumn);
+        return out;
+    }
+
+    // Reads columns [first, first + 3) of a row as written by valueColumns(); false when the row has no usable embedding
+    static bool readRow(sqlite3_stmt* stmt, int first, std::string& model, int64_t& partition, std::vector<float>& embedding) {
+        if (sqlite3_column_type(stmt, first) != SQLITE_BLOB) {
+            return false;
+        }
+        const void* blob = sqlite3_column_blob(stmt, first);
+        int bytes = sqlite3_column_bytes(stmt, first);
+        if (!blob || bytes <= 0 || bytes % static_cast<int>(sizeof(float)) != 0) {
+            return false;
+        }
+        // Blobs are not guaranteed to be 4-byte aligned
+        embedding.resize(bytes / sizeof(float));
+        std::memcpy(embedding.data(), blob, bytes);
+        model = columnText(stmt, first + 1);
+        partition = sqlite3_column_int64(stmt, first + 2);
+        return true;
+    }
+
+    bool rebuildFromTable(sqlite3* db, int64_t issued, std::string& error) {
+        StmtPtr stmt = prepare(db, "SELECT t.rowid, " + valueColumns("t") + " FROM " + identifier(source.table) + " t WHERE t." +
+                                   identifier(source.column) + " IS NOT NULL", error);
+        if (!stmt) return false;
+        groups.clear();
+        groupIndex.clear();
+        where.clear();
+        std::string model;
+        int64_t partition = 0;
+        std::vector<float> embedding;
+        int rc;
+        while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+            if (readRow(stmt.get(), 1, model, partition, embedding)) {
+                upsert(sqlite3_column_int64(stmt.get(), 0), model, partition, embedding);
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            error = sqlite3_errmsg(db);
+            return false;
+        }
+        lastSeq = issued;
+        rewriteSidecar();
+        return true;
+    }
+
+    bool applyChanges(sqlite3* db, std::string& error) {
+        StmtPtr stmt = prepare(db, "SELECT c.seq, c.rid, " + valueColumns("t") + " FROM " + kChangesTable +
+                                   " c LEFT JOIN " + identifier(source.table) + " t ON t.rowid = c.rid" +
+                                   " WHERE c.tbl = ?1 AND c.col = ?2 AND c.seq > ?3 ORDER BY c.seq", error);
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt.get(), 1, source.table.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt.get(), 2, source.column.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt.get(), 3, lastSeq);
+
+        std::vector<char> appended;
+        int64_t appendedRecords = 0;
+        int64_t seq = lastSeq;
+        std::string model;
+        int64_t partition = 0;
+        std::vector<float> embedding;
+        int rc;
+        while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+            seq = sqlite3_column_int64(stmt.get(), 0);
+            int64_t rowid = sqlite3_column_int64(stmt.get(), 1);
+            // The row as it is now: a later entry for the same row reads the same state again
+            bool present = readRow(stmt.get(), 2, model, partition, embedding) && upsert(rowid, model, partition, embedding);
+            if (!present) {
+                erase(rowid);
+            }
+            encodeRecord(appended, rowid, present ? model : std::string(), partition, present ? &embedding : nullptr);
+            appendedRecords++;
+        }
+        if (rc != SQLITE_DONE) {
+            error = sqlite3_errmsg(db);
+            return false;
+        }
+        if (seq == lastSeq) {
+            return true;
+        }
+        lastSeq = seq;
+        appendSidecar(appended, appendedRecords);
+        // Superseded records pile up as rows change; rewrite once they outnumber the live ones
+        if (records > static_cast<int64_t>(where.size() * 2 + kCompactSlack)) {
+            rewriteSidecar();
+        }
+        return true;
+    }
+
+    // False for an embedding that cannot be normalized
+    bool upsert(int64_t rowid, const std::string& model, int64_t partition, const std::vector<float>& embedding) {
+        int dim = static_cast<int>(embedding.size());
+        std::vector<float> normalized(dim);
+        if (dim == 0 || !normalize(embedding.data(), dim, normalized.data())) {
+            return false;
+        }
+        erase(rowid);
+        std::string key = model + '\x1f' + std::to_string(dim);
+        auto found = groupIndex.find(key);
+        if (found == groupIndex.end()) {
+            found = groupIndex.emplace(key, groups.size()).first;
+            groups.push_back(Group{model, dim, {}, {}, {}});
+        }
+        Group& group = groups[found->second];
+        where[rowid] = {found->second, group.ids.size()};
+        group.ids.push_back(rowid);
+        group.partitions.push_back(partition);
+        group.vectors.insert(group.vectors.end(), normalized.begin(), normalized.end());
+        return true;
+    }
+
+    void erase(int64_t rowid) {
+        auto it = where.find(rowid);
+        if (it == where.end()) {
+            return;
+        }
+        Group& group = groups[it->second.first];
+        size_t row = it->second.second;
+        size_t last = group.ids.size() - 1;
+        if (row != last) {
+            // Order does not matter for an exact scan: move the last row into the gap
+            group.ids[row] = group.ids[last];
+            group.partitions[row] = group.partitions[last];
+            std::copy(group.vectors.begin() + last * group.dim, group.vectors.begin() + (last + 1) * group.dim,
+                      group.vectors.begin() + row * group.dim);
+            where[group.ids[row]].second = row;
+        }
+        group.ids.pop_back();
+        group.partitions.pop_back();
+        group.vectors.resize(last * group.dim);
+        where.erase(it);
+    }
+
+    static void encodeRecord(std::vector<char>& out, int64_t rowid, const std::string& model, int64_t partition,
+                             const std::vector<float>* embedding) {
+        RecordHeader header;
+        header.rowid = rowid;
+        header.partition = partition;
+        header.dim = embedding ? static_cast<int32_t>(embedding->size()) : 0;
+        header.modelBytes = static_cast<uint32_t>(model.size());
+        const size_t padded = (model.size() + 3) & ~size_t(3);
+        const size_t at = out.size();
+        out.resize(at + sizeof(header) + padded + header.dim * sizeof(float), 0);
+        std::memcpy(out.data() + at, &header, sizeof(header));
+        std::memcpy(out.data() + at + sizeof(header), model.data(), model.size());
+        if (embedding) {
+            std::memcpy(out.data() + at + sizeof(header) + padded, embedding->data(), header.dim * sizeof(float));
+        }
+    }
+
+    SidecarHeader makeHeader() const {
+        SidecarHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        std::memset(header.source, 0, sizeof(header.source));
+        std::string key = source.key();
+        std::memcpy(header.source, key.data(), std::min(key.size(), sizeof(header.source) - 1));
+        header.lastSeq = lastSeq;
+        header.endOffset = endOffset;
+        header.records = records;
+        return header;
+    }
+
+    bool loadSidecar() {
+        if (sidecarPath.empty()) {
+            return false;
+        }
+        std::FILE* file = std::fopen(sidecarPath.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        SidecarHeader header;
+        SidecarHeader expected = makeHeader();
+        bool ok = readValue(file, header) && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                  header.version == kVersion && header.headerBytes == sizeof(SidecarHeader) &&
+                  std::memcmp(header.source, expected.source, sizeof(header.source)) == 0;
+
+        std::string model;
+        std::vector<float> embedding;
+        int64_t offset = sizeof(SidecarHeader);
+        for (int64_t r = 0; ok && r < header.records; r++) {
+            RecordHeader record;
+            ok = readValue(file, record) && record.dim >= 0 && record.modelBytes < 4096;
+            const size_t padded = (record.modelBytes + 3) & ~uint32_t(3);
+            if (ok) {
+                model.resize(padded);
+                embedding.resize(record.dim);
+                ok = (padded == 0 || std::fread(&model[0], 1, padded, file) == padded) &&
+                     (record.dim == 0 || std::fread(embedding.data(), sizeof(float), record.dim, file) == static_cast<size_t>(record.dim));
+                model.resize(record.modelBytes);
+            }
+            if (ok) {
+                if (record.dim == 0) {
+                    erase(record.rowid);
+                } else {
+                    upsert(record.rowid, model, record.partition, embedding);
+                }
+                offset += sizeof(record) + padded + record.dim * sizeof(float);
+            }
+        }
+        std::fclose(file);
+        ok = ok && offset == header.endOffset;
+        if (!ok) {
+            std::cerr << "⚠️ Embedding KNN: rebuilding " << sidecarPath << " (damaged or written for other columns)" << std::endl;
+            groups.clear();
+            groupIndex.clear();
+            where.clear();
+            return false;
+        }
+        lastSeq = header.lastSeq;
+        endOffset = header.endOffset;
+        records = header.records;
+        return true;
+    }
+
+    // Records go after the last complete one, then the header moves past them
+    void appendSidecar(const std::vector<char>& bytes, int64_t count) {
+        if (sidecarPath.empty()) {
+            return;
+        }
+        std::FILE* file = std::fopen(sidecarPath.c_str(), "r+b");
+        bool ok = file && std::fseek(file, static_cast<long>(endOffset), SEEK_SET) == 0 &&
+                  std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+        if (ok) {
+            endOffset += static_cast<int64_t>(bytes.size());
+            records += count;
+            SidecarHeader header = makeHeader();
+            ok = std::fseek(file, 0, SEEK_SET) == 0 && writeValue(file, header);
+        }
+        ok = (!file || std::fclose(file) == 0) && ok;
+        if (!ok) {
+            // The next process start rebuilds from the table
+            std::cerr << "❌ Embedding KNN: appending to " << sidecarPath << " failed" << std::endl;
+            std::remove(sidecarPath.c_str());
+            sidecarPath.clear();
+        }
+    }
+
+    // One record per live row, written aside and renamed over the old file
+    void rewriteSidecar() {
+        if (sidecarPath.empty()) {
+            return;
+        }
+        const std::string temporary = sidecarPath + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (!file) {
+            std::cerr << "❌ Embedding KNN: cannot write " << temporary << std::endl;
+            return;
+        }
+        std::vector<char> bytes;
+        std::vector<float> row;
+        endOffset = sizeof(SidecarHeader);
+        records = 0;
+        bool ok = writeValue(file, makeHeader());
+        for (const Group& group : groups) {
+            for (size_t r = 0; ok && r < group.ids.size(); r++) {
+                bytes.clear();
+                row.assign(group.vectors.begin() + r * group.dim, group.vectors.begin() + (r + 1) * group.dim);
+                encodeRecord(bytes, group.ids[r], group.model, group.partitions[r], &row);
+                ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+                endOffset += static_cast<int64_t>(bytes.size());
+                records++;
+            }
+        }
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && writeValue(file, makeHeader());
+        ok = (std::fclose(file) == 0) && ok;
+        if (ok) {
+#ifdef _WIN32
+            std::remove(sidecarPath.c_str());
+#endif
+            ok = std::rename(temporary.c_str(), sidecarPath.c_str()) == 0;
+        }
+        if (!ok) {
+            std::remove(temporary.c_str());
+            std::cerr << "❌ Embedding KNN: writing " << sidecarPath << " failed" << std::endl;
+            sidecarPath.clear();
+        }
+    }
+
+    Source source;
+    std::string sidecarPath; // Empty for in-memory databases, or after a write failed
+    bool loaded = false;
+    int64_t lastSeq = 0;
+    int64_t endOffset = 0;
+    int64_t records = 0;
+
+    mutable std::shared_mutex mutex;
+    std::vector<Group> groups;
+    std::unordered_map<std::string, size_t> groupIndex;              // model + dim -> group
+    std::unordered_map<int64_t, std::pair<size_t, size_t>> where;    // rowid -> group, row
+};
+
+// Sets shared by every connection of the process, per database file and column
+std::mutex cacheMutex;
+std::unordered_map<std::string, std::shared_ptr<VectorSet>> cache;
+
+std::string sidecarPathFor(sqlite3* db, const Source& source) {
+    const char* file = sqlite3_db_filename(db, "main");
+    if (!file || !*file) {
+        return std::string();
+    }
+    std::string path = file;
+    for (const std::string* part : {&source.table, &source.column}) {
+        path += '.';
+        for (char c : *part) {
+            path += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        }
+    }
+    return path + ".vec";
+}
+
+std::shared_ptr<VectorSet> setFor(sqlite3* db, const Source& source) {
+    std::string path = sidecarPathFor(db, source);
+    std::string key = path.empty() ? "memory:" + std::to_string(reinterpret_cast<uintptr_t>(db)) + '\x1f' + source.key()
+                                   : path;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::shared_ptr<VectorSet>& set = cache[key];
+    // Registered again with other model or partition columns: start over
+    if (!set || set->getSource().key() != source.key()) {
+        set = std::make_shared<VectorSet>(source, path);
+    }
+    return set;
+}
+
+// False with an empty `error` when the column is not registered
+bool readSource(sqlite3* db, const std::string& table, const std::string& column, Source& source, std::string& error) {
+    std::string ignored;
+    StmtPtr stmt = prepare(db, std::string("SELECT model_col, partition_col FROM ") + kSourcesTable + " WHERE tbl = ?1 AND col = ?2", ignored);
+    if (!stmt) return false; // No column was ever registered
+    sqlite3_bind_text(stmt.get(), 1, table.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt.get(), 2, column.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt.get());
+    if (rc != SQLITE_ROW) {
+        if (rc != SQLITE_DONE) error = sqlite3_errmsg(db);
+        return false;
+    }
+    source.table = table;
+    source.column = column;
+    source.modelColumn = columnText(stmt.get(), 0);
+    source.partitionColumn = columnText(stmt.get(), 1);
+    return true;
+}
+
+// Creates the log, registers the column and (re)creates its triggers; `created` when the triggers were missing
+bool registerSource(sqlite3* db, const Source& source, bool& created, std::string& error) {
+    std::string columns = identifier(source.column);
+    if (!source.modelColumn.empty()) columns += ", " + identifier(source.modelColumn);
+    if (!source.partitionColumn.empty()) columns += ", " + identifier(source.partitionColumn);
+    if (!prepare(db, "SELECT " + columns + " FROM " + identifier(source.table) + " LIMIT 0", error)) {
+        return false;
+    }
+
+    Source registered;
+    std::string readError;
+    bool known = readSource(db, source.table, source.column, registered, readError) && registered.key() == source.key();
+    StmtPtr trigger = prepare(db, "SELECT count(*) FROM sqlite_master WHERE type = 'trigger' AND name IN (" +
+                                  literal(source.triggerName("ins")) + ", " + literal(source.triggerName("upd")) + ", " +
+                                  literal(source.triggerName("del")) + ")", error);
+    if (!trigger || sqlite3_step(trigger.get()) != SQLITE_ROW) return false;
+    created = !known || sqlite3_column_int(trigger.get(), 0) != 3;
+    trigger.reset();
+    if (!created) {
+        return true;
+    }
+
+    // Rows changed while the triggers were missing are not in the log: the caller rebuilds
+    const std::string tbl = literal(source.table), col = literal(source.column);
+    const std::string log = std::string("INSERT INTO ") + kChangesTable + " (tbl, col, rid) VALUES (" + tbl + ", " + col + ", ";
+    return exec(db,
+        std::string("CREATE TABLE IF NOT EXISTS ") + kSourcesTable + " (tbl TEXT NOT NULL, col TEXT NOT NULL, model_col TEXT, "
+        "partition_col TEXT, pruned_seq INTEGER NOT NULL DEFAULT 0, PRIMARY KEY (tbl, col));"
+        "CREATE TABLE IF NOT EXISTS " + kChangesTable + " (seq INTEGER PRIMARY KEY AUTOINCREMENT, tbl TEXT NOT NULL, "
+        "col TEXT NOT NULL, rid INTEGER NOT NULL);"
+        "INSERT INTO " + kSourcesTable + " (tbl, col, model_col, partition_col) VALUES (" + tbl + ", " + col + ", " +
+        literal(source.modelColumn) + ", " + literal(source.partitionColumn) + ") "
+        "ON CONFLICT (tbl, col) DO UPDATE SET model_col = excluded.model_col, partition_col = excluded.partition_col;"
+        "DROP TRIGGER IF EXISTS " + identifier(source.triggerName("ins")) + ";"
+        "DROP TRIGGER IF EXISTS " + identifier(source.triggerName("upd")) + ";"
+        "DROP TRIGGER IF EXISTS " + identifier(source.triggerName("del")) + ";"
+        "CREATE TRIGGER " + identifier(source.triggerName("ins")) + " AFTER INSERT ON " + identifier(source.table) +
+        " WHEN NEW." + identifier(source.column) + " IS NOT NULL BEGIN " + log + "NEW.rowid); END;"
+        "CREATE TRIGGER " + identifier(source.triggerName("upd")) + " AFTER UPDATE OF " + columns + " ON " + identifier(source.table) +
+        " BEGIN " + log + "NEW.rowid); END;"
+        "CREATE TRIGGER " + identifier(source.triggerName("del")) + " AFTER DELETE ON " + identifier(source.table) +
+        " WHEN OLD." + identifier(source.column) + " IS NOT NULL BEGIN " + log + "OLD.rowid); END;",
+        error);
+}
+
+// embedding_knn_sync(table, column [, model_column [, partition_column]]) -> rows with an embedding
+void syncFunction(sqlite3_context* context, int argc, sqlite3_value** argv) {
+    if (argc < 2 || argc > 4) {
+        sqlite3_result_error(context, "embedding_knn_sync(table, column [, model_column [, partition_column]])", -1);
+        return;
+    }
+    sqlite3* db = sqlite3_context_db_handle(context);
+    Source source;
+    source.table = valueText(argv[0]);
+    source.column = valueText(argv[1]);
+    source.modelColumn = argc > 2 ? valueText(argv[2]) : std::string();
+    source.partitionColumn = argc > 3 ? valueText(argv[3]) : std::string();
+    if (source.table.empty() || source.column.empty()) {
+        sqlite3_result_error(context, "embedding_knn_sync: table and column are required", -1);
+        return;
+    }
+
+    std::string error;
+    bool created = false;
+    if (!registerSource(db, source, created, error)) {
+        sqlite3_result_error(context, ("embedding_knn_sync: " + error).c_str(), -1);
+        return;
+    }
+    std::shared_ptr<VectorSet> set = setFor(db, source);
+    if (!set->sync(db, created, error)) {
+        sqlite3_result_error(context, ("embedding_knn_sync: " + error).c_str(), -1);
+        return;
+    }
+
+    // Entries the sidecar holds are no longer needed
+    const std::string seq = std::to_string(set->appliedSeq());
+    const std::string where = " WHERE tbl = " + literal(source.table) + " AND col = " + literal(source.column);
+    if (!exec(db, std::string("DELETE FROM ") + kChangesTable + where + " AND seq <= " + seq + ";"
+                  "UPDATE " + kSourcesTable + " SET pruned_seq = max(pruned_seq, " + seq + ")" + where + ";", error)) {
+        sqlite3_result_error(context, ("embedding_knn_sync: " + error).c_str(), -1);
+        return;
+    }
+    sqlite3_result_int64(context, static_cast<sqlite3_int64>(set->size()));
+}
+
+// ---- embedding_knn(table, column, query [, k [, model [, partition]]]) ----
+
+enum Column {
+    ColumnId,
+    ColumnSimilarity,
+    ColumnModel,
+    ColumnTable, // Hidden columns: the table-valued function's arguments
+    ColumnColumn,
+    ColumnQuery,
+    ColumnK,
+    ColumnModelFilter,
+    ColumnPartition
+};
+constexpr int kFirstArgument = ColumnTable;
+constexpr int kArguments = ColumnPartition - ColumnTable + 1;
+constexpr int kRequiredArguments = 3;
+
+struct KnnVtab {
+    sqlite3_vtab base; // Must be first
+    sqlite3* db;
+};
+
+struct KnnCursor {
+    sqlite3_vtab_cursor base; // Must be first
+    std::vector<Match> matches;
+    size_t row = 0;
+};
+
+int knnConnect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** vtab, char**) {
+    int rc = sqlite3_declare_vtab(db,
+        "CREATE TABLE x(id INTEGER, similarity REAL, model TEXT, source_table HIDDEN, source_column HIDDEN, "
+        "query HIDDEN, k HIDDEN, model_filter HIDDEN, partition_filter HIDDEN)");
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    KnnVtab* knn = static_cast<KnnVtab*>(sqlite3_malloc(sizeof(KnnVtab)));
+    if (!knn) {
+        return SQLITE_NOMEM;
+    }
+    std::memset(knn, 0, sizeof(KnnVtab));
+    knn->db = db;
+    *vtab = &knn->base;
+    return SQLITE_OK;
+}
+
+int knnDisconnect(sqlite3_vtab* vtab) {
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+// Every argument is an equality on its hidden column; idxNum has a bit per argument given
+int knnBestIndex(sqlite3_vtab*, sqlite3_index_info* info) {
+    int argument[kArguments];
+    std::fill(argument, argument + kArguments, -1);
+    for (int i = 0; i < info->nConstraint; i++) {
+        const auto& constraint = info->aConstraint[i];
+        int column = constraint.iColumn - kFirstArgument;
+        if (column < 0 || column >= kArguments || constraint.op != SQLITE_INDEX_CONSTRAINT_EQ) {
+            continue;
+        }
+        if (!constraint.usable) {
+            // Try another join order that supplies it
+            return SQLITE_CONSTRAINT;
+        }
+        argument[column] = i;
+    }
+
+    int idxNum = 0, next = 1;
+    for (int a = 0; a < kArguments; a++) {
+        if (argument[a] >= 0) {
+            idxNum |= 1 << a;
+            info->aConstraintUsage[argument[a]].argvIndex = next++;
+            info->aConstraintUsage[argument[a]].omit = 1;
+        }
+    }
+    if ((idxNum & ((1 << kRequiredArguments) - 1)) != (1 << kRequiredArguments) - 1) {
+        return SQLITE_CONSTRAINT;
+    }
+    info->idxNum = idxNum;
+    info->estimatedCost = 1000.0;
+    info->estimatedRows = kDefaultK;
+    // Rows come out by similarity, best first
+    if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == ColumnSimilarity && info->aOrderBy[0].desc) {
+        info->orderByConsumed = 1;
+    }
+    return SQLITE_OK;
+}
+
+int knnOpen(sqlite3_vtab*, sqlite3_vtab_cursor** cursor) {
+    *cursor = reinterpret_cast<sqlite3_vtab_cursor*>(new (std::nothrow) KnnCursor());
+    return *cursor ? SQLITE_OK : SQLITE_NOMEM;
+}
+
+int knnClose(sqlite3_vtab_cursor* cursor) {
+    delete reinterpret_cast<KnnCursor*>(cursor);
+    return SQLITE_OK;
+}
+
+int knnError(sqlite3_vtab_cursor* cursor, const std::string& message) {
+    sqlite3_vtab* vtab = cursor->pVtab;
+    sqlite3_free(vtab->zErrMsg);
+    vtab->zErrMsg = sqlite3_mprintf("embedding_knn: %s", message.c_str());
+    return SQLITE_ERROR;
+}
+
+int knnFilter(sqlite3_vtab_cursor* base, int idxNum, const char*, int argc, sqlite3_value** argv) {
+    KnnCursor* cursor = reinterpret_cast<KnnCursor*>(base);
+    cursor->matches.clear();
+    cursor->row = 0;
+
+    sqlite3_value* args[kArguments] = {};
+    for (int a = 0, next = 0; a < kArguments && next < argc; a++) {
+        if (idxNum & (1 << a)) args[a] = argv[next++];
+    }
+    sqlite3_value* query = args[ColumnQuery - kFirstArgument];
+    // A correlated query without an embedding (e.g. a face never embedded) matches nothing
+    if (sqlite3_value_type(query) == SQLITE_NULL) {
+        return SQLITE_OK;
+    }
+    int bytes = sqlite3_value_bytes(query);
+    if (sqlite3_value_type(query) != SQLITE_BLOB || bytes <= 0 || bytes % static_cast<int>(sizeof(float)) != 0) {
+        return knnError(base, "query must be a float32 embedding blob");
+    }
+    std::vector<float> embedding(bytes / sizeof(float));
+    std::memcpy(embedding.data(), sqlite3_value_blob(query), bytes);
+
+    sqlite3_value* k = args[ColumnK - kFirstArgument];
+    int limit = k && sqlite3_value_type(k) != SQLITE_NULL ? sqlite3_value_int(k) : kDefaultK;
+    limit = std::max(0, std::min(limit, kMaxK));
+    sqlite3_value* modelArg = args[ColumnModelFilter - kFirstArgument];
+    std::string model = modelArg ? valueText(modelArg) : std::string();
+    sqlite3_value* partitionArg = args[ColumnPartition - kFirstArgument];
+    bool hasPartition = partitionArg && sqlite3_value_type(partitionArg) != SQLITE_NULL;
+    int64_t partition = hasPartition ? sqlite3_value_int64(partitionArg) : 0;
+
+    KnnVtab* vtab = reinterpret_cast<KnnVtab*>(base->pVtab);
+    std::string table = valueText(args[ColumnTable - kFirstArgument]);
+    std::string column = valueText(args[ColumnColumn - kFirstArgument]);
+    Source source;
+    std::string error;
+    if (!readSource(vtab->db, table, column, source, error)) {
+        return knnError(base, error.empty() ? table + "." + column + " is not registered; run embedding_knn_sync first" : error);
+    }
+    std::shared_ptr<VectorSet> set = setFor(vtab->db, source);
+    if (!set->sync(vtab->db, false, error)) {
+        return knnError(base, error);
+    }
+    set->search(embedding.data(), static_cast<int>(embedding.size()), modelArg && !model.empty() ? &model : nullptr,
+               hasPartition ? &partition : nullptr, limit, cursor->matches);
+    return SQLITE_OK;
+}
+
+int knnNext(sqlite3_vtab_cursor* cursor) {
+    reinterpret_cast<KnnCursor*>(cursor)->row++;
+    return SQLITE_OK;
+}
+
+int knnEof(sqlite3_vtab_cursor* base) {
+    KnnCursor* cursor = reinterpret_cast<KnnCursor*>(base);
+    return cursor->row >= cursor->matches.size();
+}
+
+int knnColumn(sqlite3_vtab_cursor* base, sqlite3_context* context, int column) {
+    const Match& match = reinterpret_cast<KnnCursor*>(base)->matches[reinterpret_cast<KnnCursor*>(base)->row];
+    switch (column) {
+        case ColumnId:
+            sqlite3_result_int64(context, match.id);
+            break;
+        case ColumnSimilarity:
+            sqlite3_result_double(context, match.similarity);
+            break;
+        case ColumnModel:
+            if (match.model.empty()) {
+                sqlite3_result_null(context);
+            } else {
+                sqlite3_result_text(context, match.model.c_str(), -1, SQLITE_TRANSIENT);
+            }
+            break;
+        default:
+            // Arguments are consumed by xBestIndex and never read back
+            sqlite3_result_null(context);
+            break;
+    }
+    return SQLITE_OK;
+}
+
+int knnRowid(sqlite3_vtab_cursor* base, sqlite3_int64* rowid) {
+    *rowid = static_cast<sqlite3_int64>(reinterpret_cast<KnnCursor*>(base)->row);
+    return SQLITE_OK;
+}
+
+// Eponymous-only: no xCreate, so it is used as a table-valued function and never created
+sqlite3_module makeModule() {
+    sqlite3_module module;
+    std::memset(&module, 0, sizeof(module));
+    module.xConnect = knnConnect;
+    module.xBestIndex = knnBestIndex;
+    module.xDisconnect = knnDisconnect;
+    module.xOpen = knnOpen;
+    module.xClose = knnClose;
+    module.xFilter = knnFilter;
+    module.xNext = knnNext;
+    module.xEof = knnEof;
+    module.xColumn = knnColumn;
+    module.xRowid = knnRowid;
+    return module;
+}
+
+const sqlite3_module knnModule = makeModule();
+
+} // namespace
+
+extern "C" {
+
+// Entry point SQLite derives from the file name (embedding_knn.node)
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+int sqlite3_embeddingknn_init(sqlite3* db, char** errorMessage, const sqlite3_api_routines* api) {
+    SQLITE_EXTENSION_INIT2(api);
+    int rc = sqlite3_create_module(db, "embedding_knn", &knnModule, nullptr);
+    if (rc == SQLITE_OK) {
+        // Writes triggers and prunes the log, so it is never run from schema objects
+        int flags = SQLITE_UTF8;
+#ifdef SQLITE_DIRECTONLY
+        flags |= SQLITE_DIRECTONLY;
+#endif
+        rc = sqlite3_create_function(db, "embedding_knn_sync", -1, flags, nullptr, syncFunction, nullptr, nullptr);
+    }
+    if (rc != SQLITE_OK && errorMessage) {
+        *errorMessage = sqlite3_mprintf("embedding_knn: %s", sqlite3_errmsg(db));
+    }
+    return rc;
+}
+
+} // extern "C"
@@ -0,0 +1,223 @@
+#include "stage_profiler.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kCounterCount = 5; // cycles, instructions, LLC references, LLC misses, branch misses
+
+#if defined(__linux__)
+
+std::string paranoidLevel() {
+    std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+    std::string level;
+    file >> level;
+    return level.empty() ? "unknown" : level;
+}
+
+// One counter group per thread; perf counts the thread it was opened on, wherever it is scheduled
+class CounterGroup {
+public:
+    ~CounterGroup() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    // Opens the group on first use; returns false with a reason if counters are unavailable here
+    bool ensureOpen(std::string& reason) {
+        if (tried) {
+            reason = failure;
+            return ok;
+        }
+        tried = true;
+
+        const uint64_t configs[kCounterCount] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (int i = 0; i < kCounterCount; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1; // Allowed at perf_event_paranoid 2; kernel time is not ours to tune anyway
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int groupFd = i == 0 ? -1 : fds[0];
+            int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0) {
+                int error = errno;
+                if (error == EACCES || error == EPERM) {
+                    failure = "perf_event_open not permitted (perf_event_paranoid=" + paranoidLevel() +
+                              ", or the container blocks the syscall)";
+                } else if (error == ENOENT || error == EOPNOTSUPP || error == ENODEV) {
+                    failure = "hardware counters not supported on this CPU or VM";
+                } else if (error == ENOSYS) {
+                    failure = "kernel built without perf events";
+                } else {
+                    failure = std::string("perf_event_open failed: ") + std::strerror(error);
+                }
+                reason = failure;
+                return false;
+            }
+            fds[i] = fd;
+        }
+        ok = true;
+        return true;
+    }
+
+    // Counter values scaled for multiplexing (when the PMU is shared, counters run part of the time)
+    bool read(uint64_t* values) const {
+        struct {
+            uint64_t nr;
+            uint64_t timeEnabled;
+            uint64_t timeRunning;
+            uint64_t values[kCounterCount];
+        } data;
+        if (::read(fds[0], &data, sizeof(data)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+            return false;
+        }
+        double scale = data.timeRunning > 0 && data.timeRunning < data.timeEnabled
+            ? static_cast<double>(data.timeEnabled) / data.timeRunning : 1.0;
+        for (int i = 0; i < kCounterCount; i++) {
+            values[i] = i < static_cast<int>(data.nr) ? static_cast<uint64_t>(data.values[i] * scale) : 0;
+        }
+        return true;
+    }
+
+private:
+    int fds[kCounterCount] = {-1, -1, -1, -1, -1};
+    bool tried = false;
+    bool ok = false;
+    std::string failure;
+};
+
+#else
+
+class CounterGroup {
+public:
+    bool ensureOpen(std::string& reason) {
+        reason = "hardware counters need Linux perf_event_open";
+        return false;
+    }
+    bool read(uint64_t*) const { return false; }
+};
+
+#endif
+
+thread_local CounterGroup threadCounters;
+
+} // namespace
+
+const char* profileStageName(ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::Decode: return "decode";
+        case ProfileStage::Prefilter: return "prefilter";
+        case ProfileStage::Detect: return "detect";
+        case ProfileStage::Validate: return "validate";
+        case ProfileStage::Embed: return "embed";
+    }
+    return "unknown";
+}
+
+bool StageProfiler::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    for (StageStats& stats : totals) {
+        stats = StageStats();
+    }
+    unavailableReason.clear();
+    windowStart = std::chrono::steady_clock::now();
+    generation.fetch_add(1, std::memory_order_relaxed);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+bool StageProfiler::stop(Report& report) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    active.store(false, std::memory_order_release);
+
+    report = Report();
+    report.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - windowStart).count();
+    uint64_t counted = 0;
+    for (int i = 0; i < kProfileStageCount; i++) {
+        report.stages[i] = totals[i];
+        counted += totals[i].countedCalls;
+    }
+    if (counted == 0 && unavailableReason.empty()) {
+        // Nothing ran in the window; say whether counters would have worked on this thread
+        threadCounters.ensureOpen(unavailableReason);
+    }
+    report.countersAvailable = counted > 0 || unavailableReason.empty();
+    report.unavailableReason = unavailableReason;
+    return true;
+}
+
+void StageProfiler::record(ProfileStage stage, uint64_t windowGeneration, double wallMs, const uint64_t* deltas) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active.load(std::memory_order_relaxed) || generation.load(std::memory_order_relaxed) != windowGeneration) {
+        return; // Started in a window that has since closed
+    }
+    StageStats& stats = totals[static_cast<int>(stage)];
+    stats.calls++;
+    stats.wallMs += wallMs;
+    if (deltas) {
+        stats.countedCalls++;
+        stats.cycles += deltas[0];
+        stats.instructions += deltas[1];
+        stats.llcReferences += deltas[2];
+        stats.llcMisses += deltas[3];
+        stats.branchMisses += deltas[4];
+    }
+}
+
+StageProfiler::Scope::Scope(StageProfiler& owner, ProfileStage stage)
+    : profiler(nullptr), stage(stage), generation(0), counted(false) {
+    if (!owner.isActive()) {
+        return;
+    }
+    profiler = &owner;
+    generation = owner.generation.load(std::memory_order_relaxed);
+
+    std::string reason;
+    if (threadCounters.ensureOpen(reason)) {
+        counted = threadCounters.read(startCounters);
+    } else {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        if (owner.unavailableReason.empty()) {
+            owner.unavailableReason = reason;
+        }
+    }
+    startTime = std::chrono::steady_clock::now();
+}
+
+StageProfiler::Scope::~Scope() {
+    if (!profiler) {
+        return;
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    uint64_t endCounters[kCounterCount];
+    uint64_t deltas[kCounterCount];
+    bool haveDeltas = counted && threadCounters.read(endCounters);
+    if (haveDeltas) {
+        for (int i = 0; i < kCounterCount; i++) {
+            deltas[i] = endCounters[i] >= startCounters[i] ? endCounters[i] - startCounters[i] : 0;
+        }
+    }
+    profiler->record(stage, generation, wallMs, haveDeltas ? deltas : nullptr);
+}
@@ -0,0 +1,80 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Pipeline stages measured by StageProfiler, in report order
+enum class ProfileStage { Decode, Prefilter, Detect, Validate, Embed };
+constexpr int kProfileStageCount = 5;
+const char* profileStageName(ProfileStage stage);
+
+/**
+ * @brief Hardware performance counters per pipeline stage, for a profiling window.
+ *
+ * Each thread that runs a stage opens its own perf_event_open group (cycles,
+ * instructions, last-level cache references and misses, branch misses) the
+ * first time it runs one during a window; Scope reads the group around the
+ * stage. Outside a window a Scope costs one atomic load. Where counters cannot
+ * be opened (not Linux, perf_event_paranoid, containers without the syscall,
+ * VMs without a PMU) stages still get call counts and wall time, and the
+ * report says why counters are missing.
+ */
+class StageProfiler {
+public:
+    struct StageStats {
+        uint64_t calls = 0;
+        uint64_t countedCalls = 0;   // Calls measured with hardware counters
+        double wallMs = 0.0;
+        uint64_t cycles = 0;         // Counter totals cover countedCalls only
+        uint64_t instructions = 0;
+        uint64_t llcReferences = 0;
+        uint64_t llcMisses = 0;
+        uint64_t branchMisses = 0;
+    };
+
+    struct Report {
+        bool countersAvailable = false;
+        std::string unavailableReason;
+        double durationMs = 0.0;
+        StageStats stages[kProfileStageCount];
+    };
+
+    // Opens a window; false if one is already open
+    bool start();
+    // Closes the window and returns what it measured; false if none was open
+    bool stop(Report& report);
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    // Measures the enclosing block as one call of `stage` while a window is open
+    class Scope {
+    public:
+        Scope(StageProfiler& profiler, ProfileStage stage);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        StageProfiler* profiler; // nullptr outside a window
+        ProfileStage stage;
+        uint64_t generation;
+        bool counted;
+        uint64_t startCounters[5];
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+private:
+    void record(ProfileStage stage, uint64_t generation, double wallMs, const uint64_t* deltas);
+
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> generation{0};
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point windowStart;
+    StageStats totals[kProfileStageCount];
+    std::string unavailableReason; // From the first thread whose counters failed to open
+};
+
+#endif // STAGE_PROFILER_H
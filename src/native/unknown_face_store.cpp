@@ -0,0 +1,204 @@
+#include "unknown_face_store.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t kBlockBytes = 256 * 1024; // Rows per block, sized for L2
+constexpr size_t kQueryBlock = 64;         // Queries scored against a block per kernel call
+
+} // namespace
+
+UnknownFaceStore::UnknownFaceStore(int dimension, size_t maxPerOrganization)
+    : dim(std::max(1, dimension)), maxPerOrganization(std::max<size_t>(1, maxPerOrganization)) {}
+
+bool UnknownFaceStore::normalize(const float* in, float* out) const {
+    double norm = 0.0;
+    for (int i = 0; i < dim; i++) {
+        norm += static_cast<double>(in[i]) * in[i];
+    }
+    if (!(norm > 0.0) || !std::isfinite(norm)) {
+        return false;
+    }
+    float inv = static_cast<float>(1.0 / std::sqrt(norm));
+    for (int i = 0; i < dim; i++) {
+        out[i] = in[i] * inv;
+    }
+    return true;
+}
+
+bool UnknownFaceStore::add(int64_t detectionId, int64_t organizationId, int64_t detectedAtMs, const float* embedding) {
+    std::vector<float> normalized(dim);
+    if (!embedding || !normalize(embedding, normalized.data())) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (organizationOf.count(detectionId)) {
+        return true;
+    }
+    Partition& partition = partitions[organizationId];
+    // Detections mostly arrive in time order, so this is almost always an append
+    size_t at = partition.times.size();
+    if (at > 0 && partition.times.back() > detectedAtMs) {
+        at = std::upper_bound(partition.times.begin(), partition.times.end(), detectedAtMs) - partition.times.begin();
+    }
+    partition.times.insert(partition.times.begin() + at, detectedAtMs);
+    partition.ids.insert(partition.ids.begin() + at, detectionId);
+    partition.vectors.insert(partition.vectors.begin() + at * dim, normalized.begin(), normalized.end());
+    organizationOf[detectionId] = organizationId;
+    added++;
+
+    if (partition.ids.size() > maxPerOrganization) {
+        // Evict an eighth at once so a full organization does not shift its rows on every add
+        evictOldest(partition, partition.ids.size() - maxPerOrganization + maxPerOrganization / 8);
+    }
+    return true;
+}
+
+void UnknownFaceStore::evictOldest(Partition& partition, size_t count) {
+    count = std::min(count, partition.ids.size());
+    for (size_t i = 0; i < count; i++) {
+        organizationOf.erase(partition.ids[i]);
+    }
+    partition.times.erase(partition.times.begin(), partition.times.begin() + count);
+    partition.ids.erase(partition.ids.begin(), partition.ids.begin() + count);
+    partition.vectors.erase(partition.vectors.begin(), partition.vectors.begin() + count * dim);
+    evicted += count;
+}
+
+size_t UnknownFaceStore::remove(const int64_t* detectionIds, size_t count) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Grouped by organization so each affected partition is compacted once
+    std::unordered_map<int64_t, std::unordered_set<int64_t>> doomed;
+    for (size_t i = 0; i < count; i++) {
+        auto it = organizationOf.find(detectionIds[i]);
+        if (it != organizationOf.end()) {
+            doomed[it->second].insert(it->first);
+            organizationOf.erase(it);
+        }
+    }
+
+    size_t total = 0;
+    for (const auto& entry : doomed) {
+        const std::unordered_set<int64_t>& ids = entry.second;
+        Partition& partition = partitions[entry.first];
+        size_t kept = 0;
+        for (size_t row = 0; row < partition.ids.size(); row++) {
+            if (ids.count(partition.ids[row])) {
+                continue;
+            }
+            if (kept != row) {
+                partition.times[kept] = partition.times[row];
+                partition.ids[kept] = partition.ids[row];
+                std::copy(partition.vectors.begin() + row * dim, partition.vectors.begin() + (row + 1) * dim,
+                          partition.vectors.begin() + kept * dim);
+            }
+            kept++;
+        }
+        total += partition.ids.size() - kept;
+        partition.times.resize(kept);
+        partition.ids.resize(kept);
+        partition.vectors.resize(kept * dim);
+        if (kept == 0) {
+            partitions.erase(entry.first);
+        }
+    }
+    removed += total;
+    return total;
+}
+
+void UnknownFaceStore::match(const float* queries, size_t count, const MatchOptions& options, std::vector<Link>& links) {
+    links.clear();
+    if (!queries || count == 0 || options.maxLinks == 0) {
+        return;
+    }
+
+    // Valid queries packed contiguously
+    std::vector<float> packed(count * dim);
+    std::vector<int> origin;
+    for (size_t q = 0; q < count; q++) {
+        if (normalize(queries + q * dim, packed.data() + origin.size() * dim)) {
+            origin.push_back(static_cast<int>(q));
+        }
+    }
+    if (origin.empty()) {
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    matches++;
+    auto it = partitions.find(options.organizationId);
+    if (it == partitions.end()) {
+        return;
+    }
+    const Partition& partition = it->second;
+    size_t first = std::lower_bound(partition.times.begin(), partition.times.end(), options.fromMs) - partition.times.begin();
+    size_t last = std::upper_bound(partition.times.begin(), partition.times.end(), options.toMs) - partition.times.begin();
+    if (first >= last) {
+        return;
+    }
+    scanned += last - first;
+
+    const simd::Kernels& kernels = simd::kernels();
+    size_t valid = origin.size();
+    size_t rowBlock = std::max<size_t>(16, kBlockBytes / (dim * sizeof(float)));
+    std::vector<float> tile(kQueryBlock * rowBlock);
+    std::vector<float> best(rowBlock);
+    std::vector<int> bestQuery(rowBlock);
+    for (size_t rowStart = first; rowStart < last; rowStart += rowBlock) {
+        size_t rows = std::min(rowBlock, last - rowStart);
+        const float* block = partition.vectors.data() + rowStart * dim;
+        std::fill(best.begin(), best.begin() + rows, -2.0f);
+        // Every query is scored against this block while it is in cache
+        for (size_t queryStart = 0; queryStart < valid; queryStart += kQueryBlock) {
+            size_t queryCount = std::min(kQueryBlock, valid - queryStart);
+            kernels.dotRowsBatch(packed.data() + queryStart * dim, queryCount, block, rows, dim, tile.data(), rowBlock);
+            for (size_t q = 0; q < queryCount; q++) {
+                const float* scores = tile.data() + q * rowBlock;
+                for (size_t r = 0; r < rows; r++) {
+                    if (scores[r] > best[r]) {
+                        best[r] = scores[r];
+                        bestQuery[r] = origin[queryStart + q];
+                    }
+                }
+            }
+        }
+        for (size_t r = 0; r < rows; r++) {
+            if (best[r] >= options.threshold) {
+                Link link;
+                link.detectionId = partition.ids[rowStart + r];
+                link.query = bestQuery[r];
+                link.similarity = best[r];
+                links.push_back(link);
+            }
+        }
+    }
+
+    std::sort(links.begin(), links.end(), [](const Link& a, const Link& b) { return a.similarity > b.similarity; });
+    if (links.size() > options.maxLinks) {
+        links.resize(options.maxLinks);
+    }
+    linked += links.size();
+}
+
+UnknownFaceStore::Stats UnknownFaceStore::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    Stats out;
+    out.size = organizationOf.size();
+    out.organizations = partitions.size();
+    out.dimension = dim;
+    for (const auto& entry : partitions) {
+        out.vectorBytes += static_cast<uint64_t>(entry.second.vectors.size()) * sizeof(float);
+    }
+    out.added = added.load();
+    out.removed = removed.load();
+    out.evicted = evicted.load();
+    out.matches = matches.load();
+    out.scanned = scanned.load();
+    out.links = linked.load();
+    return out;
+}
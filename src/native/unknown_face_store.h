@@ -0,0 +1,94 @@
+#ifndef UNKNOWN_FACE_STORE_H
+#define UNKNOWN_FACE_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Embeddings of detections that matched nobody, for reverse search on enrollment.
+ *
+ * Rows are partitioned by organization and kept in detection-time order, so an
+ * organization and time window select one contiguous range without a scan.
+ * match() scores the new enrollment embeddings against that range in one pass:
+ * each block of rows is loaded once and scored against every query with the
+ * batched dot-product kernel, and every detection whose best query reaches the
+ * threshold becomes a candidate link. Each organization keeps at most
+ * maxPerOrganization rows; the oldest are evicted first. Matches run
+ * concurrently; adds and removes take the store exclusively.
+ */
+class UnknownFaceStore {
+public:
+    struct Link {
+        int64_t detectionId = 0;
+        int query = 0;           // Index of the query that matched best
+        float similarity = 0.0f; // Cosine similarity
+    };
+
+    struct MatchOptions {
+        int64_t organizationId = 0;
+        int64_t fromMs = std::numeric_limits<int64_t>::min(); // Detection time window, inclusive
+        int64_t toMs = std::numeric_limits<int64_t>::max();
+        float threshold = 0.5f;  // Cosine similarity a link needs
+        size_t maxLinks = 1000;  // Best links kept
+    };
+
+    struct Stats {
+        size_t size = 0;
+        size_t organizations = 0;
+        int dimension = 0;
+        uint64_t vectorBytes = 0;
+        uint64_t added = 0;
+        uint64_t removed = 0;
+        uint64_t evicted = 0;    // Dropped as the oldest of a full organization
+        uint64_t matches = 0;
+        uint64_t scanned = 0;    // Rows scored, across all matches
+        uint64_t links = 0;
+    };
+
+    UnknownFaceStore(int dimension, size_t maxPerOrganization);
+
+    int dimension() const { return dim; }
+
+    // False for a zero or non-finite embedding; a detection already stored is left as is
+    bool add(int64_t detectionId, int64_t organizationId, int64_t detectedAtMs, const float* embedding);
+
+    // Removes detections that were linked or deleted; returns how many were stored
+    size_t remove(const int64_t* detectionIds, size_t count);
+
+    // `count` contiguous queries against the organization's window; links best first
+    void match(const float* queries, size_t count, const MatchOptions& options, std::vector<Link>& links);
+
+    Stats stats() const;
+
+private:
+    // One organization's rows, ascending by detection time
+    struct Partition {
+        std::vector<int64_t> times;
+        std::vector<int64_t> ids;
+        std::vector<float> vectors;
+    };
+
+    bool normalize(const float* in, float* out) const;
+    void evictOldest(Partition& partition, size_t count);
+
+    int dim;
+    size_t maxPerOrganization;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<int64_t, Partition> partitions;
+    std::unordered_map<int64_t, int64_t> organizationOf; // Detection id -> organization
+
+    std::atomic<uint64_t> added{0};
+    std::atomic<uint64_t> removed{0};
+    std::atomic<uint64_t> evicted{0};
+    std::atomic<uint64_t> matches{0};
+    std::atomic<uint64_t> scanned{0};
+    std::atomic<uint64_t> linked{0};
+};
+
+#endif // UNKNOWN_FACE_STORE_H
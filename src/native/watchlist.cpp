@@ -0,0 +1,186 @@
+#include "watchlist.h"
+#include "embedding_tier_policy.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+Watchlist::Watchlist(float threshold)
+    : defaultThreshold(threshold > 0.0f && threshold <= 1.0f ? threshold : 0.6f) {}
+
+bool Watchlist::normalize(const float* in, int dim, float* out) {
+    double norm = 0.0;
+    for (int i = 0; i < dim; i++) {
+        norm += static_cast<double>(in[i]) * in[i];
+    }
+    if (!(norm > 0.0) || !std::isfinite(norm)) {
+        return false;
+    }
+    float inv = static_cast<float>(1.0 / std::sqrt(norm));
+    for (int i = 0; i < dim; i++) {
+        out[i] = in[i] * inv;
+    }
+    return true;
+}
+
+bool Watchlist::insert(const Entry& entry) {
+    int dim = static_cast<int>(entry.embedding.size());
+    std::vector<float> normalized(dim);
+    if (dim == 0 || !normalize(entry.embedding.data(), dim, normalized.data())) {
+        return false;
+    }
+    auto existing = groups.find(entry.model);
+    if (existing != groups.end() && !existing->second.ids.empty() && existing->second.dim != dim) {
+        return false;
+    }
+
+    erase(entry.id);
+    Group& group = groups[entry.model];
+    group.dim = dim;
+    group.ids.push_back(entry.id);
+    group.organizations.push_back(entry.organizationId);
+    group.thresholds.push_back(entry.threshold > 0.0f ? entry.threshold : defaultThreshold);
+    group.vectors.insert(group.vectors.end(), normalized.begin(), normalized.end());
+    modelOf[entry.id] = entry.model;
+    return true;
+}
+
+void Watchlist::erase(int64_t id) {
+    auto it = modelOf.find(id);
+    if (it == modelOf.end()) {
+        return;
+    }
+    Group& group = groups[it->second];
+    size_t row = std::find(group.ids.begin(), group.ids.end(), id) - group.ids.begin();
+    size_t last = group.ids.size() - 1;
+    if (row != last) {
+        // Order does not matter for an exact scan: move the last row into the gap
+        group.ids[row] = group.ids[last];
+        group.organizations[row] = group.organizations[last];
+        group.thresholds[row] = group.thresholds[last];
+        std::copy(group.vectors.begin() + last * group.dim, group.vectors.begin() + (last + 1) * group.dim,
+                  group.vectors.begin() + row * group.dim);
+    }
+    group.ids.pop_back();
+    group.organizations.pop_back();
+    group.thresholds.pop_back();
+    group.vectors.resize(last * group.dim);
+    if (group.ids.empty()) {
+        groups.erase(it->second);
+    }
+    modelOf.erase(it);
+}
+
+bool Watchlist::add(const Entry& entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return insert(entry);
+}
+
+bool Watchlist::remove(int64_t id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    bool listed = modelOf.count(id) > 0;
+    erase(id);
+    return listed;
+}
+
+size_t Watchlist::reset(const std::vector<Entry>& entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    groups.clear();
+    modelOf.clear();
+    size_t kept = 0;
+    for (const Entry& entry : entries) {
+        kept += insert(entry) ? 1 : 0;
+    }
+    return kept;
+}
+
+// Tags are "<model>-<width>x<height>@<hash>"; the legacy rows were written by ArcFace or FaceNet
+static bool isLegacyModel(const std::string& model) {
+    int tier = embeddingTierFromName(model.substr(0, model.find('-')));
+    return tier == static_cast<int>(EmbeddingTier::ArcFace) || tier == static_cast<int>(EmbeddingTier::FaceNet);
+}
+
+int Watchlist::groupsFor(const std::string& model, int dimension, const Group* found[2]) const {
+    int count = 0;
+    auto it = groups.find(model);
+    if (it != groups.end() && it->second.dim == dimension) {
+        found[count++] = &it->second;
+    }
+    if (model.empty() || !isLegacyModel(model)) {
+        return count;
+    }
+    // Embeddings enrolled before models were tagged, still listed next to the model's own
+    auto legacy = groups.find(std::string());
+    if (legacy != groups.end() && legacy->second.dim == dimension) {
+        found[count++] = &legacy->second;
+    }
+    return count;
+}
+
+bool Watchlist::check(const std::string& model, const float* embedding, int dimension, int64_t organizationId, Hit& hit) const {
+    if (!embedding || dimension <= 0) {
+        return false;
+    }
+    checks++;
+
+    thread_local std::vector<float> query;
+    thread_local std::vector<float> scores;
+    query.resize(dimension);
+    if (!normalize(embedding, dimension, query.data())) {
+        return false;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const Group* found[2];
+    int groupCount = groupsFor(model, dimension, found);
+
+    bool matched = false;
+    for (int g = 0; g < groupCount; g++) {
+        const Group* group = found[g];
+        size_t count = group->ids.size();
+        scores.resize(count);
+        simd::kernels().dotRows(query.data(), group->vectors.data(), count, dimension, scores.data());
+        scanned += count;
+
+        for (size_t row = 0; row < count; row++) {
+            if (scores[row] < group->thresholds[row]) continue;
+            if (organizationId >= 0 && group->organizations[row] != organizationId) continue;
+            if (!matched || scores[row] > hit.similarity) {
+                hit.id = group->ids[row];
+                hit.organizationId = group->organizations[row];
+                hit.similarity = scores[row];
+                matched = true;
+            }
+        }
+    }
+    if (matched) {
+        hits++;
+    }
+    return matched;
+}
+
+void Watchlist::recordAlert(double latencyMs) {
+    uint64_t micros = static_cast<uint64_t>(std::max(0.0, latencyMs) * 1000.0);
+    alerts++;
+    alertMicros += micros;
+    uint64_t seen = maxAlertMicros.load(std::memory_order_relaxed);
+    while (micros > seen && !maxAlertMicros.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+Watchlist::Stats Watchlist::stats() const {
+    Stats out;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        out.size = modelOf.size();
+        out.models = groups.size();
+    }
+    out.threshold = defaultThreshold;
+    out.checks = checks.load();
+    out.scanned = scanned.load();
+    out.hits = hits.load();
+    out.alerts = alerts.load();
+    out.avgAlertMs = out.alerts > 0 ? alertMicros.load() / 1000.0 / out.alerts : 0.0;
+    out.maxAlertMs = maxAlertMicros.load() / 1000.0;
+    return out;
+}
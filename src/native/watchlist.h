@@ -0,0 +1,104 @@
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A small set of priority embeddings (banned visitors, VIPs) checked against every face.
+ *
+ * Kept apart from the enrolled gallery so a hit does not wait for the general
+ * search: the detector checks each face right after it is embedded, before the
+ * frame's other faces, and raises an alert on the detecting thread. Entries
+ * are grouped by embedding model, and check() is an exact scan of that
+ * model's rows with the dot-product kernel for this CPU (about 0.1 ms for
+ * two thousand 512-d entries), keeping the best entry whose threshold is
+ * reached. Embeddings without a model tag form the legacy group, written by
+ * a primary model (ArcFace or FaceNet): it is scanned as well for those
+ * models' tags of the same dimension, never for MobileFaceNet, whose vectors
+ * are in another space. Checks run concurrently; changes take the
+ * watchlist exclusively, and reset() swaps the whole list at once so a refresh
+ * never leaves it empty.
+ */
+class Watchlist {
+public:
+    struct Entry {
+        int64_t id = 0;             // Caller's id (e.g. the PersonFace); adding an id again replaces it
+        int64_t organizationId = 0;
+        std::string model;          // Version tag of the embedding; empty for legacy embeddings
+        std::vector<float> embedding;
+        float threshold = 0.0f;     // Cosine similarity for an alert; 0 = the watchlist's
+    };
+
+    struct Hit {
+        int64_t id = 0;
+        int64_t organizationId = 0;
+        float similarity = 0.0f;
+    };
+
+    struct Stats {
+        size_t size = 0;
+        size_t models = 0;
+        float threshold = 0.0f;
+        uint64_t checks = 0;
+        uint64_t scanned = 0;     // Rows scored, across all checks
+        uint64_t hits = 0;
+        uint64_t alerts = 0;      // Hits delivered to the detector's alert callback
+        double avgAlertMs = 0.0;  // Detection start to alert
+        double maxAlertMs = 0.0;
+    };
+
+    explicit Watchlist(float threshold);
+
+    // False for an empty, zero or non-finite embedding, or one whose dimension differs from its model's
+    bool add(const Entry& entry);
+    // True if the id was listed
+    bool remove(int64_t id);
+    // Replaces every entry at once; returns how many were kept
+    size_t reset(const std::vector<Entry>& entries);
+
+    // Best entry of the model reaching its threshold; organizationId below 0 matches every organization
+    bool check(const std::string& model, const float* embedding, int dimension, int64_t organizationId, Hit& hit) const;
+
+    // Latency of an alert raised from a hit, for stats
+    void recordAlert(double latencyMs);
+
+    float threshold() const { return defaultThreshold; }
+    Stats stats() const;
+
+private:
+    // One model's rows, L2-normalized and contiguous
+    struct Group {
+        int dim = 0;
+        std::vector<int64_t> ids;
+        std::vector<int64_t> organizations;
+        std::vector<float> thresholds;
+        std::vector<float> vectors;
+    };
+
+    static bool normalize(const float* in, int dim, float* out);
+    bool insert(const Entry& entry);
+    void erase(int64_t id);
+    // The model's group and, for primary models, the legacy group; returns how many were found
+    int groupsFor(const std::string& model, int dimension, const Group* found[2]) const;
+
+    float defaultThreshold;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Group> groups;
+    std::unordered_map<int64_t, std::string> modelOf; // Entry id -> group
+
+    mutable std::atomic<uint64_t> checks{0};
+    mutable std::atomic<uint64_t> scanned{0};
+    mutable std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> alerts{0};
+    std::atomic<uint64_t> alertMicros{0};
+    std::atomic<uint64_t> maxAlertMicros{0};
+};
+
+#endif // WATCHLIST_H
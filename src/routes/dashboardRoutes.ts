@@ -14,5 +14,8 @@ dashboardRoutes.use(organizationAccess);
 // Dashboard statistics
 dashboardRoutes.get('/stats', dashboardController.getStats);
 
+// Detection counts over time
+dashboardRoutes.get('/activity', dashboardController.getActivity);
+
 // System status
 dashboardRoutes.get('/system-status', dashboardController.getSystemStatus);
\ No newline at end of file
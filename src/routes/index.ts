@@ -1,4 +1,5 @@
-import { Router } from 'express';
+import { Router, Request, Response, NextFunction } from 'express';
+import { timingSafeEqual } from 'crypto';
 import { authenticateToken, authorize } from '../middlewares/auth';
 import { organizationAccess } from '../middlewares/organizationAccess';
 import { AuthController } from '../controllers/AuthController';
@@ -16,6 +17,7 @@ import streamRoutes from './streamRoutes';
 import { dashboardRoutes } from './dashboardRoutes';
 import { reportRoutes } from './reportRoutes';
 import { faceIndexService } from '../services/FaceIndexService';
+import { watchlistService } from '../services/WatchlistService';
 
 // Initialize controllers
 const authController = new AuthController();
@@ -252,6 +254,42 @@ apiRoutes.get('/debug/face-index/stats', (req, res) => {
   }
 });
 
+// Debug routes for the watchlist
+apiRoutes.get('/debug/watchlist/stats', (req, res) => {
+  try {
+    res.status(200).json({
+      success: true,
+      data: watchlistService.getStats(),
+      timestamp: new Date().toISOString(),
+    });
+  } catch (error: any) {
+    res.status(500).json({
+      success: false,
+      error: error.message,
+      timestamp: new Date().toISOString(),
+    });
+  }
+});
+
+apiRoutes.post('/debug/watchlist/refresh', async (req, res) => {
+  try {
+    const loaded = await watchlistService.refresh();
+    res.status(200).json({
+      success: true,
+      message: `Watchlist reloaded with ${loaded} face(s)`,
+      data: watchlistService.getStats(),
+      timestamp: new Date().toISOString(),
+    });
+  } catch (error: any) {
+    console.error('❌ Manual watchlist refresh failed:', error);
+    res.status(500).json({
+      success: false,
+      error: error.message,
+      timestamp: new Date().toISOString(),
+    });
+  }
+});
+
 apiRoutes.post('/debug/face-index/rebuild', async (req, res) => {
   try {
     console.log('🔄 Manual ANN index rebuild requested via API');
@@ -302,4 +340,85 @@ apiRoutes.post('/debug/face-index/threshold', async (req, res) => {
       timestamp: new Date().toISOString(),
     });
   }
+});
+
+// Gallery replication for warm standbys (FACE_INDEX_PRIMARY_URL on the standby). Enabled by setting
+// FACE_INDEX_REPLICATION_TOKEN on both nodes; the standby sends it in the x-replication-token header.
+const requireReplicationToken = (req: Request, res: Response, next: NextFunction) => {
+  const token = process.env.FACE_INDEX_REPLICATION_TOKEN;
+  if (!token) {
+    return res.status(404).json({
+      success: false,
+      error: 'Face index replication is disabled',
+      timestamp: new Date().toISOString(),
+    });
+  }
+  const given = Buffer.from(String(req.headers['x-replication-token'] || ''));
+  const expected = Buffer.from(token);
+  if (given.length !== expected.length || !timingSafeEqual(given, expected)) {
+    return res.status(401).json({
+      success: false,
+      error: 'Invalid replication token',
+      timestamp: new Date().toISOString(),
+    });
+  }
+  next();
+};
+
+apiRoutes.get('/face-index/replication', requireReplicationToken, (req, res) => {
+  res.status(200).json({
+    success: true,
+    data: {
+      role: faceIndexService.isReplica() ? 'replica' : 'primary',
+      galleries: faceIndexService.getReplicationState(),
+    },
+    timestamp: new Date().toISOString(),
+  });
+});
+
+apiRoutes.get('/face-index/replication/:model/snapshot', requireReplicationToken, (req, res) => {
+  const result = faceIndexService.exportSnapshot(req.params.model);
+  if (result.status !== 'ok') {
+    return res.status(404).json({
+      success: false,
+      error: `No native gallery for ${req.params.model}`,
+      timestamp: new Date().toISOString(),
+    });
+  }
+  res.setHeader('X-Gallery-Sequence', String(result.sequence));
+  res.type('application/octet-stream').send(result.data);
+});
+
+// 410 once the changes after `after` have left the primary's log: the standby loads a snapshot instead
+apiRoutes.get('/face-index/replication/:model/delta', requireReplicationToken, (req, res) => {
+  const after = parseInt(String(req.query.after || '0'));
+  const max = parseInt(String(req.query.max || '1024'));
+  const result = faceIndexService.exportDelta(req.params.model, after, max);
+  if (result.status === 'not_found') {
+    return res.status(404).json({
+      success: false,
+      error: `No native gallery for ${req.params.model}`,
+      timestamp: new Date().toISOString(),
+    });
+  }
+  if (result.status === 'stale') {
+    return res.status(410).json({
+      success: false,
+      error: 'Changes are no longer in the log; load a snapshot',
+      timestamp: new Date().toISOString(),
+    });
+  }
+  res.setHeader('X-Gallery-Sequence', String(result.sequence));
+  res.type('application/octet-stream').send(result.data);
+});
+
+// Failover: the standby stops following its primary and keeps serving from its galleries
+apiRoutes.post('/face-index/replication/promote', requireReplicationToken, (req, res) => {
+  const promoted = faceIndexService.promote();
+  res.status(promoted ? 200 : 409).json({
+    success: promoted,
+    message: promoted ? 'Promoted to primary' : 'This node is not a standby',
+    data: faceIndexService.getStats().replication,
+    timestamp: new Date().toISOString(),
+  });
 });
\ No newline at end of file
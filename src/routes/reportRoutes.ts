@@ -14,4 +14,5 @@ reportRoutes.use(organizationAccess);
 
 // Organization-filtered routes
 reportRoutes.get('/attendance-frequency', reportController.getAttendanceFrequencyReport);
-reportRoutes.get('/event-frequency', reportController.getEventFrequencyReport);
\ No newline at end of file
+reportRoutes.get('/event-frequency', reportController.getEventFrequencyReport);
+reportRoutes.get('/face-search', reportController.getFaceSearchReport);
\ No newline at end of file
@@ -30,6 +30,7 @@ router.get('/face-recognition/camera/:cameraId/status', authorize(['admin', 'ope
 
 // Legacy face recognition routes (for existing video streams)
 router.get('/face-recognition/health', authorize(['admin']), streamController.getFaceRecognitionHealth);
+router.post('/face-recognition/profile', authorize(['admin']), streamController.profileFaceRecognition);
 router.get('/face-recognition/sessions', authorize(['admin', 'operator']), streamController.getActiveFaceRecognitionSessions);
 router.post('/face-recognition/enable/:sessionId', authorize(['admin', 'operator']), streamController.enableFaceRecognition);
 router.post('/face-recognition/disable/:sessionId', authorize(['admin', 'operator']), streamController.disableFaceRecognition);
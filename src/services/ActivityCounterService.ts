@@ -0,0 +1,317 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import { DetectionRepository } from '../repositories';
+import { Detection } from '../entities';
+
+export type ActivityScope = 'organization' | 'camera' | 'event' | 'person';
+export type ActivityGranularity = 'minute' | 'hour' | 'day';
+
+// Native rolling counters (src/native/rolling_counters.h)
+interface NativeRollingCounters {
+  add(increments: Array<{
+    organizationId: number;
+    atMs: number;
+    cameraId?: number;
+    eventId?: number;
+    personId?: number;
+    count?: number;
+    recognized?: boolean;
+  }>): void;
+  snapshot(query: {
+    organizationId: number;
+    granularity?: ActivityGranularity;
+    buckets?: number;
+    endMs?: number;
+    scopes?: ActivityScope[];
+  }): {
+    firstBucketMs: number;
+    bucketMs: number;
+    buckets: number;
+    series: Array<{ scope: ActivityScope; id: number; counts: Uint32Array; recognized: Uint32Array; total: number; recognizedTotal: number }>;
+  };
+  save(path: string, callback: (err: Error | null) => void): void;
+  load(path: string): boolean;
+  getStats(): {
+    series: number;
+    organizations: number;
+    memoryBytes: number;
+    increments: number;
+    late: number;
+    dropped: number;
+    latestMs: number;
+    saves: number;
+    loads: number;
+  };
+  close(): void;
+}
+
+/**
+ * A detection as counted: when, where, and who it matched
+ */
+export interface ActivityDetection {
+  detectedAt: Date;
+  organizationId: number;
+  cameraId?: number;
+  eventId?: number;
+  personId?: number; // Person (not PersonFace) the detection matched
+  recognized: boolean;
+}
+
+export interface ActivitySeries {
+  scope: ActivityScope;
+  id: number;
+  counts: number[]; // Oldest bucket first
+  recognized: number[];
+  total: number;
+  recognizedTotal: number;
+}
+
+export interface ActivitySnapshot {
+  granularity: ActivityGranularity;
+  firstBucket: string;
+  bucketMs: number;
+  series: ActivitySeries[];
+}
+
+const DAY_MS = 24 * 60 * 60 * 1000;
+const HOUR_MS = 60 * 60 * 1000;
+
+/**
+ * Rolling detection counters for dashboards. Every recorded detection bumps
+ * minute, hour and day buckets for its organization, camera, event and person in
+ * a native structure, so dashboard numbers come from one in-memory snapshot
+ * instead of counting the detections table. The counters are saved to disk
+ * periodically and on shutdown. On start they are loaded back and caught up from
+ * detections newer than the last one counted; without a saved file they are
+ * seeded from the last ACTIVITY_COUNTERS_DAYS days of detections. Until then
+ * isReady() is false and callers query the database instead.
+ */
+export class ActivityCounterService {
+  private counters: NativeRollingCounters | null = null;
+  private detectionRepository: DetectionRepository;
+  private ready = false;
+  private starting: Promise<void> | null = null;
+  private saveTimer: NodeJS.Timeout | null = null;
+  private saving: Promise<void> | null = null;
+  private caughtUp = 0;
+  private readonly countersPath = process.env.ACTIVITY_COUNTERS_PATH || path.join(process.cwd(), 'data', 'activity.counters');
+  private readonly saveIntervalMs = parseInt(process.env.ACTIVITY_COUNTERS_SAVE_MS || '60000');
+  private readonly days = parseInt(process.env.ACTIVITY_COUNTERS_DAYS || '90');
+  private readonly catchUpBatch = 5000;
+
+  constructor() {
+    this.detectionRepository = new DetectionRepository();
+    if (process.env.ACTIVITY_COUNTERS === 'false') {
+      return;
+    }
+    try {
+      const nativeModulePath = path.join(process.cwd(), 'build', 'Release', 'face_detector.node');
+      const { RollingCounters } = require(nativeModulePath);
+      this.counters = new RollingCounters({
+        dayBuckets: this.days,
+        // Day buckets start at local midnight; a saved file from another offset (e.g. across DST) is reseeded
+        utcOffsetMinutes: -new Date().getTimezoneOffset(),
+        maxSeries: parseInt(process.env.ACTIVITY_COUNTERS_MAX_SERIES || '50000'),
+      });
+    } catch (error: any) {
+      // Without the native module the dashboard counts from the database
+      this.counters = null;
+    }
+  }
+
+  public isAvailable(): boolean {
+    return this.counters !== null;
+  }
+
+  /**
+   * True once the counters cover every stored detection
+   */
+  public isReady(): boolean {
+    return this.ready;
+  }
+
+  /**
+   * Loads the saved counters and counts detections stored since, in the background of startup.
+   * Call after the detection journal has replayed, before streams start recording.
+   */
+  public start(): Promise<void> {
+    if (!this.counters) {
+      return Promise.resolve();
+    }
+    if (!this.starting) {
+      this.starting = this.loadAndCatchUp().catch(error => {
+        console.error('❌ Activity counters catch-up failed; the dashboard keeps counting from the database:', error);
+      });
+    }
+    return this.starting;
+  }
+
+  private async loadAndCatchUp(): Promise<void> {
+    const startTime = Date.now();
+    // Streams start after this point, so everything up to now comes from the database and nothing is counted twice
+    const until = new Date(startTime);
+    let since = new Date(startTime - this.days * DAY_MS);
+    if (this.counters!.load(this.countersPath)) {
+      since = new Date(Math.max(since.getTime(), this.counters!.getStats().latestMs));
+    }
+
+    let lastId = 0;
+    for (;;) {
+      // Entities rather than raw rows, so detectedAt is parsed the same way on every database
+      const rows: Detection[] = await this.detectionRepository.getRepository()
+        .createQueryBuilder('detection')
+        .leftJoin('detection.personFace', 'personFace')
+        .select([
+          'detection.id', 'detection.detectedAt', 'detection.organizationId', 'detection.cameraId',
+          'detection.eventId', 'detection.faceStatus', 'personFace.id', 'personFace.personId',
+        ])
+        .where('detection.id > :lastId', { lastId })
+        .andWhere('detection.detectedAt > :since', { since })
+        .andWhere('detection.detectedAt <= :until', { until })
+        .orderBy('detection.id', 'ASC')
+        .limit(this.catchUpBatch) // Many-to-one join: one row per detection, so a plain LIMIT pages correctly
+        .getMany();
+
+      this.counters!.add(rows.map(row => ({
+        organizationId: row.organizationId,
+        atMs: new Date(row.detectedAt).getTime(),
+        cameraId: row.cameraId ?? undefined,
+        eventId: row.eventId,
+        personId: row.personFace?.personId,
+        recognized: row.faceStatus === 'recognized',
+      })));
+      this.caughtUp += rows.length;
+      if (rows.length > 0) {
+        lastId = rows[rows.length - 1].id;
+      }
+      if (rows.length < this.catchUpBatch) {
+        break;
+      }
+    }
+
+    this.ready = true;
+    this.saveTimer = setInterval(() => {
+      this.save().catch(error => console.error('❌ Activity counters save failed:', error));
+    }, this.saveIntervalMs);
+    const stats = this.counters!.getStats();
+    console.log(`📈 Activity counters ready: ${stats.series} series, ${this.caughtUp} detection(s) counted from the database in ${Date.now() - startTime}ms`);
+  }
+
+  /**
+   * Counts a frame's detections. Detections recorded before start() has caught up are counted too.
+   */
+  public record(detections: ActivityDetection[]): void {
+    if (!this.counters || detections.length === 0) {
+      return;
+    }
+    this.counters.add(detections.map(detection => ({
+      organizationId: detection.organizationId,
+      atMs: detection.detectedAt.getTime(),
+      cameraId: detection.cameraId,
+      eventId: detection.eventId,
+      personId: detection.personId,
+      recognized: detection.recognized,
+    })));
+  }
+
+  /**
+   * Every series of an organization over the last `buckets` buckets, in one native call
+   */
+  public snapshot(
+    organizationId: number,
+    granularity: ActivityGranularity = 'hour',
+    buckets = 24,
+    scopes?: ActivityScope[]
+  ): ActivitySnapshot | null {
+    if (!this.counters || !this.ready) {
+      return null;
+    }
+    const native = this.counters.snapshot({ organizationId, granularity, buckets, scopes });
+    return {
+      granularity,
+      firstBucket: new Date(native.firstBucketMs).toISOString(),
+      bucketMs: native.bucketMs,
+      series: native.series.map(series => ({
+        scope: series.scope,
+        id: series.id,
+        counts: Array.from(series.counts),
+        recognized: Array.from(series.recognized),
+        total: series.total,
+        recognizedTotal: series.recognizedTotal,
+      })),
+    };
+  }
+
+  /**
+   * Detections since local midnight, and over the same stretch of yesterday (to the hour)
+   */
+  public getTodayComparison(organizationId: number): { today: number; yesterday: number } | null {
+    if (!this.counters || !this.ready) {
+      return null;
+    }
+    const now = Date.now();
+    const days = this.counters.snapshot({ organizationId, granularity: 'day', buckets: 1, endMs: now, scopes: ['organization'] });
+    const hours = this.counters.snapshot({ organizationId, granularity: 'hour', buckets: 48, endMs: now, scopes: ['organization'] });
+    const todayCounts = days.series[0]?.counts;
+    const hourCounts = hours.series[0]?.counts;
+    if (!todayCounts || !hourCounts) {
+      return { today: 0, yesterday: 0 };
+    }
+
+    // Yesterday from midnight through the hour matching the current one
+    const yesterdayStart = days.firstBucketMs - DAY_MS;
+    const from = Math.round((yesterdayStart - hours.firstBucketMs) / HOUR_MS);
+    const to = from + Math.floor((now - days.firstBucketMs) / HOUR_MS);
+    let yesterday = 0;
+    for (let i = Math.max(0, from); i <= to && i < hourCounts.length; i++) {
+      yesterday += hourCounts[i];
+    }
+    return { today: todayCounts[0], yesterday };
+  }
+
+  /**
+   * Writes the counters to disk off the event loop; concurrent calls share the save in progress
+   */
+  public save(): Promise<void> {
+    if (!this.counters || !this.ready) {
+      return Promise.resolve();
+    }
+    if (!this.saving) {
+      const counters = this.counters;
+      this.saving = new Promise<void>((resolve, reject) => {
+        fs.mkdirSync(path.dirname(this.countersPath), { recursive: true });
+        counters.save(this.countersPath, error => (error ? reject(error) : resolve()));
+      }).finally(() => {
+        this.saving = null;
+      });
+    }
+    return this.saving;
+  }
+
+  /**
+   * Saves a last time and stops the periodic saves
+   */
+  public async close(): Promise<void> {
+    if (this.saveTimer) {
+      clearInterval(this.saveTimer);
+      this.saveTimer = null;
+    }
+    try {
+      await this.save();
+    } catch (error) {
+      console.error('❌ Activity counters save failed:', error);
+    }
+  }
+
+  public getStats(): { available: boolean; ready: boolean; caughtUp: number } & Partial<ReturnType<NativeRollingCounters['getStats']>> {
+    return {
+      available: this.isAvailable(),
+      ready: this.ready,
+      caughtUp: this.caughtUp,
+      ...(this.counters ? this.counters.getStats() : {}),
+    };
+  }
+}
+
+// Export singleton instance
+export const activityCounterService = new ActivityCounterService();
@@ -0,0 +1,265 @@
+import { frameExtractionService } from './FrameExtractionService';
+import { nativeFaceDetectionService } from './NativeFaceDetectionService';
+
+export type PipelineStartKind = 'warm' | 'cold' | 'reused';
+
+interface CameraPipeline {
+  cameraId: number;
+  organizationId: number;
+  rtspUrl: string;
+  sessionId: string;
+  state: 'standby' | 'active';
+  eventId?: number;
+  createdAt: Date;
+  releaseTimer?: NodeJS.Timeout;
+}
+
+export interface CameraPipelinePoolStats {
+  pipelines: number;
+  standby: number;
+  active: number;
+  dedicated: number;    // Sessions of events overlapping the one a camera's pipeline is recording
+  warmStarts: number;   // Event started on a pipeline pre-warmed for it
+  coldStarts: number;   // Event started with no pipeline running for the camera
+  reusedStarts: number; // Event started on a pipeline kept alive after another event
+  dedicatedStarts: number; // Event started on its own session while the camera's pipeline recorded another event
+  prewarms: number;
+  expired: number;      // Standby pipelines torn down after the keep-alive
+  lastWarmUpMs: number;
+}
+
+// Frames ffmpeg scales to for face recognition (see FrameExtractionService)
+const PIPELINE_FRAME_WIDTH = 1280;
+const PIPELINE_FRAME_HEIGHT = 720;
+const PIPELINE_FRAME_INTERVAL = 10; // Seconds between extracted frames
+
+/**
+ * One face recognition pipeline per camera, shared by the events that use it.
+ * The scheduler pre-warms a camera's pipeline ahead of an event's start: ffmpeg
+ * connects and decodes in standby (frames are dropped), and the native detector
+ * prepares a network replica per running pipeline. When the event starts the
+ * pipeline is switched to recording instead of being spawned; when it ends the
+ * pipeline goes back to standby for PIPELINE_KEEP_ALIVE_MS, so back-to-back
+ * events on the same camera never reconnect. An event that overlaps the one a
+ * pipeline is recording gets a session of its own for its duration instead of
+ * taking the pipeline over, so both events keep recording.
+ */
+export class CameraPipelinePool {
+  private static instance: CameraPipelinePool;
+  private pipelines: Map<number, CameraPipeline> = new Map();
+  private warming: Map<number, Promise<CameraPipeline | null>> = new Map();
+  private dedicated: Map<string, CameraPipeline> = new Map(); // `${cameraId}:${eventId}` -> session outside the pool
+  private readonly keepAliveMs = parseInt(process.env.PIPELINE_KEEP_ALIVE_MS || '600000');
+  private stats = { warmStarts: 0, coldStarts: 0, reusedStarts: 0, dedicatedStarts: 0, prewarms: 0, expired: 0, lastWarmUpMs: 0 };
+
+  public static getInstance(): CameraPipelinePool {
+    if (!CameraPipelinePool.instance) {
+      CameraPipelinePool.instance = new CameraPipelinePool();
+    }
+    return CameraPipelinePool.instance;
+  }
+
+  /**
+   * Start a camera's pipeline in standby so an upcoming event starts warm. No-op if it is already running.
+   */
+  public async prewarm(cameraId: number, organizationId: number, rtspUrl: string): Promise<void> {
+    if (this.pipelines.has(cameraId) || this.warming.has(cameraId)) {
+      return;
+    }
+    const pipeline = await this.startPipeline(cameraId, organizationId, rtspUrl, true);
+    if (pipeline) {
+      this.stats.prewarms++;
+      this.scheduleRelease(pipeline);
+      console.log(`🔥 Pre-warmed pipeline for camera ${cameraId}`);
+    }
+  }
+
+  /**
+   * Start recording a camera's frames for an event, reusing its pipeline if one is running.
+   * Returns the frame extraction session ID and how the pipeline was obtained.
+   */
+  public async acquire(
+    cameraId: number,
+    organizationId: number,
+    rtspUrl: string,
+    eventId: number
+  ): Promise<{ sessionId: string; start: PipelineStartKind }> {
+    const pending = this.warming.get(cameraId);
+    if (pending) {
+      await pending;
+    }
+
+    let pipeline = this.pipelines.get(cameraId);
+    let start: PipelineStartKind;
+    if (pipeline && (pipeline.rtspUrl !== rtspUrl || !frameExtractionService.isActive(pipeline.sessionId))) {
+      // Camera reconfigured or ffmpeg died: start over
+      this.teardown(pipeline);
+      pipeline = undefined;
+    }
+
+    if (pipeline && pipeline.state === 'active' && pipeline.eventId !== eventId) {
+      // The pipeline is recording another event: taking it over would stop that event's recording
+      return this.acquireDedicated(cameraId, organizationId, rtspUrl, eventId);
+    }
+
+    if (!pipeline) {
+      pipeline = await this.startPipeline(cameraId, organizationId, rtspUrl, false);
+      if (!pipeline) {
+        throw new Error(`Could not start pipeline for camera ${cameraId}`);
+      }
+      start = 'cold';
+      this.stats.coldStarts++;
+    } else if (pipeline.eventId === undefined) {
+      start = 'warm';
+      this.stats.warmStarts++;
+    } else {
+      start = 'reused';
+      this.stats.reusedStarts++;
+    }
+
+    if (pipeline.releaseTimer) {
+      clearTimeout(pipeline.releaseTimer);
+      pipeline.releaseTimer = undefined;
+    }
+    pipeline.organizationId = organizationId;
+    pipeline.eventId = eventId;
+    pipeline.state = 'active';
+    frameExtractionService.activateSession(pipeline.sessionId, eventId);
+
+    console.log(`🎬 Camera ${cameraId} pipeline ${start} start for event ${eventId}`);
+    return { sessionId: pipeline.sessionId, start };
+  }
+
+  /**
+   * Stop recording for an event and keep the pipeline in standby for the next one.
+   * An event's own session (see acquire) is stopped instead.
+   */
+  public release(cameraId: number, eventId: number): void {
+    const key = `${cameraId}:${eventId}`;
+    const dedicated = this.dedicated.get(key);
+    if (dedicated) {
+      this.dedicated.delete(key);
+      frameExtractionService.stopFrameExtraction(dedicated.sessionId);
+      return;
+    }
+
+    const pipeline = this.pipelines.get(cameraId);
+    if (!pipeline || pipeline.state !== 'active' || pipeline.eventId !== eventId) {
+      return;
+    }
+    frameExtractionService.standbySession(pipeline.sessionId);
+    pipeline.state = 'standby';
+    this.scheduleRelease(pipeline);
+  }
+
+  /**
+   * Tear down every pipeline
+   */
+  public shutdown(): void {
+    for (const pipeline of Array.from(this.pipelines.values())) {
+      this.teardown(pipeline);
+    }
+    for (const pipeline of Array.from(this.dedicated.values())) {
+      frameExtractionService.stopFrameExtraction(pipeline.sessionId);
+    }
+    this.dedicated.clear();
+  }
+
+  public getStats(): CameraPipelinePoolStats {
+    const pipelines = Array.from(this.pipelines.values());
+    return {
+      pipelines: pipelines.length,
+      standby: pipelines.filter(pipeline => pipeline.state === 'standby').length,
+      active: pipelines.filter(pipeline => pipeline.state === 'active').length,
+      dedicated: this.dedicated.size,
+      ...this.stats,
+    };
+  }
+
+  private async acquireDedicated(
+    cameraId: number,
+    organizationId: number,
+    rtspUrl: string,
+    eventId: number
+  ): Promise<{ sessionId: string; start: PipelineStartKind }> {
+    const key = `${cameraId}:${eventId}`;
+    let pipeline = this.dedicated.get(key);
+    if (!pipeline || !frameExtractionService.isActive(pipeline.sessionId)) {
+      const sessionId = `pipeline-camera-${cameraId}-event-${eventId}-${Date.now()}`;
+      await frameExtractionService.startFrameExtraction(
+        sessionId, cameraId, organizationId, rtspUrl, PIPELINE_FRAME_INTERVAL, { eventId }
+      );
+      pipeline = { cameraId, organizationId, rtspUrl, sessionId, state: 'active', eventId, createdAt: new Date() };
+      this.dedicated.set(key, pipeline);
+      this.stats.dedicatedStarts++;
+    }
+
+    console.log(`🎬 Camera ${cameraId} pipeline busy with event ${this.pipelines.get(cameraId)?.eventId}, event ${eventId} on its own session`);
+    return { sessionId: pipeline.sessionId, start: 'cold' };
+  }
+
+  private startPipeline(
+    cameraId: number,
+    organizationId: number,
+    rtspUrl: string,
+    standby: boolean
+  ): Promise<CameraPipeline | null> {
+    const starting = (async () => {
+      const sessionId = `pipeline-camera-${cameraId}-${Date.now()}`;
+      try {
+        await frameExtractionService.startFrameExtraction(
+          sessionId, cameraId, organizationId, rtspUrl, PIPELINE_FRAME_INTERVAL, { standby }
+        );
+      } catch (error) {
+        console.error(`❌ Failed to start pipeline for camera ${cameraId}:`, error);
+        return null;
+      }
+
+      const pipeline: CameraPipeline = {
+        cameraId,
+        organizationId,
+        rtspUrl,
+        sessionId,
+        state: standby ? 'standby' : 'active',
+        createdAt: new Date(),
+      };
+      this.pipelines.set(cameraId, pipeline);
+
+      // One replica per running pipeline, so simultaneous event starts do not parse models on the first frame
+      const warmUpMs = await nativeFaceDetectionService.warmUp(PIPELINE_FRAME_WIDTH, PIPELINE_FRAME_HEIGHT, this.pipelines.size + this.dedicated.size);
+      if (warmUpMs !== null) {
+        this.stats.lastWarmUpMs = warmUpMs;
+      }
+      return pipeline;
+    })();
+
+    this.warming.set(cameraId, starting);
+    return starting.finally(() => this.warming.delete(cameraId));
+  }
+
+  private scheduleRelease(pipeline: CameraPipeline): void {
+    if (pipeline.releaseTimer) {
+      clearTimeout(pipeline.releaseTimer);
+    }
+    pipeline.releaseTimer = setTimeout(() => {
+      if (pipeline.state === 'standby' && this.pipelines.get(pipeline.cameraId) === pipeline) {
+        this.stats.expired++;
+        console.log(`💤 Camera ${pipeline.cameraId} pipeline idle for ${Math.round(this.keepAliveMs / 1000)}s, stopping`);
+        this.teardown(pipeline);
+      }
+    }, this.keepAliveMs);
+  }
+
+  private teardown(pipeline: CameraPipeline): void {
+    if (pipeline.releaseTimer) {
+      clearTimeout(pipeline.releaseTimer);
+    }
+    frameExtractionService.stopFrameExtraction(pipeline.sessionId);
+    if (this.pipelines.get(pipeline.cameraId) === pipeline) {
+      this.pipelines.delete(pipeline.cameraId);
+    }
+  }
+}
+
+// Export singleton instance
+export const cameraPipelinePool = CameraPipelinePool.getInstance();
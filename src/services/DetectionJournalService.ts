@@ -0,0 +1,237 @@
+import * as path from 'path';
+import * as fs from 'fs';
+import { DeepPartial } from 'typeorm';
+import { DetectionService } from './index';
+import { Detection } from '../entities';
+
+/**
+ * One face detection as recorded by processVideoFrame, before it reaches the database.
+ */
+export interface JournalDetection {
+  detectedAt: Date;
+  organizationId: number;
+  cameraId: number;
+  eventId: number;
+  trackId?: number;
+  personFaceId?: number;
+  similarity: number;
+  confidence: number;
+  boundingBox: { x: number; y: number; width: number; height: number };
+  faceStatus: 'unrecognized' | 'detected' | 'recognized';
+  detectionStatus: 'pending' | 'confirmed';
+  embedding?: number[];
+  embeddingModel?: string;
+  cropRef?: string; // Face crop URL
+  metadata?: string; // JSON
+}
+
+export interface DetectionJournalStats {
+  available: boolean;
+  capacity: number;
+  usedBytes: number;
+  lastSeq: number;
+  committedSeq: number;
+  appended: number;
+  rejected: number;
+  recovered: number;
+  compactions: number;
+  epoch: string;
+  drained: number;
+  skipped: number;
+  batches: number;
+  lastBatchSize: number;
+  lastBatchMs: number;
+}
+
+const FACE_STATUSES = ['unrecognized', 'detected', 'recognized'] as const;
+const DETECTION_STATUSES = ['pending', 'confirmed'] as const;
+
+/**
+ * Write-behind for detections. Frames append their detections to the native,
+ * memory-mapped journal (a memory copy, no database round trip); a drain loop
+ * moves them to the detections table in batches, one transaction each, and then
+ * advances the journal watermark. Records written before a crash are replayed on
+ * the next start; the unique (journal_epoch, journal_seq) pair keeps the replay
+ * idempotent. The epoch is random per journal file, so a new or replaced file,
+ * whose seq restarts at 1, or another node's journal never collides with rows
+ * already stored.
+ */
+export class DetectionJournalService {
+  private journal: any = null;
+  private epoch = '';
+  private detectionService: DetectionService;
+  private drainTimer: NodeJS.Timeout | null = null;
+  private draining: Promise<void> | null = null;
+  private undrained = 0;
+  private readonly journalPath = process.env.DETECTION_JOURNAL_PATH || path.join(process.cwd(), 'data', 'detections.journal');
+  private readonly capacityBytes = parseInt(process.env.DETECTION_JOURNAL_MB || '64') * 1024 * 1024;
+  private readonly batchSize = parseInt(process.env.DETECTION_JOURNAL_BATCH || '500');
+  private readonly drainIntervalMs = parseInt(process.env.DETECTION_JOURNAL_DRAIN_MS || '1000');
+  private drainStats = { drained: 0, skipped: 0, batches: 0, lastBatchSize: 0, lastBatchMs: 0 };
+
+  constructor() {
+    this.detectionService = new DetectionService();
+    if (process.env.DETECTION_JOURNAL === 'false') {
+      return;
+    }
+    try {
+      const nativeModulePath = path.join(process.cwd(), 'build', 'Release', 'face_detector.node');
+      const nativeModule = require(nativeModulePath);
+      fs.mkdirSync(path.dirname(this.journalPath), { recursive: true });
+      this.journal = new nativeModule.DetectionJournal(this.journalPath, this.capacityBytes);
+      this.epoch = this.journal.getStats().epoch;
+    } catch (error: any) {
+      // Without the native module detections are written directly
+      this.journal = null;
+    }
+  }
+
+  public isAvailable(): boolean {
+    return this.journal !== null;
+  }
+
+  /**
+   * Replays anything left from the previous run, then drains periodically
+   */
+  public async start(): Promise<void> {
+    if (!this.journal || this.drainTimer) {
+      return;
+    }
+    const { recovered } = this.journal.getStats();
+    if (recovered > 0) {
+      console.log(`📒 Replaying ${recovered} journaled detections from the previous run`);
+    }
+    await this.drain();
+    this.drainTimer = setInterval(() => {
+      this.drain().catch(error => console.error('❌ Detection journal drain failed:', error));
+    }, this.drainIntervalMs);
+  }
+
+  /**
+   * Appends a frame's detections in one call. Returns false when they were not
+   * journaled (no native module, or the journal is full) and the caller should
+   * write them directly.
+   */
+  public append(detections: JournalDetection[]): boolean {
+    if (!this.journal || detections.length === 0) {
+      return false;
+    }
+    const lastSeq = this.journal.append(detections.map(detection => ({
+      detectedAt: detection.detectedAt.getTime(),
+      organizationId: detection.organizationId,
+      cameraId: detection.cameraId,
+      eventId: detection.eventId,
+      trackId: detection.trackId ?? -1,
+      personFaceId: detection.personFaceId ?? -1,
+      similarity: detection.similarity,
+      confidence: detection.confidence,
+      boundingBox: detection.boundingBox,
+      faceStatus: FACE_STATUSES.indexOf(detection.faceStatus),
+      detectionStatus: DETECTION_STATUSES.indexOf(detection.detectionStatus),
+      embedding: detection.embedding ? new Float32Array(detection.embedding) : undefined,
+      embeddingModel: detection.embeddingModel,
+      cropRef: detection.cropRef,
+      metadata: detection.metadata,
+    })));
+
+    if (lastSeq === null) {
+      console.warn('⚠️ Detection journal full - writing detections directly until it drains');
+      this.drain().catch(error => console.error('❌ Detection journal drain failed:', error));
+      return false;
+    }
+
+    this.undrained += detections.length;
+    if (this.undrained >= this.batchSize) {
+      this.drain().catch(error => console.error('❌ Detection journal drain failed:', error));
+    }
+    return true;
+  }
+
+  /**
+   * Moves journaled detections to the database until the journal is empty.
+   * Concurrent calls share the drain in progress.
+   */
+  public drain(): Promise<void> {
+    if (!this.journal) {
+      return Promise.resolve();
+    }
+    if (!this.draining) {
+      this.draining = this.drainBatches().finally(() => {
+        this.draining = null;
+      });
+    }
+    return this.draining;
+  }
+
+  private async drainBatches(): Promise<void> {
+    while (this.journal) {
+      const startTime = Date.now();
+      const batch = this.journal.read(0, this.batchSize);
+      if (batch.records.length === 0) {
+        this.undrained = 0;
+        return;
+      }
+
+      const skipped = await this.detectionService.insertJournalBatch(batch.records.map((record: any) => this.toDetection(record)));
+      if (skipped > 0) {
+        // Expected only when a batch written before a crash is replayed
+        console.warn(`⚠️ Detection journal: ${skipped} of ${batch.records.length} detections (journal ${this.epoch}) were already stored - skipped`);
+        this.drainStats.skipped += skipped;
+      }
+      if (!this.journal) {
+        return; // Closed mid-batch; the uncommitted records are replayed on the next start
+      }
+      this.journal.commit(batch.lastSeq);
+
+      this.undrained = Math.max(0, this.undrained - batch.records.length);
+      this.drainStats.drained += batch.records.length;
+      this.drainStats.batches++;
+      this.drainStats.lastBatchSize = batch.records.length;
+      this.drainStats.lastBatchMs = Date.now() - startTime;
+    }
+  }
+
+  private toDetection(record: any): DeepPartial<Detection> {
+    const embedding = record.embedding as Float32Array;
+    return {
+      journalEpoch: this.epoch,
+      journalSeq: record.seq,
+      detectedAt: new Date(record.detectedAt),
+      confidence: record.similarity,
+      faceStatus: FACE_STATUSES[record.faceStatus] ?? 'unrecognized',
+      detectionStatus: DETECTION_STATUSES[record.detectionStatus] ?? 'pending',
+      imageUrl: record.cropRef || undefined,
+      embedding: embedding.length > 0 ? Buffer.from(embedding.buffer, embedding.byteOffset, embedding.byteLength) : undefined,
+      embeddingModel: record.embeddingModel || undefined,
+      metadata: record.metadata || undefined,
+      eventId: record.eventId,
+      personFaceId: record.personFaceId >= 0 ? record.personFaceId : undefined,
+      cameraId: record.cameraId >= 0 ? record.cameraId : undefined,
+      organizationId: record.organizationId,
+    };
+  }
+
+  /**
+   * Stops draining and flushes the journal; undrained records wait for the next start
+   */
+  public close(): void {
+    if (this.drainTimer) {
+      clearInterval(this.drainTimer);
+      this.drainTimer = null;
+    }
+    if (this.journal) {
+      this.journal.sync();
+      this.journal.close();
+      this.journal = null;
+    }
+  }
+
+  public getStats(): DetectionJournalStats {
+    const native = this.journal ? this.journal.getStats() : {
+      capacity: 0, usedBytes: 0, lastSeq: 0, committedSeq: 0, appended: 0, rejected: 0, recovered: 0, compactions: 0, epoch: '',
+    };
+    return { available: this.journal !== null, ...native, ...this.drainStats };
+  }
+}
+
+export const detectionJournalService = new DetectionJournalService();
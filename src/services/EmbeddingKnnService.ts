@@ -0,0 +1,96 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import { AppDataSource } from '../config/database';
+
+// Embedding columns searched in SQL: table, blob column, model tag column, partition column
+const SOURCES: Array<[string, string, string, string]> = [
+  ['person_faces', 'embedding', 'embeddingModel', ''],
+  ['detections', 'embedding', 'embeddingModel', 'organization_id'],
+];
+
+// Largest k embedding_knn returns (kMaxK in sqlite_embedding_knn.cpp)
+export const EMBEDDING_KNN_MAX_K = 10000;
+
+/**
+ * Similarity search inside SQLite. On the SQLite deployment the native
+ * embedding_knn extension (src/native/sqlite_embedding_knn.cpp) is loaded into
+ * TypeORM's connection, so reports can use
+ * embedding_knn(table, column, query, k, model, partition) as a table and join
+ * its matches with people, events and cameras in one statement. Embedding
+ * blobs never reach JavaScript. The extension keeps each column's vectors in a
+ * sidecar file next to the database and follows changes through triggers;
+ * sync() registers the columns and prunes the change log, at start and every
+ * EMBEDDING_KNN_SYNC_MS. isReady() is false on PostgreSQL, without the built
+ * extension, or with EMBEDDING_KNN=false, and callers fall back to their
+ * JavaScript path.
+ */
+export class EmbeddingKnnService {
+  private ready = false;
+  private syncTimer: NodeJS.Timeout | null = null;
+  private lastSyncMs = 0;
+  private rows: Record<string, number> = {};
+  private readonly extensionPath = path.join(process.cwd(), 'build', 'Release', 'embedding_knn.node');
+  private readonly syncIntervalMs = parseInt(process.env.EMBEDDING_KNN_SYNC_MS || '300000');
+
+  public isReady(): boolean {
+    return this.ready;
+  }
+
+  /**
+   * Loads the extension into the SQLite connection and registers the embedding columns.
+   * Call after the database is initialized.
+   */
+  public async start(): Promise<void> {
+    if (this.ready || process.env.EMBEDDING_KNN === 'false' || AppDataSource.options.type !== 'sqlite') {
+      return;
+    }
+    if (!fs.existsSync(this.extensionPath)) {
+      console.log('⚠️ embedding_knn SQLite extension not built - similarity reports score in JavaScript');
+      return;
+    }
+    try {
+      // TypeORM's sqlite driver keeps a single node-sqlite3 connection
+      const database = (AppDataSource.driver as any).databaseConnection;
+      await new Promise<void>((resolve, reject) => {
+        database.loadExtension(this.extensionPath, (error: Error | null) => (error ? reject(error) : resolve()));
+      });
+      await this.sync();
+      this.ready = true;
+      this.syncTimer = setInterval(() => {
+        this.sync().catch(error => console.error('❌ embedding_knn sync failed:', error));
+      }, this.syncIntervalMs);
+      console.log(`✅ embedding_knn SQLite extension loaded (${Object.entries(this.rows).map(([source, rows]) => `${source}: ${rows}`).join(', ')})`);
+    } catch (error) {
+      console.error('❌ embedding_knn SQLite extension failed to load; similarity reports score in JavaScript:', error);
+    }
+  }
+
+  /**
+   * Brings every registered column's vectors up to date and prunes the change log they cover
+   */
+  public async sync(): Promise<void> {
+    const startTime = Date.now();
+    for (const [table, column, modelColumn, partitionColumn] of SOURCES) {
+      const result = await AppDataSource.query(
+        'SELECT embedding_knn_sync(?, ?, ?, ?) AS rows',
+        [table, column, modelColumn, partitionColumn]
+      );
+      this.rows[`${table}.${column}`] = Number(result[0]?.rows ?? 0);
+    }
+    this.lastSyncMs = Date.now() - startTime;
+  }
+
+  public stop(): void {
+    if (this.syncTimer) {
+      clearInterval(this.syncTimer);
+      this.syncTimer = null;
+    }
+  }
+
+  public getStats(): { ready: boolean; rows: Record<string, number>; lastSyncMs: number } {
+    return { ready: this.ready, rows: { ...this.rows }, lastSyncMs: this.lastSyncMs };
+  }
+}
+
+// Export singleton instance
+export const embeddingKnnService = new EmbeddingKnnService();
@@ -1,6 +1,6 @@
 import { EventService, CameraService } from './index';
 import { streamService } from './StreamService';
-import { frameExtractionService } from './FrameExtractionService';
+import { cameraPipelinePool } from './CameraPipelinePool';
 import { Event, EventCamera } from '../entities';
 import { EventCameraRepository } from '../repositories';
 
@@ -30,6 +30,7 @@ export class EventSchedulerService {
   private checkInterval: NodeJS.Timeout | null = null;
   private activeSessions: Map<string, ActiveEventSession> = new Map();
   private readonly checkIntervalMs = 30000; // Check every 30 seconds for better responsiveness
+  private readonly prewarmLeadMs = parseInt(process.env.PIPELINE_PREWARM_LEAD_MS || '120000'); // Start camera pipelines this long before an event
 
   // Event loop protection
   private isProcessingEvents = false;
@@ -180,6 +181,30 @@ export class EventSchedulerService {
     } else if (!shouldBeActive && isCurrentlyActive) {
       console.log(`🛑 Stopping event execution for "${event.name}"`);
       await this.stopEventExecution(event.id);
+    } else if (!shouldBeActive && this.prewarmLeadMs > 0 &&
+               this.shouldEventBeActive(event, new Date(now.getTime() + this.prewarmLeadMs))) {
+      await this.prewarmEventCameras(event);
+    }
+  }
+
+  /**
+   * Pre-warm the pipelines of an event that starts within the lead time
+   */
+  private async prewarmEventCameras(event: Event): Promise<void> {
+    const eventCameras = await this.getEventCameras(event.id, event.organizationId);
+    for (const eventCamera of eventCameras) {
+      if (!eventCamera.isActive) {
+        continue;
+      }
+      try {
+        const camera = await this.cameraService.findById(eventCamera.cameraId);
+        if (camera && camera.streamUrl) {
+          console.log(`🔥 Pre-warming camera ${camera.id} for event "${event.name}"`);
+          await cameraPipelinePool.prewarm(camera.id, event.organizationId, this.buildRtspUrl(camera));
+        }
+      } catch (error) {
+        console.error(`Error pre-warming camera ${eventCamera.cameraId} for event ${event.id}:`, error);
+      }
     }
   }
 
@@ -377,19 +402,14 @@ export class EventSchedulerService {
       );
       console.log(`✅ Video stream started with session ID: ${sessionId}`);
 
-      // Start independent facial recognition for the event
-      const faceRecSessionId = `event-${event.id}-camera-${cameraId}-${Date.now()}`;
-      console.log(`🧠 Starting facial recognition with session ID: ${faceRecSessionId}`);
-      console.log(`🧠 Parameters: cameraId=${cameraId}, organizationId=${event.organizationId}, rtspUrl=${rtspUrl}, frameInterval=10`);
-
-      await frameExtractionService.startFrameExtraction(
-        faceRecSessionId,
+      // Start facial recognition on the camera's pipeline (pre-warmed or kept from a previous event when possible)
+      const { sessionId: faceRecSessionId, start } = await cameraPipelinePool.acquire(
         cameraId,
         event.organizationId,
         rtspUrl,
-        10 // frameInterval in seconds - increased for better performance
+        event.id
       );
-      console.log(`✅ Facial recognition started successfully!`);
+      console.log(`✅ Facial recognition started successfully (${start} start, session ${faceRecSessionId})`);
 
       // Track the active session
       const sessionKey = `${event.id}-${cameraId}`;
@@ -422,8 +442,8 @@ export class EventSchedulerService {
     }
 
     try {
-      // Stop facial recognition independently
-      frameExtractionService.stopFrameExtraction(session.faceRecognitionSessionId);
+      // Stop facial recognition independently; the pipeline stays in standby for the next event
+      cameraPipelinePool.release(session.cameraId, session.eventId);
       console.log(`Stopped facial recognition for camera ${session.cameraId} for event "${session.eventName}"`);
     } catch (error) {
       console.error(`Error stopping facial recognition session ${session.faceRecognitionSessionId}:`, error);
@@ -479,6 +499,7 @@ export class EventSchedulerService {
       this.stopCameraSession(session);
     }
     this.activeSessions.clear();
+    cameraPipelinePool.shutdown();
   }
 
   /**
@@ -584,6 +605,8 @@ export class EventSchedulerService {
       checkInterval: this.checkIntervalMs,
       uptime: process.uptime(),
       lastCheck: new Date(this.lastEventCheck).toISOString(),
+      prewarmLeadMs: this.prewarmLeadMs,
+      pipelines: cameraPipelinePool.getStats(),
       performance: {
         isProcessingEvents: this.isProcessingEvents,
         cacheSize: this.eventCache.size,
@@ -1,3 +1,6 @@
+import * as http from 'http';
+import * as https from 'https';
+import * as path from 'path';
 import { HierarchicalNSW } from 'hnswlib-node';
 import { PersonFaceRepository } from '../repositories';
 import { PersonFace } from '../entities';
@@ -6,26 +9,215 @@ interface IndexedFace {
   id: number;
   personId: number;
   personName: string;
-  embedding: Float32Array;
+  embedding?: Float32Array; // Not kept for faces replicated from a primary
   reliability: number;
 }
 
+// Face metadata stored with each native gallery row and replicated with it, so a standby needs no DB reads
+interface ReplicatedFace {
+  personId: number;
+  personName: string;
+  reliability: number;
+}
+
+// A serialized delta or snapshot; `sequence` is the last change it carries
+interface NativeBlob {
+  data: Buffer;
+  sequence: number;
+}
+
+// A change a replica took from its primary; payload is the ReplicatedFace JSON given to add()
+interface NativeChange {
+  op: 'add' | 'update' | 'remove';
+  id: number;
+  payload: string;
+}
+
+// Native gallery (src/native/embedding_gallery.h): binary-code prefilter, exact float rerank
+interface NativeEmbeddingGallery {
+  add(id: number, embedding: Float32Array, payload?: string): boolean;
+  remove(id: number): boolean;
+  search(query: Float32Array, options?: NativeSearchOptions): Array<{ id: number; similarity: number; hamming: number }>;
+  searchWithReport(query: Float32Array, options?: NativeSearchOptions): {
+    matches: Array<{ id: number; similarity: number; hamming: number }>;
+    report: { depth: number; elapsedMs: number; earlyExit: boolean; budgetExhausted: boolean };
+  };
+  searchBatch(
+    queries: Float32Array[],
+    options: NativeSearchOptions,
+    callback: (err: Error | null, matches: Array<Array<{ id: number; similarity: number; hamming: number }>>) => void
+  ): void;
+  getStats(): {
+    size: number;
+    dimension: number;
+    codeBits: number;
+    vectorBytes: number;
+    codeBytes: number;
+    searches: number;
+    exactSearches: number;
+    rescored: number;
+    batches: number;
+    batchedQueries: number;
+    adaptiveSearches: number;
+    earlyExits: number;
+    budgetStops: number;
+    adaptiveMs: number;
+    epoch: string;
+    sequence: number;
+    oldestLogged: number;
+    logEntries: number;
+    deltasApplied: number;
+    snapshotsLoaded: number;
+  };
+  // Replication: every change has a sequence number; a replica applies the primary's deltas in order
+  sequence(): number;
+  setLogCapacity(entries: number): void;
+  exportDelta(afterSequence: number, maxEntries?: number): NativeBlob | null; // null: log no longer reaches back
+  exportSnapshot(): NativeBlob;
+  applyDelta(data: Buffer): { applied: number; changes: NativeChange[] } | null; // null: needs a snapshot
+  loadSnapshot(data: Buffer): { rows: number; changes: NativeChange[] };
+  close(): void;
+}
+
+// Rerank effort: `rerank` codes scored exactly, or adaptively within `budgetMs`, stopping early on a clear match
+interface NativeSearchOptions {
+  k?: number;
+  rerank?: number;
+  budgetMs?: number;
+  matchThreshold?: number; // Cosine similarity
+  margin?: number;
+  maxRerank?: number;
+}
+
+export interface FaceMatch {
+  personFaceId: number;
+  personId: number;
+  personName: string;
+  similarity: number;
+  reliability: number;
+  isMatch: boolean;
+  embeddingModel: string;
+}
+
+// Standby progress, reported by getStats()
+interface ReplicaStats {
+  promoted: boolean;
+  polls: number;
+  snapshots: number;
+  deltas: number;   // Delta requests applied
+  changes: number;  // Adds, updates and removes taken from the primary
+  errors: number;
+  lastSyncAt: number;
+}
+
+export type ReplicationExport =
+  | { status: 'ok'; data: Buffer; sequence: number }
+  | { status: 'stale' | 'not_found' };
+
+// Searches waiting for a gallery's next batch
+interface PendingSearches {
+  k: number;
+  entries: Array<{ query: Float32Array; resolve: (matches: FaceMatch[]) => void; reject: (error: Error) => void }>;
+  timer: NodeJS.Timeout;
+}
+
+/**
+ * One index per embedding model. Embeddings from different models live in
+ * different vector spaces, so a face is only ever compared against enrolled
+ * faces that were embedded with the same model version. The native gallery is
+ * used when the addon is built; HNSW otherwise.
+ */
+interface Gallery {
+  embeddingModel: string;
+  index?: HierarchicalNSW;
+  native?: NativeEmbeddingGallery;
+  dimension: number;
+  capacity: number;
+  faces: Map<number, IndexedFace>;
+  replicated?: boolean; // Standby: loaded from the primary's snapshot, following its deltas
+}
+
+// Native EmbeddingGallery constructor, or null when the addon is not built or FACE_INDEX_NATIVE=false
+const NativeGallery: (new (dimension: number) => NativeEmbeddingGallery) | null = (() => {
+  if (process.env.FACE_INDEX_NATIVE === 'false') {
+    return null;
+  }
+  try {
+    return require(path.join(process.cwd(), 'build', 'Release', 'face_detector.node')).EmbeddingGallery || null;
+  } catch (error) {
+    return null;
+  }
+})();
+
+// Gallery key for PersonFace rows enrolled before embeddings were tagged with a model
+const LEGACY_GALLERY = 'legacy';
+
+// Models that could have written the legacy rows: the primary recognition model, ArcFace or FaceNet.
+// Tags are "<model>-<width>x<height>@<hash>" (see model_version_tag in face_detector.cpp).
+const LEGACY_MODELS = new Set(['arcface', 'facenet']);
+
+/**
+ * Whether embeddings of this model tag are comparable with legacy (untagged) ones
+ */
+export function isLegacyModel(embeddingModel: string): boolean {
+  return LEGACY_MODELS.has(embeddingModel.split('-')[0]);
+}
+
 export class FaceIndexService {
-  private index: HierarchicalNSW | null = null;
-  private indexedFaces: Map<number, IndexedFace> = new Map();
+  private galleries: Map<string, Gallery> = new Map();
   private personFaceRepository: PersonFaceRepository;
   private isInitialized = false;
   private EMBEDDING_DIMENSION = 512; // Face embedding dimension (FaceNet/ArcFace)
   private SIMILARITY_THRESHOLD = 0.75; // Higher threshold to prevent false positives
+  // Closest binary codes re-scored exactly by the native gallery; 0 = exact scan
+  private readonly RERANK = parseInt(process.env.FACE_INDEX_RERANK || '256');
+  // Per-query latency budget for the native rerank: hard queries (no clear match) may rescore up to
+  // FACE_INDEX_MAX_RERANK codes within it; a match this far above the threshold ends the search early
+  private readonly BUDGET_MS = parseFloat(process.env.FACE_INDEX_BUDGET_MS || '5');
+  private readonly MAX_RERANK = parseInt(process.env.FACE_INDEX_MAX_RERANK || '4096');
+  private readonly EARLY_EXIT_MARGIN = parseFloat(process.env.FACE_INDEX_EARLY_EXIT_MARGIN || '0.05');
+  // Searches arriving within this window share one pass over the gallery; 0 disables batching
+  private readonly BATCH_WINDOW_MS = parseInt(process.env.FACE_INDEX_BATCH_WINDOW_MS || '2');
+  private readonly MAX_BATCH = parseInt(process.env.FACE_INDEX_MAX_BATCH || '64');
+  private pendingSearches: Map<Gallery, PendingSearches> = new Map();
+  // Warm standby: with FACE_INDEX_PRIMARY_URL (the primary's API base, e.g. http://10.0.0.5:3000/api/v1)
+  // native galleries follow that node's change log instead of loading from the DB
+  private readonly PRIMARY_URL = (process.env.FACE_INDEX_PRIMARY_URL || '').replace(/\/+$/, '');
+  private readonly REPLICA_POLL_MS = parseInt(process.env.FACE_INDEX_REPLICA_POLL_MS || '25');
+  private readonly REPLICATION_TOKEN = process.env.FACE_INDEX_REPLICATION_TOKEN || '';
+  private readonly REPLICATION_LOG = parseInt(process.env.FACE_INDEX_REPLICATION_LOG || '4096');
+  private replicaTimer: NodeJS.Timeout | null = null;
+  private replicaAgent: http.Agent | null = null;
+  private replicaStats: ReplicaStats = { promoted: false, polls: 0, snapshots: 0, deltas: 0, changes: 0, errors: 0, lastSyncAt: 0 };
 
   constructor() {
     this.personFaceRepository = new PersonFaceRepository();
   }
 
   /**
-   * Initialize the ANN index by loading all person faces from database
+   * Initialize the galleries: from the primary on a standby, from the database otherwise
    */
   async initialize(): Promise<void> {
+    if (!this.isReplica()) {
+      return this.loadFromDatabase();
+    }
+
+    try {
+      await this.pollPrimary();
+      console.log(`📥 Face index: standby of ${this.PRIMARY_URL}, following its changes every ${this.REPLICA_POLL_MS}ms`);
+    } catch (error: any) {
+      // Serve from the DB meanwhile; the first successful poll replaces it with the primary's snapshot
+      console.warn(`⚠️ Face index: primary ${this.PRIMARY_URL} unreachable (${error.message}) - loading from the database`);
+      await this.loadFromDatabase();
+    }
+    this.isInitialized = true;
+    this.startReplication();
+  }
+
+  /**
+   * Initialize the ANN indexes by loading all person faces from database
+   */
+  private async loadFromDatabase(): Promise<void> {
     try {
       // console.log('🔍 Initializing Face Recognition ANN Index...');
 
@@ -45,33 +237,14 @@ export class FaceIndexService {
         return;
       }
 
-      // Determine embedding dimension from the first valid embedding
-      let embeddingDim = this.EMBEDDING_DIMENSION;
+      // Count faces per model so each gallery starts with a reasonable capacity
+      const facesPerModel = new Map<string, number>();
       for (const face of personFaces) {
-        if (face.embedding && face.embedding.length > 0) {
-          // Convert buffer to Float32Array to get dimension
-          const floatArray = new Float32Array(face.embedding.buffer);
-          embeddingDim = floatArray.length;
-          // console.log(`📏 Detected embedding dimension: ${embeddingDim}`);
-
-          // Update the instance dimension to match data
-          if (embeddingDim !== this.EMBEDDING_DIMENSION) {
-            // console.log(`🔧 Updating EMBEDDING_DIMENSION from ${this.EMBEDDING_DIMENSION} to ${embeddingDim}`);
-            this.EMBEDDING_DIMENSION = embeddingDim;
-          }
-          break;
-        }
+        const key = face.embeddingModel || LEGACY_GALLERY;
+        facesPerModel.set(key, (facesPerModel.get(key) || 0) + 1);
       }
 
-      // Initialize HNSW index with correct parameters
-      // HierarchicalNSW(space, dimension)
-      this.index = new HierarchicalNSW('cosine', embeddingDim);
-      const initialCapacity = Math.max(personFaces.length * 2, 100); // Reasonable initial capacity
-      // initIndex(capacity, M = 16, efConstruction = 200, randomSeed = 100)
-      this.index.initIndex(initialCapacity, 16, 200);
-      // console.log(`📊 Initialized HNSW index with capacity: ${initialCapacity}`);
-
-      // Add faces to index
+      // Add faces to their model's gallery
       for (const face of personFaces) {
         try {
           if (!face.embedding || face.embedding.length === 0) {
@@ -80,10 +253,16 @@ export class FaceIndexService {
           }
 
           // Convert Buffer to Float32Array
-          const embedding = new Float32Array(face.embedding.buffer);
+          const embedding = this.toFloat32(face.embedding);
+          const key = face.embeddingModel || LEGACY_GALLERY;
 
-          if (embedding.length !== embeddingDim) {
-            // console.warn(`⚠️ PersonFace ${face.id} has wrong embedding dimension (${embedding.length} vs ${embeddingDim}) - skipping`);
+          let gallery = this.galleries.get(key);
+          if (!gallery) {
+            gallery = this.createGallery(key, embedding.length, Math.max((facesPerModel.get(key) || 0) * 2, 100));
+          }
+
+          if (embedding.length !== gallery.dimension) {
+            // console.warn(`⚠️ PersonFace ${face.id} has wrong embedding dimension (${embedding.length} vs ${gallery.dimension}) - skipping`);
             continue;
           }
 
@@ -96,15 +275,23 @@ export class FaceIndexService {
             reliability: face.reliability || 0.5,
           };
 
-          // Add to HNSW index - convert Float32Array to number[]
-          this.index.addPoint(Array.from(embedding), face.id);
-          this.indexedFaces.set(face.id, indexedFace);
+          this.addToIndex(gallery, indexedFace);
+          gallery.faces.set(face.id, indexedFace);
 
         } catch (error) {
           console.error(`❌ Error processing PersonFace ${face.id}:`, error);
         }
       }
 
+      // Keep the reported dimension in line with the largest gallery
+      const primary = this.getPrimaryGallery();
+      if (primary) {
+        this.EMBEDDING_DIMENSION = primary.dimension;
+      }
+
+      if (NativeGallery) {
+        console.log(`🔢 Face index: native galleries with binary-code prefilter (rerank ${this.RERANK}, budget ${this.BUDGET_MS}ms up to ${this.MAX_RERANK})`);
+      }
       this.isInitialized = true;
     } catch (error) {
       console.error('❌ Error initializing Face Recognition ANN Index:', error);
@@ -113,118 +300,188 @@ export class FaceIndexService {
   }
 
   /**
-   * Search for similar faces in the index
+   * Search for similar faces in the galleries of the model that produced the query (its own and,
+   * for the primary models, the legacy one). With the native gallery, searches arriving within
+   * FACE_INDEX_BATCH_WINDOW_MS (other faces of the frame, other cameras) are answered together in
+   * one pass over the gallery.
+   */
+  async searchSimilarFaces(queryEmbedding: Float32Array, k: number = 5, embeddingModel?: string): Promise<FaceMatch[]> {
+    const galleries = this.resolveGalleries(queryEmbedding.length, embeddingModel);
+    if (!this.isInitialized || galleries.length === 0) {
+      console.warn('⚠️ Face index not initialized or empty');
+      return [];
+    }
+
+    try {
+      const results = await Promise.all(galleries.map(async gallery => {
+        if (gallery.native && this.BATCH_WINDOW_MS > 0) {
+          return this.enqueueSearch(gallery, queryEmbedding, k);
+        }
+        return (await this.searchGallery(gallery, [queryEmbedding], k))[0];
+      }));
+      return this.mergeMatches(results, k);
+    } catch (error: any) {
+      console.error('❌ Error searching similar faces:', error);
+      return [];
+    }
+  }
+
+  /**
+   * Search several faces at once, e.g. every face of a frame. Queries are grouped by gallery and
+   * each group is one batch: every block of gallery rows is read once for all of its queries.
    */
-  async searchSimilarFaces(queryEmbedding: Float32Array, k: number = 5) {
-  if (!this.isInitialized || !this.index || this.indexedFaces.size === 0) {
-    console.warn('⚠️ Face index not initialized or empty');
-    return [];
+  async searchSimilarFacesBatch(queries: Array<{ embedding: Float32Array; embeddingModel?: string }>, k: number = 5): Promise<FaceMatch[][]> {
+    if (!this.isInitialized) {
+      return queries.map(() => []);
+    }
+
+    const groups = new Map<Gallery, number[]>();
+    queries.forEach((query, i) => {
+      for (const gallery of this.resolveGalleries(query.embedding.length, query.embeddingModel)) {
+        groups.set(gallery, [...(groups.get(gallery) || []), i]);
+      }
+    });
+
+    // A query can be in two groups (its model's gallery and legacy): collect both, then merge
+    const perGallery: FaceMatch[][][] = queries.map(() => []);
+    await Promise.all(Array.from(groups.entries()).map(async ([gallery, indexes]) => {
+      try {
+        const matches = await this.searchGallery(gallery, indexes.map(i => queries[i].embedding), k);
+        indexes.forEach((queryIndex, j) => { perGallery[queryIndex].push(matches[j]); });
+      } catch (error: any) {
+        console.error('❌ Error searching similar faces:', error);
+      }
+    }));
+    return perGallery.map(matches => this.mergeMatches(matches, k));
   }
 
-  try {
-    // Validate embedding dimension
-    if (queryEmbedding.length !== this.EMBEDDING_DIMENSION) {
-      console.error(`❌ Query embedding dimension mismatch: expected ${this.EMBEDDING_DIMENSION}, got ${queryEmbedding.length}`);
-      console.warn('🔄 Rebuilding index due to dimension mismatch...');
-      await this.rebuild();
-
-      // Try search again after rebuild
-      if (!this.index || this.indexedFaces.size === 0) {
-        console.warn('⚠️ Index still empty after rebuild');
-        return [];
-      }
-    }
-
-    // Search top-k with error handling for dimension mismatch
-    const results = this.index.searchKnn(Array.from(queryEmbedding), Math.min(k, this.indexedFaces.size));
-
-    const matches = [];
-    for (let i = 0; i < results.neighbors.length; i++) {
-      const faceId = results.neighbors[i];
-      const distance = results.distances[i];
-
-      const indexedFace = this.indexedFaces.get(faceId);
-      if (!indexedFace) continue;
-
-      // Improved similarity calculation for ArcFace/FaceNet
-      // For normalized embeddings (ArcFace), cosine distance ∈ [0,2]
-      // Convert to similarity: similarity = 1 - (distance / 2)
-      // For ArcFace: values closer to 1.0 indicate higher similarity
-      const similarity = Math.max(0, Math.min(1, 1 - distance / 2));
-
-      // Dynamic threshold based on embedding quality
-      const isMatch = similarity >= this.SIMILARITY_THRESHOLD;
-
-      matches.push({
-        personFaceId: indexedFace.id,
-        personId: indexedFace.personId,
-        personName: indexedFace.personName,
-        similarity,
-        reliability: indexedFace.reliability,
-        isMatch,
+  /**
+   * Top-k of several galleries' results for one query, best first
+   */
+  private mergeMatches(results: FaceMatch[][], k: number): FaceMatch[] {
+    if (results.length === 1) {
+      return results[0];
+    }
+    return results.flat().sort((a, b) => b.similarity - a.similarity).slice(0, k);
+  }
+
+  /**
+   * Top-k matches of each query in one gallery, best first
+   */
+  private async searchGallery(gallery: Gallery, queries: Float32Array[], k: number): Promise<FaceMatch[][]> {
+    const count = Math.min(k, gallery.faces.size);
+
+    // Search top-k, as (faceId, cosine distance) pairs per query
+    let neighbors: Array<Array<{ faceId: number; distance: number }>>;
+    if (gallery.native && queries.length > 1) {
+      const native = gallery.native;
+      const batch = await new Promise<Array<Array<{ id: number; similarity: number }>>>((resolve, reject) => {
+        native.searchBatch(queries, this.nativeSearchOptions(count), (err, matches) => (err ? reject(err) : resolve(matches)));
+      });
+      neighbors = batch.map(matches => matches.map(match => ({ faceId: match.id, distance: 1 - match.similarity })));
+    } else if (gallery.native) {
+      neighbors = queries.map(query => gallery.native!.search(query, this.nativeSearchOptions(count))
+        .map(match => ({ faceId: match.id, distance: 1 - match.similarity })));
+    } else {
+      neighbors = queries.map(query => {
+        const results = gallery.index!.searchKnn(Array.from(query), count);
+        return results.neighbors.map((faceId, i) => ({ faceId, distance: results.distances[i] }));
       });
     }
 
-    // Sort by similarity
-    matches.sort((a, b) => b.similarity - a.similarity);
+    return neighbors.map(queryNeighbors => {
+      const matches: FaceMatch[] = [];
+      for (const { faceId, distance } of queryNeighbors) {
+        const indexedFace = gallery.faces.get(faceId);
+        if (!indexedFace) continue;
+
+        // Improved similarity calculation for ArcFace/FaceNet
+        // For normalized embeddings (ArcFace), cosine distance ∈ [0,2]
+        // Convert to similarity: similarity = 1 - (distance / 2)
+        // For ArcFace: values closer to 1.0 indicate higher similarity
+        const similarity = Math.max(0, Math.min(1, 1 - distance / 2));
+
+        // Dynamic threshold based on embedding quality
+        const isMatch = similarity >= this.SIMILARITY_THRESHOLD;
+
+        matches.push({
+          personFaceId: indexedFace.id,
+          personId: indexedFace.personId,
+          personName: indexedFace.personName,
+          similarity,
+          reliability: indexedFace.reliability,
+          isMatch,
+          embeddingModel: gallery.embeddingModel,
+        });
+      }
 
-    return matches;
-  } catch (error: any) {
-    // Handle dimension mismatch errors by rebuilding the index
-    if (error.message && error.message.includes('Invalid the given array length')) {
-      console.error('❌ HNSW index has wrong dimensions - forcing rebuild...');
-      console.log(`🔧 Expected: ${this.EMBEDDING_DIMENSION}, Index was created with wrong dimensions`);
+      // Sort by similarity
+      matches.sort((a, b) => b.similarity - a.similarity);
+      return matches;
+    });
+  }
 
-      try {
-        await this.rebuild();
-        console.log('✅ Index rebuilt successfully, retrying search...');
-
-        // Retry search after rebuild
-        if (this.index && this.indexedFaces.size > 0) {
-          const retryResults = this.index.searchKnn(Array.from(queryEmbedding), Math.min(k, this.indexedFaces.size));
-          const retryMatches = [];
-
-          for (let i = 0; i < retryResults.neighbors.length; i++) {
-            const faceId = retryResults.neighbors[i];
-            const distance = retryResults.distances[i];
-            const indexedFace = this.indexedFaces.get(faceId);
-            if (!indexedFace) continue;
-
-            const similarity = Math.max(0, Math.min(1, 1 - distance / 2));
-            const isMatch = similarity >= this.SIMILARITY_THRESHOLD;
-
-            retryMatches.push({
-              personFaceId: indexedFace.id,
-              personId: indexedFace.personId,
-              personName: indexedFace.personName,
-              similarity,
-              reliability: indexedFace.reliability,
-              isMatch,
-            });
-          }
+  /**
+   * Native options for a top-k search. Similarities here are (1 + cos) / 2, so the threshold and margin are
+   * converted to cosine for the gallery.
+   */
+  private nativeSearchOptions(k: number): NativeSearchOptions {
+    return {
+      k,
+      rerank: this.RERANK,
+      budgetMs: this.BUDGET_MS,
+      matchThreshold: 2 * this.SIMILARITY_THRESHOLD - 1,
+      margin: 2 * this.EARLY_EXIT_MARGIN,
+      maxRerank: this.MAX_RERANK,
+    };
+  }
 
-          retryMatches.sort((a, b) => b.similarity - a.similarity);
-          return retryMatches;
+  /**
+   * Queue a search for the gallery's next batch; the batch runs when the window closes or it is full
+   */
+  private enqueueSearch(gallery: Gallery, query: Float32Array, k: number): Promise<FaceMatch[]> {
+    return new Promise((resolve, reject) => {
+      let pending = this.pendingSearches.get(gallery);
+      if (!pending || pending.k !== k) {
+        if (pending) {
+          this.flushSearches(gallery);
         }
-      } catch (rebuildError) {
-        console.error('❌ Failed to rebuild index:', rebuildError);
+        pending = { k, entries: [], timer: setTimeout(() => this.flushSearches(gallery), this.BATCH_WINDOW_MS) };
+        this.pendingSearches.set(gallery, pending);
       }
+      pending.entries.push({ query, resolve, reject });
+      if (pending.entries.length >= this.MAX_BATCH) {
+        this.flushSearches(gallery);
+      }
+    });
+  }
+
+  private flushSearches(gallery: Gallery): void {
+    const pending = this.pendingSearches.get(gallery);
+    if (!pending) {
+      return;
     }
+    this.pendingSearches.delete(gallery);
+    clearTimeout(pending.timer);
 
-    console.error('❌ Error searching similar faces:', error);
-    return [];
+    this.searchGallery(gallery, pending.entries.map(entry => entry.query), pending.k)
+      .then(results => pending.entries.forEach((entry, i) => entry.resolve(results[i])))
+      .catch(error => pending.entries.forEach(entry => entry.reject(error)));
   }
-}
-
 
   /**
-   * Add a new face to the index
+   * Add a new face to its model's gallery
    */
   async addFace(personFace: PersonFace): Promise<boolean> {
-    if (!this.isInitialized || !this.index) {
+    if (!this.isInitialized) {
       console.warn('⚠️ Cannot add face - index not initialized');
       return false;
     }
+    if (this.isReplica()) {
+      // Enrollment goes through the primary; its change log brings the face here
+      console.warn(`⚠️ Cannot add PersonFace ${personFace.id} on a standby - send enrollments to the primary`);
+      return false;
+    }
 
     try {
       if (!personFace.embedding || personFace.embedding.length === 0) {
@@ -233,7 +490,8 @@ export class FaceIndexService {
       }
 
       // Convert Buffer to Float32Array
-      const embedding = new Float32Array(personFace.embedding.buffer);
+      const embedding = this.toFloat32(personFace.embedding);
+      const key = personFace.embeddingModel || LEGACY_GALLERY;
 
       // Load person information
       const personFaceWithPerson = await this.personFaceRepository.getRepository()
@@ -247,6 +505,17 @@ export class FaceIndexService {
         return false;
       }
 
+      let gallery = this.galleries.get(key);
+      if (!gallery) {
+        gallery = this.createGallery(key, embedding.length, 100);
+        console.log(`📚 Created gallery for embedding model ${key} (${embedding.length} dimensions)`);
+      }
+
+      if (embedding.length !== gallery.dimension) {
+        console.warn(`⚠️ Cannot add PersonFace ${personFace.id} - dimension ${embedding.length} does not match gallery ${key} (${gallery.dimension})`);
+        return false;
+      }
+
       const indexedFace: IndexedFace = {
         id: personFace.id,
         personId: personFace.personId,
@@ -255,33 +524,25 @@ export class FaceIndexService {
         reliability: personFace.reliability || 0.5,
       };
 
-      // Add to HNSW index - convert Float32Array to number[]
-      try {
-        this.index.addPoint(Array.from(embedding), personFace.id);
-        this.indexedFaces.set(personFace.id, indexedFace);
+      // Grow the gallery before it hits its capacity limit; removed faces stay in HNSW as deleted points,
+      // so count the index's points rather than the cache
+      if (gallery.index && gallery.index.getCurrentCount() + 1 > gallery.capacity) {
+        this.growIndex(gallery);
+      }
 
-        // console.log(`✅ Added PersonFace ${personFace.id} (${indexedFace.personName}) to ANN index`);
-        return true;
+      try {
+        this.addToIndex(gallery, indexedFace);
       } catch (indexError: any) {
-        // If we hit capacity limit, rebuild the index with more capacity
-        if (indexError.message && indexError.message.includes('exceeds the specified limit')) {
-          console.warn(`⚠️ HNSW index capacity exceeded. Rebuilding with larger capacity...`);
-          await this.rebuild();
-
-          // Try adding the face again after rebuild
-          try {
-            this.index!.addPoint(Array.from(embedding), personFace.id);
-            this.indexedFaces.set(personFace.id, indexedFace);
-            // console.log(`✅ Added PersonFace ${personFace.id} (${indexedFace.personName}) to rebuilt ANN index`);
-            return true;
-          } catch (retryError) {
-            console.error(`❌ Failed to add face ${personFace.id} even after rebuild:`, retryError);
-            return false;
-          }
-        } else {
+        if (!gallery.index || !indexError.message || !indexError.message.includes('exceeds the specified limit')) {
           throw indexError; // Re-throw other errors
         }
+        this.growIndex(gallery);
+        this.addToIndex(gallery, indexedFace);
       }
+      gallery.faces.set(personFace.id, indexedFace);
+
+      // console.log(`✅ Added PersonFace ${personFace.id} (${indexedFace.personName}) to ANN index`);
+      return true;
     } catch (error) {
       console.error(`❌ Error adding face ${personFace.id} to index:`, error);
       return false;
@@ -292,14 +553,21 @@ export class FaceIndexService {
    * Remove a face from the index
    */
   removeFace(personFaceId: number): boolean {
-    if (!this.isInitialized || !this.index) {
+    if (!this.isInitialized || this.isReplica()) {
       return false;
     }
 
     try {
-      // Note: hnswlib-node doesn't support removing points,
-      // so we just remove from our cache
-      const removed = this.indexedFaces.delete(personFaceId);
+      // hnswlib-node cannot remove points: mark them deleted so searches skip them
+      // (they still count toward capacity); native galleries drop the vector
+      let removed = false;
+      for (const gallery of this.galleries.values()) {
+        gallery.native?.remove(personFaceId);
+        if (gallery.index && gallery.faces.has(personFaceId)) {
+          gallery.index.markDelete(personFaceId);
+        }
+        removed = gallery.faces.delete(personFaceId) || removed;
+      }
 
       if (removed) {
         console.log(`🗑️ Removed PersonFace ${personFaceId} from index cache`);
@@ -321,16 +589,126 @@ export class FaceIndexService {
     embeddingDimension: number;
     similarityThreshold: number;
     modelOptimized: string;
+    galleries: Array<{
+      embeddingModel: string;
+      faces: number;
+      dimension: number;
+      backend: 'native' | 'hnsw';
+      native?: ReturnType<NativeEmbeddingGallery['getStats']>;
+      effort?: { averageRerankDepth: number; averageAdaptiveMs: number; earlyExitRate: number; budgetStopRate: number };
+    }>;
+    replication: { role: 'primary' | 'replica'; primaryUrl?: string; lagMs?: number } & ReplicaStats;
   } {
+    let totalFaces = 0;
+    const galleries = [];
+    for (const gallery of this.galleries.values()) {
+      totalFaces += gallery.faces.size;
+      const native = gallery.native?.getStats();
+      // Achieved rerank effort per search, from the gallery's counters
+      const adaptive = native?.adaptiveSearches || 0;
+      galleries.push({
+        embeddingModel: gallery.embeddingModel,
+        faces: gallery.faces.size,
+        dimension: gallery.dimension,
+        backend: gallery.native ? 'native' as const : 'hnsw' as const,
+        native,
+        effort: native && native.searches > 0 ? {
+          averageRerankDepth: native.rescored / native.searches,
+          averageAdaptiveMs: adaptive > 0 ? native.adaptiveMs / adaptive : 0,
+          earlyExitRate: adaptive > 0 ? native.earlyExits / adaptive : 0,
+          budgetStopRate: adaptive > 0 ? native.budgetStops / adaptive : 0,
+        } : undefined,
+      });
+    }
+
     return {
       isInitialized: this.isInitialized,
-      totalFaces: this.indexedFaces.size,
+      totalFaces,
       embeddingDimension: this.EMBEDDING_DIMENSION,
       similarityThreshold: this.SIMILARITY_THRESHOLD,
       modelOptimized: this.SIMILARITY_THRESHOLD <= 0.75 ? 'ArcFace' : 'FaceNet',
+      galleries,
+      replication: {
+        role: this.isReplica() ? 'replica' : 'primary',
+        primaryUrl: this.PRIMARY_URL || undefined,
+        lagMs: this.isReplica() && this.replicaStats.lastSyncAt > 0 ? Date.now() - this.replicaStats.lastSyncAt : undefined,
+        ...this.replicaStats,
+      },
     };
   }
 
+  /**
+   * True while this node follows a primary (FACE_INDEX_PRIMARY_URL, native galleries, not promoted)
+   */
+  isReplica(): boolean {
+    return this.PRIMARY_URL !== '' && NativeGallery !== null && !this.replicaStats.promoted;
+  }
+
+  /**
+   * Stops following the primary; this node keeps its galleries, epoch and sequence, so other standbys
+   * can follow it next
+   */
+  promote(): boolean {
+    if (!this.isReplica()) {
+      return false;
+    }
+    this.replicaStats.promoted = true;
+    if (this.replicaTimer) {
+      clearTimeout(this.replicaTimer);
+      this.replicaTimer = null;
+    }
+    console.log(`👑 Face index: promoted to primary at ${Array.from(this.galleries.values()).map(g => `${g.embeddingModel}@${g.native?.sequence()}`).join(', ')}`);
+    return true;
+  }
+
+  /**
+   * Native galleries and their positions in the change log, for standbys
+   */
+  getReplicationState(): Array<{ embeddingModel: string; dimension: number; faces: number; epoch: string; sequence: number; oldestLogged: number }> {
+    const galleries = [];
+    for (const gallery of this.galleries.values()) {
+      if (gallery.native) {
+        const native = gallery.native.getStats();
+        galleries.push({
+          embeddingModel: gallery.embeddingModel,
+          dimension: gallery.dimension,
+          faces: gallery.faces.size,
+          epoch: native.epoch,
+          sequence: native.sequence,
+          oldestLogged: native.oldestLogged,
+        });
+      }
+    }
+    return galleries;
+  }
+
+  /**
+   * Changes to a gallery after `afterSequence`; 'stale' once they have left the log (load a snapshot)
+   */
+  exportDelta(embeddingModel: string, afterSequence: number, maxEntries: number = 1024): ReplicationExport {
+    const native = this.galleries.get(embeddingModel)?.native;
+    if (!native) {
+      return { status: 'not_found' };
+    }
+    const blob = native.exportDelta(afterSequence, maxEntries);
+    return blob ? { status: 'ok', ...blob } : { status: 'stale' };
+  }
+
+  exportSnapshot(embeddingModel: string): ReplicationExport {
+    const native = this.galleries.get(embeddingModel)?.native;
+    if (!native) {
+      return { status: 'not_found' };
+    }
+    return { status: 'ok', ...native.exportSnapshot() };
+  }
+
+  /**
+   * Similarity a match needs, on the (1 + cos) / 2 scale of FaceMatch.similarity
+   */
+  getSimilarityThreshold(): number {
+    return this.SIMILARITY_THRESHOLD;
+  }
+
   /**
    * Auto-configure for model type
    */
@@ -363,11 +741,239 @@ export class FaceIndexService {
   async rebuild(): Promise<void> {
     console.log('🔄 Rebuilding Face Recognition ANN Index...');
     this.isInitialized = false;
-    this.index = null;
-    this.indexedFaces.clear();
+    for (const gallery of this.galleries.values()) {
+      gallery.native?.close();
+    }
+    this.galleries.clear();
     await this.initialize();
   }
+
+  /**
+   * Create an empty gallery for one embedding model
+   */
+  private createGallery(embeddingModel: string, dimension: number, capacity: number): Gallery {
+    const gallery: Gallery = { embeddingModel, dimension, capacity, faces: new Map() };
+    if (NativeGallery) {
+      gallery.native = new NativeGallery(dimension);
+      gallery.native.setLogCapacity(this.REPLICATION_LOG);
+    } else {
+      // HierarchicalNSW(space, dimension)
+      gallery.index = new HierarchicalNSW('cosine', dimension);
+      // initIndex(capacity, M = 16, efConstruction = 200, randomSeed = 100)
+      gallery.index.initIndex(capacity, 16, 200);
+    }
+    this.galleries.set(embeddingModel, gallery);
+    return gallery;
+  }
+
+  private growIndex(gallery: Gallery): void {
+    console.warn(`⚠️ HNSW gallery ${gallery.embeddingModel} capacity exceeded. Resizing...`);
+    gallery.capacity = Math.max(gallery.capacity * 2, gallery.index!.getCurrentCount() + 1);
+    gallery.index!.resizeIndex(gallery.capacity);
+  }
+
+  private addToIndex(gallery: Gallery, face: IndexedFace): void {
+    const embedding = face.embedding!;
+    if (gallery.native) {
+      const payload: ReplicatedFace = { personId: face.personId, personName: face.personName, reliability: face.reliability };
+      gallery.native.add(face.id, embedding, JSON.stringify(payload));
+    } else if (gallery.index) {
+      // Add to HNSW index - convert Float32Array to number[]
+      gallery.index.addPoint(Array.from(embedding), face.id);
+    }
+  }
+
+  /**
+   * One replication round: mirror the primary's set of galleries, then bring each one up to the
+   * primary's sequence with deltas, or with a snapshot when new, behind the log, or from another epoch
+   */
+  private async pollPrimary(): Promise<void> {
+    const response = await this.primaryGet('/face-index/replication');
+    if (response.status !== 200) {
+      throw new Error(`primary answered ${response.status}`);
+    }
+    const remote: ReturnType<FaceIndexService['getReplicationState']> = JSON.parse(response.body.toString()).data.galleries;
+    this.replicaStats.polls++;
+
+    const models = new Set(remote.map(entry => entry.embeddingModel));
+    for (const [key, gallery] of this.galleries) {
+      if (!models.has(key)) {
+        gallery.native?.close();
+        this.galleries.delete(key);
+      }
+    }
+
+    for (const entry of remote) {
+      let gallery = this.galleries.get(entry.embeddingModel);
+      if (gallery && (!gallery.native || gallery.dimension !== entry.dimension)) {
+        gallery.native?.close();
+        this.galleries.delete(entry.embeddingModel);
+        gallery = undefined;
+      }
+      if (!gallery) {
+        gallery = this.createGallery(entry.embeddingModel, entry.dimension, 100);
+      }
+      await this.syncGallery(gallery, entry.epoch, entry.sequence);
+    }
+
+    const primary = this.getPrimaryGallery();
+    if (primary) {
+      this.EMBEDDING_DIMENSION = primary.dimension;
+    }
+    this.replicaStats.lastSyncAt = Date.now();
+  }
+
+  private async syncGallery(gallery: Gallery, epoch: string, sequence: number): Promise<void> {
+    const native = gallery.native!;
+    const model = encodeURIComponent(gallery.embeddingModel);
+    if (native.getStats().epoch !== epoch || native.sequence() > sequence) {
+      gallery.replicated = false; // Primary restarted or rebuilt its gallery
+    }
+
+    while (gallery.replicated && native.sequence() < sequence) {
+      const response = await this.primaryGet(`/face-index/replication/${model}/delta?after=${native.sequence()}`);
+      if (response.status === 410) {
+        gallery.replicated = false; // Fell behind the primary's log
+        break;
+      }
+      if (response.status !== 200) {
+        throw new Error(`delta for ${gallery.embeddingModel}: primary answered ${response.status}`);
+      }
+      const result = native.applyDelta(response.body);
+      if (!result) {
+        gallery.replicated = false;
+        break;
+      }
+      this.mirrorChanges(gallery, result.changes);
+      this.replicaStats.deltas++;
+      if (result.applied === 0) {
+        break;
+      }
+    }
+
+    if (!gallery.replicated) {
+      const response = await this.primaryGet(`/face-index/replication/${model}/snapshot`);
+      if (response.status !== 200) {
+        throw new Error(`snapshot of ${gallery.embeddingModel}: primary answered ${response.status}`);
+      }
+      const result = native.loadSnapshot(response.body);
+      gallery.faces.clear();
+      this.mirrorChanges(gallery, result.changes);
+      gallery.replicated = true;
+      this.replicaStats.snapshots++;
+      console.log(`📥 Face index: loaded ${result.rows} ${gallery.embeddingModel} faces from the primary's snapshot (sequence ${native.sequence()}, ${(response.body.length / 1048576).toFixed(1)} MB)`);
+    }
+  }
+
+  // Keeps the face metadata in step with the rows the native gallery just took from the primary
+  private mirrorChanges(gallery: Gallery, changes: NativeChange[]): void {
+    for (const change of changes) {
+      if (change.op === 'remove') {
+        gallery.faces.delete(change.id);
+        continue;
+      }
+      const face: Partial<ReplicatedFace> = change.payload ? JSON.parse(change.payload) : {};
+      gallery.faces.set(change.id, {
+        id: change.id,
+        personId: face.personId ?? 0,
+        personName: face.personName || 'Unknown',
+        reliability: face.reliability ?? 0.5,
+      });
+    }
+    this.replicaStats.changes += changes.length;
+  }
+
+  private startReplication(): void {
+    if (this.replicaTimer) {
+      return;
+    }
+    let failing = false;
+    const poll = async () => {
+      try {
+        if (this.isInitialized) {
+          await this.pollPrimary();
+        }
+        if (failing) {
+          console.log(`✅ Face index: primary ${this.PRIMARY_URL} reachable again`);
+          failing = false;
+        }
+      } catch (error: any) {
+        this.replicaStats.errors++;
+        if (!failing) {
+          console.warn(`⚠️ Face index: replication from ${this.PRIMARY_URL} failed (${error.message}) - serving the last state`);
+          failing = true;
+        }
+      }
+      // Chained rather than an interval so a slow snapshot never overlaps the next poll
+      this.replicaTimer = this.isReplica() ? setTimeout(poll, this.REPLICA_POLL_MS) : null;
+    };
+    this.replicaTimer = setTimeout(poll, this.REPLICA_POLL_MS);
+  }
+
+  // GET against the primary's API, over a kept-alive connection
+  private primaryGet(pathname: string): Promise<{ status: number; body: Buffer }> {
+    const url = new URL(this.PRIMARY_URL + pathname);
+    const secure = url.protocol === 'https:';
+    if (!this.replicaAgent) {
+      this.replicaAgent = secure ? new https.Agent({ keepAlive: true, maxSockets: 1 }) : new http.Agent({ keepAlive: true, maxSockets: 1 });
+    }
+    const options = { agent: this.replicaAgent, headers: { 'x-replication-token': this.REPLICATION_TOKEN }, timeout: 30000 };
+    return new Promise((resolve, reject) => {
+      const onResponse = (response: http.IncomingMessage) => {
+        const chunks: Buffer[] = [];
+        response.on('data', (chunk: Buffer) => chunks.push(chunk));
+        response.on('end', () => resolve({ status: response.statusCode || 0, body: Buffer.concat(chunks) }));
+        response.on('error', reject);
+      };
+      const request = secure ? https.get(url, options, onResponse) : http.get(url, options, onResponse);
+      request.on('timeout', () => request.destroy(new Error(`request to ${pathname} timed out`)));
+      request.on('error', reject);
+    });
+  }
+
+  /**
+   * Pick the galleries for a query: the exact model gallery when tagged, plus the
+   * legacy gallery for untagged queries and the primary models, as long as the
+   * dimensions agree. Legacy is searched even once the model has a gallery of its
+   * own, since people enrolled before embeddings were tagged are only there. A
+   * light-tier (MobileFaceNet) query only searches its own gallery: its vectors are
+   * in another space.
+   */
+  private resolveGalleries(dimension: number, embeddingModel?: string): Gallery[] {
+    const galleries: Gallery[] = [];
+    if (embeddingModel) {
+      const gallery = this.galleries.get(embeddingModel);
+      if (gallery && gallery.faces.size > 0) {
+        galleries.push(gallery);
+      }
+      if (!isLegacyModel(embeddingModel)) {
+        return galleries;
+      }
+    }
+
+    const legacy = this.galleries.get(LEGACY_GALLERY);
+    if (legacy && legacy.dimension === dimension && legacy.faces.size > 0) {
+      galleries.push(legacy);
+    }
+    return galleries;
+  }
+
+  private getPrimaryGallery(): Gallery | undefined {
+    let primary: Gallery | undefined;
+    for (const gallery of this.galleries.values()) {
+      if (!primary || gallery.faces.size > primary.faces.size) {
+        primary = gallery;
+      }
+    }
+    return primary;
+  }
+
+  private toFloat32(buffer: Buffer): Float32Array {
+    // Copy into a fresh ArrayBuffer: pooled Buffers are not guaranteed to be 4-byte aligned
+    const bytes = new Uint8Array(buffer);
+    return new Float32Array(bytes.buffer, 0, Math.floor(bytes.byteLength / Float32Array.BYTES_PER_ELEMENT));
+  }
 }
 
 // Export singleton instance
-export const faceIndexService = new FaceIndexService();
\ No newline at end of file
+export const faceIndexService = new FaceIndexService();
@@ -2,13 +2,42 @@ import * as path from 'path';
 import * as fs from 'fs';
 import { createCanvas, loadImage } from 'canvas';
 import { PersonService, DetectionService, EventService, EventCameraService } from './index';
-import { nativeFaceDetectionService } from './NativeFaceDetectionService';
+import { nativeFaceDetectionService, DetectionCancelledError, NativeCancelTarget, NativeEarlyBoxes } from './NativeFaceDetectionService';
 import { faceIndexService } from './FaceIndexService';
+import { detectionJournalService, JournalDetection } from './DetectionJournalService';
+import { activityCounterService, ActivityDetection } from './ActivityCounterService';
 import { imageProcessingPool } from '../workers/imageProcessingWorker';
 
 export interface FaceDetectionResult {
   faces: DetectedFace[];
   processedImagePath?: string;
+  cancelled?: boolean;
+  frameId?: number; // Native job id; matches the early boxes delivered for this frame
+}
+
+/**
+ * One phase of a frame's results for live overlays. 'boxes' arrives as soon as detection
+ * finishes; 'identities' follows for the same frameId once the faces are embedded and matched.
+ * A frame that is cancelled or not recorded may stop after 'boxes'.
+ */
+export interface FrameResultUpdate {
+  phase: 'boxes' | 'identities';
+  cameraId: number;
+  frameId: number;
+  faces: Array<{
+    boundingBox: DetectedFace['boundingBox'];
+    confidence: number;
+    isMatch?: boolean;
+    personName?: string;
+    recognitionConfidence?: number;
+  }>;
+}
+
+// A frame in processVideoFrame, flagged by cancelFrames() so its remaining stages are skipped
+interface FrameJob {
+  cameraId: number;
+  eventId?: number;
+  cancelled: boolean;
 }
 
 export interface DetectedFace {
@@ -21,10 +50,13 @@ export interface DetectedFace {
   confidence: number;
   landmarks?: any[];
   encoding?: number[];
+  embeddingModel?: string; // Version tag of the model that produced `encoding`
+  quality?: number;
 }
 
 export interface RecognitionResult {
   personId?: number;
+  matchedPersonId?: number; // Person the matched face belongs to
   personName?: string;
   confidence: number;
   isMatch: boolean;
@@ -46,6 +78,8 @@ export class FaceRecognitionService {
   private readonly memoryThresholdMB = 2048; // Memory threshold for throttling
   private readonly cpuThrottleDelay = 0; // No artificial delay - let native module handle performance
   private activeDetections = 0;
+  private activeFrames = new Set<FrameJob>();
+  private frameResultListeners = new Set<(update: FrameResultUpdate) => void>();
   private memoryUsageMB = 0;
   private lastMemoryCheck = Date.now();
 
@@ -92,36 +126,50 @@ export class FaceRecognitionService {
   /**
    * Detect faces in an image buffer using native detector with timeout protection
    */
-  public async detectFaces(imageBuffer: Buffer): Promise<FaceDetectionResult> {
+  public async detectFaces(
+    imageBuffer: Buffer,
+    cameraId?: number,
+    eventId?: number,
+    options: {
+      organizationId?: number; // Watchlist alerts only for this organization's entries
+      onBoxes?: (faces: DetectedFace[], frameId: number) => void;
+    } = {}
+  ): Promise<FaceDetectionResult> {
+    const { organizationId, onBoxes } = options;
     if (!this.isInitialized) {
       await this.initialize();
     }
 
     try {
+      // Early boxes go through the same filtering as the final faces, so both phases show the same set
+      const onNativeBoxes = onBoxes ? (boxes: NativeEarlyBoxes) => {
+        const faces = this.filterFaces(boxes.faces.map(face => ({ boundingBox: face.boundingBox, confidence: face.confidence })));
+        if (faces.length > 0) {
+          onBoxes(faces, boxes.jobId);
+        }
+      } : undefined;
+
       // Wrap detection with timeout to prevent freezing
       const nativeResult: any = await Promise.race([
-        nativeFaceDetectionService.detectFacesAsync(imageBuffer),
+        nativeFaceDetectionService.detectFacesAsync(imageBuffer, { cameraId, eventId, organizationId, onBoxes: onNativeBoxes }),
         this.createTimeoutPromise(this.processingTimeoutMs, 'Face detection timeout')
       ]);
 
       // Convert native result to our format
-      const candidateFaces: DetectedFace[] = nativeResult.faces
-        .map((face: any) => ({
-          boundingBox: face.boundingBox,
-          confidence: face.confidence,
-          landmarks: face.landmarks || [],
-          encoding: face.encoding || [], // Include face encoding from C++
-        }))
-        .filter((face: any) => {
-          // Basic validation for native detector
-          return this.validateBasicFace(face);
-        });
-
-      // Apply advanced filtering to remove false positives
-      const faces = this.applyAdvancedFiltering(candidateFaces);
-
-      return { faces };
+      const faces = this.filterFaces(nativeResult.faces.map((face: any) => ({
+        boundingBox: face.boundingBox,
+        confidence: face.confidence,
+        landmarks: face.landmarks || [],
+        encoding: face.encoding || [], // Include face encoding from C++
+        embeddingModel: face.embeddingModel,
+        quality: face.quality,
+      })));
+
+      return { faces, frameId: nativeResult.jobId };
     } catch (error: any) {
+      if (error instanceof DetectionCancelledError) {
+        return { faces: [], cancelled: true };
+      }
       if (error.message && error.message.includes('timeout')) {
         console.warn('⚠️ Face detection timed out, disposing detector for re-initialization');
         this.dispose(); // Force re-initialization on timeout
@@ -131,6 +179,27 @@ export class FaceRecognitionService {
     }
   }
 
+  /**
+   * Cancel frames of a stopped session: native jobs are dropped or stop before embedding, and frames
+   * already past detection skip matching, crop encoding and recording. Returns the number of frames cancelled.
+   */
+  public cancelFrames(target: NativeCancelTarget): number {
+    let cancelled = 0;
+    for (const frame of this.activeFrames) {
+      if (!frame.cancelled &&
+          (target.cameraId === undefined || target.cameraId === frame.cameraId) &&
+          (target.eventId === undefined || target.eventId === frame.eventId)) {
+        frame.cancelled = true;
+        cancelled++;
+      }
+    }
+    const nativeCancelled = nativeFaceDetectionService.cancel(target);
+    if (cancelled > 0 || nativeCancelled > 0) {
+      console.log(`🛑 Cancelled ${cancelled} frame(s) (${nativeCancelled} native job(s)) for camera ${target.cameraId ?? 'any'}, event ${target.eventId ?? 'any'}`);
+    }
+    return cancelled;
+  }
+
   /**
    * Create a timeout promise that rejects after specified milliseconds
    */
@@ -140,6 +209,27 @@ export class FaceRecognitionService {
     });
   }
 
+  /**
+   * Subscribes to the two-phase results of processed frames (boxes, then identities); returns the unsubscribe.
+   * Early boxes are only requested from the native detector while someone listens.
+   */
+  public onFrameResults(listener: (update: FrameResultUpdate) => void): () => void {
+    this.frameResultListeners.add(listener);
+    return () => {
+      this.frameResultListeners.delete(listener);
+    };
+  }
+
+  private emitFrameResults(update: FrameResultUpdate): void {
+    for (const listener of this.frameResultListeners) {
+      try {
+        listener(update);
+      } catch (error) {
+        console.error('❌ Frame results listener failed:', error);
+      }
+    }
+  }
+
   /**
    * Process a video frame for face detection and recognition with advanced throttling
    */
@@ -156,6 +246,9 @@ export class FaceRecognitionService {
       return;
     }
 
+    const frame: FrameJob = { cameraId, eventId, cancelled: false };
+    this.activeFrames.add(frame);
+
     try {
       // Start performance tracking
       const startTime = Date.now();
@@ -167,8 +260,16 @@ export class FaceRecognitionService {
         await new Promise(resolve => setImmediate(resolve));
       }
 
-      // Detect faces in the frame with timeout protection
-      const detection = await this.detectFaces(frameBuffer);
+      // Detect faces in the frame with timeout protection; overlays get the boxes before the faces are embedded
+      const onBoxes = this.frameResultListeners.size > 0
+        ? (faces: DetectedFace[], frameId: number) => this.emitFrameResults({
+          phase: 'boxes',
+          cameraId,
+          frameId,
+          faces: faces.map(face => ({ boundingBox: face.boundingBox, confidence: face.confidence })),
+        })
+        : undefined;
+      const detection = await this.detectFaces(frameBuffer, cameraId, eventId, { organizationId, onBoxes });
       const processingTime = Date.now() - startTime;
 
       // Update performance statistics
@@ -178,9 +279,9 @@ export class FaceRecognitionService {
 
       // console.log(`✅ Camera ${cameraId}: Detection completed in ${processingTime}ms, found ${detection.faces.length} faces (avg: ${this.performanceStats.averageProcessingTime.toFixed(1)}ms)`);
 
-      if (detection.faces.length === 0) {
+      if (detection.faces.length === 0 || frame.cancelled) {
         this.performanceStats.activeDetections--;
-        return; // No faces detected - skip recording
+        return; // No faces detected or session stopped - skip recording
       }
 
       // Use provided eventId or get the active event for this camera
@@ -203,12 +304,37 @@ export class FaceRecognitionService {
         this.lastSavedImageTime = currentTime;
       }
 
+      // Detections of this frame, journaled together once every face is matched
+      const frameDetections: JournalDetection[] = [];
+      const frameActivity: ActivityDetection[] = [];
+
+      // Match every eligible face of the frame at once so the gallery answers them as one batch
+      const recognitions = await Promise.all(detection.faces.map(face =>
+        face.confidence >= this.faceThreshold ? this.recognizeFace(face, organizationId) : undefined));
+
+      if (detection.frameId !== undefined && !frame.cancelled) {
+        this.emitFrameResults({
+          phase: 'identities',
+          cameraId,
+          frameId: detection.frameId,
+          faces: detection.faces.map((face, index) => ({
+            boundingBox: face.boundingBox,
+            confidence: face.confidence,
+            isMatch: recognitions[index]?.isMatch ?? false,
+            personName: recognitions[index]?.isMatch ? recognitions[index]?.personName : undefined,
+            recognitionConfidence: recognitions[index]?.confidence,
+          })),
+        });
+      }
+
       // Process each detected face
       for (let index = 0; index < detection.faces.length; index++) {
+        if (frame.cancelled) {
+          break; // Session stopped: skip crop encoding and recording for the remaining faces
+        }
         const face = detection.faces[index];
-        if (face.confidence >= this.faceThreshold) {
-          // Try to recognize the face
-          const recognition = await this.recognizeFace(face, organizationId);
+        const recognition = recognitions[index];
+        if (recognition) {
 
           let personFaceId: number | undefined;
 
@@ -223,13 +349,6 @@ export class FaceRecognitionService {
           // Save individual face crop
           const faceImageUrl = await this.saveFaceCrop(frameBuffer, face, index);
 
-          // Convert face encoding to Buffer for database storage
-          let embeddingBuffer: Buffer | undefined;
-          if (face.encoding && face.encoding.length > 0) {
-            const float32Array = new Float32Array(face.encoding);
-            embeddingBuffer = Buffer.from(float32Array.buffer);
-          }
-
           // Determine faceStatus and detectionStatus based on recognition result
           let faceStatus: 'unrecognized' | 'detected' | 'recognized';
           let detectionStatus: 'pending' | 'confirmed' = 'pending'; // Default state
@@ -251,13 +370,20 @@ export class FaceRecognitionService {
           }
 
           // Record the detection with enhanced metadata
-          await this.detectionService.create({
+          frameDetections.push({
             detectedAt: new Date(),
-            confidence: recognition.isMatch ? recognition.confidence : 0, // Use recognition confidence for consistency
+            organizationId,
+            cameraId,
+            eventId: currentEventId,
+            personFaceId, // undefined for unknown faces
+            similarity: recognition.isMatch ? recognition.confidence : 0, // Use recognition confidence for consistency
+            confidence: face.confidence,
+            boundingBox: face.boundingBox,
             faceStatus,
             detectionStatus,
-            imageUrl: faceImageUrl, // Use face crop URL instead of full detection image
-            embedding: embeddingBuffer, // Store the face embedding for future recognition
+            embedding: face.encoding, // Store the face embedding for future recognition
+            embeddingModel: face.embeddingModel || undefined,
+            cropRef: faceImageUrl, // Use face crop URL instead of full detection image
             metadata: JSON.stringify({
               boundingBox: face.boundingBox,
               isKnown: recognition.isMatch,
@@ -270,13 +396,42 @@ export class FaceRecognitionService {
               faceIndex: index,
               autoConfirmed: recognition.isMatch && recognition.confidence === 1.0, // Flag for auto-confirmation
             }),
+          });
+          frameActivity.push({
+            detectedAt: frameDetections[frameDetections.length - 1].detectedAt,
+            organizationId,
+            cameraId,
             eventId: currentEventId,
-            personFaceId: personFaceId, // This will be undefined for unknown faces
+            personId: recognition.isMatch ? recognition.matchedPersonId : undefined,
+            recognized: faceStatus === 'recognized',
+          });
+        }
+      }
+
+      // One journal append per frame; the journal drains to the database in batches
+      if (frameDetections.length > 0 && !detectionJournalService.append(frameDetections)) {
+        // No native journal, or it is full: write each detection directly
+        for (const record of frameDetections) {
+          await this.detectionService.create({
+            detectedAt: record.detectedAt,
+            confidence: record.similarity,
+            faceStatus: record.faceStatus,
+            detectionStatus: record.detectionStatus,
+            imageUrl: record.cropRef,
+            embedding: record.embedding && record.embedding.length > 0
+              ? Buffer.from(new Float32Array(record.embedding).buffer) // Float32 blob, as stored by the journal drain
+              : undefined,
+            embeddingModel: record.embeddingModel,
+            metadata: record.metadata,
+            eventId: record.eventId,
+            personFaceId: record.personFaceId,
             cameraId,
             organizationId,
           });
         }
       }
+      // Dashboard counters, once the frame's detections are stored or journaled
+      activityCounterService.record(frameActivity);
 
       // Mark processing complete
       this.activeDetections--;
@@ -292,6 +447,8 @@ export class FaceRecognitionService {
       }
 
       // Don't throw - we don't want to stop the stream for recognition errors
+    } finally {
+      this.activeFrames.delete(frame);
     }
   }
 
@@ -380,7 +537,8 @@ export class FaceRecognitionService {
       const queryEmbedding = new Float32Array(face.encoding);
 
       // Use ANN index to find similar faces (search top 5 candidates)
-      const similarFaces = await faceIndexService.searchSimilarFaces(queryEmbedding, 5);
+      // Search the gallery of the model that produced this embedding
+      const similarFaces = await faceIndexService.searchSimilarFaces(queryEmbedding, 5, face.embeddingModel);
 
       if (similarFaces.length === 0) {
         return {
@@ -403,6 +561,7 @@ export class FaceRecognitionService {
 
         return {
           personId: bestMatch.personFaceId, // Return PersonFace ID for database consistency
+          matchedPersonId: bestMatch.personId,
           personName: bestMatch.personName,
           confidence: bestMatch.similarity,
           isMatch: true,
@@ -432,6 +591,7 @@ export class FaceRecognitionService {
       const personFace = await this.personService.addFace(personId, {
         biometricParameters: JSON.stringify(face.boundingBox ? { boundingBox: face.boundingBox } : {}),
         embedding: encodingData.length > 0 ? Buffer.from(new Float32Array(encodingData).buffer) : undefined,
+        embeddingModel: face.embeddingModel,
         reliability: face.confidence,
         status: 'active' as any,
         notes: JSON.stringify({
@@ -582,6 +742,13 @@ export class FaceRecognitionService {
     }
   }
 
+  /**
+   * Basic per-face validation followed by the advanced false-positive filtering
+   */
+  private filterFaces(candidateFaces: DetectedFace[]): DetectedFace[] {
+    return this.applyAdvancedFiltering(candidateFaces.filter(face => this.validateBasicFace(face)));
+  }
+
   /**
    * Apply advanced filtering to remove false positives
    */
@@ -843,6 +1010,7 @@ export class FaceRecognitionService {
       },
       workerPool: imageProcessingPool?.getStats() || { totalWorkers: 0, activeTasks: 0, queueLength: 0, maxQueueSize: 0 },
       nativePerformance: nativeFaceDetectionService.getPerformanceStats(),
+      sampling: nativeFaceDetectionService.getSamplingStats(),
       performance: 'High-performance native implementation with worker threads and event loop protection',
     };
   }
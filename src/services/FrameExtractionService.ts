@@ -1,5 +1,6 @@
 import { spawn, ChildProcess } from 'child_process';
 import { faceRecognitionService } from './FaceRecognitionService';
+import { nativeFaceDetectionService } from './NativeFaceDetectionService';
 
 export interface FrameExtractionSession {
   cameraId: number;
@@ -14,12 +15,23 @@ export interface FrameExtractionSession {
   frameBuffer: Map<number, Buffer>; // In-memory frame storage
   lastProcessedFrame: number;
   monitor?: NodeJS.Timeout;
+  eventId?: number; // Event the frames are recorded for; overrides the one in sessionId
+  standby: boolean; // Connected and decoding, but frames are dropped until activated
+  adaptiveSampling: boolean; // ffmpeg runs at the camera's fastest rate and the native controller picks frames
+  samplingIntervalMs: number; // Current minimum gap between processed frames
+}
+
+export interface FrameExtractionOptions {
+  eventId?: number;
+  standby?: boolean;
 }
 
 export class FrameExtractionService {
   private static instance: FrameExtractionService;
   private sessions: Map<string, FrameExtractionSession> = new Map();
   private readonly defaultInterval = 1; // Extract frame every 1 second
+  private readonly adaptiveSampling = process.env.ADAPTIVE_SAMPLING !== 'false';
+  private readonly fixedSamplingGapMs = 1000;
   private healthMonitor?: NodeJS.Timeout;
   private readonly maxSessionAge = 3600000; // 1 hour max session age
   private readonly maxIdleTime = 300000; // 5 minutes max idle time
@@ -52,7 +64,8 @@ export class FrameExtractionService {
     cameraId: number,
     organizationId: number,
     rtspUrl: string,
-    extractionInterval: number = this.defaultInterval
+    extractionInterval: number = this.defaultInterval,
+    options: FrameExtractionOptions = {}
   ): Promise<void> {
     try {
       // Check if already running
@@ -71,7 +84,11 @@ export class FrameExtractionService {
         lastFrameTime: new Date(),
         extractionInterval,
         frameBuffer: new Map<number, Buffer>(),
-        lastProcessedFrame: 0
+        lastProcessedFrame: 0,
+        eventId: options.eventId,
+        standby: options.standby === true,
+        adaptiveSampling: false,
+        samplingIntervalMs: this.fixedSamplingGapMs,
       };
 
       // Initialize face recognition service - CRITICAL: Must succeed
@@ -83,6 +100,12 @@ export class FrameExtractionService {
         throw error; // Re-throw to fail the frame extraction startup
       }
 
+      // Adaptive sampling: ffmpeg emits at the camera's fastest rate and the native controller
+      // stretches the gap between processed frames while the scene is empty
+      const sampling = this.adaptiveSampling ? nativeFaceDetectionService.getSamplingConfig(cameraId) : null;
+      session.adaptiveSampling = sampling !== null;
+      const outputRate = sampling ? `${(1000 / sampling.minIntervalMs).toFixed(3)}` : `1/${extractionInterval}`;
+
       // Start FFmpeg process for frame extraction to stdout
       const ffmpegArgs = [
         // Enhanced input options for better camera compatibility
@@ -94,7 +117,7 @@ export class FrameExtractionService {
         '-i', rtspUrl,
 
         // Enhanced frame extraction options - output to stdout
-        '-vf', `fps=1/${extractionInterval},scale=1280:720:force_original_aspect_ratio=decrease`,
+        '-vf', `fps=${outputRate},scale=1280:720:force_original_aspect_ratio=decrease`,
         '-f', 'image2pipe',
         '-q:v', '3',
         '-pix_fmt', 'yuvj420p',
@@ -150,8 +173,16 @@ export class FrameExtractionService {
             if (frameStart !== -1 && frameStart < endIdx) {
               const completeFrame = frameBuffer.subarray(frameStart, endIdx + 2);
 
-              // Enhanced throttling based on global system load
-              if (now - lastFrameProcessTime < 1000 || this.activeFrameProcesses >= this.frameProcessingThrottle) {
+              // Standby keeps the camera connected and the decoder warm; nothing is recorded
+              if (session.standby) {
+                session.lastFrameTime = new Date();
+                startIdx = endIdx + 2;
+                endIdx = frameBuffer.indexOf(Buffer.from([0xFF, 0xD9]), startIdx);
+                continue;
+              }
+
+              // Enhanced throttling based on scene activity and global system load
+              if (now - lastFrameProcessTime < this.getSamplingGap(session) || this.activeFrameProcesses >= this.frameProcessingThrottle) {
                 // Skip this frame to prevent overload
                 startIdx = endIdx + 2;
                 endIdx = frameBuffer.indexOf(Buffer.from([0xFF, 0xD9]), startIdx);
@@ -232,7 +263,7 @@ export class FrameExtractionService {
         this.cleanup(sessionId);
       });
 
-      console.log(`Frame extraction started for session ${sessionId}`);
+      console.log(`Frame extraction started for session ${sessionId}${session.standby ? ' (standby)' : ''}`);
     } catch (error) {
       console.error('Failed to start frame extraction:', error);
       throw error;
@@ -259,11 +290,8 @@ export class FrameExtractionService {
       }
 
       // Extract event ID from session ID
-      let eventId: number | undefined;
-      const eventMatch = session.sessionId.match(/^event-(\d+)-camera-\d+-\d+$/);
-      if (eventMatch) {
-        eventId = parseInt(eventMatch[1]);
-      } else {
+      const eventId = this.getSessionEventId(session);
+      if (eventId === undefined) {
         console.warn(`⚠️ FRAME EXTRACT: Could not extract event ID from session ${session.sessionId}`);
       }
 
@@ -306,6 +334,28 @@ export class FrameExtractionService {
     }
   }
 
+  /**
+   * Event the session records for: the one it was started or activated with, otherwise the
+   * one encoded in scheduler session IDs (event-<eventId>-camera-<cameraId>-<timestamp>)
+   */
+  private getSessionEventId(session: FrameExtractionSession): number | undefined {
+    if (session.eventId !== undefined) {
+      return session.eventId;
+    }
+    const eventMatch = session.sessionId.match(/^event-(\d+)-camera-\d+-\d+$/);
+    return eventMatch ? parseInt(eventMatch[1]) : undefined;
+  }
+
+  /**
+   * Minimum gap before the session's next frame is processed
+   */
+  private getSamplingGap(session: FrameExtractionSession): number {
+    if (session.adaptiveSampling) {
+      session.samplingIntervalMs = nativeFaceDetectionService.getSamplingInterval(session.cameraId) ?? this.fixedSamplingGapMs;
+    }
+    return session.samplingIntervalMs;
+  }
+
   /**
    * Check if system can handle another frame processing operation globally
    */
@@ -382,10 +432,54 @@ export class FrameExtractionService {
       clearInterval(session.monitor);
     }
 
+    // Frames of this session still queued or running in native are dropped instead of finishing unseen. A session
+    // with no event (e.g. a standby pipeline expiring) has none, and a camera-wide cancel would hit other sessions' frames.
+    const eventId = this.getSessionEventId(session);
+    if (eventId !== undefined) {
+      faceRecognitionService.cancelFrames({ cameraId: session.cameraId, eventId });
+    }
+
     this.cleanup(sessionId);
     return true;
   }
 
+  /**
+   * Start recording a running session's frames for an event. The ffmpeg process keeps running,
+   * so a pre-warmed or just-released session starts without reconnecting to the camera.
+   */
+  public activateSession(sessionId: string, eventId: number): boolean {
+    const session = this.sessions.get(sessionId);
+    if (!session || !session.isActive) {
+      return false;
+    }
+    const previousEventId = this.getSessionEventId(session);
+    if (!session.standby && previousEventId !== undefined && previousEventId !== eventId) {
+      faceRecognitionService.cancelFrames({ cameraId: session.cameraId, eventId: previousEventId });
+    }
+    session.eventId = eventId;
+    session.standby = false;
+    return true;
+  }
+
+  /**
+   * Stop recording a session's frames but keep the camera connected
+   */
+  public standbySession(sessionId: string): boolean {
+    const session = this.sessions.get(sessionId);
+    if (!session) {
+      return false;
+    }
+    if (!session.standby) {
+      session.standby = true;
+      session.frameBuffer.clear();
+      const eventId = this.getSessionEventId(session);
+      if (eventId !== undefined) {
+        faceRecognitionService.cancelFrames({ cameraId: session.cameraId, eventId });
+      }
+    }
+    return true;
+  }
+
   /**
    * Get active frame extraction sessions
    */
@@ -422,6 +516,7 @@ export class FrameExtractionService {
       frameCount: session.frameCount,
       lastFrameTime: session.lastFrameTime,
       extractionInterval: session.extractionInterval,
+      samplingIntervalMs: session.samplingIntervalMs,
       uptime: Date.now() - session.lastFrameTime.getTime(),
     };
   }
@@ -540,7 +635,8 @@ export class FrameExtractionService {
         session.cameraId,
         session.organizationId,
         session.rtspUrl,
-        session.extractionInterval
+        session.extractionInterval,
+        { eventId: session.eventId, standby: session.standby }
       );
 
       console.log(`✅ Session ${sessionId} restarted successfully`);
@@ -592,6 +688,8 @@ export class FrameExtractionService {
         sessionId: id,
         cameraId: session.cameraId,
         isActive: session.isActive,
+        standby: session.standby,
+        samplingIntervalMs: Math.round(session.samplingIntervalMs),
         frameCount: session.frameCount,
         lastFrameAge: Math.round((Date.now() - session.lastFrameTime.getTime()) / 1000), // seconds
         bufferSize: session.frameBuffer.size,
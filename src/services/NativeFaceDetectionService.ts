@@ -1,12 +1,256 @@
 import * as path from 'path';
 
+export type EmbeddingTier = 'arcface' | 'facenet' | 'mobilefacenet';
+
+export interface NativeDetectionOptions {
+  cameraId?: number;
+  eventId?: number; // Tag for cancel()
+  organizationId?: number; // Watchlist alerts only for this organization's entries
+  embeddingTier?: EmbeddingTier; // Force a model instead of the load-based policy
+  allTiers?: boolean; // Extract one embedding per loaded model (enrollment)
+  detectOnly?: boolean; // Boxes only: skips embeddings and never waits for deferred recognition models
+  onBoxes?: (boxes: NativeEarlyBoxes) => void; // detectFacesAsync only: boxes at detector latency, before embeddings
+}
+
+// A face of a camera frame that matched a watchlist entry, raised natively as soon as the face was embedded
+export interface NativeWatchlistAlert {
+  jobId: number;
+  cameraId: number;
+  faceIndex: number;
+  boundingBox: { x: number; y: number; width: number; height: number };
+  confidence: number;
+  id: number; // Entry id (the PersonFace)
+  organizationId: number;
+  similarity: number;
+  latencyMs: number; // Detection start to alert
+  firedAtMs: number;
+}
+
+// A frame's boxes delivered ahead of its embeddings; the final result carries the same jobId
+export interface NativeEarlyBoxes {
+  jobId: number;
+  processingTimeMs: number;
+  faces: Array<{ boundingBox: { x: number; y: number; width: number; height: number }; confidence: number }>;
+}
+
+// Fields that are set must all match; at least one is required
+export interface NativeCancelTarget {
+  jobId?: number;
+  cameraId?: number;
+  eventId?: number;
+}
+
+export class DetectionCancelledError extends Error {
+  constructor(public readonly jobId: number) {
+    super(`Face detection job ${jobId} cancelled`);
+    this.name = 'DetectionCancelledError';
+  }
+}
+
+export interface NativeInitOptions {
+  deferRecognition?: boolean; // Serve detection as soon as the detector loads; recognition models finish in the background
+}
+
+export interface NativeModelLoadTime {
+  name: string;
+  role: 'detector' | 'prefilter' | 'recognition';
+  loadMs: number;
+  sizeBytes: number;
+  reused: boolean; // Already loaded by another detector in this process
+  deferred: boolean;
+}
+
+export interface EmbeddingTierPolicy {
+  highLoad?: number;
+  criticalLoad?: number;
+  lowQuality?: number;
+  minDwellMs?: number;
+  latencyBudgetMs?: number;
+}
+
+export interface EmbeddingTierStats {
+  models: Array<{ name: EmbeddingTier; version: string; inputWidth: number; inputHeight: number }>;
+  cameras: Record<string, {
+    tier: EmbeddingTier | null;
+    pinned: boolean;
+    load: number;
+    avgLatencyMs: number;
+    selections: Record<EmbeddingTier, number>;
+  }>;
+}
+
+// Two-stage detection: a cascade on a thumbnail runs on every frame, the detection network only when needed
+export interface DetectionCascadeConfig {
+  enabled?: boolean;
+  thumbnailWidth?: number; // Pre-filter input width
+  minNeighbors?: number; // Cascade hit threshold; lower fires more often
+  refreshFrames?: number; // Run the network at least every N frames (0 = never)
+  refreshMs?: number; // ... and at least this often (0 = never)
+  holdFrames?: number; // Keep running the network this many frames after it found a face
+}
+
+export interface DetectionCascadeStats {
+  available: boolean; // A pre-filter cascade is loaded next to the detection network
+  config: Required<DetectionCascadeConfig>;
+  cameras: Record<string, {
+    frames: number;
+    prefilterFires: number;
+    fullRuns: number;
+    holdRuns: number;
+    refreshRuns: number;
+    fullHits: number;
+    refreshHits: number;
+    prefilterPassRate: number; // Frames where stage one fired
+    fullRunRate: number; // Frames that ran the network
+    fullHitRate: number; // Network runs that found a face
+    prefilterMissRate: number; // Refreshes that found a face stage one missed
+    avgPrefilterMs: number;
+    avgFullMs: number;
+    config?: Required<DetectionCascadeConfig>; // Present when the camera overrides the default
+  }>;
+}
+
+// Adaptive sampling: per-camera interval between sampled frames, from maxIntervalMs (idle) to minIntervalMs (busy)
+export interface SamplingConfig {
+  minIntervalMs?: number;
+  maxIntervalMs?: number;
+  idleHalfLifeMs?: number; // Activity halves this often without faces or motion
+  motionThreshold?: number; // Mean thumbnail difference (gray levels) counted as full motion
+  cpuBudget?: number; // Share of hardware threads detection may use across all cameras (process-wide only)
+}
+
+export interface SamplingStats {
+  config: Required<Omit<SamplingConfig, 'cpuBudget'>>;
+  cpuBudget: number;
+  cameras: Record<string, {
+    intervalMs: number; // Effective, after the CPU budget
+    fps: number;
+    desiredIntervalMs: number; // From activity alone
+    activity: number; // 0 idle .. 1 faces present
+    motion: number;
+    faces: number;
+    budgetLimited: boolean;
+    avgProcessingMs: number;
+    frames: number;
+    config?: Required<Omit<SamplingConfig, 'cpuBudget'>>; // Present when the camera overrides the default
+  }>;
+}
+
+// Low-power cascade detector, used instead of the detection network on small edge hardware
+export interface LowPowerConfig {
+  processWidth?: number; // Frames are scanned at this width (0 = full resolution)
+  scaleFactor?: number; // Size step between scale levels, > 1
+  minNeighbors?: number;
+  minFaceSize?: number; // Smallest face, in scanned pixels
+  scaleBands?: number; // Scale bands scanned in parallel (0 = one per hardware thread, at most 4)
+  roiReuse?: boolean; // Between full scans only look around a camera's previous faces
+  fullScanFrames?: number; // Full scan at least every N frames
+  roiMargin?: number; // Area scanned around a previous face, as a fraction of its size per side
+}
+
+export interface LowPowerStats {
+  active: boolean; // Detection runs on the cascade detector
+  detector: string;
+  config: Required<LowPowerConfig>;
+  cameras: Record<string, {
+    frames: number;
+    fullScans: number;
+    roiScans: number;
+    roiMisses: number; // ROI scans that lost a face and fell back to a full scan
+    trackedFaces: number;
+    avgScanMs: number;
+  }>;
+}
+
+// One pipeline stage over a profile window; counter fields are present only when counters were available
+export interface StageProfile {
+  calls: number;
+  wallMs: number;
+  avgMs: number;
+  countedCalls?: number;
+  cycles?: number;
+  instructions?: number;
+  ipc?: number; // Instructions per cycle
+  llcReferences?: number;
+  llcMisses?: number;
+  llcMissRate?: number; // Last-level cache misses per reference
+  llcMpki?: number; // Last-level cache misses per thousand instructions
+  branchMisses?: number;
+  branchMpki?: number;
+}
+
+export interface StageProfileReport {
+  countersAvailable: boolean;
+  unavailableReason?: string; // e.g. perf_event_paranoid, container seccomp profile, VM without a PMU
+  durationMs: number;
+  stages: Record<'decode' | 'prefilter' | 'detect' | 'validate' | 'embed', StageProfile>;
+}
+
+export interface NativeCapabilities {
+  isa: 'scalar' | 'sse4.2' | 'avx2' | 'avx512' | 'neon';
+  cpuFeatures: string[];
+  compiledIsas: string[];
+  opencvVersion: string;
+  detector: string;
+  partialJpegDecode: boolean; // embedFace decodes only the face region of JPEGs
+  cascadePrefilter: boolean; // A cascade is loaded for setCascadeConfig
+  lowPower: boolean; // Detection runs on the low-power cascade detector
+  embeddingModels: string[];
+  apiVersion: number;
+}
+
+// Process-wide, shared by every detector including those created in worker_threads
+export interface NativeRuntimeStats {
+  sharedModels: number;
+  netReplicas: number;
+  netReplicaLimit: number; // Per model, FACE_DETECTOR_NET_REPLICAS
+  modelBytes: number;
+  replicaBytes: number; // Heap of one replica of every model
+  heapBytes: number; // Heap of all replicas
+  executorThreads: number;
+  executorUsers: number;
+}
+
 interface NativeFaceDetector {
   initialize(modelPath?: string, useDeepLearning?: boolean): boolean;
   initialize(modelPath: string, useDeepLearning: boolean, callback: (err: Error | null, success: boolean) => void): void;
-  detectFaces(buffer: Buffer): NativeDetectionResult;
-  detectFacesAsync(buffer: Buffer, callback: (err: Error | null, result: NativeDetectionResult) => void): void;
+  initialize(modelPath: string, useDeepLearning: boolean, options: NativeInitOptions, callback: (err: Error | null, success: boolean) => void): void;
+  detectFaces(buffer: Buffer, options?: NativeDetectionOptions): NativeDetectionResult;
+  detectFacesAsync(buffer: Buffer, callback: (err: Error | null, result: NativeDetectionResult) => void): number;
+  detectFacesAsync(buffer: Buffer, options: NativeDetectionOptions, callback: (err: Error | null, result: NativeDetectionResult) => void): number;
+  embedFace(buffer: Buffer, box: NativeDetectedFace['boundingBox'], options: NativeDetectionOptions, callback: (err: Error | null, result: NativeDetectionResult) => void): number;
+  warmUp(width: number, height: number, concurrency: number, callback: (err: Error | null, result: { success: boolean; warmUpMs: number }) => void): void;
+  profile(durationMs: number, callback: (err: Error | null, report: StageProfileReport) => void): void;
+  cancel(target: number | NativeCancelTarget): number;
+  setWatchlist(watchlist: object | null, onAlert?: (alert: NativeWatchlistAlert) => void): void;
   setConfidenceThreshold(threshold: number): void;
   isInitialized(): boolean;
+  setTierPolicy(policy: EmbeddingTierPolicy): void;
+  pinCameraTier(cameraId: number, tier: EmbeddingTier | null): void;
+  getTierStats(): EmbeddingTierStats;
+  setCascadeConfig(config: DetectionCascadeConfig, cameraId?: number): void;
+  clearCameraCascade(cameraId: number): void;
+  getCascadeStats(): DetectionCascadeStats;
+  setSamplingConfig(config: SamplingConfig, cameraId?: number): void;
+  clearCameraSampling(cameraId: number): void;
+  getSamplingInterval(cameraId: number): number;
+  getSamplingStats(): SamplingStats;
+  setLowPowerConfig(config: LowPowerConfig): void;
+  getLowPowerStats(): LowPowerStats;
+  getCapabilities(): NativeCapabilities;
+  getRuntimeStats(): NativeRuntimeStats;
+  getModelLoadTimes(): NativeModelLoadTime[];
+  isRecognitionReady(): boolean;
+}
+
+export interface NativeDetectedFace {
+  boundingBox: { x: number; y: number; width: number; height: number };
+  confidence: number;
+  landmarks?: any[];
+  encoding?: number[];
+  embeddingModel?: string; // Version tag of the model that produced `encoding`
+  quality?: number;
+  embeddings?: Record<string, number[]>; // Per-model embeddings when allTiers is set
 }
 
 interface NativeDetectionResult {
@@ -19,10 +263,15 @@ interface NativeDetectionResult {
       height: number;
     };
     confidence: number;
+    quality: number;
     encoding: number[]; // Face encoding for recognition
+    embeddingModel: string;
+    embeddings?: Record<string, number[]>;
   }>;
   processingTimeMs: number;
   error?: string;
+  jobId?: number;
+  cancelled?: boolean;
 }
 
 export class NativeFaceDetectionService {
@@ -33,6 +282,8 @@ export class NativeFaceDetectionService {
   private readonly detectionTimeoutMs = 10000; // 10 second timeout per detection
   private readonly maxDetectionRetries = 2;
   private activeTimeouts = new Set<NodeJS.Timeout>();
+  // Native jobs awaiting their callback, so cancel() can settle them without waiting for the worker
+  private pendingJobs = new Map<number, { cameraId?: number; eventId?: number; abort: () => void }>();
 
   private performanceStats = {
     totalDetections: 0,
@@ -60,7 +311,11 @@ export class NativeFaceDetectionService {
   /**
    * Initialize the native face detector
    */
-  public async initialize(modelPath?: string, useDeepLearning = true): Promise<boolean> {
+  public async initialize(
+    modelPath?: string,
+    useDeepLearning = process.env.NATIVE_DETECTOR !== 'lowpower',
+    options: NativeInitOptions = { deferRecognition: process.env.NATIVE_DEFER_RECOGNITION !== 'false' }
+  ): Promise<boolean> {
     if (!this.detector) {
       return false;
     }
@@ -72,15 +327,39 @@ export class NativeFaceDetectionService {
 
       console.log(`🔧 NATIVE DETECTOR: Initializing with model path: ${finalModelPath}`);
       console.log(`🔧 NATIVE DETECTOR: Deep learning enabled: ${useDeepLearning}`);
-      console.log(`🔧 NATIVE DETECTOR: Expected facenet model at: ${finalModelPath}/facenet/facenet.onnx`);
+      console.log(`🔧 NATIVE DETECTOR: Deferred recognition loading: ${!!options.deferRecognition}`);
 
-      // Use synchronous initialization for better reliability
-      const success = this.detector.initialize(finalModelPath, useDeepLearning);
+      // Models are mmap'd and parsed off the event loop; detector and recognizer load in parallel
+      const startTime = Date.now();
+      const success = await new Promise<boolean>((resolve, reject) => {
+        this.detector!.initialize(finalModelPath, useDeepLearning, options, (err, ok) => (err ? reject(err) : resolve(ok)));
+      });
 
       if (success) {
         this.isInitialized = true;
         this.detector.setConfidenceThreshold(0.6); // Facenet demo default - good balance of accuracy vs false positives
-        console.log(`✅ NATIVE DETECTOR: Initialization successful - detector ready`);
+        console.log(`✅ NATIVE DETECTOR: Initialization successful - detector ready in ${Date.now() - startTime}ms`);
+        for (const model of this.detector.getModelLoadTimes()) {
+          const size = (model.sizeBytes / (1024 * 1024)).toFixed(1);
+          const how = model.reused ? 'shared' : `${model.loadMs.toFixed(1)}ms`;
+          console.log(`⏱️ NATIVE DETECTOR: ${model.role} ${model.name} ${how} (${size} MB)${model.deferred ? ' [background]' : ''}`);
+        }
+        if (process.env.LOW_POWER_PROCESS_WIDTH) {
+          this.detector.setLowPowerConfig({ processWidth: parseInt(process.env.LOW_POWER_PROCESS_WIDTH) });
+        }
+        if (process.env.NATIVE_DETECTION_CASCADE === 'true') {
+          this.detector.setCascadeConfig({ enabled: true });
+        }
+        this.detector.setSamplingConfig({
+          minIntervalMs: parseInt(process.env.SAMPLING_MIN_INTERVAL_MS || '500'),
+          maxIntervalMs: parseInt(process.env.SAMPLING_MAX_INTERVAL_MS || '10000'),
+          cpuBudget: parseFloat(process.env.SAMPLING_CPU_BUDGET || '0.5'),
+        });
+        const capabilities = this.detector.getCapabilities();
+        console.log(`🔧 NATIVE DETECTOR: Kernels ${capabilities.isa} (compiled: ${capabilities.compiledIsas.join(', ')}), OpenCV ${capabilities.opencvVersion}`);
+        if (capabilities.lowPower) {
+          console.log(`🪶 NATIVE DETECTOR: Low-power ${capabilities.detector} detector (scanning at ${this.detector.getLowPowerStats().config.processWidth}px)`);
+        }
         return true;
       } else {
         console.error(`❌ NATIVE DETECTOR: Initialization failed - C++ module returned false`);
@@ -95,13 +374,8 @@ export class NativeFaceDetectionService {
   /**
    * Detect faces using the high-performance C++ module - removed queue for full parallelism
    */
-  public async detectFaces(imageBuffer: Buffer): Promise<{
-    faces: Array<{
-      boundingBox: { x: number; y: number; width: number; height: number };
-      confidence: number;
-      landmarks?: any[];
-      encoding?: number[]; // Include encoding
-    }>;
+  public async detectFaces(imageBuffer: Buffer, options: NativeDetectionOptions = {}): Promise<{
+    faces: NativeDetectedFace[];
     processingTimeMs: number;
   }> {
     if (!this.detector || !this.isInitialized) {
@@ -109,7 +383,7 @@ export class NativeFaceDetectionService {
     }
 
     try {
-      const result = this.detector.detectFaces(imageBuffer);
+      const result = this.detector.detectFaces(imageBuffer, options);
 
       if (!result.success) {
         throw new Error(`Face detection failed: ${result.error}`);
@@ -123,6 +397,9 @@ export class NativeFaceDetectionService {
         confidence: face.confidence,
         landmarks: [], // C++ module can be extended to include landmarks
         encoding: face.encoding || [], // Include face encoding from C++
+        embeddingModel: face.embeddingModel,
+        quality: face.quality,
+        embeddings: face.embeddings,
       }));
 
       // Debug logging for encoding issues
@@ -149,15 +426,12 @@ export class NativeFaceDetectionService {
    */
   public detectFacesAsync(
     imageBuffer: Buffer,
+    options: NativeDetectionOptions = {},
     retryCount = 0
   ): Promise<{
-    faces: Array<{
-      boundingBox: { x: number; y: number; width: number; height: number };
-      confidence: number;
-      landmarks?: any[];
-      encoding?: number[];
-    }>;
+    faces: NativeDetectedFace[];
     processingTimeMs: number;
+    jobId: number;
   }> {
     return new Promise((resolve, reject) => {
       if (!this.detector || !this.isInitialized) {
@@ -176,6 +450,22 @@ export class NativeFaceDetectionService {
       const startTime = Date.now();
       let isResolved = false;
 
+      let jobId = 0;
+
+      // Early boxes are dropped once this attempt has timed out; a retry delivers its own
+      const onBoxes = options.onBoxes;
+      const nativeOptions: NativeDetectionOptions = onBoxes ? {
+        ...options,
+        onBoxes: (boxes) => {
+          if (isResolved) return;
+          try {
+            onBoxes(boxes);
+          } catch (error) {
+            console.error('❌ Early boxes handler failed:', error);
+          }
+        },
+      } : options;
+
       // Enhanced timeout with cleanup
       const timeoutId = setTimeout(() => {
         if (!isResolved) {
@@ -183,12 +473,15 @@ export class NativeFaceDetectionService {
           this.performanceStats.concurrentDetections--;
           this.performanceStats.timeoutErrors++;
           this.activeTimeouts.delete(timeoutId);
+          // Stop the native job so the retry does not compete with it
+          this.pendingJobs.delete(jobId);
+          this.detector?.cancel(jobId);
 
           // Retry logic for timeouts
           if (retryCount < this.maxDetectionRetries) {
             this.performanceStats.retryCount++;
             console.warn(`⚠️ Face detection timeout, retrying (${retryCount + 1}/${this.maxDetectionRetries})`);
-            this.detectFacesAsync(imageBuffer, retryCount + 1)
+            this.detectFacesAsync(imageBuffer, options, retryCount + 1)
               .then(resolve)
               .catch(reject);
           } else {
@@ -201,19 +494,25 @@ export class NativeFaceDetectionService {
 
       // Direct async call with enhanced error handling
       try {
-        this.detector.detectFacesAsync(imageBuffer, (err, result) => {
+        jobId = this.detector.detectFacesAsync(imageBuffer, nativeOptions, (err, result) => {
+          this.pendingJobs.delete(jobId);
           if (!isResolved) {
             isResolved = true;
             clearTimeout(timeoutId);
             this.activeTimeouts.delete(timeoutId);
             this.performanceStats.concurrentDetections--;
 
+            if (result?.cancelled) {
+              reject(new DetectionCancelledError(jobId));
+              return;
+            }
+
             if (err) {
               // Retry on specific errors
               if (retryCount < this.maxDetectionRetries && this.isRetryableError(err)) {
                 this.performanceStats.retryCount++;
                 console.warn(`⚠️ Face detection error, retrying (${retryCount + 1}/${this.maxDetectionRetries}):`, err.message);
-                this.detectFacesAsync(imageBuffer, retryCount + 1)
+                this.detectFacesAsync(imageBuffer, options, retryCount + 1)
                   .then(resolve)
                   .catch(reject);
                 return;
@@ -227,7 +526,7 @@ export class NativeFaceDetectionService {
               if (retryCount < this.maxDetectionRetries) {
                 this.performanceStats.retryCount++;
                 console.warn(`⚠️ Face detection failed, retrying (${retryCount + 1}/${this.maxDetectionRetries}):`, result.error);
-                this.detectFacesAsync(imageBuffer, retryCount + 1)
+                this.detectFacesAsync(imageBuffer, options, retryCount + 1)
                   .then(resolve)
                   .catch(reject);
                 return;
@@ -244,6 +543,9 @@ export class NativeFaceDetectionService {
               confidence: face.confidence,
               landmarks: [],
               encoding: face.encoding || [],
+              embeddingModel: face.embeddingModel,
+              quality: face.quality,
+              embeddings: face.embeddings,
             }));
 
             // Debug logging for encoding issues (reduced frequency)
@@ -257,9 +559,23 @@ export class NativeFaceDetectionService {
             resolve({
               faces: processedFaces,
               processingTimeMs: result.processingTimeMs,
+              jobId,
             });
           }
         });
+        this.pendingJobs.set(jobId, {
+          cameraId: options.cameraId,
+          eventId: options.eventId,
+          abort: () => {
+            if (!isResolved) {
+              isResolved = true;
+              clearTimeout(timeoutId);
+              this.activeTimeouts.delete(timeoutId);
+              this.performanceStats.concurrentDetections--;
+              reject(new DetectionCancelledError(jobId));
+            }
+          },
+        });
       } catch (syncError) {
         if (!isResolved) {
           isResolved = true;
@@ -272,6 +588,128 @@ export class NativeFaceDetectionService {
     });
   }
 
+  /**
+   * Re-embed a face whose box is already known (e.g. a stored detection image) without running
+   * detection. Only the JPEG region covering the box is decoded, so bulk re-embedding and audit
+   * jobs pay for one face instead of the whole frame. Resolves to null if nothing could be embedded.
+   */
+  public embedFace(
+    imageBuffer: Buffer,
+    box: NativeDetectedFace['boundingBox'],
+    options: NativeDetectionOptions = {}
+  ): Promise<NativeDetectedFace | null> {
+    return new Promise((resolve, reject) => {
+      if (!this.detector || !this.isInitialized) {
+        reject(new Error('Native face detector not initialized'));
+        return;
+      }
+
+      let jobId = 0;
+      try {
+        jobId = this.detector.embedFace(imageBuffer, box, options, (err, result) => {
+          this.pendingJobs.delete(jobId);
+          if (err) {
+            reject(err);
+            return;
+          }
+          if (result.cancelled) {
+            reject(new DetectionCancelledError(jobId));
+            return;
+          }
+          if (!result.success) {
+            reject(new Error(`Face embedding failed: ${result.error}`));
+            return;
+          }
+
+          this.updatePerformanceStats(result.processingTimeMs);
+          const face = result.faces[0];
+          resolve(face && face.encoding.length > 0 ? {
+            boundingBox: face.boundingBox,
+            confidence: face.confidence,
+            landmarks: [],
+            encoding: face.encoding,
+            embeddingModel: face.embeddingModel,
+            quality: face.quality,
+            embeddings: face.embeddings,
+          } : null);
+        });
+        this.pendingJobs.set(jobId, {
+          cameraId: options.cameraId,
+          eventId: options.eventId,
+          abort: () => reject(new DetectionCancelledError(jobId)),
+        });
+      } catch (syncError) {
+        reject(syncError);
+      }
+    });
+  }
+
+  /**
+   * Prepare network replicas for a camera that is about to start: one forward pass of every loaded
+   * model per replica with a synthetic frame of the camera's size. Resolves to the time spent, or
+   * null when the native detector is unavailable.
+   */
+  public warmUp(width: number, height: number, concurrency = 1): Promise<number | null> {
+    return new Promise((resolve) => {
+      if (!this.detector || !this.isInitialized) {
+        resolve(null);
+        return;
+      }
+      this.detector.warmUp(width, height, concurrency, (err, result) => {
+        resolve(err || !result.success ? null : result.warmUpMs);
+      });
+    });
+  }
+
+  /**
+   * Hardware performance counters around each native pipeline stage for the next durationMs of
+   * live detection: per-stage IPC, last-level cache and branch miss rates. Falls back to call counts
+   * and wall time where counters are unavailable. Rejects if a profile is already running.
+   */
+  public profile(durationMs: number): Promise<StageProfileReport | null> {
+    return new Promise((resolve, reject) => {
+      if (!this.detector || !this.isInitialized) {
+        resolve(null);
+        return;
+      }
+      this.detector.profile(durationMs, (err, report) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+        if (!report.countersAvailable) {
+          console.warn(`⚠️ NATIVE PROFILE: Hardware counters unavailable (${report.unavailableReason}), reporting wall time only`);
+        }
+        resolve(report);
+      });
+    });
+  }
+
+  /**
+   * Cancel native detection jobs by job id, camera or event. Queued frames are dropped without
+   * being decoded, running ones skip embedding, and their promises reject with DetectionCancelledError.
+   */
+  public cancel(target: number | NativeCancelTarget): number {
+    if (!this.detector) {
+      return 0;
+    }
+    const filter: NativeCancelTarget = typeof target === 'number' ? { jobId: target } : target;
+    if (filter.jobId === undefined && filter.cameraId === undefined && filter.eventId === undefined) {
+      return 0;
+    }
+
+    const cancelled = this.detector.cancel(filter);
+    for (const [jobId, job] of this.pendingJobs) {
+      if ((filter.jobId === undefined || filter.jobId === jobId) &&
+          (filter.cameraId === undefined || filter.cameraId === job.cameraId) &&
+          (filter.eventId === undefined || filter.eventId === job.eventId)) {
+        this.pendingJobs.delete(jobId);
+        job.abort();
+      }
+    }
+    return cancelled;
+  }
+
   /**
    * Check if an error is retryable
    */
@@ -288,6 +726,18 @@ export class NativeFaceDetectionService {
     return retryableMessages.some(msg => errorMessage.includes(msg));
   }
 
+  /**
+   * Attach a native Watchlist (null detaches it): faces embedded from camera frames are checked against it
+   * and a hit calls onAlert before the frame's result comes back. Works before initialize().
+   */
+  public setWatchlist(watchlist: object | null, onAlert?: (alert: NativeWatchlistAlert) => void): boolean {
+    if (!this.detector) {
+      return false;
+    }
+    this.detector.setWatchlist(watchlist, onAlert);
+    return true;
+  }
+
   /**
    * Set confidence threshold for face detection
    */
@@ -297,6 +747,157 @@ export class NativeFaceDetectionService {
     }
   }
 
+  /**
+   * Tune the load-based embedding tier policy
+   */
+  public setTierPolicy(policy: EmbeddingTierPolicy): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.setTierPolicy(policy);
+    }
+  }
+
+  /**
+   * Pin a camera to an embedding tier, or pass null to return it to automatic selection
+   */
+  public pinCameraTier(cameraId: number, tier: EmbeddingTier | null): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.pinCameraTier(cameraId, tier);
+    }
+  }
+
+  /**
+   * Loaded embedding models and the tier each camera is currently using
+   */
+  public getTierStats(): EmbeddingTierStats | null {
+    if (!this.detector || !this.isInitialized) {
+      return null;
+    }
+    return this.detector.getTierStats();
+  }
+
+  /**
+   * Configure the cascade pre-filter for all cameras, or for one camera when cameraId is given
+   */
+  public setCascadeConfig(config: DetectionCascadeConfig, cameraId?: number): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.setCascadeConfig(config, cameraId);
+    }
+  }
+
+  /**
+   * Return a camera to the default cascade config
+   */
+  public clearCameraCascade(cameraId: number): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.clearCameraCascade(cameraId);
+    }
+  }
+
+  /**
+   * Per-camera pass rates of the cascade stages, for tuning
+   */
+  public getCascadeStats(): DetectionCascadeStats | null {
+    if (!this.detector || !this.isInitialized) {
+      return null;
+    }
+    return this.detector.getCascadeStats();
+  }
+
+  /**
+   * Configure adaptive sampling for all cameras, or for one camera when cameraId is given
+   */
+  public setSamplingConfig(config: SamplingConfig, cameraId?: number): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.setSamplingConfig(config, cameraId);
+    }
+  }
+
+  /**
+   * Return a camera to the default sampling config
+   */
+  public clearCameraSampling(cameraId: number): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.clearCameraSampling(cameraId);
+    }
+  }
+
+  /**
+   * Milliseconds to wait before sampling the camera's next frame, or null without the native detector
+   */
+  public getSamplingInterval(cameraId: number): number | null {
+    if (!this.detector || !this.isInitialized) {
+      return null;
+    }
+    return this.detector.getSamplingInterval(cameraId);
+  }
+
+  /**
+   * Sampling bounds in effect for a camera (its override, or the default)
+   */
+  public getSamplingConfig(cameraId: number): Required<Omit<SamplingConfig, 'cpuBudget'>> | null {
+    const stats = this.getSamplingStats();
+    return stats ? (stats.cameras[String(cameraId)]?.config ?? stats.config) : null;
+  }
+
+  /**
+   * Effective sampling rate, activity and budget state per camera
+   */
+  public getSamplingStats(): SamplingStats | null {
+    if (!this.detector || !this.isInitialized) {
+      return null;
+    }
+    return this.detector.getSamplingStats();
+  }
+
+  /**
+   * Configure the low-power cascade detector
+   */
+  public setLowPowerConfig(config: LowPowerConfig): void {
+    if (this.detector && this.isInitialized) {
+      this.detector.setLowPowerConfig(config);
+    }
+  }
+
+  /**
+   * Whether the low-power detector is in use, and its full/ROI scan counts per camera
+   */
+  public getLowPowerStats(): LowPowerStats | null {
+    if (!this.detector || !this.isInitialized) {
+      return null;
+    }
+    return this.detector.getLowPowerStats();
+  }
+
+  /**
+   * Native build and runtime capabilities, including the SIMD instruction set selected for this CPU
+   */
+  public getCapabilities(): NativeCapabilities | null {
+    if (!this.detector) {
+      return null;
+    }
+    return this.detector.getCapabilities();
+  }
+
+  /**
+   * Models and thread pool shared by all native detectors in this process
+   */
+  public getRuntimeStats(): NativeRuntimeStats | null {
+    if (!this.detector) {
+      return null;
+    }
+    return this.detector.getRuntimeStats();
+  }
+
+  /**
+   * Per-model startup cost; recognition models appear once their deferred load completes
+   */
+  public getModelLoadTimes(): NativeModelLoadTime[] {
+    if (!this.detector) {
+      return [];
+    }
+    return this.detector.getModelLoadTimes();
+  }
+
   /**
    * Check if the detector is available and initialized
    */
@@ -304,6 +905,13 @@ export class NativeFaceDetectionService {
     return this.detector !== null && this.isInitialized;
   }
 
+  /**
+   * Whether the recognition models loaded in the background after initialize() are ready
+   */
+  public isRecognitionReady(): boolean {
+    return this.detector !== null && this.isInitialized && this.detector.isRecognitionReady();
+  }
+
   /**
    * Get performance statistics with enhanced safety metrics
    */
@@ -4,17 +4,27 @@ import { PersonImageService, PersonService } from './index';
 import { PersonFaceRepository } from '../repositories';
 import { PersonImage, PersonFace } from '../entities';
 import { nativeFaceDetectionService } from './NativeFaceDetectionService';
-import { faceIndexService } from './FaceIndexService';
+import { faceIndexService, isLegacyModel } from './FaceIndexService';
+import { retroactiveMatchService } from './RetroactiveMatchService';
 
 export interface ImageProcessingResult {
   success: boolean;
   personImageId: number;
   facesDetected: number;
   personFacesCreated: PersonFace[];
+  retroactiveLinks?: number; // Past unknown detections linked to the new faces
   error?: string;
   processingTimeMs: number;
 }
 
+export interface TierBackfillResult {
+  embeddingModels: string[]; // Models loaded by the detector
+  imageFaces: number; // Enrolled image faces inspected
+  personFacesCreated: number;
+  failed: number;
+  processingTimeMs: number;
+}
+
 export class PersonImageProcessingService {
   private personImageService: PersonImageService;
   private personService: PersonService;
@@ -84,7 +94,8 @@ export class PersonImageProcessingService {
       // Detect faces using the native face detection service
       let detectionResult;
       try {
-        detectionResult = await nativeFaceDetectionService.detectFaces(imageBuffer);
+        // Enrollment embeds each face with every loaded model so all per-model galleries know the person
+        detectionResult = await nativeFaceDetectionService.detectFaces(imageBuffer, { allTiers: true });
       } catch (detectionError: any) {
         const error = detectionError.message || 'Face detection failed';
         await this.personImageService.updateProcessingStatus(personImageId, 'failed', error);
@@ -118,41 +129,50 @@ export class PersonImageProcessingService {
             continue;
           }
 
-          // Convert face encoding to buffer
-          const embeddingBuffer = Buffer.from(new Float32Array(face.encoding).buffer);
-
-          // Create biometric parameters JSON
-          const biometricParameters = JSON.stringify({
-            boundingBox: face.boundingBox,
-            confidence: face.confidence,
-            detectionSource: 'person_image',
-            sourceImageId: personImageId,
-            faceIndex: i,
-          });
-
-          // Create PersonFace entity
-          const personFaceData = {
-            personId: personImage.personId,
-            embedding: embeddingBuffer,
-            reliability: face.confidence,
-            biometricParameters,
-            status: 'active',
-            notes: `Extracted from PersonImage ${personImageId} (face ${i + 1}/${validFaces.length})`,
-          };
-
-          const personFace = await this.personFaceRepository.create(personFaceData);
-          personFacesCreated.push(personFace);
-
-          // Add to face index for recognition
-          try {
-            const addedToIndex = await faceIndexService.addFace(personFace);
-            if (addedToIndex) {
-              console.log(`✅ Added PersonFace ${personFace.id} to ANN index`);
-            } else {
-              console.warn(`⚠️ Failed to add PersonFace ${personFace.id} to ANN index`);
+          // One PersonFace per model embedding; untagged results fall back to the primary encoding
+          const embeddings: Array<[string | undefined, number[]]> = face.embeddings && Object.keys(face.embeddings).length > 0
+            ? Object.entries(face.embeddings)
+            : [[face.embeddingModel, face.encoding]];
+
+          for (const [embeddingModel, encoding] of embeddings) {
+            // Convert face encoding to buffer
+            const embeddingBuffer = Buffer.from(new Float32Array(encoding).buffer);
+
+            // Create biometric parameters JSON
+            const biometricParameters = JSON.stringify({
+              boundingBox: face.boundingBox,
+              confidence: face.confidence,
+              detectionSource: 'person_image',
+              sourceImageId: personImageId,
+              faceIndex: i,
+              embeddingModel: embeddingModel || null,
+            });
+
+            // Create PersonFace entity
+            const personFaceData = {
+              personId: personImage.personId,
+              embedding: embeddingBuffer,
+              embeddingModel: embeddingModel || undefined,
+              reliability: face.confidence,
+              biometricParameters,
+              status: 'active',
+              notes: `Extracted from PersonImage ${personImageId} (face ${i + 1}/${validFaces.length})`,
+            };
+
+            const personFace = await this.personFaceRepository.create(personFaceData);
+            personFacesCreated.push(personFace);
+
+            // Add to face index for recognition
+            try {
+              const addedToIndex = await faceIndexService.addFace(personFace);
+              if (addedToIndex) {
+                console.log(`✅ Added PersonFace ${personFace.id} to ANN index`);
+              } else {
+                console.warn(`⚠️ Failed to add PersonFace ${personFace.id} to ANN index`);
+              }
+            } catch (indexError) {
+              console.error(`❌ Error adding PersonFace ${personFace.id} to index:`, indexError);
             }
-          } catch (indexError) {
-            console.error(`❌ Error adding PersonFace ${personFace.id} to index:`, indexError);
           }
 
         } catch (faceError) {
@@ -160,6 +180,18 @@ export class PersonImageProcessingService {
         }
       }
 
+      // Link this person's earlier appearances that were recorded as unknown
+      let retroactiveLinks = 0;
+      if (personFacesCreated.length > 0 && retroactiveMatchService.isAvailable()) {
+        try {
+          const person = await this.personService.findById(personImage.personId);
+          const retroactive = await retroactiveMatchService.matchEnrollment(personFacesCreated, person.organizationId);
+          retroactiveLinks = retroactive.linked;
+        } catch (retroError) {
+          console.error(`❌ Retroactive matching failed for PersonImage ${personImageId}:`, retroError);
+        }
+      }
+
       // Update PersonImage processing status to completed
       await this.personImageService.updateProcessingStatus(personImageId, 'completed');
 
@@ -171,6 +203,7 @@ export class PersonImageProcessingService {
         personImageId,
         facesDetected: validFaces.length,
         personFacesCreated,
+        retroactiveLinks,
         processingTimeMs,
       };
 
@@ -242,6 +275,102 @@ export class PersonImageProcessingService {
     return results;
   }
 
+  /**
+   * Embed enrolled image faces with the models that were not loaded when they were enrolled, so a camera
+   * degraded to a light tier still finds people enrolled before that model existed. Faces are grouped by
+   * source image and face index; legacy (untagged) rows stand for the primary models. Faces linked from
+   * detections have no stored image box and are left to re-enrollment.
+   */
+  async backfillMissingTiers(): Promise<TierBackfillResult> {
+    const startTime = Date.now();
+    const result: TierBackfillResult = { embeddingModels: [], imageFaces: 0, personFacesCreated: 0, failed: 0, processingTimeMs: 0 };
+
+    if (!nativeFaceDetectionService.isAvailable()) {
+      throw new Error('Native face detector not initialized');
+    }
+    // Recognition models load in the background; the loaded set is only known once they are ready
+    while (!nativeFaceDetectionService.isRecognitionReady()) {
+      if (!nativeFaceDetectionService.isAvailable()) {
+        throw new Error('Native face detector was disposed before recognition was ready');
+      }
+      await new Promise(resolve => setTimeout(resolve, 1000));
+    }
+    result.embeddingModels = nativeFaceDetectionService.getCapabilities()?.embeddingModels || [];
+    if (result.embeddingModels.length < 2) {
+      result.processingTimeMs = Date.now() - startTime;
+      return result; // A single model's gallery is filled at enrollment
+    }
+
+    // Models each enrolled image face already has an embedding for
+    const personFaces = await this.personFaceRepository.findAll({ where: { status: 'active' } });
+    const imageFaces = new Map<string, { personId: number; sourceImageId: number; parameters: any; models: Set<string> }>();
+    for (const personFace of personFaces) {
+      let parameters: any;
+      try {
+        parameters = JSON.parse(personFace.biometricParameters || '{}');
+      } catch (parseError) {
+        continue;
+      }
+      if (parameters.detectionSource !== 'person_image' || !parameters.boundingBox) {
+        continue;
+      }
+      const key = `${parameters.sourceImageId}:${parameters.faceIndex}`;
+      let imageFace = imageFaces.get(key);
+      if (!imageFace) {
+        imageFace = { personId: personFace.personId, sourceImageId: parameters.sourceImageId, parameters, models: new Set() };
+        imageFaces.set(key, imageFace);
+      }
+      if (personFace.embeddingModel) {
+        imageFace.models.add(personFace.embeddingModel);
+      } else {
+        result.embeddingModels.filter(isLegacyModel).forEach(model => imageFace!.models.add(model));
+      }
+    }
+    result.imageFaces = imageFaces.size;
+
+    for (const imageFace of imageFaces.values()) {
+      const missing = result.embeddingModels.filter(model => !imageFace.models.has(model));
+      if (missing.length === 0) {
+        continue;
+      }
+
+      try {
+        const personImage = await this.personImageService.findById(imageFace.sourceImageId);
+        if (!personImage.filePath || !fs.existsSync(personImage.filePath)) {
+          throw new Error(`Image file not found: ${personImage.filePath}`);
+        }
+        const imageBuffer = fs.readFileSync(personImage.filePath);
+        const face = await nativeFaceDetectionService.embedFace(imageBuffer, imageFace.parameters.boundingBox, { allTiers: true });
+
+        for (const embeddingModel of missing) {
+          const encoding = face?.embeddings?.[embeddingModel];
+          if (!encoding || encoding.length === 0) {
+            continue;
+          }
+          const personFace = await this.personFaceRepository.create({
+            personId: imageFace.personId,
+            embedding: Buffer.from(new Float32Array(encoding).buffer),
+            embeddingModel,
+            reliability: imageFace.parameters.confidence,
+            biometricParameters: JSON.stringify({ ...imageFace.parameters, embeddingModel }),
+            status: 'active',
+            notes: `Backfilled ${embeddingModel} embedding from PersonImage ${imageFace.sourceImageId} (face ${imageFace.parameters.faceIndex + 1})`,
+          });
+          result.personFacesCreated++;
+          if (!(await faceIndexService.addFace(personFace))) {
+            console.warn(`⚠️ Failed to add backfilled PersonFace ${personFace.id} to ANN index`);
+          }
+        }
+      } catch (error) {
+        result.failed++;
+        console.error(`❌ Embedding backfill failed for PersonImage ${imageFace.sourceImageId}:`, error);
+      }
+    }
+
+    result.processingTimeMs = Date.now() - startTime;
+    return result;
+  }
+
   /**
    * Validate PersonImage before processing
    */
@@ -0,0 +1,294 @@
+import * as path from 'path';
+import { DetectionRepository } from '../repositories';
+import { Detection, PersonFace } from '../entities';
+import { faceIndexService, isLegacyModel } from './FaceIndexService';
+
+// Native store of unmatched detection embeddings (src/native/unknown_face_store.h)
+interface NativeUnknownFaceStore {
+  add(detectionId: number, organizationId: number, detectedAtMs: number, embedding: Float32Array): boolean;
+  remove(detectionIds: number[]): number;
+  match(
+    queries: Float32Array[],
+    options: { organizationId: number; fromMs?: number; toMs?: number; threshold?: number; maxLinks?: number },
+    callback: (err: Error | null, links: Array<{ detectionId: number; query: number; similarity: number }>) => void
+  ): void;
+  getStats(): {
+    size: number;
+    organizations: number;
+    dimension: number;
+    vectorBytes: number;
+    added: number;
+    removed: number;
+    evicted: number;
+    matches: number;
+    scanned: number;
+    links: number;
+  };
+  close(): void;
+}
+
+/**
+ * A past unknown detection that matches a newly enrolled face
+ */
+export interface RetroactiveLink {
+  detectionId: number;
+  personFaceId: number;
+  similarity: number; // Same (1 + cos) / 2 scale as FaceIndexService matches
+}
+
+export interface RetroactiveMatchResult {
+  links: RetroactiveLink[];
+  linked: number; // Detections updated
+  scanned: number;
+  elapsedMs: number;
+}
+
+const LEGACY_STORE = 'legacy';
+
+/**
+ * Retroactive matching: detections that matched nobody keep their embeddings in a
+ * native store, one per embedding model, partitioned by organization and time.
+ * When a person is enrolled, their new PersonFace embeddings are scored against
+ * the organization's unknown detections in one batched pass, and detections that
+ * clear the match threshold are linked to the new faces in bulk. Faces of the
+ * primary model are also scored against the legacy store (detections recorded
+ * before embeddings were tagged), the same rule FaceIndexService applies to its
+ * galleries. Linked detections stay 'pending' so an operator still confirms them. The store is filled
+ * incrementally from the detections table (rows above the last id loaded), so it
+ * also picks up detections written through the journal.
+ */
+export class RetroactiveMatchService {
+  private NativeStore: (new (dimension: number, maxPerOrganization: number) => NativeUnknownFaceStore) | null = null;
+  private stores: Map<string, NativeUnknownFaceStore> = new Map();
+  private detectionRepository: DetectionRepository;
+  private lastLoadedId = 0;
+  private syncing: Promise<void> | null = null;
+  private runs = 0;
+  private totalLinked = 0;
+  private readonly windowDays = parseInt(process.env.FACE_RETRO_WINDOW_DAYS || '30');
+  private readonly maxPerOrganization = parseInt(process.env.FACE_RETRO_MAX_PER_ORG || '200000');
+  private readonly maxLinks = parseInt(process.env.FACE_RETRO_MAX_LINKS || '1000');
+  private readonly syncBatch = 2000;
+
+  constructor() {
+    this.detectionRepository = new DetectionRepository();
+    if (process.env.FACE_RETRO_MATCH === 'false') {
+      return;
+    }
+    try {
+      const nativeModulePath = path.join(process.cwd(), 'build', 'Release', 'face_detector.node');
+      this.NativeStore = require(nativeModulePath).UnknownFaceStore || null;
+    } catch (error: any) {
+      // Without the native module, past detections are only linked by manual search
+      this.NativeStore = null;
+    }
+  }
+
+  public isAvailable(): boolean {
+    return this.NativeStore !== null;
+  }
+
+  /**
+   * Links an organization's past unknown detections to newly enrolled faces. Restricted to the
+   * last FACE_RETRO_WINDOW_DAYS unless a window is given.
+   */
+  public async matchEnrollment(
+    personFaces: PersonFace[],
+    organizationId: number,
+    window?: { from?: Date; to?: Date }
+  ): Promise<RetroactiveMatchResult> {
+    const startTime = Date.now();
+    const result: RetroactiveMatchResult = { links: [], linked: 0, scanned: 0, elapsedMs: 0 };
+    if (!this.NativeStore || personFaces.length === 0) {
+      return result;
+    }
+
+    await this.sync();
+
+    // One batched pass per embedding model; the same detection keeps its best link across models
+    const facesPerModel = new Map<string, PersonFace[]>();
+    for (const face of personFaces) {
+      if (face.embedding && face.embedding.length > 0) {
+        const key = face.embeddingModel || LEGACY_STORE;
+        facesPerModel.set(key, [...(facesPerModel.get(key) || []), face]);
+      }
+    }
+
+    const threshold = faceIndexService.getSimilarityThreshold();
+    const from = window?.from ?? new Date(Date.now() - this.windowDays * 24 * 60 * 60 * 1000);
+    const best = new Map<number, RetroactiveLink>();
+    for (const [key, faces] of facesPerModel) {
+      // New enrollments are tagged, but the detections recorded before tagging are in the legacy store
+      const storeKeys = key !== LEGACY_STORE && isLegacyModel(key) ? [key, LEGACY_STORE] : [key];
+      for (const storeKey of storeKeys) {
+        await this.matchStore(storeKey, faces, organizationId, from, window?.to, threshold, best, result);
+      }
+    }
+
+    result.links = Array.from(best.values()).sort((a, b) => b.similarity - a.similarity);
+    if (result.links.length > 0) {
+      result.linked = await this.applyLinks(result.links);
+      this.totalLinked += result.linked;
+    }
+    this.runs++;
+    result.elapsedMs = Date.now() - startTime;
+
+    if (result.links.length > 0) {
+      console.log(`🔗 Retroactive match: linked ${result.linked} past detection(s) to ${personFaces.length} new face(s) in org ${organizationId} (${result.scanned} scanned, ${result.elapsedMs}ms)`);
+    }
+    return result;
+  }
+
+  /**
+   * One batched pass of a model's new faces over one store; each detection keeps its best link in `best`
+   */
+  private async matchStore(
+    key: string,
+    faces: PersonFace[],
+    organizationId: number,
+    from: Date,
+    to: Date | undefined,
+    threshold: number,
+    best: Map<number, RetroactiveLink>,
+    result: RetroactiveMatchResult
+  ): Promise<void> {
+    const store = this.stores.get(key);
+    if (!store) {
+      return;
+    }
+    const { scanned: scannedBefore, dimension } = store.getStats();
+    const queries = faces.map(face => this.toFloat32(face.embedding!));
+    if (queries.some(query => query.length !== dimension)) {
+      console.warn(`⚠️ Retroactive match: enrolled embeddings do not match the ${key} store dimension ${dimension}`);
+      return;
+    }
+
+    const links = await new Promise<Array<{ detectionId: number; query: number; similarity: number }>>((resolve, reject) => {
+      store.match(queries, {
+        organizationId,
+        fromMs: from.getTime(),
+        toMs: to?.getTime(),
+        threshold: 2 * threshold - 1, // Cosine
+        maxLinks: this.maxLinks,
+      }, (err, found) => (err ? reject(err) : resolve(found)));
+    });
+    result.scanned += store.getStats().scanned - scannedBefore;
+
+    for (const link of links) {
+      const similarity = (1 + link.similarity) / 2;
+      const existing = best.get(link.detectionId);
+      if (!existing || existing.similarity < similarity) {
+        best.set(link.detectionId, { detectionId: link.detectionId, personFaceId: faces[link.query].id, similarity });
+      }
+    }
+  }
+
+  /**
+   * Loads unknown detections added since the last sync. Concurrent calls share the sync in progress.
+   */
+  public sync(): Promise<void> {
+    if (!this.NativeStore) {
+      return Promise.resolve();
+    }
+    if (!this.syncing) {
+      this.syncing = this.loadNewDetections().finally(() => {
+        this.syncing = null;
+      });
+    }
+    return this.syncing;
+  }
+
+  private async loadNewDetections(): Promise<void> {
+    const since = new Date(Date.now() - this.windowDays * 24 * 60 * 60 * 1000);
+    for (;;) {
+      const rows: Detection[] = await this.detectionRepository.getRepository()
+        .createQueryBuilder('detection')
+        .select(['detection.id', 'detection.organizationId', 'detection.detectedAt', 'detection.embedding', 'detection.embeddingModel'])
+        .where('detection.id > :lastId', { lastId: this.lastLoadedId })
+        .andWhere('detection.personFaceId IS NULL')
+        .andWhere('detection.embedding IS NOT NULL')
+        .andWhere('detection.detectedAt >= :since', { since })
+        .orderBy('detection.id', 'ASC')
+        .take(this.syncBatch)
+        .getMany();
+
+      for (const row of rows) {
+        const embedding = this.toFloat32(row.embedding!);
+        const key = row.embeddingModel || LEGACY_STORE;
+        let store = this.stores.get(key);
+        if (!store) {
+          store = new this.NativeStore!(embedding.length, this.maxPerOrganization);
+          this.stores.set(key, store);
+        }
+        if (embedding.length === store.getStats().dimension) {
+          store.add(row.id, row.organizationId, new Date(row.detectedAt).getTime(), embedding);
+        }
+        this.lastLoadedId = Math.max(this.lastLoadedId, row.id);
+      }
+
+      if (rows.length < this.syncBatch) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Points the linked detections at their new PersonFace and marks them recognized, in one
+   * transaction, as associateToExistingPerson does; detectionStatus stays 'pending' for review.
+   * Detections linked since the store was filled are left alone.
+   */
+  private async applyLinks(links: RetroactiveLink[]): Promise<number> {
+    const idsPerFace = new Map<number, number[]>();
+    for (const link of links) {
+      idsPerFace.set(link.personFaceId, [...(idsPerFace.get(link.personFaceId) || []), link.detectionId]);
+    }
+
+    let linked = 0;
+    await this.detectionRepository.getRepository().manager.transaction(async (manager) => {
+      for (const [personFaceId, detectionIds] of idsPerFace) {
+        // SQLite caps bound parameters per statement, so ids go in chunks
+        for (let start = 0; start < detectionIds.length; start += 500) {
+          const updated = await manager.createQueryBuilder()
+            .update(Detection)
+            .set({ personFaceId, faceStatus: 'recognized' })
+            .where('id IN (:...ids)', { ids: detectionIds.slice(start, start + 500) })
+            .andWhere('personface_id IS NULL')
+            .execute();
+          linked += updated.affected || 0;
+        }
+      }
+    });
+
+    // Linked detections are no longer unknown
+    const detectionIds = links.map(link => link.detectionId);
+    for (const store of this.stores.values()) {
+      store.remove(detectionIds);
+    }
+    return linked;
+  }
+
+  public getStats(): {
+    available: boolean;
+    runs: number;
+    linked: number;
+    lastLoadedId: number;
+    stores: Array<{ embeddingModel: string } & ReturnType<NativeUnknownFaceStore['getStats']>>;
+  } {
+    return {
+      available: this.isAvailable(),
+      runs: this.runs,
+      linked: this.totalLinked,
+      lastLoadedId: this.lastLoadedId,
+      stores: Array.from(this.stores.entries()).map(([embeddingModel, store]) => ({ embeddingModel, ...store.getStats() })),
+    };
+  }
+
+  private toFloat32(buffer: Buffer): Float32Array {
+    // Copy into a fresh ArrayBuffer: pooled Buffers are not guaranteed to be 4-byte aligned
+    const bytes = new Uint8Array(buffer);
+    return new Float32Array(bytes.buffer, 0, Math.floor(bytes.byteLength / Float32Array.BYTES_PER_ELEMENT));
+  }
+}
+
+// Export singleton instance
+export const retroactiveMatchService = new RetroactiveMatchService();
@@ -0,0 +1,270 @@
+import * as path from 'path';
+import { PersonFaceRepository } from '../repositories';
+import { PersonFace } from '../entities';
+import { nativeFaceDetectionService, NativeWatchlistAlert } from './NativeFaceDetectionService';
+
+// Native watchlist (src/native/watchlist.h)
+interface NativeWatchlist {
+  reset(entries: Array<{ id: number; organizationId: number; model?: string; embedding: Float32Array; threshold?: number }>): number;
+  remove(id: number): boolean;
+  getStats(): {
+    size: number;
+    models: number;
+    threshold: number;
+    checks: number;
+    scanned: number;
+    hits: number;
+    alerts: number;
+    droppedAlerts: number; // Raised but not delivered to JavaScript (the callback was closing)
+    avgAlertMs: number;
+    maxAlertMs: number;
+  };
+  close(): void;
+}
+
+/**
+ * A watchlisted person seen by a camera
+ */
+export interface WatchlistAlert {
+  cameraId: number;
+  organizationId: number;
+  personFaceId: number;
+  personId?: number;
+  personName?: string;
+  listType?: string; // The PersonType that put the person on the watchlist
+  similarity: number;
+  confidence: number;
+  boundingBox: { x: number; y: number; width: number; height: number };
+  latencyMs: number; // Detection start to delivery on the event loop
+  timestamp: string;
+}
+
+interface WatchlistMember {
+  personId: number;
+  personName: string;
+  listType: string;
+}
+
+/**
+ * Priority alerts for watchlisted people (banned visitors, VIPs). People with an
+ * active PersonType in WATCHLIST_TYPES are loaded into a small native watchlist
+ * attached to the detector, which checks every face of a camera frame as soon as
+ * it is embedded and raises the alert natively, before the gallery search and
+ * the database writes of the normal recognition path. The list is reloaded
+ * every WATCHLIST_REFRESH_MS; alerts for the same person on the same camera are
+ * held back for WATCHLIST_COOLDOWN_MS.
+ */
+export class WatchlistService {
+  private watchlist: NativeWatchlist | null = null;
+  private personFaceRepository: PersonFaceRepository;
+  private members = new Map<number, WatchlistMember>(); // PersonFace id -> person
+  private lastAlert = new Map<string, number>(); // cameraId:personId -> ms
+  private listeners: Array<(alert: WatchlistAlert) => void> = [];
+  private refreshTimer: NodeJS.Timeout | null = null;
+  private refreshing: Promise<number> | null = null;
+  private attached = false;
+  private delivered = 0;
+  private suppressed = 0;
+  private latencies: number[] = []; // Most recent delivery latencies, for percentiles
+  private readonly types = (process.env.WATCHLIST_TYPES || 'watchlist,banned,vip')
+    .split(',').map(type => type.trim().toLowerCase()).filter(type => type.length > 0);
+  private readonly threshold = parseFloat(process.env.WATCHLIST_THRESHOLD || '0.7');
+  private readonly refreshIntervalMs = parseInt(process.env.WATCHLIST_REFRESH_MS || '60000');
+  private readonly cooldownMs = parseInt(process.env.WATCHLIST_COOLDOWN_MS || '30000');
+  private readonly latencyWindow = 1000;
+
+  constructor() {
+    this.personFaceRepository = new PersonFaceRepository();
+    if (process.env.WATCHLIST === 'false') {
+      return;
+    }
+    try {
+      const nativeModulePath = path.join(process.cwd(), 'build', 'Release', 'face_detector.node');
+      const { Watchlist } = require(nativeModulePath);
+      this.watchlist = new Watchlist(this.threshold);
+    } catch (error: any) {
+      // Without the native module watchlisted people are only seen through normal recognition
+      this.watchlist = null;
+    }
+  }
+
+  public isAvailable(): boolean {
+    return this.watchlist !== null;
+  }
+
+  /**
+   * Loads the watchlist, attaches it to the detector and starts the periodic reload
+   */
+  public async start(): Promise<void> {
+    if (!this.watchlist || this.refreshTimer) {
+      return;
+    }
+    try {
+      await this.refresh();
+    } catch (error) {
+      console.error('❌ Watchlist load failed; watchlisted people are only seen through normal recognition:', error);
+    }
+    this.attached = nativeFaceDetectionService.setWatchlist(this.watchlist, alert => this.handleAlert(alert));
+    if (!this.attached) {
+      console.warn('⚠️ Native detector unavailable - watchlist alerts disabled');
+    }
+    this.refreshTimer = setInterval(() => {
+      this.refresh().catch(error => console.error('❌ Watchlist refresh failed:', error));
+    }, this.refreshIntervalMs);
+  }
+
+  /**
+   * Reloads every watchlisted face from the database and swaps it in at once; concurrent calls share the reload
+   */
+  public refresh(): Promise<number> {
+    if (!this.watchlist) {
+      return Promise.resolve(0);
+    }
+    if (!this.refreshing) {
+      this.refreshing = this.load().finally(() => {
+        this.refreshing = null;
+      });
+    }
+    return this.refreshing;
+  }
+
+  private async load(): Promise<number> {
+    const startTime = Date.now();
+    const personFaces: PersonFace[] = this.types.length === 0 ? [] : await this.personFaceRepository.getRepository()
+      .createQueryBuilder('personFace')
+      .innerJoinAndSelect('personFace.person', 'person')
+      .innerJoinAndSelect('person.types', 'personType')
+      .where('person.status = :status', { status: 'active' })
+      .andWhere('personType.status = :status', { status: 'active' })
+      .andWhere('LOWER(personType.type) IN (:...types)', { types: this.types })
+      .andWhere('personFace.embedding IS NOT NULL')
+      .getMany();
+
+    const members = new Map<number, WatchlistMember>();
+    const entries = personFaces.map(personFace => {
+      members.set(personFace.id, {
+        personId: personFace.person.id,
+        personName: personFace.person.name,
+        listType: personFace.person.types[0]?.type ?? '',
+      });
+      return {
+        id: personFace.id,
+        organizationId: personFace.person.organizationId,
+        model: personFace.embeddingModel || '',
+        embedding: this.toFloat32(personFace.embedding!),
+      };
+    });
+
+    const kept = this.watchlist!.reset(entries);
+    this.members = members;
+    if (kept !== entries.length) {
+      console.warn(`⚠️ Watchlist skipped ${entries.length - kept} face(s) with unusable embeddings`);
+    }
+    console.log(`🚨 Watchlist loaded: ${kept} face(s) of ${new Set([...members.values()].map(member => member.personId)).size} person(s) in ${Date.now() - startTime}ms`);
+    return kept;
+  }
+
+  /**
+   * Called for every watchlist alert delivered to the event loop
+   */
+  public onAlert(listener: (alert: WatchlistAlert) => void): () => void {
+    this.listeners.push(listener);
+    return () => {
+      this.listeners = this.listeners.filter(existing => existing !== listener);
+    };
+  }
+
+  private handleAlert(native: NativeWatchlistAlert): void {
+    const member = this.members.get(native.id);
+    const key = `${native.cameraId}:${member?.personId ?? `face${native.id}`}`;
+    const now = Date.now();
+    const last = this.lastAlert.get(key);
+    if (last !== undefined && now - last < this.cooldownMs) {
+      this.suppressed++;
+      return;
+    }
+    this.lastAlert.set(key, now);
+    if (this.lastAlert.size > 10000) {
+      for (const [staleKey, at] of this.lastAlert) {
+        if (now - at >= this.cooldownMs) this.lastAlert.delete(staleKey);
+      }
+    }
+
+    // Native latency covers detection start to the native callback; add the hop onto the event loop
+    const latencyMs = native.latencyMs + Math.max(0, now - native.firedAtMs);
+    this.latencies.push(latencyMs);
+    if (this.latencies.length > this.latencyWindow) {
+      this.latencies.shift();
+    }
+    this.delivered++;
+
+    const alert: WatchlistAlert = {
+      cameraId: native.cameraId,
+      organizationId: native.organizationId,
+      personFaceId: native.id,
+      personId: member?.personId,
+      personName: member?.personName,
+      listType: member?.listType,
+      similarity: native.similarity,
+      confidence: native.confidence,
+      boundingBox: native.boundingBox,
+      latencyMs,
+      timestamp: new Date(now).toISOString(),
+    };
+    console.log(`🚨 Watchlist hit: ${alert.personName ?? `face ${alert.personFaceId}`} (${alert.listType || 'watchlist'}) ` +
+      `on camera ${alert.cameraId}, similarity ${alert.similarity.toFixed(3)}, ${latencyMs.toFixed(1)}ms after detection start`);
+    for (const listener of this.listeners) {
+      try {
+        listener(alert);
+      } catch (error) {
+        console.error('❌ Watchlist alert listener failed:', error);
+      }
+    }
+  }
+
+  /**
+   * Detaches the watchlist from the detector and stops the periodic reload
+   */
+  public stop(): void {
+    if (this.refreshTimer) {
+      clearInterval(this.refreshTimer);
+      this.refreshTimer = null;
+    }
+    if (this.attached) {
+      nativeFaceDetectionService.setWatchlist(null);
+      this.attached = false;
+    }
+  }
+
+  public getStats(): {
+    available: boolean;
+    attached: boolean;
+    types: string[];
+    delivered: number;
+    suppressed: number;
+    p50AlertMs: number;
+    p99AlertMs: number;
+  } & Partial<ReturnType<NativeWatchlist['getStats']>> {
+    const sorted = [...this.latencies].sort((a, b) => a - b);
+    const percentile = (p: number) => sorted.length > 0 ? sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))] : 0;
+    return {
+      available: this.isAvailable(),
+      attached: this.attached,
+      types: this.types,
+      delivered: this.delivered,
+      suppressed: this.suppressed,
+      p50AlertMs: percentile(0.5),
+      p99AlertMs: percentile(0.99),
+      ...(this.watchlist ? this.watchlist.getStats() : {}),
+    };
+  }
+
+  private toFloat32(buffer: Buffer): Float32Array {
+    // Copy into a fresh ArrayBuffer: pooled Buffers are not guaranteed to be 4-byte aligned
+    const bytes = new Uint8Array(buffer);
+    return new Float32Array(bytes.buffer, 0, Math.floor(bytes.byteLength / Float32Array.BYTES_PER_ELEMENT));
+  }
+}
+
+// Export singleton instance
+export const watchlistService = new WatchlistService();
@@ -1,8 +1,16 @@
 import { Server as HTTPServer } from 'http';
 import { WebSocketServer, WebSocket } from 'ws';
 import { spawn, ChildProcess } from 'child_process';
+import * as path from 'path';
 import { v4 as uuidv4 } from 'uuid';
 import { createError } from '../middlewares/errorHandler';
+import type { FrameResultUpdate } from './FaceRecognitionService';
+import type { WatchlistAlert } from './WatchlistService';
+
+export type PreviewCodec = 'h264' | 'mjpeg';
+
+// First byte of each binary H.264 message; the Annex-B access unit follows
+const PREVIEW_FLAG_KEYFRAME = 0x01;
 
 export interface WebSocketStreamSession {
   id: string;
@@ -15,6 +23,10 @@ export interface WebSocketStreamSession {
   lastAccessed: Date;
   clients: Set<WebSocket>;
   faceRecognitionEnabled?: boolean;
+  codec: PreviewCodec;
+  fragmenter?: any;                 // Native PreviewFragmenter for H.264 sessions
+  awaitingKeyframe: Set<WebSocket>; // Clients that fell behind and resume at the next keyframe
+  bytesSent: number;
 }
 
 export class WebSocketStreamService {
@@ -22,10 +34,25 @@ export class WebSocketStreamService {
   private wss: WebSocketServer | null = null;
   private sessions: Map<string, WebSocketStreamSession> = new Map();
   private clientSessions: Map<WebSocket, string> = new Map();
+  private previewFragmenter: any = null;
+  private readonly previewCodec: PreviewCodec = process.env.PREVIEW_CODEC === 'mjpeg' ? 'mjpeg' : 'h264';
+  private readonly previewPassthrough = process.env.PREVIEW_H264_PASSTHROUGH === 'true';
+  private readonly previewBitrate = process.env.PREVIEW_BITRATE || '600k';
+  private readonly previewCacheBytes = parseInt(process.env.PREVIEW_KEYFRAME_CACHE_MB || '4') * 1024 * 1024;
+  private readonly maxClientBufferedBytes = 1024 * 1024;
 
   private constructor() {
     // Setup periodic cleanup
     setInterval(() => this.cleanupInactiveSessions(), 30000);
+
+    if (this.previewCodec === 'h264') {
+      try {
+        const nativeModulePath = path.join(process.cwd(), 'build', 'Release', 'face_detector.node');
+        this.previewFragmenter = require(nativeModulePath).PreviewFragmenter;
+      } catch (error) {
+        console.warn('⚠️ Native preview fragmenter unavailable - live preview falls back to MJPEG');
+      }
+    }
   }
 
   public static getInstance(): WebSocketStreamService {
@@ -107,9 +134,22 @@ export class WebSocketStreamService {
       ws.send(JSON.stringify({
         type: 'subscribed',
         sessionId: sessionId,
+        codec: session.codec,
+        codecString: session.fragmenter ? session.fragmenter.getStats().codec : null,
         message: 'Successfully subscribed to stream'
       }));
 
+      // A late joiner starts from the cached keyframe and catches up with the frames after it
+      if (session.fragmenter) {
+        const units = session.fragmenter.join();
+        if (units.length === 0) {
+          session.awaitingKeyframe.add(ws);
+        }
+        for (const unit of units) {
+          this.sendPreviewUnit(session, ws, unit);
+        }
+      }
+
       console.log(`Client subscribed to stream session: ${sessionId}. Total clients: ${session.clients.size}`);
     } catch (error) {
       console.error('Error subscribing to stream:', error);
@@ -123,6 +163,7 @@ export class WebSocketStreamService {
       const session = this.sessions.get(sessionId);
       if (session) {
         session.clients.delete(ws);
+        session.awaitingKeyframe.delete(ws);
         console.log(`Client unsubscribed from stream session: ${sessionId}`);
       }
       this.clientSessions.delete(ws);
@@ -156,6 +197,7 @@ export class WebSocketStreamService {
 
       // Create new session for live viewing
       sessionId = uuidv4();
+      const codec: PreviewCodec = this.previewFragmenter ? 'h264' : 'mjpeg';
       const session: WebSocketStreamSession = {
         id: sessionId,
         cameraId,
@@ -166,6 +208,10 @@ export class WebSocketStreamService {
         lastAccessed: new Date(),
         clients: new Set(),
         faceRecognitionEnabled: false, // Video streaming doesn't include face recognition
+        codec,
+        fragmenter: codec === 'h264' ? new this.previewFragmenter(this.previewCacheBytes) : undefined,
+        awaitingKeyframe: new Set(),
+        bytesSent: 0,
       };
 
       console.log(`📺 NEW: Creating new live viewing session ${sessionId} for camera ${cameraId}`);
@@ -176,8 +222,8 @@ export class WebSocketStreamService {
       // Check if FFmpeg is available
       await this.checkFFmpegAvailability();
 
-      // Build FFmpeg arguments for MJPEG over WebSocket
-      const ffmpegArgs = [
+      // Build FFmpeg arguments for H.264 (or MJPEG) over WebSocket
+      const ffmpegArgs = codec === 'h264' ? this.buildH264Args(rtspUrl) : [
         // Input options - optimized for real-time streaming
         '-rtsp_transport', 'tcp',
         '-analyzeduration', '500000',  // Reduced for faster startup
@@ -201,7 +247,7 @@ export class WebSocketStreamService {
         '-'
       ];
 
-      console.log(`Starting FFmpeg for camera ${cameraId} with WebSocket MJPEG streaming`);
+      console.log(`Starting FFmpeg for camera ${cameraId} with WebSocket ${codec === 'h264' ? 'H.264' : 'MJPEG'} streaming`);
 
       // Start FFmpeg process
       const ffmpegProcess = spawn('ffmpeg', ffmpegArgs, {
@@ -211,50 +257,59 @@ export class WebSocketStreamService {
 
       session.process = ffmpegProcess;
 
-      // Handle MJPEG frames from stdout
-      let buffer = Buffer.alloc(0);
-
-      ffmpegProcess.stdout?.on('data', (data: Buffer) => {
-        buffer = Buffer.concat([buffer, data]);
-
-        // Process all complete JPEG frames in the buffer
-        let processed = true;
-        while (processed) {
-          processed = false;
-
-          // Look for JPEG start marker (0xFF 0xD8)
-          const startMarker = Buffer.from([0xFF, 0xD8]);
-          const startIndex = buffer.indexOf(startMarker);
-
-          if (startIndex !== -1) {
-            // Look for JPEG end marker (0xFF 0xD9) after the start
-            const endMarker = Buffer.from([0xFF, 0xD9]);
-            const endIndex = buffer.indexOf(endMarker, startIndex + 2);
-
-            if (endIndex !== -1) {
-              // Extract complete JPEG frame (including end marker)
-              const frameData = buffer.slice(startIndex, endIndex + 2);
-
-              // Only broadcast frames that are reasonable size (avoid corrupted frames)
-              if (frameData.length > 1000 && frameData.length < 500000) { // 1KB to 500KB
-                this.broadcastFrame(sessionId!, frameData);
-              } else {
-                console.warn(`Skipping invalid frame size: ${frameData.length} bytes`);
+      if (session.fragmenter) {
+        // Handle H.264 access units from stdout
+        ffmpegProcess.stdout?.on('data', (data: Buffer) => {
+          if (session.fragmenter) { // Closed once the session is cleaned up
+            this.broadcastPreviewUnits(session, session.fragmenter.push(data));
+          }
+        });
+      } else {
+        // Handle MJPEG frames from stdout
+        let buffer = Buffer.alloc(0);
+
+        ffmpegProcess.stdout?.on('data', (data: Buffer) => {
+          buffer = Buffer.concat([buffer, data]);
+
+          // Process all complete JPEG frames in the buffer
+          let processed = true;
+          while (processed) {
+            processed = false;
+
+            // Look for JPEG start marker (0xFF 0xD8)
+            const startMarker = Buffer.from([0xFF, 0xD8]);
+            const startIndex = buffer.indexOf(startMarker);
+
+            if (startIndex !== -1) {
+              // Look for JPEG end marker (0xFF 0xD9) after the start
+              const endMarker = Buffer.from([0xFF, 0xD9]);
+              const endIndex = buffer.indexOf(endMarker, startIndex + 2);
+
+              if (endIndex !== -1) {
+                // Extract complete JPEG frame (including end marker)
+                const frameData = buffer.slice(startIndex, endIndex + 2);
+
+                // Only broadcast frames that are reasonable size (avoid corrupted frames)
+                if (frameData.length > 1000 && frameData.length < 500000) { // 1KB to 500KB
+                  this.broadcastFrame(sessionId!, frameData);
+                } else {
+                  console.warn(`Skipping invalid frame size: ${frameData.length} bytes`);
+                }
+
+                // Remove processed frame from buffer
+                buffer = buffer.slice(endIndex + 2);
+                processed = true; // Continue processing if there might be more frames
               }
-
-              // Remove processed frame from buffer
-              buffer = buffer.slice(endIndex + 2);
-              processed = true; // Continue processing if there might be more frames
             }
           }
-        }
 
-        // Keep buffer size manageable - if it gets too large, reset it
-        if (buffer.length > 2 * 1024 * 1024) { // 2MB limit
-          console.warn('Buffer too large, resetting...');
-          buffer = Buffer.alloc(0);
-        }
-      });
+          // Keep buffer size manageable - if it gets too large, reset it
+          if (buffer.length > 2 * 1024 * 1024) { // 2MB limit
+            console.warn('Buffer too large, resetting...');
+            buffer = Buffer.alloc(0);
+          }
+        });
+      }
 
       ffmpegProcess.stderr?.on('data', (data) => {
         const output = data.toString();
@@ -306,6 +361,86 @@ export class WebSocketStreamService {
     }
   }
 
+  /**
+   * FFmpeg arguments for the H.264 preview: the camera's own H.264 passed through when
+   * PREVIEW_H264_PASSTHROUGH is set (no transcoding, full resolution), otherwise a low-latency
+   * x264 encode. Either way the output is a raw Annex-B stream for the native fragmenter.
+   */
+  private buildH264Args(rtspUrl: string): string[] {
+    const input = [
+      '-rtsp_transport', 'tcp',
+      '-analyzeduration', '500000',
+      '-probesize', '500000',
+      '-max_delay', '0',
+      '-fflags', 'nobuffer',
+      '-flags', 'low_delay',
+      '-i', rtspUrl,
+      '-an',
+    ];
+
+    const video = this.previewPassthrough
+      ? ['-c:v', 'copy', '-bsf:v', 'h264_mp4toannexb']
+      : [
+          '-c:v', 'libx264',
+          '-preset', 'ultrafast',
+          '-tune', 'zerolatency',        // No lookahead or frame threading delay
+          '-profile:v', 'baseline',      // No B-frames, decodable by every browser
+          '-r', '15',
+          '-g', '30',                    // A keyframe every 2 seconds bounds the join cache
+          '-s', '800x600',
+          '-pix_fmt', 'yuv420p',
+          '-b:v', this.previewBitrate,
+          '-maxrate', this.previewBitrate,
+          '-bufsize', this.previewBitrate,
+        ];
+
+    return [...input, ...video, '-f', 'h264', '-flush_packets', '1', '-'];
+  }
+
+  private broadcastPreviewUnits(session: WebSocketStreamSession, units: any[]): void {
+    if (!session.isActive || session.clients.size === 0) {
+      return;
+    }
+    for (const unit of units) {
+      session.clients.forEach(client => {
+        if (client.readyState !== WebSocket.OPEN) {
+          console.log(`Removing closed client from session ${session.id}`);
+          session.clients.delete(client);
+          session.awaitingKeyframe.delete(client);
+          return;
+        }
+        this.sendPreviewUnit(session, client, unit);
+      });
+    }
+  }
+
+  /**
+   * Sends one access unit as a binary message. A client whose socket is backed up skips
+   * frames until the next keyframe instead of receiving a stream it cannot decode.
+   */
+  private sendPreviewUnit(session: WebSocketStreamSession, client: WebSocket, unit: any): void {
+    if (session.awaitingKeyframe.has(client)) {
+      if (!unit.keyframe) {
+        return;
+      }
+      session.awaitingKeyframe.delete(client);
+    }
+    if (client.bufferedAmount > this.maxClientBufferedBytes) {
+      session.awaitingKeyframe.add(client);
+      return;
+    }
+
+    const header = Buffer.from([unit.keyframe ? PREVIEW_FLAG_KEYFRAME : 0]);
+    try {
+      client.send(Buffer.concat([header, unit.data]), { binary: true });
+      session.bytesSent += unit.data.length + 1;
+    } catch (error) {
+      console.error('Error sending frame to client:', error);
+      session.clients.delete(client);
+      session.awaitingKeyframe.delete(client);
+    }
+  }
+
   private broadcastFrame(sessionId: string, frameData: Buffer): void {
     const session = this.sessions.get(sessionId);
     if (!session || !session.isActive) {
@@ -333,6 +468,7 @@ export class WebSocketStreamService {
       if (client.readyState === WebSocket.OPEN) {
         try {
           client.send(message);
+          session.bytesSent += message.length;
           successCount++;
         } catch (error) {
           console.error('Error sending frame to client:', error);
@@ -351,6 +487,59 @@ export class WebSocketStreamService {
     }
   }
 
+  /**
+   * Sends one phase of a frame's results (boxes, then identities) to every client watching its camera
+   */
+  public broadcastDetections(update: FrameResultUpdate): void {
+    let message: string | null = null;
+    for (const session of this.sessions.values()) {
+      if (!session.isActive || session.cameraId !== update.cameraId || session.clients.size === 0) {
+        continue;
+      }
+      message = message || JSON.stringify({
+        type: 'detections',
+        phase: update.phase,
+        cameraId: update.cameraId,
+        frameId: update.frameId,
+        faces: update.faces,
+        timestamp: Date.now()
+      });
+      session.clients.forEach(client => {
+        if (client.readyState === WebSocket.OPEN) {
+          try {
+            client.send(message!);
+          } catch (error) {
+            console.error('Error sending detections to client:', error);
+          }
+        }
+      });
+    }
+  }
+
+  /**
+   * Sends a watchlist alert to every client watching a camera of the alert's organization
+   */
+  public broadcastWatchlistAlert(alert: WatchlistAlert): void {
+    const message = JSON.stringify({ type: 'watchlistAlert', ...alert });
+    for (const session of this.sessions.values()) {
+      const sameOrganization = session.organizationId !== undefined
+        ? session.organizationId === alert.organizationId
+        : session.cameraId === alert.cameraId;
+      if (!session.isActive || !sameOrganization || session.clients.size === 0) {
+        continue;
+      }
+      session.clients.forEach(client => {
+        if (client.readyState === WebSocket.OPEN) {
+          try {
+            client.send(message);
+          } catch (error) {
+            console.error('Error sending watchlist alert to client:', error);
+          }
+        }
+      });
+    }
+  }
+
   public stopStream(sessionId: string): boolean {
     const session = this.sessions.get(sessionId);
     if (!session) {
@@ -436,6 +625,11 @@ export class WebSocketStreamService {
         this.clientSessions.delete(client);
       });
       session.clients.clear();
+      session.awaitingKeyframe.clear();
+      if (session.fragmenter) {
+        session.fragmenter.close();
+        session.fragmenter = undefined;
+      }
 
       this.sessions.delete(sessionId);
       console.log(`WebSocket video stream session ${sessionId} cleaned up`);
@@ -464,9 +658,20 @@ export class WebSocketStreamService {
   }
 
   public getServiceHealth() {
+    const sessions = Array.from(this.sessions.values());
     return {
       activeSessions: this.sessions.size,
-      totalClients: Array.from(this.sessions.values()).reduce((total, session) => total + session.clients.size, 0),
+      totalClients: sessions.reduce((total, session) => total + session.clients.size, 0),
+      previewCodec: this.previewFragmenter ? 'h264' : 'mjpeg',
+      previewPassthrough: this.previewPassthrough,
+      sessions: sessions.map(session => ({
+        id: session.id,
+        cameraId: session.cameraId,
+        codec: session.codec,
+        clients: session.clients.size,
+        bytesSent: session.bytesSent,
+        preview: session.fragmenter ? session.fragmenter.getStats() : undefined,
+      })),
       uptime: process.uptime(),
     };
   }
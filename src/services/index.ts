@@ -354,6 +354,33 @@ export class DetectionService extends BaseService<Detection> {
     return super.create(data);
   }
 
+  /**
+   * Bulk insert of detections drained from the detection journal. Rows whose (journalEpoch,
+   * journalSeq) is already stored are skipped, so a batch replayed after a crash is not inserted
+   * twice. Returns how many rows were skipped.
+   */
+  async insertJournalBatch(rows: DeepPartial<Detection>[], chunkSize: number = 50): Promise<number> {
+    let skipped = 0;
+    // One transaction per batch; SQLite caps bound parameters per statement, so rows go in chunks
+    await (this.repository as DetectionRepository).getRepository().manager.transaction(async (manager) => {
+      for (let start = 0; start < rows.length; start += chunkSize) {
+        const chunk = rows.slice(start, start + chunkSize);
+        // The rows already stored are the ones the insert ignores
+        skipped += await manager.getRepository(Detection).count({
+          where: chunk.map(row => ({ journalEpoch: row.journalEpoch, journalSeq: row.journalSeq })) as any[],
+        });
+        await manager.createQueryBuilder()
+          .insert()
+          .into(Detection)
+          .values(chunk as any[])
+          .orIgnore()
+          .updateEntity(false)
+          .execute();
+      }
+    });
+    return skipped;
+  }
+
   async getDetectionStats(startDate?: Date, endDate?: Date): Promise<{
     total: number;
     byDay: Array<{ date: string; count: number }>;
@@ -390,6 +417,7 @@ export class DetectionService extends BaseService<Detection> {
       personId: personId,
       biometricParameters: detection.metadata || '', // Use detection metadata if available
       embedding: detection.embedding || undefined, // Use detection embedding if available
+      embeddingModel: detection.embeddingModel || undefined, // Keep the embedding in its model's gallery
       reliability: detection.confidence / 100, // Convert percentage to decimal
       status: 'active'
     });
@@ -445,6 +473,7 @@ export class DetectionService extends BaseService<Detection> {
       personId: newPerson.id,
       biometricParameters: detection.metadata || '', // Use detection metadata if available
       embedding: detection.embedding || undefined, // Use detection embedding if available
+      embeddingModel: detection.embeddingModel || undefined, // Keep the embedding in its model's gallery
       reliability: detection.confidence / 100, // Convert percentage to decimal
       status: 'active'
     });
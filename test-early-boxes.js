@@ -0,0 +1,57 @@
+// Two-phase delivery: time until a frame's boxes arrive (onBoxes) versus until its identities arrive
+// (the final result with embeddings), over the images in temp/test.
+// Usage: node test-early-boxes.js [rounds=5]
+const { nativeFaceDetectionService } = require('./dist/services/NativeFaceDetectionService');
+const fs = require('fs');
+const path = require('path');
+
+const rounds = parseInt(process.argv[2] || '5');
+
+async function testEarlyBoxes() {
+  const testDir = path.join(process.cwd(), 'temp', 'test');
+  const images = fs.readdirSync(testDir)
+    .filter(file => file.toLowerCase().endsWith('.jpg') || file.toLowerCase().endsWith('.png'))
+    .map(file => fs.readFileSync(path.join(testDir, file)));
+  if (images.length === 0) {
+    console.log('Need at least 1 test image in temp/test');
+    return;
+  }
+
+  if (!await nativeFaceDetectionService.initialize()) {
+    console.log('Failed to initialize detector');
+    return;
+  }
+
+  const boxesMs = [];
+  const finalMs = [];
+  let outOfOrder = 0;
+  for (let round = 0; round < rounds; round++) {
+    for (const image of images) {
+      const start = performance.now();
+      let boxesAt = 0;
+      let boxesJobId = 0;
+      const result = await nativeFaceDetectionService.detectFacesAsync(image, {
+        onBoxes: (boxes) => {
+          boxesAt = performance.now();
+          boxesJobId = boxes.jobId;
+        },
+      });
+      const finalAt = performance.now();
+      if (boxesAt === 0) {
+        continue; // No faces in this image
+      }
+      if (boxesJobId !== result.jobId || boxesAt > finalAt) {
+        outOfOrder++;
+      }
+      boxesMs.push(boxesAt - start);
+      finalMs.push(finalAt - start);
+    }
+  }
+
+  const median = values => [...values].sort((a, b) => a - b)[Math.floor(values.length / 2)] || 0;
+  console.log(`📦 ${boxesMs.length} frames with faces: boxes after ${median(boxesMs).toFixed(1)}ms, ` +
+    `identities after ${median(finalMs).toFixed(1)}ms (median); ${outOfOrder} out of order`);
+  nativeFaceDetectionService.dispose();
+}
+
+testEarlyBoxes().catch(console.error);
@@ -0,0 +1,108 @@
+// Face search on the SQLite database: native embedding_knn extension versus scoring the blobs in JavaScript,
+// over every detection and again restricted to one event (filtered after ranking, as ReportController does).
+// Usage: node test-embedding-knn.js <personId> [k=50] [database=data/facial_recognition.db] [eventId=busiest]
+const sqlite3 = require('sqlite3');
+const path = require('path');
+
+const personId = parseInt(process.argv[2]);
+const k = parseInt(process.argv[3] || '50');
+const databasePath = process.argv[4] || path.join(process.cwd(), 'data', 'facial_recognition.db');
+const extensionPath = path.join(process.cwd(), 'build', 'Release', 'embedding_knn.node');
+const maxK = 10000; // kMaxK in sqlite_embedding_knn.cpp
+
+const db = new sqlite3.Database(databasePath);
+const all = (sql, params = []) => new Promise((resolve, reject) => db.all(sql, params, (err, rows) => (err ? reject(err) : resolve(rows))));
+
+function normalized(buffer) {
+  const vector = new Float32Array(new Uint8Array(buffer).buffer);
+  let norm = 0;
+  for (let i = 0; i < vector.length; i++) norm += vector[i] * vector[i];
+  const inv = 1 / Math.sqrt(norm);
+  for (let i = 0; i < vector.length; i++) vector[i] *= inv;
+  return vector;
+}
+
+// Filter first, then rank
+async function inJs(eventId) {
+  const faces = (await all('SELECT embedding FROM person_faces WHERE person_id = ? AND embedding IS NOT NULL', [personId]))
+    .map(row => normalized(row.embedding));
+  const rows = eventId === undefined
+    ? await all('SELECT id, embedding FROM detections WHERE embedding IS NOT NULL')
+    : await all('SELECT id, embedding FROM detections WHERE embedding IS NOT NULL AND deletedAt IS NULL AND event_id = ?', [eventId]);
+  const scored = rows.map(row => {
+    const vector = normalized(row.embedding);
+    let best = -1;
+    for (const face of faces) {
+      if (face.length !== vector.length) continue;
+      let dot = 0;
+      for (let i = 0; i < vector.length; i++) dot += face[i] * vector[i];
+      best = Math.max(best, dot);
+    }
+    return { id: row.id, similarity: best };
+  });
+  return scored.sort((a, b) => b.similarity - a.similarity).slice(0, k);
+}
+
+// Rank, then filter: with an event, the extension is asked for maxK rows and the join keeps the event's
+async function inSql(eventId) {
+  if (eventId === undefined) {
+    return all(`
+      SELECT m.id AS id, MAX(m.similarity) AS similarity
+      FROM person_faces pf
+      JOIN embedding_knn('detections', 'embedding', pf.embedding, ?) m
+      WHERE pf.person_id = ?
+      GROUP BY m.id ORDER BY similarity DESC LIMIT ?`, [k, personId, k]);
+  }
+  return all(`
+    SELECT m.id AS id, MAX(m.similarity) AS similarity
+    FROM person_faces pf
+    JOIN embedding_knn('detections', 'embedding', pf.embedding, ?) m
+    JOIN detections d ON d.id = m.id
+    WHERE pf.person_id = ? AND d.deletedAt IS NULL AND d.event_id = ?
+    GROUP BY m.id ORDER BY similarity DESC LIMIT ?`, [maxK, personId, eventId, k]);
+}
+
+// Runs one search through both engines; false when they return different detections
+async function compare(label, eventId) {
+  let start = performance.now();
+  const js = await inJs(eventId);
+  const jsMs = performance.now() - start;
+  start = performance.now();
+  const sql = await inSql(eventId);
+  const sqlMs = performance.now() - start;
+
+  const jsIds = new Set(js.map(row => row.id));
+  const agree = sql.filter(row => jsIds.has(row.id)).length;
+  const ok = agree === js.length && sql.length === js.length;
+  console.log(`${ok ? '✅' : '❌'} ${label} top ${k}: JavaScript ${jsMs.toFixed(1)}ms (${js.length} rows), ` +
+    `embedding_knn ${sqlMs.toFixed(1)}ms (${sql.length} rows); ${agree} ids agree`);
+  return ok;
+}
+
+async function testEmbeddingKnn() {
+  if (isNaN(personId)) {
+    console.log('Usage: node test-embedding-knn.js <personId> [k] [database] [eventId]');
+    return;
+  }
+  await new Promise((resolve, reject) => db.loadExtension(extensionPath, err => (err ? reject(err) : resolve())));
+
+  let start = performance.now();
+  const synced = await all("SELECT embedding_knn_sync('detections', 'embedding', 'embeddingModel', 'organization_id') AS rows");
+  console.log(`🔄 Sync: ${synced[0].rows} detections in ${(performance.now() - start).toFixed(1)}ms`);
+
+  let ok = await compare('All detections', undefined);
+
+  // The event filter must not shrink or change the result: the busiest event unless one is given
+  const eventId = process.argv[5] !== undefined ? parseInt(process.argv[5]) : (await all(
+    'SELECT event_id FROM detections WHERE embedding IS NOT NULL GROUP BY event_id ORDER BY COUNT(*) DESC LIMIT 1'))[0]?.event_id;
+  if (eventId !== undefined) {
+    ok = (await compare(`Event ${eventId}`, eventId)) && ok;
+  }
+  db.close();
+  process.exitCode = ok ? 0 : 1;
+}
+
+testEmbeddingKnn().catch(error => {
+  console.error(error);
+  db.close();
+});
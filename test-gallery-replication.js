@@ -0,0 +1,152 @@
+// Gallery replication between two processes: a primary enrolls and removes faces while a forked standby
+// bootstraps from its snapshot, then follows its deltas over HTTP. Reports bootstrap time, how far
+// behind the standby runs, and whether both answer searches the same way.
+// Usage: node test-gallery-replication.js [galleryFaces=20000] [changesPerSecond=500] [seconds=5] [pollMs=5] [dimension=512]
+const path = require('path');
+const http = require('http');
+const { fork } = require('child_process');
+
+const { EmbeddingGallery } = require(path.join(__dirname, 'build', 'Release', 'face_detector.node'));
+
+// The forked standby runs as: test-gallery-replication.js standby <port> [same arguments]
+const standbyPort = process.argv[2] === 'standby' ? parseInt(process.argv.splice(2, 2)[1]) : 0;
+const galleryFaces = parseInt(process.argv[2] || '20000');
+const changesPerSecond = parseInt(process.argv[3] || '500');
+const seconds = parseInt(process.argv[4] || '5');
+const pollMs = parseInt(process.argv[5] || '5');
+const dimension = parseInt(process.argv[6] || '512');
+
+function randomVector() {
+  const v = new Float32Array(dimension);
+  for (let i = 0; i < dimension; i++) v[i] = Math.random() - 0.5;
+  return v;
+}
+
+function get(port, pathname) {
+  return new Promise((resolve, reject) => {
+    http.get({ port, path: pathname, agent: standbyAgent }, (response) => {
+      const chunks = [];
+      response.on('data', chunk => chunks.push(chunk));
+      response.on('end', () => resolve({ status: response.statusCode, body: Buffer.concat(chunks) }));
+    }).on('error', reject);
+  });
+}
+const standbyAgent = new http.Agent({ keepAlive: true, maxSockets: 1 });
+
+async function standby(port) {
+  const gallery = new EmbeddingGallery(dimension);
+  const start = Date.now();
+  const snapshot = await get(port, '/snapshot');
+  const { rows } = gallery.loadSnapshot(snapshot.body);
+  process.send({ type: 'bootstrapped', rows, ms: Date.now() - start, bytes: snapshot.body.length });
+
+  let snapshots = 1;
+  let running = true;
+  process.on('message', (message) => {
+    if (message.type === 'verify') {
+      const top = message.queries.map(q => (gallery.search(new Float32Array(q), { k: 1, rerank: 0 })[0] || {}).id);
+      process.send({ type: 'verified', top, sequence: gallery.sequence(), size: gallery.getStats().size, snapshots });
+    } else if (message.type === 'stop') {
+      running = false;
+      gallery.close();
+      process.exit(0);
+    }
+  });
+
+  while (running) {
+    const delta = await get(port, `/delta?after=${gallery.sequence()}`);
+    const result = delta.status === 200 ? gallery.applyDelta(delta.body) : null;
+    if (!result) {
+      gallery.loadSnapshot((await get(port, '/snapshot')).body);
+      snapshots++;
+    } else if (result.applied > 0) {
+      process.send({ type: 'applied', sequence: gallery.sequence() });
+    }
+    await new Promise(resolve => setTimeout(resolve, pollMs));
+  }
+}
+
+async function primary() {
+  const gallery = new EmbeddingGallery(dimension);
+  gallery.setLogCapacity(16384);
+  for (let id = 0; id < galleryFaces; id++) {
+    gallery.add(id, randomVector(), JSON.stringify({ personId: id, personName: `Person ${id}`, reliability: 0.9 }));
+  }
+  console.log(`📚 Primary: ${galleryFaces} faces, ${dimension}-d, ${changesPerSecond} changes/s for ${seconds}s, standby polls every ${pollMs}ms`);
+
+  const server = http.createServer((req, res) => {
+    const url = new URL(req.url, 'http://localhost');
+    const blob = url.pathname === '/snapshot'
+      ? gallery.exportSnapshot()
+      : gallery.exportDelta(parseInt(url.searchParams.get('after') || '0'), 1024);
+    res.writeHead(blob ? 200 : 410, { 'Content-Type': 'application/octet-stream' });
+    res.end(blob ? blob.data : undefined);
+  });
+  await new Promise(resolve => server.listen(0, '127.0.0.1', resolve));
+
+  const changedAt = new Map(); // sequence -> ms
+  const lags = [];
+  const child = fork(__filename, ['standby', String(server.address().port), ...process.argv.slice(2)]);
+  const replies = [];
+  child.on('message', (message) => {
+    if (message.type === 'applied') {
+      const now = performance.now();
+      for (const [sequence, at] of changedAt) {
+        if (sequence > message.sequence) break;
+        lags.push(now - at);
+        changedAt.delete(sequence);
+      }
+    } else {
+      replies.push(message);
+    }
+  });
+  const reply = async (type) => {
+    while (!replies.some(message => message.type === type)) await new Promise(resolve => setTimeout(resolve, 5));
+    return replies.find(message => message.type === type);
+  };
+
+  const boot = await reply('bootstrapped');
+  console.log(`📥 Standby bootstrapped ${boot.rows} faces from a ${(boot.bytes / 1048576).toFixed(1)} MB snapshot in ${boot.ms}ms`);
+
+  // Enroll new faces and drop old ones at a steady rate
+  let nextId = galleryFaces;
+  const end = Date.now() + seconds * 1000;
+  while (Date.now() < end) {
+    const tickStart = Date.now();
+    for (let i = 0; i < changesPerSecond / 100; i++) {
+      const before = gallery.sequence();
+      if (Math.random() < 0.7) {
+        gallery.add(nextId++, randomVector(), JSON.stringify({ personId: nextId, personName: `Person ${nextId}`, reliability: 0.9 }));
+      } else {
+        gallery.remove(Math.floor(Math.random() * nextId));
+      }
+      if (gallery.sequence() !== before) {
+        changedAt.set(gallery.sequence(), performance.now()); // Removing an id already gone is not a change
+      }
+    }
+    await new Promise(resolve => setTimeout(resolve, Math.max(0, 10 - (Date.now() - tickStart))));
+  }
+  while (changedAt.size > 0) await new Promise(resolve => setTimeout(resolve, 5));
+
+  lags.sort((a, b) => a - b);
+  const percentile = p => lags[Math.min(lags.length - 1, Math.floor(p * lags.length))] || 0;
+  console.log(`⏱️  Standby lag over ${lags.length} changes: p50 ${percentile(0.5).toFixed(1)}ms, p99 ${percentile(0.99).toFixed(1)}ms, max ${percentile(1).toFixed(1)}ms`);
+
+  const queries = Array.from({ length: 50 }, () => randomVector());
+  child.send({ type: 'verify', queries: queries.map(q => Array.from(q)) });
+  const verified = await reply('verified');
+  const same = queries.every((q, i) => (gallery.search(q, { k: 1, rerank: 0 })[0] || {}).id === verified.top[i]);
+  console.log(`🔍 Primary sequence ${gallery.sequence()}, standby ${verified.sequence}; sizes ${gallery.getStats().size}/${verified.size}; ` +
+    `same top-1 for ${queries.length} queries: ${same ? 'yes' : 'no'} (${verified.snapshots} snapshot(s) loaded)`);
+
+  child.send({ type: 'stop' });
+  server.close();
+  standbyAgent.destroy();
+  gallery.close();
+}
+
+if (standbyPort) {
+  standby(standbyPort);
+} else {
+  primary();
+}
@@ -0,0 +1,131 @@
+// Gallery search benchmark: binary-code prefilter + rerank versus an exact float scan, adaptive
+// (latency-budgeted) reranking, then batched (searchBatch) versus one-at-a-time queries.
+// Usage: node test-gallery-search.js [galleryFaces=100000] [queries=200] [dimension=512] [k=5]
+const path = require('path');
+
+const { EmbeddingGallery } = require(path.join(__dirname, 'build', 'Release', 'face_detector.node'));
+
+const galleryFaces = parseInt(process.argv[2] || '100000');
+const queryCount = parseInt(process.argv[3] || '200');
+const dimension = parseInt(process.argv[4] || '512');
+const k = parseInt(process.argv[5] || '5');
+const facesPerPerson = 5;
+const rerankSizes = [32, 64, 128, 256, 512, 1024, 4096];
+
+// Seeded so runs are comparable
+let seed = 12345;
+function random() {
+  seed = (seed + 0x6d2b79f5) | 0;
+  let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+  t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+  return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+}
+function gaussian() {
+  return Math.sqrt(-2 * Math.log(random() + 1e-12)) * Math.cos(2 * Math.PI * random());
+}
+function randomVector(scale = 1) {
+  const v = new Float32Array(dimension);
+  for (let i = 0; i < dimension; i++) v[i] = gaussian() * scale;
+  return v;
+}
+// A face of `person`: its identity direction plus per-photo variation (same-person cosine around 0.6-0.7)
+function faceOf(person) {
+  const noise = randomVector(0.8);
+  for (let i = 0; i < dimension; i++) noise[i] += person[i];
+  return noise;
+}
+
+console.log(`🔢 Gallery benchmark: ${galleryFaces} faces (${facesPerPerson} per person), ${dimension}-d, ${queryCount} queries, k=${k}`);
+
+const gallery = new EmbeddingGallery(dimension);
+const people = [];
+const buildStart = Date.now();
+for (let id = 0; id < galleryFaces; id++) {
+  if (id % facesPerPerson === 0) people.push(randomVector());
+  gallery.add(id, faceOf(people[people.length - 1]));
+}
+const stats = gallery.getStats();
+console.log(`📚 Enrolled in ${Date.now() - buildStart}ms: vectors ${(stats.vectorBytes / 1048576).toFixed(1)} MB, ` +
+  `codes ${(stats.codeBytes / 1048576).toFixed(1)} MB (${stats.codeBits} bits, ${(stats.vectorBytes / stats.codeBytes).toFixed(0)}x smaller)`);
+
+const queries = [];
+for (let q = 0; q < queryCount; q++) {
+  queries.push(faceOf(people[Math.floor(random() * people.length)]));
+}
+
+function timeSearches(rerank) {
+  // One untimed pass warms caches and the per-thread scratch buffers
+  gallery.search(queries[0], { k, rerank });
+  const results = [];
+  const start = process.hrtime.bigint();
+  for (const query of queries) {
+    results.push(gallery.search(query, { k, rerank }));
+  }
+  const ms = Number(process.hrtime.bigint() - start) / 1e6 / queries.length;
+  return { ms, results };
+}
+
+const exact = timeSearches(0);
+console.log(`🎯 Exact scan: ${exact.ms.toFixed(3)} ms/query`);
+console.log('   rerank   ms/query   speedup   recall@k   top-1');
+
+for (const rerank of rerankSizes) {
+  if (rerank >= galleryFaces) break;
+  const { ms, results } = timeSearches(rerank);
+  let hits = 0;
+  let top1 = 0;
+  results.forEach((matches, q) => {
+    const truth = new Set(exact.results[q].map(match => match.id));
+    hits += matches.filter(match => truth.has(match.id)).length;
+    if (matches.length > 0 && matches[0].id === exact.results[q][0].id) top1++;
+  });
+  const recall = hits / (queries.length * Math.min(k, galleryFaces));
+  console.log(`   ${String(rerank).padStart(6)}   ${ms.toFixed(3).padStart(8)}   ${(exact.ms / ms).toFixed(1).padStart(6)}x   ` +
+    `${recall.toFixed(3).padStart(8)}   ${(top1 / queries.length).toFixed(3).padStart(5)}`);
+}
+
+// Adaptive: enrolled people (clear matches) should stop early, strangers go deeper only within the budget
+const strangers = queries.map(() => randomVector());
+const strangerExact = strangers.map(query => gallery.search(query, { k, rerank: 0 }));
+console.log('   budget   known ms   depth   early   stranger ms   depth   top-1');
+for (const budgetMs of [0.5, 1, 2, 5]) {
+  const options = { k, rerank: 256, budgetMs, matchThreshold: 0.5, margin: 0.05, maxRerank: 4096 };
+  const effort = (list, truth) => {
+    let ms = 0, depth = 0, early = 0, top1 = 0;
+    list.forEach((query, q) => {
+      const { matches, report } = gallery.searchWithReport(query, options);
+      ms += report.elapsedMs;
+      depth += report.depth;
+      if (report.earlyExit) early++;
+      if (matches.length > 0 && matches[0].id === truth[q][0].id) top1++;
+    });
+    return { ms: ms / list.length, depth: depth / list.length, early: early / list.length, top1 };
+  };
+  const known = effort(queries, exact.results);
+  const unknown = effort(strangers, strangerExact);
+  console.log(`   ${String(budgetMs).padStart(6)}   ${known.ms.toFixed(3).padStart(8)}   ${known.depth.toFixed(0).padStart(5)}   ` +
+    `${known.early.toFixed(2).padStart(5)}   ${unknown.ms.toFixed(3).padStart(11)}   ${unknown.depth.toFixed(0).padStart(5)}   ` +
+    `${((known.top1 + unknown.top1) / (2 * queries.length)).toFixed(3).padStart(5)}`);
+}
+
+// Batched: every block of gallery rows is read once for all queries of the batch
+function searchBatch(rerank) {
+  return new Promise((resolve, reject) => {
+    gallery.searchBatch(queries, { k, rerank }, (err, matches) => (err ? reject(err) : resolve(matches)));
+  });
+}
+
+(async () => {
+  console.log('   batched  rerank   ms/query   vs single   same results');
+  for (const rerank of [0, 256]) {
+    const single = rerank === 0 ? exact : timeSearches(rerank);
+    await searchBatch(rerank);
+    const start = process.hrtime.bigint();
+    const results = await searchBatch(rerank);
+    const ms = Number(process.hrtime.bigint() - start) / 1e6 / queries.length;
+    const same = results.every((matches, q) =>
+      matches.length === single.results[q].length && matches.every((match, i) => match.id === single.results[q][i].id));
+    console.log(`            ${String(rerank).padStart(6)}   ${ms.toFixed(3).padStart(8)}   ${(single.ms / ms).toFixed(1).padStart(8)}x   ${same ? 'yes' : 'no'}`);
+  }
+  gallery.close();
+})();